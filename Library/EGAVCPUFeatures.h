@@ -0,0 +1,105 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVCPUFeatures.h
+
+@brief		Runtime CPU feature detection for the SIMD video/audio kernels.
+
+			Kernels using AVX2 are compiled with EGAV_TARGET_AVX2 so the rest of the
+			library can be built for the baseline instruction set. On non-x86 targets
+			(Apple silicon) only the scalar kernels are built.
+**/
+//==============================================================================
+
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define EGAV_X86 1
+#else
+	#define EGAV_X86 0
+#endif
+
+#if EGAV_X86
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define EGAV_TARGET_AVX2
+		#define EGAV_TARGET_SSSE3
+	#else
+		#include <cpuid.h>
+		#define EGAV_TARGET_AVX2	__attribute__((target("avx2,fma")))
+		#define EGAV_TARGET_SSSE3	__attribute__((target("ssse3")))
+	#endif
+	#include <immintrin.h>
+#endif
+
+
+//! @return true if the CPU and the OS support AVX2 (including FMA)
+inline bool EGAV_CPUHasAVX2()
+{
+#if EGAV_X86
+	static const bool hasAVX2 = []
+	{
+	#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4] = {};
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool fma     = (info[2] & (1 << 12)) != 0;
+		if (!osxsave || !fma || (_xgetbv(0) & 6) != 6) // OS saves XMM and YMM state
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	#endif
+	}();
+	return hasAVX2;
+#else
+	return false;
+#endif
+}
+
+//! @return true if the CPU supports SSSE3 (pshufb)
+inline bool EGAV_CPUHasSSSE3()
+{
+#if EGAV_X86
+	static const bool hasSSSE3 = []
+	{
+	#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4] = {};
+		__cpuid(info, 1);
+		return (info[2] & (1 << 9)) != 0;
+	#else
+		return __builtin_cpu_supports("ssse3") != 0;
+	#endif
+	}();
+	return hasSSSE3;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,351 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVColorConverter.cpp
+
+@brief		YCbCr (NV12, P010) to BGRA conversion for CPU previews
+**/
+//==============================================================================
+
+#include "EGAVColorConverter.h"
+#include "EGAVCPUFeatures.h"
+
+#include <cstring>
+
+
+//==============================================================================
+// # AVI colorimetry
+//==============================================================================
+
+EGAVColorFormat HDMI_AVI_GetColorFormat(const HDMI_GENERIC_INFOFRAME* inAVI, int inHeight)
+{
+	EGAVColorFormat format;
+	format.matrix = (inHeight < 720) ? EGAVColorMatrix::BT601 : EGAVColorMatrix::BT709;
+
+	if (!inAVI || !HDMI_AVI_IsValid(*inAVI))
+		return format;
+
+	const HDMI_AVI2_PAYLOAD& avi = inAVI->plAVI2;
+	switch (avi.bfColorimetry)
+	{
+		case HDMI_AVI_C_SMTPE170M:	format.matrix = EGAVColorMatrix::BT601; break;
+		case HDMI_AVI_C_ITUR709:	format.matrix = EGAVColorMatrix::BT709; break;
+		case HDMI_AVI_C_EXTENDED:
+			switch (avi.bfExtendedColorimetry)
+			{
+				case HDMI_AVI_EC_XVYCC601:
+				case HDMI_AVI_EC_SYCC601:
+				case HDMI_AVI_EC_ADOBEYCC601:	format.matrix = EGAVColorMatrix::BT601;  break;
+				case HDMI_AVI_EC_XVYCC709:		format.matrix = EGAVColorMatrix::BT709;  break;
+				case HDMI_AVI_EC_BT2020C:
+				case HDMI_AVI_EC_BT2020:		format.matrix = EGAVColorMatrix::BT2020; break;
+				default:						break; // Adobe RGB, DCI-P3: RGB only
+			}
+			break;
+		default:
+			break;
+	}
+
+	// sYCC and Adobe YCC are full range by definition, otherwise YQ
+	format.fullRange = (HDMI_AVI_YQ_FULL == avi.bfYCCQuantizationRange)
+		|| (HDMI_AVI_C_EXTENDED == avi.bfColorimetry && (HDMI_AVI_EC_SYCC601 == avi.bfExtendedColorimetry || HDMI_AVI_EC_ADOBEYCC601 == avi.bfExtendedColorimetry));
+	return format;
+}
+
+
+//==============================================================================
+// # Coefficients
+//==============================================================================
+
+// All kernels work on samples scaled to 8 bit << 6 (int16) and Q13 coefficients:
+//   term = (sample6 * coeff + 2^14) >> 15   (= _mm256_mulhrs_epi16)  -> value << 4
+//   out  = clamp((yTerm + cTerms + 8) >> 4, 0, 255)
+
+struct ColorCoefficients
+{
+	int16_t		y;			//!< luma scale
+	int16_t		rv;			//!< Cr -> R
+	int16_t		gu;			//!< Cb -> G
+	int16_t		gv;			//!< Cr -> G
+	int16_t		bu;			//!< Cb -> B
+};
+
+constexpr int16_t ToQ13(double inValue)
+{
+	return (int16_t)(inValue >= 0 ? inValue * 8192 + 0.5 : inValue * 8192 - 0.5);
+}
+
+constexpr ColorCoefficients MakeCoefficients(double inKr, double inKb, bool inFullRange)
+{
+	const double kg = 1 - inKr - inKb;
+	const double ys = inFullRange ? 1.0 : 255.0 / 219.0;
+	const double cs = inFullRange ? 1.0 : 255.0 / 224.0;
+	return ColorCoefficients{
+		ToQ13(ys),
+		ToQ13(2 * (1 - inKr) * cs),
+		ToQ13(-2 * inKb * (1 - inKb) / kg * cs),
+		ToQ13(-2 * inKr * (1 - inKr) / kg * cs),
+		ToQ13(2 * (1 - inKb) * cs) };
+}
+
+template <EGAVColorMatrix M, bool Full>
+struct ColorTraits
+{
+	static constexpr double kr = (M == EGAVColorMatrix::BT601) ? 0.299 : (M == EGAVColorMatrix::BT709) ? 0.2126 : 0.2627;
+	static constexpr double kb = (M == EGAVColorMatrix::BT601) ? 0.114 : (M == EGAVColorMatrix::BT709) ? 0.0722 : 0.0593;
+	static constexpr ColorCoefficients c = MakeCoefficients(kr, kb, Full);
+	static constexpr int yOffset6 = Full ? 0 : 16 << 6;	//!< luma offset in the sample6 domain
+};
+
+static_assert(ColorTraits<EGAVColorMatrix::BT2020, false>::c.bu < 32767, "Q13 coefficient overflow");
+
+
+//==============================================================================
+// # Scalar kernels
+//==============================================================================
+
+static inline int MulHRS(int inA, int inB)
+{
+	return (inA * inB + 0x4000) >> 15;
+}
+
+static inline uint8_t Clamp8(int inValue)
+{
+	inValue = (inValue + 8) >> 4;
+	return (uint8_t)(inValue < 0 ? 0 : (inValue > 255 ? 255 : inValue));
+}
+
+template <EGAVColorMatrix M, bool Full, bool P010>
+static void ConvertRowScalar(const uint8_t* inY, const uint8_t* inUV, uint8_t* outBGRA, int inWidth)
+{
+	typedef ColorTraits<M, Full> T;
+	for (int x = 0; x < inWidth; x += 2)
+	{
+		int u6, v6;
+		if (P010)
+		{
+			u6 = (((const uint16_t*)inUV)[x] >> 2) - (128 << 6);
+			v6 = (((const uint16_t*)inUV)[x + 1] >> 2) - (128 << 6);
+		}
+		else
+		{
+			u6 = (inUV[x] - 128) << 6;
+			v6 = (inUV[x + 1] - 128) << 6;
+		}
+		const int r = MulHRS(v6, T::c.rv);
+		const int g = MulHRS(u6, T::c.gu) + MulHRS(v6, T::c.gv);
+		const int b = MulHRS(u6, T::c.bu);
+
+		for (int i = 0; i < 2; i++)
+		{
+			const int y6 = (P010 ? (((const uint16_t*)inY)[x + i] >> 2) : (inY[x + i] << 6)) - T::yOffset6;
+			const int y  = MulHRS(y6, T::c.y);
+			uint8_t* out = outBGRA + 4 * (x + i);
+			out[0] = Clamp8(y + b);
+			out[1] = Clamp8(y + g);
+			out[2] = Clamp8(y + r);
+			out[3] = 0xFF;
+		}
+	}
+}
+
+
+//==============================================================================
+// # AVX2 kernels
+//==============================================================================
+
+#if EGAV_X86
+
+//! @brief 16 pixels per iteration
+template <EGAVColorMatrix M, bool Full, bool P010>
+EGAV_TARGET_AVX2 static void ConvertRowAVX2(const uint8_t* inY, const uint8_t* inUV, uint8_t* outBGRA, int inWidth)
+{
+	typedef ColorTraits<M, Full> T;
+	const __m256i cy      = _mm256_set1_epi16(T::c.y);
+	const __m256i crv     = _mm256_set1_epi16(T::c.rv);
+	const __m256i cgu     = _mm256_set1_epi16(T::c.gu);
+	const __m256i cgv     = _mm256_set1_epi16(T::c.gv);
+	const __m256i cbu     = _mm256_set1_epi16(T::c.bu);
+	const __m256i yOffset = _mm256_set1_epi16((short)T::yOffset6);
+	const __m256i cOffset = _mm256_set1_epi16(128 << 6);
+	const __m256i round   = _mm256_set1_epi16(8);
+	const __m256i alpha   = _mm256_set1_epi16(0xFF);
+	const __m256i lowWord = _mm256_set1_epi32(0xFFFF);
+
+	int x = 0;
+	for (; x + 16 <= inWidth; x += 16)
+	{
+		__m256i y6, uv6;
+		if (P010)
+		{
+			y6  = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i*)(inY + 2 * x)), 2);
+			uv6 = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i*)(inUV + 2 * x)), 2);
+		}
+		else
+		{
+			y6  = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(inY + x))), 6);
+			uv6 = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(inUV + x))), 6);
+		}
+		y6  = _mm256_sub_epi16(y6, yOffset);
+		uv6 = _mm256_sub_epi16(uv6, cOffset);
+
+		// [u0 v0 u1 v1 ...] -> [u0 u0 u1 u1 ...] and [v0 v0 v1 v1 ...]
+		const __m256i u = _mm256_and_si256(uv6, lowWord);
+		const __m256i v = _mm256_srli_epi32(uv6, 16);
+		const __m256i u6 = _mm256_or_si256(u, _mm256_slli_epi32(u, 16));
+		const __m256i v6 = _mm256_or_si256(v, _mm256_slli_epi32(v, 16));
+
+		const __m256i y = _mm256_add_epi16(_mm256_mulhrs_epi16(y6, cy), round);
+		const __m256i r = _mm256_srai_epi16(_mm256_add_epi16(y, _mm256_mulhrs_epi16(v6, crv)), 4);
+		const __m256i g = _mm256_srai_epi16(_mm256_add_epi16(y, _mm256_add_epi16(_mm256_mulhrs_epi16(u6, cgu), _mm256_mulhrs_epi16(v6, cgv))), 4);
+		const __m256i b = _mm256_srai_epi16(_mm256_add_epi16(y, _mm256_mulhrs_epi16(u6, cbu)), 4);
+
+		// Interleave to BGRA: per 128 bit lane [B0-7 R0-7], [G0-7 A0-7] -> BGRA for pixels 0-3, 4-7
+		const __m256i br   = _mm256_packus_epi16(b, r);
+		const __m256i ga   = _mm256_packus_epi16(g, alpha);
+		const __m256i bg   = _mm256_unpacklo_epi8(br, ga);
+		const __m256i ra   = _mm256_unpackhi_epi8(br, ga);
+		const __m256i out0 = _mm256_unpacklo_epi16(bg, ra);	// pixels 0-3 | 8-11
+		const __m256i out1 = _mm256_unpackhi_epi16(bg, ra);	// pixels 4-7 | 12-15
+		_mm256_storeu_si256((__m256i*)(outBGRA + 4 * x),      _mm256_permute2x128_si256(out0, out1, 0x20));
+		_mm256_storeu_si256((__m256i*)(outBGRA + 4 * x + 32), _mm256_permute2x128_si256(out0, out1, 0x31));
+	}
+
+	if (x < inWidth)
+		ConvertRowScalar<M, Full, P010>(inY + (P010 ? 2 * x : x), inUV + (P010 ? 2 * x : x), outBGRA + 4 * x, inWidth - x);
+}
+
+#endif // EGAV_X86
+
+
+//==============================================================================
+// # Kernel table
+//==============================================================================
+
+template <EGAVColorMatrix M, bool Full, bool P010>
+static EGAVColorConverter::RowKernel SelectKernel(bool inSIMD)
+{
+#if EGAV_X86
+	if (inSIMD && EGAV_CPUHasAVX2())
+		return ConvertRowAVX2<M, Full, P010>;
+#else
+	(void)inSIMD;
+#endif
+	return ConvertRowScalar<M, Full, P010>;
+}
+
+template <bool P010>
+static EGAVColorConverter::RowKernel SelectKernel(const EGAVColorFormat& inFormat, bool inSIMD)
+{
+	switch (inFormat.matrix)
+	{
+		case EGAVColorMatrix::BT601:
+			return inFormat.fullRange ? SelectKernel<EGAVColorMatrix::BT601, true, P010>(inSIMD) : SelectKernel<EGAVColorMatrix::BT601, false, P010>(inSIMD);
+		case EGAVColorMatrix::BT2020:
+			return inFormat.fullRange ? SelectKernel<EGAVColorMatrix::BT2020, true, P010>(inSIMD) : SelectKernel<EGAVColorMatrix::BT2020, false, P010>(inSIMD);
+		case EGAVColorMatrix::BT709:
+		default:
+			return inFormat.fullRange ? SelectKernel<EGAVColorMatrix::BT709, true, P010>(inSIMD) : SelectKernel<EGAVColorMatrix::BT709, false, P010>(inSIMD);
+	}
+}
+
+EGAVColorConverter::RowKernel EGAVColorConverter::GetKernel(const EGAVColorFormat& inFormat, bool inP010, bool inSIMD)
+{
+	return inP010 ? SelectKernel<true>(inFormat, inSIMD) : SelectKernel<false>(inFormat, inSIMD);
+}
+
+
+//==============================================================================
+// # Class EGAVColorConverter
+//==============================================================================
+
+EGAVColorConverter::EGAVColorConverter()
+{
+	SelectKernels();
+}
+
+void EGAVColorConverter::SelectKernels()
+{
+	mKernelNV12 = GetKernel(mFormat, false, mSIMDEnabled);
+	mKernelP010 = GetKernel(mFormat, true, mSIMDEnabled);
+}
+
+void EGAVColorConverter::SetColorFormat(const EGAVColorFormat& inFormat)
+{
+	mFormat = inFormat;
+	SelectKernels();
+}
+
+void EGAVColorConverter::SetSIMDEnabled(bool inEnable)
+{
+	mSIMDEnabled = inEnable;
+	SelectKernels();
+}
+
+bool EGAVColorConverter::UpdateInfoFrame(const HDMI_GENERIC_INFOFRAME* inAVI, int inHeight)
+{
+	const bool isSD = inHeight < 720;
+	if (isSD == mLastIsSD && (inAVI != nullptr) == mHasLastAVI && (!inAVI || 0 == memcmp(inAVI, &mLastAVI, sizeof(mLastAVI))))
+		return false;
+
+	mHasLastAVI = (inAVI != nullptr);
+	mLastIsSD   = isSD;
+	if (inAVI)
+		memcpy(&mLastAVI, inAVI, sizeof(mLastAVI));
+
+	const EGAVColorFormat format = HDMI_AVI_GetColorFormat(inAVI, inHeight);
+	if (format == mFormat)
+		return false;
+	SetColorFormat(format);
+	return true;
+}
+
+static EGAVResult ConvertFrame(EGAVColorConverter::RowKernel inKernel,
+							   const uint8_t* inY, int inYStride, const uint8_t* inUV, int inUVStride,
+							   uint8_t* outBGRA, int outStride, int inWidth, int inHeight)
+{
+	EGAVResult_CheckPointer(inY);
+	EGAVResult_CheckPointer(inUV);
+	EGAVResult_CheckPointer(outBGRA);
+	if (inWidth <= 0 || inHeight <= 0 || (inWidth & 1) || (inHeight & 1))
+		return EGAVResult::ErrInvalidParameter;
+
+	for (int y = 0; y < inHeight; y++)
+		inKernel(inY + (size_t)y * inYStride, inUV + (size_t)(y / 2) * inUVStride, outBGRA + (size_t)y * outStride, inWidth);
+	return EGAVResult::Ok;
+}
+
+EGAVResult EGAVColorConverter::ConvertNV12(const uint8_t* inY, int inYStride, const uint8_t* inUV, int inUVStride,
+										   uint8_t* outBGRA, int outStride, int inWidth, int inHeight) const
+{
+	return ConvertFrame(mKernelNV12, inY, inYStride, inUV, inUVStride, outBGRA, outStride, inWidth, inHeight);
+}
+
+EGAVResult EGAVColorConverter::ConvertP010(const uint8_t* inY, int inYStride, const uint8_t* inUV, int inUVStride,
+										   uint8_t* outBGRA, int outStride, int inWidth, int inHeight) const
+{
+	return ConvertFrame(mKernelP010, inY, inYStride, inUV, inUVStride, outBGRA, outStride, inWidth, inHeight);
+}
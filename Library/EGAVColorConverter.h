@@ -0,0 +1,111 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVColorConverter.h
+
+@brief		YCbCr (NV12, P010) to BGRA conversion for CPU previews.
+
+			Matrix (BT.601, BT.709, BT.2020) and quantization range are taken from the
+			AVI info frame instead of being guessed. There is one kernel per
+			matrix/range/input format, with coefficients computed at compile time
+			(AVX2, scalar fallback).
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+
+#include "EGAVResult.h"
+#include "HDMIInfoFramesAPI.h"
+
+
+enum class EGAVColorMatrix
+{
+	BT601,
+	BT709,
+	BT2020,		//!< non-constant luminance
+};
+
+struct EGAVColorFormat
+{
+	EGAVColorMatrix		matrix		= EGAVColorMatrix::BT709;
+	bool				fullRange	= false;	//!< false: limited (16..235/240)
+
+	bool operator==(const EGAVColorFormat& inOther) const { return matrix == inOther.matrix && fullRange == inOther.fullRange; }
+	bool operator!=(const EGAVColorFormat& inOther) const { return !(*this == inOther); }
+};
+
+//! @brief Decodes colorimetry (C, EC) and YCC quantization range (YQ) of an AVI info frame.
+//! Without colorimetry data the CEA-861 default applies: BT.601 for SD (< 720 lines), BT.709 otherwise.
+EGAVColorFormat HDMI_AVI_GetColorFormat(const HDMI_GENERIC_INFOFRAME* inAVI, int inHeight);
+
+
+//==============================================================================
+// # Class EGAVColorConverter
+//==============================================================================
+
+class EGAVColorConverter
+{
+public:
+	//! @brief Converts one luma row and its (4:2:0) chroma row to BGRA
+	typedef void (*RowKernel)(const uint8_t* inY, const uint8_t* inUV, uint8_t* outBGRA, int inWidth);
+
+	EGAVColorConverter();
+
+	//! @brief Selects the kernels for the AVI info frame (nullptr: no info frame).
+	//! Cheap if nothing changed: the kernels are only re-selected when the info frame bytes or the height class change.
+	//! @return true if the color format changed
+	bool UpdateInfoFrame(const HDMI_GENERIC_INFOFRAME* inAVI, int inHeight);
+
+	void SetColorFormat(const EGAVColorFormat& inFormat);
+	EGAVColorFormat GetColorFormat() const { return mFormat; }
+
+	//! @brief Forces the scalar kernels (reference for the SIMD path)
+	void SetSIMDEnabled(bool inEnable);
+
+	//! @brief Width and height must be even, strides are in bytes
+	EGAVResult ConvertNV12(const uint8_t* inY, int inYStride, const uint8_t* inUV, int inUVStride,
+						   uint8_t* outBGRA, int outStride, int inWidth, int inHeight) const;
+	EGAVResult ConvertP010(const uint8_t* inY, int inYStride, const uint8_t* inUV, int inUVStride,
+						   uint8_t* outBGRA, int outStride, int inWidth, int inHeight) const;
+
+	//! @brief Kernel lookup (exposed for benchmarks)
+	static RowKernel GetKernel(const EGAVColorFormat& inFormat, bool inP010, bool inSIMD);
+
+private:
+	void SelectKernels();
+
+	EGAVColorFormat			mFormat;
+	bool					mSIMDEnabled	= true;
+	RowKernel				mKernelNV12		= nullptr;
+	RowKernel				mKernelP010		= nullptr;
+
+	// Change detection for UpdateInfoFrame()
+	HDMI_GENERIC_INFOFRAME	mLastAVI{};
+	bool					mHasLastAVI		= false;
+	bool					mLastIsSD		= false;
+};
@@ -0,0 +1,815 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVDeviceProxy.cpp
+
+@brief		Local RPC for ElgatoUVCDevice over a Unix domain socket
+**/
+//==============================================================================
+
+#include "EGAVDeviceProxy.h"
+#include "ElgatoUVCDevice.h"
+
+#include <cstring>
+#include <type_traits>
+
+#if !_UP_WINDOWS
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+
+static_assert(std::is_trivially_copyable<HDMI_GENERIC_INFOFRAME>::value && std::is_trivially_copyable<HDMI_AUDIO_INFO>::value, "sent as raw bytes");
+
+static const size_t kMaxClientOutput = 1 << 20;	//!< a client that doesn't read its responses is disconnected
+
+
+bool EGAVProxy_IsWriteOp(EGAVProxyOp inOp)
+{
+	return inOp == EGAVProxyOp::SetHDRTonemappingEnabled;
+}
+
+
+#if _UP_WINDOWS
+
+// Not implemented on Windows
+EGAVDeviceProxyServer::EGAVDeviceProxyServer(ElgatoUVCDevice& inDevice) : mDevice(inDevice) {}
+EGAVDeviceProxyServer::~EGAVDeviceProxyServer() {}
+EGAVResult EGAVDeviceProxyServer::Start(const std::string&, int) { return EGAVResult::ErrNotSupported; }
+void EGAVDeviceProxyServer::Stop() {}
+EGAVDeviceProxyStatistics EGAVDeviceProxyServer::GetStatistics() const { return EGAVDeviceProxyStatistics(); }
+
+EGAVDeviceProxyClient::~EGAVDeviceProxyClient() {}
+EGAVResult EGAVDeviceProxyClient::Connect(const std::string&) { return EGAVResult::ErrNotSupported; }
+void EGAVDeviceProxyClient::Disconnect() {}
+std::future<EGAVProxyResponse> EGAVDeviceProxyClient::SendRequest(EGAVProxyOp, const void*, size_t)
+{
+	std::promise<EGAVProxyResponse> promise;
+	promise.set_value(EGAVProxyResponse{ EGAVResult::ErrNotSupported, {} });
+	return promise.get_future();
+}
+
+#else
+
+static void CloseFD(int& ioFD)
+{
+	if (ioFD >= 0)
+		close(ioFD);
+	ioFD = -1;
+}
+
+static bool MakeSocketAddress(const std::string& inPath, sockaddr_un& outAddress)
+{
+	memset(&outAddress, 0, sizeof(outAddress));
+	outAddress.sun_family = AF_UNIX;
+	if (inPath.empty() || inPath.size() >= sizeof(outAddress.sun_path))
+		return false;
+	memcpy(outAddress.sun_path, inPath.c_str(), inPath.size());
+	return true;
+}
+
+static void DisableSigPipe(int inSocket)
+{
+#ifdef SO_NOSIGPIPE
+	const int on = 1;
+	setsockopt(inSocket, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+	(void)inSocket;
+#endif
+}
+
+static void SetNonBlocking(int inFD)
+{
+	fcntl(inFD, F_SETFL, fcntl(inFD, F_GETFL, 0) | O_NONBLOCK);
+}
+
+static ssize_t SendNoSignal(int inSocket, const void* inData, size_t inLength)
+{
+#ifdef MSG_NOSIGNAL
+	return send(inSocket, inData, inLength, MSG_NOSIGNAL);
+#else
+	return send(inSocket, inData, inLength, 0); // SO_NOSIGPIPE
+#endif
+}
+
+
+//! @brief Removes the socket file a crashed server left behind; a live server is left alone
+//! @return ErrDeviceInUse if a server accepts connections on the path, ErrInvalidPath if it isn't a socket
+static EGAVResult RemoveStaleSocket(const sockaddr_un& inAddress)
+{
+	struct stat info;
+	if (lstat(inAddress.sun_path, &info) != 0)
+		return EGAVResult::Ok; // nothing there
+	if (!S_ISSOCK(info.st_mode))
+		return EGAVResult::ErrInvalidPath;
+
+	int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (probe < 0)
+		return EGAVResult::ErrResourceNotAvail;
+	const bool live = connect(probe, (const sockaddr*)&inAddress, sizeof(inAddress)) == 0 || errno != ECONNREFUSED;
+	CloseFD(probe);
+	if (live)
+		return EGAVResult::ErrDeviceInUse;
+
+	unlink(inAddress.sun_path);
+	return EGAVResult::Ok;
+}
+
+
+//==============================================================================
+// # Class EGAVDeviceProxyServer
+//==============================================================================
+
+EGAVDeviceProxyServer::EGAVDeviceProxyServer(ElgatoUVCDevice& inDevice)
+	: mDevice(inDevice)
+{
+}
+
+EGAVDeviceProxyServer::~EGAVDeviceProxyServer()
+{
+	Stop();
+}
+
+EGAVResult EGAVDeviceProxyServer::Start(const std::string& inSocketPath, int inMode /*= 0660*/)
+{
+	Stop();
+
+	sockaddr_un address;
+	if (!MakeSocketAddress(inSocketPath, address))
+		return EGAVResult::ErrInvalidPath;
+
+	mListenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (mListenSocket < 0 || pipe(mWakeFDs) != 0)
+	{
+		CloseFD(mListenSocket);
+		return EGAVResult::ErrResourceNotAvail;
+	}
+	SetNonBlocking(mListenSocket);
+	SetNonBlocking(mWakeFDs[0]);
+	SetNonBlocking(mWakeFDs[1]);
+
+	EGAVResult res = RemoveStaleSocket(address);
+	if (res.Succeeded())
+	{
+		// The socket is created with its final mode: no window in which it is accessible with the default umask.
+		// umask() is process-wide; files created by other threads during bind() get the stricter of both masks.
+		const mode_t previousMask = umask((mode_t)(~inMode & 0777));
+		const bool bound = bind(mListenSocket, (const sockaddr*)&address, sizeof(address)) == 0;
+		umask(previousMask);
+		if (!bound || listen(mListenSocket, 64) != 0)
+		{
+			error_printf("EGAVDeviceProxyServer: can't listen on %s (%d)", inSocketPath.c_str(), errno);
+			res = EGAVResult::ErrInvalidPath;
+		}
+	}
+	if (res.Failed())
+	{
+		CloseFD(mListenSocket);
+		CloseFD(mWakeFDs[0]);
+		CloseFD(mWakeFDs[1]);
+		return res;
+	}
+
+	mSocketPath = inSocketPath;
+	mDeviceThread = std::thread(&EGAVDeviceProxyServer::DeviceThread, this);
+	mThread = std::thread(&EGAVDeviceProxyServer::ServerThread, this);
+	return EGAVResult::Ok;
+}
+
+void EGAVDeviceProxyServer::Stop()
+{
+	if (mThread.joinable())
+	{
+		{
+			const std::lock_guard<std::mutex> lock(mBatchMutex);
+			mStopping = true;
+		}
+		mBatchCondition.notify_all();
+		Wake();
+		mThread.join();
+	}
+	if (mDeviceThread.joinable())
+		mDeviceThread.join(); // finishes the batch it is executing
+
+	for (Client& client : mClients)
+		CloseFD(client.socket);
+	mClients.clear();
+	mQueued.clear();
+	mBatch.clear();
+	mResponses.clear();
+	mDeviceBusy = false;
+	mStopping = false;
+	if (mListenSocket >= 0)
+	{
+		CloseFD(mListenSocket);
+		unlink(mSocketPath.c_str());
+	}
+	CloseFD(mWakeFDs[0]);
+	CloseFD(mWakeFDs[1]);
+
+	const std::lock_guard<std::mutex> lock(mStatisticsMutex);
+	mStatistics.clients = 0;
+}
+
+EGAVDeviceProxyStatistics EGAVDeviceProxyServer::GetStatistics() const
+{
+	const std::lock_guard<std::mutex> lock(mStatisticsMutex);
+	return mStatistics;
+}
+
+void EGAVDeviceProxyServer::Wake()
+{
+	// A full pipe already wakes the server thread
+	const char wake = 1;
+	if (write(mWakeFDs[1], &wake, 1) < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+		warning_printf("EGAVDeviceProxyServer: wake-up failed (%d)", errno);
+}
+
+EGAVDeviceProxyServer::Client* EGAVDeviceProxyServer::FindClient(uint64_t inID)
+{
+	for (Client& client : mClients)
+		if (client.id == inID)
+			return client.closed ? nullptr : &client;
+	return nullptr;
+}
+
+bool EGAVDeviceProxyServer::ReadClient(Client& ioClient)
+{
+	uint8_t buffer[4096];
+	while (true)
+	{
+		const ssize_t received = recv(ioClient.socket, buffer, sizeof(buffer), 0);
+		if (received > 0)
+			ioClient.input.insert(ioClient.input.end(), buffer, buffer + received);
+		else if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return true;
+		else if (received < 0 && errno == EINTR)
+			continue;
+		else
+			return false; // closed or error
+	}
+}
+
+bool EGAVDeviceProxyServer::FlushClient(Client& ioClient)
+{
+	size_t sent = 0;
+	while (sent < ioClient.output.size())
+	{
+		const ssize_t n = SendNoSignal(ioClient.socket, ioClient.output.data() + sent, ioClient.output.size() - sent);
+		if (n > 0)
+			sent += (size_t)n;
+		else if (n < 0 && errno == EINTR)
+			continue;
+		else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break; // rest is sent when the socket is writable again
+		else
+			return false;
+	}
+	ioClient.output.erase(ioClient.output.begin(), ioClient.output.begin() + sent);
+	return ioClient.output.size() <= kMaxClientOutput;
+}
+
+EGAVResult EGAVDeviceProxyServer::Execute(EGAVProxyOp inOp, const uint8_t* inPayload, size_t inLength, std::vector<uint8_t>& outPayload)
+{
+	auto output = [&outPayload](const void* inData, size_t inSize)
+	{
+		outPayload.assign((const uint8_t*)inData, (const uint8_t*)inData + inSize);
+	};
+
+	EGAVResult res = EGAVResult::ErrInvalidParameter;
+	switch (inOp)
+	{
+		case EGAVProxyOp::SetHDRTonemappingEnabled:
+			if (inLength == 1)
+				res = mDevice.SetHDRTonemappingEnabled(inPayload[0] != 0);
+			break;
+
+		case EGAVProxyOp::IsVideoHDR:
+		{
+			bool isHDR = false;
+			res = mDevice.IsVideoHDR(isHDR);
+			const uint8_t value = isHDR ? 1 : 0;
+			output(&value, sizeof(value));
+			break;
+		}
+
+		case EGAVProxyOp::GetHDMIHDRStatusPacket:
+		case EGAVProxyOp::GetHDMIInfoFrame:
+		{
+			HDMI_GENERIC_INFOFRAME frame{};
+			if (inOp == EGAVProxyOp::GetHDMIHDRStatusPacket)
+				res = mDevice.GetHDMIHDRStatusPacket(frame);
+			else if (inLength == 1)
+				res = mDevice.GetHDMIInfoFrame(inPayload[0], frame);
+			output(&frame, sizeof(frame));
+			break;
+		}
+
+		case EGAVProxyOp::GetHDMIContentType:
+		case EGAVProxyOp::GetPixelRepetitionFactor:
+		{
+			int value = HDMI_ERROR;
+			res = (inOp == EGAVProxyOp::GetHDMIContentType) ? mDevice.GetHDMIContentType(value) : mDevice.GetPixelRepetitionFactor(value);
+			const int32_t value32 = value;
+			output(&value32, sizeof(value32));
+			break;
+		}
+
+		case EGAVProxyOp::GetHDMIAudioInfo:
+		{
+			HDMI_AUDIO_INFO info;
+			res = mDevice.GetHDMIAudioInfo(info);
+			output(&info, sizeof(info));
+			break;
+		}
+
+		default:
+			res = EGAVResult::ErrNotSupported;
+			break;
+	}
+	return res;
+}
+
+//! @brief Device thread: executes inBatch, outResponses gets one response frame per request
+void EGAVDeviceProxyServer::ProcessBatch(const std::vector<Request>& inBatch, std::vector<Response>& outResponses)
+{
+	// Results of this batch, reused for identical requests
+	struct CachedResult
+	{
+		const Request*			request;
+		int32_t					result;
+		std::vector<uint8_t>	payload;
+	};
+	std::vector<CachedResult> cache;
+
+	uint64_t executed = 0, coalesced = 0;
+	for (const Request& request : inBatch)
+	{
+		const EGAVProxyOp op = (EGAVProxyOp)request.header.op;
+		const CachedResult* cached = nullptr;
+		for (const CachedResult& entry : cache)
+		{
+			if (entry.request->header.op == request.header.op && entry.request->header.payloadLength == request.header.payloadLength &&
+				entry.request->payload == request.payload)
+			{
+				cached = &entry;
+				break;
+			}
+		}
+
+		if (cached)
+			coalesced++;
+		else
+		{
+			if (EGAVProxy_IsWriteOp(op))
+				cache.clear(); // reads before the write are outdated
+
+			CachedResult entry;
+			entry.request = &request;
+			entry.result  = Execute(op, request.payload.data(), request.payload.size(), entry.payload).GetResultCode();
+			cache.push_back(std::move(entry));
+			cached = &cache.back();
+			executed++;
+		}
+
+		EGAVProxyResponseHeader header;
+		header.op				= request.header.op;
+		header.payloadLength	= (uint16_t)cached->payload.size();
+		header.requestID		= request.header.requestID;
+		header.result			= cached->result;
+
+		Response response;
+		response.client = request.client;
+		response.frame.assign((const uint8_t*)&header, (const uint8_t*)&header + sizeof(header));
+		response.frame.insert(response.frame.end(), cached->payload.begin(), cached->payload.end());
+		outResponses.push_back(std::move(response));
+	}
+
+	const std::lock_guard<std::mutex> lock(mStatisticsMutex);
+	mStatistics.executed  += executed;
+	mStatistics.coalesced += coalesced;
+	mStatistics.batches++;
+}
+
+void EGAVDeviceProxyServer::DeviceThread()
+{
+	std::vector<Request> batch;
+	std::vector<Response> responses;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mBatchMutex);
+			mBatchCondition.wait(lock, [this] { return mStopping || !mBatch.empty(); });
+			if (mStopping)
+				break;
+			batch.clear();
+			batch.swap(mBatch);
+		}
+
+		responses.clear();
+		ProcessBatch(batch, responses);
+
+		{
+			const std::lock_guard<std::mutex> lock(mBatchMutex);
+			mResponses.insert(mResponses.end(), std::make_move_iterator(responses.begin()), std::make_move_iterator(responses.end()));
+			mDeviceBusy = false;
+		}
+		Wake();
+	}
+}
+
+void EGAVDeviceProxyServer::ServerThread()
+{
+	std::vector<pollfd> pfds;
+	std::vector<Response> responses;
+	while (true)
+	{
+		pfds.clear();
+		pfds.push_back({ mWakeFDs[0], POLLIN, 0 });
+		pfds.push_back({ mListenSocket, POLLIN, 0 });
+		for (const Client& client : mClients)
+			pfds.push_back({ client.socket, (short)(POLLIN | (client.output.empty() ? 0 : POLLOUT)), 0 });
+
+		if (poll(pfds.data(), (nfds_t)pfds.size(), -1) < 0 && errno != EINTR)
+			break;
+		if (pfds[0].revents)
+		{
+			char drain[64];
+			while (read(mWakeFDs[0], drain, sizeof(drain)) > 0)
+				;
+			const std::lock_guard<std::mutex> lock(mBatchMutex);
+			if (mStopping)
+				break;
+		}
+
+		// New clients
+		const size_t polledClients = mClients.size();
+		for (int socket; (socket = accept(mListenSocket, nullptr, nullptr)) >= 0; )
+		{
+			SetNonBlocking(socket);
+			DisableSigPipe(socket);
+			Client client;
+			client.id     = mNextClientID++;
+			client.socket = socket;
+			mClients.push_back(std::move(client));
+		}
+
+		// Read everything that arrived and split it into requests. Ping is answered right away,
+		// device operations are queued for the device thread.
+		uint64_t received = 0;
+		for (size_t i = 0; i < polledClients; i++)
+		{
+			Client& client = mClients[i];
+			if ((pfds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) && !ReadClient(client))
+				client.closed = true;
+
+			size_t offset = 0;
+			while (!client.closed && client.input.size() - offset >= sizeof(EGAVProxyRequestHeader))
+			{
+				Request request;
+				memcpy(&request.header, client.input.data() + offset, sizeof(request.header));
+				if (request.header.payloadLength > EGAV_PROXY_MAX_PAYLOAD)
+				{
+					warning_printf("EGAVDeviceProxyServer: protocol error, closing client");
+					client.closed = true;
+					break;
+				}
+				if (client.input.size() - offset < sizeof(request.header) + request.header.payloadLength)
+					break;
+				const uint8_t* payload = client.input.data() + offset + sizeof(request.header);
+				offset += sizeof(request.header) + request.header.payloadLength;
+				received++;
+
+				if ((EGAVProxyOp)request.header.op == EGAVProxyOp::Ping)
+				{
+					EGAVProxyResponseHeader header;
+					header.op				= request.header.op;
+					header.payloadLength	= 0;
+					header.requestID		= request.header.requestID;
+					header.result			= EGAVResult::Ok;
+					client.output.insert(client.output.end(), (const uint8_t*)&header, (const uint8_t*)&header + sizeof(header));
+					continue;
+				}
+				request.client = client.id;
+				request.payload.assign(payload, payload + request.header.payloadLength);
+				mQueued.push_back(std::move(request));
+			}
+			client.input.erase(client.input.begin(), client.input.begin() + offset);
+		}
+
+		// Collect finished responses; hand the queued requests to the device thread once it is idle
+		responses.clear();
+		{
+			const std::lock_guard<std::mutex> lock(mBatchMutex);
+			responses.swap(mResponses);
+			if (!mDeviceBusy && !mQueued.empty())
+			{
+				mBatch.swap(mQueued);
+				mQueued.clear();
+				mDeviceBusy = true;
+				mBatchCondition.notify_one();
+			}
+		}
+		for (Response& response : responses)
+		{
+			Client* client = FindClient(response.client);
+			if (client) // else: closed while its requests were executed
+				client->output.insert(client->output.end(), response.frame.begin(), response.frame.end());
+		}
+
+		for (Client& client : mClients)
+		{
+			if (!client.closed && !client.output.empty() && !FlushClient(client))
+				client.closed = true;
+		}
+
+		for (size_t i = 0; i < mClients.size(); )
+		{
+			if (mClients[i].closed)
+			{
+				CloseFD(mClients[i].socket);
+				mClients.erase(mClients.begin() + i);
+			}
+			else
+				i++;
+		}
+
+		const std::lock_guard<std::mutex> lock(mStatisticsMutex);
+		mStatistics.requests += received;
+		mStatistics.clients = (int)mClients.size();
+	}
+}
+
+
+//==============================================================================
+// # Class EGAVDeviceProxyClient
+//==============================================================================
+
+EGAVDeviceProxyClient::~EGAVDeviceProxyClient()
+{
+	Disconnect();
+}
+
+EGAVResult EGAVDeviceProxyClient::Connect(const std::string& inSocketPath)
+{
+	Disconnect();
+
+	sockaddr_un address;
+	if (!MakeSocketAddress(inSocketPath, address))
+		return EGAVResult::ErrInvalidPath;
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (const sockaddr*)&address, sizeof(address)) != 0)
+	{
+		CloseFD(fd);
+		return EGAVResult::ErrNotFound;
+	}
+	DisableSigPipe(fd);
+
+	{
+		const std::lock_guard<std::mutex> lock(mSendMutex);
+		mSocket = fd;
+	}
+	mConnected = true;
+	mReceiver = std::thread(&EGAVDeviceProxyClient::ReceiveThread, this);
+	return EGAVResult::Ok;
+}
+
+void EGAVDeviceProxyClient::Disconnect()
+{
+	// shutdown() without the lock: it ends the receive thread and a send blocked on a full socket.
+	// The descriptor is closed under the lock, so a concurrent SendRequest() can't use it after close
+	// (or a descriptor number reused by another open).
+	if (mSocket >= 0)
+		shutdown(mSocket, SHUT_RDWR);
+	if (mReceiver.joinable())
+		mReceiver.join();
+	{
+		const std::lock_guard<std::mutex> lock(mSendMutex);
+		CloseFD(mSocket);
+	}
+	mConnected = false;
+	FailPending();
+}
+
+void EGAVDeviceProxyClient::FailPending()
+{
+	std::map<uint32_t, std::promise<EGAVProxyResponse>> pending;
+	{
+		const std::lock_guard<std::mutex> lock(mPendingMutex);
+		pending.swap(mPending);
+	}
+	for (auto& entry : pending)
+		entry.second.set_value(EGAVProxyResponse{ EGAVResult::ErrResourceNotAvail, {} });
+}
+
+std::future<EGAVProxyResponse> EGAVDeviceProxyClient::SendRequest(EGAVProxyOp inOp, const void* inPayload /*= nullptr*/, size_t inLength /*= 0*/)
+{
+	std::promise<EGAVProxyResponse> promise;
+	std::future<EGAVProxyResponse> future = promise.get_future();
+	if (!mConnected || inLength > EGAV_PROXY_MAX_PAYLOAD || (inLength && !inPayload))
+	{
+		promise.set_value(EGAVProxyResponse{ mConnected ? EGAVResult::ErrInvalidParameter : EGAVResult::ErrResourceNotAvail, {} });
+		return future;
+	}
+
+	EGAVProxyRequestHeader header;
+	header.op				= (uint16_t)inOp;
+	header.payloadLength	= (uint16_t)inLength;
+	{
+		// mConnected is cleared under this lock before the pending requests are failed: none gets lost
+		const std::lock_guard<std::mutex> lock(mPendingMutex);
+		if (!mConnected)
+		{
+			promise.set_value(EGAVProxyResponse{ EGAVResult::ErrResourceNotAvail, {} });
+			return future;
+		}
+		header.requestID = mNextRequestID++;
+		mPending.emplace(header.requestID, std::move(promise));
+	}
+
+	uint8_t frame[sizeof(EGAVProxyRequestHeader) + EGAV_PROXY_MAX_PAYLOAD];
+	memcpy(frame, &header, sizeof(header));
+	if (inLength)
+		memcpy(frame + sizeof(header), inPayload, inLength);
+
+	bool sent = true;
+	{
+		const std::lock_guard<std::mutex> lock(mSendMutex);
+		sent = (mSocket >= 0);
+		for (size_t offset = 0, size = sizeof(header) + inLength; sent && offset < size; )
+		{
+			const ssize_t n = SendNoSignal(mSocket, frame + offset, size - offset);
+			if (n > 0)
+				offset += (size_t)n;
+			else if (!(n < 0 && errno == EINTR))
+				sent = false;
+		}
+	}
+
+	if (!sent)
+	{
+		std::promise<EGAVProxyResponse> failed;
+		{
+			const std::lock_guard<std::mutex> lock(mPendingMutex);
+			auto it = mPending.find(header.requestID);
+			if (it == mPending.end())
+				return future; // already failed by the receive thread
+			failed = std::move(it->second);
+			mPending.erase(it);
+		}
+		failed.set_value(EGAVProxyResponse{ EGAVResult::ErrResourceNotAvail, {} });
+	}
+	return future;
+}
+
+void EGAVDeviceProxyClient::ReceiveThread()
+{
+	auto receiveAll = [this](void* outData, size_t inLength)
+	{
+		for (size_t offset = 0; offset < inLength; )
+		{
+			const ssize_t n = recv(mSocket, (uint8_t*)outData + offset, inLength - offset, 0);
+			if (n > 0)
+				offset += (size_t)n;
+			else if (!(n < 0 && errno == EINTR))
+				return false;
+		}
+		return true;
+	};
+
+	while (true)
+	{
+		EGAVProxyResponseHeader header;
+		EGAVProxyResponse response;
+		if (!receiveAll(&header, sizeof(header)))
+			break;
+		response.payload.resize(header.payloadLength);
+		if (header.payloadLength && !receiveAll(response.payload.data(), header.payloadLength))
+			break;
+		response.result = EGAVResult(header.result);
+
+		std::promise<EGAVProxyResponse> promise;
+		{
+			const std::lock_guard<std::mutex> lock(mPendingMutex);
+			auto it = mPending.find(header.requestID);
+			if (it == mPending.end())
+				continue;
+			promise = std::move(it->second);
+			mPending.erase(it);
+		}
+		promise.set_value(std::move(response));
+	}
+
+	{
+		const std::lock_guard<std::mutex> lock(mPendingMutex);
+		mConnected = false;
+	}
+	FailPending();
+}
+
+#endif // !_UP_WINDOWS
+
+
+//------------------------------------------------------------------------------
+// Typed operations
+//------------------------------------------------------------------------------
+
+EGAVProxyResponse EGAVDeviceProxyClient::Call(EGAVProxyOp inOp, const void* inPayload /*= nullptr*/, size_t inLength /*= 0*/)
+{
+	return SendRequest(inOp, inPayload, inLength).get();
+}
+
+//! @brief Copies a fixed size response payload
+template <typename T>
+static EGAVResult GetPayload(const EGAVProxyResponse& inResponse, T& outValue)
+{
+	if (inResponse.result.Succeeded())
+	{
+		if (inResponse.payload.size() != sizeof(T))
+			return EGAVResult::ErrInvalidFormat;
+		memcpy((void*)&outValue, inResponse.payload.data(), sizeof(T));
+	}
+	return inResponse.result;
+}
+
+EGAVResult EGAVDeviceProxyClient::Ping()
+{
+	return Call(EGAVProxyOp::Ping).result;
+}
+
+EGAVResult EGAVDeviceProxyClient::SetHDRTonemappingEnabled(bool inEnable)
+{
+	const uint8_t enable = inEnable ? 1 : 0;
+	return Call(EGAVProxyOp::SetHDRTonemappingEnabled, &enable, sizeof(enable)).result;
+}
+
+EGAVResult EGAVDeviceProxyClient::IsVideoHDR(bool& outIsHDR)
+{
+	uint8_t isHDR = 0;
+	EGAVResult res = GetPayload(Call(EGAVProxyOp::IsVideoHDR), isHDR);
+	if (res.Succeeded())
+		outIsHDR = (isHDR != 0);
+	return res;
+}
+
+EGAVResult EGAVDeviceProxyClient::GetHDMIHDRStatusPacket(HDMI_GENERIC_INFOFRAME& outFrame)
+{
+	return GetPayload(Call(EGAVProxyOp::GetHDMIHDRStatusPacket), outFrame);
+}
+
+EGAVResult EGAVDeviceProxyClient::GetHDMIInfoFrame(uint8_t inType, HDMI_GENERIC_INFOFRAME& outFrame)
+{
+	return GetPayload(Call(EGAVProxyOp::GetHDMIInfoFrame, &inType, sizeof(inType)), outFrame);
+}
+
+EGAVResult EGAVDeviceProxyClient::GetHDMIContentType(int& outContentType)
+{
+	int32_t value = HDMI_ERROR;
+	EGAVResult res = GetPayload(Call(EGAVProxyOp::GetHDMIContentType), value);
+	if (res.Succeeded())
+		outContentType = value;
+	return res;
+}
+
+EGAVResult EGAVDeviceProxyClient::GetPixelRepetitionFactor(int& outFactor)
+{
+	int32_t value = HDMI_ERROR;
+	EGAVResult res = GetPayload(Call(EGAVProxyOp::GetPixelRepetitionFactor), value);
+	if (res.Succeeded())
+		outFactor = value;
+	return res;
+}
+
+EGAVResult EGAVDeviceProxyClient::GetHDMIAudioInfo(HDMI_AUDIO_INFO& outInfo)
+{
+	return GetPayload(Call(EGAVProxyOp::GetHDMIAudioInfo), outInfo);
+}
@@ -0,0 +1,240 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVDeviceProxy.h
+
+@brief		Local RPC for ElgatoUVCDevice over a Unix domain socket.
+
+			The server runs in the process that owns the device (e.g. the
+			EGAVStatusDaemon sample). Clients only need access to the socket, not to
+			the HID device, and their requests can't interleave on the I2C bus.
+
+			Framing: 8 byte request header (operation, payload length, request ID) and
+			12 byte response header (plus the result code), followed by the payload in
+			host byte order (same machine only). Clients may send any number of
+			requests without waiting (pipelining); responses carry the request ID.
+			Device operations run on a separate device thread, so a slow device
+			doesn't stall the server thread: it keeps accepting clients, reading
+			requests and answering Ping. Requests that arrive while the device thread
+			is busy form the next batch; identical requests of a batch are executed
+			once (coalescing). A write discards the coalesced read results, so a
+			client still sees its own writes.
+
+			Raw I2C access is deliberately not exposed.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EGAVResult.h"
+#include "HDMIInfoFramesAPI.h"
+
+class ElgatoUVCDevice;
+
+
+//==============================================================================
+// # Protocol
+//==============================================================================
+
+enum class EGAVProxyOp : uint16_t
+{
+	Ping						= 1,	//!< answered by the server thread, no device access (latency measurements, keep-alive)
+	SetHDRTonemappingEnabled	= 2,	//!< payload: uint8_t enable
+	IsVideoHDR					= 3,	//!< response: uint8_t isHDR
+	GetHDMIHDRStatusPacket		= 4,	//!< response: HDMI_GENERIC_INFOFRAME
+	GetHDMIInfoFrame			= 5,	//!< payload: uint8_t type; response: HDMI_GENERIC_INFOFRAME
+	GetHDMIContentType			= 6,	//!< response: int32_t
+	GetPixelRepetitionFactor	= 7,	//!< response: int32_t
+	GetHDMIAudioInfo			= 8,	//!< response: HDMI_AUDIO_INFO
+	// EXTEND_PROXY_OPS: add the operation here, in EGAVProxy_IsWriteOp() and in EGAVDeviceProxyServer::Execute()
+};
+
+//! @return true if the operation changes device state (ends coalescing of reads)
+bool EGAVProxy_IsWriteOp(EGAVProxyOp inOp);
+
+#pragma pack(push, 1)
+struct EGAVProxyRequestHeader
+{
+	uint16_t	op;				//!< EGAVProxyOp
+	uint16_t	payloadLength;
+	uint32_t	requestID;
+};
+
+struct EGAVProxyResponseHeader
+{
+	uint16_t	op;
+	uint16_t	payloadLength;
+	uint32_t	requestID;
+	int32_t		result;			//!< EGAVResultCode
+};
+#pragma pack(pop)
+
+static_assert(sizeof(EGAVProxyRequestHeader) == 8 && sizeof(EGAVProxyResponseHeader) == 12, "proxy framing");
+
+#define EGAV_PROXY_MAX_PAYLOAD		512		//!< larger frames are a protocol error (connection closed)
+
+struct EGAVProxyResponse
+{
+	EGAVResult				result;
+	std::vector<uint8_t>	payload;
+};
+
+
+//==============================================================================
+// # Class EGAVDeviceProxyServer
+//==============================================================================
+
+struct EGAVDeviceProxyStatistics
+{
+	uint64_t	requests	= 0;	//!< requests received
+	uint64_t	executed	= 0;	//!< device operations executed
+	uint64_t	coalesced	= 0;	//!< requests answered with the result of an identical request
+	uint64_t	batches		= 0;
+	int			clients		= 0;	//!< connected clients
+};
+
+class EGAVDeviceProxyServer
+{
+public:
+	explicit EGAVDeviceProxyServer(ElgatoUVCDevice& inDevice);
+	~EGAVDeviceProxyServer();
+
+	//! @brief Listens on the socket and starts the server thread. A socket file left by a crashed server is replaced.
+	//! @param inMode file permissions of the socket (who may control the device)
+	//! @return ErrDeviceInUse if another server listens on the path, ErrInvalidPath if the path is not a socket
+	EGAVResult Start(const std::string& inSocketPath, int inMode = 0660);
+	void Stop();
+
+	EGAVDeviceProxyStatistics GetStatistics() const;
+
+private:
+	struct Client
+	{
+		uint64_t				id		= 0;	//!< stays valid while the device thread executes the client's requests
+		int						socket	= -1;
+		std::vector<uint8_t>	input;
+		std::vector<uint8_t>	output;
+		bool					closed	= false;
+	};
+
+	struct Request
+	{
+		uint64_t				client;
+		EGAVProxyRequestHeader	header;
+		std::vector<uint8_t>	payload;
+	};
+
+	struct Response
+	{
+		uint64_t				client;
+		std::vector<uint8_t>	frame;			//!< header and payload
+	};
+
+	void ServerThread();
+	void DeviceThread();
+	void Wake();
+	Client* FindClient(uint64_t inID);
+	bool ReadClient(Client& ioClient);
+	bool FlushClient(Client& ioClient);
+	void ProcessBatch(const std::vector<Request>& inBatch, std::vector<Response>& outResponses);
+	EGAVResult Execute(EGAVProxyOp inOp, const uint8_t* inPayload, size_t inLength, std::vector<uint8_t>& outPayload);
+
+	ElgatoUVCDevice&			mDevice;
+	std::string					mSocketPath;
+	int							mListenSocket	= -1;
+	int							mWakeFDs[2]		= { -1, -1 };	//!< pipe: Stop() and finished batches wake the server thread
+	std::thread					mThread;
+	std::thread					mDeviceThread;
+	std::vector<Client>			mClients;						//!< server thread only
+	std::vector<Request>		mQueued;						//!< server thread only: waits for the device thread
+	uint64_t					mNextClientID	= 1;			//!< server thread only
+
+	std::mutex					mBatchMutex;
+	std::condition_variable		mBatchCondition;
+	std::vector<Request>		mBatch;							//!< mBatchMutex: handed to the device thread
+	std::vector<Response>		mResponses;						//!< mBatchMutex: finished by the device thread
+	bool						mDeviceBusy		= false;		//!< mBatchMutex
+	bool						mStopping		= false;		//!< mBatchMutex
+
+	mutable std::mutex			mStatisticsMutex;
+	EGAVDeviceProxyStatistics	mStatistics;
+};
+
+
+//==============================================================================
+// # Class EGAVDeviceProxyClient
+//==============================================================================
+
+//! @brief Client side: the same operations as ElgatoUVCDevice. Thread safe; concurrent calls are pipelined on one connection.
+class EGAVDeviceProxyClient
+{
+public:
+	EGAVDeviceProxyClient() = default;
+	~EGAVDeviceProxyClient();
+
+	EGAVResult Connect(const std::string& inSocketPath);
+	void Disconnect();
+	bool IsConnected() const { return mConnected; }
+
+	//! @brief Sends a request without waiting for the response (pipelining)
+	//! A lost connection completes the future with ErrResourceNotAvail.
+	std::future<EGAVProxyResponse> SendRequest(EGAVProxyOp inOp, const void* inPayload = nullptr, size_t inLength = 0);
+
+	//! @brief Sends a request and waits for the response
+	EGAVProxyResponse Call(EGAVProxyOp inOp, const void* inPayload = nullptr, size_t inLength = 0);
+
+	EGAVResult Ping();
+	EGAVResult SetHDRTonemappingEnabled(bool inEnable);
+	EGAVResult IsVideoHDR(bool& outIsHDR);
+	EGAVResult GetHDMIHDRStatusPacket(HDMI_GENERIC_INFOFRAME& outFrame);
+	EGAVResult GetHDMIInfoFrame(uint8_t inType, HDMI_GENERIC_INFOFRAME& outFrame);
+	EGAVResult GetHDMIContentType(int& outContentType);
+	EGAVResult GetPixelRepetitionFactor(int& outFactor);
+	EGAVResult GetHDMIAudioInfo(HDMI_AUDIO_INFO& outInfo);
+
+private:
+	void ReceiveThread();
+	void FailPending();
+
+	int							mSocket			= -1;	//!< changed and used for sending under mSendMutex
+	std::atomic<bool>			mConnected{false};
+	std::thread					mReceiver;
+
+	std::mutex					mSendMutex;		//!< one frame at a time on the socket; Disconnect() doesn't close it during a send
+	std::mutex					mPendingMutex;
+	std::map<uint32_t, std::promise<EGAVProxyResponse>> mPending;
+	uint32_t					mNextRequestID	= 1;	//!< mPendingMutex
+};
@@ -32,6 +32,7 @@ SOFTWARE.
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "EGAVResult.h"
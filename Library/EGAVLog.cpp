@@ -0,0 +1,503 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVLog.cpp
+
+@brief		Binary logging backend for the debug macros
+**/
+//==============================================================================
+
+#include "EGAVLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+std::atomic<int> EGAVLog::sLevel{-1};
+
+static EGAVLogConfig					gConfig;
+static std::unique_ptr<EGAVLogRecord[]>	gRecords;
+static std::unique_ptr<EGAVLogRing[]>	gRingStorage;
+static std::atomic<EGAVLogRing*>		gRings{nullptr};		//!< never freed: threads may log while the logger stops
+static int								gRingCount	= 0;
+static std::atomic<uint64_t>			gDroppedNoRing{0};
+static std::atomic<uint64_t>			gFormatted{0};
+static std::atomic<int>					gOverflowWaitUs{-1};	//!< EGAVLogOverflow::Wait: wait time, -1: drop (read by producers)
+
+static std::mutex						gMutex;				//!< consumer state, Start/Stop
+static std::condition_variable			gCondition;
+static std::condition_variable			gFlushDone;
+static std::thread						gConsumer;
+static bool								gStop				= false;
+static uint64_t							gFlushRequested		= 0;
+static uint64_t							gFlushCompleted		= 0;
+static std::mutex						gDrainMutex;		//!< one consumer at a time
+
+
+static uint64_t GetTimestampUs()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//==============================================================================
+// # Producer
+//==============================================================================
+
+namespace
+{
+	struct ThreadRing
+	{
+		EGAVLogRing* ring = nullptr;
+		~ThreadRing()
+		{
+			if (ring)
+				ring->state.store(2, std::memory_order_release); // the consumer drains and frees it
+		}
+	};
+}
+
+EGAVLogRing* EGAVLog::GetThreadRing()
+{
+	static thread_local ThreadRing tRing;
+	if (tRing.ring)
+		return tRing.ring;
+
+	EGAVLogRing* rings = gRings.load(std::memory_order_acquire);
+	for (int i = 0; rings && i < gRingCount; i++)
+	{
+		int expected = 0;
+		if (rings[i].state.compare_exchange_strong(expected, 1, std::memory_order_acq_rel))
+		{
+			rings[i].dropped = 0;
+			tRing.ring = &rings[i];
+			return tRing.ring;
+		}
+	}
+	gDroppedNoRing.fetch_add(1, std::memory_order_relaxed);
+	return nullptr;
+}
+
+EGAVLogRecord* EGAVLog::BeginRecord(EGAVLogRing* inRing)
+{
+	const uint64_t head = inRing->head.load(std::memory_order_relaxed);
+	if (head - inRing->tail.load(std::memory_order_acquire) > inRing->mask)
+	{
+		bool full = true;
+		const int waitUs = gOverflowWaitUs.load(std::memory_order_relaxed);
+		if (waitUs >= 0)
+		{
+			gCondition.notify_one();
+			const uint64_t deadline = GetTimestampUs() + (uint64_t)waitUs;
+			while (full && GetTimestampUs() < deadline)
+			{
+				std::this_thread::yield();
+				full = head - inRing->tail.load(std::memory_order_acquire) > inRing->mask;
+			}
+		}
+		if (full)
+		{
+			inRing->dropped++;
+			inRing->droppedTotal.store(inRing->droppedTotal.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+	}
+
+	EGAVLogRecord* record = &inRing->slots[head & inRing->mask];
+	record->timestampUs = GetTimestampUs();
+	record->dropped     = inRing->dropped;
+	inRing->dropped     = 0;
+	return record;
+}
+
+void EGAVLog::CommitRecord(EGAVLogRing* inRing)
+{
+	inRing->head.store(inRing->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+
+//==============================================================================
+// # Formatting
+//==============================================================================
+
+static int64_t ArgAsSigned(const EGAVLogRecord& inRecord, int inIndex)
+{
+	if (inRecord.argTypes[inIndex] == EGAVLogRecord::Double)
+	{
+		double value;
+		memcpy(&value, &inRecord.args[inIndex], sizeof(value));
+		return (int64_t)value;
+	}
+	return (int64_t)inRecord.args[inIndex];
+}
+
+//! @brief Integer argument as printf would read it: the stored size, narrowed by an h or hh length modifier,
+//! sign-extended for d and i, zero-extended for u, x, X and o
+//! @param inModifierSize 1 (hh), 2 (h) or 0 (none, or a modifier that doesn't narrow)
+static uint64_t ArgAsInteger(const EGAVLogRecord& inRecord, int inIndex, size_t inModifierSize, bool inSigned)
+{
+	if (inRecord.argTypes[inIndex] == EGAVLogRecord::Double)
+		return (uint64_t)ArgAsSigned(inRecord, inIndex);
+
+	size_t size = inRecord.argSizes[inIndex];
+	if (inModifierSize > 0 && inModifierSize < size)
+		size = inModifierSize;
+	if (size == 0 || size >= sizeof(uint64_t))
+		return inRecord.args[inIndex];
+
+	const unsigned bits = (unsigned)size * 8;
+	const uint64_t mask = (1ull << bits) - 1;
+	uint64_t value = inRecord.args[inIndex] & mask;
+	if (inSigned && (value >> (bits - 1)) != 0)
+		value |= ~mask;
+	return value;
+}
+
+static double ArgAsDouble(const EGAVLogRecord& inRecord, int inIndex)
+{
+	const uint64_t bits = inRecord.args[inIndex];
+	switch (inRecord.argTypes[inIndex])
+	{
+		case EGAVLogRecord::Double:		{ double value; memcpy(&value, &bits, sizeof(value)); return value; }
+		case EGAVLogRecord::Signed:		return (double)(int64_t)bits;
+		default:						return (double)bits;
+	}
+}
+
+int EGAVLog::FormatRecord(const EGAVLogRecord& inRecord, char* outBuffer, size_t inBufferSize)
+{
+	if (!outBuffer || inBufferSize == 0)
+		return 0;
+
+	size_t pos = 0;
+	int arg = 0;
+	auto append = [&](const char* inText, size_t inLength)
+	{
+		const size_t n = std::min(inLength, inBufferSize - 1 - pos);
+		memcpy(outBuffer + pos, inText, n);
+		pos += n;
+	};
+	auto appendFormatted = [&](int inLength)
+	{
+		// snprintf wrote into outBuffer + pos (truncated to the remaining space)
+		if (inLength > 0)
+			pos = std::min(pos + (size_t)inLength, inBufferSize - 1);
+	};
+
+	const char* p = inRecord.format ? inRecord.format : "";
+	while (*p && pos < inBufferSize - 1)
+	{
+		const char* percent = strchr(p, '%');
+		if (!percent)
+		{
+			append(p, strlen(p));
+			break;
+		}
+		append(p, percent - p);
+		p = percent + 1;
+		if (*p == '%')
+		{
+			append("%", 1);
+			p++;
+			continue;
+		}
+
+		// Conversion: flags, width, precision; length modifiers are replaced by the stored type (h and hh narrow it)
+		char spec[32] = "%";
+		size_t specLength = 1;
+		auto specAppend = [&](const char* inText, size_t inLength)
+		{
+			const size_t available = (specLength + 8 < sizeof(spec)) ? sizeof(spec) - 8 - specLength : 0; // room for the conversion
+			inLength = std::min(inLength, available);
+			memcpy(spec + specLength, inText, inLength);
+			specLength += inLength;
+			spec[specLength] = 0;
+		};
+		auto specNumber = [&]()
+		{
+			if (*p == '*')
+			{
+				char number[16];
+				const int value = (arg < inRecord.argCount) ? (int)ArgAsSigned(inRecord, arg++) : 0;
+				specAppend(number, (size_t)snprintf(number, sizeof(number), "%d", value));
+				p++;
+				return;
+			}
+			const char* start = p;
+			while (*p >= '0' && *p <= '9')
+				p++;
+			specAppend(start, p - start);
+		};
+
+		const char* flags = p;
+		while (*p && strchr("-+ #0", *p))
+			p++;
+		specAppend(flags, p - flags);
+		specNumber();
+		if (*p == '.')
+		{
+			specAppend(".", 1);
+			p++;
+			specNumber();
+		}
+		const char* modifier = p;
+		while (*p && strchr("hlLqjzt", *p))
+			p++;
+		size_t modifierSize = 0;
+		if (p - modifier == 1 && *modifier == 'h')
+			modifierSize = 2;
+		else if (p - modifier == 2 && modifier[0] == 'h' && modifier[1] == 'h')
+			modifierSize = 1;
+
+		const char conversion = *p;
+		if (!conversion)
+			break;
+		p++;
+
+		if (arg >= inRecord.argCount)
+		{
+			append("(?)", 3);
+			continue;
+		}
+
+		const int index = arg++;
+		char* out = outBuffer + pos;
+		const size_t space = inBufferSize - pos;
+		switch (conversion)
+		{
+			case 'd': case 'i':
+				specAppend("lld", 3);
+				appendFormatted(snprintf(out, space, spec, (long long)ArgAsInteger(inRecord, index, modifierSize, true)));
+				break;
+			case 'u': case 'x': case 'X': case 'o':
+				specAppend("ll", 2);
+				specAppend(&conversion, 1);
+				appendFormatted(snprintf(out, space, spec, (unsigned long long)ArgAsInteger(inRecord, index, modifierSize, false)));
+				break;
+			case 'c':
+				specAppend("c", 1);
+				appendFormatted(snprintf(out, space, spec, (int)ArgAsSigned(inRecord, index)));
+				break;
+			case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+				specAppend(&conversion, 1);
+				appendFormatted(snprintf(out, space, spec, ArgAsDouble(inRecord, index)));
+				break;
+			case 's':
+				specAppend("s", 1);
+				if (inRecord.argTypes[index] == EGAVLogRecord::String && inRecord.args[index] < sizeof(inRecord.text))
+					appendFormatted(snprintf(out, space, spec, inRecord.text + inRecord.args[index]));
+				else
+					append("(?)", 3);
+				break;
+			case 'p':
+				specAppend("p", 1);
+				appendFormatted(snprintf(out, space, spec, (void*)(uintptr_t)inRecord.args[index]));
+				break;
+			default:
+				append("(?)", 3); // %n and unknown conversions
+				break;
+		}
+	}
+
+	outBuffer[pos] = 0;
+	return (int)pos;
+}
+
+
+//==============================================================================
+// # Consumer
+//==============================================================================
+
+struct FormattedRecord
+{
+	uint64_t		timestampUs;
+	EGAVLogLevel	level;
+	int				threadIndex;
+	std::string		message;
+};
+
+static void DefaultSink(EGAVLogLevel inLevel, uint64_t inTimestampUs, int inThreadIndex, const char* inMessage)
+{
+	static const char* kLevelNames[] = { "E", "W", "I" };
+	fprintf(stderr, "[%llu.%06llu] [%s] [%d] %s\n", (unsigned long long)(inTimestampUs / 1000000), (unsigned long long)(inTimestampUs % 1000000),
+		kLevelNames[(int)inLevel], inThreadIndex, inMessage);
+}
+
+//! @brief Formats all committed records and passes them to the sink, sorted by timestamp
+static void DrainRings()
+{
+	const std::lock_guard<std::mutex> lock(gDrainMutex);
+	EGAVLogRing* rings = gRings.load(std::memory_order_acquire);
+	if (!rings)
+		return;
+
+	std::vector<FormattedRecord> batch;
+	char buffer[1024];
+	for (int i = 0; i < gRingCount; i++)
+	{
+		EGAVLogRing& ring = rings[i];
+		const int state = ring.state.load(std::memory_order_acquire);
+		if (state == 0)
+			continue;
+
+		const uint64_t head = ring.head.load(std::memory_order_acquire);
+		uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+		for (; tail != head; tail++)
+		{
+			const EGAVLogRecord& record = ring.slots[tail & ring.mask];
+			if (record.dropped)
+			{
+				snprintf(buffer, sizeof(buffer), "(%u log messages dropped)", record.dropped);
+				batch.push_back({ record.timestampUs, EGAVLogLevel::Warning, i, buffer });
+			}
+			EGAVLog::FormatRecord(record, buffer, sizeof(buffer));
+			batch.push_back({ record.timestampUs, record.level, i, buffer });
+		}
+		ring.tail.store(tail, std::memory_order_release);
+
+		// Thread exited and everything it wrote is formatted: the ring can be reused
+		if (state == 2 && ring.head.load(std::memory_order_acquire) == tail)
+		{
+			int expected = 2;
+			ring.state.compare_exchange_strong(expected, 0, std::memory_order_acq_rel);
+		}
+	}
+
+	std::stable_sort(batch.begin(), batch.end(), [](const FormattedRecord& a, const FormattedRecord& b) { return a.timestampUs < b.timestampUs; });
+	for (const FormattedRecord& entry : batch)
+	{
+		if (gConfig.sink)
+			gConfig.sink(entry.level, entry.timestampUs, entry.threadIndex, entry.message.c_str());
+		else
+			DefaultSink(entry.level, entry.timestampUs, entry.threadIndex, entry.message.c_str());
+	}
+	gFormatted.fetch_add(batch.size(), std::memory_order_relaxed);
+}
+
+static void ConsumerThread()
+{
+	std::unique_lock<std::mutex> lock(gMutex);
+	while (true)
+	{
+		gCondition.wait_for(lock, std::chrono::milliseconds(std::max(gConfig.flushIntervalMs, 1)),
+			[] { return gStop || gFlushRequested != gFlushCompleted; });
+		const bool stop = gStop;
+		const uint64_t request = gFlushRequested;
+		lock.unlock();
+
+		DrainRings();
+
+		lock.lock();
+		gFlushCompleted = request;
+		gFlushDone.notify_all();
+		if (stop)
+			break;
+	}
+}
+
+
+//==============================================================================
+// # Class EGAVLog
+//==============================================================================
+
+void EGAVLog::Start(const EGAVLogConfig& inConfig /*= EGAVLogConfig()*/)
+{
+	Stop();
+
+	const std::lock_guard<std::mutex> lock(gMutex);
+	gConfig = inConfig;
+
+	// The rings are kept for the lifetime of the process: a thread may still hold one
+	if (!gRings.load(std::memory_order_acquire))
+	{
+		gRingCount = std::max(gConfig.maxThreads, 1);
+		uint64_t slots = 1;
+		while (slots < (uint64_t)std::max(gConfig.slotsPerThread, 2))
+			slots <<= 1;
+
+		gRecords.reset(new EGAVLogRecord[(size_t)(gRingCount * slots)]()); // zeroed: no page faults on the logging threads
+		gRingStorage.reset(new EGAVLogRing[gRingCount]);
+		for (int i = 0; i < gRingCount; i++)
+		{
+			gRingStorage[i].mask  = slots - 1;
+			gRingStorage[i].slots = gRecords.get() + i * slots;
+		}
+		gRings.store(gRingStorage.get(), std::memory_order_release);
+	}
+
+	gOverflowWaitUs.store((gConfig.overflow == EGAVLogOverflow::Wait) ? std::max(gConfig.waitUs, 0) : -1, std::memory_order_relaxed);
+	gStop = false;
+	gConsumer = std::thread(ConsumerThread);
+	sLevel.store((int)gConfig.level, std::memory_order_release);
+}
+
+void EGAVLog::Stop()
+{
+	sLevel.store(-1, std::memory_order_release);
+	{
+		const std::lock_guard<std::mutex> lock(gMutex);
+		gStop = true;
+	}
+	gCondition.notify_all();
+	if (gConsumer.joinable())
+		gConsumer.join();
+}
+
+void EGAVLog::Flush()
+{
+	std::unique_lock<std::mutex> lock(gMutex);
+	if (!gConsumer.joinable() || gStop)
+	{
+		lock.unlock();
+		DrainRings();
+		return;
+	}
+	const uint64_t request = ++gFlushRequested;
+	gCondition.notify_all();
+	gFlushDone.wait(lock, [request] { return gFlushCompleted >= request || gStop; });
+}
+
+EGAVLogStatistics EGAVLog::GetStatistics()
+{
+	EGAVLogStatistics statistics;
+	statistics.dropped   = gDroppedNoRing.load(std::memory_order_relaxed);
+	statistics.formatted = gFormatted.load(std::memory_order_relaxed);
+
+	EGAVLogRing* rings = gRings.load(std::memory_order_acquire);
+	for (int i = 0; rings && i < gRingCount; i++)
+	{
+		statistics.written += rings[i].head.load(std::memory_order_relaxed);
+		statistics.dropped += rings[i].droppedTotal.load(std::memory_order_relaxed);
+	}
+	return statistics;
+}
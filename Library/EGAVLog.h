@@ -0,0 +1,232 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVLog.h
+
+@brief		Binary logging backend for error_printf(), warning_printf() and info_printf().
+
+			Enabled with EGAV_USE_BINARY_LOG=1. A log call stores the format string
+			pointer, a timestamp and the raw arguments (strings are copied) in a ring
+			buffer of the calling thread and returns: no formatting, no allocation, no
+			lock. A background thread formats the records and passes them to the sink.
+
+			The rings are allocated by EGAVLog::Start(), one per logging thread up to
+			EGAVLogConfig::maxThreads. Loss is bounded and counted: if a ring is full the
+			record is dropped (optionally after a short wait) and the number of dropped
+			records is reported with the next record of that thread.
+
+			Format strings must be string literals (only the pointer is stored).
+			Supported arguments: integers, enums, bool, floating point, C strings and pointers.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+
+enum class EGAVLogLevel : uint8_t
+{
+	Error,
+	Warning,
+	Info,
+};
+
+//! @brief What a log call does if the ring of its thread is full
+enum class EGAVLogOverflow
+{
+	Drop,		//!< drop the record (never blocks the caller)
+	Wait,		//!< wait up to EGAVLogConfig::waitUs for the consumer, then drop
+};
+
+//! @brief Receives the formatted messages on the consumer thread, in timestamp order per flush
+typedef std::function<void(EGAVLogLevel inLevel, uint64_t inTimestampUs, int inThreadIndex, const char* inMessage)> EGAVLogSink;
+
+struct EGAVLogConfig
+{
+	EGAVLogLevel	level				= EGAVLogLevel::Info;	//!< records above this level are discarded by the caller
+	int				maxThreads			= 16;					//!< threads that can log at the same time (further threads: dropped)
+	int				slotsPerThread		= 512;					//!< records per ring, rounded up to a power of two
+	EGAVLogOverflow	overflow			= EGAVLogOverflow::Drop;
+	int				waitUs				= 100;
+	int				flushIntervalMs		= 50;
+	EGAVLogSink		sink;										//!< nullptr: stderr
+};
+
+struct EGAVLogStatistics
+{
+	uint64_t	written		= 0;	//!< records stored in a ring
+	uint64_t	dropped		= 0;	//!< records lost (ring full or no free ring)
+	uint64_t	formatted	= 0;	//!< records passed to the sink
+};
+
+
+//==============================================================================
+// # Records
+//==============================================================================
+
+//! @brief One log call in a ring slot (fixed size, no pointers into the caller's memory except the format)
+struct EGAVLogRecord
+{
+	static const int kMaxArgs	= 8;
+	static const int kSize		= 256;
+
+	enum ArgType : uint8_t { Signed, Unsigned, Double, String, Pointer };
+
+	const char*		format;
+	uint64_t		timestampUs;
+	uint32_t		dropped;				//!< records of this thread dropped before this one
+	EGAVLogLevel	level;
+	uint8_t			argCount;
+	uint8_t			textUsed;				//!< bytes used in text
+	ArgType			argTypes[kMaxArgs];
+	uint8_t			argSizes[kMaxArgs];		//!< integers: size after default promotion (4 or 8)
+	uint64_t		args[kMaxArgs];			//!< value, double bits or string offset in text
+	char			text[kSize - 40 - 8 * kMaxArgs];
+};
+static_assert(sizeof(EGAVLogRecord) == EGAVLogRecord::kSize, "EGAVLogRecord layout");
+
+
+//! @brief Single producer, single consumer ring of records
+struct EGAVLogRing
+{
+	alignas(64) std::atomic<uint64_t>	head{0};	//!< written by the producer
+	alignas(64) std::atomic<uint64_t>	tail{0};	//!< written by the consumer
+	alignas(64) std::atomic<int>		state{0};	//!< 0: free, 1: owned by a thread, 2: thread exited (consumer drains and frees)
+	uint32_t							dropped = 0;	//!< producer only: dropped since the last stored record
+	std::atomic<uint64_t>				droppedTotal{0};	//!< written by the producer only
+	uint64_t							mask	= 0;
+	EGAVLogRecord*						slots	= nullptr;
+};
+
+
+//==============================================================================
+// # Class EGAVLog
+//==============================================================================
+
+class EGAVLog
+{
+public:
+	//! @brief Allocates the rings (first call only, later calls keep the ring layout) and starts the consumer thread
+	static void Start(const EGAVLogConfig& inConfig = EGAVLogConfig());
+	//! @brief Formats the remaining records and stops the consumer thread. Later log calls are discarded.
+	static void Stop();
+	//! @brief Formats all records written so far (blocks until the consumer is done)
+	static void Flush();
+
+	static EGAVLogStatistics GetStatistics();
+
+	static bool IsEnabled(EGAVLogLevel inLevel) { return (int)inLevel <= sLevel.load(std::memory_order_relaxed); }
+
+	//! @brief Formats one record the way printf would (used by the consumer; exposed for tests)
+	static int FormatRecord(const EGAVLogRecord& inRecord, char* outBuffer, size_t inBufferSize);
+
+	template <typename... Args>
+	static void Write(EGAVLogLevel inLevel, const char* inFormat, Args... inArgs)
+	{
+		static_assert(sizeof...(Args) <= EGAVLogRecord::kMaxArgs, "too many arguments for a binary log record");
+		if (!IsEnabled(inLevel))
+			return;
+
+		EGAVLogRing* ring = GetThreadRing();
+		EGAVLogRecord* record = ring ? BeginRecord(ring) : nullptr;
+		if (!record)
+			return;
+
+		FillRecord(*record, inLevel, inFormat, inArgs...);
+		CommitRecord(ring);
+	}
+
+	//! @brief Stores a log call in a record (used by Write(); exposed for tests)
+	template <typename... Args>
+	static void FillRecord(EGAVLogRecord& outRecord, EGAVLogLevel inLevel, const char* inFormat, Args... inArgs)
+	{
+		static_assert(sizeof...(Args) <= EGAVLogRecord::kMaxArgs, "too many arguments for a binary log record");
+		outRecord.format   = inFormat;
+		outRecord.level    = inLevel;
+		outRecord.argCount = 0;
+		outRecord.textUsed = 0;
+		int dummy[] = { 0, (StoreArg(outRecord, inArgs), 0)... };
+		(void)dummy;
+	}
+
+private:
+	static std::atomic<int> sLevel;	//!< -1: not started
+
+	static EGAVLogRing* GetThreadRing();
+	static EGAVLogRecord* BeginRecord(EGAVLogRing* inRing);
+	static void CommitRecord(EGAVLogRing* inRing);
+
+	static void Store(EGAVLogRecord& ioRecord, EGAVLogRecord::ArgType inType, uint64_t inValue, size_t inSize = sizeof(uint64_t))
+	{
+		ioRecord.argTypes[ioRecord.argCount] = inType;
+		ioRecord.argSizes[ioRecord.argCount] = (uint8_t)inSize;
+		ioRecord.args[ioRecord.argCount++]   = inValue;
+	}
+
+	//! @brief Size of an integer argument after default promotion, as printf sees it
+	template <typename T>
+	static constexpr size_t PromotedSize() { return sizeof(T) < sizeof(int) ? sizeof(int) : sizeof(T); }
+
+	static void StoreString(EGAVLogRecord& ioRecord, const char* inString)
+	{
+		if (!inString)
+			inString = "(null)";
+		const size_t offset = (ioRecord.textUsed < sizeof(ioRecord.text)) ? ioRecord.textUsed : sizeof(ioRecord.text) - 1;
+		const size_t length = strnlen(inString, sizeof(ioRecord.text) - 1 - offset); // truncated if the text area is full
+		memcpy(ioRecord.text + offset, inString, length);
+		ioRecord.text[offset + length] = 0;
+		ioRecord.textUsed = (uint8_t)(offset + length + 1);
+		Store(ioRecord, EGAVLogRecord::String, offset);
+	}
+
+	template <typename T>
+	static void StoreArg(EGAVLogRecord& ioRecord, T inValue)
+	{
+		if constexpr (std::is_same<T, const char*>::value || std::is_same<T, char*>::value)
+			StoreString(ioRecord, inValue);
+		else if constexpr (std::is_pointer<T>::value)
+			Store(ioRecord, EGAVLogRecord::Pointer, (uint64_t)(uintptr_t)inValue);
+		else if constexpr (std::is_floating_point<T>::value)
+		{
+			const double value = (double)inValue;
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			Store(ioRecord, EGAVLogRecord::Double, bits);
+		}
+		else if constexpr (std::is_enum<T>::value)
+			Store(ioRecord, EGAVLogRecord::Signed, (uint64_t)(int64_t)inValue, PromotedSize<T>());
+		else
+		{
+			static_assert(std::is_integral<T>::value, "unsupported binary log argument type");
+			Store(ioRecord, std::is_signed<T>::value ? EGAVLogRecord::Signed : EGAVLogRecord::Unsigned, (uint64_t)inValue, PromotedSize<T>());
+		}
+	}
+};
@@ -0,0 +1,234 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVProcessLock.cpp
+
+@brief		Cross-process lock for the I2C transactions of one device
+**/
+//==============================================================================
+
+#include "EGAVProcessLock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#if !_UP_WINDOWS
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+static uint64_t GetTimestampNs()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//==============================================================================
+// # Class EGAVProcessLock
+//==============================================================================
+
+EGAVProcessLock::~EGAVProcessLock()
+{
+	Close();
+}
+
+std::string EGAVProcessLock::GetLockName(const EGAVDeviceID& inDeviceID, const std::string& inDirectory /*= std::string()*/)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "egav-%d-%04x-%04x-%08x.lock", (int)inDeviceID.busType, inDeviceID.vendorID, inDeviceID.productID, inDeviceID.locationID);
+#if _UP_WINDOWS
+	(void)inDirectory;
+	return std::string("Local\\") + name;
+#else
+	return (inDirectory.empty() ? std::string(EGAV_PROCESS_LOCK_DIRECTORY) : inDirectory) + "/" + name;
+#endif
+}
+
+#if _UP_WINDOWS
+
+EGAVResult EGAVProcessLock::Open(const std::string& inName)
+{
+	Close();
+	mMutex = CreateMutexA(nullptr, FALSE, inName.c_str());
+	if (!mMutex)
+	{
+		EGAVResult res;
+		res.InitWithWinError(GetLastError());
+		return res;
+	}
+	return EGAVResult::Ok;
+}
+
+void EGAVProcessLock::Close()
+{
+	if (mLocked)
+		Unlock();
+	if (mMutex)
+		CloseHandle(mMutex);
+	mMutex = nullptr;
+}
+
+bool EGAVProcessLock::IsOpen() const
+{
+	return mMutex != nullptr;
+}
+
+EGAVResult EGAVProcessLock::Lock()
+{
+	if (!mMutex)
+		return EGAVResult::ErrNotInitialized;
+
+	const uint64_t start = GetTimestampNs();
+	DWORD wait = WaitForSingleObject(mMutex, 0);
+	if (wait == WAIT_TIMEOUT)
+	{
+		mStatistics.contended++;
+		wait = WaitForSingleObject(mMutex, INFINITE);
+	}
+	// WAIT_ABANDONED: the owner died, the mutex is ours now
+	if (wait != WAIT_OBJECT_0 && wait != WAIT_ABANDONED)
+		return EGAVResult::ErrUnknown;
+
+	mLocked     = true;
+	mLockedAtNs = GetTimestampNs();
+	const uint64_t waitNs = mLockedAtNs - start;
+	mStatistics.acquisitions++;
+	mStatistics.waitNsTotal += waitNs;
+	mStatistics.waitNsMax = std::max(mStatistics.waitNsMax, waitNs);
+	return EGAVResult::Ok;
+}
+
+void EGAVProcessLock::Unlock()
+{
+	if (!mLocked)
+		return;
+	const uint64_t holdNs = GetTimestampNs() - mLockedAtNs;
+	mStatistics.holdNsTotal += holdNs;
+	mStatistics.holdNsMax = std::max(mStatistics.holdNsMax, holdNs);
+	mLocked = false;
+	ReleaseMutex(mMutex);
+}
+
+#else
+
+EGAVResult EGAVProcessLock::Open(const std::string& inName)
+{
+	Close();
+
+	// Open the existing file, or create it exclusively; never through a symlink planted in the directory.
+	// flock() only needs a descriptor, so read access to the file is enough.
+	const int flags = O_RDONLY | O_CLOEXEC | O_NOFOLLOW;
+	int fd;
+	bool created = false;
+	do
+	{
+		fd = open(inName.c_str(), flags);
+		if (fd < 0 && errno == ENOENT)
+		{
+			fd = open(inName.c_str(), flags | O_CREAT | O_EXCL, 0660);
+			created = fd >= 0;
+		}
+	} while (fd < 0 && errno == EEXIST); // another process created it in between
+
+	// The umask (typically 022) must not take the group's access away: other users of the group share the file
+	if (created && fchmod(fd, 0660) != 0)
+		warning_printf("EGAVProcessLock: can't set the mode of %s (%d)", inName.c_str(), errno);
+
+	struct stat info;
+	if (fd >= 0 && (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)))
+	{
+		close(fd);
+		fd = -1;
+		errno = EINVAL;
+	}
+	if (fd < 0)
+	{
+		error_printf("EGAVProcessLock: can't open %s (%d)", inName.c_str(), errno);
+		return EGAVResult::ErrCouldNotOpenFile;
+	}
+	mFD = fd;
+	return EGAVResult::Ok;
+}
+
+void EGAVProcessLock::Close()
+{
+	if (mLocked)
+		Unlock();
+	if (mFD >= 0)
+		close(mFD);
+	mFD = -1;
+}
+
+bool EGAVProcessLock::IsOpen() const
+{
+	return mFD >= 0;
+}
+
+EGAVResult EGAVProcessLock::Lock()
+{
+	if (mFD < 0)
+		return EGAVResult::ErrNotInitialized;
+
+	const uint64_t start = GetTimestampNs();
+	if (flock(mFD, LOCK_EX | LOCK_NB) != 0)
+	{
+		if (errno != EWOULDBLOCK)
+			return EGAVResult::ErrUnknown;
+
+		mStatistics.contended++;
+		int res;
+		while ((res = flock(mFD, LOCK_EX)) != 0 && errno == EINTR)
+			;
+		if (res != 0)
+			return EGAVResult::ErrUnknown;
+	}
+
+	mLocked     = true;
+	mLockedAtNs = GetTimestampNs();
+	const uint64_t waitNs = mLockedAtNs - start;
+	mStatistics.acquisitions++;
+	mStatistics.waitNsTotal += waitNs;
+	mStatistics.waitNsMax = std::max(mStatistics.waitNsMax, waitNs);
+	return EGAVResult::Ok;
+}
+
+void EGAVProcessLock::Unlock()
+{
+	if (!mLocked)
+		return;
+	const uint64_t holdNs = GetTimestampNs() - mLockedAtNs;
+	mStatistics.holdNsTotal += holdNs;
+	mStatistics.holdNsMax = std::max(mStatistics.holdNsMax, holdNs);
+	mLocked = false;
+	flock(mFD, LOCK_UN);
+}
+
+#endif
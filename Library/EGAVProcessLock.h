@@ -0,0 +1,141 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVProcessLock.h
+
+@brief		Cross-process lock for the I2C transactions of one device.
+
+			ElgatoUVCDevice::mHIDMutex serializes the write-then-read sequences
+			within one process only. Processes that use the same device agree on a lock
+			derived from the device identity: an advisory file lock (flock) on POSIX,
+			a named mutex on Windows. Both are released by the OS if the owner dies.
+			See ElgatoUVCDevice::EnableProcessLock().
+
+			POSIX: the lock files live in a directory owned by the system integration,
+			by default EGAV_PROCESS_LOCK_DIRECTORY (e.g. a systemd-tmpfiles entry
+			"d /run/egav 2770 root video"). Its group and mode decide which users
+			share the lock; the library doesn't create the directory. New lock files
+			get mode 0660 regardless of the umask and are opened read-only (enough
+			for flock), without following symlinks.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "EGAVResult.h"
+#include "EGAVDevice.h"
+
+
+#ifndef EGAV_PROCESS_LOCK_DIRECTORY
+	#define EGAV_PROCESS_LOCK_DIRECTORY	"/run/egav"
+#endif
+
+
+struct EGAVProcessLockStatistics
+{
+	uint64_t	acquisitions	= 0;
+	uint64_t	contended		= 0;	//!< acquisitions that had to wait for another process
+	uint64_t	waitNsTotal		= 0;
+	uint64_t	waitNsMax		= 0;
+	uint64_t	holdNsTotal		= 0;
+	uint64_t	holdNsMax		= 0;
+};
+
+
+//==============================================================================
+// # Class EGAVProcessLock
+//==============================================================================
+
+//! @brief Not thread safe: Lock() and Unlock() must be serialized by the owner (ElgatoUVCDevice holds mHIDMutex)
+class EGAVProcessLock
+{
+public:
+	EGAVProcessLock() = default;
+	~EGAVProcessLock();
+	EGAVProcessLock(const EGAVProcessLock&) = delete;
+	EGAVProcessLock& operator=(const EGAVProcessLock&) = delete;
+
+	//! @return lock name of the device: a file in inDirectory (default: EGAV_PROCESS_LOCK_DIRECTORY) on POSIX,
+	//! a mutex name on Windows
+	static std::string GetLockName(const EGAVDeviceID& inDeviceID, const std::string& inDirectory = std::string());
+
+	//! @param inName see GetLockName(). POSIX: the file is created with mode 0660 (not reduced by the umask) if it doesn't exist.
+	//! @return ErrCouldNotOpenFile if the directory is missing or not accessible, or the name is a symlink
+	//! or not a regular file
+	EGAVResult Open(const std::string& inName);
+	void Close();
+	bool IsOpen() const;
+
+	//! @brief Blocks until no other process holds the lock
+	EGAVResult Lock();
+	void Unlock();
+
+	const EGAVProcessLockStatistics& GetStatistics() const { return mStatistics; }
+	void ResetStatistics() { mStatistics = EGAVProcessLockStatistics(); }
+
+private:
+#if _UP_WINDOWS
+	HANDLE						mMutex		= nullptr;
+#else
+	int							mFD			= -1;
+#endif
+	bool						mLocked		= false;
+	uint64_t					mLockedAtNs	= 0;
+	EGAVProcessLockStatistics	mStatistics;
+};
+
+
+//! @brief Holds the lock for one transaction; no-op for nullptr or a lock that isn't open
+class EGAVProcessLockGuard
+{
+public:
+	explicit EGAVProcessLockGuard(EGAVProcessLock* inLock)
+		: mLock((inLock && inLock->IsOpen()) ? inLock : nullptr)
+	{
+		if (mLock)
+		{
+			mResult = mLock->Lock();
+			if (mResult.Failed())
+				mLock = nullptr;
+		}
+	}
+	~EGAVProcessLockGuard()
+	{
+		if (mLock)
+			mLock->Unlock();
+	}
+	EGAVProcessLockGuard(const EGAVProcessLockGuard&) = delete;
+	EGAVProcessLockGuard& operator=(const EGAVProcessLockGuard&) = delete;
+
+	EGAVResult GetResult() const { return mResult; }
+
+private:
+	EGAVProcessLock*	mLock;
+	EGAVResult			mResult = EGAVResult::Ok;
+};
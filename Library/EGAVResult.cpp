@@ -36,21 +36,9 @@ SOFTWARE.
 #endif
 
 //------------------------------------------------------------------------------
-// Constructor / Destructor
+// Initialization
 //------------------------------------------------------------------------------
 
-EGAVResult::EGAVResult(EGAVResultCode inResultCode)
-{
-	mResultCode = inResultCode;
-}
-
-EGAVResult::EGAVResult(EGAVResultCustomType inCustomResultType, int64_t inCustomResultCode)
-{
-	mResultCode       = ErrCustom;
-	mCustomResultType = inCustomResultType;
-	mCustomResultCode = inCustomResultCode;
-}
-
 #if _UP_WINDOWS
 void EGAVResult::InitWithHresult(HRESULT hr)
 {
@@ -71,61 +59,75 @@ void EGAVResult::InitWithWinError(LONG err)
 // Helpers
 //------------------------------------------------------------------------------
 
-bool EGAVResult::Succeeded() const 
+bool EGAVResult::CustomSucceeded() const
 {
-	if (mResultCode == ErrCustom)
+	switch (mCustomResultType)
 	{
-		switch (mCustomResultType)
-		{
 #if _UP_WINDOWS
-		case EGAVResultCustomType::Hresult:		return SUCCEEDED(mCustomResultCode);
-		case EGAVResultCustomType::WinError:	return (mCustomResultCode == ERROR_SUCCESS) ? true : false;
+	case EGAVResultCustomType::Hresult:		return SUCCEEDED(mCustomResultCode);
+	case EGAVResultCustomType::WinError:	return (mCustomResultCode == ERROR_SUCCESS) ? true : false;
 #elif _UP_MAC
-		case EGAVResultCustomType::Mac:			return (mCustomResultCode == 0) ? true : false;
+	case EGAVResultCustomType::Mac:			return (mCustomResultCode == 0) ? true : false;
 #endif
-		case EGAVResultCustomType::MainConcept:
-		case EGAVResultCustomType::Device:
-			return (mCustomResultCode == 0) ? true : false;
-		default:
-			return false;
-		}
-	}
-	else
-	{
-		return (int32_t)mResultCode > 0 ? true : false;
+	case EGAVResultCustomType::MainConcept:
+	case EGAVResultCustomType::Device:
+		return (mCustomResultCode == 0) ? true : false;
+	default:
+		return false;
 	}
 }
 
 
 //------------------------------------------------------------------------------
-// Operators
+// Result code strings
 //------------------------------------------------------------------------------
-void EGAVResult::operator=(const EGAVResultCode inResultCode)
-{
-	mCustomResultType = EGAVResultCustomType::None;
-	mResultCode = inResultCode;
-}
 
-bool EGAVResult::operator==(const EGAVResult inResult) const
+struct ResultCodeString
 {
-	if (mResultCode 	  != inResult.mResultCode	   ) return false;
-	if (mCustomResultType != inResult.mCustomResultType) return false;
-	if (mCustomResultCode != inResult.mCustomResultCode) return false;
-	return true;
-}
-
-bool EGAVResult::operator!=(const EGAVResult inResult) const
-{
-	return !(*this == inResult);
-}
+	EGAVResultCode	code;
+	const char*		string;
+};
 
-
-bool EGAVResult::operator==(const EGAVResultCode inResultCode) const
+// EXTEND_EGAVResultCode
+static const ResultCodeString kResultCodeStrings[] =
 {
-	return mResultCode == inResultCode;
-}
-
-bool EGAVResult::operator!=(const EGAVResultCode inResultCode) const
+	{ EGAVResult::ErrInvalidOperation,		"Invalid operation" },
+	{ EGAVResult::ErrUnknownUnit,			"Unknown unit" },
+	{ EGAVResult::ErrDeviceInUse,			"Device is in use by another application" },
+	{ EGAVResult::ErrInvalidPath,			"Invalid path" },
+	{ EGAVResult::ErrCouldNotOpenFile,		"Could not open file" },
+	{ EGAVResult::ErrResultPending,			"Result pending" },
+	{ EGAVResult::ErrResourceNotAvail,		"Resource not available" },
+	{ EGAVResult::ErrOutOfRange,			"Out of range" },
+	{ EGAVResult::ErrTimeOut,				"Timeout" },
+	{ EGAVResult::ErrNotSupported,			"Not supported" },
+	{ EGAVResult::ErrConversionFailed,		"Conversion failed" },
+	{ EGAVResult::ErrNotFound,				"Not found" },
+	{ EGAVResult::ErrNoData,				"No data" },
+	{ EGAVResult::ErrVideoScaler,			"Video scaler error" },
+	{ EGAVResult::ErrEncoder,				"Encoder error" },
+	{ EGAVResult::ErrInvalidFormat,			"Invalid format" },
+	{ EGAVResult::ErrInvalidParameter,		"Invalid parameter" },
+	{ EGAVResult::ErrInvalidState,			"Invalid state" },
+	{ EGAVResult::ErrInsufficientMemory,	"Insufficient memory" },
+	{ EGAVResult::ErrNotInitialized,		"Not initialized" },
+	{ EGAVResult::ErrInvalidCast,			"Invalid cast" },
+	{ EGAVResult::ErrNotImplemented,		"Not implemented" },
+	{ EGAVResult::ErrNullPointer,			"Null pointer" },
+	{ EGAVResult::ErrUnknown,				"Unknown error" },
+	{ EGAVResult::ErrCustom,				"Custom error" },
+	{ EGAVResult::Ok,						"Ok" },
+	{ EGAVResult::OkNoDataChanged,			"Ok (no data changed)" },
+	{ EGAVResult::OkFileNotFound,			"Ok (file not found)" },
+	{ EGAVResult::OkButIncomplete,			"Ok (incomplete)" },
+};
+
+const char* EGAVResult::GetResultCodeString(EGAVResultCode inResultCode)
 {
-	return mResultCode != inResultCode;
+	for (const ResultCodeString& entry : kResultCodeStrings)
+	{
+		if (entry.code == inResultCode)
+			return entry.string;
+	}
+	return (inResultCode > 0) ? "Ok (unknown code)" : "Unknown error code";
 }
@@ -37,7 +37,9 @@ SOFTWARE.
 // Includes
 //------------------------------------------------------------------------------
 
-#include <string>
+#include <cstdint>
+#include <string>			// not used here any more, kept for files relying on it
+#include <type_traits>
 #if _UP_WINDOWS 
 	// FMB NOTE: For some strange reason <WinSock2.h> must be before <Windows.h>. 
 	// This is only necessary because contents of <WinSock2.h> are required in other code files.
@@ -133,10 +135,11 @@ public:
 	//------------------------------------------------------------------------------
 
 	//! Constructor
-	EGAVResult() {}
-	EGAVResult(EGAVResultCode inResultCode);
+	constexpr EGAVResult() = default;
+	constexpr EGAVResult(EGAVResultCode inResultCode) : mResultCode(inResultCode) {}
 
-	EGAVResult(EGAVResultCustomType inCustomResultType, int64_t inCustomResultCode);
+	constexpr EGAVResult(EGAVResultCustomType inCustomResultType, int64_t inCustomResultCode)
+		: mResultCode(ErrCustom), mCustomResultType(inCustomResultType), mCustomResultCode(inCustomResultCode) {}
 
 	//------------------------------------------------------------------------------
 	// Initialization
@@ -154,19 +157,23 @@ public:
 	// Helpers
 	//------------------------------------------------------------------------------
 
-	bool Succeeded() const;
+	//! Plain result codes are decided inline, only custom codes need the platform specific check
+	bool Succeeded() const { return (mResultCode != ErrCustom) ? mResultCode > 0 : CustomSucceeded(); }
 	bool Failed() const { return !Succeeded(); }
 
 	EGAVResultCode GetResultCode() const { return mResultCode; }
 	EGAVResultCustomType GetCustomResultType() const { return mCustomResultType; }
 	int64_t GetCustomResultCode() const { return mCustomResultCode; }
 
+	//! @return static description of the result code (never nullptr)
+	static const char* GetResultCodeString(EGAVResultCode inResultCode);
+	const char* GetResultCodeString() const { return GetResultCodeString(mResultCode); }
 
-	void operator=(const EGAVResultCode inResultCode);
-	bool operator==(const EGAVResult inResult) const;
-	bool operator!=(const EGAVResult inResult) const;
-	bool operator==(const EGAVResultCode inResultCode) const;
-	bool operator!=(const EGAVResultCode inResultCode) const;
+	void operator=(const EGAVResultCode inResultCode) { mResultCode = inResultCode; mCustomResultType = EGAVResultCustomType::None; mCustomResultCode = 0; }
+	bool operator==(const EGAVResult& inResult) const { return mResultCode == inResult.mResultCode && mCustomResultType == inResult.mCustomResultType && mCustomResultCode == inResult.mCustomResultCode; }
+	bool operator!=(const EGAVResult& inResult) const { return !(*this == inResult); }
+	bool operator==(const EGAVResultCode inResultCode) const { return mResultCode == inResultCode; }
+	bool operator!=(const EGAVResultCode inResultCode) const { return mResultCode != inResultCode; }
 
 	//------------------------------------------------------------------------------
 	// Members
@@ -180,9 +187,15 @@ public:
 	int64_t					mCustomResultCode	= 0;
 
 private:
-	std::string				mMessage;
+	bool CustomSucceeded() const;
 };
 
+// Results are returned by value from every HID and I2C call: keep them small enough for two registers
+// (System V x64 and ARM64 ABIs) and free of anything that needs a destructor
+static_assert(sizeof(EGAVResult) == 16, "EGAVResult must stay 16 bytes");
+static_assert(std::is_trivially_copyable<EGAVResult>::value, "EGAVResult must stay trivially copyable");
+static_assert(std::is_trivially_destructible<EGAVResult>::value, "EGAVResult must stay trivially destructible");
+
 
 
 //==============================================================================
@@ -207,7 +220,15 @@ private:
 	inline void dummy() {}
 
 	#define EPL_ASSERT_BREAK(...) dummy()
+#if EGAV_USE_BINARY_LOG
+	// Deferred formatting on a background thread, see EGAVLog.h (call EGAVLog::Start() to enable output)
+	#include "EGAVLog.h"
+	#define error_printf(...)     EGAVLog::Write(EGAVLogLevel::Error, __VA_ARGS__)
+	#define warning_printf(...)   EGAVLog::Write(EGAVLogLevel::Warning, __VA_ARGS__)
+	#define info_printf(...)      EGAVLog::Write(EGAVLogLevel::Info, __VA_ARGS__)
+#else
 	#define error_printf(...)     dummy()
 	#define warning_printf(...)   dummy()
 	#define info_printf(...)      dummy()
 #endif
+#endif
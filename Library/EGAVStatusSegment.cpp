@@ -0,0 +1,544 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVStatusSegment.cpp
+
+@brief		Device status in POSIX shared memory: one publisher, any number of readers
+**/
+//==============================================================================
+
+#include "EGAVStatusSegment.h"
+#include "ElgatoUVCDevice.h"
+
+#include <cstddef>
+#include <cstring>
+
+#if !_UP_WINDOWS
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#endif
+
+
+//==============================================================================
+// # Device poll
+//==============================================================================
+
+EGAVResult EGAVStatus_PollDevice(ElgatoUVCDevice& inDevice, EGAVStatusSnapshot& outSnapshot)
+{
+	outSnapshot.deviceResult	= EGAVResult::Ok;
+	outSnapshot.isHDR			= 0;
+	outSnapshot.eotf			= HDMI_ERROR;
+	outSnapshot.contentType		= EGAV_STATUS_UNSUPPORTED;
+	outSnapshot.pixelRepetition	= EGAV_STATUS_UNSUPPORTED;
+	outSnapshot.frameMask		= 0;
+	outSnapshot.supportedMask	= 0;
+	for (HDMI_GENERIC_INFOFRAME& frame : outSnapshot.frames)
+		frame = HDMI_GENERIC_INFOFRAME{};
+
+	for (uint8_t type = HDMI_INFOFRAME_TYPE_MIN; type <= HDMI_INFOFRAME_TYPE_MAX; type++)
+	{
+		HDMI_GENERIC_INFOFRAME frame{};
+		EGAVResult res = inDevice.GetHDMIInfoFrame(type, frame);
+		if (res != EGAVResult::ErrNotSupported)
+			outSnapshot.supportedMask |= 1u << (type - 1);
+		if (res.Succeeded())
+		{
+			outSnapshot.frames[type - 1] = frame;
+			outSnapshot.frameMask |= 1u << (type - 1);
+		}
+		else if (res != EGAVResult::ErrNotSupported && res != EGAVResult::ErrNoData)
+		{
+			outSnapshot.deviceResult = res.GetResultCode(); // I2C error
+			return res;
+		}
+	}
+
+	if (const HDMI_GENERIC_INFOFRAME* dr = outSnapshot.GetFrame(HDMI_INFOFRAME_TYPE_DR))
+	{
+		if (HDMI_IsInfoFrameValid(dr))
+			outSnapshot.eotf = (int8_t)dr->plDR1.bfEOTF;
+	}
+	else
+		outSnapshot.eotf = HDMI_DR_EOTF_SDRGAMMA; // no DR info frame
+	outSnapshot.isHDR = (outSnapshot.eotf != HDMI_ERROR && outSnapshot.eotf != HDMI_DR_EOTF_SDRGAMMA) ? 1 : 0;
+
+	if (const HDMI_GENERIC_INFOFRAME* avi = outSnapshot.GetFrame(HDMI_INFOFRAME_TYPE_AVI))
+	{
+		outSnapshot.contentType		= (int8_t)HDMI_AVI_GetITContentType(*avi);
+		outSnapshot.pixelRepetition	= (int8_t)HDMI_AVI_GetPixelRepetitionFactor(*avi);
+	}
+	else if (outSnapshot.IsFrameSupported(HDMI_INFOFRAME_TYPE_AVI))
+	{
+		outSnapshot.contentType		= HDMI_ERROR; // no AVI info frame received
+		outSnapshot.pixelRepetition	= HDMI_ERROR;
+	}
+	return EGAVResult::Ok;
+}
+
+
+#if _UP_WINDOWS
+
+// Not implemented on Windows (named file mapping + event would be the equivalent)
+EGAVStatusPublisher::~EGAVStatusPublisher() {}
+EGAVResult EGAVStatusPublisher::Create(const std::string&) { return EGAVResult::ErrNotSupported; }
+void EGAVStatusPublisher::Close() {}
+EGAVResult EGAVStatusPublisher::EnableChangeNotification(const std::string&) { return EGAVResult::ErrNotSupported; }
+EGAVResult EGAVStatusPublisher::Publish(const EGAVStatusSnapshot&, uint64_t) { return EGAVResult::ErrNotInitialized; }
+void EGAVStatusPublisher::ServiceSubscribers() {}
+void EGAVStatusPublisher::NotifySubscribers() {}
+
+EGAVStatusReader::~EGAVStatusReader() {}
+EGAVResult EGAVStatusReader::Open(const std::string&) { return EGAVResult::ErrNotSupported; }
+void EGAVStatusReader::Close() {}
+EGAVResult EGAVStatusReader::Read(EGAVStatusSnapshot&, uint64_t*) const { return EGAVResult::ErrNotInitialized; }
+uint64_t EGAVStatusReader::GetSequence() const { return 0; }
+uint64_t EGAVStatusReader::GetHeartbeatUs() const { return 0; }
+EGAVResult EGAVStatusReader::SubscribeChanges(const std::string&, int&) { return EGAVResult::ErrNotSupported; }
+EGAVResult EGAVStatusReader::WaitForChange(int) { return EGAVResult::ErrInvalidState; }
+
+#else
+
+//! @brief Bytes of the snapshot that are compared for changes (without sequence, timestamp and padding)
+static const size_t kCompareOffset	= offsetof(EGAVStatusSnapshot, deviceResult);
+static const size_t kCompareEnd		= offsetof(EGAVStatusSnapshot, frames) + sizeof(EGAVStatusSnapshot::frames);
+
+static void CloseFD(int& ioFD)
+{
+	if (ioFD >= 0)
+		close(ioFD);
+	ioFD = -1;
+}
+
+static bool SetNonBlocking(int inFD)
+{
+	const int flags = fcntl(inFD, F_GETFL, 0);
+	return flags >= 0 && fcntl(inFD, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool MakeSocketAddress(const std::string& inPath, sockaddr_un& outAddress)
+{
+	memset(&outAddress, 0, sizeof(outAddress));
+	outAddress.sun_family = AF_UNIX;
+	if (inPath.empty() || inPath.size() >= sizeof(outAddress.sun_path))
+		return false;
+	memcpy(outAddress.sun_path, inPath.c_str(), inPath.size());
+	return true;
+}
+
+
+//==============================================================================
+// # Class EGAVStatusPublisher
+//==============================================================================
+
+EGAVStatusPublisher::~EGAVStatusPublisher()
+{
+	Close();
+}
+
+EGAVResult EGAVStatusPublisher::Create(const std::string& inName)
+{
+	Close();
+
+	mFD = shm_open(inName.c_str(), O_CREAT | O_RDWR, 0644);
+	if (mFD < 0)
+	{
+		error_printf("EGAVStatusPublisher: shm_open(%s) failed with %d", inName.c_str(), errno);
+		return EGAVResult::ErrInvalidPath;
+	}
+
+	// One publisher per segment; the lock is released automatically if the publisher dies
+	if (flock(mFD, LOCK_EX | LOCK_NB) != 0 && errno == EWOULDBLOCK)
+	{
+		CloseFD(mFD);
+		return EGAVResult::ErrDeviceInUse;
+	}
+
+	void* memory = MAP_FAILED;
+	if (ftruncate(mFD, sizeof(EGAVStatusSegment)) == 0)
+		memory = mmap(nullptr, sizeof(EGAVStatusSegment), PROT_READ | PROT_WRITE, MAP_SHARED, mFD, 0);
+	if (memory == MAP_FAILED)
+	{
+		error_printf("EGAVStatusPublisher: mapping %s failed with %d", inName.c_str(), errno);
+		CloseFD(mFD);
+		return EGAVResult::ErrInsufficientMemory;
+	}
+
+	// Readers of a previous publisher see the magic disappear while the segment is rebuilt
+	mSegment = (EGAVStatusSegment*)memory;
+	mSegment->magic.store(0, std::memory_order_release);
+	memset((uint8_t*)mSegment + sizeof(mSegment->magic), 0, sizeof(EGAVStatusSegment) - sizeof(mSegment->magic));
+	mSegment->version		= EGAV_STATUS_SEGMENT_VERSION;
+	mSegment->size			= sizeof(EGAVStatusSegment);
+	mSegment->publisherPid	= (int32_t)getpid();
+	mSegment->magic.store(EGAV_STATUS_SEGMENT_MAGIC, std::memory_order_release);
+
+	mName    = inName;
+	mHasLast = false;
+	return EGAVResult::Ok;
+}
+
+void EGAVStatusPublisher::Close()
+{
+	for (Subscriber& subscriber : mSubscribers)
+	{
+		CloseFD(subscriber.connection);
+		CloseFD(subscriber.notifyFD);
+	}
+	mSubscribers.clear();
+	if (mListenSocket >= 0)
+	{
+		CloseFD(mListenSocket);
+		unlink(mSocketPath.c_str());
+	}
+
+	if (mSegment)
+	{
+		mSegment->magic.store(0, std::memory_order_release);
+		munmap(mSegment, sizeof(EGAVStatusSegment));
+		mSegment = nullptr;
+		shm_unlink(mName.c_str()); // readers keep their mapping, new readers don't find stale data
+	}
+	CloseFD(mFD);
+}
+
+EGAVResult EGAVStatusPublisher::EnableChangeNotification(const std::string& inSocketPath)
+{
+	sockaddr_un address;
+	if (!MakeSocketAddress(inSocketPath, address))
+		return EGAVResult::ErrInvalidPath;
+
+	CloseFD(mListenSocket);
+	mListenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (mListenSocket < 0 || !SetNonBlocking(mListenSocket))
+	{
+		CloseFD(mListenSocket);
+		return EGAVResult::ErrResourceNotAvail;
+	}
+
+	unlink(inSocketPath.c_str()); // left over from a publisher that died (we own the segment lock)
+	if (bind(mListenSocket, (const sockaddr*)&address, sizeof(address)) != 0 || listen(mListenSocket, 16) != 0)
+	{
+		error_printf("EGAVStatusPublisher: can't listen on %s (%d)", inSocketPath.c_str(), errno);
+		CloseFD(mListenSocket);
+		return EGAVResult::ErrInvalidPath;
+	}
+	mSocketPath = inSocketPath;
+	return EGAVResult::Ok;
+}
+
+void EGAVStatusPublisher::ServiceSubscribers()
+{
+	if (mListenSocket < 0)
+		return;
+
+	for (int connection; (connection = accept(mListenSocket, nullptr, nullptr)) >= 0; )
+	{
+		SetNonBlocking(connection);
+		Subscriber subscriber;
+		subscriber.connection = connection;
+		mSubscribers.push_back(subscriber);
+	}
+
+	// Receive the notification descriptors, detect disconnected readers
+	for (size_t i = 0; i < mSubscribers.size(); )
+	{
+		Subscriber& subscriber = mSubscribers[i];
+		bool remove = false;
+
+		pollfd pfd = { subscriber.connection, POLLIN, 0 };
+		if (poll(&pfd, 1, 0) > 0)
+		{
+			char kind = 0;
+			iovec iov = { &kind, 1 };
+			alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+			msghdr msg{};
+			msg.msg_iov			= &iov;
+			msg.msg_iovlen		= 1;
+			msg.msg_control		= control;
+			msg.msg_controllen	= sizeof(control);
+
+			const ssize_t received = recvmsg(subscriber.connection, &msg, 0);
+			if (received <= 0)
+				remove = !(received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+			else if (subscriber.notifyFD < 0)
+			{
+				cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+				if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+				{
+					memcpy(&subscriber.notifyFD, CMSG_DATA(cmsg), sizeof(int));
+					subscriber.isEventFD = (kind == 'e');
+					SetNonBlocking(subscriber.notifyFD);
+				}
+				else
+					remove = true; // protocol error
+			}
+		}
+
+		if (remove)
+		{
+			CloseFD(subscriber.connection);
+			CloseFD(subscriber.notifyFD);
+			mSubscribers.erase(mSubscribers.begin() + i);
+		}
+		else
+			i++;
+	}
+}
+
+void EGAVStatusPublisher::NotifySubscribers()
+{
+	for (Subscriber& subscriber : mSubscribers)
+	{
+		if (subscriber.notifyFD < 0)
+			continue;
+
+		// A full pipe or eventfd already signals a change: EAGAIN is fine.
+		// Pipes of dead readers fail with EPIPE (the publisher must ignore SIGPIPE).
+		const uint64_t one = 1;
+		const ssize_t written = subscriber.isEventFD ? write(subscriber.notifyFD, &one, sizeof(one)) : write(subscriber.notifyFD, &one, 1);
+		if (written < 0 && errno == EPIPE)
+			CloseFD(subscriber.notifyFD); // reader gone; the connection is dropped by ServiceSubscribers()
+	}
+}
+
+EGAVResult EGAVStatusPublisher::Publish(const EGAVStatusSnapshot& inSnapshot, uint64_t inTimestampUs)
+{
+	if (!mSegment)
+		return EGAVResult::ErrNotInitialized;
+
+	mSegment->heartbeatUs.store(inTimestampUs, std::memory_order_release);
+	if (mHasLast && 0 == memcmp((const uint8_t*)&inSnapshot + kCompareOffset, (const uint8_t*)&mLast + kCompareOffset, kCompareEnd - kCompareOffset))
+		return EGAVResult::OkNoDataChanged;
+
+	const uint64_t sequence = mSegment->sequence.load(std::memory_order_relaxed) + 1;
+	mLast				= inSnapshot;
+	mLast.sequence		= sequence;
+	mLast.timestampUs	= inTimestampUs;
+	mHasLast			= true;
+
+	// Seqlock write into the slot readers are not directed to
+	const uint32_t next = mSegment->current.load(std::memory_order_relaxed) ^ 1;
+	EGAVStatusSegment::Slot& slot = mSegment->slots[next];
+	const uint32_t seqlock = slot.seqlock.load(std::memory_order_relaxed);
+	slot.seqlock.store(seqlock + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(&slot.snapshot, &mLast, sizeof(mLast));
+	slot.seqlock.store(seqlock + 2, std::memory_order_release);
+
+	mSegment->current.store(next, std::memory_order_release);
+	mSegment->sequence.store(sequence, std::memory_order_release);
+
+	NotifySubscribers();
+	return EGAVResult::Ok;
+}
+
+
+//==============================================================================
+// # Class EGAVStatusReader
+//==============================================================================
+
+EGAVStatusReader::~EGAVStatusReader()
+{
+	Close();
+}
+
+EGAVResult EGAVStatusReader::Open(const std::string& inName)
+{
+	Close();
+
+	mFD = shm_open(inName.c_str(), O_RDONLY, 0);
+	if (mFD < 0)
+		return EGAVResult::ErrNotFound;
+
+	struct stat info;
+	if (fstat(mFD, &info) != 0 || info.st_size < (off_t)sizeof(EGAVStatusSegment))
+	{
+		CloseFD(mFD);
+		return EGAVResult::ErrNotInitialized; // publisher hasn't sized it yet (or a different layout)
+	}
+
+	void* memory = mmap(nullptr, sizeof(EGAVStatusSegment), PROT_READ, MAP_SHARED, mFD, 0);
+	if (memory == MAP_FAILED)
+	{
+		CloseFD(mFD);
+		return EGAVResult::ErrInsufficientMemory;
+	}
+	mSegment = (const EGAVStatusSegment*)memory;
+
+	EGAVResult res = EGAVResult::Ok;
+	if (mSegment->magic.load(std::memory_order_acquire) != EGAV_STATUS_SEGMENT_MAGIC)
+		res = EGAVResult::ErrNotInitialized;
+	else if (mSegment->version != EGAV_STATUS_SEGMENT_VERSION || mSegment->size != sizeof(EGAVStatusSegment))
+		res = EGAVResult::ErrInvalidFormat;
+	if (res.Failed())
+		Close();
+	return res;
+}
+
+void EGAVStatusReader::Close()
+{
+	CloseFD(mConnection);
+	CloseFD(mNotifyFD);
+	if (mSegment)
+	{
+		munmap((void*)mSegment, sizeof(EGAVStatusSegment));
+		mSegment = nullptr;
+	}
+	CloseFD(mFD);
+}
+
+uint64_t EGAVStatusReader::GetSequence() const
+{
+	return mSegment ? mSegment->sequence.load(std::memory_order_acquire) : 0;
+}
+
+uint64_t EGAVStatusReader::GetHeartbeatUs() const
+{
+	return mSegment ? mSegment->heartbeatUs.load(std::memory_order_acquire) : 0;
+}
+
+EGAVResult EGAVStatusReader::Read(EGAVStatusSnapshot& outSnapshot, uint64_t* ioLastSequence /*= nullptr*/) const
+{
+	if (!mSegment)
+		return EGAVResult::ErrNotInitialized;
+
+	const uint64_t sequence = mSegment->sequence.load(std::memory_order_acquire);
+	if (sequence == 0)
+		return EGAVResult::ErrNoData;
+	if (ioLastSequence && *ioLastSequence == sequence)
+		return EGAVResult::OkNoDataChanged;
+
+	while (true)
+	{
+		const EGAVStatusSegment::Slot& slot = mSegment->slots[mSegment->current.load(std::memory_order_acquire) & 1];
+		const uint32_t before = slot.seqlock.load(std::memory_order_acquire);
+		if (before & 1)
+			continue; // publisher lapped us and is writing this slot
+
+		memcpy(&outSnapshot, (const void*)&slot.snapshot, sizeof(outSnapshot));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.seqlock.load(std::memory_order_relaxed) == before)
+			break;
+	}
+
+	if (ioLastSequence)
+		*ioLastSequence = outSnapshot.sequence;
+	return EGAVResult::Ok;
+}
+
+EGAVResult EGAVStatusReader::SubscribeChanges(const std::string& inSocketPath, int& outFD)
+{
+	sockaddr_un address;
+	if (!MakeSocketAddress(inSocketPath, address))
+		return EGAVResult::ErrInvalidPath;
+
+	CloseFD(mConnection);
+	CloseFD(mNotifyFD);
+
+	// Descriptor handed to the publisher: eventfd (Linux) or the write end of a pipe
+	int sendFD = -1;
+	char kind = 'p';
+#ifdef __linux__
+	mNotifyFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	sendFD    = mNotifyFD;
+	kind      = 'e';
+	mIsEventFD = true;
+#else
+	int fds[2];
+	if (pipe(fds) == 0)
+	{
+		mNotifyFD = fds[0];
+		sendFD    = fds[1];
+		SetNonBlocking(mNotifyFD);
+	}
+	mIsEventFD = false;
+#endif
+	if (mNotifyFD < 0)
+		return EGAVResult::ErrResourceNotAvail;
+
+	mConnection = socket(AF_UNIX, SOCK_STREAM, 0);
+	EGAVResult res = EGAVResult::Ok;
+	if (mConnection < 0 || connect(mConnection, (const sockaddr*)&address, sizeof(address)) != 0)
+		res = EGAVResult::ErrNotFound;
+	else
+	{
+		iovec iov = { &kind, 1 };
+		alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+		memset(control, 0, sizeof(control));
+		msghdr msg{};
+		msg.msg_iov			= &iov;
+		msg.msg_iovlen		= 1;
+		msg.msg_control		= control;
+		msg.msg_controllen	= sizeof(control);
+		cmsghdr* cmsg		= CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level	= SOL_SOCKET;
+		cmsg->cmsg_type		= SCM_RIGHTS;
+		cmsg->cmsg_len		= CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(cmsg), &sendFD, sizeof(int));
+		if (sendmsg(mConnection, &msg, 0) != 1)
+			res = EGAVResult::ErrResourceNotAvail;
+	}
+
+	if (sendFD != mNotifyFD)
+		close(sendFD); // the publisher has its own copy of the write end
+	if (res.Failed())
+	{
+		CloseFD(mConnection);
+		CloseFD(mNotifyFD);
+		return res;
+	}
+	outFD = mNotifyFD;
+	return EGAVResult::Ok;
+}
+
+EGAVResult EGAVStatusReader::WaitForChange(int inTimeoutMs)
+{
+	if (mNotifyFD < 0)
+		return EGAVResult::ErrInvalidState;
+
+	pollfd pfd = { mNotifyFD, POLLIN, 0 };
+	if (poll(&pfd, 1, inTimeoutMs) <= 0)
+		return EGAVResult::ErrTimeOut;
+
+	uint8_t buffer[64];
+	if (mIsEventFD)
+		return (read(mNotifyFD, buffer, sizeof(uint64_t)) == sizeof(uint64_t)) ? EGAVResult::Ok : EGAVResult::ErrTimeOut;
+	while (read(mNotifyFD, buffer, sizeof(buffer)) > 0)
+		;
+	return EGAVResult::Ok;
+}
+
+#endif // !_UP_WINDOWS
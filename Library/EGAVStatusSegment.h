@@ -0,0 +1,218 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVStatusSegment.h
+
+@brief		Device status in POSIX shared memory: one publisher, any number of readers.
+
+			The publisher (e.g. the EGAVStatusDaemon sample) is the only process that
+			talks to the device. It publishes the decoded signal status and the raw
+			info frames into a shared memory segment. Readers map the segment read-only
+			and take snapshots without system calls or locks.
+
+			The segment holds two slots, each protected by a seqlock. The publisher
+			writes the slot readers are not directed to and then switches. A reader
+			therefore only retries if two updates happen during its copy, which never
+			occurs at poll rates.
+
+			Change notification (optional): a reader sends an eventfd (Linux) or the
+			write end of a pipe over a Unix domain socket; the publisher signals it on
+			every change. The descriptor can be used with poll/epoll/kqueue.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "EGAVResult.h"
+#include "HDMIInfoFramesAPI.h"
+
+class ElgatoUVCDevice;
+
+
+//! @brief Value of the decoded fields whose info frame the device doesn't expose (no register mapped, see
+//! ElgatoUVCDevice::SetInfoFrameRegister()). The released firmware only delivers the DR info frame.
+#define EGAV_STATUS_UNSUPPORTED		-2
+
+//! @brief Status of one capture device
+struct EGAVStatusSnapshot
+{
+	uint64_t				sequence;			//!< number of changes published (0: nothing published yet)
+	uint64_t				timestampUs;		//!< publisher steady clock at the poll that found the change
+	int32_t					deviceResult;		//!< EGAVResultCode of the poll (e.g. ErrTimeOut: device not responding)
+	uint8_t					isHDR;
+	int8_t					eotf;				//!< HDMI_DR_EOTF_* or HDMI_ERROR
+	int8_t					contentType;		//!< HDMI_AVI_CN_*, HDMI_ERROR or EGAV_STATUS_UNSUPPORTED (no AVI info frame register)
+	int8_t					pixelRepetition;	//!< 1..10, HDMI_ERROR or EGAV_STATUS_UNSUPPORTED (no AVI info frame register)
+	uint32_t				frameMask;			//!< bit (type - 1): info frame of that type was received
+	uint32_t				supportedMask;		//!< bit (type - 1): the device exposes info frames of that type
+	HDMI_GENERIC_INFOFRAME	frames[HDMI_INFOFRAME_TYPE_MAX];	//!< raw info frames, index: type - 1
+
+	const HDMI_GENERIC_INFOFRAME* GetFrame(uint8_t inType) const
+	{
+		return (inType >= HDMI_INFOFRAME_TYPE_MIN && inType <= HDMI_INFOFRAME_TYPE_MAX && (frameMask & (1u << (inType - 1)))) ? &frames[inType - 1] : nullptr;
+	}
+
+	bool IsFrameSupported(uint8_t inType) const
+	{
+		return inType >= HDMI_INFOFRAME_TYPE_MIN && inType <= HDMI_INFOFRAME_TYPE_MAX && (supportedMask & (1u << (inType - 1)));
+	}
+};
+static_assert(std::is_trivially_copyable<EGAVStatusSnapshot>::value, "EGAVStatusSnapshot is copied with memcpy");
+
+//! @brief Reads all info frames the firmware exposes and decodes the signal status (publisher side)
+//! @param outSnapshot sequence and timestampUs are not touched
+EGAVResult EGAVStatus_PollDevice(ElgatoUVCDevice& inDevice, EGAVStatusSnapshot& outSnapshot);
+
+
+//==============================================================================
+// # Segment layout
+//==============================================================================
+
+// The atomics are shared between processes: they must not fall back to a lock
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free, "shared memory atomics must be lock-free");
+
+#define EGAV_STATUS_SEGMENT_MAGIC		0x53564145	// 'EAVS'
+#define EGAV_STATUS_SEGMENT_VERSION		2
+
+struct EGAVStatusSegment
+{
+	struct alignas(64) Slot
+	{
+		std::atomic<uint32_t>	seqlock;		//!< odd: write in progress
+		EGAVStatusSnapshot		snapshot;
+	};
+
+	std::atomic<uint32_t>	magic;				//!< set last when the publisher initialized the segment
+	uint32_t				version;
+	uint32_t				size;				//!< sizeof(EGAVStatusSegment) of the publisher
+	int32_t					publisherPid;
+	std::atomic<uint64_t>	heartbeatUs;		//!< publisher steady clock of the last poll (changed or not)
+	std::atomic<uint64_t>	sequence;			//!< sequence of the latest snapshot
+	std::atomic<uint32_t>	current;			//!< slot of the latest snapshot
+	Slot					slots[2];
+};
+
+
+//==============================================================================
+// # Class EGAVStatusPublisher
+//==============================================================================
+
+class EGAVStatusPublisher
+{
+public:
+	EGAVStatusPublisher() = default;
+	~EGAVStatusPublisher();
+	EGAVStatusPublisher(const EGAVStatusPublisher&) = delete;
+	EGAVStatusPublisher& operator=(const EGAVStatusPublisher&) = delete;
+
+	//! @brief Creates (or takes over) the segment, e.g. "/egav-status-0"
+	//! @return ErrDeviceInUse if another publisher owns the segment
+	EGAVResult Create(const std::string& inName);
+	void Close();
+
+	//! @brief Accepts change subscriptions on the Unix domain socket
+	EGAVResult EnableChangeNotification(const std::string& inSocketPath);
+
+	//! @brief Publishes the snapshot if it differs from the last one (sequence and timestamp are set here)
+	//! @return OkNoDataChanged if nothing changed (only the heartbeat is updated)
+	EGAVResult Publish(const EGAVStatusSnapshot& inSnapshot, uint64_t inTimestampUs);
+
+	//! @brief Accepts new subscribers and drops disconnected ones; call from the poll loop
+	void ServiceSubscribers();
+
+	int GetSubscriberCount() const { return (int)mSubscribers.size(); }
+
+private:
+	void NotifySubscribers();
+
+	struct Subscriber
+	{
+		int		connection	= -1;
+		int		notifyFD	= -1;
+		bool	isEventFD	= false;
+	};
+
+	std::string					mName;
+	int							mFD				= -1;
+	EGAVStatusSegment*			mSegment		= nullptr;
+	EGAVStatusSnapshot			mLast{};
+	bool						mHasLast		= false;
+
+	std::string					mSocketPath;
+	int							mListenSocket	= -1;
+	std::vector<Subscriber>		mSubscribers;
+};
+
+
+//==============================================================================
+// # Class EGAVStatusReader
+//==============================================================================
+
+class EGAVStatusReader
+{
+public:
+	EGAVStatusReader() = default;
+	~EGAVStatusReader();
+	EGAVStatusReader(const EGAVStatusReader&) = delete;
+	EGAVStatusReader& operator=(const EGAVStatusReader&) = delete;
+
+	//! @return ErrNotFound if no publisher created the segment, ErrNotInitialized if it isn't ready yet,
+	//! ErrInvalidFormat for a different segment version
+	EGAVResult Open(const std::string& inName);
+	void Close();
+
+	//! @brief Copies the latest snapshot (lock-free, no system call)
+	//! @return OkNoDataChanged if the sequence equals ioLastSequence (snapshot not copied); ErrNoData before the first publish
+	EGAVResult Read(EGAVStatusSnapshot& outSnapshot, uint64_t* ioLastSequence = nullptr) const;
+
+	//! @return number of changes published so far (cheap change check)
+	uint64_t GetSequence() const;
+
+	//! @return publisher steady clock of its last poll (stale if the publisher died)
+	uint64_t GetHeartbeatUs() const;
+
+	//! @brief Subscribes to change notifications
+	//! @param outFD becomes readable on changes (owned by the reader; use with poll/epoll, reset with WaitForChange(0))
+	EGAVResult SubscribeChanges(const std::string& inSocketPath, int& outFD);
+
+	//! @brief Waits until the publisher signals a change and resets the notification
+	//! @param inTimeoutMs 0: don't wait, -1: infinite
+	//! @return ErrTimeOut if nothing changed, ErrInvalidState without a subscription
+	EGAVResult WaitForChange(int inTimeoutMs);
+
+private:
+	int							mFD				= -1;
+	const EGAVStatusSegment*	mSegment		= nullptr;
+	int							mConnection		= -1;
+	int							mNotifyFD		= -1;	//!< read end
+	bool						mIsEventFD		= false;
+};
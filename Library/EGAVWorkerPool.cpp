@@ -0,0 +1,137 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		EGAVWorkerPool.cpp
+
+@brief		Persistent worker threads
+**/
+//==============================================================================
+
+#include "EGAVWorkerPool.h"
+
+
+//==============================================================================
+// # Class EGAVWorkerPool
+//==============================================================================
+
+EGAVWorkerPool::EGAVWorkerPool(size_t inThreadCount)
+{
+	mThreads.reserve(inThreadCount);
+	for (size_t i = 0; i < inThreadCount; i++)
+		mThreads.emplace_back(&EGAVWorkerPool::WorkerThread, this);
+}
+
+EGAVWorkerPool::~EGAVWorkerPool()
+{
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mWakeUp.notify_all();
+	for (auto& thread : mThreads)
+		thread.join();
+}
+
+void EGAVWorkerPool::Submit(Task inTask)
+{
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mTasks.push_back(std::move(inTask));
+	}
+	mWakeUp.notify_one();
+}
+
+void EGAVWorkerPool::ParallelFor(size_t inCount, const std::function<void(size_t inIndex)>& inFunction)
+{
+	if (inCount == 0)
+		return;
+	if (mThreads.empty() || inCount == 1)
+	{
+		for (size_t i = 0; i < inCount; i++)
+			inFunction(i);
+		return;
+	}
+
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mLoopFunction = &inFunction;
+		mLoopCount    = inCount;
+		mLoopNext     = 0;
+		mLoopPending  = inCount;
+	}
+	mWakeUp.notify_all();
+
+	RunLoopIndices();
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mLoopDone.wait(lock, [this] { return mLoopPending == 0; });
+	mLoopFunction = nullptr;
+}
+
+void EGAVWorkerPool::RunLoopIndices()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (mLoopFunction && mLoopNext < mLoopCount)
+	{
+		const size_t index = mLoopNext++;
+		const std::function<void(size_t)>& function = *mLoopFunction;
+		lock.unlock();
+		function(index);
+		lock.lock();
+		if (--mLoopPending == 0)
+			mLoopDone.notify_all();
+	}
+}
+
+void EGAVWorkerPool::WorkerThread()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (;;)
+	{
+		mWakeUp.wait(lock, [this] { return mStop || !mTasks.empty() || (mLoopFunction && mLoopNext < mLoopCount); });
+
+		// Loop indices first: the caller of ParallelFor() is waiting for them
+		if (mLoopFunction && mLoopNext < mLoopCount)
+		{
+			lock.unlock();
+			RunLoopIndices();
+			lock.lock();
+			continue;
+		}
+		if (!mTasks.empty())
+		{
+			Task task = std::move(mTasks.front());
+			mTasks.pop_front();
+			lock.unlock();
+			task();
+			lock.lock();
+			continue;
+		}
+		if (mStop)
+			return;
+	}
+}
@@ -0,0 +1,92 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		EGAVWorkerPool.h
+
+@brief		Persistent worker threads for per-frame parallel loops and for
+			offloading blocking calls.
+
+			The threads are created once and sleep on a condition variable between
+			jobs, so a parallel loop per video frame costs a wake-up instead of a
+			thread creation and join per slice.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+//==============================================================================
+// # Class EGAVWorkerPool
+//==============================================================================
+
+class EGAVWorkerPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	//! @param inThreadCount number of worker threads (0: none, ParallelFor() runs on the calling thread)
+	explicit EGAVWorkerPool(size_t inThreadCount);
+	//! @brief Waits for the submitted tasks, then joins the workers
+	~EGAVWorkerPool();
+	EGAVWorkerPool(const EGAVWorkerPool&) = delete;
+	EGAVWorkerPool& operator=(const EGAVWorkerPool&) = delete;
+
+	size_t GetThreadCount() const { return mThreads.size(); }
+
+	//! @brief Runs inTask on a worker thread (FIFO). Requires at least one worker.
+	void Submit(Task inTask);
+
+	//! @brief Calls inFunction(i) for every i in [0, inCount) on the workers and the calling thread.
+	//!        Returns when all calls have returned. Not reentrant; one ParallelFor() at a time.
+	void ParallelFor(size_t inCount, const std::function<void(size_t inIndex)>& inFunction);
+
+private:
+	void WorkerThread();
+	//! @brief Runs indices of the current loop until none is left
+	void RunLoopIndices();
+
+	std::vector<std::thread>	mThreads;
+	std::mutex					mMutex;
+	std::condition_variable		mWakeUp;
+	std::condition_variable		mLoopDone;
+	std::deque<Task>			mTasks;				//!< protected by mMutex
+	bool						mStop		= false;
+
+	// Current ParallelFor() loop (protected by mMutex)
+	const std::function<void(size_t)>* mLoopFunction = nullptr;
+	size_t						mLoopCount		= 0;
+	size_t						mLoopNext		= 0;
+	size_t						mLoopPending	= 0;	//!< indices not yet finished
+};
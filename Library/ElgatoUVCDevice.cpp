@@ -25,205 +25,452 @@ SOFTWARE.
 #include "ElgatoUVCDevice.h"
 
 
-#define WORKAROUND_HD60_S_PLUS_PAYLOAD_SIZE 1 //!<  Workaround HD60 S+ firmware issue: invalid payload length (seen with HDR and SPD info frames)
-
-
 //==============================================================================
 // # Elgato HID interface for UVC devices
 //==============================================================================
 
 
-enum class I2CAddress
+//! @brief MCU registers delivering HDMI info frames (HDMI_INFOFRAME_TYPE_* --> register)
+struct InfoFrameRegister
 {
-	MCU					= 0x55,
+	uint8_t				type;
+	MCU_I2C_REGISTER	reg;
 };
 
-//! @brief I2C registers for MCU (I2C address 0x55).
-enum class MCU_I2C_REGISTER
+static const InfoFrameRegister kInfoFrameRegisters[] =
 {
-	GET_HDR_PACKET		= 0x09, //!< HDR capable devices (HD60 S+, HD60 X)
-	XET_HDR_TONEMAPPING	= 0x0A, //!< HDR capable devices (HD60 S+, HD60 X): Enable hardware tonemapping; param 0/1 (uint8_t)
+	{ HDMI_INFOFRAME_TYPE_DR, MCU_I2C_REGISTER::GET_HDR_PACKET },
+	// EXTEND_INFOFRAME_REGISTERS: other info frame types (AVI, SPD, audio, VS) once the firmware exposes them
+	// (until then: ElgatoUVCDevice::SetInfoFrameRegister())
 };
 
+static std::map<uint8_t, uint8_t> GetDefaultInfoFrameRegisters()
+{
+	std::map<uint8_t, uint8_t> registers;
+	for (const InfoFrameRegister& entry : kInfoFrameRegisters)
+		registers[entry.type] = (uint8_t)entry.reg;
+	return registers;
+}
+
 
 
 //==============================================================================
-// ## HID interface - I2C
+// ## HID interface - I2C (see ElgatoUVCProtocol.h)
 //==============================================================================
 
-//! @brief HID report case for new device type.
-enum class REPORT_CASE_NEW
-{
-	REPORT_IIC_WRITE = 6,
-	REPORT_IIC_READ = 7
-};
+const int MAX_BLOCK_READ_ATTEMPTS	=  3;	//!< ReadI2cBlock() with verification
+
+
+//==============================================================================
+// # Class ElgatoUVCDevice
+//==============================================================================
 
-//! @brief HID report IDs for new device type. Can also be queried via HidP_GetValueCaps()
-enum class HID_REPORT_ID_NEW
+//! @brief Runtime protocol selection
+static std::unique_ptr<ElgatoUVCDeviceCore> CreateDeviceCore(std::shared_ptr<EGAVHIDInterface> inHID, bool inNewDeviceType)
 {
-	I2C_READ = 5,
-	I2C_WRITE = 6
-};
+	if (inNewDeviceType)
+		return std::make_unique<ElgatoUVCDeviceT<NewProtocol>>(std::move(inHID));
+	return std::make_unique<ElgatoUVCDeviceT<LegacyProtocol>>(std::move(inHID));
+}
 
-//! @brief HDI report IDs for original device type. Can also be queried via HidP_GetValueCaps()
-enum class HID_REPORT_ID
+ElgatoUVCDevice::ElgatoUVCDevice(std::shared_ptr<EGAVHIDInterface> hid, bool isNewDeviceType)
+	: mHID(hid), mCore(CreateDeviceCore(hid, isNewDeviceType)),
+	  mDeviceID(isNewDeviceType ? deviceIDHD60X : deviceIDHD60SPlus),
+	  mQuirks(ResolveElgatoUVCQuirks(mDeviceID, EGAVFirmwareVersion())),
+	  mInfoFrameRegisters(GetDefaultInfoFrameRegisters())
 {
-	I2C_READ_SET_ID = 9,
-	I2C_READ_GET_ID = 10,
-	I2C_WRITE_ID = 11
-};
+}
 
-const int I2C_BUFFER_HEADER_SIZE	=  4;
-const int MAX_COMM_READ_BUFFER_SIZE	= 32;
+ElgatoUVCDevice::ElgatoUVCDevice(std::shared_ptr<EGAVHIDInterface> hid, const EGAVDeviceID& inDeviceID, const EGAVFirmwareVersion& inFirmware /*= EGAVFirmwareVersion()*/)
+	: mHID(hid), mCore(CreateDeviceCore(hid, IsNewDeviceType(inDeviceID))), mDeviceID(inDeviceID), mQuirks(ResolveElgatoUVCQuirks(inDeviceID, inFirmware)),
+	  mInfoFrameRegisters(GetDefaultInfoFrameRegisters())
+{
+}
 
+EGAVResult ElgatoUVCDevice::ReadI2cData(uint8_t inI2CAddress, uint8_t inRegister, uint8_t* outData, uint8_t inLength)
+{
+	EPL_ASSERT_BREAK(inLength <= MAX_COMM_READ_BUFFER_SIZE);
 
-//==============================================================================
-// # Helpers
-//==============================================================================
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	const EGAVProcessLockGuard processLock(mProcessLock.get());
+	if (processLock.GetResult().Failed())
+		return processLock.GetResult();
+	EGAVResult res = mCore->ReadI2cData(inI2CAddress, inRegister, outData, inLength);
+	EPL_ASSERT_BREAK(res.Succeeded());
+	return res;
+}
 
-std::vector<EGAVDeviceID> GetElgatoUVCDeviceIDs()
+EGAVResult ElgatoUVCDevice::WriteI2cData(uint8_t inI2CAddress, uint8_t inRegister, uint8_t* inData, uint8_t inLength)
 {
-	std::vector<EGAVDeviceID> devices {deviceIDHD60SPlus, deviceIDHD60X, deviceIDHD60XRev2 };
-	// EXTEND_DEVICES
-	return devices;
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	const EGAVProcessLockGuard processLock(mProcessLock.get());
+	if (processLock.GetResult().Failed())
+		return processLock.GetResult();
+	if (inI2CAddress == (uint8_t)I2CAddress::EDID)
+		mEDIDCache.reset(); // also if the write fails: it may have changed some bytes
+	return mCore->WriteI2cData(inI2CAddress, inRegister, inData, inLength);
 }
 
-//! @return true for new USB chipset
-bool IsNewDeviceType(const EGAVDeviceID& inDeviceID) { return (inDeviceID != deviceIDHD60SPlus); }
-
+EGAVResult ElgatoUVCDevice::EnableProcessLock(const std::string& inLockDirectory /*= std::string()*/)
+{
+	auto processLock = std::make_unique<EGAVProcessLock>();
+	EGAVResult res = processLock->Open(EGAVProcessLock::GetLockName(mDeviceID, inLockDirectory));
+	if (res.Failed())
+		return res;
 
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	mProcessLock = std::move(processLock);
+	return EGAVResult::Ok;
+}
 
-//==============================================================================
-// # Class ElgatoUVCDevice
-//==============================================================================
+void ElgatoUVCDevice::DisableProcessLock()
+{
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	mProcessLock.reset();
+}
 
-ElgatoUVCDevice::ElgatoUVCDevice(std::shared_ptr<EGAVHIDInterface> hid, bool isNewDeviceType) : mHIDImpl(hid), mNewDeviceType(isNewDeviceType) {}
+EGAVProcessLockStatistics ElgatoUVCDevice::GetProcessLockStatistics()
+{
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	return mProcessLock ? mProcessLock->GetStatistics() : EGAVProcessLockStatistics();
+}
 
-EGAVResult ElgatoUVCDevice::ReadI2cData(uint8_t inI2CAddress, uint8_t inRegister, uint8_t* outData, uint8_t inLength)
+EGAVResult ElgatoUVCDevice::ReadI2cBlock(uint8_t inI2CAddress, uint8_t inStartRegister, uint8_t* outData, size_t inLength, bool inVerify /*= false*/)
 {
 	EGAVResult_CheckPointer(outData);
-	EGAVResult_CheckPointer(mHIDImpl);
-
-	EPL_ASSERT_BREAK(inLength <= MAX_COMM_READ_BUFFER_SIZE);
+	if (inLength == 0 || inStartRegister + inLength > 0x100)
+		return EGAVResult::ErrOutOfRange;
 
 	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
 
-	EGAVResult res = EGAVResult::ErrUnknown;
-
-	if (mNewDeviceType) 
+	auto readBlock = [&](uint8_t* outBlock) -> EGAVResult
 	{
-		const uint8_t writeLen = 1 /* +1 for byte register address*/, readLen = inLength, reportLen = 4 + writeLen + sizeof(readLen);
-		std::vector<uint8_t> outputMessage{ reportLen, (uint8_t)REPORT_CASE_NEW::REPORT_IIC_READ, inI2CAddress, writeLen, inRegister, readLen };
-		EPL_ASSERT_BREAK(reportLen == outputMessage.size());
-		res = mHIDImpl->WriteHID(outputMessage, (int)HID_REPORT_ID_NEW::I2C_WRITE);
-		if (res.Failed())
-			error_printf("WriteHID() FAILED for I2C address 0x%02x, register 0x%02x", inI2CAddress, inRegister);
-		else
+		for (size_t offset = 0; offset < inLength; offset += MAX_COMM_READ_BUFFER_SIZE)
 		{
-			std::vector<uint8_t> inputMessage;
-			const int inputReportLength = 0xFF | ((int)REPORT_CASE_NEW::REPORT_IIC_READ << 8); // report case is coded into report length
-			res = mHIDImpl->ReadHID(inputMessage, (int)HID_REPORT_ID_NEW::I2C_READ, inputReportLength);
+			const uint8_t chunk = (uint8_t)std::min(inLength - offset, (size_t)MAX_COMM_READ_BUFFER_SIZE);
+			EGAVResult res = ReadI2cData(inI2CAddress, (uint8_t)(inStartRegister + offset), outBlock + offset, chunk);
 			if (res.Failed())
-				error_printf("ReadHID() FAILED for I2C address 0x%02x, register 0x%02x", inI2CAddress, inRegister);
-			else
-			{
-				int dataLen = std::min((int)inLength, (int)(inputMessage.size() - 1));
-				memcpy(outData, inputMessage.data() + 1, dataLen);
-			}
+				return res;
 		}
+		return EGAVResult::Ok;
+	};
+
+	EGAVResult res = readBlock(outData);
+	if (res.Failed() || !inVerify)
+		return res;
+
+	// Compare with a second copy; on a mismatch the newer copy is compared with a third one, and so on
+	std::vector<uint8_t> copy(inLength);
+	for (int attempt = 1; attempt < MAX_BLOCK_READ_ATTEMPTS; attempt++)
+	{
+		res = readBlock(copy.data());
+		if (res.Failed())
+			return res;
+		if (memcmp(copy.data(), outData, inLength) == 0)
+			return EGAVResult::Ok;
+		memcpy(outData, copy.data(), inLength);
 	}
-	else
+	warning_printf("I2C block read from address 0x%02x, register 0x%02x: data changed during %d attempts", inI2CAddress, inStartRegister, MAX_BLOCK_READ_ATTEMPTS);
+	return EGAVResult::ErrInvalidState;
+}
+
+EGAVResult ElgatoUVCDevice::WriteI2cBlock(uint8_t inI2CAddress, uint8_t inStartRegister, const uint8_t* inData, size_t inLength, bool inVerify /*= false*/)
+{
+	EGAVResult_CheckPointer(inData);
+	if (inLength == 0 || inStartRegister + inLength > 0x100)
+		return EGAVResult::ErrOutOfRange;
+
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+
+	uint8_t chunkData[MAX_COMM_WRITE_BUFFER_SIZE];
+	for (size_t offset = 0; offset < inLength; offset += MAX_COMM_WRITE_BUFFER_SIZE)
 	{
-		std::vector<uint8_t> outputMessage{ inI2CAddress, inRegister, inLength };
-		res = mHIDImpl->WriteHID(outputMessage, (int)HID_REPORT_ID::I2C_READ_SET_ID);
+		const uint8_t chunk = (uint8_t)std::min(inLength - offset, (size_t)MAX_COMM_WRITE_BUFFER_SIZE);
+		memcpy(chunkData, inData + offset, chunk);
+		EGAVResult res = WriteI2cData(inI2CAddress, (uint8_t)(inStartRegister + offset), chunkData, chunk);
 		if (res.Failed())
-			error_printf("WriteHID() FAILED for I2C address 0x%02x, register 0x%02x", inI2CAddress, inRegister);
-		else
-		{
-			std::vector<uint8_t> inputMessage(I2C_BUFFER_HEADER_SIZE + MAX_COMM_READ_BUFFER_SIZE);
-			res = mHIDImpl->ReadHID(inputMessage, (int)HID_REPORT_ID::I2C_READ_GET_ID);
-			if (res.Failed())
-				error_printf("ReadHID() FAILED for I2C address 0x%02x, register 0x%02x", inI2CAddress, inRegister);
-			else
-				memcpy(outData, inputMessage.data(), inLength);
-		}
+			return res;
 	}
+	if (!inVerify)
+		return EGAVResult::Ok;
 
-	EPL_ASSERT_BREAK(res.Succeeded());
+	std::vector<uint8_t> readBack(inLength);
+	EGAVResult res = ReadI2cBlock(inI2CAddress, inStartRegister, readBack.data(), inLength);
+	if (res.Succeeded() && memcmp(readBack.data(), inData, inLength) != 0)
+	{
+		error_printf("I2C block write to address 0x%02x, register 0x%02x: read back differs", inI2CAddress, inStartRegister);
+		res = EGAVResult::ErrInvalidState;
+	}
 	return res;
 }
 
+EGAVResult ElgatoUVCDevice::GetEDID(std::shared_ptr<const HDMIEDID>& outEDID, bool inForceRead /*= false*/)
+{
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
 
-EGAVResult ElgatoUVCDevice::WriteI2cData(uint8_t inI2CAddress, uint8_t inRegister, uint8_t* inData, uint8_t inLength)
+	if (mEDIDCache && !inForceRead)
+	{
+		outEDID = mEDIDCache;
+		return EGAVResult::Ok;
+	}
+
+	uint8_t data[HDMI_EDID_MAX_SIZE] = {};
+	EGAVResult res = ReadI2cBlock((uint8_t)I2CAddress::EDID, 0, data, HDMI_EDID_BLOCK_SIZE, true);
+	if (res.Succeeded() && data[126] > 0)
+		res = ReadI2cBlock((uint8_t)I2CAddress::EDID, HDMI_EDID_BLOCK_SIZE, data + HDMI_EDID_BLOCK_SIZE, HDMI_EDID_BLOCK_SIZE, true);
+	if (res.Failed())
+		return res;
+
+	auto edid = std::make_shared<HDMIEDID>();
+	res = edid->Decode(data, (data[126] > 0) ? HDMI_EDID_MAX_SIZE : HDMI_EDID_BLOCK_SIZE);
+	if (res.Failed())
+	{
+		warning_printf("EDID: invalid header or checksum!");
+		return res;
+	}
+
+	mEDIDCache = edid;
+	outEDID = mEDIDCache;
+	return res;
+}
+
+void ElgatoUVCDevice::InvalidateEDIDCache()
+{
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	mEDIDCache.reset();
+}
+
+EGAVResult ElgatoUVCDevice::SetHDRTonemappingEnabled(bool inValue)
+{
+	uint8_t buffer = inValue ? 1 : 0;
+	return WriteRegisterShadowed((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::XET_HDR_TONEMAPPING, &buffer, sizeof(buffer));
+}
+
+void ElgatoUVCDevice::SetRegisterWriteVerification(bool inVerify, int inMaxRetries /*= 2*/)
+{
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	mVerifyWrites = inVerify;
+	mWriteRetries = std::max(inMaxRetries, 0);
+}
+
+EGAVResult ElgatoUVCDevice::WriteRegisterShadowed(uint8_t inI2CAddress, uint8_t inRegister, const uint8_t* inData, uint8_t inLength)
 {
 	EGAVResult_CheckPointer(inData);
-	EGAVResult_CheckPointer(mHIDImpl);
+	if (inLength == 0 || inLength > MAX_COMM_WRITE_BUFFER_SIZE)
+		return EGAVResult::ErrInvalidParameter;
 
 	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
 
-	EGAVResult res = EGAVResult::ErrUnknown;
+	ShadowRegister& shadow = mShadowRegisters[(uint16_t)((inI2CAddress << 8) | inRegister)];
+	if (!shadow.dirty && shadow.length == inLength && memcmp(shadow.value.data(), inData, inLength) == 0)
+		return EGAVResult::OkNoDataChanged;
+
+	memcpy(shadow.value.data(), inData, inLength);
+	shadow.length = inLength;
+	shadow.dirty  = true;
+
+	EGAVResult res = WriteAndVerify(inI2CAddress, inRegister, inData, inLength);
+	shadow.dirty = res.Failed(); // retried with the next write or replay
+	return res;
+}
+
+EGAVResult ElgatoUVCDevice::WriteAndVerify(uint8_t inI2CAddress, uint8_t inRegister, const uint8_t* inData, uint8_t inLength)
+{
+	uint8_t data[MAX_COMM_WRITE_BUFFER_SIZE];
+	memcpy(data, inData, inLength);
 
-	if (mNewDeviceType)
+	EGAVResult res = EGAVResult::ErrUnknown;
+	for (int attempt = 0; attempt <= mWriteRetries; attempt++)
 	{
-		const uint8_t writeLen = 1 + inLength /* +1 for byte register address*/, reportLen = 4 + writeLen;
-		std::vector<uint8_t> outputMessage{ reportLen, (uint8_t)REPORT_CASE_NEW::REPORT_IIC_WRITE, inI2CAddress, writeLen, inRegister };
-		for (int i = 0; i < inLength; i++)
-			outputMessage.push_back(inData[i]);
-		EPL_ASSERT_BREAK(reportLen == outputMessage.size());
+		res = WriteI2cData(inI2CAddress, inRegister, data, inLength);
+		if (res.Succeeded() && mVerifyWrites)
+		{
+			uint8_t readBack[MAX_COMM_WRITE_BUFFER_SIZE];
+			res = ReadI2cData(inI2CAddress, inRegister, readBack, inLength);
+			if (res.Succeeded() && memcmp(readBack, inData, inLength) != 0)
+			{
+				warning_printf("I2C address 0x%02x, register 0x%02x: read back differs (attempt %d)", inI2CAddress, inRegister, attempt + 1);
+				res = EGAVResult::ErrInvalidState;
+			}
+		}
+		if (res.Succeeded())
+			break;
+	}
+	return res;
+}
 
-		res = mHIDImpl->WriteHID(outputMessage, (int)HID_REPORT_ID_NEW::I2C_WRITE);
+EGAVResult ElgatoUVCDevice::ReopenHIDInterface()
+{
+	EGAVResult_CheckPointer(mHID);
+
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	mHID->DeinitHIDInterface();
+	EGAVResult res = mHID->InitHIDInterface(mDeviceID);
+	if (res.Failed())
+	{
+		mEDIDCache.reset();
+		return res;
 	}
-	else
+	return ReplayShadowRegisters();
+}
+
+EGAVResult ElgatoUVCDevice::ReplayShadowRegisters()
+{
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+
+	// After a reconnect or reset the device may present a different EDID
+	mEDIDCache.reset();
+
+	// Runs of consecutive registers (same I2C address) are sent as one write
+	EGAVResult result = EGAVResult::Ok;
+	for (auto it = mShadowRegisters.begin(); it != mShadowRegisters.end(); )
 	{
-		std::vector<uint8_t> outputMessage{ inI2CAddress, inRegister, inLength };
-		for (int i = 0; i < inLength; i++)
-			outputMessage.push_back(inData[i]);
-		res = mHIDImpl->WriteHID(outputMessage, (int)HID_REPORT_ID::I2C_WRITE_ID);
+		const uint16_t first = it->first;
+		uint8_t data[MAX_COMM_WRITE_BUFFER_SIZE];
+		size_t length = 0;
+		auto end = it;
+		while (end != mShadowRegisters.end() && (end->first >> 8) == (first >> 8) && end->first == first + length
+			   && length + end->second.length <= sizeof(data))
+		{
+			memcpy(data + length, end->second.value.data(), end->second.length);
+			length += end->second.length;
+			++end;
+		}
+
+		EGAVResult res = WriteAndVerify((uint8_t)(first >> 8), (uint8_t)first, data, (uint8_t)length);
+		for (; it != end; ++it)
+			it->second.dirty = res.Failed();
+		if (res.Failed())
+			result = res;
 	}
+	return result;
+}
 
-	if (res.Failed())
-		error_printf("WriteHID() FAILED for I2C address 0x%02d, register 0x%02d", inI2CAddress, inRegister);
+void ElgatoUVCDevice::InvalidateShadowRegisters()
+{
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	mShadowRegisters.clear();
+}
+
+EGAVResult ElgatoUVCDevice::GetHDMIHDRStatusPacket(HDMI_GENERIC_INFOFRAME& outFrame)
+{
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	EGAVResult res = ReadInfoFrameRegister((uint8_t)MCU_I2C_REGISTER::GET_HDR_PACKET, outFrame);
+
+	// Only the DR packet is journaled: AVI/SPD/audio are polled separately and would interleave with it
+	if (res.Succeeded() && mJournal)
+	{
+		// A failing journal (e.g. disk full) doesn't fail the read; reported once until it recovers
+		EGAVResult journalRes = mJournal->Append(outFrame);
+		if (journalRes.Failed() && !mJournalFailed)
+			warning_printf("ElgatoUVCDevice: info frame journal append FAILED (%s)", journalRes.GetResultCodeString());
+		mJournalFailed = journalRes.Failed();
+	}
 	return res;
 }
 
-void ElgatoUVCDevice::SetHDRTonemappingEnabled(bool inValue)
+EGAVResult ElgatoUVCDevice::GetHDMIInfoFrame(uint8_t inType, HDMI_GENERIC_INFOFRAME& outFrame)
 {
 	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	const auto entry = mInfoFrameRegisters.find(inType);
+	if (entry == mInfoFrameRegisters.end())
+		return EGAVResult::ErrNotSupported;
 
-	uint8_t buffer = inValue ? 1 : 0;
-	WriteI2cData((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::XET_HDR_TONEMAPPING, &buffer, sizeof(buffer));
+	EGAVResult res = ReadInfoFrameRegister(entry->second, outFrame);
+	if (res.Succeeded() && outFrame.header.bfType != inType)
+		res = EGAVResult::ErrNoData; // e.g. all empty: source doesn't send this info frame
+	return res;
 }
 
-EGAVResult ElgatoUVCDevice::GetHDMIHDRStatusPacket(HDMI_GENERIC_INFOFRAME& outFrame)
+void ElgatoUVCDevice::SetInfoFrameRegister(uint8_t inType, uint8_t inRegister)
 {
 	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	mInfoFrameRegisters[inType] = inRegister;
+}
 
-	const size_t bufSize = mNewDeviceType ? 32 : 33;
-	uint8_t* buffer = new uint8_t[bufSize];
-	EGAVResult res = ReadI2cData((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::GET_HDR_PACKET, buffer, (uint8_t)bufSize);
+EGAVResult ElgatoUVCDevice::GetHDMISourceProductDescription(HDMI_SPD_INFO& outInfo)
+{
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAVResult res = GetHDMIInfoFrame(HDMI_INFOFRAME_TYPE_SPD, frame);
+	if (res.Succeeded() && !HDMI_SPD_Decode(frame, outInfo))
+	{
+		warning_printf("HDMI SPD: invalid info frame (length or checksum)!");
+		res = EGAVResult::ErrInvalidFormat;
+	}
+	return res;
+}
+
+EGAVResult ElgatoUVCDevice::GetHDMIContentType(int& outContentType)
+{
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAVResult res = GetHDMIInfoFrame(HDMI_INFOFRAME_TYPE_AVI, frame);
 	if (res.Succeeded())
 	{
-		size_t size = (bufSize < sizeof(outFrame)) ? bufSize : sizeof(outFrame);
-		memcpy(&outFrame, mNewDeviceType ? buffer : buffer+1, size);
+		if (HDMI_AVI_IsValid(frame))
+			outContentType = HDMI_AVI_GetITContentType(frame);
+		else
+		{
+			warning_printf("HDMI AVI: invalid info frame (version, length or checksum)!");
+			res = EGAVResult::ErrInvalidFormat;
+		}
+	}
+	return res;
+}
 
-#if WORKAROUND_HD60_S_PLUS_PAYLOAD_SIZE
-		// Workaround HD60 S+ firmware issue: invalid payload length (seen with HDR and SPD info frames)
-		// Also with HD60 X FW 22.03.24 (MCU: 22.03.16)
-		if (outFrame.header.bPayloadLength > HDMI_MAX_INFOFRAME_PAYLOAD)
+EGAVResult ElgatoUVCDevice::GetPixelRepetitionFactor(int& outFactor)
+{
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAVResult res = GetHDMIInfoFrame(HDMI_INFOFRAME_TYPE_AVI, frame);
+	if (res.Succeeded())
+	{
+		int factor = HDMI_AVI_GetPixelRepetitionFactor(frame);
+		if (factor == HDMI_ERROR)
 		{
-			if (HDMI_INFOFRAME_TYPE_DR == outFrame.header.bfType)
-			{
-				int diff = outFrame.header.bPayloadLength - sizeof(outFrame.plDR1);
-				outFrame.header.bPayloadLength = sizeof(outFrame.plDR1);
-				outFrame.bChecksum += diff;
-			}
+			warning_printf("HDMI AVI: invalid info frame or reserved pixel repetition factor!");
+			res = EGAVResult::ErrInvalidFormat;
 		}
-#endif
+		else
+			outFactor = factor;
+	}
+	return res;
+}
+
+EGAVResult ElgatoUVCDevice::GetHDMIAudioInfo(HDMI_AUDIO_INFO& outInfo)
+{
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAVResult res = GetHDMIInfoFrame(HDMI_INFOFRAME_TYPE_A, frame);
+	if (res.Succeeded() && !HDMI_A_Decode(frame, outInfo))
+	{
+		warning_printf("HDMI Audio: invalid info frame or reserved channel allocation!");
+		res = EGAVResult::ErrInvalidFormat;
+	}
+	return res;
+}
+
+EGAVResult ElgatoUVCDevice::ReadInfoFrameRegister(uint8_t inRegister, HDMI_GENERIC_INFOFRAME& outFrame)
+{
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+
+	const size_t bufSize = mQuirks.infoFrameReadSize;
+	uint8_t* buffer = new uint8_t[bufSize];
+	EGAVResult res = ReadI2cData((uint8_t)I2CAddress::MCU, inRegister, buffer, (uint8_t)bufSize);
+	if (res.Succeeded())
+	{
+		size_t size = std::min(bufSize - mQuirks.infoFrameOffset, sizeof(outFrame));
+		memcpy(&outFrame, buffer + mQuirks.infoFrameOffset, size);
+		mQuirks.ApplyInfoFrameFixups(outFrame);
 	}
 	delete [] buffer;
 	return res;
 }
 
+void ElgatoUVCDevice::SetInfoFrameJournal(std::shared_ptr<HDMIInfoFrameJournalWriter> inJournal)
+{
+	const std::lock_guard<std::recursive_mutex> lock(mHIDMutex);
+	mJournal = inJournal;
+	mJournalFailed = false;
+}
+
 EGAVResult ElgatoUVCDevice::IsVideoHDR(bool& outIsHDR)
 {
 	// Try to read HDR meta data
@@ -24,34 +24,29 @@ SOFTWARE.
 
 #pragma once
 
+#include <array>
+#include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "EGAVResult.h"
 #include "EGAVDevice.h"
 #include "HDMIInfoFramesAPI.h"
+#include "HDMIEDID.h"
+#include "ElgatoUVCQuirks.h"
+#include "ElgatoUVCProtocol.h"
+#include "HDMIInfoFrameJournal.h"
+#include "EGAVProcessLock.h"
 
 #ifdef _MSC_VER
 #include "win/EGAVHIDImplementation.h"
+#elif defined(__linux__)
+#include "linux/EGAVHIDImplementation.h"
 #else
 #include "mac/EGAVHIDImplementation.h"
 #endif
 
-// Supported devices
-inline const EGAVDeviceID deviceIDHD60SPlus (EGAVBusType::USB, 0x0FD9, 0x006A); //!< HD60 S+
-inline const EGAVDeviceID deviceIDHD60X     (EGAVBusType::USB, 0x0FD9, 0x0082); //!< HD60 X
-inline const EGAVDeviceID deviceIDHD60XRev2 (EGAVBusType::USB, 0x0FD9, 0x008A); //!< HD60 X Rev. 2
-// EXTEND_DEVICES
-
-
-//! @return Device IDs of supported Elgato UVC devices
-std::vector<EGAVDeviceID> GetElgatoUVCDeviceIDs();
-
-
-//! @return true for new devices with new USB chipset
-bool IsNewDeviceType(const EGAVDeviceID& inDeviceID);
-
-
 
 //==============================================================================
 // # Class ElgatoUVCDevice
@@ -63,8 +58,36 @@ class ElgatoUVCDevice
 public:
 	ElgatoUVCDevice(std::shared_ptr<EGAVHIDInterface> hid, bool isNewDeviceType);
 
+	//! @brief Resolves the device and firmware specific quirks (see ElgatoUVCQuirks.h)
+	//! @param inFirmware unknown (0.0.0): all firmware specific quirks of the device apply. The version can't be
+	//! read from the device; pass it if it is known (e.g. from Elgato's update tool).
+	ElgatoUVCDevice(std::shared_ptr<EGAVHIDInterface> hid, const EGAVDeviceID& inDeviceID, const EGAVFirmwareVersion& inFirmware = EGAVFirmwareVersion());
+
+	const ElgatoUVCQuirks& GetQuirks() const { return mQuirks; }
+
 	//! @brief Works with HD60 S+, HD60 X or newer
-	void SetHDRTonemappingEnabled(bool inEnable);
+	//! @return OkNoDataChanged if tonemapping is already in the requested state (nothing is sent)
+	EGAVResult SetHDRTonemappingEnabled(bool inEnable);
+
+	//! @brief Writes registers through the shadow (setting registers, not status or EDID): a value equal to the
+	//! last one written successfully is not sent. Failed writes are sent again with the next write or replay.
+	//! @param inLength 1 .. 32 bytes
+	//! @return OkNoDataChanged if nothing was sent
+	EGAVResult WriteRegisterShadowed(uint8_t inI2CAddress, uint8_t inRegister, const uint8_t* inData, uint8_t inLength);
+
+	//! @brief Read-back verification of shadowed register writes, with up to inMaxRetries repeated writes on failure
+	void SetRegisterWriteVerification(bool inVerify, int inMaxRetries = 2);
+
+	//! @brief Writes all registers set through this object again, consecutive registers in one transfer.
+	//! Call after the HID interface was reopened (device reconnect or reset). Also drops the cached EDID.
+	EGAVResult ReplayShadowRegisters();
+
+	//! @brief Closes and reopens the HID interface after a device reconnect or reset, then replays the shadow
+	//! registers (see ReplayShadowRegisters()). The EDID cache is dropped in any case.
+	EGAVResult ReopenHIDInterface();
+
+	//! @brief Forgets the written register values: the next write of each register is sent
+	void InvalidateShadowRegisters();
 
 	//! @brief Works with HD60 S+, HD60 X or newer
 	EGAVResult GetHDMIHDRStatusPacket(HDMI_GENERIC_INFOFRAME& outFrame);
@@ -72,13 +95,98 @@ public:
 	//! @brief Works with HD60 S+, HD60 X or newer
 	EGAVResult IsVideoHDR(bool& outIsHDR);
 
+	//! @brief Reads the info frame of the given type (HDMI_INFOFRAME_TYPE_*)
+	//! The released firmware only delivers the DR info frame (GET_HDR_PACKET); other types need a register
+	//! mapped with SetInfoFrameRegister().
+	//! @return ErrNotSupported if no register is mapped for this type, ErrNoData if the source doesn't send it
+	EGAVResult GetHDMIInfoFrame(uint8_t inType, HDMI_GENERIC_INFOFRAME& outFrame);
+
+	//! @brief Maps an info frame type to the MCU register delivering it (same format as GET_HDR_PACKET),
+	//! for firmware that exposes more info frames than the built-in table. Replaces an existing mapping.
+	void SetInfoFrameRegister(uint8_t inType, uint8_t inRegister);
+
+	//! @brief Reads and decodes the SPD info frame (see HDMI_SPD_GetSourceClass() for console/PC detection)
+	//! @return ErrNotSupported unless a register is mapped for HDMI_INFOFRAME_TYPE_SPD (see GetHDMIInfoFrame())
+	EGAVResult GetHDMISourceProductDescription(HDMI_SPD_INFO& outInfo);
+
+	//! @brief Reads the IT content type from the AVI info frame
+	//! @param outContentType HDMI_AVI_CN_* or HDMI_ERROR if the source doesn't signal IT content
+	//! @return ErrNotSupported unless a register is mapped for HDMI_INFOFRAME_TYPE_AVI (see GetHDMIInfoFrame())
+	EGAVResult GetHDMIContentType(int& outContentType);
+
+	//! @brief Reads the pixel repetition factor from the AVI info frame (see HDMIPixelRepetition.h)
+	//! @param outFactor 1 (no repetition) .. 10
+	//! @return ErrNotSupported unless a register is mapped for HDMI_INFOFRAME_TYPE_AVI (see GetHDMIInfoFrame())
+	EGAVResult GetPixelRepetitionFactor(int& outFactor);
+
+	//! @brief Reads the audio info frame: format and speaker layout (see HDMIAudioRemapper.h)
+	//! @return ErrNotSupported unless a register is mapped for HDMI_INFOFRAME_TYPE_A (see GetHDMIInfoFrame())
+	EGAVResult GetHDMIAudioInfo(HDMI_AUDIO_INFO& outInfo);
+
+	//! @brief Reads and decodes the EDID the device presents to the HDMI source.
+	//! Only the base block and the first extension are read (256 bytes). An EDID announcing two or more
+	//! extensions decodes as far as it was read: HDMIEDID::Decode()'s OkButIncomplete is returned, which counts
+	//! as success (check for it if the later extensions matter).
+	//! The result is cached until InvalidateEDIDCache(), a write to I2CAddress::EDID, ReplayShadowRegisters()
+	//! or ReopenHIDInterface(), or until inForceRead is set.
+	EGAVResult GetEDID(std::shared_ptr<const HDMIEDID>& outEDID, bool inForceRead = false);
+
+	//! @brief Drops the cached EDID; call on HDMI hotplug (device reconnects are covered by ReopenHIDInterface())
+	void InvalidateEDIDCache();
+
+	//! @brief Reads a block of consecutive registers (auto-incrementing register address) of any length
+	//! The block is split into as few I2C reads as possible (32 bytes each), all under one lock.
+	//! @param inVerify reads the block twice and retries if the copies differ (data changed during the transfer);
+	//! returns ErrInvalidState if no two consecutive copies match
+	EGAVResult ReadI2cBlock(uint8_t inI2CAddress, uint8_t inStartRegister, uint8_t* outData, size_t inLength, bool inVerify = false);
+
+	//! @brief Writes a block of consecutive registers, split into writes of 32 bytes
+	//! @param inVerify reads the block back and returns ErrInvalidState if it differs
+	EGAVResult WriteI2cBlock(uint8_t inI2CAddress, uint8_t inStartRegister, const uint8_t* inData, size_t inLength, bool inVerify = false);
+
+	//! @brief Every info frame read by GetHDMIHDRStatusPacket() is appended to the journal (nullptr to disable).
+	//! Other info frame types (GetHDMIInfoFrame()) are not journaled.
+	void SetInfoFrameJournal(std::shared_ptr<HDMIInfoFrameJournalWriter> inJournal);
+
+	//! @brief Serializes the I2C transactions with other processes using the same device (see EGAVProcessLock.h).
+	//! Each read (write request + read) or write holds the lock only for that transaction.
+	//! @param inLockDirectory POSIX: directory of the lock file (default: EGAV_PROCESS_LOCK_DIRECTORY, /run/egav)
+	EGAVResult EnableProcessLock(const std::string& inLockDirectory = std::string());
+	void DisableProcessLock();
+
+	//! @return contention metrics of the process lock (all zero if it is disabled)
+	EGAVProcessLockStatistics GetProcessLockStatistics();
+
 
 private:
 	EGAVResult WriteI2cData(uint8_t inI2CAddress, uint8_t inRegister, uint8_t* inData, uint8_t inLength);
 	EGAVResult ReadI2cData(uint8_t inI2CAddress, uint8_t inRegister, uint8_t* outData, uint8_t inLength);
+	EGAVResult ReadInfoFrameRegister(uint8_t inRegister, HDMI_GENERIC_INFOFRAME& outFrame);
 
-	bool mNewDeviceType = false; //!< true: HD60 X and newer devices , false: HD60 S+
+	EGAVResult WriteAndVerify(uint8_t inI2CAddress, uint8_t inRegister, const uint8_t* inData, uint8_t inLength);
 
-	std::shared_ptr<EGAVHIDInterface> mHIDImpl;
+	std::shared_ptr<EGAVHIDInterface> mHID; //!< reopened by ReopenHIDInterface()
+	std::unique_ptr<ElgatoUVCDeviceCore> mCore; //!< LegacyProtocol: HD60 S+, NewProtocol: HD60 X and newer devices
 	std::recursive_mutex mHIDMutex;
+
+	const EGAVDeviceID mDeviceID;
+	const ElgatoUVCQuirks mQuirks;
+	std::unique_ptr<EGAVProcessLock> mProcessLock; //!< protected by mHIDMutex
+
+	std::shared_ptr<HDMIInfoFrameJournalWriter> mJournal;
+	bool mJournalFailed = false; //!< last append failed; protected by mHIDMutex
+
+	std::shared_ptr<const HDMIEDID> mEDIDCache; //!< protected by mHIDMutex
+	std::map<uint8_t, uint8_t> mInfoFrameRegisters; //!< HDMI_INFOFRAME_TYPE_* --> MCU register; protected by mHIDMutex
+
+	//! @brief Last value written to a register
+	struct ShadowRegister
+	{
+		std::array<uint8_t, MAX_COMM_WRITE_BUFFER_SIZE> value{};
+		uint8_t	length	= 0;
+		bool	dirty	= true;	//!< not confirmed by the device (write failed)
+	};
+	std::map<uint16_t, ShadowRegister> mShadowRegisters; //!< key: I2C address << 8 | register; protected by mHIDMutex
+	bool mVerifyWrites = false;
+	int mWriteRetries = 2;
 };
@@ -0,0 +1,299 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		ElgatoUVCProtocol.h
+
+@brief		I2C over HID protocols of the Elgato UVC devices.
+
+			LegacyProtocol (HD60 S+) and NewProtocol (HD60 X and newer chipsets) build
+			their messages with constexpr functions into caller buffers of
+			kMaxRequestSize bytes; the same builders produce the golden reports
+			checked at compile time.
+			ElgatoUVCDeviceT<Protocol> runs the I2C transactions without any runtime
+			protocol checks; ElgatoUVCDevice selects one of them at construction.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "EGAVResult.h"
+#include "EGAVHID.h"
+
+
+const int I2C_BUFFER_HEADER_SIZE	=  4;
+const int MAX_COMM_READ_BUFFER_SIZE	= 32;
+const int MAX_COMM_WRITE_BUFFER_SIZE	= 32;
+
+enum class I2CAddress
+{
+	MCU					= 0x55,
+	EDID				= 0x50,	//!< DDC address of the EDID presented to the HDMI source
+};
+
+//! @brief I2C registers for MCU (I2C address 0x55).
+enum class MCU_I2C_REGISTER
+{
+	GET_HDR_PACKET		= 0x09, //!< HDR capable devices (HD60 S+, HD60 X)
+	XET_HDR_TONEMAPPING	= 0x0A, //!< HDR capable devices (HD60 S+, HD60 X): Enable hardware tonemapping; param 0/1 (uint8_t)
+};
+
+
+//==============================================================================
+// # Protocols
+//==============================================================================
+
+//! @brief HD60 S+: separate report IDs for read request, read response and write
+struct LegacyProtocol
+{
+	//! @brief HDI report IDs for original device type. Can also be queried via HidP_GetValueCaps()
+	enum class HID_REPORT_ID
+	{
+		I2C_READ_SET_ID = 9,
+		I2C_READ_GET_ID = 10,
+		I2C_WRITE_ID = 11
+	};
+
+	static constexpr int kReadRequestReportID	= (int)HID_REPORT_ID::I2C_READ_SET_ID;
+	static constexpr int kReadResponseReportID	= (int)HID_REPORT_ID::I2C_READ_GET_ID;
+	static constexpr int kReadResponseSize		= 0;	//!< ReadHID() buffer size: default input report length
+	static constexpr int kWriteReportID			= (int)HID_REPORT_ID::I2C_WRITE_ID;
+	static constexpr size_t kReadRequestSize	= 3;
+	static constexpr size_t kWriteHeaderSize	= 3;
+	static constexpr size_t kMaxRequestSize		= kWriteHeaderSize + MAX_COMM_WRITE_BUFFER_SIZE;
+
+	//! @brief [address, register, length]
+	//! @param outMessage kMaxRequestSize bytes
+	//! @return message length
+	static constexpr size_t BuildReadRequest(uint8_t inI2CAddress, uint8_t inRegister, uint8_t inLength, uint8_t* outMessage)
+	{
+		outMessage[0] = inI2CAddress;
+		outMessage[1] = inRegister;
+		outMessage[2] = inLength;
+		return kReadRequestSize;
+	}
+
+	//! @brief [address, register, length, data...]
+	//! @param inLength up to MAX_COMM_WRITE_BUFFER_SIZE
+	//! @param outMessage kMaxRequestSize bytes
+	//! @return message length
+	static constexpr size_t BuildWriteRequest(uint8_t inI2CAddress, uint8_t inRegister, const uint8_t* inData, uint8_t inLength, uint8_t* outMessage)
+	{
+		outMessage[0] = inI2CAddress;
+		outMessage[1] = inRegister;
+		outMessage[2] = inLength;
+		for (size_t i = 0; i < inLength; i++)
+			outMessage[kWriteHeaderSize + i] = inData[i];
+		return kWriteHeaderSize + inLength;
+	}
+
+	static void PrepareReadResponse(std::vector<uint8_t>& outMessage) { outMessage.assign(I2C_BUFFER_HEADER_SIZE + MAX_COMM_READ_BUFFER_SIZE, 0); }
+
+	//! @brief The data starts at the first byte
+	static void ParseReadResponse(const uint8_t* inMessage, size_t inSize, uint8_t* outData, uint8_t inLength)
+	{
+		memcpy(outData, inMessage, std::min((size_t)inLength, inSize));
+	}
+};
+
+//! @brief HD60 X and newer: one output report ID, the report case is part of the message
+struct NewProtocol
+{
+	//! @brief HID report case for new device type.
+	enum class REPORT_CASE_NEW
+	{
+		REPORT_IIC_WRITE = 6,
+		REPORT_IIC_READ = 7
+	};
+
+	//! @brief HID report IDs for new device type. Can also be queried via HidP_GetValueCaps()
+	enum class HID_REPORT_ID_NEW
+	{
+		I2C_READ = 5,
+		I2C_WRITE = 6
+	};
+
+	static constexpr int kReadRequestReportID	= (int)HID_REPORT_ID_NEW::I2C_WRITE;
+	static constexpr int kReadResponseReportID	= (int)HID_REPORT_ID_NEW::I2C_READ;
+	static constexpr int kReadResponseSize		= 0xFF | ((int)REPORT_CASE_NEW::REPORT_IIC_READ << 8); //!< report case is coded into report length
+	static constexpr int kWriteReportID			= (int)HID_REPORT_ID_NEW::I2C_WRITE;
+	static constexpr size_t kReadRequestSize	= 6;
+	static constexpr size_t kWriteHeaderSize	= 5;
+	static constexpr size_t kMaxRequestSize		= kWriteHeaderSize + MAX_COMM_WRITE_BUFFER_SIZE;
+
+	//! @brief [report length, case, address, write length, register, read length]
+	//! @param outMessage kMaxRequestSize bytes
+	//! @return message length
+	static constexpr size_t BuildReadRequest(uint8_t inI2CAddress, uint8_t inRegister, uint8_t inLength, uint8_t* outMessage)
+	{
+		const uint8_t writeLen = 1 /* +1 for byte register address*/;
+		outMessage[0] = (uint8_t)(4 + writeLen + 1);
+		outMessage[1] = (uint8_t)REPORT_CASE_NEW::REPORT_IIC_READ;
+		outMessage[2] = inI2CAddress;
+		outMessage[3] = writeLen;
+		outMessage[4] = inRegister;
+		outMessage[5] = inLength;
+		return kReadRequestSize;
+	}
+
+	//! @brief [report length, case, address, write length, register, data...]
+	//! @param inLength up to MAX_COMM_WRITE_BUFFER_SIZE
+	//! @param outMessage kMaxRequestSize bytes
+	//! @return message length
+	static constexpr size_t BuildWriteRequest(uint8_t inI2CAddress, uint8_t inRegister, const uint8_t* inData, uint8_t inLength, uint8_t* outMessage)
+	{
+		const uint8_t writeLen = (uint8_t)(1 + inLength) /* +1 for byte register address*/;
+		outMessage[0] = (uint8_t)(4 + writeLen);
+		outMessage[1] = (uint8_t)REPORT_CASE_NEW::REPORT_IIC_WRITE;
+		outMessage[2] = inI2CAddress;
+		outMessage[3] = writeLen;
+		outMessage[4] = inRegister;
+		for (size_t i = 0; i < inLength; i++)
+			outMessage[kWriteHeaderSize + i] = inData[i];
+		return kWriteHeaderSize + inLength;
+	}
+
+	static void PrepareReadResponse(std::vector<uint8_t>& outMessage) { outMessage.clear(); }
+
+	//! @brief The data follows the report case byte
+	static void ParseReadResponse(const uint8_t* inMessage, size_t inSize, uint8_t* outData, uint8_t inLength)
+	{
+		if (inSize > 1)
+			memcpy(outData, inMessage + 1, std::min((size_t)inLength, inSize - 1));
+	}
+};
+
+
+//==============================================================================
+// # Golden reports (checked at compile time)
+//==============================================================================
+
+//! @brief Builds a request with the runtime builders at compile time and compares it with the expected bytes
+template <class Protocol, size_t N, size_t M>
+constexpr bool EGAV_RequestEquals(bool inRead, uint8_t inI2CAddress, uint8_t inRegister, uint8_t inReadLength,
+								  const uint8_t (&inData)[N], const uint8_t (&inExpected)[M])
+{
+	uint8_t message[Protocol::kMaxRequestSize] = {};
+	const size_t size = inRead ? Protocol::BuildReadRequest(inI2CAddress, inRegister, inReadLength, message)
+							   : Protocol::BuildWriteRequest(inI2CAddress, inRegister, inData, (uint8_t)N, message);
+	if (size != M)
+		return false;
+	for (size_t i = 0; i < M; i++)
+		if (message[i] != inExpected[i])
+			return false;
+	return true;
+}
+
+static_assert(EGAV_RequestEquals<LegacyProtocol>(true,  0x55, 0x09, 33, { 0 },    { 0x55, 0x09, 33 }), "legacy read request");
+static_assert(EGAV_RequestEquals<LegacyProtocol>(false, 0x55, 0x0A, 0,  { 1 },    { 0x55, 0x0A, 1, 1 }), "legacy write request");
+static_assert(EGAV_RequestEquals<LegacyProtocol>(false, 0x50, 0x10, 0,  { 7, 8 }, { 0x50, 0x10, 2, 7, 8 }), "legacy write request");
+static_assert(EGAV_RequestEquals<NewProtocol>(true,  0x55, 0x09, 32, { 0 },    { 6, 7, 0x55, 1, 0x09, 32 }), "new read request");
+static_assert(EGAV_RequestEquals<NewProtocol>(false, 0x55, 0x0A, 0,  { 1 },    { 6, 6, 0x55, 2, 0x0A, 1 }), "new write request");
+static_assert(EGAV_RequestEquals<NewProtocol>(false, 0x50, 0x10, 0,  { 7, 8 }, { 7, 6, 0x50, 3, 0x10, 7, 8 }), "new write request");
+
+
+//==============================================================================
+// # Class ElgatoUVCDeviceCore
+//==============================================================================
+
+//! @brief Protocol independent I2C access (implemented by ElgatoUVCDeviceT)
+class ElgatoUVCDeviceCore
+{
+public:
+	virtual ~ElgatoUVCDeviceCore() {}
+
+	//! @param inLength up to MAX_COMM_READ_BUFFER_SIZE (33 for the legacy info frame registers)
+	virtual EGAVResult ReadI2cData(uint8_t inI2CAddress, uint8_t inRegister, uint8_t* outData, uint8_t inLength) = 0;
+	virtual EGAVResult WriteI2cData(uint8_t inI2CAddress, uint8_t inRegister, const uint8_t* inData, uint8_t inLength) = 0;
+	virtual bool IsNewProtocol() const = 0;
+};
+
+
+//==============================================================================
+// # Class ElgatoUVCDeviceT
+//==============================================================================
+
+//! @brief I2C transactions for one protocol. Not thread safe: ElgatoUVCDevice serializes the calls.
+template <class Protocol>
+class ElgatoUVCDeviceT : public ElgatoUVCDeviceCore
+{
+public:
+	explicit ElgatoUVCDeviceT(std::shared_ptr<EGAVHIDInterface> inHID) : mHIDImpl(std::move(inHID)) {}
+
+	EGAVResult ReadI2cData(uint8_t inI2CAddress, uint8_t inRegister, uint8_t* outData, uint8_t inLength) override
+	{
+		EGAVResult_CheckPointer(outData);
+		EGAVResult_CheckPointer(mHIDImpl);
+
+		uint8_t message[Protocol::kMaxRequestSize];
+		const size_t size = Protocol::BuildReadRequest(inI2CAddress, inRegister, inLength, message);
+		mRequest.assign(message, message + size);
+		EGAVResult res = mHIDImpl->WriteHID(mRequest, Protocol::kReadRequestReportID);
+		if (res.Failed())
+		{
+			error_printf("WriteHID() FAILED for I2C address 0x%02x, register 0x%02x", inI2CAddress, inRegister);
+			return res;
+		}
+
+		Protocol::PrepareReadResponse(mResponse);
+		res = mHIDImpl->ReadHID(mResponse, Protocol::kReadResponseReportID, Protocol::kReadResponseSize);
+		if (res.Failed())
+			error_printf("ReadHID() FAILED for I2C address 0x%02x, register 0x%02x", inI2CAddress, inRegister);
+		else
+			Protocol::ParseReadResponse(mResponse.data(), mResponse.size(), outData, inLength);
+		return res;
+	}
+
+	EGAVResult WriteI2cData(uint8_t inI2CAddress, uint8_t inRegister, const uint8_t* inData, uint8_t inLength) override
+	{
+		EGAVResult_CheckPointer(inData);
+		EGAVResult_CheckPointer(mHIDImpl);
+
+		uint8_t message[Protocol::kMaxRequestSize];
+		const size_t size = Protocol::BuildWriteRequest(inI2CAddress, inRegister, inData, inLength, message);
+		mRequest.assign(message, message + size);
+		EGAVResult res = mHIDImpl->WriteHID(mRequest, Protocol::kWriteReportID);
+		if (res.Failed())
+			error_printf("WriteHID() FAILED for I2C address 0x%02x, register 0x%02x", inI2CAddress, inRegister);
+		return res;
+	}
+
+	bool IsNewProtocol() const override { return std::is_same<Protocol, NewProtocol>::value; }
+
+private:
+	std::shared_ptr<EGAVHIDInterface> mHIDImpl;
+
+	// Reused report buffers (no allocation per transaction). The messages are built on the stack; EGAVHIDInterface
+	// takes a std::vector, so they are copied into mRequest once (the hidraw paths send the stack buffer as is).
+	std::vector<uint8_t> mRequest;
+	std::vector<uint8_t> mResponse;
+};
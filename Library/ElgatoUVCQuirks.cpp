@@ -0,0 +1,169 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		ElgatoUVCQuirks.cpp
+
+@brief		Device and firmware specific fixups for ElgatoUVCDevice
+**/
+//==============================================================================
+
+#include "ElgatoUVCQuirks.h"
+
+#include <cstdio>
+
+
+//==============================================================================
+// # Supported devices
+//==============================================================================
+
+std::vector<EGAVDeviceID> GetElgatoUVCDeviceIDs()
+{
+	std::vector<EGAVDeviceID> devices {deviceIDHD60SPlus, deviceIDHD60X, deviceIDHD60XRev2 };
+	// EXTEND_DEVICES
+	return devices;
+}
+
+//! @return true for new USB chipset
+bool IsNewDeviceType(const EGAVDeviceID& inDeviceID) { return (inDeviceID != deviceIDHD60SPlus); }
+
+
+//==============================================================================
+// # EGAVFirmwareVersion
+//==============================================================================
+
+bool EGAVFirmwareVersion::FromString(const std::string& inString, EGAVFirmwareVersion& outVersion)
+{
+	int major = 0, minor = 0, patch = 0;
+	if (sscanf(inString.c_str(), "%d.%d.%d", &major, &minor, &patch) != 3)
+		return false;
+	outVersion = EGAVFirmwareVersion(major, minor, patch);
+	return true;
+}
+
+std::string EGAVFirmwareVersion::ToString() const
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%02d.%02d.%02d", major, minor, patch);
+	return buffer;
+}
+
+int EGAVFirmwareVersion::Compare(const EGAVFirmwareVersion& inOther) const
+{
+	if (major != inOther.major) return (major < inOther.major) ? -1 : 1;
+	if (minor != inOther.minor) return (minor < inOther.minor) ? -1 : 1;
+	if (patch != inOther.patch) return (patch < inOther.patch) ? -1 : 1;
+	return 0;
+}
+
+
+//==============================================================================
+// # Fixups
+//==============================================================================
+
+void EGAV_FixInfoFramePayloadLength(HDMI_GENERIC_INFOFRAME& ioFrame)
+{
+	// Seen with HDR and SPD info frames: the length is too large, the payload itself is fine
+	if (ioFrame.header.bPayloadLength <= HDMI_MAX_INFOFRAME_PAYLOAD)
+		return;
+
+	int payloadSize = 0;
+	if (HDMI_INFOFRAME_TYPE_DR == ioFrame.header.bfType)
+		payloadSize = sizeof(ioFrame.plDR1);
+	else if (HDMI_INFOFRAME_TYPE_SPD == ioFrame.header.bfType)
+		payloadSize = sizeof(ioFrame.plSPD1);
+
+	if (payloadSize)
+	{
+		int diff = ioFrame.header.bPayloadLength - payloadSize;
+		ioFrame.header.bPayloadLength = payloadSize;
+		ioFrame.bChecksum += diff;
+	}
+}
+
+
+//==============================================================================
+// # Quirk table
+//==============================================================================
+
+namespace
+{
+	struct QuirkEntry
+	{
+		const EGAVDeviceID*		deviceID;
+		EGAVFirmwareVersion		minFirmware;	//!< 0.0.0: no lower bound
+		EGAVFirmwareVersion		maxFirmware;	//!< 0.0.0: no upper bound
+		uint32_t				quirks;
+	};
+
+	// All matching entries are combined
+	const QuirkEntry kQuirkTable[] =
+	{
+		{ &deviceIDHD60SPlus,	{},	{},				EGAV_QUIRK_INFOFRAME_LEGACY_BUFFER | EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH },
+		{ &deviceIDHD60X,		{},	{ 22, 3, 24 },	EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH },	// FW 22.03.24 (MCU 22.03.16)
+		// EXTEND_QUIRKS
+	};
+
+	bool Matches(const QuirkEntry& inEntry, const EGAVDeviceID& inDeviceID, const EGAVFirmwareVersion& inFirmware)
+	{
+		if (!inEntry.deviceID->Equals(inDeviceID, true))
+			return false;
+		if (!inFirmware.IsKnown())
+			return true;
+		if (inEntry.minFirmware.IsKnown() && inFirmware.Compare(inEntry.minFirmware) < 0)
+			return false;
+		if (inEntry.maxFirmware.IsKnown() && inFirmware.Compare(inEntry.maxFirmware) > 0)
+			return false;
+		return true;
+	}
+}
+
+ElgatoUVCQuirks ResolveElgatoUVCQuirks(const EGAVDeviceID& inDeviceID, const EGAVFirmwareVersion& inFirmware)
+{
+	uint32_t quirks = 0;
+	bool known = false;
+	for (const QuirkEntry& entry : kQuirkTable)
+	{
+		known = known || entry.deviceID->Equals(inDeviceID, true);
+		if (Matches(entry, inDeviceID, inFirmware))
+			quirks |= entry.quirks;
+	}
+
+	// No table entry (e.g. HD60 X Rev. 2, or a device added to GetElgatoUVCDeviceIDs() only): nothing is known
+	// about its firmware, so it gets the conservative fixups
+	if (!known)
+		quirks = EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH; // harmless for valid frames
+
+	ElgatoUVCQuirks result;
+	result.quirks = quirks;
+	if (quirks & EGAV_QUIRK_INFOFRAME_LEGACY_BUFFER)
+	{
+		result.infoFrameReadSize = 33;
+		result.infoFrameOffset   = 1;
+	}
+	if (quirks & EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH)
+		result.infoFrameFixups[result.infoFrameFixupCount++] = EGAV_FixInfoFramePayloadLength;
+	return result;
+}
@@ -0,0 +1,120 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		ElgatoUVCQuirks.h
+
+@brief		Device and firmware specific fixups for ElgatoUVCDevice.
+
+			The quirk table maps device ID and firmware version ranges to fixups.
+			It is resolved once when the device is opened into a flat list of
+			function pointers, so the read path doesn't branch on the device type.
+
+			The firmware version can't be read over the I2C interface. Integrators
+			who know it (e.g. from Elgato's update tool) pass it to the
+			ElgatoUVCDevice constructor; without it all firmware specific quirks of
+			the device apply, which only costs the fixups on frames that are valid.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "EGAVDevice.h"
+#include "HDMIInfoFramesAPI.h"
+
+
+// Supported devices
+inline const EGAVDeviceID deviceIDHD60SPlus (EGAVBusType::USB, 0x0FD9, 0x006A); //!< HD60 S+
+inline const EGAVDeviceID deviceIDHD60X     (EGAVBusType::USB, 0x0FD9, 0x0082); //!< HD60 X
+inline const EGAVDeviceID deviceIDHD60XRev2 (EGAVBusType::USB, 0x0FD9, 0x008A); //!< HD60 X Rev. 2
+// EXTEND_DEVICES
+
+
+//! @return Device IDs of supported Elgato UVC devices
+std::vector<EGAVDeviceID> GetElgatoUVCDeviceIDs();
+
+
+//! @return true for new devices with new USB chipset
+bool IsNewDeviceType(const EGAVDeviceID& inDeviceID);
+
+
+//! @brief Firmware version as shown by Elgato tools, e.g. 22.03.24 (0.0.0: unknown)
+struct EGAVFirmwareVersion
+{
+	EGAVFirmwareVersion() {}
+	EGAVFirmwareVersion(int inMajor, int inMinor, int inPatch) : major(inMajor), minor(inMinor), patch(inPatch) {}
+
+	int		major	= 0;
+	int		minor	= 0;
+	int		patch	= 0;
+
+	bool IsKnown() const { return major || minor || patch; }
+
+	//! @brief Parses "22.03.24"
+	static bool FromString(const std::string& inString, EGAVFirmwareVersion& outVersion);
+	std::string ToString() const;
+
+	int Compare(const EGAVFirmwareVersion& inOther) const;
+	bool operator == (const EGAVFirmwareVersion& inOther) const { return Compare(inOther) == 0; }
+	bool operator <= (const EGAVFirmwareVersion& inOther) const { return Compare(inOther) <= 0; }
+};
+
+
+// Quirks (bit mask)
+#define EGAV_QUIRK_INFOFRAME_LEGACY_BUFFER		0x0001	// info frame registers deliver 33 bytes, the frame starts at offset 1 (HD60 S+)
+#define EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH		0x0002	// invalid payload length in DR and SPD info frames
+
+
+//! @brief Fixup applied to every info frame read from the device
+typedef void (*EGAVInfoFrameFixup)(HDMI_GENERIC_INFOFRAME& ioFrame);
+
+//! @brief Resolved quirks of one device
+struct ElgatoUVCQuirks
+{
+	static const int kMaxFixups = 4;
+
+	uint32_t			quirks					= 0;	//!< EGAV_QUIRK_*
+	uint8_t				infoFrameReadSize		= 32;	//!< bytes to read from an info frame register
+	uint8_t				infoFrameOffset			= 0;	//!< offset of the info frame in the register data
+	EGAVInfoFrameFixup	infoFrameFixups[kMaxFixups] = {};
+	int					infoFrameFixupCount		= 0;
+
+	void ApplyInfoFrameFixups(HDMI_GENERIC_INFOFRAME& ioFrame) const
+	{
+		for (int i = 0; i < infoFrameFixupCount; i++)
+			infoFrameFixups[i](ioFrame);
+	}
+};
+
+//! @brief Looks up the quirks for a device; an unknown firmware version counts as affected by all firmware specific quirks
+//! Devices without a quirk table entry (listed in GetElgatoUVCDeviceIDs() or not) get the conservative fixups.
+ElgatoUVCQuirks ResolveElgatoUVCQuirks(const EGAVDeviceID& inDeviceID, const EGAVFirmwareVersion& inFirmware);
+
+//! @brief Fixup for EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH (exposed for tests)
+void EGAV_FixInfoFramePayloadLength(HDMI_GENERIC_INFOFRAME& ioFrame);
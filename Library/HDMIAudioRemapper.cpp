@@ -0,0 +1,193 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIAudioRemapper.cpp
+
+@brief		Reorders interleaved HDMI PCM to the canonical channel order
+**/
+//==============================================================================
+
+#include "HDMIAudioRemapper.h"
+#include "EGAVCPUFeatures.h"
+
+#include <cstring>
+
+
+//==============================================================================
+// # Kernels
+//==============================================================================
+
+#if EGAV_X86
+
+//! @brief Byte shuffle of 32 byte windows: out = pshufb(inLo, lo) | pshufb(inHi, hi) per 16 byte half
+EGAV_TARGET_SSSE3 static size_t RemapSSSE3(const uint8_t* inPCM, uint8_t* outPCM, size_t inFrames,
+										   size_t inFrameBytes, size_t outFrameBytes, int inGroupFrames,
+										   const uint8_t* inShuffleLo, const uint8_t* inShuffleHi)
+{
+	const __m128i lo0 = _mm_loadu_si128((const __m128i*)inShuffleLo);
+	const __m128i lo1 = _mm_loadu_si128((const __m128i*)(inShuffleLo + 16));
+	const __m128i hi0 = _mm_loadu_si128((const __m128i*)inShuffleHi);
+	const __m128i hi1 = _mm_loadu_si128((const __m128i*)(inShuffleHi + 16));
+
+	// The 32 byte loads and stores must stay inside the buffers, the rest is done by the caller
+	const size_t inBytes = inFrames * inFrameBytes, outBytes = inFrames * outFrameBytes;
+	size_t f = 0;
+	for (; f * inFrameBytes + 32 <= inBytes && f * outFrameBytes + 32 <= outBytes; f += inGroupFrames)
+	{
+		const __m128i a = _mm_loadu_si128((const __m128i*)(inPCM + f * inFrameBytes));
+		const __m128i b = _mm_loadu_si128((const __m128i*)(inPCM + f * inFrameBytes + 16));
+		uint8_t* out = outPCM + f * outFrameBytes;
+		_mm_storeu_si128((__m128i*)out, _mm_or_si128(_mm_shuffle_epi8(a, lo0), _mm_shuffle_epi8(b, hi0)));
+		_mm_storeu_si128((__m128i*)(out + 16), _mm_or_si128(_mm_shuffle_epi8(a, lo1), _mm_shuffle_epi8(b, hi1)));
+	}
+	return f;
+}
+
+//! @brief 32 bit samples: one cross-lane dword permutation per 32 byte window
+EGAV_TARGET_AVX2 static size_t RemapAVX2(const uint8_t* inPCM, uint8_t* outPCM, size_t inFrames,
+										 size_t inFrameBytes, size_t outFrameBytes, int inGroupFrames, const uint32_t* inPermute)
+{
+	const __m256i permute = _mm256_loadu_si256((const __m256i*)inPermute);
+
+	const size_t inBytes = inFrames * inFrameBytes, outBytes = inFrames * outFrameBytes;
+	size_t f = 0;
+	for (; f * inFrameBytes + 32 <= inBytes && f * outFrameBytes + 32 <= outBytes; f += inGroupFrames)
+	{
+		const __m256i v = _mm256_loadu_si256((const __m256i*)(inPCM + f * inFrameBytes));
+		_mm256_storeu_si256((__m256i*)(outPCM + f * outFrameBytes), _mm256_permutevar8x32_epi32(v, permute));
+	}
+	return f;
+}
+
+#endif // EGAV_X86
+
+
+//==============================================================================
+// # Class HDMIAudioRemapper
+//==============================================================================
+
+HDMIAudioRemapper::HDMIAudioRemapper()
+{
+	HDMI_AUDIO_INFO stereo;
+	Setup(stereo, 2);
+}
+
+EGAVResult HDMIAudioRemapper::Setup(const HDMI_AUDIO_INFO& inInfo, int inBytesPerSample)
+{
+	if (inBytesPerSample < 2 || inBytesPerSample > 4 || inInfo.slotCount < 1 || inInfo.slotCount > HDMI_A_MAX_CHANNELS)
+		return EGAVResult::ErrInvalidParameter;
+
+	// Canonical order: ascending speaker bits; slots without a speaker are dropped
+	int count = 0;
+	for (int bit = 0; bit < 32; bit++)
+	{
+		const uint32_t speaker = 1u << bit;
+		for (int slot = 0; slot < inInfo.slotCount; slot++)
+		{
+			if (inInfo.slotSpeakers[slot] == speaker)
+			{
+				mSourceSlot[count++] = (uint8_t)slot;
+				break;
+			}
+		}
+	}
+	if (count == 0)
+		return EGAVResult::ErrInvalidParameter;
+
+	mBytesPerSample = inBytesPerSample;
+	mInChannels     = inInfo.slotCount;
+	mOutChannels    = count;
+	mSpeakerMask    = 0;
+	mIdentity       = (mInChannels == mOutChannels);
+	for (int ch = 0; ch < count; ch++)
+	{
+		mSpeakerMask |= inInfo.slotSpeakers[mSourceSlot[ch]];
+		mIdentity = mIdentity && (mSourceSlot[ch] == ch);
+	}
+
+	// Byte shuffle masks for as many whole frames as fit into 32 bytes (0x80: zero)
+	const int inFrameBytes  = mInChannels * mBytesPerSample;
+	const int outFrameBytes = mOutChannels * mBytesPerSample;
+	mGroupFrames = 32 / inFrameBytes;
+	for (int i = 0; i < 32; i++)
+	{
+		mShuffleLo[i] = mShuffleHi[i] = 0x80;
+		if (i >= mGroupFrames * outFrameBytes)
+			continue;
+		const int frame = i / outFrameBytes, sample = (i % outFrameBytes) / mBytesPerSample, byte = i % mBytesPerSample;
+		const int src = frame * inFrameBytes + mSourceSlot[sample] * mBytesPerSample + byte;
+		if (src < 16)
+			mShuffleLo[i] = (uint8_t)src;
+		else
+			mShuffleHi[i] = (uint8_t)(src - 16);
+	}
+	for (int i = 0; i < 8; i++)
+	{
+		const int frame = i / mOutChannels;
+		mPermute[i] = (frame < mGroupFrames) ? (uint32_t)(frame * mInChannels + mSourceSlot[i % mOutChannels]) : 0;
+	}
+	return EGAVResult::Ok;
+}
+
+void HDMIAudioRemapper::ProcessScalar(const uint8_t* inPCM, uint8_t* outPCM, size_t inFrames) const
+{
+	const size_t inFrameBytes  = (size_t)mInChannels * mBytesPerSample;
+	const size_t outFrameBytes = (size_t)mOutChannels * mBytesPerSample;
+	for (size_t f = 0; f < inFrames; f++)
+	{
+		const uint8_t* in = inPCM + f * inFrameBytes;
+		uint8_t* out = outPCM + f * outFrameBytes;
+		for (int ch = 0; ch < mOutChannels; ch++)
+			memcpy(out + ch * mBytesPerSample, in + mSourceSlot[ch] * mBytesPerSample, mBytesPerSample);
+	}
+}
+
+EGAVResult HDMIAudioRemapper::Process(const uint8_t* inPCM, uint8_t* outPCM, size_t inFrames) const
+{
+	EGAVResult_CheckPointer(inPCM);
+	EGAVResult_CheckPointer(outPCM);
+
+	const size_t inFrameBytes  = (size_t)mInChannels * mBytesPerSample;
+	const size_t outFrameBytes = (size_t)mOutChannels * mBytesPerSample;
+	if (mIdentity)
+	{
+		memcpy(outPCM, inPCM, inFrames * inFrameBytes);
+		return EGAVResult::Ok;
+	}
+
+	size_t done = 0;
+#if EGAV_X86
+	if (mSIMDEnabled)
+	{
+		if (mBytesPerSample == 4 && EGAV_CPUHasAVX2())
+			done = RemapAVX2(inPCM, outPCM, inFrames, inFrameBytes, outFrameBytes, mGroupFrames, mPermute);
+		else if (EGAV_CPUHasSSSE3())
+			done = RemapSSSE3(inPCM, outPCM, inFrames, inFrameBytes, outFrameBytes, mGroupFrames, mShuffleLo, mShuffleHi);
+	}
+#endif
+	ProcessScalar(inPCM + done * inFrameBytes, outPCM + done * outFrameBytes, inFrames - done);
+	return EGAVResult::Ok;
+}
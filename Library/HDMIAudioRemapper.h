@@ -0,0 +1,91 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIAudioRemapper.h
+
+@brief		Reorders interleaved HDMI PCM to the canonical channel order.
+
+			HDMI transmits the channels in the slot order of the CEA-861 channel
+			allocation (e.g. 5.1: FL FR LFE FC RL RR), audio APIs expect ascending
+			speaker bits (FL FR FC LFE SL SR, see HDMI_A_SPEAKER_*). Unused slots are
+			dropped. 16, 24 and 32 bit samples, up to 8 channels (SSSE3/AVX2, scalar fallback).
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EGAVResult.h"
+#include "HDMIInfoFramesAPI.h"
+
+
+//==============================================================================
+// # Class HDMIAudioRemapper
+//==============================================================================
+
+class HDMIAudioRemapper
+{
+public:
+	HDMIAudioRemapper();
+
+	//! @brief Prepares the channel map for the speaker layout of the audio info frame
+	//! @param inBytesPerSample 2, 3 (packed 24 bit) or 4
+	EGAVResult Setup(const HDMI_AUDIO_INFO& inInfo, int inBytesPerSample);
+
+	//! @brief Reorders inFrames sample frames; input and output must not overlap
+	//! @param inPCM GetInputChannels() interleaved channels in slot order
+	//! @param outPCM GetOutputChannels() interleaved channels in canonical order
+	EGAVResult Process(const uint8_t* inPCM, uint8_t* outPCM, size_t inFrames) const;
+
+	//! @brief Forces the scalar path (reference for the SIMD kernels)
+	void SetSIMDEnabled(bool inEnable) { mSIMDEnabled = inEnable; }
+
+	int GetInputChannels() const { return mInChannels; }
+	int GetOutputChannels() const { return mOutChannels; }
+	uint32_t GetSpeakerMask() const { return mSpeakerMask; }
+	bool IsIdentity() const { return mIdentity; }
+
+private:
+	void ProcessScalar(const uint8_t* inPCM, uint8_t* outPCM, size_t inFrames) const;
+
+	int			mBytesPerSample		= 2;
+	int			mInChannels			= 2;
+	int			mOutChannels		= 2;
+	uint32_t	mSpeakerMask		= HDMI_A_SPEAKER_FL | HDMI_A_SPEAKER_FR;
+	bool		mIdentity			= true;
+	bool		mSIMDEnabled		= true;
+
+	//! Input slot of each output channel
+	uint8_t		mSourceSlot[HDMI_A_MAX_CHANNELS] = {};
+
+	// SIMD: mGroupFrames frames per 32 byte window
+	int			mGroupFrames		= 1;
+	uint8_t		mShuffleLo[32]		= {};	//!< pshufb masks for output bytes 0..15 / 16..31 from input bytes 0..15
+	uint8_t		mShuffleHi[32]		= {};	//!< ... from input bytes 16..31
+	uint32_t	mPermute[8]			= {};	//!< vpermd indices (32 bit samples)
+};
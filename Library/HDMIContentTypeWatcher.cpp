@@ -0,0 +1,185 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIContentTypeWatcher.cpp
+
+@brief		Recommends a pipeline latency profile from the AVI IT content type
+**/
+//==============================================================================
+
+#include "HDMIContentTypeWatcher.h"
+#include "ElgatoUVCDevice.h"
+
+#include <chrono>
+
+
+static uint64_t GetTimestampUs()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//==============================================================================
+// # Class HDMIContentTypeWatcher
+//==============================================================================
+
+HDMIContentTypeWatcher::HDMIContentTypeWatcher(ElgatoUVCDevice& inDevice, ProfileCallback inCallback,
+	int inPollIntervalMs /*= kDefaultPollIntervalMs*/, int inDebounceCount /*= kDefaultDebounceCount*/)
+	: mDevice(inDevice), mCallback(inCallback), mPollIntervalMs(inPollIntervalMs > 0 ? inPollIntervalMs : 1), mDebounceCount(inDebounceCount > 0 ? inDebounceCount : 1)
+{
+}
+
+HDMIContentTypeWatcher::~HDMIContentTypeWatcher()
+{
+	Stop();
+}
+
+HDMILatencyProfile HDMIContentTypeWatcher::GetDefaultProfile(int inContentType)
+{
+	HDMILatencyProfile profile;
+	profile.contentType = inContentType;
+	switch (inContentType)
+	{
+		case HDMI_AVI_CN_GAME:		profile.queueDepth = 1; profile.encoderLookahead = 0;  break;
+		case HDMI_AVI_CN_GRAPHICS:	profile.queueDepth = 2; profile.encoderLookahead = 0;  break;
+		case HDMI_AVI_CN_PHOTO:		profile.queueDepth = 4; profile.encoderLookahead = 8;  break;
+		case HDMI_AVI_CN_CINEMA:	profile.queueDepth = 8; profile.encoderLookahead = 32; break;
+		default:					break; // no IT content: defaults
+	}
+	return profile;
+}
+
+HDMILatencyProfile HDMIContentTypeWatcher::GetCurrentProfile() const
+{
+	const std::lock_guard<std::mutex> lock(mMutex);
+	return mCurrent;
+}
+
+EGAVResult HDMIContentTypeWatcher::Start(int inAVIRegister /*= -1*/)
+{
+	Stop();
+
+	if (inAVIRegister >= 0)
+		mDevice.SetInfoFrameRegister(HDMI_INFOFRAME_TYPE_AVI, (uint8_t)inAVIRegister);
+
+	int contentType = HDMI_ERROR;
+	EGAVResult res = mDevice.GetHDMIContentType(contentType);
+	if (res == EGAVResult::ErrNotSupported)
+		return res;
+
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mStop           = false;
+		mPublished      = false;
+		mCurrent        = HDMILatencyProfile();
+		mCandidateCount = 0;
+	}
+
+	// Publish the initial profile right away (no debouncing); on I2C errors the thread debounces the first result
+	if (res.Succeeded())
+		PublishProfile(contentType, GetTimestampUs(), 0);
+	else if (res == EGAVResult::ErrNoData)
+		PublishProfile(HDMI_ERROR, GetTimestampUs(), 0);
+
+	mWorker = std::thread(&HDMIContentTypeWatcher::WorkerThread, this);
+	return EGAVResult::Ok;
+}
+
+void HDMIContentTypeWatcher::Stop()
+{
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mCondition.notify_all();
+	if (mWorker.joinable())
+		mWorker.join();
+}
+
+void HDMIContentTypeWatcher::ProcessContentType(int inContentType, uint64_t inTimestampUs)
+{
+	uint64_t latencyUs = 0;
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+
+		if (mPublished && inContentType == mCurrent.contentType)
+		{
+			mCandidateCount = 0; // glitch is over
+			mLastConfirmed  = inTimestampUs;
+			return;
+		}
+
+		if (mCandidateCount == 0 || inContentType != mCandidate)
+		{
+			mCandidate      = inContentType;
+			mCandidateCount = 0;
+			if (!mPublished)
+				mLastConfirmed = inTimestampUs; // nothing seen before: count from the first poll
+		}
+		if (++mCandidateCount < mDebounceCount)
+			return;
+
+		// The signal changed after the last poll that still saw the old content type
+		latencyUs = inTimestampUs - mLastConfirmed;
+	}
+
+	PublishProfile(inContentType, inTimestampUs, latencyUs);
+}
+
+void HDMIContentTypeWatcher::PublishProfile(int inContentType, uint64_t inTimestampUs, uint64_t inLatencyUs)
+{
+	HDMILatencyProfile profile;
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mCurrent        = GetDefaultProfile(inContentType);
+		mPublished      = true;
+		mCandidateCount = 0;
+		mLastConfirmed  = inTimestampUs;
+		profile         = mCurrent;
+	}
+
+	if (mCallback)
+		mCallback(profile, inLatencyUs);
+}
+
+void HDMIContentTypeWatcher::WorkerThread()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (!mCondition.wait_for(lock, std::chrono::milliseconds(mPollIntervalMs), [this] { return mStop; }))
+	{
+		lock.unlock();
+
+		int contentType = HDMI_ERROR;
+		EGAVResult res = mDevice.GetHDMIContentType(contentType);
+		if (res.Succeeded())
+			ProcessContentType(contentType, GetTimestampUs());
+		else if (res == EGAVResult::ErrNoData)
+			ProcessContentType(HDMI_ERROR, GetTimestampUs()); // no AVI info frame (e.g. no signal)
+		// other errors (I2C): keep the current profile
+
+		lock.lock();
+	}
+}
@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIContentTypeWatcher.h
+
+@brief		Recommends a pipeline latency profile from the AVI IT content type.
+
+			Polls ElgatoUVCDevice::GetHDMIContentType() on a background thread. A new
+			content type must be seen in inDebounceCount consecutive polls before the
+			profile callback fires (sources toggle CN briefly during mode changes).
+
+			The stock firmware has no register for the AVI info frame: map one with
+			ElgatoUVCDevice::SetInfoFrameRegister() (or Start(inAVIRegister)) first.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "EGAVResult.h"
+
+class ElgatoUVCDevice;
+
+
+//! @brief Buffering recommendation for capture/encode
+struct HDMILatencyProfile
+{
+	int		contentType			= -1;	//!< HDMI_AVI_CN_* or HDMI_ERROR (no IT content signaled)
+	int		queueDepth			= 4;	//!< frames buffered between capture and encoder
+	int		encoderLookahead	= 16;	//!< encoder lookahead in frames (0: disabled)
+};
+
+
+//==============================================================================
+// # Class HDMIContentTypeWatcher
+//==============================================================================
+
+class HDMIContentTypeWatcher
+{
+public:
+	//! inSwitchLatencyUs: time from the last poll that still saw the previous content type to the
+	//! callback, i.e. an upper bound of signal change --> publish (0 for the initial profile)
+	typedef std::function<void(const HDMILatencyProfile& inProfile, uint64_t inSwitchLatencyUs)> ProfileCallback;
+
+	static const int kDefaultPollIntervalMs	= 100;
+	static const int kDefaultDebounceCount	= 3;
+
+	HDMIContentTypeWatcher(ElgatoUVCDevice& inDevice, ProfileCallback inCallback,
+		int inPollIntervalMs = kDefaultPollIntervalMs, int inDebounceCount = kDefaultDebounceCount);
+	~HDMIContentTypeWatcher();
+
+	//! @brief Polls once synchronously (publishes the initial profile) and starts the background thread
+	//! @param inAVIRegister MCU register of the AVI info frame (-1: keep the device's mapping)
+	//! @return ErrNotSupported if no register is mapped for the AVI info frame
+	EGAVResult Start(int inAVIRegister = -1);
+	void Stop();
+
+	//! @brief Feeds one poll result (used by the thread; exposed for scripted sources)
+	void ProcessContentType(int inContentType, uint64_t inTimestampUs);
+
+	//! @return default profile for HDMI_AVI_CN_* (or HDMI_ERROR)
+	static HDMILatencyProfile GetDefaultProfile(int inContentType);
+
+	HDMILatencyProfile GetCurrentProfile() const;
+
+private:
+	void PublishProfile(int inContentType, uint64_t inTimestampUs, uint64_t inLatencyUs);
+	void WorkerThread();
+
+	ElgatoUVCDevice&			mDevice;
+	ProfileCallback				mCallback;
+	const int					mPollIntervalMs;
+	const int					mDebounceCount;
+
+	mutable std::mutex			mMutex;
+	std::condition_variable		mCondition;
+	std::thread					mWorker;
+	bool						mStop = false;
+
+	// Debouncing (mMutex)
+	bool						mPublished		= false;
+	HDMILatencyProfile			mCurrent;
+	int							mCandidate		= -1;
+	int							mCandidateCount	= 0;
+	uint64_t					mLastConfirmed	= 0;	//!< last poll that saw mCurrent.contentType
+};
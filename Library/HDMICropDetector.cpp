@@ -0,0 +1,269 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMICropDetector.cpp
+
+@brief		Active picture crop rectangle for letterboxed/pillarboxed video
+**/
+//==============================================================================
+
+#include "HDMICropDetector.h"
+#include "EGAVCPUFeatures.h"
+
+#include <algorithm>
+
+
+//==============================================================================
+// # Bar data
+//==============================================================================
+
+bool HDMICrop_GetBarDataRect(const HDMI_GENERIC_INFOFRAME& inAVI, int inWidth, int inHeight, EGAVCropRect& outRect)
+{
+	if (!HDMI_AVI_IsValid(inAVI) || HDMI_AVI_B_NODATA == inAVI.plAVI2.bfBarDataPresent || inWidth <= 0 || inHeight <= 0)
+		return false;
+
+	// Bar data is the same in AVI versions 2..4. ETB/ELB: last line/pixel of the top/left bar,
+	// SBB/SRB: first line/pixel of the bottom/right bar (1-based, 0: no bar)
+	const HDMI_AVI2_PAYLOAD& avi = inAVI.plAVI2;
+	int left = 0, top = 0, right = inWidth, bottom = inHeight;
+	if (avi.bfBarDataPresent & HDMI_AVI_B_H)
+	{
+		top    = avi.wLineNumberOfEndOfTopBar;
+		bottom = avi.wLineNumberOfStartOfBottomBar ? avi.wLineNumberOfStartOfBottomBar - 1 : inHeight;
+	}
+	if (avi.bfBarDataPresent & HDMI_AVI_B_V)
+	{
+		left  = avi.wPixelNumberOfEndOfLeftBar;
+		right = avi.wPixelNumberOfStartOfRightBar ? avi.wPixelNumberOfStartOfRightBar - 1 : inWidth;
+	}
+
+	left   = std::min(std::max(left, 0), inWidth);
+	top    = std::min(std::max(top, 0), inHeight);
+	right  = std::min(std::max(right, left), inWidth);
+	bottom = std::min(std::max(bottom, top), inHeight);
+	if (right <= left || bottom <= top)
+		return false; // inconsistent bar data
+
+	outRect.left   = left;
+	outRect.top    = top;
+	outRect.width  = right - left;
+	outRect.height = bottom - top;
+	return true;
+}
+
+EGAVCropRect HDMICrop_Align(const EGAVCropRect& inRect, int inWidth, int inHeight, int inAlignment)
+{
+	const int a = std::max(inAlignment, 2); // at least 2 for 4:2:0 chroma
+	const int left   = inRect.left / a * a;
+	const int top    = inRect.top / a * a;
+	const int right  = std::min((inRect.left + inRect.width + a - 1) / a * a, inWidth);
+	const int bottom = std::min((inRect.top + inRect.height + a - 1) / a * a, inHeight);
+
+	EGAVCropRect rect;
+	rect.left   = left;
+	rect.top    = top;
+	rect.width  = std::max(right - left, 0);
+	rect.height = std::max(bottom - top, 0);
+	return rect;
+}
+
+
+//==============================================================================
+// # Black border scan
+//==============================================================================
+
+//! @brief Loads 16 luma samples as 8 bit (P010: upper byte)
+#if EGAV_X86
+static inline __m128i Load16Samples(const uint8_t* inRow, int inX, int inBytesPerSample)
+{
+	if (inBytesPerSample == 1)
+		return _mm_loadu_si128((const __m128i*)(inRow + inX));
+
+	const __m128i lo = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(inRow + 2 * inX)), 8);
+	const __m128i hi = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(inRow + 2 * inX + 16)), 8);
+	return _mm_packus_epi16(lo, hi);
+}
+#endif
+
+static inline uint8_t Sample8(const uint8_t* inRow, int inX, int inBytesPerSample)
+{
+	return (inBytesPerSample == 1) ? inRow[inX] : inRow[2 * inX + 1];
+}
+
+//! @return true if a sample of the row is above the threshold
+static bool IsRowActive(const uint8_t* inRow, int inWidth, int inBytesPerSample, uint8_t inThreshold)
+{
+	int x = 0;
+#if EGAV_X86
+	const __m128i threshold = _mm_set1_epi8((char)inThreshold);
+	for (; x + 16 <= inWidth; x += 16)
+	{
+		// max(v, t) == t for all lanes <=> all samples <= t
+		__m128i v = Load16Samples(inRow, x, inBytesPerSample);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, threshold), threshold)) != 0xFFFF)
+			return true;
+	}
+#endif
+	for (; x < inWidth; x++)
+		if (Sample8(inRow, x, inBytesPerSample) > inThreshold)
+			return true;
+	return false;
+}
+
+//! @brief ioColumnMax[x] = max(ioColumnMax[x], row[x])
+static void AccumulateColumnMax(const uint8_t* inRow, int inWidth, int inBytesPerSample, uint8_t* ioColumnMax)
+{
+	int x = 0;
+#if EGAV_X86
+	for (; x + 16 <= inWidth; x += 16)
+	{
+		__m128i m = _mm_loadu_si128((const __m128i*)(ioColumnMax + x));
+		_mm_storeu_si128((__m128i*)(ioColumnMax + x), _mm_max_epu8(m, Load16Samples(inRow, x, inBytesPerSample)));
+	}
+#endif
+	for (; x < inWidth; x++)
+		ioColumnMax[x] = std::max(ioColumnMax[x], Sample8(inRow, x, inBytesPerSample));
+}
+
+bool HDMICrop_ScanBlackBorders(const uint8_t* inY, int inYStride, int inWidth, int inHeight, int inBytesPerSample,
+	int inBlackThreshold, EGAVCropRect& outRect)
+{
+	if (!inY || inWidth <= 0 || inHeight <= 0 || (inBytesPerSample != 1 && inBytesPerSample != 2))
+		return false;
+
+	const uint8_t threshold = (uint8_t)std::min(std::max(inBlackThreshold, 0), 255);
+	auto row = [&](int y) { return inY + (size_t)y * inYStride; };
+
+	// Top and bottom bars: whole rows, early exit at the first active sample
+	int top = 0;
+	while (top < inHeight && !IsRowActive(row(top), inWidth, inBytesPerSample, threshold))
+		top++;
+	if (top == inHeight)
+		return false;
+
+	int bottom = inHeight;
+	while (bottom > top && !IsRowActive(row(bottom - 1), inWidth, inBytesPerSample, threshold))
+		bottom--;
+
+	// Left and right bars: column maxima over every second row of the active lines
+	std::vector<uint8_t> columnMax(inWidth, 0);
+	for (int y = top; y < bottom; y += 2)
+		AccumulateColumnMax(row(y), inWidth, inBytesPerSample, columnMax.data());
+
+	int left = 0;
+	while (left < inWidth && columnMax[left] <= threshold)
+		left++;
+	int right = inWidth;
+	while (right > left && columnMax[right - 1] <= threshold)
+		right--;
+	if (right <= left)
+		return false;
+
+	outRect.left   = left;
+	outRect.top    = top;
+	outRect.width  = right - left;
+	outRect.height = bottom - top;
+	return true;
+}
+
+
+//==============================================================================
+// # Class HDMICropDetector
+//==============================================================================
+
+HDMICropDetector::HDMICropDetector(int inAlignment /*= 16*/, int inStableFrames /*= 5*/, int inBlackThreshold /*= 32*/)
+	: mAlignment(inAlignment), mStableFrames(std::max(inStableFrames, 1)), mBlackThreshold(inBlackThreshold)
+{
+}
+
+void HDMICropDetector::Reset()
+{
+	mWidth = mHeight = 0;
+	mCurrent        = EGAVCropRect();
+	mCandidate      = EGAVCropRect();
+	mCandidateCount = 0;
+}
+
+EGAVCropRect HDMICropDetector::Update(const HDMI_GENERIC_INFOFRAME* inAVI, const uint8_t* inY, int inYStride, int inWidth, int inHeight, int inBytesPerSample)
+{
+	if (inWidth != mWidth || inHeight != mHeight)
+	{
+		Reset();
+		mWidth  = inWidth;
+		mHeight = inHeight;
+		mCurrent.width  = inWidth;
+		mCurrent.height = inHeight;
+	}
+
+	// Bar data is authoritative
+	EGAVCropRect rect;
+	if (inAVI && HDMICrop_GetBarDataRect(*inAVI, inWidth, inHeight, rect))
+	{
+		mCurrent        = HDMICrop_Align(rect, inWidth, inHeight, mAlignment);
+		mCandidateCount = 0;
+		return mCurrent;
+	}
+
+	// Black frames (fades, scene cuts) don't tell anything about the borders
+	if (!HDMICrop_ScanBlackBorders(inY, inYStride, inWidth, inHeight, inBytesPerSample, mBlackThreshold, rect))
+		return mCurrent;
+
+	rect = HDMICrop_Align(rect, inWidth, inHeight, mAlignment);
+	if (rect == mCurrent)
+	{
+		mCandidateCount = 0;
+		return mCurrent;
+	}
+
+	// Active pixels outside the current crop: grow at once (never cut picture content),
+	// shrinking waits for a stable result (dark scenes look like borders)
+	const int left   = std::min(rect.left, mCurrent.left);
+	const int top    = std::min(rect.top, mCurrent.top);
+	const int right  = std::max(rect.left + rect.width, mCurrent.left + mCurrent.width);
+	const int bottom = std::max(rect.top + rect.height, mCurrent.top + mCurrent.height);
+	if (right - left != mCurrent.width || bottom - top != mCurrent.height)
+	{
+		mCurrent.left   = left;
+		mCurrent.top    = top;
+		mCurrent.width  = right - left;
+		mCurrent.height = bottom - top;
+		mCandidateCount = 0;
+		if (rect == mCurrent)
+			return mCurrent;
+	}
+
+	if (rect != mCandidate)
+	{
+		mCandidate      = rect;
+		mCandidateCount = 0;
+	}
+	if (++mCandidateCount >= mStableFrames)
+	{
+		mCurrent        = mCandidate;
+		mCandidateCount = 0;
+	}
+	return mCurrent;
+}
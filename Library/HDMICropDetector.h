@@ -0,0 +1,107 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMICropDetector.h
+
+@brief		Active picture crop rectangle for letterboxed/pillarboxed video.
+
+			The rectangle comes from the AVI bar data (ETB/SBB/ELB/SRB) if the source
+			sends it. Otherwise a black-border scan of the luma plane (SSE2) is used,
+			which must be stable for some frames before the crop changes. The rectangle
+			is aligned outward to the encoder block size (16 for AVC macroblocks,
+			32/64 for HEVC CTUs) so no active pixel is lost.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "HDMIInfoFramesAPI.h"
+
+
+//! @brief Rectangle in pixels (luma)
+struct EGAVCropRect
+{
+	int		left	= 0;
+	int		top		= 0;
+	int		width	= 0;
+	int		height	= 0;
+
+	bool IsEmpty() const { return width <= 0 || height <= 0; }
+	bool operator==(const EGAVCropRect& inOther) const { return left == inOther.left && top == inOther.top && width == inOther.width && height == inOther.height; }
+	bool operator!=(const EGAVCropRect& inOther) const { return !(*this == inOther); }
+};
+
+
+//==============================================================================
+// # Functions
+//==============================================================================
+
+//! @brief Active picture from the AVI bar data
+//! @return false if the frame is no valid AVI info frame or contains no bar data
+bool HDMICrop_GetBarDataRect(const HDMI_GENERIC_INFOFRAME& inAVI, int inWidth, int inHeight, EGAVCropRect& outRect);
+
+//! @brief Grows the rectangle to multiples of inAlignment (clamped to the frame)
+EGAVCropRect HDMICrop_Align(const EGAVCropRect& inRect, int inWidth, int inHeight, int inAlignment);
+
+//! @brief Finds the non-black area of a luma plane
+//! @param inBytesPerSample 1: NV12/8 bit, 2: P010 (MSB aligned)
+//! @param inBlackThreshold max. black level in 8 bit code values (limited range black is 16)
+//! @return false if the whole frame is black
+bool HDMICrop_ScanBlackBorders(const uint8_t* inY, int inYStride, int inWidth, int inHeight, int inBytesPerSample,
+	int inBlackThreshold, EGAVCropRect& outRect);
+
+
+//==============================================================================
+// # Class HDMICropDetector
+//==============================================================================
+
+class HDMICropDetector
+{
+public:
+	//! @param inAlignment encoder block size
+	//! @param inStableFrames number of frames a scanned rectangle must be unchanged before it is used
+	HDMICropDetector(int inAlignment = 16, int inStableFrames = 5, int inBlackThreshold = 32);
+
+	//! @param inAVI current AVI info frame or nullptr
+	//! @return aligned crop rectangle (the full frame until a crop is known)
+	EGAVCropRect Update(const HDMI_GENERIC_INFOFRAME* inAVI, const uint8_t* inY, int inYStride, int inWidth, int inHeight, int inBytesPerSample);
+
+	void Reset();
+
+private:
+	const int		mAlignment;
+	const int		mStableFrames;
+	const int		mBlackThreshold;
+
+	int				mWidth			= 0;
+	int				mHeight			= 0;
+	EGAVCropRect	mCurrent;
+	EGAVCropRect	mCandidate;
+	int				mCandidateCount	= 0;
+};
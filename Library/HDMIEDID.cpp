@@ -0,0 +1,317 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIEDID.cpp
+
+@brief		EDID decoding (base block and CTA-861 extension)
+**/
+//==============================================================================
+
+#include "HDMIEDID.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace
+{
+	const uint8_t kEDIDHeader[8] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+
+	const uint8_t kCTAExtensionTag		= 0x02;
+
+	// CTA data block tags, see CTA-861-G chapter 7.4, table 54
+	const uint8_t kTagVideo				= 2;
+	const uint8_t kTagVendorSpecific	= 3;
+	const uint8_t kTagExtended			= 7;
+
+	// Extended tags, see CTA-861-G chapter 7.4, table 55
+	const uint8_t kExtColorimetry		= 5;
+	const uint8_t kExtHDRStaticMetadata	= 6;
+	const uint8_t kExtYCbCr420Video		= 14;
+	const uint8_t kExtYCbCr420CapMap	= 15;
+
+	bool IsBlockValid(const uint8_t* inBlock)
+	{
+		uint8_t sum = 0;
+		for (int i = 0; i < HDMI_EDID_BLOCK_SIZE; i++)
+			sum += inBlock[i];
+		return sum == 0;
+	}
+
+	//! @brief Short video descriptor, see CTA-861-G chapter 7.5.1: VIC 1..64 can carry the native flag
+	//! @return VIC, 0 for reserved values
+	uint8_t SVDToVIC(uint8_t inSVD, bool& outNative)
+	{
+		outNative = (inSVD >= 129 && inSVD <= 192);
+		const uint8_t vic = outNative ? (uint8_t)(inSVD & 0x7F) : inSVD;
+		return (vic == 128 || vic >= HDMI_VIC_TABLE_SIZE) ? 0 : vic;
+	}
+
+	uint32_t ReadOUI(const uint8_t* inPayload)
+	{
+		return (uint32_t)inPayload[0] | ((uint32_t)inPayload[1] << 8) | ((uint32_t)inPayload[2] << 16);
+	}
+}
+
+uint64_t HDMIEDID::ModeKey(int inWidth, int inHeight, int inRefreshRate, bool inInterlaced)
+{
+	return ((uint64_t)(uint32_t)inWidth << 40) | ((uint64_t)(uint32_t)inHeight << 20) | ((uint64_t)(uint32_t)inRefreshRate << 1) | (inInterlaced ? 1 : 0);
+}
+
+EGAVResult HDMIEDID::Decode(const uint8_t* inData, size_t inSize)
+{
+	EGAVResult_CheckPointer(inData);
+	*this = HDMIEDID();
+
+	if (inSize < HDMI_EDID_BLOCK_SIZE || memcmp(inData, kEDIDHeader, sizeof(kEDIDHeader)) != 0 || !IsBlockValid(inData))
+		return EGAVResult::ErrInvalidFormat;
+
+	const uint8_t* base = inData;
+	const int extensions = base[126];
+	const size_t available = std::min(inSize / HDMI_EDID_BLOCK_SIZE, (size_t)extensions + 1);
+	mData.assign(inData, inData + available * HDMI_EDID_BLOCK_SIZE);
+
+	// Vendor and product identification, see E-EDID 1.4 chapter 3.4
+	const uint16_t id = (uint16_t)((base[8] << 8) | base[9]);
+	for (int shift = 10; shift >= 0; shift -= 5)
+		mManufacturerID += (char)('A' - 1 + ((id >> shift) & 0x1F));
+	mProductCode = (uint16_t)(base[10] | (base[11] << 8));
+	mYear        = base[17] ? 1990 + base[17] : 0;
+
+	for (int desc = 54; desc < 126; desc += 18)
+		DecodeDetailedDescriptor(base + desc);
+
+	for (size_t block = 1; block < available; block++)
+	{
+		const uint8_t* ext = inData + block * HDMI_EDID_BLOCK_SIZE;
+		if (ext[0] == kCTAExtensionTag && IsBlockValid(ext))
+			DecodeCTAExtension(ext);
+	}
+
+	std::sort(mModeIndex.begin(), mModeIndex.end());
+	mModeIndex.erase(std::unique(mModeIndex.begin(), mModeIndex.end()), mModeIndex.end());
+
+	return (available < (size_t)extensions + 1) ? EGAVResult::OkButIncomplete : EGAVResult::Ok;
+}
+
+bool HDMIEDID::SupportsMode(int inWidth, int inHeight, int inRefreshRate, bool inInterlaced /*= false*/) const
+{
+	return std::binary_search(mModeIndex.begin(), mModeIndex.end(), ModeKey(inWidth, inHeight, inRefreshRate, inInterlaced));
+}
+
+void HDMIEDID::AddMode(const HDMIEDIDMode& inMode)
+{
+	mModes.push_back(inMode);
+	mModeIndex.push_back(ModeKey(inMode.width, inMode.height, inMode.refreshRate, inMode.interlaced));
+}
+
+void HDMIEDID::AddVIC(uint8_t inVIC, bool inNative, bool in420Only)
+{
+	const HDMI_VIC_DESCRIPTOR& desc = g_HDMI_VIC_TABLE[inVIC < HDMI_VIC_TABLE_SIZE ? inVIC : 0];
+	if (desc.iWidth == 0)
+		return; // reserved
+
+	mVICs.set(inVIC);
+	if (in420Only)
+		mVICs420.set(inVIC);
+
+	HDMIEDIDMode mode;
+	mode.width        = desc.iWidth;
+	mode.height       = desc.iHeight;
+	mode.refreshRate  = desc.iFieldRate;
+	mode.interlaced   = desc.bInterlaced;
+	mode.vic          = inVIC;
+	mode.native       = inNative;
+	mode.ycbcr420Only = in420Only;
+	AddMode(mode);
+}
+
+//! @brief Detailed timing or display descriptor, see E-EDID 1.4 chapter 3.10
+void HDMIEDID::DecodeDetailedDescriptor(const uint8_t* inDesc)
+{
+	const int pixelClock = inDesc[0] | (inDesc[1] << 8); // 10 kHz
+	if (pixelClock == 0)
+	{
+		// Display descriptor: only the name is of interest
+		if (inDesc[3] == 0xFC)
+		{
+			const char* name = (const char*)inDesc + 5;
+			size_t len = 0;
+			while (len < 13 && name[len] != '\n' && name[len] != 0)
+				len++;
+			while (len > 0 && name[len - 1] == ' ')
+				len--;
+			mMonitorName.assign(name, len);
+		}
+		return;
+	}
+
+	const int hActive = inDesc[2] | ((inDesc[4] & 0xF0) << 4);
+	const int hBlank  = inDesc[3] | ((inDesc[4] & 0x0F) << 8);
+	const int vActive = inDesc[5] | ((inDesc[7] & 0xF0) << 4);
+	const int vBlank  = inDesc[6] | ((inDesc[7] & 0x0F) << 8);
+	const int hTotal = hActive + hBlank, vTotal = vActive + vBlank;
+	if (hTotal == 0 || vTotal == 0)
+		return;
+
+	// Interlaced: vertical values are per field, the result is the field rate
+	HDMIEDIDMode mode;
+	mode.interlaced  = (inDesc[17] & 0x80) != 0;
+	mode.width       = hActive;
+	mode.height      = mode.interlaced ? 2 * vActive : vActive;
+	mode.refreshRate = (int)std::lround(pixelClock * 10000.0 / ((double)hTotal * vTotal));
+	AddMode(mode);
+}
+
+//! @brief CTA-861 extension block, see CTA-861-G chapter 7.3
+void HDMIEDID::DecodeCTAExtension(const uint8_t* inBlock)
+{
+	mHasCTA = true;
+
+	// The offset comes from the device: byte 127 is the checksum, nothing may extend past it
+	const int dtdOffset = std::min((int)inBlock[2], HDMI_EDID_BLOCK_SIZE - 1);
+	std::vector<uint8_t> svds;
+	const uint8_t* capMap = nullptr;
+	int capMapLength = 0;
+
+	// Data block collection (revision 3+): bytes 4 .. dtdOffset-1
+	if (inBlock[1] >= 3 && dtdOffset >= 4)
+	{
+		for (int pos = 4; pos < dtdOffset; )
+		{
+			const uint8_t tag = inBlock[pos] >> 5;
+			const int length = inBlock[pos] & 0x1F;
+			const uint8_t* payload = inBlock + pos + 1;
+			pos += 1 + length;
+			if (pos > dtdOffset)
+				break; // malformed: the block runs past the data block collection
+
+			if (tag == kTagExtended && length >= 1 && payload[0] == kExtYCbCr420CapMap)
+			{
+				// Refers to the SVDs of all video data blocks: applied afterwards
+				capMap = payload + 1;
+				capMapLength = length - 1;
+			}
+			else
+				DecodeCTADataBlock(tag, payload, length, svds);
+		}
+	}
+
+	if (capMap)
+	{
+		// An empty map means all SVDs support 4:2:0
+		for (size_t i = 0; i < svds.size(); i++)
+			if (svds[i] && (capMapLength == 0 || (i / 8 < (size_t)capMapLength && (capMap[i / 8] & (1 << (i % 8))))))
+				mVICs420.set(svds[i]);
+	}
+
+	// Detailed timing descriptors
+	for (int pos = dtdOffset; pos >= 4 && pos + 18 <= HDMI_EDID_BLOCK_SIZE - 1; pos += 18)
+	{
+		if ((inBlock[pos] | inBlock[pos + 1]) == 0)
+			break;
+		DecodeDetailedDescriptor(inBlock + pos);
+	}
+}
+
+void HDMIEDID::DecodeCTADataBlock(uint8_t inTag, const uint8_t* inPayload, int inLength, std::vector<uint8_t>& ioSVDs)
+{
+	if (inTag == kTagVideo)
+	{
+		for (int i = 0; i < inLength; i++)
+		{
+			bool native = false;
+			const uint8_t vic = SVDToVIC(inPayload[i], native);
+			ioSVDs.push_back(vic); // the 4:2:0 capability map counts reserved SVDs as well
+			if (vic)
+				AddVIC(vic, native, false);
+		}
+	}
+	else if (inTag == kTagVendorSpecific && inLength >= 3)
+	{
+		const uint32_t oui = ReadOUI(inPayload);
+		if (oui == HDMI_VS_OUI_HDMI_LLC && inLength >= 5)
+		{
+			// HDMI 1.4b chapter 8.3.2
+			mHDMI.hdmiVSDB        = true;
+			mHDMI.physicalAddress = (uint16_t)((inPayload[3] << 8) | inPayload[4]);
+			if (inLength >= 7 && inPayload[6] && mHDMI.maxTMDSCharacterRate == 0)
+				mHDMI.maxTMDSCharacterRate = inPayload[6] * 5;
+		}
+		else if (oui == HDMI_VS_OUI_HDMI_FORUM && inLength >= 6)
+		{
+			// HDMI 2.1 chapter 10.3.2
+			mHDMI.hfVSDB = true;
+			if (inPayload[4])
+				mHDMI.maxTMDSCharacterRate = inPayload[4] * 5;
+			mHDMI.scdc = (inPayload[5] & 0x80) != 0;
+			if (inLength >= 7)
+				mHDMI.maxFRLRate = inPayload[6] >> 4;
+			if (inLength >= 8)
+				mHDMI.allm = (inPayload[7] & 0x02) != 0;
+		}
+	}
+	else if (inTag == kTagExtended && inLength >= 1)
+	{
+		const uint8_t* data = inPayload + 1;
+		const int length = inLength - 1;
+		switch (inPayload[0])
+		{
+			case kExtColorimetry:
+				if (length >= 2)
+					mColorimetry = (uint16_t)(data[0] | ((data[1] & 0x80) << 8));
+				break;
+
+			case kExtHDRStaticMetadata:
+				// CTA-861-G chapter 7.5.13: luminance codes are optional
+				if (length >= 2)
+				{
+					mHDR.present          = true;
+					mHDR.eotfMask         = data[0] & 0x3F;
+					mHDR.metadataTypeMask = data[1];
+					if (length >= 3 && data[2])
+						mHDR.maxLuminance = 50.0f * std::pow(2.0f, data[2] / 32.0f);
+					if (length >= 4 && data[3])
+						mHDR.maxFrameAvgLuminance = 50.0f * std::pow(2.0f, data[3] / 32.0f);
+					if (length >= 5 && data[4] && mHDR.maxLuminance > 0)
+						mHDR.minLuminance = mHDR.maxLuminance * (data[4] / 255.0f) * (data[4] / 255.0f) / 100.0f;
+				}
+				break;
+
+			case kExtYCbCr420Video:
+				// Formats supported in 4:2:0 only (not part of the SVD order of the capability map)
+				for (int i = 0; i < length; i++)
+				{
+					bool native = false;
+					const uint8_t vic = SVDToVIC(data[i], native);
+					if (vic)
+						AddVIC(vic, native, true);
+				}
+				break;
+		}
+	}
+}
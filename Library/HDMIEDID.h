@@ -0,0 +1,166 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIEDID.h
+
+@brief		EDID decoding (base block and CTA-861 extension).
+
+			The EDID the capture device presents to the source decides which formats
+			the source sends (HDR, 4K120, 4:2:0, ...). Video formats from SVDs, 4:2:0
+			data blocks and detailed timings are collected into a VIC bitmap and a
+			sorted mode index for fast "does the sink advertise mode X" queries.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "EGAVResult.h"
+#include "HDMIInfoFramesAPI.h"
+
+
+#define HDMI_EDID_BLOCK_SIZE		128
+#define HDMI_EDID_MAX_SIZE			256		// base block + one extension (8 bit register address)
+
+// EOTFs of the HDR static metadata data block, see CTA-861-G chapter 7.5.13, table 85 (bit numbers = HDMI_DR_EOTF_*)
+#define HDMI_EDID_EOTF_SDR			0x01
+#define HDMI_EDID_EOTF_HDR			0x02	// traditional gamma, HDR luminance range
+#define HDMI_EDID_EOTF_PQ			0x04	// SMPTE ST 2084
+#define HDMI_EDID_EOTF_HLG			0x08
+
+// Colorimetry data block, see CTA-861-G chapter 7.5.5, table 81
+#define HDMI_EDID_CL_XVYCC601		0x0001
+#define HDMI_EDID_CL_XVYCC709		0x0002
+#define HDMI_EDID_CL_SYCC601		0x0004
+#define HDMI_EDID_CL_OPYCC601		0x0008
+#define HDMI_EDID_CL_OPRGB			0x0010
+#define HDMI_EDID_CL_BT2020CYCC		0x0020
+#define HDMI_EDID_CL_BT2020YCC		0x0040
+#define HDMI_EDID_CL_BT2020RGB		0x0080
+#define HDMI_EDID_CL_DCIP3			0x8000	// second byte, bit 7
+
+
+//! @brief Video format advertised by the sink
+struct HDMIEDIDMode
+{
+	int			width			= 0;
+	int			height			= 0;		//!< frame height, also for interlaced formats
+	int			refreshRate		= 0;		//!< field rate in Hz, rounded (59.94 -> 60)
+	bool		interlaced		= false;
+	uint8_t		vic				= 0;		//!< 0: detailed timing descriptor
+	bool		native			= false;
+	bool		ycbcr420Only	= false;
+};
+
+//! @brief HDR static metadata data block
+struct HDMIEDIDHDRCapabilities
+{
+	bool		present					= false;
+	uint8_t		eotfMask				= 0;	//!< HDMI_EDID_EOTF_*
+	uint8_t		metadataTypeMask		= 0;	//!< bit 0: static metadata type 1
+	float		maxLuminance			= 0;	//!< desired content max luminance in cd/m2 (0: not given)
+	float		maxFrameAvgLuminance	= 0;	//!< cd/m2 (0: not given)
+	float		minLuminance			= 0;	//!< cd/m2 (0: not given)
+};
+
+//! @brief HDMI and HDMI Forum vendor specific data blocks
+struct HDMIEDIDHDMICapabilities
+{
+	bool		hdmiVSDB				= false;	//!< HDMI 1.x VSDB present (HDMI sink, not DVI)
+	uint16_t	physicalAddress			= 0xFFFF;	//!< CEC physical address, e.g. 0x1000 = 1.0.0.0
+	bool		hfVSDB					= false;	//!< HDMI Forum VSDB present (HDMI 2.x)
+	int			maxTMDSCharacterRate	= 0;		//!< MHz (0: not given, 340 for HDMI 1.x)
+	int			maxFRLRate				= 0;		//!< Max_FRL_Rate code (0: no FRL, 6: 4 lanes at 12 Gbit/s)
+	bool		allm					= false;	//!< auto low latency mode
+	bool		scdc					= false;
+};
+
+
+//==============================================================================
+// # Class HDMIEDID
+//==============================================================================
+
+class HDMIEDID
+{
+public:
+	//! @brief Decodes the EDID (base block and CTA-861 extension, other extensions are skipped)
+	//! @return ErrInvalidFormat for a bad header or checksum; OkButIncomplete if extensions were truncated
+	EGAVResult Decode(const uint8_t* inData, size_t inSize);
+
+	//! @name Queries (fast, use the index built by Decode())
+	//! @{
+	bool SupportsVIC(uint8_t inVIC) const { return mVICs.test(inVIC); }
+	bool SupportsYCbCr420(uint8_t inVIC) const { return mVICs420.test(inVIC); }
+	bool SupportsMode(int inWidth, int inHeight, int inRefreshRate, bool inInterlaced = false) const;
+	bool SupportsEOTF(uint8_t inEOTFMask) const { return (mHDR.eotfMask & inEOTFMask) == inEOTFMask; }
+	//! @}
+
+	//! @return manufacturer PNP ID, e.g. "ELG"
+	const std::string& GetManufacturerID() const { return mManufacturerID; }
+	uint16_t GetProductCode() const { return mProductCode; }
+	const std::string& GetMonitorName() const { return mMonitorName; }
+	int GetManufactureYear() const { return mYear; }
+
+	//! @brief Formats in EDID order: detailed timings of the base block first (the first one is preferred)
+	const std::vector<HDMIEDIDMode>& GetModes() const { return mModes; }
+	const HDMIEDIDHDRCapabilities& GetHDRCapabilities() const { return mHDR; }
+	const HDMIEDIDHDMICapabilities& GetHDMICapabilities() const { return mHDMI; }
+	uint16_t GetColorimetry() const { return mColorimetry; }		//!< HDMI_EDID_CL_*
+	bool HasCTAExtension() const { return mHasCTA; }
+
+	//! @brief Raw EDID as decoded
+	const std::vector<uint8_t>& GetData() const { return mData; }
+
+private:
+	void DecodeDetailedDescriptor(const uint8_t* inDesc);
+	void DecodeCTAExtension(const uint8_t* inBlock);
+	void DecodeCTADataBlock(uint8_t inTag, const uint8_t* inPayload, int inLength, std::vector<uint8_t>& ioSVDs);
+	void AddVIC(uint8_t inVIC, bool inNative, bool in420Only);
+	void AddMode(const HDMIEDIDMode& inMode);
+
+	static uint64_t ModeKey(int inWidth, int inHeight, int inRefreshRate, bool inInterlaced);
+
+	std::vector<uint8_t>		mData;
+	std::string					mManufacturerID;
+	uint16_t					mProductCode	= 0;
+	std::string					mMonitorName;
+	int							mYear			= 0;
+
+	std::vector<HDMIEDIDMode>	mModes;
+	std::vector<uint64_t>		mModeIndex;		//!< sorted ModeKey() values
+	std::bitset<256>			mVICs;
+	std::bitset<256>			mVICs420;		//!< 4:2:0 capable (4:2:0 only or 4:2:0 capability map)
+
+	HDMIEDIDHDRCapabilities		mHDR;
+	HDMIEDIDHDMICapabilities	mHDMI;
+	uint16_t					mColorimetry	= 0;
+	bool						mHasCTA			= false;
+};
@@ -0,0 +1,514 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIInfoFrameJournal.cpp
+
+@brief		Append-only binary journal of HDMI info frames
+**/
+//==============================================================================
+
+#include "HDMIInfoFrameJournal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+#if !_UP_WINDOWS
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+
+static const size_t kFrameSize = sizeof(HDMI_GENERIC_INFOFRAME);
+
+
+//==============================================================================
+// # Class HDMIInfoFrameJournalWriter
+//==============================================================================
+
+HDMIInfoFrameJournalWriter::~HDMIInfoFrameJournalWriter()
+{
+	Close();
+}
+
+uint64_t HDMIInfoFrameJournalWriter::GetWallClockNow()
+{
+	auto now = std::chrono::system_clock::now().time_since_epoch();
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+uint64_t HDMIInfoFrameJournalWriter::GetTimestamp()
+{
+	const std::lock_guard<std::mutex> lock(mMutex);
+	return mJournalFile ? GetTimestampLocked() : 0;
+}
+
+uint64_t HDMIInfoFrameJournalWriter::GetTimestampLocked() const
+{
+	auto elapsed = std::chrono::steady_clock::now() - mSteadyBase;
+	return mClockBaseUs + (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+EGAVResult HDMIInfoFrameJournalWriter::Open(const std::string& inPath, const EGAVDeviceID& inDeviceID)
+{
+	const std::lock_guard<std::mutex> lock(mMutex);
+
+	if (mJournalFile)
+		return EGAVResult::ErrInvalidState;
+
+	// A failed index write of an earlier session may have left a partial entry: drop it, the rest stays valid
+	std::error_code error;
+	const std::string indexPath = inPath + ".idx";
+	const uintmax_t indexSize = std::filesystem::file_size(indexPath, error);
+	if (!error && indexSize % sizeof(HDMI_JOURNAL_INDEXENTRY) != 0)
+		std::filesystem::resize_file(indexPath, indexSize - indexSize % sizeof(HDMI_JOURNAL_INDEXENTRY), error);
+
+	mJournalFile = fopen(inPath.c_str(), "ab");
+	mIndexFile   = fopen(indexPath.c_str(), "ab");
+	if (!mJournalFile || !mIndexFile)
+	{
+		error_printf("HDMIInfoFrameJournalWriter: could not open %s", inPath.c_str());
+		CloseFilesLocked();
+		return EGAVResult::ErrCouldNotOpenFile;
+	}
+
+	fseek(mJournalFile, 0, SEEK_END);
+	mOffset = (uint64_t)ftell(mJournalFile);
+	mLastTimestamp = 0;
+	if (mOffset > 0)
+	{
+		// Journal time must not go backwards across sessions either
+		// Older versions are readable, but records of this version must not be appended to them
+		HDMIInfoFrameJournalReader existing;
+		EGAVResult res = existing.Open(inPath);
+		if (res.Failed() || existing.GetVersion() != HDMI_JOURNAL_VERSION)
+		{
+			error_printf("HDMIInfoFrameJournalWriter: %s is not a version %d journal", inPath.c_str(), HDMI_JOURNAL_VERSION);
+			CloseFilesLocked();
+			return EGAVResult::ErrInvalidFormat;
+		}
+		mLastTimestamp = existing.GetLastTimestamp();
+	}
+	else
+	{
+		HDMI_JOURNAL_FILEHEADER header{};
+		header.dwMagic           = HDMI_JOURNAL_MAGIC;
+		header.wVersion          = HDMI_JOURNAL_VERSION;
+		header.wKeyFrameInterval = kKeyFrameInterval;
+		header.bBusType          = (uint8_t)inDeviceID.busType;
+		header.wVendorID         = inDeviceID.vendorID;
+		header.wProductID        = inDeviceID.productID;
+		header.dwLocationID      = inDeviceID.locationID;
+		if (fwrite(&header, sizeof(header), 1, mJournalFile) != 1)
+		{
+			error_printf("HDMIInfoFrameJournalWriter: write failed");
+			CloseFilesLocked();
+			return EGAVResult::ErrUnknown;
+		}
+		mOffset = sizeof(header);
+	}
+
+	mClockBaseUs       = std::max(GetWallClockNow(), mLastTimestamp);
+	mSteadyBase        = std::chrono::steady_clock::now();
+	mWallClockOffsetUs = 0;
+	mRecordsSinceKey   = kKeyFrameInterval;
+	mHasPrevious       = false;
+	mIndexStale        = false;
+	return EGAVResult::Ok;
+}
+
+EGAVResult HDMIInfoFrameJournalWriter::Close()
+{
+	const std::lock_guard<std::mutex> lock(mMutex);
+	CloseFilesLocked();
+	return EGAVResult::Ok;
+}
+
+void HDMIInfoFrameJournalWriter::CloseFilesLocked()
+{
+	if (mJournalFile) fclose(mJournalFile);
+	if (mIndexFile)   fclose(mIndexFile);
+	mJournalFile = mIndexFile = nullptr;
+}
+
+EGAVResult HDMIInfoFrameJournalWriter::Append(const HDMI_GENERIC_INFOFRAME& inFrame)
+{
+	const std::lock_guard<std::mutex> lock(mMutex);
+
+	EGAVResult_CheckPointer(mJournalFile);
+	return AppendLocked(inFrame, std::max(GetTimestampLocked(), mLastTimestamp), true);
+}
+
+EGAVResult HDMIInfoFrameJournalWriter::Append(const HDMI_GENERIC_INFOFRAME& inFrame, uint64_t inTimestampUs)
+{
+	const std::lock_guard<std::mutex> lock(mMutex);
+
+	EGAVResult_CheckPointer(mJournalFile);
+	if (inTimestampUs < mLastTimestamp)
+		return EGAVResult::ErrInvalidParameter;
+	return AppendLocked(inFrame, inTimestampUs, false);
+}
+
+EGAVResult HDMIInfoFrameJournalWriter::WriteClockRecord(uint64_t inTimestampUs, int64_t inWallClockOffsetUs)
+{
+	uint8_t record[sizeof(HDMI_JOURNAL_RECORDHEADER) + sizeof(int64_t)];
+	HDMI_JOURNAL_RECORDHEADER header{ inTimestampUs, HDMI_JOURNAL_RECORD_CLOCK };
+	memcpy(record, &header, sizeof(header));
+	memcpy(record + sizeof(header), &inWallClockOffsetUs, sizeof(inWallClockOffsetUs));
+	if (fwrite(record, sizeof(record), 1, mJournalFile) != 1)
+	{
+		error_printf("HDMIInfoFrameJournalWriter: write failed");
+		return EGAVResult::ErrUnknown;
+	}
+	mOffset += sizeof(record);
+	mWallClockOffsetUs = inWallClockOffsetUs;
+	return EGAVResult::Ok;
+}
+
+EGAVResult HDMIInfoFrameJournalWriter::AppendLocked(const HDMI_GENERIC_INFOFRAME& inFrame, uint64_t inTimestampUs, bool inWithClock)
+{
+	const uint8_t* cur  = (const uint8_t*)&inFrame;
+	const uint8_t* prev = (const uint8_t*)&mPrevious;
+
+	uint32_t changeMask = 0;
+	if (mHasPrevious)
+	{
+		for (size_t i = 0; i < kFrameSize; i++)
+			if (cur[i] != prev[i])
+				changeMask |= (1u << i);
+		if (changeMask == 0)
+			return EGAVResult::OkNoDataChanged;
+	}
+
+	// Record: header + key frame or header + change mask + changed bytes (max. 4 + 31 bytes)
+	uint8_t record[sizeof(HDMI_JOURNAL_RECORDHEADER) + sizeof(uint32_t) + kFrameSize];
+	HDMI_JOURNAL_RECORDHEADER header{ inTimestampUs, HDMI_JOURNAL_RECORD_DELTA };
+	size_t size = sizeof(header);
+
+	const bool isKeyFrame = !mHasPrevious || mRecordsSinceKey >= kKeyFrameInterval;
+	if (isKeyFrame)
+	{
+		header.bKind = HDMI_JOURNAL_RECORD_KEY;
+		memcpy(record + size, cur, kFrameSize);
+		size += kFrameSize;
+	}
+	else
+	{
+		memcpy(record + size, &changeMask, sizeof(changeMask));
+		size += sizeof(changeMask);
+		for (size_t i = 0; i < kFrameSize; i++)
+			if (changeMask & (1u << i))
+				record[size++] = cur[i];
+	}
+	memcpy(record, &header, sizeof(header));
+
+	if (fwrite(record, size, 1, mJournalFile) != 1)
+	{
+		error_printf("HDMIInfoFrameJournalWriter: write failed");
+		return EGAVResult::ErrUnknown;
+	}
+
+	// The record is in the journal now: the state below must follow it even if the index write fails
+	EGAVResult res = EGAVResult::Ok;
+	if (isKeyFrame)
+	{
+		HDMI_JOURNAL_INDEXENTRY entry{ inTimestampUs, mOffset };
+		if (!mIndexStale && fwrite(&entry, sizeof(entry), 1, mIndexFile) != 1)
+		{
+			// A partial entry would shift all later ones: no more entries this session (see Open())
+			error_printf("HDMIInfoFrameJournalWriter: index write failed, index stale until reopened");
+			mIndexStale = true;
+			res = EGAVResult::ErrUnknown;
+		}
+		mRecordsSinceKey = 0;
+	}
+
+	mOffset += size;
+	mRecordsSinceKey++;
+	mLastTimestamp = inTimestampUs;
+	mPrevious      = inFrame;
+	mHasPrevious   = true;
+
+	// Replay starts at a key frame, so every key frame is followed by the current offset
+	if (inWithClock)
+	{
+		const int64_t wallClockOffsetUs = (int64_t)(GetWallClockNow() - inTimestampUs);
+		const int64_t stepUs = wallClockOffsetUs - mWallClockOffsetUs;
+		if (isKeyFrame || stepUs > kClockStepUs || stepUs < -kClockStepUs)
+		{
+			EGAVResult clockRes = WriteClockRecord(inTimestampUs, wallClockOffsetUs);
+			if (clockRes.Failed())
+				res = clockRes;
+		}
+	}
+	return res;
+}
+
+EGAVResult HDMIInfoFrameJournalWriter::Flush()
+{
+	const std::lock_guard<std::mutex> lock(mMutex);
+
+	EGAVResult_CheckPointer(mJournalFile);
+	// Journal first: an index entry must never point behind the end of the journal
+	fflush(mJournalFile);
+	fflush(mIndexFile);
+	return EGAVResult::Ok;
+}
+
+
+//==============================================================================
+// # Class HDMIInfoFrameJournalReader
+//==============================================================================
+
+HDMIInfoFrameJournalReader::~HDMIInfoFrameJournalReader()
+{
+	Close();
+}
+
+EGAVResult HDMIInfoFrameJournalReader::MapFile(const std::string& inPath, MappedFile& outFile)
+{
+#if _UP_WINDOWS
+	outFile.file = CreateFileA(inPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (outFile.file == INVALID_HANDLE_VALUE)
+		return EGAVResult::ErrCouldNotOpenFile;
+
+	LARGE_INTEGER size{};
+	GetFileSizeEx(outFile.file, &size);
+	outFile.size = (size_t)size.QuadPart;
+	if (outFile.size == 0)
+		return EGAVResult::Ok;
+
+	outFile.mapping = CreateFileMappingA(outFile.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (outFile.mapping)
+		outFile.data = (const uint8_t*)MapViewOfFile(outFile.mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	int fd = open(inPath.c_str(), O_RDONLY);
+	if (fd < 0)
+		return EGAVResult::ErrCouldNotOpenFile;
+
+	struct stat st{};
+	fstat(fd, &st);
+	outFile.size = (size_t)st.st_size;
+	if (outFile.size == 0)
+	{
+		close(fd);
+		return EGAVResult::Ok;
+	}
+
+	void* data = mmap(nullptr, outFile.size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // the mapping stays valid
+	outFile.data = (data == MAP_FAILED) ? nullptr : (const uint8_t*)data;
+#endif
+
+	if (!outFile.data)
+	{
+		error_printf("HDMIInfoFrameJournalReader: could not map %s", inPath.c_str());
+		UnmapFile(outFile);
+		return EGAVResult::ErrUnknown;
+	}
+	return EGAVResult::Ok;
+}
+
+void HDMIInfoFrameJournalReader::UnmapFile(MappedFile& ioFile)
+{
+#if _UP_WINDOWS
+	if (ioFile.data)								UnmapViewOfFile(ioFile.data);
+	if (ioFile.mapping)								CloseHandle(ioFile.mapping);
+	if (ioFile.file != INVALID_HANDLE_VALUE)		CloseHandle(ioFile.file);
+	ioFile.mapping = nullptr;
+	ioFile.file    = INVALID_HANDLE_VALUE;
+#else
+	if (ioFile.data)
+		munmap((void*)ioFile.data, ioFile.size);
+#endif
+	ioFile.data = nullptr;
+	ioFile.size = 0;
+}
+
+EGAVResult HDMIInfoFrameJournalReader::Open(const std::string& inPath)
+{
+	Close();
+
+	EGAVResult res = MapFile(inPath, mJournal);
+	if (res.Succeeded())
+		res = MapFile(inPath + ".idx", mIndex);
+	if (res.Failed())
+	{
+		Close();
+		return res;
+	}
+
+	HDMI_JOURNAL_FILEHEADER header{};
+	if (mJournal.size < sizeof(header))
+	{
+		Close();
+		return EGAVResult::ErrInvalidFormat;
+	}
+	memcpy(&header, mJournal.data, sizeof(header));
+	if (header.dwMagic != HDMI_JOURNAL_MAGIC || header.wVersion < 1 || header.wVersion > HDMI_JOURNAL_VERSION)
+	{
+		Close();
+		return EGAVResult::ErrInvalidFormat;
+	}
+	mDeviceID = EGAVDeviceID((EGAVBusType)header.bBusType, header.wVendorID, header.wProductID, header.dwLocationID);
+	mVersion  = header.wVersion;
+
+	// A partially written trailing entry (writer still running) is ignored
+	mIndexEntries = (const HDMI_JOURNAL_INDEXENTRY*)mIndex.data;
+	mIndexCount   = mIndex.size / sizeof(HDMI_JOURNAL_INDEXENTRY);
+	while (mIndexCount > 0 && mIndexEntries[mIndexCount - 1].qwOffset + sizeof(HDMI_JOURNAL_RECORDHEADER) + kFrameSize > mJournal.size)
+		mIndexCount--;
+
+	return EGAVResult::Ok;
+}
+
+void HDMIInfoFrameJournalReader::Close()
+{
+	UnmapFile(mJournal);
+	UnmapFile(mIndex);
+	mIndexEntries = nullptr;
+	mIndexCount   = 0;
+}
+
+bool HDMIInfoFrameJournalReader::PeekTimestamp(size_t inOffset, uint64_t& outTimestamp) const
+{
+	if (inOffset + sizeof(HDMI_JOURNAL_RECORDHEADER) > mJournal.size)
+		return false;
+	memcpy(&outTimestamp, mJournal.data + inOffset, sizeof(outTimestamp));
+	return true;
+}
+
+bool HDMIInfoFrameJournalReader::DecodeRecord(size_t& ioOffset, HDMI_GENERIC_INFOFRAME& ioFrame, uint64_t& ioChangedAt, int64_t& ioWallClockOffset) const
+{
+	HDMI_JOURNAL_RECORDHEADER header{};
+	size_t offset = ioOffset;
+	if (offset + sizeof(header) > mJournal.size)
+		return false;
+	memcpy(&header, mJournal.data + offset, sizeof(header));
+	offset += sizeof(header);
+
+	HDMI_GENERIC_INFOFRAME decoded = ioFrame;
+	uint8_t* frame = (uint8_t*)&decoded;
+	if (header.bKind == HDMI_JOURNAL_RECORD_KEY)
+	{
+		if (offset + kFrameSize > mJournal.size)
+			return false;
+		memcpy(frame, mJournal.data + offset, kFrameSize);
+		offset += kFrameSize;
+	}
+	else if (header.bKind == HDMI_JOURNAL_RECORD_DELTA)
+	{
+		uint32_t changeMask = 0;
+		if (offset + sizeof(changeMask) > mJournal.size)
+			return false;
+		memcpy(&changeMask, mJournal.data + offset, sizeof(changeMask));
+		offset += sizeof(changeMask);
+
+		for (size_t i = 0; i < kFrameSize; i++)
+		{
+			if (changeMask & (1u << i))
+			{
+				if (offset >= mJournal.size)
+					return false;
+				frame[i] = mJournal.data[offset++];
+			}
+		}
+	}
+	else if (header.bKind == HDMI_JOURNAL_RECORD_CLOCK)
+	{
+		if (offset + sizeof(int64_t) > mJournal.size)
+			return false;
+		memcpy(&ioWallClockOffset, mJournal.data + offset, sizeof(int64_t));
+		ioOffset = offset + sizeof(int64_t);
+		return true;
+	}
+	else
+		return false;
+
+	ioFrame     = decoded;
+	ioOffset    = offset;
+	ioChangedAt = header.qwTimestamp;
+	return true;
+}
+
+EGAVResult HDMIInfoFrameJournalReader::GetFrameAt(uint64_t inTimestampUs, HDMI_GENERIC_INFOFRAME& outFrame, uint64_t* outChangedAtUs /*= nullptr*/,
+												  int64_t* outWallClockOffsetUs /*= nullptr*/) const
+{
+	if (!mJournal.data || mIndexCount == 0)
+		return EGAVResult::ErrNoData;
+
+	// Binary search: last key frame with timestamp <= inTimestampUs
+	size_t lo = 0, hi = mIndexCount;
+	while (lo < hi)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+		if (mIndexEntries[mid].qwTimestamp <= inTimestampUs)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == 0)
+		return EGAVResult::ErrNotFound;
+
+	// Replay deltas (at most kKeyFrameInterval) up to inTimestampUs
+	size_t offset = (size_t)mIndexEntries[lo - 1].qwOffset;
+	uint64_t timestamp = 0;
+	int64_t wallClockOffset = 0;
+	if (!DecodeRecord(offset, outFrame, timestamp, wallClockOffset))
+		return EGAVResult::ErrInvalidFormat;
+
+	uint64_t next = 0;
+	while (PeekTimestamp(offset, next) && next <= inTimestampUs)
+	{
+		if (!DecodeRecord(offset, outFrame, timestamp, wallClockOffset))
+			break; // truncated trailing record
+	}
+
+	if (outChangedAtUs)
+		*outChangedAtUs = timestamp;
+	if (outWallClockOffsetUs)
+		*outWallClockOffsetUs = wallClockOffset;
+	return EGAVResult::Ok;
+}
+
+uint64_t HDMIInfoFrameJournalReader::GetLastTimestamp() const
+{
+	if (!mJournal.data || mIndexCount == 0)
+		return 0;
+
+	// At most kKeyFrameInterval frame records (plus clock records) follow the last indexed key frame,
+	// more if the writer's index went stale
+	size_t offset = (size_t)mIndexEntries[mIndexCount - 1].qwOffset;
+	HDMI_GENERIC_INFOFRAME frame{};
+	uint64_t timestamp = 0, last = 0;
+	int64_t wallClockOffset = 0;
+	while (PeekTimestamp(offset, timestamp) && DecodeRecord(offset, frame, timestamp, wallClockOffset))
+		last = timestamp;
+	return last;
+}
@@ -0,0 +1,230 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIInfoFrameJournal.h
+
+@brief		Append-only binary journal of HDMI info frames (one journal per device)
+
+			Journal file (<path>):
+				HDMI_JOURNAL_FILEHEADER
+				records: timestamp (us), kind, key frame (full info frame) or delta
+				(change mask + changed bytes against the previous record), or the
+				wall clock offset of the following records
+
+			Timestamps are journal time: the wall clock at Open() advanced by a
+			steady clock, so they never go backwards when the system clock is
+			stepped (NTP, suspend, manual changes). The difference to the wall
+			clock is stored in clock records: after every key frame and whenever
+			it changes by more than kClockStepUs.
+
+			Index file (<path>.idx):
+				HDMI_JOURNAL_INDEXENTRY for every key frame (sparse time index)
+
+			Only changed frames are stored. Every kKeyFrameInterval records a key
+			frame is written, so a query replays at most kKeyFrameInterval deltas.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#include "EGAVResult.h"
+#include "EGAVDevice.h"
+#include "HDMIInfoFramesAPI.h"
+
+
+//==============================================================================
+// # File format
+//==============================================================================
+
+#pragma pack(push, 1)
+
+#define HDMI_JOURNAL_MAGIC			0x4A494745	// 'EGIJ'
+#define HDMI_JOURNAL_VERSION		2
+
+#define HDMI_JOURNAL_RECORD_KEY		0x01		// full HDMI_GENERIC_INFOFRAME follows
+#define HDMI_JOURNAL_RECORD_DELTA	0x02		// uint32_t change mask + changed bytes follow
+#define HDMI_JOURNAL_RECORD_CLOCK	0x03		// int64_t wall clock offset follows (wall clock = timestamp + offset)
+
+typedef struct _HDMI_JOURNAL_FILEHEADER
+{
+	uint32_t	dwMagic;				// HDMI_JOURNAL_MAGIC
+	uint16_t	wVersion;				// HDMI_JOURNAL_VERSION
+	uint16_t	wKeyFrameInterval;		// max. number of records between two key frames
+	uint8_t		bBusType;				// EGAVBusType
+	uint8_t		bReserved[3];
+	uint16_t	wVendorID;
+	uint16_t	wProductID;
+	uint32_t	dwLocationID;
+}
+HDMI_JOURNAL_FILEHEADER;
+
+typedef struct _HDMI_JOURNAL_RECORDHEADER
+{
+	uint64_t	qwTimestamp;			// journal time in microseconds, monotonically increasing within a journal
+	uint8_t		bKind;					// HDMI_JOURNAL_RECORD_*
+}
+HDMI_JOURNAL_RECORDHEADER;
+
+typedef struct _HDMI_JOURNAL_INDEXENTRY
+{
+	uint64_t	qwTimestamp;			// timestamp of the key frame
+	uint64_t	qwOffset;				// file offset of the key frame record header
+}
+HDMI_JOURNAL_INDEXENTRY;
+
+#pragma pack(pop)
+
+static_assert(sizeof(HDMI_GENERIC_INFOFRAME) <= 32, "delta change mask is 32 bit");
+
+
+//==============================================================================
+// # Class HDMIInfoFrameJournalWriter
+//==============================================================================
+
+//! @brief Appends timestamped info frames of one device to a journal.
+//!        Thread-safe; unchanged frames are dropped.
+class HDMIInfoFrameJournalWriter
+{
+public:
+	static const int kKeyFrameInterval = 64;
+	static const int64_t kClockStepUs = 1000000;	//!< wall clock changes smaller than this are not recorded
+
+	~HDMIInfoFrameJournalWriter();
+
+	//! @brief Opens (or creates) a journal. Appending to an existing journal starts with a key frame.
+	//!        Journal time continues after the last record if the wall clock is behind it.
+	//!        A partial index entry left by a failed write is removed.
+	//! @param inPath path of the journal file; the index is written to inPath + ".idx"
+	//! @return ErrInvalidFormat if the existing journal has a different version (older versions are only read)
+	EGAVResult Open(const std::string& inPath, const EGAVDeviceID& inDeviceID);
+	EGAVResult Close();
+
+	//! @brief Appends a frame at the current journal time if it differs from the previous one.
+	//!        If an index entry can't be written, the record stays in the journal and no more index
+	//!        entries are written until the journal is reopened: queries replay from an earlier key frame.
+	//! @return Ok if a record was written, OkNoDataChanged if the frame did not change
+	EGAVResult Append(const HDMI_GENERIC_INFOFRAME& inFrame);
+
+	//! @brief Appends a frame with an explicit timestamp (e.g. when converting recorded data); no clock records are written.
+	//! @param inTimestampUs microseconds, must not be smaller than the previous timestamp
+	//! @return Ok if a record was written, OkNoDataChanged if the frame did not change
+	EGAVResult Append(const HDMI_GENERIC_INFOFRAME& inFrame, uint64_t inTimestampUs);
+
+	//! @brief Flushes buffered records, e.g. to make them visible to a reader.
+	EGAVResult Flush();
+
+	//! @return current journal time in microseconds (0 if not open)
+	uint64_t GetTimestamp();
+
+	//! @return current wall clock time in microseconds
+	static uint64_t GetWallClockNow();
+
+private:
+	uint64_t GetTimestampLocked() const;
+	void CloseFilesLocked();
+	EGAVResult AppendLocked(const HDMI_GENERIC_INFOFRAME& inFrame, uint64_t inTimestampUs, bool inWithClock);
+	EGAVResult WriteClockRecord(uint64_t inTimestampUs, int64_t inWallClockOffsetUs);
+
+	std::mutex				mMutex;
+	FILE*					mJournalFile	= nullptr;
+	FILE*					mIndexFile		= nullptr;
+	uint64_t				mOffset			= 0;	//!< end of journal file
+	uint64_t				mLastTimestamp	= 0;
+	uint64_t				mClockBaseUs	= 0;	//!< journal time at mSteadyBase
+	std::chrono::steady_clock::time_point mSteadyBase;
+	int64_t					mWallClockOffsetUs = 0;	//!< last recorded wall clock offset
+	int						mRecordsSinceKey = kKeyFrameInterval; //!< forces a key frame first
+	bool					mHasPrevious	= false;
+	bool					mIndexStale		= false;	//!< an index write failed: no more index entries until reopened
+	HDMI_GENERIC_INFOFRAME	mPrevious{};
+};
+
+
+//==============================================================================
+// # Class HDMIInfoFrameJournalReader
+//==============================================================================
+
+//! @brief Memory-mapped, read-only view of a journal written by HDMIInfoFrameJournalWriter.
+//!        Answers "signal state at time T" in O(log n) via the sparse key frame index.
+class HDMIInfoFrameJournalReader
+{
+public:
+	HDMIInfoFrameJournalReader() {}
+	~HDMIInfoFrameJournalReader();
+
+	HDMIInfoFrameJournalReader(const HDMIInfoFrameJournalReader&) = delete;
+	HDMIInfoFrameJournalReader& operator=(const HDMIInfoFrameJournalReader&) = delete;
+
+	EGAVResult Open(const std::string& inPath);
+	void Close();
+
+	//! @brief Returns the info frame that was signalled at inTimestampUs (journal time).
+	//! @param outChangedAtUs optional, receives the timestamp of the record that produced the state
+	//! @param outWallClockOffsetUs optional, receives the wall clock offset at inTimestampUs (0 if none was recorded)
+	//! @return ErrNotFound if inTimestampUs is before the first record
+	EGAVResult GetFrameAt(uint64_t inTimestampUs, HDMI_GENERIC_INFOFRAME& outFrame, uint64_t* outChangedAtUs = nullptr,
+						  int64_t* outWallClockOffsetUs = nullptr) const;
+
+	//! @return timestamp of the last complete record, 0 if the journal is empty
+	uint64_t GetLastTimestamp() const;
+
+	EGAVDeviceID GetDeviceID() const { return mDeviceID; }
+	uint16_t GetVersion() const { return mVersion; }
+	size_t GetKeyFrameCount() const { return mIndexCount; }
+
+private:
+	struct MappedFile
+	{
+		const uint8_t*	data	= nullptr;
+		size_t			size	= 0;
+#if _UP_WINDOWS
+		HANDLE			file	= INVALID_HANDLE_VALUE;
+		HANDLE			mapping	= nullptr;
+#endif
+	};
+
+	static EGAVResult MapFile(const std::string& inPath, MappedFile& outFile);
+	static void UnmapFile(MappedFile& ioFile);
+
+	//! @brief Decodes the record at ioOffset into ioFrame (frame records) or ioWallClockOffset (clock records).
+	//! @param ioChangedAt receives the timestamp of a frame record
+	//! @return false at end of data or for a truncated record
+	bool DecodeRecord(size_t& ioOffset, HDMI_GENERIC_INFOFRAME& ioFrame, uint64_t& ioChangedAt, int64_t& ioWallClockOffset) const;
+	bool PeekTimestamp(size_t inOffset, uint64_t& outTimestamp) const;
+
+	MappedFile						mJournal;
+	MappedFile						mIndex;
+	const HDMI_JOURNAL_INDEXENTRY*	mIndexEntries	= nullptr;
+	size_t							mIndexCount		= 0;
+	EGAVDeviceID					mDeviceID;
+	uint16_t						mVersion		= 0;
+};
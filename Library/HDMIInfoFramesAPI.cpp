@@ -0,0 +1,791 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIInfoFramesAPI.cpp
+
+@brief		Helper functions for HDMI info frames
+**/
+//==============================================================================
+
+#include <cstdint>
+#include <cstring>
+#include <array>
+
+#include "HDMIInfoFramesAPI.h"
+
+
+//====================================================================================
+// # VIDEO IDENTIFICATION CODES (VIC)
+//====================================================================================
+
+// see CTA-861-G chapter 4.1, table 3; interlaced formats: height of the frame, field rate.
+// Pixel repeated formats (e.g. 720(1440)x480i) use the transmitted width.
+const HDMI_VIC_DESCRIPTOR g_HDMI_VIC_TABLE[HDMI_VIC_TABLE_SIZE] =
+{
+	{   0,     0,    0,   0, false,   0,   0 },	// no VIC
+	{   1,   640,  480,  60, false,   4,   3 },
+	{   2,   720,  480,  60, false,   4,   3 },
+	{   3,   720,  480,  60, false,  16,   9 },
+	{   4,  1280,  720,  60, false,  16,   9 },
+	{   5,  1920, 1080,  60, true ,  16,   9 },
+	{   6,  1440,  480,  60, true ,   4,   3 },
+	{   7,  1440,  480,  60, true ,  16,   9 },
+	{   8,  1440,  240,  60, false,   4,   3 },
+	{   9,  1440,  240,  60, false,  16,   9 },
+	{  10,  2880,  480,  60, true ,   4,   3 },
+	{  11,  2880,  480,  60, true ,  16,   9 },
+	{  12,  2880,  240,  60, false,   4,   3 },
+	{  13,  2880,  240,  60, false,  16,   9 },
+	{  14,  1440,  480,  60, false,   4,   3 },
+	{  15,  1440,  480,  60, false,  16,   9 },
+	{  16,  1920, 1080,  60, false,  16,   9 },
+	{  17,   720,  576,  50, false,   4,   3 },
+	{  18,   720,  576,  50, false,  16,   9 },
+	{  19,  1280,  720,  50, false,  16,   9 },
+	{  20,  1920, 1080,  50, true ,  16,   9 },
+	{  21,  1440,  576,  50, true ,   4,   3 },
+	{  22,  1440,  576,  50, true ,  16,   9 },
+	{  23,  1440,  288,  50, false,   4,   3 },
+	{  24,  1440,  288,  50, false,  16,   9 },
+	{  25,  2880,  576,  50, true ,   4,   3 },
+	{  26,  2880,  576,  50, true ,  16,   9 },
+	{  27,  2880,  288,  50, false,   4,   3 },
+	{  28,  2880,  288,  50, false,  16,   9 },
+	{  29,  1440,  576,  50, false,   4,   3 },
+	{  30,  1440,  576,  50, false,  16,   9 },
+	{  31,  1920, 1080,  50, false,  16,   9 },
+	{  32,  1920, 1080,  24, false,  16,   9 },
+	{  33,  1920, 1080,  25, false,  16,   9 },
+	{  34,  1920, 1080,  30, false,  16,   9 },
+	{  35,  2880,  480,  60, false,   4,   3 },
+	{  36,  2880,  480,  60, false,  16,   9 },
+	{  37,  2880,  576,  50, false,   4,   3 },
+	{  38,  2880,  576,  50, false,  16,   9 },
+	{  39,  1920, 1080,  50, true ,  16,   9 },
+	{  40,  1920, 1080, 100, true ,  16,   9 },
+	{  41,  1280,  720, 100, false,  16,   9 },
+	{  42,   720,  576, 100, false,   4,   3 },
+	{  43,   720,  576, 100, false,  16,   9 },
+	{  44,  1440,  576, 100, true ,   4,   3 },
+	{  45,  1440,  576, 100, true ,  16,   9 },
+	{  46,  1920, 1080, 120, true ,  16,   9 },
+	{  47,  1280,  720, 120, false,  16,   9 },
+	{  48,   720,  480, 120, false,   4,   3 },
+	{  49,   720,  480, 120, false,  16,   9 },
+	{  50,  1440,  480, 120, true ,   4,   3 },
+	{  51,  1440,  480, 120, true ,  16,   9 },
+	{  52,   720,  576, 200, false,   4,   3 },
+	{  53,   720,  576, 200, false,  16,   9 },
+	{  54,  1440,  576, 200, true ,   4,   3 },
+	{  55,  1440,  576, 200, true ,  16,   9 },
+	{  56,   720,  480, 240, false,   4,   3 },
+	{  57,   720,  480, 240, false,  16,   9 },
+	{  58,  1440,  480, 240, true ,   4,   3 },
+	{  59,  1440,  480, 240, true ,  16,   9 },
+	{  60,  1280,  720,  24, false,  16,   9 },
+	{  61,  1280,  720,  25, false,  16,   9 },
+	{  62,  1280,  720,  30, false,  16,   9 },
+	{  63,  1920, 1080, 120, false,  16,   9 },
+	{  64,  1920, 1080, 100, false,  16,   9 },
+	{  65,  1280,  720,  24, false,  64,  27 },
+	{  66,  1280,  720,  25, false,  64,  27 },
+	{  67,  1280,  720,  30, false,  64,  27 },
+	{  68,  1280,  720,  50, false,  64,  27 },
+	{  69,  1280,  720,  60, false,  64,  27 },
+	{  70,  1280,  720, 100, false,  64,  27 },
+	{  71,  1280,  720, 120, false,  64,  27 },
+	{  72,  1920, 1080,  24, false,  64,  27 },
+	{  73,  1920, 1080,  25, false,  64,  27 },
+	{  74,  1920, 1080,  30, false,  64,  27 },
+	{  75,  1920, 1080,  50, false,  64,  27 },
+	{  76,  1920, 1080,  60, false,  64,  27 },
+	{  77,  1920, 1080, 100, false,  64,  27 },
+	{  78,  1920, 1080, 120, false,  64,  27 },
+	{  79,  1680,  720,  24, false,  64,  27 },
+	{  80,  1680,  720,  25, false,  64,  27 },
+	{  81,  1680,  720,  30, false,  64,  27 },
+	{  82,  1680,  720,  50, false,  64,  27 },
+	{  83,  1680,  720,  60, false,  64,  27 },
+	{  84,  1680,  720, 100, false,  64,  27 },
+	{  85,  1680,  720, 120, false,  64,  27 },
+	{  86,  2560, 1080,  24, false,  64,  27 },
+	{  87,  2560, 1080,  25, false,  64,  27 },
+	{  88,  2560, 1080,  30, false,  64,  27 },
+	{  89,  2560, 1080,  50, false,  64,  27 },
+	{  90,  2560, 1080,  60, false,  64,  27 },
+	{  91,  2560, 1080, 100, false,  64,  27 },
+	{  92,  2560, 1080, 120, false,  64,  27 },
+	{  93,  3840, 2160,  24, false,  16,   9 },
+	{  94,  3840, 2160,  25, false,  16,   9 },
+	{  95,  3840, 2160,  30, false,  16,   9 },
+	{  96,  3840, 2160,  50, false,  16,   9 },
+	{  97,  3840, 2160,  60, false,  16,   9 },
+	{  98,  4096, 2160,  24, false, 256, 135 },
+	{  99,  4096, 2160,  25, false, 256, 135 },
+	{ 100,  4096, 2160,  30, false, 256, 135 },
+	{ 101,  4096, 2160,  50, false, 256, 135 },
+	{ 102,  4096, 2160,  60, false, 256, 135 },
+	{ 103,  3840, 2160,  24, false,  64,  27 },
+	{ 104,  3840, 2160,  25, false,  64,  27 },
+	{ 105,  3840, 2160,  30, false,  64,  27 },
+	{ 106,  3840, 2160,  50, false,  64,  27 },
+	{ 107,  3840, 2160,  60, false,  64,  27 },
+	{ 108,  1280,  720,  48, false,  16,   9 },
+	{ 109,  1280,  720,  48, false,  64,  27 },
+	{ 110,  1680,  720,  48, false,  64,  27 },
+	{ 111,  1920, 1080,  48, false,  16,   9 },
+	{ 112,  1920, 1080,  48, false,  64,  27 },
+	{ 113,  2560, 1080,  48, false,  64,  27 },
+	{ 114,  3840, 2160,  48, false,  16,   9 },
+	{ 115,  4096, 2160,  48, false, 256, 135 },
+	{ 116,  3840, 2160,  48, false,  64,  27 },
+	{ 117,  3840, 2160, 100, false,  16,   9 },
+	{ 118,  3840, 2160, 120, false,  16,   9 },
+	{ 119,  3840, 2160, 100, false,  64,  27 },
+	{ 120,  3840, 2160, 120, false,  64,  27 },
+	{ 121,  5120, 2160,  24, false,  64,  27 },
+	{ 122,  5120, 2160,  25, false,  64,  27 },
+	{ 123,  5120, 2160,  30, false,  64,  27 },
+	{ 124,  5120, 2160,  48, false,  64,  27 },
+	{ 125,  5120, 2160,  50, false,  64,  27 },
+	{ 126,  5120, 2160,  60, false,  64,  27 },
+	{ 127,  5120, 2160, 100, false,  64,  27 },
+	{ 128,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 129,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 130,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 131,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 132,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 133,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 134,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 135,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 136,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 137,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 138,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 139,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 140,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 141,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 142,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 143,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 144,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 145,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 146,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 147,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 148,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 149,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 150,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 151,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 152,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 153,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 154,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 155,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 156,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 157,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 158,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 159,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 160,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 161,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 162,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 163,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 164,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 165,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 166,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 167,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 168,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 169,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 170,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 171,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 172,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 173,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 174,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 175,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 176,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 177,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 178,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 179,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 180,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 181,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 182,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 183,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 184,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 185,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 186,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 187,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 188,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 189,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 190,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 191,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 192,     0,    0,   0, false,   0,   0 },	// reserved
+	{ 193,  5120, 2160, 120, false,  64,  27 },
+	{ 194,  7680, 4320,  24, false,  16,   9 },
+	{ 195,  7680, 4320,  25, false,  16,   9 },
+	{ 196,  7680, 4320,  30, false,  16,   9 },
+	{ 197,  7680, 4320,  48, false,  16,   9 },
+	{ 198,  7680, 4320,  50, false,  16,   9 },
+	{ 199,  7680, 4320,  60, false,  16,   9 },
+	{ 200,  7680, 4320, 100, false,  16,   9 },
+	{ 201,  7680, 4320, 120, false,  16,   9 },
+	{ 202,  7680, 4320,  24, false,  64,  27 },
+	{ 203,  7680, 4320,  25, false,  64,  27 },
+	{ 204,  7680, 4320,  30, false,  64,  27 },
+	{ 205,  7680, 4320,  48, false,  64,  27 },
+	{ 206,  7680, 4320,  50, false,  64,  27 },
+	{ 207,  7680, 4320,  60, false,  64,  27 },
+	{ 208,  7680, 4320, 100, false,  64,  27 },
+	{ 209,  7680, 4320, 120, false,  64,  27 },
+	{ 210, 10240, 4320,  24, false,  64,  27 },
+	{ 211, 10240, 4320,  25, false,  64,  27 },
+	{ 212, 10240, 4320,  30, false,  64,  27 },
+	{ 213, 10240, 4320,  48, false,  64,  27 },
+	{ 214, 10240, 4320,  50, false,  64,  27 },
+	{ 215, 10240, 4320,  60, false,  64,  27 },
+	{ 216, 10240, 4320, 100, false,  64,  27 },
+	{ 217, 10240, 4320, 120, false,  64,  27 },
+	{ 218,  4096, 2160, 100, false, 256, 135 },
+	{ 219,  4096, 2160, 120, false, 256, 135 },
+};
+
+
+//====================================================================================
+// # SOURCE PRODUCT DESCRIPTION INFOFRAME  (SPD)
+//====================================================================================
+
+const char* HDMI_SPD_ToString(uint8_t inByte)
+{
+	switch (inByte)
+	{
+		case HDMI_SPD_SI_UNKNOWN:	return "Unknown";
+		case HDMI_SPD_SI_STB:		return "Digital STB";
+		case HDMI_SPD_SI_DVD:		return "DVD player";
+		case HDMI_SPD_SI_DVHS:		return "D-VHS";
+		case HDMI_SPD_SI_DVR:		return "HDD Videorecorder";
+		case HDMI_SPD_SI_DVC:		return "DVC";
+		case HDMI_SPD_SI_DSC:		return "DSC";
+		case HDMI_SPD_SI_VCD:		return "Video CD";
+		case HDMI_SPD_SI_GAME:		return "Game";
+		case HDMI_SPD_SI_PC:		return "PC general";
+		case HDMI_SPD_SI_BD:		return "Blu-Ray Disc";
+		case HDMI_SPD_SI_SACD:		return "Super Audio CD";
+		case HDMI_SPD_SI_HDDVD:		return "HD DVD";
+		case HDMI_SPD_SI_PMP:		return "PMP";
+	}
+	return "Reserved";
+}
+
+
+//------------------------------------------------------------------------------------
+// ## Manufacturer names (perfect hash)
+//------------------------------------------------------------------------------------
+
+namespace
+{
+	struct ManufacturerEntry
+	{
+		const char*		key;		//!< upper case, max. 8 characters (SPD vendor name field)
+		const char*		name;
+	};
+
+	// EXTEND_SPD_MANUFACTURERS: add new entries here (upper case key); the hash seed is found at compile time
+	constexpr ManufacturerEntry kManufacturers[] =
+	{
+		{ "AMAZON",		"Amazon" },
+		{ "AMD",		"AMD" },
+		{ "APPLE",		"Apple" },
+		{ "ATI",		"AMD (ATI)" },
+		{ "BROADCOM",	"Broadcom" },
+		{ "DENON",		"Denon" },
+		{ "ELGATO",		"Elgato" },
+		{ "GOOGLE",		"Google" },
+		{ "INTEL",		"Intel" },
+		{ "LGE",		"LG Electronics" },
+		{ "MEDIATEK",	"MediaTek" },
+		{ "MSFT",		"Microsoft" },
+		{ "NINTENDO",	"Nintendo" },
+		{ "NVIDIA",		"NVIDIA" },
+		{ "ONKYO",		"Onkyo" },
+		{ "PHILIPS",	"Philips" },
+		{ "PIONEER",	"Pioneer" },
+		{ "REALTEK",	"Realtek" },
+		{ "ROKU",		"Roku" },
+		{ "SAMSUNG",	"Samsung" },
+		{ "SCEI",		"Sony Computer Entertainment" },
+		{ "SIE",		"Sony Interactive Entertainment" },
+		{ "SONY",		"Sony" },
+		{ "TOSHIBA",	"Toshiba" },
+		{ "VALVE",		"Valve" },
+		{ "YAMAHA",		"Yamaha" },
+	};
+
+	constexpr size_t kManufacturerCount = sizeof(kManufacturers) / sizeof(kManufacturers[0]);
+	constexpr size_t kHashSlots         = 64;	// power of two, > kManufacturerCount
+
+	constexpr size_t Length(const char* inString)
+	{
+		size_t len = 0;
+		while (inString[len])
+			len++;
+		return len;
+	}
+
+	constexpr uint32_t Hash(const char* inKey, size_t inLength, uint32_t inSeed)
+	{
+		uint32_t hash = 0x811C9DC5u ^ inSeed;
+		for (size_t i = 0; i < inLength; i++)
+		{
+			hash ^= (uint8_t)inKey[i];
+			hash *= 0x01000193u;
+		}
+		return (hash ^ (hash >> 15)) & (kHashSlots - 1);
+	}
+
+	//! @return first seed for which all keys land in different slots, 0 if none was found
+	constexpr uint32_t FindSeed()
+	{
+		for (uint32_t seed = 1; seed < 100000; seed++)
+		{
+			bool used[kHashSlots] = {};
+			bool collision = false;
+			for (size_t i = 0; i < kManufacturerCount && !collision; i++)
+			{
+				uint32_t slot = Hash(kManufacturers[i].key, Length(kManufacturers[i].key), seed);
+				collision = used[slot];
+				used[slot] = true;
+			}
+			if (!collision)
+				return seed;
+		}
+		return 0;
+	}
+
+	constexpr uint32_t kHashSeed = FindSeed();
+	static_assert(kHashSeed != 0, "No perfect hash seed found for kManufacturers: increase kHashSlots");
+
+	constexpr std::array<int8_t, kHashSlots> BuildSlots()
+	{
+		std::array<int8_t, kHashSlots> slots{};
+		for (size_t i = 0; i < kHashSlots; i++)
+			slots[i] = -1;
+		for (size_t i = 0; i < kManufacturerCount; i++)
+			slots[Hash(kManufacturers[i].key, Length(kManufacturers[i].key), kHashSeed)] = (int8_t)i;
+		return slots;
+	}
+
+	constexpr std::array<int8_t, kHashSlots> kSlots = BuildSlots();
+
+	//! @return entry for the (upper case) key or nullptr
+	const ManufacturerEntry* FindManufacturer(const char* inKey, size_t inLength)
+	{
+		int8_t index = kSlots[Hash(inKey, inLength, kHashSeed)];
+		if (index < 0)
+			return nullptr;
+		const ManufacturerEntry& entry = kManufacturers[index];
+		return (Length(entry.key) == inLength && 0 == memcmp(entry.key, inKey, inLength)) ? &entry : nullptr;
+	}
+
+	//! @brief Copies a fixed-size SPD text field, removing trailing blanks and NULs
+	std::string TrimmedField(const uint8_t* inField, size_t inSize)
+	{
+		size_t len = 0;
+		while (len < inSize && inField[len] != 0)
+			len++;
+		while (len > 0 && inField[len - 1] == ' ')
+			len--;
+		return std::string((const char*)inField, len);
+	}
+
+	bool ContainsNoCase(const std::string& inText, const char* inUpperPattern)
+	{
+		std::string upper(inText);
+		for (char& c : upper)
+			c = (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+		return upper.find(inUpperPattern) != std::string::npos;
+	}
+}
+
+
+std::string HDMI_SPD_MapManufacturerString(const std::string& inManufacturer)
+{
+	char key[8];
+	size_t len = inManufacturer.size();
+	while (len > 0 && (inManufacturer[len - 1] == ' ' || inManufacturer[len - 1] == 0))
+		len--;
+	if (len == 0 || len > sizeof(key))
+		return inManufacturer;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		char c = inManufacturer[i];
+		key[i] = (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+	}
+
+	const ManufacturerEntry* entry = FindManufacturer(key, len);
+	return entry ? std::string(entry->name) : inManufacturer;
+}
+
+bool HDMI_SPD_Decode(const HDMI_GENERIC_INFOFRAME& inFrame, HDMI_SPD_INFO& outInfo)
+{
+	if (HDMI_INFOFRAME_TYPE_SPD != inFrame.header.bfType || inFrame.header.bPayloadLength < sizeof(HDMI_SPD1_PAYLOAD) || inFrame.header.bPayloadLength > HDMI_MAX_INFOFRAME_PAYLOAD)
+		return false;
+	if (!HDMI_IsInfoFrameValid(&inFrame))
+		return false;
+
+	const HDMI_SPD1_PAYLOAD& spd = inFrame.plSPD1;
+	outInfo.vendorName         = TrimmedField(spd.bVendorName, sizeof(spd.bVendorName));
+	outInfo.manufacturer       = HDMI_SPD_MapManufacturerString(outInfo.vendorName);
+	outInfo.productDescription = TrimmedField(spd.bProductDescription, sizeof(spd.bProductDescription));
+	outInfo.bSourceInformation = spd.bSourceInformation;
+	return true;
+}
+
+uint8_t HDMI_SPD_GetSourceClass(const HDMI_SPD_INFO& inInfo)
+{
+	switch (inInfo.bSourceInformation)
+	{
+		case HDMI_SPD_SI_GAME:
+		case HDMI_SPD_SI_PC:
+		case HDMI_SPD_SI_BD:
+			return inInfo.bSourceInformation;
+		case HDMI_SPD_SI_HDDVD:
+			return HDMI_SPD_SI_BD;
+	}
+
+	// Many sources don't fill in the source information: use well-known names
+	const std::string vendor = HDMI_SPD_MapManufacturerString(inInfo.vendorName);
+	if (vendor == "Sony Computer Entertainment" || vendor == "Sony Interactive Entertainment" || vendor == "Nintendo" || vendor == "Valve")
+		return HDMI_SPD_SI_GAME;
+	if (vendor == "Microsoft" && ContainsNoCase(inInfo.productDescription, "XBOX"))
+		return HDMI_SPD_SI_GAME;
+	if (vendor == "Sony" && ContainsNoCase(inInfo.productDescription, "PLAYSTATION"))
+		return HDMI_SPD_SI_GAME;
+	if (vendor == "NVIDIA" || vendor == "AMD" || vendor == "AMD (ATI)" || vendor == "Intel")
+		return ContainsNoCase(inInfo.productDescription, "SHIELD") ? HDMI_SPD_SI_UNKNOWN : HDMI_SPD_SI_PC;
+
+	return HDMI_SPD_SI_UNKNOWN;
+}
+
+
+//====================================================================================
+// # AUXILIARY VIDEO INFORMATION INFOFRAME  (AVI)
+//====================================================================================
+
+bool HDMI_AVI_IsValid(const HDMI_GENERIC_INFOFRAME& inFrame)
+{
+	// AVI version 1 is obsolete; versions 2..4 share the layout of data bytes 1..13
+	if (HDMI_INFOFRAME_TYPE_AVI != inFrame.header.bfType || inFrame.header.bfVersion < 2 || inFrame.header.bfVersion > 4)
+		return false;
+	if (inFrame.header.bPayloadLength < sizeof(HDMI_AVI2_PAYLOAD) || inFrame.header.bPayloadLength > HDMI_MAX_INFOFRAME_PAYLOAD)
+		return false;
+	return HDMI_IsInfoFrameValid(&inFrame);
+}
+
+int HDMI_AVI_GetITContentType(const HDMI_GENERIC_INFOFRAME& inFrame)
+{
+	if (!HDMI_AVI_IsValid(inFrame) || HDMI_AVI_ITC_VALID != inFrame.plAVI2.bfITContent)
+		return HDMI_ERROR;
+	return inFrame.plAVI2.bfITContentType;
+}
+
+int HDMI_AVI_GetPixelRepetitionFactor(const HDMI_GENERIC_INFOFRAME& inFrame)
+{
+	if (!HDMI_AVI_IsValid(inFrame) || inFrame.plAVI2.bfPixelRepetitionFactor > HDMI_AVI_PR_9)
+		return HDMI_ERROR;
+	return inFrame.plAVI2.bfPixelRepetitionFactor + 1;
+}
+
+
+//====================================================================================
+// # AUDIO INFOFRAME
+//====================================================================================
+
+namespace
+{
+	const uint32_t __ = 0;
+	const uint32_t FL = HDMI_A_SPEAKER_FL, FR = HDMI_A_SPEAKER_FR, FC = HDMI_A_SPEAKER_FC, LFE = HDMI_A_SPEAKER_LFE;
+	const uint32_t RL = HDMI_A_SPEAKER_SL, RR = HDMI_A_SPEAKER_SR, RC = HDMI_A_SPEAKER_BC;
+	const uint32_t RLC = HDMI_A_SPEAKER_BL, RRC = HDMI_A_SPEAKER_BR, FLC = HDMI_A_SPEAKER_FLC, FRC = HDMI_A_SPEAKER_FRC;
+	const uint32_t TC = HDMI_A_SPEAKER_TC, FCH = HDMI_A_SPEAKER_TFC, FLH = HDMI_A_SPEAKER_TFL, FRH = HDMI_A_SPEAKER_TFR;
+	const uint32_t FLW = HDMI_A_SPEAKER_FLW, FRW = HDMI_A_SPEAKER_FRW;
+
+	// Channel allocation, see CEA-861-E chapter 6.6.2, table 28 (slots 1..8)
+	const uint32_t kChannelAllocations[HDMI_A_CA_MAX + 1][HDMI_A_MAX_CHANNELS] =
+	{
+		{ FL, FR, __,  __, __, __,  __,  __  },	// 0x00
+		{ FL, FR, LFE, __, __, __,  __,  __  },	// 0x01
+		{ FL, FR, __,  FC, __, __,  __,  __  },	// 0x02
+		{ FL, FR, LFE, FC, __, __,  __,  __  },	// 0x03
+		{ FL, FR, __,  __, RC, __,  __,  __  },	// 0x04
+		{ FL, FR, LFE, __, RC, __,  __,  __  },	// 0x05
+		{ FL, FR, __,  FC, RC, __,  __,  __  },	// 0x06
+		{ FL, FR, LFE, FC, RC, __,  __,  __  },	// 0x07
+		{ FL, FR, __,  __, RL, RR,  __,  __  },	// 0x08
+		{ FL, FR, LFE, __, RL, RR,  __,  __  },	// 0x09
+		{ FL, FR, __,  FC, RL, RR,  __,  __  },	// 0x0A
+		{ FL, FR, LFE, FC, RL, RR,  __,  __  },	// 0x0B
+		{ FL, FR, __,  __, RL, RR,  RC,  __  },	// 0x0C
+		{ FL, FR, LFE, __, RL, RR,  RC,  __  },	// 0x0D
+		{ FL, FR, __,  FC, RL, RR,  RC,  __  },	// 0x0E
+		{ FL, FR, LFE, FC, RL, RR,  RC,  __  },	// 0x0F
+		{ FL, FR, __,  __, RL, RR,  RLC, RRC },	// 0x10
+		{ FL, FR, LFE, __, RL, RR,  RLC, RRC },	// 0x11
+		{ FL, FR, __,  FC, RL, RR,  RLC, RRC },	// 0x12
+		{ FL, FR, LFE, FC, RL, RR,  RLC, RRC },	// 0x13
+		{ FL, FR, __,  __, __, __,  FLC, FRC },	// 0x14
+		{ FL, FR, LFE, __, __, __,  FLC, FRC },	// 0x15
+		{ FL, FR, __,  FC, __, __,  FLC, FRC },	// 0x16
+		{ FL, FR, LFE, FC, __, __,  FLC, FRC },	// 0x17
+		{ FL, FR, __,  __, RC, __,  FLC, FRC },	// 0x18
+		{ FL, FR, LFE, __, RC, __,  FLC, FRC },	// 0x19
+		{ FL, FR, __,  FC, RC, __,  FLC, FRC },	// 0x1A
+		{ FL, FR, LFE, FC, RC, __,  FLC, FRC },	// 0x1B
+		{ FL, FR, __,  __, RL, RR,  FLC, FRC },	// 0x1C
+		{ FL, FR, LFE, __, RL, RR,  FLC, FRC },	// 0x1D
+		{ FL, FR, __,  FC, RL, RR,  FLC, FRC },	// 0x1E
+		{ FL, FR, LFE, FC, RL, RR,  FLC, FRC },	// 0x1F
+		{ FL, FR, __,  FC, RL, RR,  FCH, __  },	// 0x20
+		{ FL, FR, LFE, FC, RL, RR,  FCH, __  },	// 0x21
+		{ FL, FR, __,  FC, RL, RR,  __,  TC  },	// 0x22
+		{ FL, FR, LFE, FC, RL, RR,  __,  TC  },	// 0x23
+		{ FL, FR, __,  __, RL, RR,  FLH, FRH },	// 0x24
+		{ FL, FR, LFE, __, RL, RR,  FLH, FRH },	// 0x25
+		{ FL, FR, __,  __, RL, RR,  FLW, FRW },	// 0x26
+		{ FL, FR, LFE, __, RL, RR,  FLW, FRW },	// 0x27
+		{ FL, FR, __,  FC, RL, RR,  RC,  TC  },	// 0x28
+		{ FL, FR, LFE, FC, RL, RR,  RC,  TC  },	// 0x29
+		{ FL, FR, __,  FC, RL, RR,  RC,  FCH },	// 0x2A
+		{ FL, FR, LFE, FC, RL, RR,  RC,  FCH },	// 0x2B
+		{ FL, FR, __,  FC, RL, RR,  FCH, TC  },	// 0x2C
+		{ FL, FR, LFE, FC, RL, RR,  FCH, TC  },	// 0x2D
+		{ FL, FR, __,  FC, RL, RR,  FLH, FRH },	// 0x2E
+		{ FL, FR, LFE, FC, RL, RR,  FLH, FRH },	// 0x2F
+		{ FL, FR, __,  FC, RL, RR,  FLW, FRW },	// 0x30
+		{ FL, FR, LFE, FC, RL, RR,  FLW, FRW },	// 0x31
+	};
+}
+
+bool HDMI_A_GetSpeakerLayout(uint8_t inChannelAllocation, uint32_t outSlotSpeakers[HDMI_A_MAX_CHANNELS], int& outSlotCount, uint32_t& outSpeakerMask)
+{
+	if (inChannelAllocation > HDMI_A_CA_MAX)
+		return false;
+
+	outSlotCount   = 0;
+	outSpeakerMask = 0;
+	for (int slot = 0; slot < HDMI_A_MAX_CHANNELS; slot++)
+	{
+		const uint32_t speaker = kChannelAllocations[inChannelAllocation][slot];
+		outSlotSpeakers[slot] = speaker;
+		outSpeakerMask |= speaker;
+		if (speaker)
+			outSlotCount = slot + 1;
+	}
+	return true;
+}
+
+bool HDMI_A_Decode(const HDMI_GENERIC_INFOFRAME& inFrame, HDMI_AUDIO_INFO& outInfo)
+{
+	if (HDMI_INFOFRAME_TYPE_A != inFrame.header.bfType || inFrame.header.bPayloadLength < 5 || inFrame.header.bPayloadLength > HDMI_MAX_INFOFRAME_PAYLOAD)
+		return false;
+	if (!HDMI_IsInfoFrameValid(&inFrame))
+		return false;
+
+	static const int kSampleSizes[] = { 0, 16, 20, 24 };
+	static const int kSampleRates[] = { 0, 32000, 44100, 48000, 88200, 96000, 176400, 192000 };
+
+	const HDMI_A1_PAYLOAD& a = inFrame.plA1;
+	HDMI_AUDIO_INFO info;
+	info.channelCount       = a.bfChannelCount ? a.bfChannelCount + 1 : 0;
+	info.bCodingType        = a.bfAudioCodingType;
+	info.sampleSize         = kSampleSizes[a.bfSampleSize];
+	info.sampleRate         = kSampleRates[a.bfSampleFrequency];
+	info.bChannelAllocation = a.bChannelAllocation;
+	info.levelShift         = a.bfLevelShiftValue;
+	info.downMixInhibit     = (HDMI_A_DM_PROHIBITED == a.bfDownMixInhibitFlag);
+
+	if (!HDMI_A_GetSpeakerLayout(a.bChannelAllocation, info.slotSpeakers, info.slotCount, info.speakerMask))
+		return false;
+
+	// CC = 0 (2 channels or "refer to stream") with a multichannel CA: trust the CA
+	if (info.channelCount > info.slotCount)
+		info.slotCount = info.channelCount;
+
+	outInfo = info;
+	return true;
+}
+
+
+//====================================================================================
+// # VENDOR SPECIFIC INFOFRAME  (VS)
+//====================================================================================
+
+namespace
+{
+	// PB4 and following (PB1..PB3 hold the OUI)
+	inline const uint8_t* VendorPayload(const HDMI_GENERIC_INFOFRAME& inFrame) { return inFrame.bPayload + 3; }
+
+	bool DecodeHDMI14b(const HDMI_GENERIC_INFOFRAME& inFrame, HDMI_VS_INFO& ioInfo)
+	{
+		const uint8_t* pb = VendorPayload(inFrame);
+		const int len = inFrame.header.bPayloadLength;
+		HDMI_VS_HDMI14B_INFO& vs = ioInfo.hdmi14b;
+		vs.bVideoFormat = pb[0] >> 5;
+		if (HDMI_VS_VF_EXTENDED == vs.bVideoFormat && len >= 5)
+			vs.bHDMIVIC = pb[1];
+		else if (HDMI_VS_VF_3D == vs.bVideoFormat && len >= 5)
+		{
+			vs.b3DStructure = pb[1] >> 4;
+			if (vs.b3DStructure >= 8 && len >= 6)
+				vs.b3DExtData = pb[2] >> 4;
+		}
+
+		// Dolby Vision standard mode: HDMI LLC OUI with a 24 byte payload
+		vs.bDolbyVision = (0x18 == inFrame.header.bPayloadLength);
+		return true;
+	}
+
+	bool DecodeHDMIForum(const HDMI_GENERIC_INFOFRAME& inFrame, HDMI_VS_INFO& ioInfo)
+	{
+		if (inFrame.header.bPayloadLength < 5)
+			return false;
+
+		const uint8_t* pb = VendorPayload(inFrame);
+		HDMI_VS_HDMI_FORUM_INFO& hf = ioInfo.hdmiForum;
+		hf.bVersion = pb[0];
+		hf.b3DValid = (pb[1] & 0x01) != 0;
+		hf.bALLM    = (pb[1] & 0x02) != 0;
+		if (hf.b3DValid && inFrame.header.bPayloadLength >= 6)
+			hf.b3DStructure = pb[2] >> 4;
+		return true;
+	}
+
+	bool DecodeHDR10Plus(const HDMI_GENERIC_INFOFRAME& inFrame, HDMI_VS_INFO& ioInfo)
+	{
+		if (inFrame.header.bPayloadLength < 27)
+			return false;
+
+		const uint8_t* pb = VendorPayload(inFrame);
+		HDMI_VS_HDR10PLUS_INFO& md = ioInfo.hdr10plus;
+		md.bApplicationVersion          = pb[0] >> 6;
+		md.bTargetedSystemDisplayMaxLum = (pb[0] >> 1) & 0x1F;
+		md.bAverageMaxRGB               = pb[1];
+		memcpy(md.bDistributionValues, pb + 2, sizeof(md.bDistributionValues));
+		md.bNumBezierCurveAnchors       = pb[11] >> 4;
+		md.wKneePointX                  = (uint16_t)(((pb[11] & 0x0F) << 6) | (pb[12] >> 2));
+		md.wKneePointY                  = (uint16_t)(((pb[12] & 0x03) << 8) | pb[13]);
+		memcpy(md.bBezierCurveAnchors, pb + 14, sizeof(md.bBezierCurveAnchors));
+		md.bGraphicsOverlay             = (pb[23] & 0x80) != 0;
+		md.bNoDelay                     = (pb[23] & 0x40) != 0;
+		return true;
+	}
+
+	bool DecodeDolby(const HDMI_GENERIC_INFOFRAME& inFrame, HDMI_VS_INFO& ioInfo)
+	{
+		if (inFrame.header.bPayloadLength < 6)
+			return false;
+
+		const uint8_t* pb = VendorPayload(inFrame);
+		HDMI_VS_DOLBY_INFO& dv = ioInfo.dolby;
+		dv.bDolbyVision       = (pb[0] & 0x02) != 0;
+		dv.bLowLatency        = (pb[0] & 0x01) != 0;
+		dv.bBacklightMetadata = (pb[1] & 0x80) != 0;
+		if (dv.bBacklightMetadata)
+			dv.wEffectiveTmaxPQ = (uint16_t)(((pb[1] & 0x0F) << 8) | pb[2]);
+		return true;
+	}
+
+	struct VendorEntry
+	{
+		uint32_t	oui;
+		uint8_t		kind;
+		const char*	name;
+		bool		(*decode)(const HDMI_GENERIC_INFOFRAME&, HDMI_VS_INFO&);
+	};
+
+	// EXTEND_VS_VENDORS: add new vendor specific info frames here
+	constexpr VendorEntry kVendors[] =
+	{
+		{ HDMI_VS_OUI_HDMI_LLC,		HDMI_VS_KIND_HDMI14B,		"HDMI 1.4b",	DecodeHDMI14b },
+		{ HDMI_VS_OUI_HDMI_FORUM,	HDMI_VS_KIND_HDMI_FORUM,	"HDMI Forum",	DecodeHDMIForum },
+		{ HDMI_VS_OUI_HDR10PLUS,	HDMI_VS_KIND_HDR10PLUS,		"HDR10+",		DecodeHDR10Plus },
+		{ HDMI_VS_OUI_DOLBY,		HDMI_VS_KIND_DOLBY,			"Dolby Vision",	DecodeDolby },
+	};
+
+	constexpr const VendorEntry* FindVendor(uint32_t inOUI)
+	{
+		for (const VendorEntry& entry : kVendors)
+			if (entry.oui == inOUI)
+				return &entry;
+		return nullptr;
+	}
+
+	constexpr bool VendorKindsMatchIndex()
+	{
+		for (size_t i = 0; i < sizeof(kVendors) / sizeof(kVendors[0]); i++)
+			if (kVendors[i].kind != i + 1)
+				return false;
+		return true;
+	}
+	static_assert(VendorKindsMatchIndex(), "kVendors must be ordered by HDMI_VS_KIND_*");
+	static_assert(FindVendor(HDMI_VS_OUI_HDR10PLUS)->kind == HDMI_VS_KIND_HDR10PLUS, "OUI lookup");
+}
+
+uint32_t HDMI_VS_GetOUI(const HDMI_GENERIC_INFOFRAME& inFrame)
+{
+	if (HDMI_INFOFRAME_TYPE_VS != inFrame.header.bfType)
+		return 0;
+	const uint8_t* oui = inFrame.plVS1.IEEERegistrationID;
+	return (uint32_t)oui[0] | ((uint32_t)oui[1] << 8) | ((uint32_t)oui[2] << 16);
+}
+
+uint8_t HDMI_VS_GetKind(uint32_t inOUI)
+{
+	const VendorEntry* entry = FindVendor(inOUI);
+	return entry ? entry->kind : HDMI_VS_KIND_UNKNOWN;
+}
+
+const char* HDMI_VS_KindToString(uint8_t inKind)
+{
+	if (inKind >= 1 && inKind <= sizeof(kVendors) / sizeof(kVendors[0]))
+		return kVendors[inKind - 1].name;
+	return "Unknown";
+}
+
+bool HDMI_VS_Decode(const HDMI_GENERIC_INFOFRAME& inFrame, HDMI_VS_INFO& outInfo)
+{
+	if (HDMI_INFOFRAME_TYPE_VS != inFrame.header.bfType || inFrame.header.bPayloadLength < 4 || inFrame.header.bPayloadLength > HDMI_MAX_INFOFRAME_PAYLOAD)
+		return false;
+	if (!HDMI_IsInfoFrameValid(&inFrame))
+		return false;
+
+	HDMI_VS_INFO info;
+	info.dwOUI = HDMI_VS_GetOUI(inFrame);
+	const VendorEntry* entry = FindVendor(info.dwOUI);
+	if (entry)
+	{
+		if (!entry->decode(inFrame, info))
+			return false;
+		info.bKind = entry->kind;
+	}
+	outInfo = info;
+	return true;
+}
@@ -744,3 +744,189 @@ inline bool HDMI_IsInfoFrameValid(const _HDMI_GENERIC_INFOFRAME* pInfoFrame)
 
 
 
+
+
+//------------------------------------------------------------------------------------
+// ## Source Product Description
+//------------------------------------------------------------------------------------
+
+//! @brief Decoded SPD info frame
+typedef struct _HDMI_SPD_INFO
+{
+	std::string		vendorName;				//!< as sent by the source, trailing blanks/NULs removed
+	std::string		manufacturer;			//!< user-friendly name (see HDMI_SPD_MapManufacturerString())
+	std::string		productDescription;		//!< trailing blanks/NULs removed
+	uint8_t			bSourceInformation = HDMI_SPD_SI_UNKNOWN;	//!< see HDMI_SPD_SI_*
+}
+HDMI_SPD_INFO;
+
+//! @brief Decodes an SPD info frame (type, length and checksum are verified)
+bool HDMI_SPD_Decode(const HDMI_GENERIC_INFOFRAME& inFrame, HDMI_SPD_INFO& outInfo);
+
+//! @brief Classifies the source for pipeline presets
+//! @return HDMI_SPD_SI_GAME, HDMI_SPD_SI_PC, HDMI_SPD_SI_BD or HDMI_SPD_SI_UNKNOWN.
+//! Sources that leave the source information at 'unknown' are classified by well-known vendor/product names (e.g. game consoles).
+uint8_t HDMI_SPD_GetSourceClass(const HDMI_SPD_INFO& inInfo);
+
+
+//------------------------------------------------------------------------------------
+// ## Auxiliary Video Information
+//------------------------------------------------------------------------------------
+
+//! @brief Checks type, version (2..4) and checksum of an AVI info frame
+bool HDMI_AVI_IsValid(const HDMI_GENERIC_INFOFRAME& inFrame);
+
+//! @return IT content type (HDMI_AVI_CN_*) or HDMI_ERROR if the frame is invalid or ITC is not set
+int HDMI_AVI_GetITContentType(const HDMI_GENERIC_INFOFRAME& inFrame);
+
+//! @return number of times each pixel is sent (1..10, i.e. PR + 1) or HDMI_ERROR if the frame is invalid
+int HDMI_AVI_GetPixelRepetitionFactor(const HDMI_GENERIC_INFOFRAME& inFrame);
+
+
+//------------------------------------------------------------------------------------
+// ## Audio
+//------------------------------------------------------------------------------------
+
+// Speaker positions, bit values as in WAVEFORMATEXTENSIBLE::dwChannelMask (SPEAKER_*).
+// The canonical channel order is ascending bit order, e.g. 7.1: FL FR FC LFE BL BR SL SR.
+// CEA-861 rear left/right (RL/RR) map to the side speakers, rear left/right center (RLC/RRC) to the back speakers.
+#define HDMI_A_SPEAKER_FL			0x00000001	// front left
+#define HDMI_A_SPEAKER_FR			0x00000002	// front right
+#define HDMI_A_SPEAKER_FC			0x00000004	// front center
+#define HDMI_A_SPEAKER_LFE			0x00000008	// low frequency effects
+#define HDMI_A_SPEAKER_BL			0x00000010	// back left (CEA-861 RLC)
+#define HDMI_A_SPEAKER_BR			0x00000020	// back right (CEA-861 RRC)
+#define HDMI_A_SPEAKER_FLC			0x00000040	// front left of center
+#define HDMI_A_SPEAKER_FRC			0x00000080	// front right of center
+#define HDMI_A_SPEAKER_BC			0x00000100	// back center (CEA-861 RC)
+#define HDMI_A_SPEAKER_SL			0x00000200	// side left (CEA-861 RL)
+#define HDMI_A_SPEAKER_SR			0x00000400	// side right (CEA-861 RR)
+#define HDMI_A_SPEAKER_TC			0x00000800	// top center
+#define HDMI_A_SPEAKER_TFL			0x00001000	// top front left (CEA-861 FLH)
+#define HDMI_A_SPEAKER_TFC			0x00002000	// top front center (CEA-861 FCH)
+#define HDMI_A_SPEAKER_TFR			0x00004000	// top front right (CEA-861 FRH)
+#define HDMI_A_SPEAKER_FLW			0x01000000	// front left wide (no WAVE equivalent)
+#define HDMI_A_SPEAKER_FRW			0x02000000	// front right wide (no WAVE equivalent)
+
+#define HDMI_A_MAX_CHANNELS			8
+#define HDMI_A_CA_MAX				0x31		// highest channel allocation defined by CEA-861-E
+
+//! @brief Decoded audio info frame
+typedef struct _HDMI_AUDIO_INFO
+{
+	int			channelCount		= 0;		//!< 0: refer to stream header
+	uint8_t		bCodingType			= HDMI_A_CT_STREAM;
+	int			sampleSize			= 0;		//!< bits, 0: refer to stream header
+	int			sampleRate			= 0;		//!< Hz, 0: refer to stream header
+	uint8_t		bChannelAllocation	= 0;
+	int			levelShift			= 0;		//!< dB
+	bool		downMixInhibit		= false;
+
+	//! Speaker of each transmitted channel slot (0: slot unused), in transmission order
+	uint32_t	slotSpeakers[HDMI_A_MAX_CHANNELS] = {};
+	int			slotCount			= 2;		//!< number of transmitted slots (highest used slot)
+	uint32_t	speakerMask			= HDMI_A_SPEAKER_FL | HDMI_A_SPEAKER_FR;
+}
+HDMI_AUDIO_INFO;
+
+//! @brief Speaker layout for a CEA-861 channel allocation (CA)
+//! @param outSlotSpeakers HDMI_A_MAX_CHANNELS entries (HDMI_A_SPEAKER_* or 0)
+//! @return false for reserved CA values
+bool HDMI_A_GetSpeakerLayout(uint8_t inChannelAllocation, uint32_t outSlotSpeakers[HDMI_A_MAX_CHANNELS], int& outSlotCount, uint32_t& outSpeakerMask);
+
+//! @brief Decodes an audio info frame (type, length and checksum are verified)
+bool HDMI_A_Decode(const HDMI_GENERIC_INFOFRAME& inFrame, HDMI_AUDIO_INFO& outInfo);
+
+
+//------------------------------------------------------------------------------------
+// ## Vendor specific
+//------------------------------------------------------------------------------------
+
+// IEEE OUIs of the known vendor specific info frames (sent LSB first in PB1..PB3)
+#define HDMI_VS_OUI_HDMI_LLC		0x000C03	// HDMI 1.4b (4K VICs, 3D), also Dolby Vision "standard" tunneling
+#define HDMI_VS_OUI_HDMI_FORUM		0xC45DD8	// HDMI 2.x (ALLM, 3D)
+#define HDMI_VS_OUI_HDR10PLUS		0x90848B	// HDR10+ dynamic metadata (HDR10+ Technologies / Samsung)
+#define HDMI_VS_OUI_DOLBY			0x00D046	// Dolby Vision low latency
+
+// Vendor specific info frame kinds
+#define HDMI_VS_KIND_UNKNOWN		0x00
+#define HDMI_VS_KIND_HDMI14B		0x01
+#define HDMI_VS_KIND_HDMI_FORUM		0x02
+#define HDMI_VS_KIND_HDR10PLUS		0x03
+#define HDMI_VS_KIND_DOLBY			0x04
+
+// HDMI_Video_Format, see HDMI 1.4b chapter 8.2.3, table 8-11
+#define HDMI_VS_VF_NONE				0x00	// no additional format
+#define HDMI_VS_VF_EXTENDED			0x01	// extended resolution format (HDMI_VIC follows)
+#define HDMI_VS_VF_3D				0x02	// 3D format (3D_Structure follows)
+
+//! @brief HDMI 1.4b vendor specific info frame
+typedef struct _HDMI_VS_HDMI14B_INFO
+{
+	uint8_t		bVideoFormat		= HDMI_VS_VF_NONE;	//!< HDMI_VS_VF_*
+	uint8_t		bHDMIVIC			= 0;		//!< 1: 4K30, 2: 4K25, 3: 4K24, 4: 4K24 SMPTE (HDMI_VS_VF_EXTENDED)
+	uint8_t		b3DStructure		= 0;		//!< 0: frame packing .. 6: top-and-bottom, 8: side-by-side half (HDMI_VS_VF_3D)
+	uint8_t		b3DExtData			= 0;		//!< sub-sampling for side-by-side half
+	bool		bDolbyVision		= false;	//!< 24 byte payload: Dolby Vision standard (tunneled) mode
+}
+HDMI_VS_HDMI14B_INFO;
+
+//! @brief HDMI Forum vendor specific info frame (HF-VSIF), see HDMI 2.1 chapter 10.2
+typedef struct _HDMI_VS_HDMI_FORUM_INFO
+{
+	uint8_t		bVersion			= 0;
+	bool		b3DValid			= false;
+	bool		bALLM				= false;	//!< auto low latency mode requested by the source
+	uint8_t		b3DStructure		= 0;		//!< if b3DValid
+}
+HDMI_VS_HDMI_FORUM_INFO;
+
+//! @brief HDR10+ vendor specific info frame (dynamic metadata, sent every frame)
+typedef struct _HDMI_VS_HDR10PLUS_INFO
+{
+	uint8_t		bApplicationVersion				= 0;
+	uint8_t		bTargetedSystemDisplayMaxLum	= 0;	//!< 5 bit code
+	uint8_t		bAverageMaxRGB					= 0;	//!< 8 bit code
+	uint8_t		bDistributionValues[9]			= {};
+	uint8_t		bNumBezierCurveAnchors			= 0;
+	uint16_t	wKneePointX						= 0;	//!< 10 bit
+	uint16_t	wKneePointY						= 0;	//!< 10 bit
+	uint8_t		bBezierCurveAnchors[9]			= {};
+	bool		bGraphicsOverlay				= false;
+	bool		bNoDelay						= false;
+}
+HDMI_VS_HDR10PLUS_INFO;
+
+//! @brief Dolby vendor specific info frame (Dolby Vision low latency / source-led mode)
+typedef struct _HDMI_VS_DOLBY_INFO
+{
+	bool		bDolbyVision					= false;	//!< Dolby_Vision_Signal
+	bool		bLowLatency						= false;
+	bool		bBacklightMetadata				= false;	//!< Backlt_Ctrl_MD_Present
+	uint16_t	wEffectiveTmaxPQ				= 0;		//!< 12 bit PQ code, if bBacklightMetadata
+}
+HDMI_VS_DOLBY_INFO;
+
+//! @brief Decoded vendor specific info frame; only the member for bKind is filled in
+typedef struct _HDMI_VS_INFO
+{
+	uint32_t					dwOUI	= 0;
+	uint8_t						bKind	= HDMI_VS_KIND_UNKNOWN;		//!< HDMI_VS_KIND_*
+	HDMI_VS_HDMI14B_INFO		hdmi14b;
+	HDMI_VS_HDMI_FORUM_INFO		hdmiForum;
+	HDMI_VS_HDR10PLUS_INFO		hdr10plus;
+	HDMI_VS_DOLBY_INFO			dolby;
+}
+HDMI_VS_INFO;
+
+//! @return IEEE OUI of a vendor specific info frame (0 for other types)
+uint32_t HDMI_VS_GetOUI(const HDMI_GENERIC_INFOFRAME& inFrame);
+
+//! @return HDMI_VS_KIND_* for an OUI
+uint8_t HDMI_VS_GetKind(uint32_t inOUI);
+
+const char* HDMI_VS_KindToString(uint8_t inKind);
+
+//! @brief Decodes a vendor specific info frame (type, length and checksum are verified)
+//! @return false for invalid frames; unknown OUIs decode to HDMI_VS_KIND_UNKNOWN
+bool HDMI_VS_Decode(const HDMI_GENERIC_INFOFRAME& inFrame, HDMI_VS_INFO& outInfo);
@@ -0,0 +1,240 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIPixelRepetition.cpp
+
+@brief		Removes HDMI pixel repetition (AVI PR field) from captured frames
+**/
+//==============================================================================
+
+#include "HDMIPixelRepetition.h"
+#include "EGAVCPUFeatures.h"
+
+#include <cstring>
+
+
+static const int kMaxRepetitionFactor = HDMI_AVI_PR_9 + 1;
+
+
+//==============================================================================
+// # Row kernels
+//==============================================================================
+
+//! @brief Keeps every n-th element; T is the element (Y sample, UV pair)
+template <typename T>
+static void DecimateRowScalar(const uint8_t* inRow, uint8_t* outRow, int inOutCount, int inFactor)
+{
+	const T* in = (const T*)inRow;
+	T* out = (T*)outRow;
+	for (int i = 0; i < inOutCount; i++)
+		out[i] = in[i * inFactor];
+}
+
+//! @brief YUY2: output macropixel k holds the pixels 2kn and (2k+1)n, chroma of input macropixel kn
+static void DecimateRowYUY2Scalar(const uint8_t* inRow, uint8_t* outRow, int inOutWidth, int inFactor)
+{
+	for (int k = 0; k < inOutWidth / 2; k++)
+	{
+		const int x0 = 2 * k * inFactor, x1 = x0 + inFactor;
+		const uint8_t* mp = inRow + 2 * x0; // x0 is even
+		outRow[4 * k + 0] = mp[0];
+		outRow[4 * k + 1] = mp[1];
+		outRow[4 * k + 2] = inRow[2 * x1];
+		outRow[4 * k + 3] = mp[3];
+	}
+}
+
+#if EGAV_X86
+
+// Factor 2 kernels (SSE2): 16 output bytes per iteration
+
+static void DecimateRow8x2SSE2(const uint8_t* inRow, uint8_t* outRow, int inOutCount)
+{
+	const __m128i mask = _mm_set1_epi16(0x00FF);
+	int i = 0;
+	for (; i + 16 <= inOutCount; i += 16)
+	{
+		__m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i*)(inRow + 2 * i)), mask);
+		__m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i*)(inRow + 2 * i + 16)), mask);
+		_mm_storeu_si128((__m128i*)(outRow + i), _mm_packus_epi16(a, b));
+	}
+	DecimateRowScalar<uint8_t>(inRow + 2 * i, outRow + i, inOutCount - i, 2);
+}
+
+static void DecimateRow16x2SSE2(const uint8_t* inRow, uint8_t* outRow, int inOutCount)
+{
+	int i = 0;
+	for (; i + 8 <= inOutCount; i += 8)
+	{
+		// sign-extend the even words to 32 bit so the saturating pack keeps them unchanged
+		__m128i a = _mm_srai_epi32(_mm_slli_epi32(_mm_loadu_si128((const __m128i*)(inRow + 4 * i)), 16), 16);
+		__m128i b = _mm_srai_epi32(_mm_slli_epi32(_mm_loadu_si128((const __m128i*)(inRow + 4 * i + 16)), 16), 16);
+		_mm_storeu_si128((__m128i*)(outRow + 2 * i), _mm_packs_epi32(a, b));
+	}
+	DecimateRowScalar<uint16_t>(inRow + 4 * i, outRow + 2 * i, inOutCount - i, 2);
+}
+
+static void DecimateRow32x2SSE2(const uint8_t* inRow, uint8_t* outRow, int inOutCount)
+{
+	int i = 0;
+	for (; i + 4 <= inOutCount; i += 4)
+	{
+		__m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(inRow + 8 * i)));
+		__m128 b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(inRow + 8 * i + 16)));
+		_mm_storeu_si128((__m128i*)(outRow + 4 * i), _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))));
+	}
+	DecimateRowScalar<uint32_t>(inRow + 8 * i, outRow + 4 * i, inOutCount - i, 2);
+}
+
+static void DecimateRowYUY2x2SSE2(const uint8_t* inRow, uint8_t* outRow, int inOutWidth)
+{
+	// Two input macropixels [Y0 U Y1 V][Y2 U' Y3 V'] -> [Y0 U Y2 V]
+	const __m128i keep  = _mm_set_epi32(0, (int)0xFF00FFFF, 0, (int)0xFF00FFFF);
+	const __m128i lowY  = _mm_set_epi32(0, 0xFF, 0, 0xFF);
+	int k = 0;
+	for (; k + 4 <= inOutWidth / 2; k += 4)
+	{
+		__m128i x0 = _mm_loadu_si128((const __m128i*)(inRow + 8 * k));
+		__m128i x1 = _mm_loadu_si128((const __m128i*)(inRow + 8 * k + 16));
+		x0 = _mm_or_si128(_mm_and_si128(x0, keep), _mm_slli_epi64(_mm_and_si128(_mm_srli_epi64(x0, 32), lowY), 16));
+		x1 = _mm_or_si128(_mm_and_si128(x1, keep), _mm_slli_epi64(_mm_and_si128(_mm_srli_epi64(x1, 32), lowY), 16));
+		__m128 packed = _mm_shuffle_ps(_mm_castsi128_ps(x0), _mm_castsi128_ps(x1), _MM_SHUFFLE(2, 0, 2, 0));
+		_mm_storeu_si128((__m128i*)(outRow + 4 * k), _mm_castps_si128(packed));
+	}
+	DecimateRowYUY2Scalar(inRow + 8 * k, outRow + 4 * k, inOutWidth - 2 * k, 2);
+}
+
+#endif // EGAV_X86
+
+
+//==============================================================================
+// # Plane helpers
+//==============================================================================
+
+//! @param inElementSize 1, 2 or 4 bytes
+static void DecimatePlane(const uint8_t* inPlane, int inStride, uint8_t* outPlane, int outStride,
+						  int inOutCount, int inRows, int inElementSize, int inFactor, bool inUseSIMD)
+{
+	for (int y = 0; y < inRows; y++)
+	{
+		const uint8_t* in = inPlane + (size_t)y * inStride;
+		uint8_t* out = outPlane + (size_t)y * outStride;
+
+		if (inFactor == 1)
+		{
+			memcpy(out, in, (size_t)inOutCount * inElementSize);
+			continue;
+		}
+#if EGAV_X86
+		if (inUseSIMD && inFactor == 2)
+		{
+			switch (inElementSize)
+			{
+				case 1: DecimateRow8x2SSE2(in, out, inOutCount);  continue;
+				case 2: DecimateRow16x2SSE2(in, out, inOutCount); continue;
+				case 4: DecimateRow32x2SSE2(in, out, inOutCount); continue;
+			}
+		}
+#else
+		(void)inUseSIMD;
+#endif
+		switch (inElementSize)
+		{
+			case 1: DecimateRowScalar<uint8_t>(in, out, inOutCount, inFactor);  break;
+			case 2: DecimateRowScalar<uint16_t>(in, out, inOutCount, inFactor); break;
+			case 4: DecimateRowScalar<uint32_t>(in, out, inOutCount, inFactor); break;
+		}
+	}
+}
+
+static EGAVResult RemovePixelRepetition420(const uint8_t* inY, int inYStride, const uint8_t* inUV, int inUVStride,
+										   uint8_t* outY, int outYStride, uint8_t* outUV, int outUVStride,
+										   int inWidth, int inHeight, int inFactor, int inBytesPerSample, bool inUseSIMD)
+{
+	EGAVResult_CheckPointer(inY);
+	EGAVResult_CheckPointer(inUV);
+	EGAVResult_CheckPointer(outY);
+	EGAVResult_CheckPointer(outUV);
+	if (inFactor < 1 || inFactor > kMaxRepetitionFactor || inHeight <= 0 || (inHeight & 1))
+		return EGAVResult::ErrInvalidParameter;
+
+	const int outWidth = HDMI_GetDecimatedWidth(inWidth, inFactor);
+	if (outWidth <= 0)
+		return EGAVResult::ErrInvalidParameter;
+
+	DecimatePlane(inY, inYStride, outY, outYStride, outWidth, inHeight, inBytesPerSample, inFactor, inUseSIMD);
+	DecimatePlane(inUV, inUVStride, outUV, outUVStride, outWidth / 2, inHeight / 2, 2 * inBytesPerSample, inFactor, inUseSIMD);
+	return EGAVResult::Ok;
+}
+
+
+//==============================================================================
+// # Functions
+//==============================================================================
+
+EGAVResult HDMI_RemovePixelRepetitionNV12(const uint8_t* inY, int inYStride, const uint8_t* inUV, int inUVStride,
+										  uint8_t* outY, int outYStride, uint8_t* outUV, int outUVStride,
+										  int inWidth, int inHeight, int inFactor, bool inUseSIMD /*= true*/)
+{
+	return RemovePixelRepetition420(inY, inYStride, inUV, inUVStride, outY, outYStride, outUV, outUVStride, inWidth, inHeight, inFactor, 1, inUseSIMD);
+}
+
+EGAVResult HDMI_RemovePixelRepetitionP010(const uint8_t* inY, int inYStride, const uint8_t* inUV, int inUVStride,
+										  uint8_t* outY, int outYStride, uint8_t* outUV, int outUVStride,
+										  int inWidth, int inHeight, int inFactor, bool inUseSIMD /*= true*/)
+{
+	return RemovePixelRepetition420(inY, inYStride, inUV, inUVStride, outY, outYStride, outUV, outUVStride, inWidth, inHeight, inFactor, 2, inUseSIMD);
+}
+
+EGAVResult HDMI_RemovePixelRepetitionYUY2(const uint8_t* inYUY2, int inStride, uint8_t* outYUY2, int outStride,
+										  int inWidth, int inHeight, int inFactor, bool inUseSIMD /*= true*/)
+{
+	EGAVResult_CheckPointer(inYUY2);
+	EGAVResult_CheckPointer(outYUY2);
+	if (inFactor < 1 || inFactor > kMaxRepetitionFactor || inHeight <= 0)
+		return EGAVResult::ErrInvalidParameter;
+
+	const int outWidth = HDMI_GetDecimatedWidth(inWidth, inFactor);
+	if (outWidth <= 0)
+		return EGAVResult::ErrInvalidParameter;
+
+	for (int y = 0; y < inHeight; y++)
+	{
+		const uint8_t* in = inYUY2 + (size_t)y * inStride;
+		uint8_t* out = outYUY2 + (size_t)y * outStride;
+
+		if (inFactor == 1)
+			memcpy(out, in, (size_t)outWidth * 2);
+#if EGAV_X86
+		else if (inUseSIMD && inFactor == 2)
+			DecimateRowYUY2x2SSE2(in, out, outWidth);
+#endif
+		else
+			DecimateRowYUY2Scalar(in, out, outWidth, inFactor);
+	}
+	(void)inUseSIMD;
+	return EGAVResult::Ok;
+}
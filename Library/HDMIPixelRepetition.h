@@ -0,0 +1,60 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIPixelRepetition.h
+
+@brief		Removes HDMI pixel repetition (AVI PR field) from captured frames.
+
+			With a repetition factor n every pixel is sent n times, so only every n-th
+			pixel is kept. The output width is inWidth / n (even for the 4:2:x formats).
+			Factor 2 (the common case, e.g. 720(1440)x480i) has an SSE2 fast path.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+
+#include "EGAVResult.h"
+#include "HDMIInfoFramesAPI.h"
+
+
+//! @return output width for the repetition factor (even, as required by NV12, P010 and YUY2)
+inline int HDMI_GetDecimatedWidth(int inWidth, int inFactor) { return (inFactor > 0) ? (inWidth / inFactor) & ~1 : 0; }
+
+//! @brief NV12: Y and interleaved UV planes; strides in bytes
+EGAVResult HDMI_RemovePixelRepetitionNV12(const uint8_t* inY, int inYStride, const uint8_t* inUV, int inUVStride,
+										  uint8_t* outY, int outYStride, uint8_t* outUV, int outUVStride,
+										  int inWidth, int inHeight, int inFactor, bool inUseSIMD = true);
+
+//! @brief P010: 16 bit Y and interleaved UV planes; strides in bytes
+EGAVResult HDMI_RemovePixelRepetitionP010(const uint8_t* inY, int inYStride, const uint8_t* inUV, int inUVStride,
+										  uint8_t* outY, int outYStride, uint8_t* outUV, int outUVStride,
+										  int inWidth, int inHeight, int inFactor, bool inUseSIMD = true);
+
+//! @brief YUY2: packed Y0 U Y1 V; strides in bytes
+EGAVResult HDMI_RemovePixelRepetitionYUY2(const uint8_t* inYUY2, int inStride, uint8_t* outYUY2, int outStride,
+										  int inWidth, int inHeight, int inFactor, bool inUseSIMD = true);
@@ -0,0 +1,154 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIVendorInfoFrameParser.cpp
+
+@brief		Streaming parser for vendor specific info frames
+**/
+//==============================================================================
+
+#include "HDMIVendorInfoFrameParser.h"
+
+#include <cstring>
+#include <utility>
+
+
+HDMIVendorInfoFrameParser::HDMIVendorInfoFrameParser(ChangeCallback inCallback /*= nullptr*/)
+	: mCallback(std::move(inCallback))
+{
+}
+
+void HDMIVendorInfoFrameParser::Reset()
+{
+	for (VendorState& vendor : mVendors)
+		vendor = VendorState();
+	mStatistics  = Statistics();
+	mPendingSize = 0;
+}
+
+bool HDMIVendorInfoFrameParser::Parse(const HDMI_GENERIC_INFOFRAME& inFrame, bool* outChanged /*= nullptr*/)
+{
+	if (outChanged)
+		*outChanged = false;
+	if (HDMI_INFOFRAME_TYPE_VS != inFrame.header.bfType)
+		return false;
+
+	mStatistics.framesParsed++;
+	const size_t size = sizeof(HDMI_INFOFRAMEHEADER) + 1 + inFrame.header.bPayloadLength;
+	if (inFrame.header.bPayloadLength < 4 || size > HDMI_MAX_INFOFRAME_SIZE)
+	{
+		mStatistics.framesInvalid++;
+		return false;
+	}
+
+	// Fast path: same bytes as the last frame of this vendor (the checksum was verified then)
+	VendorState& vendor = mVendors[HDMI_VS_GetKind(HDMI_VS_GetOUI(inFrame))];
+	if (vendor.valid && memcmp(vendor.raw, &inFrame, size) == 0)
+		return true;
+
+	HDMI_VS_INFO info;
+	if (!HDMI_VS_Decode(inFrame, info))
+	{
+		mStatistics.framesInvalid++;
+		return false;
+	}
+
+	mStatistics.framesDecoded++;
+	memset(vendor.raw, 0, sizeof(vendor.raw));
+	memcpy(vendor.raw, &inFrame, size);
+	vendor.info  = info;
+	vendor.valid = true;
+	if (outChanged)
+		*outChanged = true;
+	if (mCallback)
+		mCallback(vendor.info);
+	return true;
+}
+
+size_t HDMIVendorInfoFrameParser::Feed(const uint8_t* inData, size_t inSize)
+{
+	static const size_t kHeaderSize = sizeof(HDMI_INFOFRAMEHEADER) + 1;
+
+	auto drop = [this](size_t inCount)
+	{
+		mPendingSize -= inCount;
+		memmove(mPending, mPending + inCount, mPendingSize);
+	};
+
+	size_t frames = 0;
+	while (inSize > 0)
+	{
+		const size_t n = (sizeof(mPending) - mPendingSize < inSize) ? sizeof(mPending) - mPendingSize : inSize;
+		memcpy(mPending + mPendingSize, inData, n);
+		mPendingSize += n;
+		inData += n;
+		inSize -= n;
+
+		while (mPendingSize >= kHeaderSize)
+		{
+			const uint8_t type = mPending[0] & 0x7F;
+			const size_t size = kHeaderSize + mPending[2];
+			if (type < HDMI_INFOFRAME_TYPE_MIN || type > HDMI_INFOFRAME_TYPE_MAX || mPending[2] > HDMI_MAX_INFOFRAME_PAYLOAD)
+			{
+				// Not an info frame header: resynchronize byte by byte
+				drop(1);
+				mStatistics.bytesSkipped++;
+				continue;
+			}
+			if (mPendingSize < size)
+				break;
+
+			HDMI_GENERIC_INFOFRAME frame{};
+			memcpy(&frame, mPending, size);
+			if (HDMI_IsInfoFrameValid(&frame))
+			{
+				drop(size);
+				frames++;
+				Parse(frame);
+			}
+			else
+			{
+				drop(1);
+				mStatistics.bytesSkipped++;
+			}
+		}
+	}
+	return frames;
+}
+
+bool HDMIVendorInfoFrameParser::GetInfo(uint8_t inKind, HDMI_VS_INFO& outInfo) const
+{
+	if (inKind >= kKindCount || !mVendors[inKind].valid)
+		return false;
+	outInfo = mVendors[inKind].info;
+	return true;
+}
+
+const HDMI_VS_HDR10PLUS_INFO* HDMIVendorInfoFrameParser::GetHDR10PlusMetadata() const
+{
+	const VendorState& vendor = mVendors[HDMI_VS_KIND_HDR10PLUS];
+	return vendor.valid ? &vendor.info.hdr10plus : nullptr;
+}
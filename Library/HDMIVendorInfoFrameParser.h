@@ -0,0 +1,105 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDMIVendorInfoFrameParser.h
+
+@brief		Streaming parser for vendor specific info frames (HDMI 1.4b, HDMI Forum,
+			HDR10+, Dolby Vision).
+
+			HDR10+ sources send new dynamic metadata with every video frame, most
+			other vendor info frames repeat unchanged. The parser keeps the last frame
+			per vendor and only decodes when the bytes differ, so it can run on every
+			captured frame. Feed() accepts raw info frame bytes in arbitrary chunks
+			(e.g. HID reads or a journal file) and reassembles the frames.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "HDMIInfoFramesAPI.h"
+
+
+//==============================================================================
+// # Class HDMIVendorInfoFrameParser
+//==============================================================================
+
+class HDMIVendorInfoFrameParser
+{
+public:
+	//! @brief Called for every vendor specific info frame whose content changed
+	typedef std::function<void(const HDMI_VS_INFO& inInfo)> ChangeCallback;
+
+	struct Statistics
+	{
+		uint64_t	framesParsed	= 0;	//!< vendor specific frames seen
+		uint64_t	framesDecoded	= 0;	//!< ... that were new or changed
+		uint64_t	framesInvalid	= 0;	//!< wrong length or checksum
+		uint64_t	bytesSkipped	= 0;	//!< stream bytes dropped while resynchronizing
+	};
+
+	explicit HDMIVendorInfoFrameParser(ChangeCallback inCallback = nullptr);
+
+	//! @brief Parses one info frame; other info frame types are ignored
+	//! @return true if it is a valid vendor specific info frame
+	bool Parse(const HDMI_GENERIC_INFOFRAME& inFrame, bool* outChanged = nullptr);
+
+	//! @brief Appends raw info frame bytes (header, checksum, payload; back to back)
+	//! @return number of complete info frames found
+	size_t Feed(const uint8_t* inData, size_t inSize);
+
+	//! @brief Last decoded info frame of a vendor
+	//! @return false if none was received since the last Reset()
+	bool GetInfo(uint8_t inKind, HDMI_VS_INFO& outInfo) const;
+
+	//! @brief Current HDR10+ dynamic metadata (nullptr if none was received)
+	const HDMI_VS_HDR10PLUS_INFO* GetHDR10PlusMetadata() const;
+
+	const Statistics& GetStatistics() const { return mStatistics; }
+
+	void Reset();
+
+private:
+	static const int kKindCount = HDMI_VS_KIND_DOLBY + 1;
+
+	struct VendorState
+	{
+		bool					valid	= false;
+		uint8_t					raw[HDMI_MAX_INFOFRAME_SIZE] = {};	//!< header, checksum and payload of the last frame
+		HDMI_VS_INFO			info;
+	};
+
+	ChangeCallback			mCallback;
+	VendorState				mVendors[kKindCount];
+	Statistics				mStatistics;
+
+	// Feed() reassembly
+	uint8_t					mPending[HDMI_MAX_INFOFRAME_SIZE] = {};
+	size_t					mPendingSize	= 0;
+};
@@ -0,0 +1,246 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDRContentClassifier.cpp
+
+@brief		Content-based HDR detection for P010 frames
+**/
+//==============================================================================
+
+#include "HDRContentClassifier.h"
+#include "EGAVCPUFeatures.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+//==============================================================================
+// # Constants
+//==============================================================================
+
+static const int	kBlockPixels		= 16;		//!< pixels per sampled block (one AVX2 register)
+static const int	kBinShift			= 6;		//!< 10 bit code -> bin (64 codes per bin)
+static const int	kBlackCode			= 80;		//!< codes below: black (HDRLumaHistogram::black)
+
+static const float	kSmoothing			= 0.1f;		//!< weight of a new frame in the smoothed vote
+static const float	kMinBrightFraction	= 0.05f;	//!< frames with less content above code 448 carry no evidence
+static const float	kSDRTopFraction		= 0.02f;	//!< above code 832: ~4000 cd/m2 in PQ, common in SDR
+static const float	kPQHighFraction		= 0.005f;	//!< above code 768: ~1500 cd/m2 in PQ
+static const float	kPQMidFraction		= 0.10f;	//!< codes 448..767: HDR diffuse white / SDR mid tones
+static const float	kPQMaxShadowFraction = 0.25f;	//!< codes 80..191 of the non-black pixels: below 1 cd/m2 in PQ, dim SDR shadows
+
+
+//==============================================================================
+// # Histogram kernels
+//==============================================================================
+
+static void HistogramRowScalar(const uint16_t* inRow, int inBlocks, int inColumnStep, HDRLumaHistogram& ioHistogram)
+{
+	for (int block = 0; block < inBlocks; block += inColumnStep)
+	{
+		const uint16_t* p = inRow + block * kBlockPixels;
+		for (int i = 0; i < kBlockPixels; i++)
+		{
+			const int code = p[i] >> 6;
+			ioHistogram.bins[code >> kBinShift]++;
+			if (code < kBlackCode)
+				ioHistogram.black++;
+		}
+	}
+}
+
+#if EGAV_X86
+
+//! @brief Sum of the 16 bit counters
+EGAV_TARGET_AVX2 static uint32_t HorizontalSumAVX2(__m256i inCounters)
+{
+	__m256i sum32 = _mm256_madd_epi16(inCounters, _mm256_set1_epi16(1));
+	__m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum32), _mm256_extracti128_si256(sum32, 1));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (uint32_t)_mm_cvtsi128_si32(s);
+}
+
+//! @brief Cumulative counts (code >= bin start) via compares; bins are the differences
+EGAV_TARGET_AVX2 static void HistogramRowAVX2(const uint16_t* inRow, int inBlocks, int inColumnStep, HDRLumaHistogram& ioHistogram)
+{
+	const int kBins = HDRLumaHistogram::kBinCount;
+
+	__m256i ge[kBins];		// ge[k]: lanes with bin >= k (16 bit counters, k >= 1)
+	for (int k = 0; k < kBins; k++)
+		ge[k] = _mm256_setzero_si256();
+	__m256i black = _mm256_setzero_si256();
+	const __m256i blackCode = _mm256_set1_epi16((short)kBlackCode);
+
+	int samples = 0;
+	for (int block = 0; block < inBlocks; block += inColumnStep)
+	{
+		const __m256i code = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i*)(inRow + block * kBlockPixels)), 6);
+		const __m256i bin = _mm256_srli_epi16(code, kBinShift);
+		for (int k = 1; k < kBins; k++)
+			ge[k] = _mm256_sub_epi16(ge[k], _mm256_cmpgt_epi16(bin, _mm256_set1_epi16((short)(k - 1))));
+		black = _mm256_sub_epi16(black, _mm256_cmpgt_epi16(blackCode, code));
+		samples += kBlockPixels;
+	}
+
+	// Horizontal sums (row length keeps each 16 bit lane far below overflow)
+	uint32_t cumulative[kBins + 1] = {};
+	cumulative[0] = samples;
+	for (int k = 1; k < kBins; k++)
+		cumulative[k] = HorizontalSumAVX2(ge[k]);
+	for (int k = 0; k < kBins; k++)
+		ioHistogram.bins[k] += cumulative[k] - cumulative[k + 1];
+	ioHistogram.black += HorizontalSumAVX2(black);
+}
+
+#endif // EGAV_X86
+
+
+//==============================================================================
+// # Class HDRContentClassifier
+//==============================================================================
+
+HDRContentClassifier::HDRContentClassifier(int inRowStep /*= 4*/, int inColumnStep /*= 4*/)
+	: mRowStep(std::max(1, inRowStep)), mColumnStep(std::max(1, inColumnStep))
+{
+}
+
+void HDRContentClassifier::ComputeHistogram(const uint8_t* inY, int inYStride, int inWidth, int inHeight, HDRLumaHistogram& outHistogram) const
+{
+	outHistogram = HDRLumaHistogram();
+	if (!inY || inWidth < kBlockPixels || inHeight <= 0)
+		return;
+
+	auto rowKernel = HistogramRowScalar;
+#if EGAV_X86
+	if (mSIMDEnabled && EGAV_CPUHasAVX2())
+		rowKernel = HistogramRowAVX2;
+#endif
+
+	const int blocks = inWidth / kBlockPixels;
+	for (int y = 0; y < inHeight; y += mRowStep)
+		rowKernel((const uint16_t*)(inY + (size_t)y * inYStride), blocks, mColumnStep, outHistogram);
+
+	for (int k = 0; k < HDRLumaHistogram::kBinCount; k++)
+		outHistogram.total += outHistogram.bins[k];
+}
+
+HDRContentEstimate HDRContentClassifier::Classify(const HDRLumaHistogram& inHistogram)
+{
+	HDRContentEstimate estimate;
+	if (inHistogram.total == 0)
+		return estimate;
+
+	auto fraction = [&inHistogram](int inFirstBin, int inEndBin)
+	{
+		uint32_t count = 0;
+		for (int k = inFirstBin; k < inEndBin; k++)
+			count += inHistogram.bins[k];
+		return (float)count / inHistogram.total;
+	};
+
+	const float bright = fraction(7, 16);	// >= 448
+	const float mid    = fraction(7, 12);	// 448..767
+	const float high   = fraction(12, 16);	// >= 768
+	const float top    = fraction(13, 16);	// >= 832
+
+	// Shadows 80..191 of the non-black pixels (black bars don't dilute them)
+	const uint32_t nonBlack = inHistogram.total - std::min(inHistogram.black, inHistogram.total);
+	const uint32_t dark     = inHistogram.bins[0] + inHistogram.bins[1] + inHistogram.bins[2];
+	const float shadow      = nonBlack ? (float)(dark - std::min(inHistogram.black, dark)) / nonBlack : 0.f;
+
+	if (bright < kMinBrightFraction)
+		return estimate; // dark frame: both curves look alike
+
+	if (top >= kSDRTopFraction)
+	{
+		estimate.kind       = HDRContentKind::SDR;
+		estimate.confidence = std::min(1.f, top / (4 * kSDRTopFraction));
+	}
+	else if (high <= kPQHighFraction && mid >= kPQMidFraction && shadow <= kPQMaxShadowFraction)
+	{
+		estimate.kind       = HDRContentKind::PQ;
+		estimate.confidence = std::min(1.f, mid / (3 * kPQMidFraction)) * (1.f - high / kPQHighFraction * 0.5f);
+	}
+	return estimate;
+}
+
+HDRContentEstimate HDRContentClassifier::AddFrame(const uint8_t* inY, int inYStride, int inWidth, int inHeight)
+{
+	HDRLumaHistogram histogram;
+	ComputeHistogram(inY, inYStride, inWidth, inHeight, histogram);
+
+	HDRContentEstimate frame = Classify(histogram);
+	if (frame.kind != HDRContentKind::Unknown)
+	{
+		float vote = (frame.kind == HDRContentKind::PQ) ? frame.confidence : -frame.confidence;
+		mScore += kSmoothing * (vote - mScore);
+	}
+	return GetEstimate();
+}
+
+HDRContentEstimate HDRContentClassifier::GetEstimate() const
+{
+	HDRContentEstimate estimate;
+	if (mScore > 0.2f)
+		estimate.kind = HDRContentKind::PQ;
+	else if (mScore < -0.2f)
+		estimate.kind = HDRContentKind::SDR;
+	estimate.confidence = std::min(1.f, mScore < 0 ? -mScore : mScore);
+	return estimate;
+}
+
+
+//==============================================================================
+// # Combined decision
+//==============================================================================
+
+EGAVResult HDR_CombineDecision(const EGAVResult& inInfoFrameResult, const HDMI_GENERIC_INFOFRAME& inInfoFrame, const HDRContentEstimate& inContent, bool& outIsHDR)
+{
+	const float kOverrideConfidence = 0.6f;
+
+	static const HDMI_GENERIC_INFOFRAME emptyFrame{};
+	const bool missing = (inInfoFrameResult == EGAVResult::ErrNoData) ||
+						 (inInfoFrameResult.Succeeded() && 0 == memcmp(&inInfoFrame, &emptyFrame, sizeof(emptyFrame)));
+	if (!missing && inInfoFrameResult.Succeeded() && HDMI_IsInfoFrameValid(&inInfoFrame) && HDMI_INFOFRAME_TYPE_DR == inInfoFrame.header.bfType)
+	{
+		outIsHDR = (HDMI_DR_EOTF_SDRGAMMA != inInfoFrame.plDR1.bfEOTF);
+		return EGAVResult::Ok;
+	}
+
+	// Missing or invalid info frame: the content decides if it is confident
+	if (inContent.kind != HDRContentKind::Unknown && inContent.confidence >= kOverrideConfidence)
+	{
+		outIsHDR = (inContent.kind == HDRContentKind::PQ);
+		return EGAVResult::Ok;
+	}
+	if (missing)
+	{
+		outIsHDR = false;
+		return EGAVResult::Ok;
+	}
+	return inInfoFrameResult.Failed() ? inInfoFrameResult : EGAVResult(EGAVResult::ErrInvalidFormat);
+}
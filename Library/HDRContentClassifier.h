@@ -0,0 +1,116 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDRContentClassifier.h
+
+@brief		Content-based HDR detection for P010 frames.
+
+			Fallback for sources that send PQ video with a missing or broken DR info frame.
+			A subsampled luma code-value histogram tells PQ from SDR gamma: SDR puts diffuse
+			white near code 940, PQ puts it near code 570 (203 cd/m2) and rarely uses the top
+			of the code range. A dim SDR frame can look the same from above, but gamma 2.4
+			crushes its shadows towards black, where PQ keeps them above code ~190 (1 cd/m2).
+			The estimate is only a fallback: a valid DR info frame always decides
+			(HDR_CombineDecision()).
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+
+#include "EGAVResult.h"
+#include "HDMIInfoFramesAPI.h"
+
+
+//==============================================================================
+// # Types
+//==============================================================================
+
+enum class HDRContentKind
+{
+	Unknown,	//!< not enough evidence (e.g. dark or flat frames)
+	SDR,		//!< SDR gamma
+	PQ,			//!< SMPTE ST 2084
+};
+
+struct HDRContentEstimate
+{
+	HDRContentKind	kind		= HDRContentKind::Unknown;
+	float			confidence	= 0;	//!< 0..1
+};
+
+//! @brief Luma histogram of a P010 frame, 16 bins of 64 code values (10 bit)
+struct HDRLumaHistogram
+{
+	static const int kBinCount = 16;
+
+	uint32_t	bins[kBinCount]	= {};
+	uint32_t	black			= 0;	//!< codes below 80 (limited range black and its noise), also counted in bins
+	uint32_t	total			= 0;
+};
+
+
+//==============================================================================
+// # Class HDRContentClassifier
+//==============================================================================
+
+class HDRContentClassifier
+{
+public:
+	//! @param inRowStep / inColumnStep subsampling: every n-th row, every n-th block of 16 pixels
+	HDRContentClassifier(int inRowStep = 4, int inColumnStep = 4);
+
+	//! @brief Histograms the Y plane of a P010 frame (AVX2 if available) and updates the estimate
+	//! @param inYStride in bytes
+	HDRContentEstimate AddFrame(const uint8_t* inY, int inYStride, int inWidth, int inHeight);
+
+	//! @brief Classifies a single histogram (no temporal smoothing)
+	static HDRContentEstimate Classify(const HDRLumaHistogram& inHistogram);
+
+	//! @brief Computes the subsampled histogram
+	void ComputeHistogram(const uint8_t* inY, int inYStride, int inWidth, int inHeight, HDRLumaHistogram& outHistogram) const;
+
+	//! @brief Forces the scalar kernel (reference for the SIMD path)
+	void SetSIMDEnabled(bool inEnable) { mSIMDEnabled = inEnable; }
+
+	HDRContentEstimate GetEstimate() const;
+	void Reset() { mScore = 0; }
+
+private:
+	int		mRowStep		= 4;
+	int		mColumnStep		= 4;
+	bool	mSIMDEnabled	= true;
+	float	mScore			= 0;	//!< smoothed vote: -1 SDR .. +1 PQ
+};
+
+
+//! @brief Combines the DR info frame (result and frame of ElgatoUVCDevice::GetHDMIHDRStatusPacket()) with a content estimate.
+//! A valid DR info frame decides, HDR or not. The content estimate is only used if the info frame is missing
+//! (ErrNoData or an all zero frame) or invalid (read error, checksum, other type): a confident estimate decides,
+//! otherwise a missing info frame means SDR.
+//! @return Ok if a decision was made, otherwise inInfoFrameResult (ErrInvalidFormat for an invalid frame that was read)
+EGAVResult HDR_CombineDecision(const EGAVResult& inInfoFrameResult, const HDMI_GENERIC_INFOFRAME& inInfoFrame, const HDRContentEstimate& inContent, bool& outIsHDR);
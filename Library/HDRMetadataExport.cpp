@@ -0,0 +1,243 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDRMetadataExport.cpp
+
+@brief		HDMI DR info frame to HEVC SEI / AV1 OBU / Matroska conversion
+**/
+//==============================================================================
+
+#include "HDRMetadataExport.h"
+
+#include <cmath>
+#include <cstring>
+
+
+//==============================================================================
+// # Constants
+//==============================================================================
+
+static const float kChromaticityUnit	= 0.00002f;	//!< HDMI and HEVC: xy in units of 0.00002
+static const float kMinLuminanceUnit	= 0.0001f;	//!< HDMI: min. luminance in units of 0.0001 cd/m2
+
+enum class HEVCSEIPayloadType
+{
+	MasteringDisplayColourVolume	= 137,
+	ContentLightLevelInfo			= 144,
+};
+
+static const uint8_t kHEVCNALTypePrefixSEI	= 39;
+static const uint8_t kAV1OBUTypeMetadata	= 5;
+
+enum class AV1MetadataType
+{
+	HDR_CLL		= 1,
+	HDR_MDCV	= 2,
+};
+
+
+//==============================================================================
+// # Helpers
+//==============================================================================
+
+static uint8_t* PutBE16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)(v >> 8); p[1] = (uint8_t)v; return p + 2; }
+static uint8_t* PutBE32(uint8_t* p, uint32_t v) { p = PutBE16(p, (uint16_t)(v >> 16)); return PutBE16(p, (uint16_t)v); }
+
+static uint16_t ToFixed16(float inValue, float inScale)
+{
+	float v = std::round(inValue * inScale);
+	return (uint16_t)(v < 0 ? 0 : (v > 65535.f ? 65535.f : v));
+}
+
+//! @brief Sorts the info frame primaries into red, green, blue order.
+//! CTA-861.3 does not mandate an order; sources usually send G, B, R (HEVC order).
+//! Red has the largest x, green the largest y of the remaining two.
+static void GetPrimaryOrderRGB(const HDMI_DR1_PAYLOAD& inPayload, int outIndex[3])
+{
+	const HDMI_XY* p = inPayload.xyDisplayPrimaries;
+
+	int red = 0;
+	for (int i = 1; i < 3; i++)
+		if (p[i].X > p[red].X) red = i;
+
+	int a = (red + 1) % 3, b = (red + 2) % 3;
+	int green = (p[a].Y >= p[b].Y) ? a : b;
+	int blue  = (green == a) ? b : a;
+
+	if (p[red].X == 0 && p[green].Y == 0) // no primaries signalled: assume HEVC order
+	{
+		red = 2; green = 0; blue = 1;
+	}
+
+	outIndex[0] = red;
+	outIndex[1] = green;
+	outIndex[2] = blue;
+}
+
+//! @brief Inserts emulation prevention bytes (0x000003) into a NAL unit payload
+static void AppendEscaped(std::vector<uint8_t>& ioNAL, const uint8_t* inData, size_t inSize)
+{
+	int zeros = 0;
+	for (size_t i = 0; i < inSize; i++)
+	{
+		if (zeros >= 2 && inData[i] <= 3)
+		{
+			ioNAL.push_back(3);
+			zeros = 0;
+		}
+		ioNAL.push_back(inData[i]);
+		zeros = (inData[i] == 0) ? zeros + 1 : 0;
+	}
+}
+
+
+//==============================================================================
+// # Class HDRMetadataExporter
+//==============================================================================
+
+EGAVResult HDRMetadataExporter::Convert(const HDMI_GENERIC_INFOFRAME& inFrame, HDRMetadataExport& outExport)
+{
+	if (!HDMI_IsInfoFrameValid(&inFrame) || HDMI_INFOFRAME_TYPE_DR != inFrame.header.bfType || HDMI_DR_MD_STATIC != inFrame.plDR1.bfMetadataID)
+		return EGAVResult::ErrInvalidFormat;
+
+	const HDMI_DR1_PAYLOAD& dr = inFrame.plDR1;
+
+	int rgb[3];
+	GetPrimaryOrderRGB(dr, rgb);
+
+	//------------------------------------------------------------------------------
+	// Normalised values
+	//------------------------------------------------------------------------------
+	HDRMasteringMetadata& md = outExport.metadata;
+	md.eotf = dr.bfEOTF;
+	for (int c = 0; c < 3; c++)
+	{
+		md.primaries[c][0] = dr.xyDisplayPrimaries[rgb[c]].X * kChromaticityUnit;
+		md.primaries[c][1] = dr.xyDisplayPrimaries[rgb[c]].Y * kChromaticityUnit;
+	}
+	md.whitePoint[0] = dr.xyWhitePoint.X * kChromaticityUnit;
+	md.whitePoint[1] = dr.xyWhitePoint.Y * kChromaticityUnit;
+	md.maxLuminance  = (float)dr.wMaxDisplayLuminance;
+	md.minLuminance  = dr.wMinDisplayLuminance * kMinLuminanceUnit;
+	md.maxCLL        = dr.wMaxCLL;
+	md.maxFALL       = dr.wMaxFALL;
+
+	//------------------------------------------------------------------------------
+	// HEVC SEI (H.265 D.2.28, D.2.35): primaries in G, B, R order, big endian
+	//------------------------------------------------------------------------------
+	uint8_t* p = outExport.hevcMasteringDisplayColourVolume.data();
+	const int hevcOrder[3] = { rgb[1], rgb[2], rgb[0] };
+	for (int c = 0; c < 3; c++)
+	{
+		p = PutBE16(p, dr.xyDisplayPrimaries[hevcOrder[c]].X);
+		p = PutBE16(p, dr.xyDisplayPrimaries[hevcOrder[c]].Y);
+	}
+	p = PutBE16(p, dr.xyWhitePoint.X);
+	p = PutBE16(p, dr.xyWhitePoint.Y);
+	p = PutBE32(p, (uint32_t)dr.wMaxDisplayLuminance * 10000);	// units of 0.0001 cd/m2
+	p = PutBE32(p, (uint32_t)dr.wMinDisplayLuminance);			// already 0.0001 cd/m2
+
+	p = outExport.hevcContentLightLevelInfo.data();
+	p = PutBE16(p, dr.wMaxCLL);
+	p = PutBE16(p, dr.wMaxFALL);
+
+	std::vector<uint8_t> rbsp;
+	rbsp.push_back((uint8_t)HEVCSEIPayloadType::MasteringDisplayColourVolume);
+	rbsp.push_back((uint8_t)outExport.hevcMasteringDisplayColourVolume.size());
+	rbsp.insert(rbsp.end(), outExport.hevcMasteringDisplayColourVolume.begin(), outExport.hevcMasteringDisplayColourVolume.end());
+	rbsp.push_back((uint8_t)HEVCSEIPayloadType::ContentLightLevelInfo);
+	rbsp.push_back((uint8_t)outExport.hevcContentLightLevelInfo.size());
+	rbsp.insert(rbsp.end(), outExport.hevcContentLightLevelInfo.begin(), outExport.hevcContentLightLevelInfo.end());
+	rbsp.push_back(0x80); // rbsp_trailing_bits
+
+	outExport.hevcSEINALUnit.clear();
+	outExport.hevcSEINALUnit.push_back((uint8_t)(kHEVCNALTypePrefixSEI << 1));	// forbidden_zero_bit, nal_unit_type, nuh_layer_id (high bit)
+	outExport.hevcSEINALUnit.push_back(1);										// nuh_layer_id (low bits), nuh_temporal_id_plus1
+	AppendEscaped(outExport.hevcSEINALUnit, rbsp.data(), rbsp.size());
+
+	//------------------------------------------------------------------------------
+	// AV1 metadata OBUs (AV1 5.8.3, 5.8.4): primaries in R, G, B order, 0.16 fixed point
+	//------------------------------------------------------------------------------
+	p = outExport.av1MasteringDisplayOBU.data();
+	*p++ = (uint8_t)(kAV1OBUTypeMetadata << 3) | 0x02;						// obu_type, obu_has_size_field
+	*p++ = (uint8_t)(outExport.av1MasteringDisplayOBU.size() - 2);			// obu_size (leb128, < 128)
+	*p++ = (uint8_t)AV1MetadataType::HDR_MDCV;
+	for (int c = 0; c < 3; c++)
+	{
+		p = PutBE16(p, ToFixed16(md.primaries[c][0], 65536.f));
+		p = PutBE16(p, ToFixed16(md.primaries[c][1], 65536.f));
+	}
+	p = PutBE16(p, ToFixed16(md.whitePoint[0], 65536.f));
+	p = PutBE16(p, ToFixed16(md.whitePoint[1], 65536.f));
+	p = PutBE32(p, (uint32_t)dr.wMaxDisplayLuminance << 8);								// 24.8 fixed point
+	p = PutBE32(p, (uint32_t)std::lround(dr.wMinDisplayLuminance * kMinLuminanceUnit * 16384.0));	// 18.14 fixed point
+	*p++ = 0x80; // trailing_bits
+
+	p = outExport.av1ContentLightLevelOBU.data();
+	*p++ = (uint8_t)(kAV1OBUTypeMetadata << 3) | 0x02;
+	*p++ = (uint8_t)(outExport.av1ContentLightLevelOBU.size() - 2);
+	*p++ = (uint8_t)AV1MetadataType::HDR_CLL;
+	p = PutBE16(p, dr.wMaxCLL);
+	p = PutBE16(p, dr.wMaxFALL);
+	*p++ = 0x80;
+
+	//------------------------------------------------------------------------------
+	// Matroska
+	//------------------------------------------------------------------------------
+	HDRMatroskaColour& mkv = outExport.mkv;
+	mkv.transferCharacteristics = (HDMI_DR_EOTF_ST2084 == dr.bfEOTF) ? 16 : (HDMI_DR_EOTF_HLG == dr.bfEOTF) ? 18 : 2;
+	mkv.maxCLL                  = dr.wMaxCLL;
+	mkv.maxFALL                 = dr.wMaxFALL;
+	mkv.primaryRChromaticityX   = md.primaries[0][0];
+	mkv.primaryRChromaticityY   = md.primaries[0][1];
+	mkv.primaryGChromaticityX   = md.primaries[1][0];
+	mkv.primaryGChromaticityY   = md.primaries[1][1];
+	mkv.primaryBChromaticityX   = md.primaries[2][0];
+	mkv.primaryBChromaticityY   = md.primaries[2][1];
+	mkv.whitePointChromaticityX = md.whitePoint[0];
+	mkv.whitePointChromaticityY = md.whitePoint[1];
+	mkv.luminanceMax            = md.maxLuminance;
+	mkv.luminanceMin            = md.minLuminance;
+
+	return EGAVResult::Ok;
+}
+
+std::shared_ptr<const HDRMetadataExport> HDRMetadataExporter::Update(const HDMI_GENERIC_INFOFRAME& inFrame)
+{
+	// Fast path: same info frame as last time
+	if (mHasLastFrame && 0 == memcmp(&inFrame, &mLastFrame, sizeof(inFrame)))
+		return mCurrent;
+
+	mLastFrame    = inFrame;
+	mHasLastFrame = true;
+
+	auto result = std::make_shared<HDRMetadataExport>();
+	if (Convert(inFrame, *result).Succeeded())
+		mCurrent = result;
+	else
+		mCurrent = nullptr;
+	return mCurrent;
+}
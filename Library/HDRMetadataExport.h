@@ -0,0 +1,127 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDRMetadataExport.h
+
+@brief		Converts the HDMI Dynamic Range and Mastering info frame (HDMI_DR1_PAYLOAD)
+			to SMPTE ST 2086 / content light level metadata for encoders and muxers:
+			HEVC SEI, AV1 metadata OBUs and Matroska Colour elements.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "EGAVResult.h"
+#include "HDMIInfoFramesAPI.h"
+
+
+//==============================================================================
+// # Types
+//==============================================================================
+
+//! @brief Normalised ST 2086 mastering display and content light level values
+struct HDRMasteringMetadata
+{
+	uint8_t		eotf				= HDMI_DR_EOTF_SDRGAMMA;	//!< HDMI_DR_EOTF_*
+	float		primaries[3][2]		= {};	//!< CIE 1931 xy of red, green, blue (in this order)
+	float		whitePoint[2]		= {};	//!< CIE 1931 xy
+	float		maxLuminance		= 0;	//!< cd/m2
+	float		minLuminance		= 0;	//!< cd/m2
+	uint16_t	maxCLL				= 0;	//!< cd/m2, 0 if unknown
+	uint16_t	maxFALL				= 0;	//!< cd/m2, 0 if unknown
+};
+
+//! @brief Matroska Video/Colour element values
+struct HDRMatroskaColour
+{
+	uint64_t	matrixCoefficients			= 9;	//!< BT.2020 non-constant luminance
+	uint64_t	transferCharacteristics		= 2;	//!< 16: ST 2084 (PQ), 18: ARIB STD-B67 (HLG), 2: unspecified
+	uint64_t	primaries					= 9;	//!< BT.2020
+	uint64_t	maxCLL						= 0;
+	uint64_t	maxFALL						= 0;
+
+	// MasteringMetadata
+	float		primaryRChromaticityX		= 0;
+	float		primaryRChromaticityY		= 0;
+	float		primaryGChromaticityX		= 0;
+	float		primaryGChromaticityY		= 0;
+	float		primaryBChromaticityX		= 0;
+	float		primaryBChromaticityY		= 0;
+	float		whitePointChromaticityX		= 0;
+	float		whitePointChromaticityY		= 0;
+	float		luminanceMax				= 0;
+	float		luminanceMin				= 0;
+};
+
+//! @brief All representations of one DR info frame. Immutable once created by HDRMetadataExporter.
+struct HDRMetadataExport
+{
+	HDRMasteringMetadata		metadata;
+
+	//! HEVC SEI payloads (without payloadType/payloadSize)
+	std::array<uint8_t, 24>		hevcMasteringDisplayColourVolume{};		//!< payloadType 137
+	std::array<uint8_t, 4>		hevcContentLightLevelInfo{};			//!< payloadType 144
+
+	//! Prefix SEI NAL unit containing both messages, emulation prevention applied, without start code
+	std::vector<uint8_t>		hevcSEINALUnit;
+
+	//! Complete AV1 metadata OBUs (obu_header with obu_has_size_field, size, payload)
+	std::array<uint8_t, 28>		av1MasteringDisplayOBU{};				//!< METADATA_TYPE_HDR_MDCV
+	std::array<uint8_t, 8>		av1ContentLightLevelOBU{};				//!< METADATA_TYPE_HDR_CLL
+
+	HDRMatroskaColour			mkv;
+};
+
+
+//==============================================================================
+// # Class HDRMetadataExporter
+//==============================================================================
+
+//! @brief Converts DR info frames and caches the result.
+//!        The conversion only runs if the info frame changed, otherwise Update() just hands out the cached pointer.
+class HDRMetadataExporter
+{
+public:
+	//! @brief Converts one DR info frame (no caching)
+	//! @return ErrInvalidFormat if the frame is not a valid DR info frame with static metadata type 1
+	static EGAVResult Convert(const HDMI_GENERIC_INFOFRAME& inFrame, HDRMetadataExport& outExport);
+
+	//! @brief Returns the export for inFrame, nullptr if inFrame is not a valid DR info frame.
+	std::shared_ptr<const HDRMetadataExport> Update(const HDMI_GENERIC_INFOFRAME& inFrame);
+
+	//! @return result of the last Update() call
+	std::shared_ptr<const HDRMetadataExport> GetCurrent() const { return mCurrent; }
+
+private:
+	HDMI_GENERIC_INFOFRAME						mLastFrame{};
+	bool										mHasLastFrame = false;
+	std::shared_ptr<const HDRMetadataExport>	mCurrent;
+};
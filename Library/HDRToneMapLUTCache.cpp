@@ -0,0 +1,172 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDRToneMapLUTCache.cpp
+
+@brief		LRU cache of tonemapping LUTs keyed by the decoded DR info frame
+**/
+//==============================================================================
+
+#include "HDRToneMapLUTCache.h"
+
+#include <cstring>
+
+
+//==============================================================================
+// # Class HDRToneMapLUTCache
+//==============================================================================
+
+HDRToneMapLUTCache::HDRToneMapLUTCache(size_t inCapacity /*= 8*/, float inTargetPeak /*= 203.f*/)
+	: mCapacity(inCapacity > 0 ? inCapacity : 1), mTargetPeak(inTargetPeak)
+{
+	mWorker = std::thread(&HDRToneMapLUTCache::WorkerThread, this);
+}
+
+HDRToneMapLUTCache::~HDRToneMapLUTCache()
+{
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mCondition.notify_all();
+	mWorker.join();
+}
+
+uint64_t HDRToneMapLUTCache::GetKey(const HDRToneMapParams& inParams)
+{
+	// FNV-1a over the fields that define the curves
+	uint64_t hash = 0xCBF29CE484222325ull;
+	auto add = [&hash](const void* inData, size_t inSize)
+	{
+		const uint8_t* p = (const uint8_t*)inData;
+		for (size_t i = 0; i < inSize; i++)
+		{
+			hash ^= p[i];
+			hash *= 0x100000001B3ull;
+		}
+	};
+	add(&inParams.eotf,        sizeof(inParams.eotf));
+	add(&inParams.sourcePeak,  sizeof(inParams.sourcePeak));
+	add(&inParams.sourceBlack, sizeof(inParams.sourceBlack));
+	add(&inParams.targetPeak,  sizeof(inParams.targetPeak));
+	return hash;
+}
+
+std::shared_ptr<const HDRToneMapLUT> HDRToneMapLUTCache::Acquire(const HDMI_DR1_PAYLOAD& inPayload)
+{
+	HDRToneMapParams params = HDRToneMapParams::FromInfoFrame(inPayload);
+	params.targetPeak = mTargetPeak;
+	return Acquire(params);
+}
+
+std::shared_ptr<const HDRToneMapLUT> HDRToneMapLUTCache::Acquire(const HDRToneMapParams& inParams)
+{
+	const uint64_t key = GetKey(inParams);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	auto it = mEntries.find(key);
+	if (it != mEntries.end())
+	{
+		mLRU.splice(mLRU.begin(), mLRU, it->second.lruPosition);
+		mHits++;
+		return it->second.lut;
+	}
+
+	mMisses++;
+	if (mPending.insert(key).second)
+	{
+		mQueue.push_back(inParams);
+		lock.unlock();
+		mCondition.notify_all();
+	}
+	return nullptr;
+}
+
+void HDRToneMapLUTCache::WaitForPendingBuilds()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mCondition.wait(lock, [this] { return mPending.empty() || mStop; });
+}
+
+std::shared_ptr<const HDRToneMapLUT> HDRToneMapLUTCache::Build(const HDRToneMapParams& inParams)
+{
+	auto lut = std::make_shared<HDRToneMapLUT>();
+	lut->key    = GetKey(inParams);
+	lut->curves = HDRToneMapCurves::Build(inParams);
+
+	const int n = HDRToneMapLUT::k3DSize;
+	lut->lut3D.resize((size_t)n * n * n * 3);
+	float* out = lut->lut3D.data();
+	for (int b = 0; b < n; b++)
+	{
+		for (int g = 0; g < n; g++)
+		{
+			for (int r = 0; r < n; r++)
+			{
+				const float rgb[3] = { (float)r / (n - 1), (float)g / (n - 1), (float)b / (n - 1) };
+				lut->curves->Apply(rgb, out);
+				out += 3;
+			}
+		}
+	}
+	return lut;
+}
+
+void HDRToneMapLUTCache::Insert(std::shared_ptr<const HDRToneMapLUT> inLUT)
+{
+	// mMutex is locked by the caller
+	mLRU.push_front(inLUT->key);
+	mEntries[inLUT->key] = Entry{ inLUT, mLRU.begin() };
+
+	while (mEntries.size() > mCapacity)
+	{
+		mEntries.erase(mLRU.back());
+		mLRU.pop_back();
+	}
+}
+
+void HDRToneMapLUTCache::WorkerThread()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (;;)
+	{
+		mCondition.wait(lock, [this] { return mStop || !mQueue.empty(); });
+		if (mStop)
+			break;
+
+		HDRToneMapParams params = mQueue.front();
+		mQueue.pop_front();
+
+		lock.unlock();
+		std::shared_ptr<const HDRToneMapLUT> lut = Build(params);
+		lock.lock();
+
+		Insert(lut);
+		mPending.erase(lut->key);
+		mCondition.notify_all();
+	}
+}
@@ -0,0 +1,116 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDRToneMapLUTCache.h
+
+@brief		LRU cache of tonemapping LUTs keyed by the decoded DR info frame.
+
+			LUTs are built on a background thread. Acquire() never blocks on a build:
+			on a miss it queues the build and returns nullptr, so the caller keeps
+			using its previous LUT until the new one is ready.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "HDRToneMapper.h"
+
+
+//! @brief 1D curves (for HDRToneMapper) and a 3D LUT (e.g. for a GPU preview) of one parameter set
+struct HDRToneMapLUT
+{
+	static const int k3DSize = 33;	//!< grid points per axis
+
+	uint64_t									key = 0;
+	std::shared_ptr<const HDRToneMapCurves>		curves;
+
+	//! Non-linear BT.2020 R'G'B' -> non-linear BT.709 R'G'B', RGB triplets, red varies fastest
+	std::vector<float>							lut3D;
+};
+
+
+//==============================================================================
+// # Class HDRToneMapLUTCache
+//==============================================================================
+
+class HDRToneMapLUTCache
+{
+public:
+	//! @param inCapacity max. number of cached LUTs (least recently used are evicted)
+	HDRToneMapLUTCache(size_t inCapacity = 8, float inTargetPeak = 203.f);
+	~HDRToneMapLUTCache();
+
+	//! @return cache key: hash of the tonemapping parameters decoded from the DR payload
+	static uint64_t GetKey(const HDRToneMapParams& inParams);
+
+	//! @brief Returns the LUT for the DR payload, or nullptr if it is still being built (build is queued).
+	std::shared_ptr<const HDRToneMapLUT> Acquire(const HDMI_DR1_PAYLOAD& inPayload);
+	std::shared_ptr<const HDRToneMapLUT> Acquire(const HDRToneMapParams& inParams);
+
+	//! @brief Blocks until all queued builds are finished (e.g. for prewarming)
+	void WaitForPendingBuilds();
+
+	//! @brief Builds a LUT synchronously (used by the background thread)
+	static std::shared_ptr<const HDRToneMapLUT> Build(const HDRToneMapParams& inParams);
+
+	size_t GetHitCount() const  { return mHits; }
+	size_t GetMissCount() const { return mMisses; }
+
+private:
+	void WorkerThread();
+	void Insert(std::shared_ptr<const HDRToneMapLUT> inLUT);
+
+	struct Entry
+	{
+		std::shared_ptr<const HDRToneMapLUT>	lut;
+		std::list<uint64_t>::iterator			lruPosition;
+	};
+
+	const size_t								mCapacity;
+	const float									mTargetPeak;
+
+	std::mutex									mMutex;
+	std::condition_variable						mCondition;
+	std::unordered_map<uint64_t, Entry>			mEntries;
+	std::list<uint64_t>							mLRU;			//!< front: most recently used
+	std::deque<HDRToneMapParams>				mQueue;			//!< pending builds
+	std::unordered_set<uint64_t>				mPending;		//!< keys queued or being built
+	bool										mStop = false;
+	std::atomic<size_t>							mHits{ 0 }, mMisses{ 0 };
+
+	std::thread									mWorker;
+};
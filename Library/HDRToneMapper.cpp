@@ -0,0 +1,403 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDRToneMapper.cpp
+
+@brief		Software HDR to SDR tonemapping (P010 -> NV12)
+**/
+//==============================================================================
+
+#include "HDRToneMapper.h"
+#include "EGAVCPUFeatures.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+
+//==============================================================================
+// # Constants
+//==============================================================================
+
+// P010 input: 10 bit limited range BT.2020 non-constant luminance
+static const float kYOffset10	= 64.f,  kYScale10	= 1.f / 876.f;
+static const float kCOffset10	= 512.f, kCScale10	= 1.f / 896.f;
+
+static const float kBT2020_CrR	=  1.4746f;
+static const float kBT2020_CbG	= -0.16455f;
+static const float kBT2020_CrG	= -0.57135f;
+static const float kBT2020_CbB	=  1.8814f;
+
+// BT.2020 -> BT.709 primaries, linear light (BT.2087)
+static const float kGamut[3][3] =
+{
+	{  1.6605f, -0.5876f, -0.0728f },
+	{ -0.1246f,  1.1329f, -0.0083f },
+	{ -0.0182f, -0.1006f,  1.1187f },
+};
+
+// NV12 output: 8 bit limited range BT.709
+static const float kBT709_Kr	= 0.2126f, kBT709_Kg = 0.7152f, kBT709_Kb = 0.0722f;
+static const float kBT709_Cb	= 1.f / 1.8556f;
+static const float kBT709_Cr	= 1.f / 1.5748f;
+static const float kYOffset8	= 16.f,  kYScale8	= 219.f;
+static const float kCOffset8	= 128.f, kCScale8	= 224.f;
+
+
+//==============================================================================
+// # Transfer functions
+//==============================================================================
+
+static double PQ_EOTF(double inValue) //!< non-linear 0..1 -> cd/m2
+{
+	const double m1 = 2610.0 / 16384.0, m2 = 2523.0 / 4096.0 * 128.0;
+	const double c1 = 3424.0 / 4096.0, c2 = 2413.0 / 4096.0 * 32.0, c3 = 2392.0 / 4096.0 * 32.0;
+	double p = std::pow(std::max(inValue, 0.0), 1.0 / m2);
+	return 10000.0 * std::pow(std::max(p - c1, 0.0) / (c2 - c3 * p), 1.0 / m1);
+}
+
+static double PQ_InverseEOTF(double inNits) //!< cd/m2 -> non-linear 0..1
+{
+	const double m1 = 2610.0 / 16384.0, m2 = 2523.0 / 4096.0 * 128.0;
+	const double c1 = 3424.0 / 4096.0, c2 = 2413.0 / 4096.0 * 32.0, c3 = 2392.0 / 4096.0 * 32.0;
+	double y = std::pow(std::max(inNits, 0.0) / 10000.0, m1);
+	return std::pow((c1 + c2 * y) / (1.0 + c3 * y), m2);
+}
+
+//! HLG inverse OETF followed by a per-channel display OOTF (BT.2100), non-linear 0..1 -> cd/m2
+static double HLG_EOTF(double inValue, double inPeakNits)
+{
+	const double a = 0.17883277, b = 0.28466892, c = 0.55991073;
+	double e = (inValue <= 0.5) ? inValue * inValue / 3.0 : (std::exp((inValue - c) / a) + b) / 12.0;
+	double gamma = 1.2 + 0.42 * std::log10(inPeakNits / 1000.0);
+	return inPeakNits * std::pow(e, gamma);
+}
+
+//! BT.2390 EETF: maps [sourceBlack, sourcePeak] to [0, targetPeak] with a hermite knee in PQ space
+static double BT2390_EETF(double inNits, const HDRToneMapParams& inParams)
+{
+	const double pqBlack = PQ_InverseEOTF(inParams.sourceBlack);
+	const double pqWhite = PQ_InverseEOTF(inParams.sourcePeak);
+	const double range   = pqWhite - pqBlack;
+	if (range <= 0)
+		return std::min(inNits, (double)inParams.targetPeak);
+
+	double e      = std::min(std::max((PQ_InverseEOTF(inNits) - pqBlack) / range, 0.0), 1.0);
+	double maxLum = (PQ_InverseEOTF(inParams.targetPeak) - pqBlack) / range;
+	if (maxLum < 1.0)
+	{
+		double ks = 1.5 * maxLum - 0.5;
+		if (e > ks)
+		{
+			double t = (e - ks) / (1.0 - ks), t2 = t * t, t3 = t2 * t;
+			e = (2 * t3 - 3 * t2 + 1) * ks + (t3 - 2 * t2 + t) * (1.0 - ks) + (-2 * t3 + 3 * t2) * maxLum;
+		}
+	}
+	return PQ_EOTF(e * range + pqBlack);
+}
+
+
+//==============================================================================
+// # HDRToneMapParams / HDRToneMapCurves
+//==============================================================================
+
+HDRToneMapParams HDRToneMapParams::FromInfoFrame(const HDMI_DR1_PAYLOAD& inPayload)
+{
+	HDRToneMapParams params;
+	params.eotf = (HDMI_DR_EOTF_HLG == inPayload.bfEOTF) ? HDMI_DR_EOTF_HLG : HDMI_DR_EOTF_ST2084;
+	if (inPayload.wMaxCLL > 0)
+		params.sourcePeak = inPayload.wMaxCLL;
+	else if (inPayload.wMaxDisplayLuminance > 0)
+		params.sourcePeak = inPayload.wMaxDisplayLuminance;
+	params.sourceBlack = inPayload.wMinDisplayLuminance * 0.0001f;
+	return params;
+}
+
+bool HDRToneMapParams::operator==(const HDRToneMapParams& inOther) const
+{
+	return eotf == inOther.eotf && sourcePeak == inOther.sourcePeak && sourceBlack == inOther.sourceBlack && targetPeak == inOther.targetPeak;
+}
+
+std::shared_ptr<const HDRToneMapCurves> HDRToneMapCurves::Build(const HDRToneMapParams& inParams)
+{
+	auto curves = std::make_shared<HDRToneMapCurves>();
+	curves->params = inParams;
+
+	for (int i = 0; i < kInputSize; i++)
+	{
+		double v    = (double)i / (kInputSize - 1);
+		double nits = (HDMI_DR_EOTF_HLG == inParams.eotf) ? HLG_EOTF(v, inParams.sourcePeak) : PQ_EOTF(v);
+		curves->eotf[i] = (float)(nits / inParams.targetPeak);
+		curves->gain[i] = (nits > 0) ? (float)(BT2390_EETF(nits, inParams) / nits) : 1.f;
+	}
+	for (int i = 0; i < kOutputSize; i++)
+		curves->oetf[i] = (float)std::pow((double)i / (kOutputSize - 1), 1.0 / 2.4);
+
+	return curves;
+}
+
+
+//==============================================================================
+// # Kernels
+//==============================================================================
+
+static inline float Clamp01(float v) { return v < 0.f ? 0.f : (v > 1.f ? 1.f : v); }
+
+//! @brief Tonemaps one pixel given non-linear BT.2020 R'G'B', returns non-linear BT.709 R'G'B'
+static inline void ToneMapPixel(const HDRToneMapCurves& c, float r, float g, float b, float out[3])
+{
+	const float scaleIn = HDRToneMapCurves::kInputSize - 1, scaleOut = HDRToneMapCurves::kOutputSize - 1;
+	r = Clamp01(r); g = Clamp01(g); b = Clamp01(b);
+
+	float gain = c.gain[std::lrint(std::max(r, std::max(g, b)) * scaleIn)];
+	float lr = c.eotf[std::lrint(r * scaleIn)] * gain;
+	float lg = c.eotf[std::lrint(g * scaleIn)] * gain;
+	float lb = c.eotf[std::lrint(b * scaleIn)] * gain;
+
+	for (int i = 0; i < 3; i++)
+	{
+		float v = Clamp01(kGamut[i][0] * lr + kGamut[i][1] * lg + kGamut[i][2] * lb);
+		out[i] = c.oetf[std::lrint(v * scaleOut)];
+	}
+}
+
+void HDRToneMapCurves::Apply(const float inRGB[3], float outRGB[3]) const
+{
+	ToneMapPixel(*this, inRGB[0], inRGB[1], inRGB[2], outRGB);
+}
+
+static inline uint8_t ToByte(float v) { return (uint8_t)std::min(std::max(std::lrint(v), 0L), 255L); }
+
+static void RowPairScalar(const HDRToneMapCurves& c, const uint16_t* inY0, const uint16_t* inY1, const uint16_t* inUV,
+						  uint8_t* outY0, uint8_t* outY1, uint8_t* outUV, int inWidth, int inStart)
+{
+	for (int x = inStart; x < inWidth; x += 2)
+	{
+		float cb = ((inUV[x]     >> 6) - kCOffset10) * kCScale10;
+		float cr = ((inUV[x + 1] >> 6) - kCOffset10) * kCScale10;
+		float dr = kBT2020_CrR * cr, dg = kBT2020_CbG * cb + kBT2020_CrG * cr, db = kBT2020_CbB * cb;
+
+		float sum[3] = { 0, 0, 0 };
+		const uint16_t* rows[2] = { inY0, inY1 };
+		uint8_t* outRows[2] = { outY0, outY1 };
+		for (int row = 0; row < 2; row++)
+		{
+			for (int i = 0; i < 2; i++)
+			{
+				float y = ((rows[row][x + i] >> 6) - kYOffset10) * kYScale10;
+				float rgb[3];
+				ToneMapPixel(c, y + dr, y + dg, y + db, rgb);
+				outRows[row][x + i] = ToByte(kYOffset8 + kYScale8 * (kBT709_Kr * rgb[0] + kBT709_Kg * rgb[1] + kBT709_Kb * rgb[2]));
+				sum[0] += rgb[0]; sum[1] += rgb[1]; sum[2] += rgb[2];
+			}
+		}
+
+		float r = sum[0] * 0.25f, g = sum[1] * 0.25f, b = sum[2] * 0.25f;
+		float y = kBT709_Kr * r + kBT709_Kg * g + kBT709_Kb * b;
+		outUV[x]     = ToByte(kCOffset8 + kCScale8 * (b - y) * kBT709_Cb);
+		outUV[x + 1] = ToByte(kCOffset8 + kCScale8 * (r - y) * kBT709_Cr);
+	}
+}
+
+static void RowPairScalarKernel(const HDRToneMapCurves& c, const uint16_t* inY0, const uint16_t* inY1, const uint16_t* inUV,
+								uint8_t* outY0, uint8_t* outY1, uint8_t* outUV, int inWidth)
+{
+	RowPairScalar(c, inY0, inY1, inUV, outY0, outY1, outUV, inWidth, 0);
+}
+
+#if EGAV_X86
+
+//! @brief 8 pixels: non-linear BT.2020 R'G'B' -> non-linear BT.709 R'G'B'
+EGAV_TARGET_AVX2 static inline void ToneMap8(const HDRToneMapCurves& c, __m256 r, __m256 g, __m256 b, __m256& outR, __m256& outG, __m256& outB)
+{
+	const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f);
+	const __m256 scaleIn  = _mm256_set1_ps(HDRToneMapCurves::kInputSize - 1);
+	const __m256 scaleOut = _mm256_set1_ps(HDRToneMapCurves::kOutputSize - 1);
+
+	r = _mm256_min_ps(_mm256_max_ps(r, zero), one);
+	g = _mm256_min_ps(_mm256_max_ps(g, zero), one);
+	b = _mm256_min_ps(_mm256_max_ps(b, zero), one);
+
+	__m256 m    = _mm256_max_ps(r, _mm256_max_ps(g, b));
+	__m256 gain = _mm256_i32gather_ps(c.gain, _mm256_cvtps_epi32(_mm256_mul_ps(m, scaleIn)), 4);
+	__m256 lr   = _mm256_mul_ps(_mm256_i32gather_ps(c.eotf, _mm256_cvtps_epi32(_mm256_mul_ps(r, scaleIn)), 4), gain);
+	__m256 lg   = _mm256_mul_ps(_mm256_i32gather_ps(c.eotf, _mm256_cvtps_epi32(_mm256_mul_ps(g, scaleIn)), 4), gain);
+	__m256 lb   = _mm256_mul_ps(_mm256_i32gather_ps(c.eotf, _mm256_cvtps_epi32(_mm256_mul_ps(b, scaleIn)), 4), gain);
+
+	__m256 out[3];
+	for (int i = 0; i < 3; i++)
+	{
+		__m256 v = _mm256_mul_ps(_mm256_set1_ps(kGamut[i][0]), lr);
+		v = _mm256_fmadd_ps(_mm256_set1_ps(kGamut[i][1]), lg, v);
+		v = _mm256_fmadd_ps(_mm256_set1_ps(kGamut[i][2]), lb, v);
+		v = _mm256_min_ps(_mm256_max_ps(v, zero), one);
+		out[i] = _mm256_i32gather_ps(c.oetf, _mm256_cvtps_epi32(_mm256_mul_ps(v, scaleOut)), 4);
+	}
+	outR = out[0]; outG = out[1]; outB = out[2];
+}
+
+//! @brief Stores 8 floats as bytes (rounded, saturated)
+EGAV_TARGET_AVX2 static inline void Store8(uint8_t* outDst, __m256 inValues)
+{
+	__m256i i32 = _mm256_cvtps_epi32(inValues);
+	__m128i i16 = _mm_packus_epi32(_mm256_castsi256_si128(i32), _mm256_extracti128_si256(i32, 1));
+	_mm_storel_epi64((__m128i*)outDst, _mm_packus_epi16(i16, i16));
+}
+
+EGAV_TARGET_AVX2 static void RowPairAVX2Kernel(const HDRToneMapCurves& c, const uint16_t* inY0, const uint16_t* inY1, const uint16_t* inUV,
+											   uint8_t* outY0, uint8_t* outY1, uint8_t* outUV, int inWidth)
+{
+	const __m256 yOff = _mm256_set1_ps(kYOffset10), yScale = _mm256_set1_ps(kYScale10);
+	const __m256 cOff = _mm256_set1_ps(kCOffset10), cScale = _mm256_set1_ps(kCScale10);
+	const __m256 kr = _mm256_set1_ps(kBT709_Kr), kg = _mm256_set1_ps(kBT709_Kg), kb = _mm256_set1_ps(kBT709_Kb);
+	const __m256 yOff8 = _mm256_set1_ps(kYOffset8), yScale8 = _mm256_set1_ps(kYScale8);
+	const __m256i evenIdx = _mm256_setr_epi32(0, 0, 2, 2, 4, 4, 6, 6);
+	const __m256i oddIdx  = _mm256_setr_epi32(1, 1, 3, 3, 5, 5, 7, 7);
+	const __m256i pairIdx = _mm256_setr_epi32(0, 1, 4, 5, 0, 1, 4, 5);
+
+	const int simdWidth = inWidth & ~7;
+	for (int x = 0; x < simdWidth; x += 8)
+	{
+		// 4 chroma samples (Cb, Cr interleaved), each shared by 2x2 pixels
+		__m256i uv = _mm256_srli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(inUV + x))), 6);
+		__m256 cb  = _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_permutevar8x32_epi32(uv, evenIdx)), cOff), cScale);
+		__m256 cr  = _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_permutevar8x32_epi32(uv, oddIdx)),  cOff), cScale);
+		__m256 dr  = _mm256_mul_ps(_mm256_set1_ps(kBT2020_CrR), cr);
+		__m256 dg  = _mm256_fmadd_ps(_mm256_set1_ps(kBT2020_CbG), cb, _mm256_mul_ps(_mm256_set1_ps(kBT2020_CrG), cr));
+		__m256 db  = _mm256_mul_ps(_mm256_set1_ps(kBT2020_CbB), cb);
+
+		__m256 sumR = _mm256_setzero_ps(), sumG = _mm256_setzero_ps(), sumB = _mm256_setzero_ps();
+		const uint16_t* rows[2] = { inY0, inY1 };
+		uint8_t* outRows[2] = { outY0, outY1 };
+		for (int row = 0; row < 2; row++)
+		{
+			__m256i yi = _mm256_srli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(rows[row] + x))), 6);
+			__m256 y   = _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(yi), yOff), yScale);
+
+			__m256 r, g, b;
+			ToneMap8(c, _mm256_add_ps(y, dr), _mm256_add_ps(y, dg), _mm256_add_ps(y, db), r, g, b);
+
+			__m256 luma = _mm256_fmadd_ps(kr, r, _mm256_fmadd_ps(kg, g, _mm256_mul_ps(kb, b)));
+			Store8(outRows[row] + x, _mm256_fmadd_ps(yScale8, luma, yOff8));
+
+			sumR = _mm256_add_ps(sumR, r);
+			sumG = _mm256_add_ps(sumG, g);
+			sumB = _mm256_add_ps(sumB, b);
+		}
+
+		// Average 2x2: horizontal pairs -> lanes 0..3
+		const __m256 quarter = _mm256_set1_ps(0.25f);
+		__m256 r = _mm256_mul_ps(_mm256_permutevar8x32_ps(_mm256_hadd_ps(sumR, sumR), pairIdx), quarter);
+		__m256 g = _mm256_mul_ps(_mm256_permutevar8x32_ps(_mm256_hadd_ps(sumG, sumG), pairIdx), quarter);
+		__m256 b = _mm256_mul_ps(_mm256_permutevar8x32_ps(_mm256_hadd_ps(sumB, sumB), pairIdx), quarter);
+		__m256 luma = _mm256_fmadd_ps(kr, r, _mm256_fmadd_ps(kg, g, _mm256_mul_ps(kb, b)));
+		__m256 u = _mm256_fmadd_ps(_mm256_set1_ps(kCScale8 * kBT709_Cb), _mm256_sub_ps(b, luma), _mm256_set1_ps(kCOffset8));
+		__m256 v = _mm256_fmadd_ps(_mm256_set1_ps(kCScale8 * kBT709_Cr), _mm256_sub_ps(r, luma), _mm256_set1_ps(kCOffset8));
+
+		__m128i ui = _mm256_castsi256_si128(_mm256_cvtps_epi32(u));
+		__m128i vi = _mm256_castsi256_si128(_mm256_cvtps_epi32(v));
+		__m128i i16 = _mm_packus_epi32(_mm_unpacklo_epi32(ui, vi), _mm_unpackhi_epi32(ui, vi));
+		_mm_storel_epi64((__m128i*)(outUV + x), _mm_packus_epi16(i16, i16));
+	}
+
+	RowPairScalar(c, inY0, inY1, inUV, outY0, outY1, outUV, inWidth, simdWidth);
+}
+
+#endif // EGAV_X86
+
+
+//==============================================================================
+// # Class HDRToneMapper
+//==============================================================================
+
+HDRToneMapper::HDRToneMapper(int inThreadCount /*= 0*/)
+{
+	mThreadCount = (inThreadCount > 0) ? inThreadCount : std::max(1, (int)std::thread::hardware_concurrency());
+	mWorkers     = std::make_unique<EGAVWorkerPool>((size_t)(mThreadCount - 1));
+	SetSIMDEnabled(true);
+	SetParams(HDRToneMapParams());
+}
+
+void HDRToneMapper::SetParams(const HDRToneMapParams& inParams)
+{
+	if (!mCurves || mCurves->params != inParams)
+		mCurves = HDRToneMapCurves::Build(inParams);
+}
+
+void HDRToneMapper::SetCurves(std::shared_ptr<const HDRToneMapCurves> inCurves)
+{
+	if (inCurves)
+		mCurves = inCurves;
+}
+
+void HDRToneMapper::SetSIMDEnabled(bool inEnable)
+{
+	mKernel = RowPairScalarKernel;
+#if EGAV_X86
+	if (inEnable && EGAV_CPUHasAVX2())
+		mKernel = RowPairAVX2Kernel;
+#endif
+}
+
+EGAVResult HDRToneMapper::Process(const uint8_t* inY, int inYStride, const uint8_t* inUV, int inUVStride,
+								  uint8_t* outY, int outYStride, uint8_t* outUV, int outUVStride,
+								  int inWidth, int inHeight)
+{
+	EGAVResult_CheckPointer(inY);
+	EGAVResult_CheckPointer(inUV);
+	EGAVResult_CheckPointer(outY);
+	EGAVResult_CheckPointer(outUV);
+	if (inWidth <= 0 || inHeight <= 0 || (inWidth & 1) || (inHeight & 1))
+		return EGAVResult::ErrInvalidParameter;
+
+	std::shared_ptr<const HDRToneMapCurves> curves = mCurves; // keep alive while processing
+	const RowPairKernel kernel = mKernel;
+
+	auto processSlice = [&](int inFirstPair, int inEndPair)
+	{
+		for (int pair = inFirstPair; pair < inEndPair; pair++)
+		{
+			const int y = pair * 2;
+			kernel(*curves,
+				   (const uint16_t*)(inY + (size_t)y * inYStride), (const uint16_t*)(inY + (size_t)(y + 1) * inYStride),
+				   (const uint16_t*)(inUV + (size_t)pair * inUVStride),
+				   outY + (size_t)y * outYStride, outY + (size_t)(y + 1) * outYStride,
+				   outUV + (size_t)pair * outUVStride, inWidth);
+		}
+	};
+
+	// Slices of whole row pairs, shared between the workers and the calling thread
+	const int pairs  = inHeight / 2;
+	const int slices = std::min(mThreadCount, pairs);
+	const std::lock_guard<std::mutex> lock(mProcessMutex);
+	mWorkers->ParallelFor((size_t)slices, [&](size_t inSlice)
+	{
+		processSlice(pairs * (int)inSlice / slices, pairs * ((int)inSlice + 1) / slices);
+	});
+
+	return EGAVResult::Ok;
+}
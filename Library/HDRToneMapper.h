@@ -0,0 +1,128 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDRToneMapper.h
+
+@brief		Software HDR to SDR tonemapping: P010 (PQ or HLG, BT.2020 limited range)
+			to NV12 (BT.709 limited range).
+
+			Used for an SDR preview when on-device tonemapping is disabled
+			(ElgatoUVCDevice::SetHDRTonemappingEnabled(false), or P010 from the 4K60 Pro MK.2).
+			The curve is BT.2390 EETF, parameterised by the DR info frame (MaxCLL / mastering luminance).
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "EGAVResult.h"
+#include "HDMIInfoFramesAPI.h"
+#include "EGAVWorkerPool.h"
+
+
+//==============================================================================
+// # Parameters and curves
+//==============================================================================
+
+struct HDRToneMapParams
+{
+	uint8_t		eotf			= HDMI_DR_EOTF_ST2084;	//!< HDMI_DR_EOTF_ST2084 or HDMI_DR_EOTF_HLG
+	float		sourcePeak		= 1000.f;	//!< cd/m2, brightest content (HLG: nominal display peak)
+	float		sourceBlack		= 0.f;		//!< cd/m2
+	float		targetPeak		= 203.f;	//!< cd/m2 mapped to SDR white (BT.2408 reference white)
+
+	//! @brief Source peak is MaxCLL, mastering display luminance or 1000 cd/m2 (first one available)
+	static HDRToneMapParams FromInfoFrame(const HDMI_DR1_PAYLOAD& inPayload);
+
+	bool operator==(const HDRToneMapParams& inOther) const;
+	bool operator!=(const HDRToneMapParams& inOther) const { return !(*this == inOther); }
+};
+
+//! @brief Precomputed transfer curves used by the tonemapping kernels.
+//! All inputs are normalised non-linear values (0..1) quantised to the table size.
+struct HDRToneMapCurves
+{
+	static const int kInputSize		= 1024;		//!< 10 bit non-linear input
+	static const int kOutputSize	= 4096;		//!< 12 bit linear input of the output OETF
+
+	HDRToneMapParams	params;
+	float				eotf[kInputSize];		//!< R'G'B' (BT.2020) -> linear light, 1.0 = params.targetPeak
+	float				gain[kInputSize];		//!< max(R',G',B') -> tonemapping gain applied to linear RGB
+	float				oetf[kOutputSize];		//!< linear light (BT.709) -> R'G'B' (BT.1886 inverse, gamma 2.4)
+
+	static std::shared_ptr<const HDRToneMapCurves> Build(const HDRToneMapParams& inParams);
+
+	//! @brief Tonemaps one pixel exactly like the kernels
+	//! @param inRGB non-linear BT.2020 R'G'B' (0..1)
+	//! @param outRGB non-linear BT.709 R'G'B' (0..1)
+	void Apply(const float inRGB[3], float outRGB[3]) const;
+};
+
+
+//==============================================================================
+// # Class HDRToneMapper
+//==============================================================================
+
+//! @brief Multithreaded P010 to NV12 tonemapper (AVX2 kernel with scalar fallback)
+class HDRToneMapper
+{
+public:
+	//! @param inThreadCount number of slices processed in parallel, 0 = number of CPU cores.
+	//!        The calling thread processes one slice, the other slices run on inThreadCount - 1 persistent workers.
+	HDRToneMapper(int inThreadCount = 0);
+	HDRToneMapper(const HDRToneMapper&) = delete;
+	HDRToneMapper& operator=(const HDRToneMapper&) = delete;
+
+	//! @brief Rebuilds the curves if the parameters changed
+	void SetParams(const HDRToneMapParams& inParams);
+
+	//! @brief Uses prebuilt curves (e.g. shared between several tonemappers)
+	void SetCurves(std::shared_ptr<const HDRToneMapCurves> inCurves);
+	std::shared_ptr<const HDRToneMapCurves> GetCurves() const { return mCurves; }
+
+	//! @brief Forces the scalar kernel (reference for the SIMD path)
+	void SetSIMDEnabled(bool inEnable);
+
+	//! @brief Converts one frame. Width and height must be even, strides are in bytes.
+	//!        Concurrent calls are serialized (they share the workers).
+	EGAVResult Process(const uint8_t* inY, int inYStride, const uint8_t* inUV, int inUVStride,
+					   uint8_t* outY, int outYStride, uint8_t* outUV, int outUVStride,
+					   int inWidth, int inHeight);
+
+	//! @brief Processes two luma rows and the corresponding chroma row
+	typedef void (*RowPairKernel)(const HDRToneMapCurves& inCurves, const uint16_t* inY0, const uint16_t* inY1, const uint16_t* inUV,
+								  uint8_t* outY0, uint8_t* outY1, uint8_t* outUV, int inWidth);
+
+private:
+	std::shared_ptr<const HDRToneMapCurves>	mCurves;
+	RowPairKernel							mKernel			= nullptr;
+	int										mThreadCount	= 1;
+	std::unique_ptr<EGAVWorkerPool>			mWorkers;
+	std::mutex								mProcessMutex;	//!< one frame at a time on mWorkers
+};
@@ -0,0 +1,229 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDRTonemapPolicy.cpp
+
+@brief		Automatic on-device HDR tonemapping from the DR info frame
+**/
+//==============================================================================
+
+#include "HDRTonemapPolicy.h"
+#include "ElgatoUVCDevice.h"
+
+#include <chrono>
+#include <cstring>
+
+
+static uint64_t GetTimestampUs()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//==============================================================================
+// # HDRTonemapRule
+//==============================================================================
+
+bool HDRTonemapRule::ShouldTonemap(int inEOTF) const
+{
+	if (downstreamHDR)
+		return false;
+
+	switch (inEOTF)
+	{
+		case HDMI_DR_EOTF_ST2084:	return tonemapPQ;
+		case HDMI_DR_EOTF_HLG:		return tonemapHLG;
+		case HDMI_DR_EOTF_HDRGAMMA:	return tonemapHDRGamma;
+		default:					return false;
+	}
+}
+
+
+//==============================================================================
+// # Class HDRTonemapPolicy
+//==============================================================================
+
+HDRTonemapPolicy::HDRTonemapPolicy(ElgatoUVCDevice& inDevice, const HDRTonemapPolicyConfig& inConfig /*= HDRTonemapPolicyConfig()*/, TransitionCallback inCallback /*= nullptr*/)
+	: mDevice(inDevice), mConfig(inConfig), mCallback(inCallback)
+{
+	if (mConfig.pollIntervalMs <= 0)
+		mConfig.pollIntervalMs = 1;
+}
+
+HDRTonemapPolicy::~HDRTonemapPolicy()
+{
+	Stop();
+}
+
+int HDRTonemapPolicy::GetSignalEOTF(const HDMI_GENERIC_INFOFRAME& inFrame)
+{
+	if (HDMI_IsInfoFrameValid(&inFrame) && HDMI_INFOFRAME_TYPE_DR == inFrame.header.bfType)
+		return inFrame.plDR1.bfEOTF;
+
+	// All empty: no DR info frame (seen with HD60 S+ when HDR is not active)
+	static const HDMI_GENERIC_INFOFRAME emptyFrame{};
+	if (0 == memcmp(&inFrame, &emptyFrame, sizeof(emptyFrame)))
+		return HDMI_DR_EOTF_SDRGAMMA;
+
+	return HDMI_ERROR;
+}
+
+int HDRTonemapPolicy::PollSignal()
+{
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAVResult res = mDevice.GetHDMIHDRStatusPacket(frame);
+	return GetSignalEOTF(res, frame);
+}
+
+int HDRTonemapPolicy::GetSignalEOTF(EGAVResult inResult, const HDMI_GENERIC_INFOFRAME& inFrame)
+{
+	if (inResult.Succeeded())
+		return GetSignalEOTF(inFrame);
+	if (inResult == EGAVResult::ErrNoData)
+		return HDMI_DR_EOTF_SDRGAMMA;
+	return HDMI_ERROR; // I2C error: keep the current state
+}
+
+void HDRTonemapPolicy::SetRule(const HDRTonemapRule& inRule)
+{
+	const std::lock_guard<std::mutex> lock(mMutex);
+	mConfig.rule = inRule;
+}
+
+bool HDRTonemapPolicy::IsTonemapping() const
+{
+	const std::lock_guard<std::mutex> lock(mMutex);
+	return mApplied && mTonemapping;
+}
+
+HDRTonemapPolicyStatistics HDRTonemapPolicy::GetStatistics() const
+{
+	const std::lock_guard<std::mutex> lock(mMutex);
+	return mStatistics;
+}
+
+EGAVResult HDRTonemapPolicy::Start()
+{
+	Stop();
+
+	// The probe is also the first sample
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAVResult res = mDevice.GetHDMIHDRStatusPacket(frame);
+	if (res == EGAVResult::ErrNotSupported)
+		return EGAVResult::ErrNotSupported;
+
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mStop    = false;
+		mApplied = false;
+		mPending = false;
+	}
+
+	// Apply the initial state right away (no hold time)
+	ProcessSignal(GetSignalEOTF(res, frame), GetTimestampUs());
+
+	mWorker = std::thread(&HDRTonemapPolicy::WorkerThread, this);
+	return EGAVResult::Ok;
+}
+
+void HDRTonemapPolicy::Stop()
+{
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mCondition.notify_all();
+	if (mWorker.joinable())
+		mWorker.join();
+}
+
+bool HDRTonemapPolicy::ProcessSignal(int inEOTF, uint64_t inTimestampUs)
+{
+	bool tonemapping = false;
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+
+		if (HDMI_ERROR == inEOTF)
+			return false;
+		mStatistics.samples++;
+
+		const bool desired = mConfig.rule.ShouldTonemap(inEOTF);
+		if (mApplied && desired == mTonemapping)
+		{
+			if (mPending)
+			{
+				mPending = false; // glitch is over
+				mStatistics.suppressed++;
+			}
+			return false;
+		}
+
+		if (mApplied)
+		{
+			if (!mPending)
+			{
+				mPending      = true;
+				mPendingSince = inTimestampUs;
+			}
+			const uint64_t holdUs  = (uint64_t)(desired ? mConfig.enableHoldMs : mConfig.disableHoldMs) * 1000;
+			const uint64_t dwellUs = (uint64_t)mConfig.minDwellMs * 1000;
+			if (inTimestampUs - mPendingSince < holdUs || inTimestampUs - mLastTransition < dwellUs)
+				return false;
+		}
+
+		// The write is done under the lock: the state must not change while it is in flight
+		EGAVResult res = mDevice.SetHDRTonemappingEnabled(desired);
+		if (res.Failed())
+		{
+			mStatistics.writeErrors++;
+			return false; // stays pending: retried with the next sample
+		}
+		if (res != EGAVResult::OkNoDataChanged)
+			mStatistics.registerWrites++;
+
+		mApplied        = true;
+		mTonemapping    = desired;
+		mLastTransition = inTimestampUs;
+		mPending        = false;
+		mStatistics.transitions++;
+		tonemapping     = desired;
+	}
+
+	if (mCallback)
+		mCallback(tonemapping, inEOTF);
+	return true;
+}
+
+void HDRTonemapPolicy::WorkerThread()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (!mCondition.wait_for(lock, std::chrono::milliseconds(mConfig.pollIntervalMs), [this] { return mStop; }))
+	{
+		lock.unlock();
+		ProcessSignal(PollSignal(), GetTimestampUs());
+		lock.lock();
+	}
+}
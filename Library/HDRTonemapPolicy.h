@@ -0,0 +1,140 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		HDRTonemapPolicy.h
+
+@brief		Automatic on-device HDR tonemapping from the DR info frame.
+
+			Polls ElgatoUVCDevice::GetHDMIHDRStatusPacket() on a background thread and
+			enables or disables tonemapping according to a rule (default: tonemap PQ and
+			HLG if the downstream pipeline is SDR). Sources drop the DR info frame for a
+			moment during mode switches, so a new state must be stable for a hold time
+			and transitions are at least a minimum dwell time apart. Each real transition
+			costs one register write.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "EGAVResult.h"
+#include "HDMIInfoFramesAPI.h"
+
+class ElgatoUVCDevice;
+
+
+//! @brief Decides whether the device should tonemap a signal
+struct HDRTonemapRule
+{
+	bool	downstreamHDR	= false;	//!< encoder/display accepts HDR: never tonemap
+	bool	tonemapPQ		= true;
+	bool	tonemapHLG		= true;
+	bool	tonemapHDRGamma	= false;	//!< traditional gamma HDR (rarely used)
+
+	//! @param inEOTF HDMI_DR_EOTF_* (HDMI_DR_EOTF_SDRGAMMA: no DR info frame)
+	bool ShouldTonemap(int inEOTF) const;
+};
+
+struct HDRTonemapPolicyConfig
+{
+	HDRTonemapRule	rule;
+	int				pollIntervalMs	= 100;
+	int				enableHoldMs	= 300;		//!< HDR must be signaled this long before tonemapping is enabled
+	int				disableHoldMs	= 1500;		//!< DR info frame must be gone this long before tonemapping is disabled
+	int				minDwellMs		= 2000;		//!< minimum time between two transitions
+};
+
+struct HDRTonemapPolicyStatistics
+{
+	uint64_t	samples			= 0;	//!< signal samples processed
+	uint64_t	transitions		= 0;	//!< tonemapping state changes (including the initial state)
+	uint64_t	registerWrites	= 0;	//!< writes that reached the device
+	uint64_t	suppressed		= 0;	//!< signal changes that reverted within the hold time
+	uint64_t	writeErrors		= 0;
+};
+
+
+//==============================================================================
+// # Class HDRTonemapPolicy
+//==============================================================================
+
+class HDRTonemapPolicy
+{
+public:
+	//! inEOTF: HDMI_DR_EOTF_* of the signal that caused the transition
+	typedef std::function<void(bool inTonemapping, int inEOTF)> TransitionCallback;
+
+	HDRTonemapPolicy(ElgatoUVCDevice& inDevice, const HDRTonemapPolicyConfig& inConfig = HDRTonemapPolicyConfig(), TransitionCallback inCallback = nullptr);
+	~HDRTonemapPolicy();
+
+	//! @brief Polls once synchronously (applies the initial state without hold time) and starts the background thread
+	//! @return ErrNotSupported if the device doesn't deliver DR info frames
+	EGAVResult Start();
+	void Stop();
+
+	//! @brief Changes the rule (e.g. the downstream display changed). The new state is subject to hold and dwell time.
+	void SetRule(const HDRTonemapRule& inRule);
+
+	//! @brief Feeds one poll result (used by the thread; exposed for scripted sources)
+	//! @param inEOTF HDMI_DR_EOTF_* or HDMI_ERROR (read failed: ignored)
+	//! @return true if the tonemapping state changed
+	bool ProcessSignal(int inEOTF, uint64_t inTimestampUs);
+
+	//! @return HDMI_DR_EOTF_* of the info frame, HDMI_DR_EOTF_SDRGAMMA if no DR info frame is sent, HDMI_ERROR if invalid
+	static int GetSignalEOTF(const HDMI_GENERIC_INFOFRAME& inFrame);
+
+	//! @return false before the first state was applied
+	bool IsTonemapping() const;
+	HDRTonemapPolicyStatistics GetStatistics() const;
+
+private:
+	int PollSignal();
+	//! @return EOTF of a GetHDMIHDRStatusPacket() result (see ProcessSignal())
+	static int GetSignalEOTF(EGAVResult inResult, const HDMI_GENERIC_INFOFRAME& inFrame);
+	void WorkerThread();
+
+	ElgatoUVCDevice&			mDevice;
+	HDRTonemapPolicyConfig		mConfig;
+	TransitionCallback			mCallback;
+
+	mutable std::mutex			mMutex;
+	std::condition_variable		mCondition;
+	std::thread					mWorker;
+	bool						mStop = false;
+
+	// State (mMutex)
+	bool						mApplied		= false;	//!< initial state was written
+	bool						mTonemapping	= false;
+	uint64_t					mLastTransition	= 0;
+	bool						mPending		= false;	//!< signal asks for the other state
+	uint64_t					mPendingSince	= 0;
+	HDRTonemapPolicyStatistics	mStatistics;
+};
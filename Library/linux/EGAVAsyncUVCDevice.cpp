@@ -0,0 +1,414 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVAsyncUVCDevice.cpp
+
+@brief		Non-blocking I2C-over-HID transactions driven by EGAVReactor
+**/
+//==============================================================================
+
+#include "EGAVAsyncUVCDevice.h"
+#include "EGAVHIDRawReports.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sys/epoll.h>
+
+
+//==============================================================================
+// # Exchange
+//==============================================================================
+
+//! @brief One blocking call: [drain input,] output report[, GET_REPORT]
+struct EGAVAsyncUVCDevice::Exchange
+{
+	std::unique_ptr<EGAVHIDRawTransport> transport;
+
+	// Request (set on the reactor thread before RunBlocking())
+	uint8_t					report[kMaxRequestReportSize];
+	size_t					reportSize			= 0;
+	bool					isRead				= false;
+	bool					drainFirst			= false;
+	uint8_t					responseReportID	= 0;
+	size_t					responseBufferSize	= 0;
+
+	// Result (set on the worker)
+	EGAVResult				result				= EGAVResult::Ok;
+	size_t					drained				= 0;
+	size_t					inputSize			= 0;
+	uint8_t					input[kMaxInputReportSize];
+
+	void Run()
+	{
+		drained   = drainFirst ? transport->DrainInput() : 0;
+		inputSize = 0;
+		result    = transport->WriteReport(report, reportSize);
+		if (result.Succeeded() && isRead)
+		{
+			input[0] = responseReportID;
+			result   = transport->GetInputReport(input, responseBufferSize, inputSize);
+		}
+	}
+};
+
+
+//==============================================================================
+// # Class EGAVAsyncUVCDevice
+//==============================================================================
+
+EGAVAsyncUVCDevice::EGAVAsyncUVCDevice(EGAVReactor& inReactor, std::unique_ptr<EGAVHIDRawTransport> inTransport, const EGAVDeviceID& inDeviceID,
+									   const EGAVFirmwareVersion& inFirmware /*= EGAVFirmwareVersion()*/,
+									   const EGAVAsyncUVCDeviceConfig& inConfig /*= EGAVAsyncUVCDeviceConfig()*/)
+	: mReactor(inReactor), mExchange(std::make_shared<Exchange>()), mAlive(std::make_shared<bool>(true)),
+	  mNewProtocol(IsNewDeviceType(inDeviceID)), mQuirks(ResolveElgatoUVCQuirks(inDeviceID, inFirmware)), mConfig(inConfig)
+{
+	mExchange->transport = std::move(inTransport);
+}
+
+EGAVAsyncUVCDevice::~EGAVAsyncUVCDevice()
+{
+	Stop();
+}
+
+std::unique_ptr<EGAVHIDRawTransport> EGAVAsyncUVCDevice::OpenHIDRaw(const std::string& inPath)
+{
+	auto device = std::make_unique<EGAVHIDRawDevice>();
+	if (device->Open(inPath).Failed())
+		return nullptr;
+	return device;
+}
+
+EGAVResult EGAVAsyncUVCDevice::Start(HDRStatusCallback inCallback)
+{
+	if (mRunning)
+		return EGAVResult::ErrInvalidState;
+	if (!mExchange->transport)
+		return EGAVResult::ErrNotInitialized;
+
+	// Edge triggered: input reports arriving while a call is in flight are drained by the next call
+	const int fd = mExchange->transport->GetFD();
+	if (fd >= 0)
+	{
+		EGAVResult res = mReactor.AddFD(fd, EPOLLIN | EPOLLET, [this](uint32_t inEvents) { OnIO(inEvents); });
+		if (res.Failed())
+			return res;
+		mWatchingFD = true;
+	}
+
+	mHDRStatusCallback = std::move(inCallback);
+	mRunning   = true;
+	mDrainNext = true; // reports queued before Start()
+	if (mConfig.pollIntervalUs)
+	{
+		mNextPollUs = EGAVReactor::GetTimeUs() + mConfig.pollPhaseUs;
+		mPollTimer  = mReactor.AddTimerAt(mNextPollUs, [this] { OnPollTimer(); });
+	}
+	StartNext();
+	return EGAVResult::Ok;
+}
+
+void EGAVAsyncUVCDevice::Stop()
+{
+	if (!mRunning)
+		return;
+
+	mReactor.CancelTimer(mPollTimer);
+	mReactor.CancelTimer(mTimeoutTimer);
+	mPollTimer = mTimeoutTimer = EGAVReactor::kInvalidTimer;
+	if (mWatchingFD)
+		mReactor.RemoveFD(mExchange->transport->GetFD());
+	mWatchingFD   = false;
+	mRunning      = false;
+	mPollInFlight = false;
+	if (mCallInFlight)
+		mCallAbandoned = true;
+
+	std::deque<Transaction> queue;
+	queue.swap(mQueue);
+	for (Transaction& transaction : queue)
+	{
+		if (transaction.readCallback)
+			transaction.readCallback(EGAVResult::ErrInvalidState, nullptr, 0);
+		else if (transaction.writeCallback)
+			transaction.writeCallback(EGAVResult::ErrInvalidState);
+	}
+}
+
+void EGAVAsyncUVCDevice::ReadI2cData(uint8_t inI2CAddress, uint8_t inRegister, uint8_t inLength, ReadCallback inCallback)
+{
+	Transaction transaction;
+	transaction.isRead       = true;
+	transaction.address      = inI2CAddress;
+	transaction.reg          = inRegister;
+	transaction.length       = std::min<uint8_t>(inLength, MAX_COMM_READ_BUFFER_SIZE + 1);
+	transaction.readCallback = std::move(inCallback);
+	Enqueue(std::move(transaction));
+}
+
+void EGAVAsyncUVCDevice::WriteI2cData(uint8_t inI2CAddress, uint8_t inRegister, const uint8_t* inData, uint8_t inLength, WriteCallback inCallback)
+{
+	if (!inData || inLength > MAX_COMM_WRITE_BUFFER_SIZE)
+	{
+		if (inCallback)
+			inCallback(EGAVResult::ErrInvalidParameter);
+		return;
+	}
+
+	Transaction transaction;
+	transaction.address       = inI2CAddress;
+	transaction.reg           = inRegister;
+	transaction.length        = inLength;
+	transaction.writeCallback = std::move(inCallback);
+	std::copy(inData, inData + inLength, transaction.data.begin());
+	Enqueue(std::move(transaction));
+}
+
+void EGAVAsyncUVCDevice::SetHDRTonemappingEnabled(bool inEnable, WriteCallback inCallback)
+{
+	const uint8_t value = inEnable ? 1 : 0;
+	WriteI2cData((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::XET_HDR_TONEMAPPING, &value, 1, std::move(inCallback));
+}
+
+//==============================================================================
+// ## Transaction state machine
+//==============================================================================
+
+void EGAVAsyncUVCDevice::Enqueue(Transaction&& inTransaction)
+{
+	if (!mRunning)
+	{
+		if (inTransaction.readCallback)
+			inTransaction.readCallback(EGAVResult::ErrInvalidState, nullptr, 0);
+		else if (inTransaction.writeCallback)
+			inTransaction.writeCallback(EGAVResult::ErrInvalidState);
+		return;
+	}
+	mQueue.push_back(std::move(inTransaction));
+	StartNext();
+}
+
+void EGAVAsyncUVCDevice::StartNext()
+{
+	// One call per device: a timed out call blocks the device until it has returned
+	if (!mRunning || mCallInFlight || mQueue.empty())
+		return;
+
+	const Transaction& transaction = mQueue.front();
+	Exchange& exchange = *mExchange;
+	exchange.isRead = transaction.isRead;
+	if (transaction.isRead)
+	{
+		if (mNewProtocol)
+		{
+			exchange.reportSize = BuildReadReport<NewProtocol>(transaction.address, transaction.reg, transaction.length, exchange.report);
+			exchange.responseReportID   = (uint8_t)NewProtocol::kReadResponseReportID;
+			exchange.responseBufferSize = GetReadResponseBufferSize<NewProtocol>(*exchange.transport);
+		}
+		else
+		{
+			exchange.reportSize = BuildReadReport<LegacyProtocol>(transaction.address, transaction.reg, transaction.length, exchange.report);
+			exchange.responseReportID   = (uint8_t)LegacyProtocol::kReadResponseReportID;
+			exchange.responseBufferSize = GetReadResponseBufferSize<LegacyProtocol>(*exchange.transport);
+		}
+		exchange.responseBufferSize = std::min(exchange.responseBufferSize, sizeof(exchange.input));
+	}
+	else
+	{
+		if (mNewProtocol)
+			exchange.reportSize = BuildWriteReport<NewProtocol>(transaction.address, transaction.reg, transaction.data.data(), transaction.length, exchange.report);
+		else
+			exchange.reportSize = BuildWriteReport<LegacyProtocol>(transaction.address, transaction.reg, transaction.data.data(), transaction.length, exchange.report);
+	}
+	exchange.drainFirst = mDrainNext;
+	mDrainNext = false;
+
+	mCallInFlight  = true;
+	mCallAbandoned = false;
+	mTimeoutTimer  = mReactor.AddTimer(mConfig.responseTimeoutUs, [this] { OnTimeout(); });
+
+	std::shared_ptr<Exchange> call = mExchange;
+	std::weak_ptr<bool> alive = mAlive;
+	mReactor.RunBlocking([call] { call->Run(); }, [this, alive]
+	{
+		if (!alive.expired())
+			OnExchangeDone();
+	});
+}
+
+void EGAVAsyncUVCDevice::OnExchangeDone()
+{
+	mCallInFlight = false;
+	const Exchange& exchange = *mExchange;
+	mStatistics.drainedReports += exchange.drained;
+
+	if (mCallAbandoned)
+	{
+		// A response to the abandoned request may still be queued
+		mCallAbandoned = false;
+		mStatistics.lateCompletions++;
+		mDrainNext = true;
+		StartNext();
+		return;
+	}
+
+	mReactor.CancelTimer(mTimeoutTimer);
+	mTimeoutTimer = EGAVReactor::kInvalidTimer;
+
+	const Transaction& transaction = mQueue.front();
+	if (exchange.result.Failed())
+	{
+		error_printf("EGAVAsyncUVCDevice: %s FAILED for I2C address 0x%02x, register 0x%02x (%s)", transaction.isRead ? "read" : "write",
+					 transaction.address, transaction.reg, exchange.result.GetResultCodeString());
+		mDrainNext = true;
+		Complete(exchange.result, nullptr, 0);
+		return;
+	}
+	if (!transaction.isRead)
+	{
+		Complete(EGAVResult::Ok, nullptr, 0);
+		return;
+	}
+
+	uint8_t data[MAX_COMM_READ_BUFFER_SIZE + 1] = {};
+	const uint8_t length = transaction.length;
+	const bool parsed = mNewProtocol ? ParseReadReport<NewProtocol>(exchange.input, exchange.inputSize, data, length)
+									 : ParseReadReport<LegacyProtocol>(exchange.input, exchange.inputSize, data, length);
+	if (parsed)
+		Complete(EGAVResult::Ok, data, length);
+	else
+		Complete(EGAVResult::ErrNoData, nullptr, 0); // other input report
+}
+
+void EGAVAsyncUVCDevice::Complete(EGAVResult inResult, const uint8_t* inData, uint8_t inLength)
+{
+	if (mQueue.empty())
+		return;
+
+	Transaction transaction = std::move(mQueue.front());
+	mQueue.pop_front();
+
+	mStatistics.transactions++;
+	if (inResult.Failed())
+		mStatistics.errors++;
+
+	// The callback may queue the next transaction (and start it)
+	if (transaction.readCallback)
+		transaction.readCallback(inResult, inData, inLength);
+	else if (transaction.writeCallback)
+		transaction.writeCallback(inResult);
+
+	StartNext();
+}
+
+void EGAVAsyncUVCDevice::OnIO(uint32_t inEvents)
+{
+	if (inEvents & (EPOLLERR | EPOLLHUP))
+	{
+		// Device unplugged
+		warning_printf("EGAVAsyncUVCDevice: fd %d closed by the device", mExchange->transport->GetFD());
+		Stop();
+		return;
+	}
+
+	// Interrupt-IN reports aren't part of the protocols; don't let them fill the hidraw buffer
+	if (inEvents & EPOLLIN)
+	{
+		if (mCallInFlight)
+			mDrainNext = true; // the worker owns the transport
+		else
+			mStatistics.drainedReports += mExchange->transport->DrainInput();
+	}
+}
+
+void EGAVAsyncUVCDevice::OnTimeout()
+{
+	mTimeoutTimer = EGAVReactor::kInvalidTimer;
+	if (!mCallInFlight || mCallAbandoned || mQueue.empty())
+		return;
+
+	mStatistics.timeouts++;
+	error_printf("EGAVAsyncUVCDevice: no response for I2C address 0x%02x, register 0x%02x", mQueue.front().address, mQueue.front().reg);
+	mCallAbandoned = true;
+	Complete(EGAVResult::ErrTimeOut, nullptr, 0);
+}
+
+//==============================================================================
+// ## HDR status poll
+//==============================================================================
+
+void EGAVAsyncUVCDevice::OnPollTimer()
+{
+	const uint64_t nowUs = mReactor.GetLoopTimeUs();
+	const uint64_t jitterUs = (nowUs > mNextPollUs) ? nowUs - mNextPollUs : 0;
+	mStatistics.pollJitterUsTotal += jitterUs;
+	mStatistics.pollJitterUsMax = std::max(mStatistics.pollJitterUsMax, jitterUs);
+
+	// Fixed schedule (no drift); intervals missed by a stalled loop are skipped
+	mNextPollUs += mConfig.pollIntervalUs;
+	if (mNextPollUs <= nowUs)
+		mNextPollUs = nowUs + mConfig.pollIntervalUs - (nowUs - mNextPollUs) % mConfig.pollIntervalUs;
+	mPollTimer = mReactor.AddTimerAt(mNextPollUs, [this] { OnPollTimer(); });
+
+	if (mPollInFlight)
+	{
+		mStatistics.pollsSkipped++;
+		return;
+	}
+
+	mStatistics.polls++;
+	mPollInFlight = true;
+	mPollStartUs  = nowUs;
+	Transaction transaction;
+	transaction.isRead       = true;
+	transaction.isPoll       = true;
+	transaction.address      = (uint8_t)I2CAddress::MCU;
+	transaction.reg          = (uint8_t)MCU_I2C_REGISTER::GET_HDR_PACKET;
+	transaction.length       = mQuirks.infoFrameReadSize;
+	transaction.readCallback = [this](EGAVResult inResult, const uint8_t* inData, uint8_t inLength) { OnPollResult(inResult, inData, inLength); };
+	Enqueue(std::move(transaction));
+}
+
+void EGAVAsyncUVCDevice::OnPollResult(EGAVResult inResult, const uint8_t* inData, uint8_t inLength)
+{
+	if (!mPollInFlight)
+		return; // stopped
+	mPollInFlight = false;
+
+	const uint64_t latencyUs = EGAVReactor::GetTimeUs() - mPollStartUs;
+	mStatistics.pollLatencyUsTotal += latencyUs;
+	mStatistics.pollLatencyUsMax = std::max(mStatistics.pollLatencyUsMax, latencyUs);
+
+	HDMI_GENERIC_INFOFRAME frame{};
+	if (inResult.Succeeded() && inData && inLength > mQuirks.infoFrameOffset)
+	{
+		// Same as ElgatoUVCDevice::ReadInfoFrameRegister()
+		const size_t size = std::min((size_t)(inLength - mQuirks.infoFrameOffset), sizeof(frame));
+		memcpy(&frame, inData + mQuirks.infoFrameOffset, size);
+		mQuirks.ApplyInfoFrameFixups(frame);
+	}
+	if (mHDRStatusCallback)
+		mHDRStatusCallback(inResult, frame);
+}
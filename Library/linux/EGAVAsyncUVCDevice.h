@@ -0,0 +1,174 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVAsyncUVCDevice.h
+
+@brief		Non-blocking I2C-over-HID transactions of one Elgato UVC device, driven
+			by an EGAVReactor, so one thread can service dozens of cards.
+
+			The transactions are the ones of ElgatoUVCDevice (same protocols and
+			quirks, see ElgatoUVCProtocol.h): a queue per device, one transaction in
+			flight, the response deadline and the periodic HDR status poll are
+			reactor timers. The response is read with GET_REPORT, which blocks and
+			can't be polled (see EGAVHIDRawDevice.h), so each transaction (output
+			report, then GET_REPORT) runs on a worker of EGAVReactor::RunBlocking();
+			the state machine and all callbacks stay on the reactor thread.
+
+			A transaction that times out completes with ErrTimeOut, but the device
+			stays busy until its blocking call has returned. The next transaction
+			first discards queued input reports, so nothing of the abandoned one is
+			attributed to it. All methods must be called on the reactor thread
+			(EGAVReactor::Post()).
+**/
+//==============================================================================
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "EGAVResult.h"
+#include "EGAVDevice.h"
+#include "HDMIInfoFramesAPI.h"
+#include "ElgatoUVCProtocol.h"
+#include "ElgatoUVCQuirks.h"
+#include "EGAVReactor.h"
+#include "EGAVHIDRawDevice.h"
+
+
+struct EGAVAsyncUVCDeviceConfig
+{
+	uint32_t	pollIntervalUs		= 100000;	//!< HDR status poll (0: no polling)
+	uint32_t	pollPhaseUs			= 0;		//!< delay of the first poll; spreads the polls of many devices over the interval
+	uint32_t	responseTimeoutUs	= 100000;	//!< output report and GET_REPORT of one transaction
+};
+
+struct EGAVAsyncUVCDeviceStatistics
+{
+	uint64_t	polls				= 0;
+	uint64_t	pollsSkipped		= 0;	//!< previous poll still in flight
+	uint64_t	transactions		= 0;
+	uint64_t	timeouts			= 0;
+	uint64_t	errors				= 0;
+	uint64_t	lateCompletions		= 0;	//!< blocking calls that returned after their transaction timed out
+	uint64_t	drainedReports		= 0;	//!< discarded interrupt-IN reports
+	uint64_t	pollJitterUsMax		= 0;	//!< poll start after its scheduled time
+	uint64_t	pollJitterUsTotal	= 0;
+	uint64_t	pollLatencyUsMax	= 0;	//!< poll start to HDR status callback
+	uint64_t	pollLatencyUsTotal	= 0;
+};
+
+
+//==============================================================================
+// # Class EGAVAsyncUVCDevice
+//==============================================================================
+
+class EGAVAsyncUVCDevice
+{
+public:
+	typedef std::function<void(EGAVResult inResult, const uint8_t* inData, uint8_t inLength)> ReadCallback;
+	typedef std::function<void(EGAVResult inResult)> WriteCallback;
+	//! @brief Called after every poll; inFrame is only valid if inResult succeeded
+	typedef std::function<void(EGAVResult inResult, const HDMI_GENERIC_INFOFRAME& inFrame)> HDRStatusCallback;
+
+	//! @param inTransport the device's reports (see OpenHIDRaw()); owned by this object
+	EGAVAsyncUVCDevice(EGAVReactor& inReactor, std::unique_ptr<EGAVHIDRawTransport> inTransport, const EGAVDeviceID& inDeviceID,
+					   const EGAVFirmwareVersion& inFirmware = EGAVFirmwareVersion(),
+					   const EGAVAsyncUVCDeviceConfig& inConfig = EGAVAsyncUVCDeviceConfig());
+	//! @brief A blocking call still in flight finishes on its worker; its result is dropped
+	~EGAVAsyncUVCDevice();
+	EGAVAsyncUVCDevice(const EGAVAsyncUVCDevice&) = delete;
+	EGAVAsyncUVCDevice& operator=(const EGAVAsyncUVCDevice&) = delete;
+
+	//! @param inPath hidraw node, e.g. from EGAVHIDRawDevice::FindDevice()
+	//! @return nullptr on error
+	static std::unique_ptr<EGAVHIDRawTransport> OpenHIDRaw(const std::string& inPath);
+
+	//! @brief Watches the transport fd (queued input reports, unplug) and starts the HDR status polls (inCallback may be nullptr)
+	EGAVResult Start(HDRStatusCallback inCallback);
+	//! @brief Fails the queued transactions with ErrInvalidState
+	void Stop();
+
+	//! @param inLength up to MAX_COMM_READ_BUFFER_SIZE (33 for the legacy info frame registers)
+	void ReadI2cData(uint8_t inI2CAddress, uint8_t inRegister, uint8_t inLength, ReadCallback inCallback);
+	void WriteI2cData(uint8_t inI2CAddress, uint8_t inRegister, const uint8_t* inData, uint8_t inLength, WriteCallback inCallback);
+	void SetHDRTonemappingEnabled(bool inEnable, WriteCallback inCallback);
+
+	const ElgatoUVCQuirks& GetQuirks() const { return mQuirks; }
+	size_t GetQueueLength() const { return mQueue.size(); }
+	const EGAVAsyncUVCDeviceStatistics& GetStatistics() const { return mStatistics; }
+
+private:
+	struct Transaction
+	{
+		bool		isRead		= false;
+		bool		isPoll		= false;
+		uint8_t		address		= 0;
+		uint8_t		reg			= 0;
+		uint8_t		length		= 0;
+		std::array<uint8_t, MAX_COMM_WRITE_BUFFER_SIZE> data{};
+		ReadCallback	readCallback;
+		WriteCallback	writeCallback;
+	};
+
+	struct Exchange;
+
+	void Enqueue(Transaction&& inTransaction);
+	void StartNext();
+	void OnExchangeDone();
+	void Complete(EGAVResult inResult, const uint8_t* inData, uint8_t inLength);
+	void OnIO(uint32_t inEvents);
+	void OnTimeout();
+	void OnPollTimer();
+	void OnPollResult(EGAVResult inResult, const uint8_t* inData, uint8_t inLength);
+
+	EGAVReactor&				mReactor;
+	std::shared_ptr<Exchange>	mExchange;		//!< transport and buffers, shared with the worker of the call in flight
+	std::shared_ptr<bool>		mAlive;			//!< completions posted after destruction are dropped
+	const bool					mNewProtocol;
+	const ElgatoUVCQuirks		mQuirks;
+	const EGAVAsyncUVCDeviceConfig mConfig;
+	HDRStatusCallback			mHDRStatusCallback;
+
+	bool						mRunning		= false;
+	bool						mWatchingFD		= false;
+	bool						mCallInFlight	= false;	//!< blocking call on a worker
+	bool						mCallAbandoned	= false;	//!< its transaction has already been completed (timeout, Stop())
+	bool						mDrainNext		= false;	//!< discard queued input reports before the next request
+	std::deque<Transaction>		mQueue;			//!< front: transaction in flight
+	EGAVReactor::TimerID		mTimeoutTimer	= EGAVReactor::kInvalidTimer;
+	EGAVReactor::TimerID		mPollTimer		= EGAVReactor::kInvalidTimer;
+	uint64_t					mNextPollUs		= 0;
+	uint64_t					mPollStartUs	= 0;
+	bool						mPollInFlight	= false;
+
+	EGAVAsyncUVCDeviceStatistics mStatistics;
+};
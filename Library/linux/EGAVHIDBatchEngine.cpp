@@ -0,0 +1,719 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVHIDBatchEngine.cpp
+
+@brief		Batched I2C-over-HID transactions for many devices (io_uring, epoll)
+**/
+//==============================================================================
+
+#include "EGAVHIDBatchEngine.h"
+#include "EGAVHIDRawReports.h"
+
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+
+const int kMaxEventsPerWait = 64;
+
+//! @brief io_uring user data: batch sequence (never reset, so a stale completion can't match a later batch), slot and operation
+enum class RingOp : uint64_t { Write = 0, Timeout = 1 };
+
+static uint64_t EncodeUserData(uint32_t inBatch, size_t inSlot, RingOp inOp) { return ((uint64_t)inBatch << 32) | ((uint64_t)inSlot << 1) | (uint64_t)inOp; }
+
+
+//==============================================================================
+// # Device
+//==============================================================================
+
+struct EGAVHIDBatchEngine::Device
+{
+	std::unique_ptr<EGAVHIDRawTransport> transport;
+	bool					newProtocol		= true;
+	ElgatoUVCQuirks			quirks;
+	uint32_t				pollIntervalUs	= 0;
+	uint64_t				nextPollUs		= 0;
+	bool					inBatch			= false;
+
+	// Buffers of the transaction in flight: must stay valid until io_uring has completed it
+	std::vector<uint8_t>	report;			//!< sized once in AddDevice(): output report size or kMaxRequestReportSize
+	size_t					reportSize		= 0;	//!< request padded to the output report size
+	uint8_t					input[kMaxInputReportSize];
+	struct __kernel_timespec timeout;
+};
+
+
+//==============================================================================
+// # Class EGAVHIDBatchEngine::IoUring
+//==============================================================================
+
+//! @brief Minimal io_uring: SQ/CQ rings mapped into user space, raw io_uring_setup/io_uring_enter
+class EGAVHIDBatchEngine::IoUring
+{
+public:
+	~IoUring()
+	{
+		if (mSQRing && mSQRing != MAP_FAILED)
+			munmap(mSQRing, mSQRingSize);
+		if (mCQRing && mCQRing != MAP_FAILED && mCQRing != mSQRing)
+			munmap(mCQRing, mCQRingSize);
+		if (mSQEs && mSQEs != MAP_FAILED)
+			munmap(mSQEs, mSQEsSize);
+		if (mFD >= 0)
+			close(mFD);
+	}
+
+	EGAVResult Init(uint32_t inEntries)
+	{
+		struct io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		mFD = (int)syscall(__NR_io_uring_setup, inEntries, &params);
+		if (mFD < 0)
+		{
+			info_printf("EGAVHIDBatchEngine: io_uring not available (%d)", errno);
+			return EGAVResult::ErrNotSupported;
+		}
+		if (!(params.features & IORING_FEAT_NODROP) || !SupportsOps())
+		{
+			info_printf("EGAVHIDBatchEngine: io_uring lacks the required features");
+			return EGAVResult::ErrNotSupported;
+		}
+
+		mSQRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		mCQRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+		if (params.features & IORING_FEAT_SINGLE_MMAP)
+			mSQRingSize = mCQRingSize = std::max(mSQRingSize, mCQRingSize);
+		mSQEsSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+		mSQRing = mmap(nullptr, mSQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFD, IORING_OFF_SQ_RING);
+		mCQRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? mSQRing
+				: mmap(nullptr, mCQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFD, IORING_OFF_CQ_RING);
+		mSQEs   = (struct io_uring_sqe*)mmap(nullptr, mSQEsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFD, IORING_OFF_SQES);
+		if (mSQRing == MAP_FAILED || mCQRing == MAP_FAILED || mSQEs == MAP_FAILED)
+			return EGAVResult::ErrInsufficientMemory;
+
+		uint8_t* sq = (uint8_t*)mSQRing;
+		uint8_t* cq = (uint8_t*)mCQRing;
+		mSQHead    = (uint32_t*)(sq + params.sq_off.head);
+		mSQTail    = (uint32_t*)(sq + params.sq_off.tail);
+		mSQMask    = *(uint32_t*)(sq + params.sq_off.ring_mask);
+		mSQArray   = (uint32_t*)(sq + params.sq_off.array);
+		mCQHead    = (uint32_t*)(cq + params.cq_off.head);
+		mCQTail    = (uint32_t*)(cq + params.cq_off.tail);
+		mCQMask    = *(uint32_t*)(cq + params.cq_off.ring_mask);
+		mCQEs      = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+		mSQEntries = params.sq_entries;
+		return EGAVResult::Ok;
+	}
+
+	uint32_t GetSQEntries() const { return mSQEntries; }
+
+	//! @return cleared SQE at the tail (published by Submit()), nullptr if the ring is full
+	struct io_uring_sqe* GetSQE()
+	{
+		const uint32_t head = __atomic_load_n(mSQHead, __ATOMIC_ACQUIRE);
+		if (mLocalTail - head >= mSQEntries)
+			return nullptr;
+		const uint32_t index = mLocalTail & mSQMask;
+		mSQArray[index] = index;
+		mLocalTail++;
+		struct io_uring_sqe* sqe = &mSQEs[index];
+		memset(sqe, 0, sizeof(*sqe));
+		return sqe;
+	}
+
+	//! @brief Publishes the new SQEs, submits until the kernel has consumed all of them and waits for
+	//!        inMinComplete completions
+	//! @return number of io_uring_enter() calls, -1 on error (errno)
+	int Enter(uint32_t inMinComplete)
+	{
+		__atomic_store_n(mSQTail, mLocalTail, __ATOMIC_RELEASE);
+		int calls = 0;
+		for (;;)
+		{
+			const uint32_t toSubmit = mLocalTail - __atomic_load_n(mSQHead, __ATOMIC_ACQUIRE);
+			const int res = (int)syscall(__NR_io_uring_enter, mFD, toSubmit, inMinComplete, inMinComplete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+			calls++;
+			if (res < 0 && errno != EINTR)
+				return -1;
+
+			// The kernel stops at the first SQE it can't consume (and then doesn't wait): submit the rest
+			if (mLocalTail == __atomic_load_n(mSQHead, __ATOMIC_ACQUIRE))
+				return calls;
+			if (res == 0)
+			{
+				errno = EAGAIN;
+				return -1;
+			}
+		}
+	}
+
+	//! @brief Turns the SQEs the kernel hasn't consumed yet (Enter() failed) into NOPs: they no longer
+	//!        reference the report buffers, but still complete with their user data
+	void NeutralizeUnsubmitted()
+	{
+		for (uint32_t i = __atomic_load_n(mSQHead, __ATOMIC_ACQUIRE); i != mLocalTail; i++)
+		{
+			struct io_uring_sqe* sqe = &mSQEs[mSQArray[i & mSQMask]];
+			const uint64_t userData = sqe->user_data;
+			memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode    = IORING_OP_NOP;
+			sqe->user_data = userData;
+		}
+	}
+
+	//! @brief Calls inHandler for every available completion
+	template <class Handler>
+	void Reap(Handler&& inHandler)
+	{
+		uint32_t head = *mCQHead;
+		const uint32_t tail = __atomic_load_n(mCQTail, __ATOMIC_ACQUIRE);
+		for (; head != tail; head++)
+			inHandler(mCQEs[head & mCQMask]);
+		__atomic_store_n(mCQHead, head, __ATOMIC_RELEASE);
+	}
+
+private:
+	bool SupportsOps()
+	{
+		const size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+		std::vector<uint8_t> buffer(size, 0);
+		struct io_uring_probe* probe = (struct io_uring_probe*)buffer.data();
+		if (syscall(__NR_io_uring_register, mFD, IORING_REGISTER_PROBE, probe, 256) < 0)
+			return false;
+		for (int op : { IORING_OP_WRITE, IORING_OP_LINK_TIMEOUT })
+			if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+				return false;
+		return true;
+	}
+
+	int						mFD			= -1;
+	void*					mSQRing		= nullptr;
+	void*					mCQRing		= nullptr;
+	struct io_uring_sqe*	mSQEs		= nullptr;
+	size_t					mSQRingSize	= 0;
+	size_t					mCQRingSize	= 0;
+	size_t					mSQEsSize	= 0;
+	uint32_t*				mSQHead		= nullptr;
+	uint32_t*				mSQTail		= nullptr;
+	uint32_t*				mSQArray	= nullptr;
+	uint32_t				mSQMask		= 0;
+	uint32_t				mSQEntries	= 0;
+	uint32_t				mLocalTail	= 0;
+	uint32_t*				mCQHead		= nullptr;
+	uint32_t*				mCQTail		= nullptr;
+	uint32_t				mCQMask		= 0;
+	struct io_uring_cqe*	mCQEs		= nullptr;
+};
+
+
+//==============================================================================
+// # Class EGAVHIDBatchEngine
+//==============================================================================
+
+EGAVHIDBatchEngine::EGAVHIDBatchEngine(const EGAVHIDBatchEngineConfig& inConfig /*= EGAVHIDBatchEngineConfig()*/)
+	: mConfig(inConfig)
+{
+}
+
+EGAVHIDBatchEngine::~EGAVHIDBatchEngine()
+{
+	if (mEpollFD >= 0)
+		close(mEpollFD);
+}
+
+uint64_t EGAVHIDBatchEngine::GetTimeUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+const char* EGAVHIDBatchEngine::GetBackendName(EGAVHIDBatchBackend inBackend)
+{
+	switch (inBackend)
+	{
+		case EGAVHIDBatchBackend::IoUring:	return "io_uring";
+		case EGAVHIDBatchBackend::Sync:		return "sync";
+		default:							return "auto";
+	}
+}
+
+EGAVResult EGAVHIDBatchEngine::Init()
+{
+	if (mBackend != EGAVHIDBatchBackend::Auto)
+		return EGAVResult::ErrInvalidState;
+	if (mConfig.maxBatchSize == 0)
+		return EGAVResult::ErrInvalidParameter;
+
+	mEpollFD = epoll_create1(EPOLL_CLOEXEC);
+	if (mEpollFD < 0)
+		return EGAVResult::ErrResourceNotAvail;
+	if (mConfig.getReportThreads > 1)
+		mGetReportPool = std::make_unique<EGAVWorkerPool>(mConfig.getReportThreads - 1);
+
+	if (mConfig.backend != EGAVHIDBatchBackend::Sync)
+	{
+		// Two SQEs per transaction
+		auto ring = std::make_unique<IoUring>();
+		EGAVResult res = ring->Init(2 * mConfig.maxBatchSize);
+		if (res.Succeeded())
+		{
+			mRing    = std::move(ring);
+			mBackend = EGAVHIDBatchBackend::IoUring;
+			return EGAVResult::Ok;
+		}
+		if (mConfig.backend == EGAVHIDBatchBackend::IoUring)
+			return res;
+	}
+	mBackend = EGAVHIDBatchBackend::Sync;
+	return EGAVResult::Ok;
+}
+
+int EGAVHIDBatchEngine::AddDevice(std::unique_ptr<EGAVHIDRawTransport> inTransport, const EGAVDeviceID& inDeviceID,
+								  const EGAVFirmwareVersion& inFirmware /*= EGAVFirmwareVersion()*/, uint32_t inPollIntervalUs /*= 100000*/)
+{
+	if (mBackend == EGAVHIDBatchBackend::Auto || !inTransport)
+		return -1;
+
+	// Level triggered: the fd is reported as long as input reports are queued
+	const int index = (int)mDevices.size();
+	const int fd = inTransport->GetFD();
+	if (fd >= 0)
+	{
+		struct epoll_event ev = {};
+		ev.events   = EPOLLIN;
+		ev.data.u32 = (uint32_t)index;
+		if (epoll_ctl(mEpollFD, EPOLL_CTL_ADD, fd, &ev) != 0)
+			return -1;
+	}
+
+	auto device = std::make_unique<Device>();
+	device->transport      = std::move(inTransport);
+	device->newProtocol    = IsNewDeviceType(inDeviceID);
+	device->quirks         = ResolveElgatoUVCQuirks(inDeviceID, inFirmware);
+	device->pollIntervalUs = inPollIntervalUs;
+	device->nextPollUs     = GetTimeUs();
+	device->report.assign(std::max(device->transport->GetOutputReportSize(), kMaxRequestReportSize), 0);
+	mDevices.push_back(std::move(device));
+	return index;
+}
+
+void EGAVHIDBatchEngine::BuildReport(Device& ioDevice, const EGAVHIDBatchTransaction& inTransaction)
+{
+	uint8_t* report = ioDevice.report.data();
+	size_t size = 0;
+	if (inTransaction.isRead)
+	{
+		if (ioDevice.newProtocol)
+			size = BuildReadReport<NewProtocol>(inTransaction.address, inTransaction.reg, inTransaction.length, report);
+		else
+			size = BuildReadReport<LegacyProtocol>(inTransaction.address, inTransaction.reg, inTransaction.length, report);
+	}
+	else
+	{
+		if (ioDevice.newProtocol)
+			size = BuildWriteReport<NewProtocol>(inTransaction.address, inTransaction.reg, inTransaction.data.data(), inTransaction.length, report);
+		else
+			size = BuildWriteReport<LegacyProtocol>(inTransaction.address, inTransaction.reg, inTransaction.data.data(), inTransaction.length, report);
+	}
+
+	// io_uring writes the report as is; WriteReport() pads it itself. Clear what a longer previous request left behind.
+	const size_t outputReportSize = ioDevice.transport->GetOutputReportSize();
+	if (size < outputReportSize)
+	{
+		memset(report + size, 0, outputReportSize - size);
+		size = outputReportSize;
+	}
+	ioDevice.reportSize = size;
+}
+
+bool EGAVHIDBatchEngine::ParseResponse(Device& ioDevice, const uint8_t* inReport, size_t inSize, EGAVHIDBatchTransaction& ioTransaction)
+{
+	return ioDevice.newProtocol ? ParseReadReport<NewProtocol>(inReport, inSize, ioTransaction.data.data(), ioTransaction.length)
+								: ParseReadReport<LegacyProtocol>(inReport, inSize, ioTransaction.data.data(), ioTransaction.length);
+}
+
+EGAVResult EGAVHIDBatchEngine::Execute(EGAVHIDBatchTransaction* ioTransactions, size_t inCount)
+{
+	if (mBackend == EGAVHIDBatchBackend::Auto)
+		return EGAVResult::ErrNotInitialized;
+	if (inCount && !ioTransactions)
+		return EGAVResult::ErrNullPointer;
+
+	// Validate: known devices, one transaction per device and batch
+	EGAVResult res = EGAVResult::Ok;
+	for (size_t i = 0; i < inCount; i++)
+	{
+		EGAVHIDBatchTransaction& transaction = ioTransactions[i];
+		const bool valid = transaction.device >= 0 && transaction.device < (int)mDevices.size()
+						&& transaction.length <= (transaction.isRead ? MAX_COMM_READ_BUFFER_SIZE + 1 : MAX_COMM_WRITE_BUFFER_SIZE)
+						&& !mDevices[transaction.device]->inBatch;
+		if (valid)
+			mDevices[transaction.device]->inBatch = true;
+		else
+			res = EGAVResult::ErrInvalidParameter;
+	}
+	for (size_t i = 0; i < inCount; i++)
+		if (ioTransactions[i].device >= 0 && ioTransactions[i].device < (int)mDevices.size())
+			mDevices[ioTransactions[i].device]->inBatch = false;
+	if (res.Failed())
+		return res;
+
+	for (size_t offset = 0; offset < inCount; offset += mConfig.maxBatchSize)
+	{
+		res = ExecuteBatch(ioTransactions + offset, std::min<size_t>(inCount - offset, mConfig.maxBatchSize));
+		if (res.Failed())
+			return res;
+	}
+	return EGAVResult::Ok;
+}
+
+EGAVResult EGAVHIDBatchEngine::ExecuteBatch(EGAVHIDBatchTransaction* ioTransactions, size_t inCount)
+{
+	// Writes of an aborted batch may still reference the report buffers that BuildReport() overwrites
+	if (mRingPending)
+	{
+		EGAVResult res = WaitForAbortedWrites();
+		if (res.Failed())
+			return res;
+	}
+
+	mStatistics.batches++;
+	DrainStaleInput(ioTransactions, inCount);
+
+	for (size_t i = 0; i < inCount; i++)
+	{
+		BuildReport(*mDevices[ioTransactions[i].device], ioTransactions[i]);
+		ioTransactions[i].result = EGAVResult::Ok;
+	}
+	if (mBackend == EGAVHIDBatchBackend::IoUring)
+	{
+		EGAVResult res = WriteReportsIoUring(ioTransactions, inCount);
+		if (res.Failed())
+			return res;
+	}
+	else
+		WriteReportsSync(ioTransactions, inCount);
+	ReadResponses(ioTransactions, inCount);
+
+	for (size_t i = 0; i < inCount; i++)
+	{
+		mStatistics.transactions++;
+		if (ioTransactions[i].result.GetResultCode() == EGAVResult::ErrTimeOut)
+			mStatistics.timeouts++;
+		else if (ioTransactions[i].result.Failed())
+			mStatistics.errors++;
+	}
+	return EGAVResult::Ok;
+}
+
+//! Responses carry no register echo: a report queued before the request (interrupt-IN, or the
+//! answer to a request of an earlier batch) must not be taken for the response
+void EGAVHIDBatchEngine::DrainStaleInput(const EGAVHIDBatchTransaction* inTransactions, size_t inCount)
+{
+	struct epoll_event events[kMaxEventsPerWait];
+	for (;;)
+	{
+		const int count = epoll_wait(mEpollFD, events, kMaxEventsPerWait, 0);
+		mStatistics.syscalls++;
+		for (int e = 0; e < count; e++)
+		{
+			const size_t drained = mDevices[events[e].data.u32]->transport->DrainInput();
+			mStatistics.drainedReports += drained;
+			mStatistics.syscalls += drained + 1; // reads until EAGAIN
+		}
+		if (count < kMaxEventsPerWait)
+			break;
+	}
+
+	// Transports without fd (e.g. simulations) are drained directly
+	for (size_t i = 0; i < inCount; i++)
+	{
+		EGAVHIDRawTransport& transport = *mDevices[inTransactions[i].device]->transport;
+		if (transport.GetFD() < 0)
+			mStatistics.drainedReports += transport.DrainInput();
+	}
+}
+
+//==============================================================================
+// ## io_uring backend
+//==============================================================================
+
+EGAVResult EGAVHIDBatchEngine::WriteReportsIoUring(EGAVHIDBatchTransaction* ioTransactions, size_t inCount)
+{
+	// One chain per transaction: write report -> link timeout
+	const uint32_t batch = ++mBatchSequence;
+	uint32_t expected = 0;
+	for (size_t i = 0; i < inCount; i++)
+	{
+		EGAVHIDBatchTransaction& transaction = ioTransactions[i];
+		Device& device = *mDevices[transaction.device];
+		const int fd = device.transport->GetFD();
+		if (fd < 0)
+		{
+			transaction.result = device.transport->WriteReport(device.report.data(), device.reportSize);
+			continue;
+		}
+
+		// The ring has room for maxBatchSize chains (aborted batches were waited for); guard against a full ring anyway
+		struct io_uring_sqe* sqe = mRing->GetSQE();
+		struct io_uring_sqe* timeoutSQE = sqe ? mRing->GetSQE() : nullptr;
+		if (!timeoutSQE)
+		{
+			if (sqe)
+			{
+				sqe->opcode    = IORING_OP_NOP;
+				sqe->user_data = EncodeUserData(batch, i, RingOp::Timeout);
+				expected++;
+			}
+			transaction.result = EGAVResult::ErrResourceNotAvail;
+			continue;
+		}
+
+		sqe->opcode    = IORING_OP_WRITE;
+		sqe->fd        = fd;
+		sqe->addr      = (uint64_t)(uintptr_t)device.report.data();
+		sqe->len       = (uint32_t)device.reportSize;
+		sqe->off       = (uint64_t)-1; // current position (not seekable)
+		sqe->flags     = IOSQE_IO_LINK;
+		sqe->user_data = EncodeUserData(batch, i, RingOp::Write);
+
+		device.timeout.tv_sec  = mConfig.responseTimeoutUs / 1000000;
+		device.timeout.tv_nsec = (long long)(mConfig.responseTimeoutUs % 1000000) * 1000;
+		timeoutSQE->opcode    = IORING_OP_LINK_TIMEOUT;
+		timeoutSQE->addr      = (uint64_t)(uintptr_t)&device.timeout;
+		timeoutSQE->len       = 1;
+		timeoutSQE->user_data = EncodeUserData(batch, i, RingOp::Timeout);
+		expected += 2;
+	}
+
+	// Submit everything and wait for all completions; usually one syscall per batch
+	uint32_t reaped = 0;
+	while (reaped < expected)
+	{
+		const int calls = mRing->Enter(expected - reaped);
+		if (calls < 0)
+		{
+			mStatistics.syscalls++;
+			error_printf("EGAVHIDBatchEngine: io_uring_enter() failed (%d)", errno);
+
+			// Submitted writes complete later (bounded by their link timeouts); the next batch waits for them
+			mRing->NeutralizeUnsubmitted();
+			mRingPending = expected - reaped;
+			return EGAVResult::ErrUnknown;
+		}
+		mStatistics.syscalls += (uint64_t)calls;
+
+		mRing->Reap([&](const struct io_uring_cqe& inCQE)
+		{
+			if ((uint32_t)(inCQE.user_data >> 32) != batch)
+				return;
+			reaped++;
+			if ((RingOp)(inCQE.user_data & 1) != RingOp::Write)
+				return; // -ETIME: the write was cancelled
+
+			const size_t slot = (size_t)((inCQE.user_data & 0xFFFFFFFF) >> 1);
+			EGAVHIDBatchTransaction& transaction = ioTransactions[slot];
+			if (inCQE.res == (int)mDevices[transaction.device]->reportSize)
+				return;
+			error_printf("EGAVHIDBatchEngine: write() FAILED for I2C address 0x%02x, register 0x%02x (%d)", transaction.address, transaction.reg, -inCQE.res);
+			if (inCQE.res == -ECANCELED)
+				transaction.result = EGAVResult::ErrTimeOut;
+			else if (inCQE.res == -ENODEV)
+				transaction.result = EGAVResult::ErrNotFound;
+			else
+				transaction.result = EGAVResult::ErrUnknown;
+		});
+	}
+	return EGAVResult::Ok;
+}
+
+EGAVResult EGAVHIDBatchEngine::WaitForAbortedWrites()
+{
+	while (mRingPending)
+	{
+		const int calls = mRing->Enter(mRingPending);
+		if (calls < 0)
+		{
+			mStatistics.syscalls++;
+			error_printf("EGAVHIDBatchEngine: io_uring_enter() failed (%d)", errno);
+			return EGAVResult::ErrUnknown;
+		}
+		mStatistics.syscalls += (uint64_t)calls;
+		mRing->Reap([&](const struct io_uring_cqe&) { mRingPending--; });
+	}
+	return EGAVResult::Ok;
+}
+
+//==============================================================================
+// ## Sync backend
+//==============================================================================
+
+void EGAVHIDBatchEngine::WriteReportsSync(EGAVHIDBatchTransaction* ioTransactions, size_t inCount)
+{
+	for (size_t i = 0; i < inCount; i++)
+	{
+		EGAVHIDBatchTransaction& transaction = ioTransactions[i];
+		Device& device = *mDevices[transaction.device];
+		transaction.result = device.transport->WriteReport(device.report.data(), device.reportSize);
+		mStatistics.syscalls++;
+		if (transaction.result.Failed())
+			error_printf("EGAVHIDBatchEngine: write() FAILED for I2C address 0x%02x, register 0x%02x", transaction.address, transaction.reg);
+	}
+}
+
+//==============================================================================
+// ## Responses
+//==============================================================================
+
+void EGAVHIDBatchEngine::ReadResponses(EGAVHIDBatchTransaction* ioTransactions, size_t inCount)
+{
+	mReads.clear();
+	for (size_t i = 0; i < inCount; i++)
+		if (ioTransactions[i].isRead && ioTransactions[i].result.Succeeded())
+			mReads.push_back(&ioTransactions[i]);
+	mStatistics.syscalls += mReads.size();
+
+	// Each call touches the buffers of its own device only
+	if (mGetReportPool && mReads.size() > 1)
+		mGetReportPool->ParallelFor(mReads.size(), [this](size_t inIndex) { ReadResponse(*mReads[inIndex]); });
+	else
+		for (EGAVHIDBatchTransaction* transaction : mReads)
+			ReadResponse(*transaction);
+}
+
+void EGAVHIDBatchEngine::ReadResponse(EGAVHIDBatchTransaction& ioTransaction)
+{
+	Device& device = *mDevices[ioTransaction.device];
+	size_t bufferSize = 0;
+	if (device.newProtocol)
+	{
+		device.input[0] = (uint8_t)NewProtocol::kReadResponseReportID;
+		bufferSize = GetReadResponseBufferSize<NewProtocol>(*device.transport);
+	}
+	else
+	{
+		device.input[0] = (uint8_t)LegacyProtocol::kReadResponseReportID;
+		bufferSize = GetReadResponseBufferSize<LegacyProtocol>(*device.transport);
+	}
+
+	size_t size = 0;
+	ioTransaction.result = device.transport->GetInputReport(device.input, std::min(bufferSize, sizeof(device.input)), size);
+	if (ioTransaction.result.Failed())
+		error_printf("EGAVHIDBatchEngine: GET_REPORT FAILED for I2C address 0x%02x, register 0x%02x", ioTransaction.address, ioTransaction.reg);
+	else if (!ParseResponse(device, device.input, size, ioTransaction))
+		ioTransaction.result = EGAVResult::ErrNoData; // other input report
+}
+
+//==============================================================================
+// ## HDR status polls
+//==============================================================================
+
+EGAVResult EGAVHIDBatchEngine::PollHDRStatus(const int* inDevices, size_t inCount, const HDRStatusCallback& inCallback)
+{
+	if (inCount && !inDevices)
+		return EGAVResult::ErrNullPointer;
+
+	mBatch.resize(inCount);
+	for (size_t i = 0; i < inCount; i++)
+	{
+		EGAVHIDBatchTransaction& transaction = mBatch[i];
+		transaction.device  = inDevices[i];
+		transaction.isRead  = true;
+		transaction.address = (uint8_t)I2CAddress::MCU;
+		transaction.reg     = (uint8_t)MCU_I2C_REGISTER::GET_HDR_PACKET;
+		transaction.length  = (inDevices[i] >= 0 && inDevices[i] < (int)mDevices.size()) ? mDevices[inDevices[i]]->quirks.infoFrameReadSize : 0;
+	}
+
+	EGAVResult res = Execute(mBatch.data(), inCount);
+	if (res.Failed() || !inCallback)
+		return res;
+
+	for (const EGAVHIDBatchTransaction& transaction : mBatch)
+	{
+		// Same as ElgatoUVCDevice::ReadInfoFrameRegister()
+		const ElgatoUVCQuirks& quirks = mDevices[transaction.device]->quirks;
+		HDMI_GENERIC_INFOFRAME frame{};
+		if (transaction.result.Succeeded())
+		{
+			const size_t size = std::min((size_t)(transaction.length - quirks.infoFrameOffset), sizeof(frame));
+			memcpy(&frame, transaction.data.data() + quirks.infoFrameOffset, size);
+			quirks.ApplyInfoFrameFixups(frame);
+		}
+		inCallback(transaction.device, transaction.result, frame);
+	}
+	return EGAVResult::Ok;
+}
+
+EGAVResult EGAVHIDBatchEngine::RunPollTick(const HDRStatusCallback& inCallback)
+{
+	uint64_t nextUs = UINT64_MAX;
+	for (const auto& device : mDevices)
+		if (device->pollIntervalUs)
+			nextUs = std::min(nextUs, device->nextPollUs);
+	if (nextUs == UINT64_MAX)
+		return EGAVResult::ErrNotFound;
+
+	uint64_t nowUs = GetTimeUs();
+	if (nextUs > nowUs)
+	{
+		struct timespec ts;
+		ts.tv_sec  = (time_t)(nextUs / 1000000);
+		ts.tv_nsec = (long)(nextUs % 1000000) * 1000;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+			;
+		nowUs = GetTimeUs();
+	}
+
+	// Everything due within this tick goes into the batch
+	mDue.clear();
+	const uint64_t tickEndUs = nowUs + mConfig.tickUs;
+	for (size_t i = 0; i < mDevices.size(); i++)
+	{
+		Device& device = *mDevices[i];
+		if (!device.pollIntervalUs || device.nextPollUs >= tickEndUs)
+			continue;
+
+		const uint64_t jitterUs = (nowUs > device.nextPollUs) ? nowUs - device.nextPollUs : 0;
+		mStatistics.pollJitterUsTotal += jitterUs;
+		mStatistics.pollJitterUsMax = std::max(mStatistics.pollJitterUsMax, jitterUs);
+
+		// Fixed schedule; intervals missed by a slow batch are skipped
+		device.nextPollUs += device.pollIntervalUs;
+		if (device.nextPollUs <= nowUs)
+			device.nextPollUs = nowUs + device.pollIntervalUs - (nowUs - device.nextPollUs) % device.pollIntervalUs;
+		mDue.push_back((int)i);
+	}
+	return PollHDRStatus(mDue.data(), mDue.size(), inCallback);
+}
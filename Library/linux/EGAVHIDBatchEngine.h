@@ -0,0 +1,186 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVHIDBatchEngine.h
+
+@brief		Batched I2C-over-HID transactions for many devices on Linux.
+
+			All devices due in a poll tick are serviced as one batch:
+			1. Stale input reports of the devices are discarded (one epoll_wait()
+			   finds the hidraw fds with queued reports), so nothing queued before the
+			   batch is taken for a response.
+			2. The output reports (requests) are written. With io_uring the writes of
+			   the whole batch are submitted with one io_uring_enter() (raw syscalls,
+			   no liburing), each linked to a timeout. hidraw doesn't support
+			   non-blocking writes (no FMODE_NOWAIT), so io_uring runs every write on
+			   an io-wq worker: the batch costs one syscall on the calling thread and
+			   the USB transfers of the devices overlap. Without io_uring (old kernel,
+			   io_uring_disabled, seccomp) the writes are issued one by one.
+			3. The responses are read with GET_REPORT (HIDIOCGINPUT), like
+			   ElgatoUVCDevice does on every platform. io_uring can't issue this
+			   ioctl; the calls of a batch are spread over getReportThreads threads.
+			   They are bounded by the USB control timeout of the kernel, not by
+			   responseTimeoutUs.
+
+			Devices are hidraw transports (see EGAVHIDRawDevice.h and
+			EGAVHIDRawReports.h for the report framing). Compared to
+			EGAVAsyncUVCDevice this engine trades per-transaction latency for fewer
+			syscalls and threads: a batch completes when its slowest device has
+			answered. Not thread safe.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "EGAVResult.h"
+#include "EGAVDevice.h"
+#include "HDMIInfoFramesAPI.h"
+#include "ElgatoUVCProtocol.h"
+#include "ElgatoUVCQuirks.h"
+#include "EGAVHIDRawDevice.h"
+#include "EGAVWorkerPool.h"
+
+
+enum class EGAVHIDBatchBackend
+{
+	Auto,		//!< io_uring if available, else Sync
+	IoUring,
+	Sync,		//!< blocking writes on the calling thread
+};
+
+struct EGAVHIDBatchEngineConfig
+{
+	EGAVHIDBatchBackend	backend				= EGAVHIDBatchBackend::Auto;
+	uint32_t			maxBatchSize		= 64;		//!< transactions per submission (larger batches are split)
+	uint32_t			responseTimeoutUs	= 100000;	//!< io_uring: output report writes of a batch
+	uint32_t			tickUs				= 1000;		//!< RunPollTick(): devices due within one tick share a batch
+	uint32_t			getReportThreads	= 4;		//!< GET_REPORT calls of a batch in parallel (including the calling thread)
+};
+
+struct EGAVHIDBatchStatistics
+{
+	uint64_t	batches				= 0;
+	uint64_t	transactions		= 0;
+	uint64_t	timeouts			= 0;
+	uint64_t	errors				= 0;
+	uint64_t	syscalls			= 0;	//!< I/O syscalls issued by the engine (io_uring_enter, write, ioctl, epoll_wait, read)
+	uint64_t	drainedReports		= 0;	//!< stale input reports discarded before a batch
+	uint64_t	pollJitterUsMax		= 0;	//!< RunPollTick(): batch start after the due time of a device
+	uint64_t	pollJitterUsTotal	= 0;
+};
+
+//! @brief One I2C transaction of a batch (at most one per device)
+struct EGAVHIDBatchTransaction
+{
+	int			device		= -1;		//!< EGAVHIDBatchEngine::AddDevice() index
+	bool		isRead		= true;
+	uint8_t		address		= 0;
+	uint8_t		reg			= 0;
+	uint8_t		length		= 0;		//!< read: up to MAX_COMM_READ_BUFFER_SIZE + 1, write: up to MAX_COMM_WRITE_BUFFER_SIZE
+	std::array<uint8_t, MAX_COMM_READ_BUFFER_SIZE + 1> data{};	//!< write: in, read: out
+	EGAVResult	result		= EGAVResult::Ok;
+};
+
+
+//==============================================================================
+// # Class EGAVHIDBatchEngine
+//==============================================================================
+
+class EGAVHIDBatchEngine
+{
+public:
+	//! @brief inFrame is only valid if inResult succeeded
+	typedef std::function<void(int inDevice, EGAVResult inResult, const HDMI_GENERIC_INFOFRAME& inFrame)> HDRStatusCallback;
+
+	explicit EGAVHIDBatchEngine(const EGAVHIDBatchEngineConfig& inConfig = EGAVHIDBatchEngineConfig());
+	~EGAVHIDBatchEngine();
+	EGAVHIDBatchEngine(const EGAVHIDBatchEngine&) = delete;
+	EGAVHIDBatchEngine& operator=(const EGAVHIDBatchEngine&) = delete;
+
+	//! @return ErrNotSupported if io_uring was requested explicitly and isn't available
+	EGAVResult Init();
+	EGAVHIDBatchBackend GetBackend() const { return mBackend; }
+	static const char* GetBackendName(EGAVHIDBatchBackend inBackend);
+
+	//! @param inTransport the device's reports, e.g. EGAVAsyncUVCDevice::OpenHIDRaw(); owned by this object
+	//! @param inPollIntervalUs RunPollTick() interval (0: not polled)
+	//! @return device index, -1 on error
+	int AddDevice(std::unique_ptr<EGAVHIDRawTransport> inTransport, const EGAVDeviceID& inDeviceID, const EGAVFirmwareVersion& inFirmware = EGAVFirmwareVersion(),
+				  uint32_t inPollIntervalUs = 100000);
+	size_t GetDeviceCount() const { return mDevices.size(); }
+
+	//! @brief Runs the transactions as one batch (split at maxBatchSize) and sets their results
+	EGAVResult Execute(EGAVHIDBatchTransaction* ioTransactions, size_t inCount);
+
+	//! @brief Reads the HDR status packet (DR info frame) of the devices in one batch
+	EGAVResult PollHDRStatus(const int* inDevices, size_t inCount, const HDRStatusCallback& inCallback);
+
+	//! @brief Sleeps until the next poll is due, then polls all devices due within that tick in one batch
+	EGAVResult RunPollTick(const HDRStatusCallback& inCallback);
+
+	const EGAVHIDBatchStatistics& GetStatistics() const { return mStatistics; }
+	void ResetStatistics() { mStatistics = EGAVHIDBatchStatistics(); }
+
+	static uint64_t GetTimeUs();
+
+private:
+	struct Device;
+	class IoUring;
+
+	void BuildReport(Device& ioDevice, const EGAVHIDBatchTransaction& inTransaction);
+	bool ParseResponse(Device& ioDevice, const uint8_t* inReport, size_t inSize, EGAVHIDBatchTransaction& ioTransaction);
+	EGAVResult ExecuteBatch(EGAVHIDBatchTransaction* ioTransactions, size_t inCount);
+	void DrainStaleInput(const EGAVHIDBatchTransaction* inTransactions, size_t inCount);
+	EGAVResult WriteReportsIoUring(EGAVHIDBatchTransaction* ioTransactions, size_t inCount);
+	EGAVResult WaitForAbortedWrites();
+	void WriteReportsSync(EGAVHIDBatchTransaction* ioTransactions, size_t inCount);
+	void ReadResponses(EGAVHIDBatchTransaction* ioTransactions, size_t inCount);
+	void ReadResponse(EGAVHIDBatchTransaction& ioTransaction);
+
+	const EGAVHIDBatchEngineConfig		mConfig;
+	EGAVHIDBatchBackend					mBackend	= EGAVHIDBatchBackend::Auto;
+	std::unique_ptr<IoUring>			mRing;
+	uint32_t							mBatchSequence	= 0;	//!< io_uring user data tag of the last batch
+	uint32_t							mRingPending	= 0;	//!< completions still due from a batch aborted by io_uring_enter() errors
+	int									mEpollFD	= -1;	//!< readable hidraw fds (stale input reports)
+	std::unique_ptr<EGAVWorkerPool>		mGetReportPool;
+	std::vector<std::unique_ptr<Device>> mDevices;
+
+	// Batch scratch
+	std::vector<EGAVHIDBatchTransaction*> mReads;
+
+	// RunPollTick() scratch
+	std::vector<int>					mDue;
+	std::vector<EGAVHIDBatchTransaction> mBatch;
+
+	EGAVHIDBatchStatistics				mStatistics;
+};
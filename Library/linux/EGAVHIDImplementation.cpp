@@ -0,0 +1,95 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		EGAVHIDImplementation.cpp
+
+@brief		Linux implementation of EGAVHIDInterface (hidraw)
+**/
+//==============================================================================
+
+#include "EGAVHIDImplementation.h"
+
+#include <algorithm>
+
+
+std::shared_ptr<EGAVHIDInterface> CreateEGAVHIDInterface()
+{
+	return std::make_shared<EGAVHID>();
+}
+
+
+//==============================================================================
+// ## Class EGAVHID
+//==============================================================================
+
+EGAVHID::EGAVHID()
+{
+}
+
+EGAVResult EGAVHID::InitHIDInterface(const EGAVDeviceID& inDeviceID)
+{
+	if (mDevice.IsOpen())
+		return EGAVResult::ErrInvalidState;
+
+	const std::string path = EGAVHIDRawDevice::FindDevice(inDeviceID);
+	if (path.empty())
+		return EGAVResult::ErrNotFound;
+	return mDevice.Open(path);
+}
+
+EGAVResult EGAVHID::DeinitHIDInterface()
+{
+	mDevice.Close();
+	return EGAVResult::Ok;
+}
+
+EGAVResult EGAVHID::ReadHID(std::vector<uint8_t>& outMessage, int inReportID, int inReadBufferSize /*= 0*/)
+{
+	if (!mDevice.IsOpen())
+		return EGAVResult::ErrNotInitialized;
+
+	// Same as HidD_GetInputReport(): the buffer size is the requested length (see NewProtocol::kReadResponseSize)
+	const size_t bufferSize = (inReadBufferSize > 0) ? (size_t)inReadBufferSize : mDevice.GetInputReportSize((uint8_t)inReportID);
+	mReport.assign(std::max<size_t>(bufferSize, 2), 0);
+	mReport[0] = (uint8_t)inReportID;
+
+	size_t size = 0;
+	EGAVResult res = mDevice.GetInputReport(mReport.data(), mReport.size(), size);
+	if (res.Succeeded())
+		outMessage.assign(mReport.begin(), mReport.begin() + size);
+	return res;
+}
+
+EGAVResult EGAVHID::WriteHID(const std::vector<uint8_t>& inMessage, int inReportID)
+{
+	if (!mDevice.IsOpen())
+		return EGAVResult::ErrNotInitialized;
+
+	mReport.assign(1, (uint8_t)inReportID);
+	mReport.insert(mReport.end(), inMessage.begin(), inMessage.end());
+	return mDevice.WriteReport(mReport.data(), mReport.size());
+}
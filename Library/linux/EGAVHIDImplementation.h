@@ -0,0 +1,66 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		EGAVHIDImplementation.h
+
+@brief		Linux implementation of EGAVHIDInterface (hidraw)
+**/
+//==============================================================================
+
+#pragma once
+
+#include <memory>
+
+#include "EGAVHID.h"
+#include "EGAVHIDRawDevice.h"
+
+class EGAVHID : public EGAVHIDInterface
+{
+public:
+	EGAVHID();
+
+	//-----------------------------------------------------------------------------
+	// ## EGAVHIDInterface implementation
+	//-----------------------------------------------------------------------------
+	//! @brief Opens the first hidraw node of the device (inDeviceID.locationID is ignored)
+	virtual EGAVResult InitHIDInterface(const EGAVDeviceID& inDeviceID) override;
+	virtual EGAVResult DeinitHIDInterface() override;
+
+	//! @brief Reads an input report with GET_REPORT (HIDIOCGINPUT), like HidD_GetInputReport() on Windows.
+	//! @param outMessage will contain the report, report ID first. Its length will be adjusted automatically.
+	virtual EGAVResult ReadHID(std::vector<uint8_t>& outMessage, int inReportID, int inReadBufferSize = 0) override;
+
+	//! @brief Writes a HID report (report ID, then inMessage) padded to the output report size.
+	//! @param inMessage the report contents, not including the report ID.
+	virtual EGAVResult WriteHID(const std::vector<uint8_t>& inMessage, int inReportID) override;
+
+	EGAVHIDRawDevice& GetRawDevice() { return mDevice; }
+
+private:
+	EGAVHIDRawDevice			mDevice;
+	std::vector<uint8_t>		mReport;	//!< reused report buffer
+};
@@ -0,0 +1,257 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		EGAVHIDRawDevice.cpp
+
+@brief		Report-level access to a HID device on Linux (hidraw)
+**/
+//==============================================================================
+
+#include "EGAVHIDRawDevice.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/hidraw.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <vector>
+
+
+const uint32_t kBusUSB			= 0x03;		//!< BUS_USB of linux/input.h
+const size_t kMaxReportSize		= 4096;		//!< largest report handled here (the kernel limit is 16 KiB)
+
+//! @brief Report sizes (bits) per report ID from the main items of a report descriptor
+static void ParseReportDescriptor(const uint8_t* inDescriptor, size_t inSize, uint32_t* outInputBits, uint32_t* outOutputBits)
+{
+	struct Globals { uint32_t reportSize = 0, reportCount = 0; uint8_t reportID = 0; };
+	Globals globals;
+	std::vector<Globals> stack;
+
+	size_t i = 0;
+	while (i < inSize)
+	{
+		const uint8_t prefix = inDescriptor[i];
+		if (prefix == 0xFE) // long item: size, tag, data
+		{
+			if (i + 1 >= inSize)
+				break;
+			i += 3 + inDescriptor[i + 1];
+			continue;
+		}
+
+		const size_t length = ((prefix & 3) == 3) ? 4 : (prefix & 3);
+		if (i + 1 + length > inSize)
+			break;
+		uint32_t value = 0;
+		for (size_t b = 0; b < length; b++)
+			value |= (uint32_t)inDescriptor[i + 1 + b] << (8 * b);
+
+		switch (prefix & 0xFC)
+		{
+			case 0x80: outInputBits[globals.reportID]  += globals.reportSize * globals.reportCount; break; // Input
+			case 0x90: outOutputBits[globals.reportID] += globals.reportSize * globals.reportCount; break; // Output
+			case 0x74: globals.reportSize  = value; break;
+			case 0x94: globals.reportCount = value; break;
+			case 0x84: globals.reportID    = (uint8_t)value; break;
+			case 0xA4: stack.push_back(globals); break; // Push
+			case 0xB4: if (!stack.empty()) { globals = stack.back(); stack.pop_back(); } break; // Pop
+			default: break;
+		}
+		i += 1 + length;
+	}
+}
+
+
+//==============================================================================
+// # Class EGAVHIDRawDevice
+//==============================================================================
+
+EGAVHIDRawDevice::~EGAVHIDRawDevice()
+{
+	Close();
+}
+
+std::string EGAVHIDRawDevice::FindDevice(const EGAVDeviceID& inDeviceID, int inIndex /*= 0*/)
+{
+	std::vector<std::string> nodes;
+	DIR* dir = opendir("/sys/class/hidraw");
+	if (!dir)
+		return std::string();
+
+	while (struct dirent* entry = readdir(dir))
+	{
+		if (strncmp(entry->d_name, "hidraw", 6) != 0)
+			continue;
+
+		// HID_ID=0003:00000FD9:0000006A
+		const std::string uevent = std::string("/sys/class/hidraw/") + entry->d_name + "/device/uevent";
+		FILE* file = fopen(uevent.c_str(), "r");
+		if (!file)
+			continue;
+		char line[256];
+		while (fgets(line, sizeof(line), file))
+		{
+			unsigned int bus = 0, vendor = 0, product = 0;
+			if (sscanf(line, "HID_ID=%x:%x:%x", &bus, &vendor, &product) == 3)
+			{
+				if (bus == kBusUSB && vendor == inDeviceID.vendorID && product == inDeviceID.productID)
+					nodes.push_back(std::string("/dev/") + entry->d_name);
+				break;
+			}
+		}
+		fclose(file);
+	}
+	closedir(dir);
+
+	// readdir() order is arbitrary; hidraw numbers follow the enumeration order
+	std::sort(nodes.begin(), nodes.end(), [](const std::string& a, const std::string& b)
+	{
+		return (a.size() != b.size()) ? a.size() < b.size() : a < b;
+	});
+	return (inIndex >= 0 && inIndex < (int)nodes.size()) ? nodes[inIndex] : std::string();
+}
+
+EGAVResult EGAVHIDRawDevice::Open(const std::string& inPath)
+{
+	if (mFD >= 0)
+		return EGAVResult::ErrInvalidState;
+
+	mFD = open(inPath.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+	if (mFD < 0)
+	{
+		error_printf("EGAVHIDRawDevice: can't open %s (%d)", inPath.c_str(), errno);
+		return (errno == EACCES) ? EGAVResult::ErrDeviceInUse : EGAVResult::ErrNotFound;
+	}
+
+	int descriptorSize = 0;
+	struct hidraw_report_descriptor descriptor;
+	memset(&descriptor, 0, sizeof(descriptor));
+	if (ioctl(mFD, HIDIOCGRDESCSIZE, &descriptorSize) < 0 || descriptorSize <= 0 || descriptorSize > HID_MAX_DESCRIPTOR_SIZE)
+		descriptorSize = 0;
+	descriptor.size = (uint32_t)descriptorSize;
+	if (descriptorSize == 0 || ioctl(mFD, HIDIOCGRDESC, &descriptor) < 0)
+	{
+		error_printf("EGAVHIDRawDevice: can't read the report descriptor of %s (%d)", inPath.c_str(), errno);
+		Close();
+		return EGAVResult::ErrInvalidFormat;
+	}
+
+	uint32_t inputBits[256] = {}, outputBits[256] = {};
+	ParseReportDescriptor(descriptor.value, descriptor.size, inputBits, outputBits);
+
+	// Reports always start with the report ID byte (0 for a device without report IDs)
+	mOutputReportSize = mMaxInputReportSize = 0;
+	for (int id = 0; id < 256; id++)
+	{
+		mInputReportSizes[id] = inputBits[id] ? (uint16_t)(1 + (inputBits[id] + 7) / 8) : 0;
+		mMaxInputReportSize   = std::max(mMaxInputReportSize, (size_t)mInputReportSizes[id]);
+		if (outputBits[id])
+			mOutputReportSize = std::max(mOutputReportSize, (size_t)(1 + (outputBits[id] + 7) / 8));
+	}
+	return EGAVResult::Ok;
+}
+
+void EGAVHIDRawDevice::Close()
+{
+	if (mFD >= 0)
+		close(mFD);
+	mFD = -1;
+}
+
+size_t EGAVHIDRawDevice::GetInputReportSize(uint8_t inReportID) const
+{
+	return mInputReportSizes[inReportID] ? mInputReportSizes[inReportID] : mMaxInputReportSize;
+}
+
+EGAVResult EGAVHIDRawDevice::WriteReport(const uint8_t* inReport, size_t inSize)
+{
+	EGAVResult_CheckPointer(inReport);
+	if (mFD < 0)
+		return EGAVResult::ErrNotInitialized;
+
+	// hidraw sends what it gets: pad like HidD_SetOutputReport() requires
+	uint8_t padded[kMaxReportSize];
+	if (inSize < mOutputReportSize && mOutputReportSize <= sizeof(padded))
+	{
+		memcpy(padded, inReport, inSize);
+		memset(padded + inSize, 0, mOutputReportSize - inSize);
+		inReport = padded;
+		inSize   = mOutputReportSize;
+	}
+
+	ssize_t written = 0;
+	do
+		written = write(mFD, inReport, inSize);
+	while (written < 0 && errno == EINTR);
+	if (written == (ssize_t)inSize)
+		return EGAVResult::Ok;
+	if (written >= 0)
+		return EGAVResult::ErrInvalidOperation;
+	// ENODEV: unplugged; ETIMEDOUT: no answer to the output transfer
+	return (errno == ENODEV) ? EGAVResult::ErrNotFound : (errno == ETIMEDOUT) ? EGAVResult::ErrTimeOut : EGAVResult::ErrInvalidOperation;
+}
+
+EGAVResult EGAVHIDRawDevice::GetInputReport(uint8_t* ioReport, size_t inBufferSize, size_t& outSize)
+{
+	EGAVResult_CheckPointer(ioReport);
+	if (mFD < 0)
+		return EGAVResult::ErrNotInitialized;
+	if (inBufferSize < 2 || inBufferSize > kMaxReportSize)
+		return EGAVResult::ErrInvalidParameter;
+
+	int received = 0;
+	do
+		received = ioctl(mFD, HIDIOCGINPUT(inBufferSize), ioReport);
+	while (received < 0 && errno == EINTR);
+	if (received < 0)
+	{
+		if (errno == ENOTTY || errno == EINVAL)
+		{
+			error_printf("EGAVHIDRawDevice: HIDIOCGINPUT not supported (Linux 5.11 or newer required)");
+			return EGAVResult::ErrNotSupported;
+		}
+		return (errno == ENODEV) ? EGAVResult::ErrNotFound : (errno == ETIMEDOUT) ? EGAVResult::ErrTimeOut : EGAVResult::ErrInvalidOperation;
+	}
+	outSize = (size_t)received;
+	return EGAVResult::Ok;
+}
+
+size_t EGAVHIDRawDevice::DrainInput()
+{
+	if (mFD < 0)
+		return 0;
+
+	size_t drained = 0;
+	uint8_t report[kMaxReportSize];
+	while (read(mFD, report, sizeof(report)) > 0)
+		drained++;
+	return drained;
+}
@@ -0,0 +1,128 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		EGAVHIDRawDevice.h
+
+@brief		Report-level access to a HID device on Linux (hidraw).
+
+			The Elgato MCU answers a read request with an input report that the host
+			fetches with a GET_REPORT control request, as HidD_GetInputReport() does
+			on Windows and IOHIDDeviceGetReport() on macOS; the protocols don't rely
+			on interrupt-IN reports. On hidraw GET_REPORT is the HIDIOCGINPUT ioctl.
+			It blocks for the control transfer and can't be polled, so asynchronous
+			callers run it on a worker thread (see EGAVReactor::RunBlocking()).
+			Interrupt-IN reports the device sends anyway queue up in the hidraw
+			buffer and are discarded with DrainInput().
+
+			The buffer size passed to GetInputReport() is the wLength of the control
+			request; NewProtocol encodes the report case into it (kReadResponseSize).
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "EGAVResult.h"
+#include "EGAVDevice.h"
+
+
+//==============================================================================
+// # Interface EGAVHIDRawTransport
+//==============================================================================
+
+//! @brief Reports of one device, report ID first (implemented by EGAVHIDRawDevice, simulated in the tests)
+class EGAVHIDRawTransport
+{
+public:
+	virtual ~EGAVHIDRawTransport() {}
+
+	//! @return fd that is readable when input reports are queued and reports EPOLLHUP when the device is gone,
+	//!         and accepts output reports with write() (batched writes); -1 if there is none
+	virtual int GetFD() const = 0;
+
+	//! @return output reports are padded with zeros to this size (0: no padding)
+	virtual size_t GetOutputReportSize() const = 0;
+
+	//! @return input report size including the report ID byte
+	virtual size_t GetInputReportSize(uint8_t inReportID) const = 0;
+
+	//! @brief Sends an output report (blocking)
+	virtual EGAVResult WriteReport(const uint8_t* inReport, size_t inSize) = 0;
+
+	//! @brief GET_REPORT of an input report (blocking)
+	//! @param ioReport in: report ID at [0]; out: the report, report ID first
+	//! @param inBufferSize size of ioReport, sent as the requested length
+	//! @param outSize received report size
+	virtual EGAVResult GetInputReport(uint8_t* ioReport, size_t inBufferSize, size_t& outSize) = 0;
+
+	//! @brief Discards the queued interrupt-IN reports (non-blocking)
+	//! @return number of discarded reports
+	virtual size_t DrainInput() = 0;
+};
+
+
+//==============================================================================
+// # Class EGAVHIDRawDevice
+//==============================================================================
+
+class EGAVHIDRawDevice : public EGAVHIDRawTransport
+{
+public:
+	EGAVHIDRawDevice() {}
+	~EGAVHIDRawDevice();
+	EGAVHIDRawDevice(const EGAVHIDRawDevice&) = delete;
+	EGAVHIDRawDevice& operator=(const EGAVHIDRawDevice&) = delete;
+
+	//! @param inIndex selects one of several connected devices with the same ID
+	//! @return /dev/hidrawN of the device, empty if it isn't connected
+	static std::string FindDevice(const EGAVDeviceID& inDeviceID, int inIndex = 0);
+
+	//! @brief Opens the hidraw node (non-blocking reads) and reads the report sizes from the report descriptor
+	EGAVResult Open(const std::string& inPath);
+	void Close();
+	bool IsOpen() const { return mFD >= 0; }
+
+	//-----------------------------------------------------------------------------
+	// ## EGAVHIDRawTransport implementation
+	//-----------------------------------------------------------------------------
+	int GetFD() const override { return mFD; }
+	size_t GetOutputReportSize() const override { return mOutputReportSize; }
+	//! @return largest input report for unknown IDs
+	size_t GetInputReportSize(uint8_t inReportID) const override;
+	EGAVResult WriteReport(const uint8_t* inReport, size_t inSize) override;
+	EGAVResult GetInputReport(uint8_t* ioReport, size_t inBufferSize, size_t& outSize) override;
+	size_t DrainInput() override;
+
+private:
+	int			mFD					= -1;
+	size_t		mOutputReportSize	= 0;	//!< largest output report, including the report ID byte
+	size_t		mMaxInputReportSize	= 0;
+	uint16_t	mInputReportSizes[256] = {};	//!< per report ID, 0: no such input report
+};
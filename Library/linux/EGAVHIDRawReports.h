@@ -0,0 +1,92 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVHIDRawReports.h
+
+@brief		hidraw report framing of the Elgato UVC protocols (internal).
+
+			Output reports are the report ID, then the protocol message of
+			ElgatoUVCProtocol.h. The read response is fetched with GET_REPORT
+			(EGAVHIDRawTransport::GetInputReport()) and parsed like the message
+			EGAVHIDInterface::ReadHID() returns: the whole report, report ID first.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "ElgatoUVCProtocol.h"
+#include "EGAVHIDRawDevice.h"
+
+
+//! @brief Input buffer size; NewProtocol::kReadResponseSize requests 0x7FF bytes
+const size_t kMaxInputReportSize = 2048;
+
+//! @brief Output buffer size of BuildReadReport() and BuildWriteReport(): report ID and the longest message
+const size_t kMaxRequestReportSize = 1 + std::max(LegacyProtocol::kMaxRequestSize, NewProtocol::kMaxRequestSize);
+
+
+//==============================================================================
+// # Reports (hidraw framing: report ID, then the protocol message)
+//==============================================================================
+
+//! @param outReport kMaxRequestReportSize bytes
+//! @return report size
+template <class Protocol>
+inline size_t BuildReadReport(uint8_t inI2CAddress, uint8_t inRegister, uint8_t inLength, uint8_t* outReport)
+{
+	outReport[0] = (uint8_t)Protocol::kReadRequestReportID;
+	return 1 + Protocol::BuildReadRequest(inI2CAddress, inRegister, inLength, outReport + 1);
+}
+
+//! @param outReport kMaxRequestReportSize bytes
+//! @return report size
+template <class Protocol>
+inline size_t BuildWriteReport(uint8_t inI2CAddress, uint8_t inRegister, const uint8_t* inData, uint8_t inLength, uint8_t* outReport)
+{
+	outReport[0] = (uint8_t)Protocol::kWriteReportID;
+	return 1 + Protocol::BuildWriteRequest(inI2CAddress, inRegister, inData, inLength, outReport + 1);
+}
+
+//! @return GET_REPORT buffer size (requested length) of the read response, like ReadHID() with kReadResponseSize
+template <class Protocol>
+inline size_t GetReadResponseBufferSize(const EGAVHIDRawTransport& inTransport)
+{
+	return Protocol::kReadResponseSize ? (size_t)Protocol::kReadResponseSize : inTransport.GetInputReportSize((uint8_t)Protocol::kReadResponseReportID);
+}
+
+//! @param inReport GET_REPORT result, report ID first; parsed in place
+//! @return false if the report is not a read response of the protocol
+template <class Protocol>
+inline bool ParseReadReport(const uint8_t* inReport, size_t inSize, uint8_t* outData, uint8_t inLength)
+{
+	if (inSize < 1 || inReport[0] != (uint8_t)Protocol::kReadResponseReportID)
+		return false;
+	Protocol::ParseReadResponse(inReport, inSize, outData, inLength);
+	return true;
+}
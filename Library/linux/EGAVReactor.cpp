@@ -0,0 +1,430 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVReactor.cpp
+
+@brief		Single-thread event loop for Linux (epoll, timer wheel)
+**/
+//==============================================================================
+
+#include "EGAVReactor.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+
+const int kMaxEventsPerWait = 64;
+
+static uint32_t RoundUpPowerOf2(uint32_t inValue)
+{
+	uint32_t value = 1;
+	while (value < inValue && value < 0x80000000u)
+		value <<= 1;
+	return value;
+}
+
+static uint64_t EncodeEventData(int inFD, uint32_t inGeneration) { return ((uint64_t)inGeneration << 32) | (uint32_t)inFD; }
+
+
+//==============================================================================
+// # Class EGAVReactor
+//==============================================================================
+
+EGAVReactor::EGAVReactor(uint32_t inTickUs /*= 1000*/, uint32_t inWheelSlots /*= 1024*/, size_t inBlockingThreads /*= 4*/)
+	: mTickUs(std::max(inTickUs, 1u)), mSlotMask(RoundUpPowerOf2(std::max(inWheelSlots, 2u)) - 1),
+	  mBlockingThreads(std::max<size_t>(inBlockingThreads, 1))
+{
+	mSlotHeads.assign(mSlotMask + 1, -1);
+}
+
+EGAVReactor::~EGAVReactor()
+{
+	mBlockingPool.reset();
+	if (mEpollFD >= 0)
+		close(mEpollFD);
+	if (mTimerFD >= 0)
+		close(mTimerFD);
+	if (mWakeFD >= 0)
+		close(mWakeFD);
+}
+
+uint64_t EGAVReactor::GetTimeUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+EGAVResult EGAVReactor::Init()
+{
+	if (mEpollFD >= 0)
+		return EGAVResult::ErrInvalidState;
+
+	mEpollFD = epoll_create1(EPOLL_CLOEXEC);
+	mTimerFD = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	mWakeFD  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (mEpollFD < 0 || mTimerFD < 0 || mWakeFD < 0)
+	{
+		error_printf("EGAVReactor: can't create epoll/timerfd/eventfd (%d)", errno);
+		return EGAVResult::ErrResourceNotAvail;
+	}
+
+	for (int fd : { mTimerFD, mWakeFD })
+	{
+		struct epoll_event ev = {};
+		ev.events   = EPOLLIN;
+		ev.data.u64 = EncodeEventData(fd, 0);
+		if (epoll_ctl(mEpollFD, EPOLL_CTL_ADD, fd, &ev) != 0)
+			return EGAVResult::ErrResourceNotAvail;
+	}
+
+	mNowUs       = GetTimeUs();
+	mCurrentTick = mNowUs / mTickUs;
+	mStop        = false;
+	return EGAVResult::Ok;
+}
+
+//==============================================================================
+// ## File descriptors
+//==============================================================================
+
+EGAVResult EGAVReactor::AddFD(int inFD, uint32_t inEvents, IOHandler inHandler)
+{
+	if (mEpollFD < 0)
+		return EGAVResult::ErrNotInitialized;
+	if (inFD < 0 || !inHandler)
+		return EGAVResult::ErrInvalidParameter;
+
+	if ((size_t)inFD >= mFDs.size())
+		mFDs.resize(inFD + 1);
+	FDEntry& entry = mFDs[inFD];
+	if (entry.active)
+		return EGAVResult::ErrInvalidState;
+
+	struct epoll_event ev = {};
+	ev.events   = inEvents;
+	ev.data.u64 = EncodeEventData(inFD, ++entry.generation);
+	if (epoll_ctl(mEpollFD, EPOLL_CTL_ADD, inFD, &ev) != 0)
+	{
+		error_printf("EGAVReactor: epoll_ctl(ADD, %d) failed (%d)", inFD, errno);
+		return EGAVResult::ErrInvalidParameter;
+	}
+	entry.handler = std::move(inHandler);
+	entry.active  = true;
+	return EGAVResult::Ok;
+}
+
+EGAVResult EGAVReactor::ModifyFD(int inFD, uint32_t inEvents)
+{
+	if (inFD < 0 || (size_t)inFD >= mFDs.size() || !mFDs[inFD].active)
+		return EGAVResult::ErrNotFound;
+
+	struct epoll_event ev = {};
+	ev.events   = inEvents;
+	ev.data.u64 = EncodeEventData(inFD, mFDs[inFD].generation);
+	return (epoll_ctl(mEpollFD, EPOLL_CTL_MOD, inFD, &ev) == 0) ? EGAVResult::Ok : EGAVResult::ErrInvalidParameter;
+}
+
+EGAVResult EGAVReactor::RemoveFD(int inFD)
+{
+	if (inFD < 0 || (size_t)inFD >= mFDs.size() || !mFDs[inFD].active)
+		return EGAVResult::ErrNotFound;
+
+	FDEntry& entry = mFDs[inFD];
+	epoll_ctl(mEpollFD, EPOLL_CTL_DEL, inFD, nullptr);
+	entry.active = false;
+	mRetiredHandlers.push_back(std::move(entry.handler)); // may be the running handler
+	entry.handler = nullptr;
+	return EGAVResult::Ok;
+}
+
+//==============================================================================
+// ## Timer wheel
+//==============================================================================
+
+void EGAVReactor::LinkTimer(int32_t inIndex)
+{
+	Timer& timer = mTimers[inIndex];
+	timer.slot = (int32_t)(timer.dueTick & mSlotMask);
+	timer.prev = -1;
+	timer.next = mSlotHeads[timer.slot];
+	if (timer.next >= 0)
+		mTimers[timer.next].prev = inIndex;
+	mSlotHeads[timer.slot] = inIndex;
+}
+
+void EGAVReactor::UnlinkTimer(int32_t inIndex)
+{
+	Timer& timer = mTimers[inIndex];
+	if (timer.prev >= 0)
+		mTimers[timer.prev].next = timer.next;
+	else
+		mSlotHeads[timer.slot] = timer.next;
+	if (timer.next >= 0)
+		mTimers[timer.next].prev = timer.prev;
+	timer.prev = timer.next = -1;
+}
+
+void EGAVReactor::FreeTimer(int32_t inIndex)
+{
+	Timer& timer = mTimers[inIndex];
+	timer.slot = -1;
+	timer.generation++;
+	mFreeTimers.push_back(inIndex);
+	mActiveTimers--;
+}
+
+EGAVReactor::TimerID EGAVReactor::AddTimer(uint64_t inDelayUs, TimerHandler inHandler)
+{
+	return AddTimerAt(GetTimeUs() + inDelayUs, std::move(inHandler));
+}
+
+EGAVReactor::TimerID EGAVReactor::AddTimerAt(uint64_t inDueUs, TimerHandler inHandler)
+{
+	if (!inHandler)
+		return kInvalidTimer;
+
+	int32_t index;
+	if (!mFreeTimers.empty())
+	{
+		index = mFreeTimers.back();
+		mFreeTimers.pop_back();
+	}
+	else
+	{
+		index = (int32_t)mTimers.size();
+		mTimers.emplace_back();
+	}
+
+	Timer& timer = mTimers[index];
+	timer.handler = std::move(inHandler);
+	timer.dueUs   = inDueUs;
+	timer.dueTick = std::max((inDueUs + mTickUs - 1) / mTickUs, mCurrentTick); // never before its due time
+	LinkTimer(index);
+	mActiveTimers++;
+	return ((uint64_t)timer.generation << 32) | (uint32_t)(index + 1);
+}
+
+bool EGAVReactor::CancelTimer(TimerID inTimer)
+{
+	const int64_t index = (int64_t)(inTimer & 0xFFFFFFFF) - 1;
+	if (index < 0 || index >= (int64_t)mTimers.size())
+		return false;
+
+	Timer& timer = mTimers[index];
+	if (timer.slot < 0 || timer.generation != (uint32_t)(inTimer >> 32))
+		return false;
+
+	UnlinkTimer((int32_t)index);
+	timer.handler = nullptr;
+	FreeTimer((int32_t)index);
+	return true;
+}
+
+void EGAVReactor::ExpireTimers()
+{
+	const uint64_t nowTick = mNowUs / mTickUs;
+	if (nowTick < mCurrentTick || !mActiveTimers)
+	{
+		mCurrentTick = std::max(mCurrentTick, nowTick + (mActiveTimers ? 0 : 1));
+		return;
+	}
+
+	// Visit the slots of the elapsed ticks (each slot once at most), collect the due timers
+	thread_local std::vector<int32_t> due;
+	due.clear();
+	const uint64_t ticks = std::min<uint64_t>(nowTick - mCurrentTick + 1, (uint64_t)mSlotMask + 1);
+	for (uint64_t t = 0; t < ticks; t++)
+	{
+		int32_t index = mSlotHeads[(mCurrentTick + t) & mSlotMask];
+		while (index >= 0)
+		{
+			const int32_t next = mTimers[index].next;
+			if (mTimers[index].dueTick <= nowTick)
+			{
+				UnlinkTimer(index);
+				due.push_back(index);
+			}
+			index = next;
+		}
+	}
+	mCurrentTick = nowTick + 1;
+
+	std::sort(due.begin(), due.end(), [this](int32_t a, int32_t b) { return mTimers[a].dueUs < mTimers[b].dueUs; });
+	for (int32_t index : due)
+	{
+		TimerHandler handler = std::move(mTimers[index].handler);
+		const uint64_t lateUs = (mNowUs > mTimers[index].dueUs) ? mNowUs - mTimers[index].dueUs : 0;
+		FreeTimer(index);
+
+		mStatistics.timersFired++;
+		mStatistics.timerLateUsTotal += lateUs;
+		mStatistics.timerLateUsMax = std::max(mStatistics.timerLateUsMax, lateUs);
+		handler();
+	}
+}
+
+void EGAVReactor::ArmTimerFD()
+{
+	uint64_t nextTick = 0;
+	if (mActiveTimers)
+	{
+		// Nearest non-empty slot within one rotation, else the earliest timer of a later rotation
+		for (uint64_t t = mCurrentTick; t <= mCurrentTick + mSlotMask && !nextTick; t++)
+		{
+			for (int32_t index = mSlotHeads[t & mSlotMask]; index >= 0; index = mTimers[index].next)
+			{
+				if (mTimers[index].dueTick <= t)
+				{
+					nextTick = t;
+					break;
+				}
+			}
+		}
+		if (!nextTick)
+		{
+			nextTick = UINT64_MAX;
+			for (const Timer& timer : mTimers)
+				if (timer.slot >= 0)
+					nextTick = std::min(nextTick, timer.dueTick);
+		}
+	}
+	if (nextTick == mArmedTick)
+		return;
+
+	struct itimerspec spec = {};
+	if (nextTick)
+	{
+		const uint64_t dueUs = std::max<uint64_t>(nextTick * mTickUs, 1);
+		spec.it_value.tv_sec  = (time_t)(dueUs / 1000000);
+		spec.it_value.tv_nsec = (long)(dueUs % 1000000) * 1000;
+	}
+	timerfd_settime(mTimerFD, TFD_TIMER_ABSTIME, &spec, nullptr);
+	mArmedTick = nextTick;
+}
+
+//==============================================================================
+// ## Loop
+//==============================================================================
+
+void EGAVReactor::Post(std::function<void()> inHandler)
+{
+	{
+		const std::lock_guard<std::mutex> lock(mPostMutex);
+		mPosted.push_back(std::move(inHandler));
+	}
+	const uint64_t one = 1;
+	(void)!write(mWakeFD, &one, sizeof(one));
+}
+
+void EGAVReactor::RunBlocking(std::function<void()> inWork, std::function<void()> inDone)
+{
+	if (!mBlockingPool)
+		mBlockingPool = std::make_unique<EGAVWorkerPool>(mBlockingThreads);
+
+	// The completion is posted from the worker: one wake-up of the loop per call
+	mBlockingPool->Submit([this, work = std::move(inWork), done = std::move(inDone)]() mutable
+	{
+		work();
+		Post(std::move(done));
+	});
+}
+
+void EGAVReactor::RunPosted()
+{
+	{
+		const std::lock_guard<std::mutex> lock(mPostMutex);
+		if (mPosted.empty())
+			return;
+		mPostedRun.swap(mPosted);
+	}
+	for (auto& handler : mPostedRun)
+		handler();
+	mPostedRun.clear();
+}
+
+EGAVResult EGAVReactor::RunOnce(int inTimeoutMs /*= -1*/)
+{
+	if (mEpollFD < 0)
+		return EGAVResult::ErrNotInitialized;
+
+	ArmTimerFD();
+
+	struct epoll_event events[kMaxEventsPerWait];
+	const int count = epoll_wait(mEpollFD, events, kMaxEventsPerWait, inTimeoutMs);
+	if (count < 0 && errno != EINTR)
+		return EGAVResult::ErrUnknown;
+
+	mNowUs = GetTimeUs();
+	mStatistics.wakeups++;
+	for (int i = 0; i < count; i++)
+	{
+		const int fd = (int)(events[i].data.u64 & 0xFFFFFFFF);
+		const uint32_t generation = (uint32_t)(events[i].data.u64 >> 32);
+		if (fd == mTimerFD || fd == mWakeFD)
+		{
+			uint64_t value;
+			(void)!read(fd, &value, sizeof(value));
+			if (fd == mTimerFD)
+				mArmedTick = 0; // expired
+			continue;
+		}
+
+		// The fd may have been removed (or removed and re-added) by an earlier handler of this round
+		if ((size_t)fd >= mFDs.size() || !mFDs[fd].active || mFDs[fd].generation != generation)
+			continue;
+		mStatistics.ioEvents++;
+		mFDs[fd].handler(events[i].events);
+	}
+
+	ExpireTimers();
+	RunPosted();
+	mRetiredHandlers.clear();
+	return EGAVResult::Ok;
+}
+
+EGAVResult EGAVReactor::Run()
+{
+	while (!mStop)
+	{
+		EGAVResult res = RunOnce(-1);
+		if (res.Failed())
+			return res;
+	}
+	return EGAVResult::Ok;
+}
+
+void EGAVReactor::Stop()
+{
+	mStop = true;
+	const uint64_t one = 1;
+	(void)!write(mWakeFD, &one, sizeof(one));
+}
@@ -0,0 +1,175 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVReactor.h
+
+@brief		Single-thread event loop for Linux: epoll for file descriptors and a
+			hashed timer wheel for polls and deadlines.
+
+			The timer wheel has a fixed tick (default 1 ms); adding and cancelling a
+			timer is O(1). A timerfd armed to the next expiry wakes the loop, so an idle
+			wheel costs nothing and the wake-up precision is not limited to the
+			millisecond timeout of epoll_wait(). All handlers run on the loop thread;
+			only Post() and Stop() may be called from other threads.
+
+			Calls that block and can't be polled (e.g. the HID GET_REPORT ioctl) run
+			on a few worker threads with RunBlocking(); their completion handler is
+			posted back to the loop thread.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "EGAVResult.h"
+#include "EGAVWorkerPool.h"
+
+
+struct EGAVReactorStatistics
+{
+	uint64_t	wakeups			= 0;	//!< returns from epoll_wait()
+	uint64_t	ioEvents		= 0;
+	uint64_t	timersFired		= 0;
+	uint64_t	timerLateUsMax	= 0;	//!< latest timer dispatch after its due time
+	uint64_t	timerLateUsTotal = 0;
+};
+
+
+//==============================================================================
+// # Class EGAVReactor
+//==============================================================================
+
+class EGAVReactor
+{
+public:
+	typedef std::function<void(uint32_t inEvents)> IOHandler;	//!< inEvents: EPOLLIN, EPOLLOUT, EPOLLERR, EPOLLHUP
+	typedef std::function<void()> TimerHandler;
+	typedef uint64_t TimerID;
+	static const TimerID kInvalidTimer = 0;
+
+	//! @param inTickUs timer resolution
+	//! @param inWheelSlots rounded up to a power of 2; timers further away than inTickUs * inWheelSlots take several rotations
+	//! @param inBlockingThreads workers of RunBlocking(), i.e. blocking calls in flight at the same time (created on first use)
+	explicit EGAVReactor(uint32_t inTickUs = 1000, uint32_t inWheelSlots = 1024, size_t inBlockingThreads = 4);
+	~EGAVReactor();
+	EGAVReactor(const EGAVReactor&) = delete;
+	EGAVReactor& operator=(const EGAVReactor&) = delete;
+
+	EGAVResult Init();
+
+	//! @brief inFD must stay open until RemoveFD()
+	EGAVResult AddFD(int inFD, uint32_t inEvents, IOHandler inHandler);
+	EGAVResult ModifyFD(int inFD, uint32_t inEvents);
+	EGAVResult RemoveFD(int inFD);
+
+	//! @brief One-shot timer; a handler may add new timers (periodic polls re-arm themselves)
+	TimerID AddTimer(uint64_t inDelayUs, TimerHandler inHandler);
+	//! @brief Same as AddTimer() with an absolute due time (GetTimeUs() clock)
+	TimerID AddTimerAt(uint64_t inDueUs, TimerHandler inHandler);
+	//! @return false if the timer already fired or was cancelled
+	bool CancelTimer(TimerID inTimer);
+
+	//! @brief Thread safe: runs inHandler on the loop thread
+	void Post(std::function<void()> inHandler);
+
+	//! @brief Runs inWork on a worker thread, then inDone on the loop thread (FIFO).
+	//!        Must be called on the loop thread. Pending calls finish before the reactor is destroyed.
+	void RunBlocking(std::function<void()> inWork, std::function<void()> inDone);
+
+	//! @brief Waits for events for up to inTimeoutMs (-1: infinite) and dispatches them
+	EGAVResult RunOnce(int inTimeoutMs = -1);
+	//! @brief Runs until Stop(). Returns right away if Stop() was called before (e.g. by a thread that
+	//!        got the reactor before the loop thread started running it); a stopped reactor stays stopped.
+	EGAVResult Run();
+	//! @brief Thread safe
+	void Stop();
+
+	//! @brief Loop time of the current dispatch round (µs, CLOCK_MONOTONIC)
+	uint64_t GetLoopTimeUs() const { return mNowUs; }
+	static uint64_t GetTimeUs();
+
+	size_t GetTimerCount() const { return mActiveTimers; }
+	const EGAVReactorStatistics& GetStatistics() const { return mStatistics; }
+
+private:
+	struct FDEntry
+	{
+		IOHandler	handler;
+		uint32_t	generation	= 0;	//!< detects events of a removed and re-added fd in the same round
+		bool		active		= false;
+	};
+
+	//! @brief Pool entry; the wheel slots are intrusive doubly-linked lists of pool indices
+	struct Timer
+	{
+		TimerHandler	handler;
+		uint64_t		dueUs		= 0;
+		uint64_t		dueTick		= 0;
+		uint32_t		generation	= 0;
+		int32_t			prev		= -1;
+		int32_t			next		= -1;
+		int32_t			slot		= -1;	//!< -1: free
+	};
+
+	void LinkTimer(int32_t inIndex);
+	void UnlinkTimer(int32_t inIndex);
+	void FreeTimer(int32_t inIndex);
+	void ExpireTimers();
+	void ArmTimerFD();
+	void RunPosted();
+
+	const uint64_t				mTickUs;
+	const uint32_t				mSlotMask;
+	int							mEpollFD	= -1;
+	int							mTimerFD	= -1;
+	int							mWakeFD		= -1;
+	std::atomic<bool>			mStop		{ false };
+
+	std::vector<FDEntry>		mFDs;		//!< index: fd
+	std::vector<IOHandler>		mRetiredHandlers;	//!< removed during dispatch, destroyed after it
+	std::vector<Timer>			mTimers;
+	std::vector<int32_t>		mSlotHeads;
+	std::vector<int32_t>		mFreeTimers;
+	size_t						mActiveTimers	= 0;
+	uint64_t					mCurrentTick	= 0;	//!< all ticks before this one are expired
+	uint64_t					mArmedTick		= 0;	//!< timerfd due tick (0: disarmed)
+	uint64_t					mNowUs			= 0;
+
+	std::mutex					mPostMutex;
+	std::vector<std::function<void()>> mPosted;		//!< protected by mPostMutex
+	std::vector<std::function<void()>> mPostedRun;
+
+	const size_t				mBlockingThreads;
+	std::unique_ptr<EGAVWorkerPool> mBlockingPool;	//!< destroyed first: its tasks post to the loop
+
+	EGAVReactorStatistics		mStatistics;
+};
@@ -0,0 +1,159 @@
+﻿/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		StatusDaemon.cpp
+
+@brief		Sole owner of an Elgato UVC device: polls the signal status and
+			publishes it in shared memory (see EGAVStatusSegment.h), and executes
+			device operations for other processes (see EGAVDeviceProxy.h).
+
+			Usage: EGAVStatusDaemon [segment name] [socket path] [poll interval ms] [proxy socket path] [firmware version]
+
+			The firmware version (e.g. 22.03.24) selects the device quirks (see
+			ElgatoUVCQuirks.h); without it all firmware specific quirks apply.
+**/
+//==============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "ElgatoUVCDevice.h"
+#include "EGAVStatusSegment.h"
+#include "EGAVDeviceProxy.h"
+
+
+//==============================================================================
+// # Constants
+//==============================================================================
+
+const char* kDefaultSegmentName	= "/egav-status-0";
+const char* kDefaultSocketPath	= "/tmp/egav-status-0.sock";
+const int kDefaultPollIntervalMs	= 100;
+const char* kDefaultProxySocketPath	= "/tmp/egav-proxy-0.sock";
+const int kReopenAfterFailedPolls	= 3;	//!< consecutive I2C errors before the HID interface is reopened
+
+static std::atomic<bool> gQuit(false);
+
+static void OnSignal(int) { gQuit = true; }
+
+static uint64_t GetTimestampUs()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//==============================================================================
+// # main()
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	const std::string segmentName	= (argc > 1) ? argv[1] : kDefaultSegmentName;
+	const std::string socketPath	= (argc > 2) ? argv[2] : kDefaultSocketPath;
+	const int pollIntervalMs		= (argc > 3) ? std::max(atoi(argv[3]), 1) : kDefaultPollIntervalMs;
+	const std::string proxySocketPath	= (argc > 4) ? argv[4] : kDefaultProxySocketPath;
+	EGAVFirmwareVersion firmware;
+	if (argc > 5 && !EGAVFirmwareVersion::FromString(argv[5], firmware))
+	{
+		std::cout << "Invalid firmware version " << argv[5] << " (expected e.g. 22.03.24)." << std::endl;
+		return 1;
+	}
+
+	std::signal(SIGINT, OnSignal);
+	std::signal(SIGTERM, OnSignal);
+	std::signal(SIGPIPE, SIG_IGN); // notification pipes of readers that exited
+
+	// Take the first supported device
+	std::shared_ptr<EGAVHIDInterface> hid = std::make_shared<EGAVHID>();
+	EGAVDeviceID deviceID;
+	bool found = false;
+	for (const EGAVDeviceID& id : GetElgatoUVCDeviceIDs())
+	{
+		if (hid->InitHIDInterface(id).Succeeded())
+		{
+			deviceID = id;
+			found = true;
+			break;
+		}
+	}
+	if (!found)
+	{
+		std::cout << "No supported device found." << std::endl;
+		return 1;
+	}
+
+	EGAVStatusPublisher publisher;
+	EGAVResult res = publisher.Create(segmentName);
+	if (res == EGAVResult::ErrDeviceInUse)
+		std::cout << "Another daemon publishes " << segmentName << "." << std::endl;
+	if (res.Failed())
+	{
+		hid->DeinitHIDInterface();
+		return 1;
+	}
+	if (publisher.EnableChangeNotification(socketPath).Failed())
+		std::cout << "Change notification disabled (can't listen on " << socketPath << ")." << std::endl;
+
+	std::cout << "Publishing " << segmentName << " every " << pollIntervalMs << " ms (Ctrl+C to stop)" << std::endl;
+
+	ElgatoUVCDevice device(hid, deviceID, firmware);
+	EGAVDeviceProxyServer proxy(device);
+	if (proxy.Start(proxySocketPath).Failed())
+		std::cout << "Device proxy disabled (can't listen on " << proxySocketPath << ")." << std::endl;
+
+	int failedPolls = 0;
+	while (!gQuit)
+	{
+		EGAVStatusSnapshot snapshot{};
+		if (EGAVStatus_PollDevice(device, snapshot).Failed() && ++failedPolls >= kReopenAfterFailedPolls)
+		{
+			// Device reset or reconnected: reopen, replay the register state and drop the cached EDID
+			failedPolls = 0;
+			res = device.ReopenHIDInterface();
+			std::cout << "Reopened the device: " << res.GetResultCodeString() << std::endl;
+		}
+		else if (snapshot.deviceResult == EGAVResult::Ok)
+			failedPolls = 0;
+		if (publisher.Publish(snapshot, GetTimestampUs()) == EGAVResult::Ok)
+		{
+			std::cout << "Status: " << (snapshot.isHDR ? "HDR" : "SDR") << ", EOTF " << (int)snapshot.eotf
+				<< ", info frames 0x" << std::hex << snapshot.frameMask << std::dec
+				<< ", result " << EGAVResult::GetResultCodeString(snapshot.deviceResult) << std::endl;
+		}
+		publisher.ServiceSubscribers();
+		std::this_thread::sleep_for(std::chrono::milliseconds(pollIntervalMs));
+	}
+
+	proxy.Stop();
+	publisher.Close();
+	hid->DeinitHIDInterface();
+	return 0;
+}
@@ -56,7 +56,7 @@ int main()
 	}
 	else
 	{
-		ElgatoUVCDevice device(hid, IsNewDeviceType(selectedDeviceID));
+		ElgatoUVCDevice device(hid, selectedDeviceID);
 		HDMI_GENERIC_INFOFRAME frame{};
 		memset(&frame, 0, sizeof(frame));
 		res = device.GetHDMIHDRStatusPacket(frame);
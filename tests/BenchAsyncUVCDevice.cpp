@@ -0,0 +1,229 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		BenchAsyncUVCDevice.cpp
+
+@brief		EGAVAsyncUVCDevice on one EGAVReactor against simulated devices on
+			socketpairs, with the periodic HDR status polls running
+
+			- reads: every device keeps one register read in flight next to its
+			  polls; the completion callback issues the next one. Prints the
+			  reactor throughput and the time per read.
+			- polls: HDR status polls only. Prints the CPU time per device (process
+			  CPU time from getrusage() without the simulated device threads) and
+			  the deviation of the poll intervals from the configured interval
+			  (p50/p99, HDR status callback to callback).
+			See EGAVSimulatedHIDRaw.h: the socketpair replaces the USB control
+			transfers of hidraw, so these numbers are the reactor and worker
+			overhead, not the latency on hardware.
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVSimulatedHIDRaw.h"
+#include "EGAVAsyncUVCDevice.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <sys/resource.h>
+
+
+//! @brief Simulated devices and their EGAVAsyncUVCDevice, polls spread over the interval
+struct DeviceSet
+{
+	std::vector<std::unique_ptr<EGAVSimulatedHIDRawDevice>> simulated;
+	std::vector<std::unique_ptr<EGAVAsyncUVCDevice>> devices;
+
+	bool Start(EGAVReactor& ioReactor, int inDevices, uint32_t inPollIntervalUs, std::function<void(int)> inOnPoll)
+	{
+		for (int i = 0; i < inDevices; i++)
+		{
+			EGAVAsyncUVCDeviceConfig config;
+			config.pollIntervalUs = inPollIntervalUs;
+			config.pollPhaseUs    = (uint32_t)((uint64_t)inPollIntervalUs * i / inDevices);
+			simulated.push_back(std::make_unique<EGAVSimulatedHIDRawDevice>((uint8_t)i));
+			devices.push_back(std::make_unique<EGAVAsyncUVCDevice>(ioReactor, simulated.back()->TakeTransport(), deviceIDHD60X, EGAVFirmwareVersion(), config));
+			if (devices.back()->Start([inOnPoll, i](EGAVResult, const HDMI_GENERIC_INFOFRAME&) { if (inOnPoll) inOnPoll(i); }).Failed())
+				return false;
+		}
+		return true;
+	}
+
+	void Stop()
+	{
+		for (const auto& device : devices)
+			device->Stop();
+	}
+
+	EGAVAsyncUVCDeviceStatistics GetStatistics() const
+	{
+		EGAVAsyncUVCDeviceStatistics total;
+		for (const auto& device : devices)
+		{
+			const EGAVAsyncUVCDeviceStatistics& statistics = device->GetStatistics();
+			total.polls				+= statistics.polls;
+			total.pollsSkipped		+= statistics.pollsSkipped;
+			total.timeouts			+= statistics.timeouts;
+			total.errors			+= statistics.errors;
+			total.pollLatencyUsMax	 = std::max(total.pollLatencyUsMax, statistics.pollLatencyUsMax);
+			total.pollLatencyUsTotal += statistics.pollLatencyUsTotal;
+		}
+		return total;
+	}
+
+	uint64_t GetSimulatedCPUTimeNs() const
+	{
+		uint64_t total = 0;
+		for (const auto& device : simulated)
+			total += device->GetThreadCPUTimeNs();
+		return total;
+	}
+};
+
+static uint64_t GetProcessCPUTimeNs()
+{
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	return ((uint64_t)usage.ru_utime.tv_sec + (uint64_t)usage.ru_stime.tv_sec) * 1000000000ull +
+		   ((uint64_t)usage.ru_utime.tv_usec + (uint64_t)usage.ru_stime.tv_usec) * 1000ull;
+}
+
+
+//==============================================================================
+// # Register reads next to the polls
+//==============================================================================
+
+static bool RunReads(int inDevices, int inReadsPerDevice, uint32_t inPollIntervalUs)
+{
+	EGAVReactor reactor;
+	if (reactor.Init().Failed())
+		return false;
+	DeviceSet set;
+	if (!set.Start(reactor, inDevices, inPollIntervalUs, nullptr))
+		return false;
+	std::vector<std::unique_ptr<EGAVAsyncUVCDevice>>& devices = set.devices;
+
+	int completed = 0, bad = 0;
+	std::vector<int> remaining(inDevices, inReadsPerDevice);
+	std::function<void(int)> readNext = [&](int inDevice)
+	{
+		devices[inDevice]->ReadI2cData(0x55, 0x40, 2, [&, inDevice](EGAVResult inResult, const uint8_t* inData, uint8_t)
+		{
+			completed++;
+			if (inResult.Failed() || !inData || inData[0] != (uint8_t)(0x40 ^ inDevice) || inData[1] != (uint8_t)(0x41 ^ inDevice))
+				bad++;
+			if (--remaining[inDevice] > 0)
+				readNext(inDevice);
+		});
+	};
+
+	const int total = inDevices * inReadsPerDevice;
+	const uint64_t start = EGAVBenchmark_GetTimeNs();
+	for (int i = 0; i < inDevices; i++)
+		readNext(i);
+	while (completed < total && EGAVBenchmark_GetTimeNs() - start < 60000000000ull)
+		reactor.RunOnce(10);
+	const double seconds = (double)(EGAVBenchmark_GetTimeNs() - start) / 1e9;
+
+	const EGAVAsyncUVCDeviceStatistics statistics = set.GetStatistics();
+	printf("reads %4d devices: %10.0f reads/s %8.1f us/read per device %8llu polls %6llu timeouts  %s\n", inDevices, (double)completed / seconds,
+		seconds * 1e6 / (double)inReadsPerDevice, (unsigned long long)statistics.polls, (unsigned long long)statistics.timeouts,
+		(bad || completed < total) ? "ERRORS" : "");
+
+	set.Stop();
+	return bad == 0 && completed == total;
+}
+
+
+//==============================================================================
+// # Polls only: CPU time and interval deviation
+//==============================================================================
+
+static bool RunPolls(int inDevices, uint64_t inDurationUs, uint32_t inPollIntervalUs)
+{
+	EGAVReactor reactor;
+	if (reactor.Init().Failed())
+		return false;
+
+	std::vector<uint64_t> lastPollNs(inDevices, 0);
+	std::vector<uint64_t> deviations;
+	deviations.reserve((size_t)(inDevices * (inDurationUs / inPollIntervalUs + 1)));
+	DeviceSet set;
+	const bool started = set.Start(reactor, inDevices, inPollIntervalUs, [&](int inDevice)
+	{
+		const uint64_t now = EGAVBenchmark_GetTimeNs();
+		if (lastPollNs[inDevice])
+		{
+			const int64_t interval = (int64_t)(now - lastPollNs[inDevice]);
+			deviations.push_back((uint64_t)std::abs(interval - (int64_t)inPollIntervalUs * 1000));
+		}
+		lastPollNs[inDevice] = now;
+	});
+	if (!started)
+		return false;
+
+	const uint64_t cpuStart = GetProcessCPUTimeNs(), simulatedStart = set.GetSimulatedCPUTimeNs();
+	const uint64_t start = EGAVBenchmark_GetTimeNs();
+	while (EGAVBenchmark_GetTimeNs() - start < inDurationUs * 1000)
+		reactor.RunOnce(10);
+	const double seconds = (double)(EGAVBenchmark_GetTimeNs() - start) / 1e9;
+	const uint64_t processNs = GetProcessCPUTimeNs() - cpuStart, simulatedNs = set.GetSimulatedCPUTimeNs() - simulatedStart;
+	const uint64_t cpuNs = processNs - std::min(processNs, simulatedNs);
+	set.Stop();
+
+	const EGAVAsyncUVCDeviceStatistics statistics = set.GetStatistics();
+	std::sort(deviations.begin(), deviations.end());
+	auto percentileUs = [&deviations](size_t inPercent)
+	{
+		return deviations.empty() ? 0.0 : (double)deviations[std::min(deviations.size() - 1, deviations.size() * inPercent / 100)] / 1000.0;
+	};
+	printf("polls %4d devices: %8.3f %% CPU/device %8.1f us CPU/poll   interval deviation p50 %7.1f us p99 %7.1f us   latency avg %6.1f us max %6llu us %5llu skipped  %s\n",
+		inDevices, 100.0 * (double)cpuNs / 1e9 / seconds / inDevices, statistics.polls ? (double)cpuNs / 1000.0 / (double)statistics.polls : 0.0,
+		percentileUs(50), percentileUs(99), statistics.polls ? (double)statistics.pollLatencyUsTotal / (double)statistics.polls : 0.0,
+		(unsigned long long)statistics.pollLatencyUsMax, (unsigned long long)statistics.pollsSkipped, (statistics.errors || deviations.empty()) ? "ERRORS" : "");
+	return statistics.errors == 0 && !deviations.empty();
+}
+
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+	const int reads = quick ? 20 : 2000;
+	const uint64_t pollDurationUs = quick ? 100000 : 5000000;
+	const uint32_t pollIntervalUs = quick ? 10000 : 20000;
+	const std::vector<int> deviceCounts = quick ? std::vector<int>{ 4 } : std::vector<int>{ 1, 4, 16, 64 };
+
+	bool ok = true;
+	for (int devices : deviceCounts)
+		ok = RunReads(devices, reads, pollIntervalUs) && ok;
+	for (int devices : deviceCounts)
+		ok = RunPolls(devices, pollDurationUs, pollIntervalUs) && ok;
+	return ok ? 0 : 1;
+}
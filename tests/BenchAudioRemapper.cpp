@@ -0,0 +1,105 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		BenchAudioRemapper.cpp
+
+@brief		HDMIAudioRemapper kernels: SSSE3 byte shuffle (16 and 24 bit) and
+			AVX2 dword permutation (32 bit) against the scalar path, for the
+			common CEA-861 channel allocations, per 10 ms period at 48 kHz and
+			per second of audio
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVCPUFeatures.h"
+#include "HDMIAudioRemapper.h"
+
+#include <string>
+#include <vector>
+
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+
+	struct Layout
+	{
+		const char*		name;
+		uint8_t			channelAllocation;
+	};
+	const Layout layouts[] =
+	{
+		{ "2.0",	0x00 },		// identity: memcpy
+		{ "3.0",	0x02 },		// FL FR - FC: the empty slot is dropped, 3 output channels
+		{ "5.1",	0x0B },		// FL FR LFE FC RL RR
+		{ "7.1",	0x13 },		// FL FR LFE FC RL RR RLC RRC
+	};
+
+	bool ok = true;
+	for (const Layout& layout : layouts)
+	{
+		HDMI_AUDIO_INFO info;
+		info.bChannelAllocation = layout.channelAllocation;
+		ok = ok && HDMI_A_GetSpeakerLayout(layout.channelAllocation, info.slotSpeakers, info.slotCount, info.speakerMask);
+
+		for (int bytesPerSample : { 2, 3, 4 })
+		{
+			HDMIAudioRemapper remapper;
+			ok = ok && remapper.Setup(info, bytesPerSample).Succeeded();
+
+			for (size_t frames : { (size_t)480, (size_t)48000 })
+			{
+				std::vector<uint8_t> in(frames * remapper.GetInputChannels() * bytesPerSample), out(frames * remapper.GetOutputChannels() * bytesPerSample);
+				for (size_t i = 0; i < in.size(); i++)
+					in[i] = (uint8_t)(i * 13);
+
+				const char* kernel = remapper.IsIdentity() ? "memcpy"
+								   : (bytesPerSample == 4 && EGAV_CPUHasAVX2()) ? "AVX2"
+								   : EGAV_CPUHasSSSE3() ? "SSSE3" : "scalar";
+				const uint64_t iterations = quick ? 2 : (uint64_t)(200000000 / in.size());
+				std::vector<uint8_t> reference;
+				for (bool simd : { true, false })
+				{
+					remapper.SetSIMDEnabled(simd);
+					const std::string name = std::string(layout.name) + ", " + std::to_string(bytesPerSample * 8) + " bit, " + std::to_string(frames) +
+											 " frames, " + (simd ? kernel : "scalar");
+					const double ns = EGAVBenchmark_Run(name.c_str(), iterations, [&](uint64_t)
+					{
+						ok = ok && remapper.Process(in.data(), out.data(), frames).Succeeded();
+						EGAVBenchmark_DoNotOptimize(out);
+					});
+					printf("%-48s %12.1f Mframes/s\n", "", (double)frames / ns * 1000.0);
+
+					if (simd)
+						reference = out;
+					else
+						ok = ok && out == reference;
+				}
+			}
+		}
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		BenchColorConverter.cpp
+
+@brief		EGAVColorConverter: every kernel (matrix, range, NV12 / P010) with
+			AVX2 and scalar on a 1080p frame
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVColorConverter.h"
+
+#include <string>
+#include <vector>
+
+
+static const char* GetMatrixName(EGAVColorMatrix inMatrix)
+{
+	switch (inMatrix)
+	{
+		case EGAVColorMatrix::BT601:	return "BT.601";
+		case EGAVColorMatrix::BT709:	return "BT.709";
+		case EGAVColorMatrix::BT2020:	return "BT.2020";
+	}
+	return "";
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+	const uint64_t frames = quick ? 2 : 300;
+	const int width = 1920, height = 1080;
+
+	// Mid grey with some variation, P010 sized (NV12 uses the first half of each row)
+	std::vector<uint8_t> y((size_t)width * 2 * height), uv((size_t)width * 2 * height / 2), bgra((size_t)width * 4 * height);
+	for (size_t i = 0; i < y.size(); i++)
+		y[i] = (uint8_t)(i * 7);
+	for (size_t i = 0; i < uv.size(); i++)
+		uv[i] = (uint8_t)(0x70 + (i & 0x1F));
+
+	bool ok = true;
+	for (bool isP010 : { false, true })
+	{
+		const int inStride = isP010 ? width * 2 : width;
+		for (EGAVColorMatrix matrix : { EGAVColorMatrix::BT601, EGAVColorMatrix::BT709, EGAVColorMatrix::BT2020 })
+		{
+			for (bool fullRange : { false, true })
+			{
+				std::vector<uint8_t> reference;
+				for (bool simd : { true, false })
+				{
+					EGAVColorConverter converter;
+					converter.SetColorFormat(EGAVColorFormat{ matrix, fullRange });
+					converter.SetSIMDEnabled(simd);
+
+					const std::string name = std::string(isP010 ? "P010 " : "NV12 ") + GetMatrixName(matrix) + (fullRange ? " full" : " limited") +
+											 (simd ? ", SIMD" : ", scalar");
+					const double ns = EGAVBenchmark_Run(name.c_str(), frames, [&](uint64_t)
+					{
+						const EGAVResult result = isP010
+							? converter.ConvertP010(y.data(), inStride, uv.data(), inStride, bgra.data(), width * 4, width, height)
+							: converter.ConvertNV12(y.data(), inStride, uv.data(), inStride, bgra.data(), width * 4, width, height);
+						ok = ok && result.Succeeded();
+						EGAVBenchmark_DoNotOptimize(bgra);
+					});
+					printf("%-48s %12.1f Mpixel/s\n", "", (double)width * height / ns * 1000.0);
+
+					if (simd)
+						reference = bgra;
+					else
+						ok = ok && bgra == reference;
+				}
+			}
+		}
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		BenchContentClassifier.cpp
+
+@brief		HDRContentClassifier on a 4K P010 PQ frame (EGAVTestFrames.h): luma
+			histogram with the AVX2 and the scalar kernel, default subsampling and
+			every pixel, plus the per-frame classification
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVTestFrames.h"
+#include "HDRContentClassifier.h"
+
+#include <string>
+
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+	const uint64_t frames = quick ? 2 : 200;
+	const EGAVTestFrame frame = EGAVTest_MakeSceneFrame(EGAVTestTransfer::PQ, 203, true, 3840, 2160);
+
+	bool ok = true;
+	for (int step : { 4, 1 })
+	{
+		HDRLumaHistogram reference;
+		for (bool simd : { true, false })
+		{
+			HDRContentClassifier classifier(step, step);
+			classifier.SetSIMDEnabled(simd);
+			HDRLumaHistogram histogram;
+			const std::string name = std::string("4K histogram, step ") + std::to_string(step) + (simd ? ", SIMD" : ", scalar");
+			const double ns = EGAVBenchmark_Run(name.c_str(), frames, [&](uint64_t)
+			{
+				classifier.ComputeHistogram(frame.GetY(), frame.GetStride(), frame.width, frame.height, histogram);
+				EGAVBenchmark_DoNotOptimize(histogram);
+			});
+			printf("%-48s %12.1f frames/s\n", "", 1e9 / ns);
+			if (simd)
+				reference = histogram;
+			else
+				ok = ok && 0 == memcmp(&reference, &histogram, sizeof(histogram));
+		}
+	}
+
+	HDRContentClassifier classifier;
+	HDRLumaHistogram histogram;
+	classifier.ComputeHistogram(frame.GetY(), frame.GetStride(), frame.width, frame.height, histogram);
+	HDRContentEstimate estimate;
+	EGAVBenchmark_Run("Classify (histogram given)", quick ? 1000 : 10000000, [&](uint64_t)
+	{
+		estimate = HDRContentClassifier::Classify(histogram);
+		EGAVBenchmark_DoNotOptimize(estimate);
+	});
+	ok = ok && estimate.kind == HDRContentKind::PQ;
+
+	EGAVBenchmark_Run("4K AddFrame (default step)", frames, [&](uint64_t)
+	{
+		estimate = classifier.AddFrame(frame.GetY(), frame.GetStride(), frame.width, frame.height);
+	});
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		BenchCropDetector.cpp
+
+@brief		Black border scan on 4K luma planes (NV12 and P010): a 2.39:1
+			letterbox, a 4:3 pillarbox and a full frame, plus the detector with
+			bar data. The row scans stop at the first active row (letterbox: after
+			the bars), the column maxima always read every second active row.
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVSimulatedHID.h"
+#include "EGAVTestFrames.h"
+#include "HDMICropDetector.h"
+
+#include <string>
+#include <vector>
+
+
+//! @brief 8 bit (or MSB aligned 16 bit) luma, black (16) outside the content rectangle
+static std::vector<uint8_t> MakeLuma(int inWidth, int inHeight, int inBytesPerSample, const EGAVCropRect& inContent)
+{
+	std::vector<uint8_t> luma((size_t)inWidth * inHeight * inBytesPerSample, 0);
+	EGAVTestRandom random(1);
+	for (int y = 0; y < inHeight; y++)
+	{
+		for (int x = 0; x < inWidth; x++)
+		{
+			const bool inside = x >= inContent.left && x < inContent.left + inContent.width && y >= inContent.top && y < inContent.top + inContent.height;
+			const uint8_t value = inside ? (uint8_t)(48 + random.Next() % 188) : 16;
+			luma[((size_t)y * inWidth + x) * inBytesPerSample + inBytesPerSample - 1] = value;
+		}
+	}
+	return luma;
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+	const uint64_t frames = quick ? 2 : 500;
+	const int width = 3840, height = 2160;
+
+	struct Scene
+	{
+		const char*		name;
+		EGAVCropRect	content;
+	};
+	Scene scenes[3];
+	scenes[0].name = "letterbox";
+	scenes[0].content.top = 276;
+	scenes[0].content.width = width;
+	scenes[0].content.height = height - 2 * 276;
+	scenes[1].name = "pillarbox";
+	scenes[1].content.left = 480;
+	scenes[1].content.width = width - 2 * 480;
+	scenes[1].content.height = height;
+	scenes[2].name = "full frame";
+	scenes[2].content.width = width;
+	scenes[2].content.height = height;
+
+	bool ok = true;
+	for (int bytesPerSample : { 1, 2 })
+	{
+		for (const Scene& scene : scenes)
+		{
+			const std::vector<uint8_t> luma = MakeLuma(width, height, bytesPerSample, scene.content);
+			EGAVCropRect rect;
+			const std::string name = std::string(bytesPerSample == 1 ? "4K NV12 scan, " : "4K P010 scan, ") + scene.name;
+			const double ns = EGAVBenchmark_Run(name.c_str(), frames, [&](uint64_t)
+			{
+				ok = ok && HDMICrop_ScanBlackBorders(luma.data(), width * bytesPerSample, width, height, bytesPerSample, 32, rect);
+				EGAVBenchmark_DoNotOptimize(rect);
+			});
+			printf("%-48s %12.1f frames/s, %.2f Gpixel/s\n", "", 1e9 / ns, (double)width * height / ns);
+			ok = ok && rect == scene.content;
+		}
+	}
+
+	// Detector with bar data: no scan
+	HDMICropDetector detector;
+	const std::vector<uint8_t> luma = MakeLuma(width, height, 1, scenes[0].content);
+	const uint16_t endOfTopBar = 276, startOfBottomBar = height - 276 + 1;
+	const HDMI_GENERIC_INFOFRAME avi = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_AVI, 2,
+		{ (uint8_t)(0x40 | (HDMI_AVI_B_H << 2)), 0x28, 0, 97, 0,
+		  (uint8_t)endOfTopBar, (uint8_t)(endOfTopBar >> 8), (uint8_t)startOfBottomBar, (uint8_t)(startOfBottomBar >> 8), 0, 0, 0, 0 });
+
+	EGAVCropRect rect;
+	EGAVBenchmark_Run("4K Update with bar data", quick ? 1000 : 1000000, [&](uint64_t)
+	{
+		rect = detector.Update(&avi, luma.data(), width, width, height, 1);
+		EGAVBenchmark_DoNotOptimize(rect);
+	});
+	ok = ok && rect.top == 272 && rect.height == height - 2 * 272;
+	return ok ? 0 : 1;
+}
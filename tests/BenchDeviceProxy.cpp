@@ -0,0 +1,216 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		BenchDeviceProxy.cpp
+
+@brief		EGAVDeviceProxy latency and throughput against a simulated device
+
+			- round trip: one client, one request at a time (Ping, DR packet read),
+			  compared with the direct ElgatoUVCDevice call
+			- pipelined: one client with up to 64 requests in flight
+			- clients: N clients polling the DR packet, with the share of
+			  coalesced requests
+			- slow device: Ping latency (p50/p99) while another client keeps the
+			  device thread busy with 1 ms HID reads
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVSimulatedHID.h"
+#include "EGAVDeviceProxy.h"
+#include "ElgatoUVCDevice.h"
+#include "ElgatoUVCQuirks.h"
+
+#if !_UP_WINDOWS
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <unistd.h>
+
+
+static bool RoundTrips(EGAVDeviceProxyClient& ioClient, ElgatoUVCDevice& ioDevice, uint64_t inIterations)
+{
+	bool ok = true;
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAVBenchmark_Run("direct GetHDMIHDRStatusPacket", inIterations, [&](uint64_t)
+	{
+		ok = ioDevice.GetHDMIHDRStatusPacket(frame).Succeeded() && ok;
+	});
+	EGAVBenchmark_Run("proxy Ping round trip", inIterations, [&](uint64_t)
+	{
+		ok = ioClient.Ping().Succeeded() && ok;
+	});
+	EGAVBenchmark_Run("proxy GetHDMIHDRStatusPacket round trip", inIterations, [&](uint64_t)
+	{
+		ok = ioClient.GetHDMIHDRStatusPacket(frame).Succeeded() && ok;
+	});
+	return ok;
+}
+
+static bool Pipelined(EGAVDeviceProxyClient& ioClient, uint64_t inIterations)
+{
+	const size_t kWindow = 64;
+	bool ok = true;
+	std::deque<std::future<EGAVProxyResponse>> inFlight;
+	EGAVBenchmark_Run("proxy pipelined DR packet (64 in flight)", inIterations, [&](uint64_t)
+	{
+		if (inFlight.size() == kWindow)
+		{
+			ok = inFlight.front().get().result.Succeeded() && ok;
+			inFlight.pop_front();
+		}
+		inFlight.push_back(ioClient.SendRequest(EGAVProxyOp::GetHDMIHDRStatusPacket));
+	});
+	for (auto& future : inFlight)
+		ok = future.get().result.Succeeded() && ok;
+	return ok;
+}
+
+static bool Clients(EGAVDeviceProxyServer& ioServer, const std::string& inPath, int inClients, uint64_t inDurationNs)
+{
+	const EGAVDeviceProxyStatistics before = ioServer.GetStatistics();
+	std::atomic<bool> stop{false}, failed{false};
+	std::atomic<uint64_t> requests{0};
+	std::vector<std::thread> threads;
+	for (int c = 0; c < inClients; c++)
+	{
+		threads.emplace_back([&]
+		{
+			EGAVDeviceProxyClient client;
+			if (client.Connect(inPath).Failed())
+			{
+				failed = true;
+				return;
+			}
+			HDMI_GENERIC_INFOFRAME frame{};
+			uint64_t count = 0;
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				if (client.GetHDMIHDRStatusPacket(frame).Failed())
+					failed = true;
+				count++;
+			}
+			requests += count;
+		});
+	}
+	const uint64_t start = EGAVBenchmark_GetTimeNs();
+	std::this_thread::sleep_for(std::chrono::nanoseconds(inDurationNs));
+	stop = true;
+	for (std::thread& thread : threads)
+		thread.join();
+	const double seconds = (double)(EGAVBenchmark_GetTimeNs() - start) / 1e9;
+
+	const EGAVDeviceProxyStatistics after = ioServer.GetStatistics();
+	const uint64_t received = after.requests - before.requests;
+	printf("%4d clients: %10.0f requests/s %6.1f %% coalesced %8.1f requests/batch\n", inClients, (double)requests / seconds,
+		received ? 100.0 * (double)(after.coalesced - before.coalesced) / (double)received : 0.0,
+		(after.batches > before.batches) ? (double)received / (double)(after.batches - before.batches) : 0.0);
+	return !failed && requests > 0;
+}
+
+static bool PingWithSlowDevice(EGAVSimulatedHID& ioHID, const std::string& inPath, int inPings)
+{
+	ioHID.SetReadHook([](uint8_t, uint8_t, uint8_t) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+
+	std::atomic<bool> stop{false}, failed{false};
+	std::thread busy([&]
+	{
+		EGAVDeviceProxyClient client;
+		if (client.Connect(inPath).Failed())
+			failed = true;
+		HDMI_GENERIC_INFOFRAME frame{};
+		while (!failed && !stop.load(std::memory_order_relaxed))
+			if (client.GetHDMIHDRStatusPacket(frame).Failed())
+				failed = true;
+	});
+
+	EGAVDeviceProxyClient client;
+	if (client.Connect(inPath).Failed())
+		failed = true;
+	std::vector<uint64_t> latencies;
+	for (int i = 0; i < inPings && !failed; i++)
+	{
+		const uint64_t start = EGAVBenchmark_GetTimeNs();
+		if (client.Ping().Failed())
+			failed = true;
+		latencies.push_back(EGAVBenchmark_GetTimeNs() - start);
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+	stop = true;
+	busy.join();
+	ioHID.SetReadHook(nullptr);
+
+	if (latencies.empty())
+		return false;
+	std::sort(latencies.begin(), latencies.end());
+	printf("Ping while the device is busy (1 ms HID reads): p50 %.1f us, p99 %.1f us\n", (double)latencies[latencies.size() / 2] / 1000.0,
+		(double)latencies[latencies.size() * 99 / 100] / 1000.0);
+	return !failed;
+}
+
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+	const uint64_t iterations = quick ? 200 : 50000;
+	const uint64_t durationNs = quick ? 20000000ull : 1000000000ull;
+	const std::vector<int> clientCounts = quick ? std::vector<int>{ 4 } : std::vector<int>{ 1, 2, 4, 8, 16, 32 };
+	const std::string path = "/tmp/egav-bench-proxy-" + std::to_string(getpid()) + ".sock";
+
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	const HDMI_GENERIC_INFOFRAME hdr = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, { 0x02, 0x00, 0x10, 0x27 });
+	hid->SetRegisters((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::GET_HDR_PACKET, &hdr, sizeof(hdr));
+
+	EGAVDeviceProxyServer server(device);
+	EGAVResult res = server.Start(path);
+	EGAVDeviceProxyClient client;
+	if (res.Succeeded())
+		res = client.Connect(path);
+	if (res.Failed())
+	{
+		printf("Can't start the proxy on %s: %s\n", path.c_str(), res.GetResultCodeString());
+		return 1;
+	}
+
+	bool ok = RoundTrips(client, device, iterations);
+	ok = Pipelined(client, iterations) && ok;
+	for (int clients : clientCounts)
+		ok = Clients(server, path, clients, durationNs) && ok;
+	ok = PingWithSlowDevice(*hid, path, quick ? 20 : 2000) && ok;
+
+	client.Disconnect();
+	server.Stop();
+	return ok ? 0 : 1;
+}
+
+#else
+
+int main() { return 0; }
+
+#endif
@@ -0,0 +1,205 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		BenchHIDBatchEngine.cpp
+
+@brief		EGAVHIDBatchEngine against the blocking ElgatoUVCDevice path, with
+			simulated devices on socketpairs
+
+			Two workloads: one register read per device and round, and the HDR
+			status poll (DR info frame register, PollHDRStatus()). Each runs on
+			- blocking: one ElgatoUVCDevice (EGAVHIDInterface) per device, read
+			  one after the other, as an application without the engine does
+			- io_uring and sync: the engine's backends, one batch per round
+			Prints the time per round and transaction and the engine's I/O
+			syscalls per batch. See EGAVSimulatedHIDRaw.h: socketpair round trips
+			take microseconds, hidraw control transfers hundreds of them, so these
+			numbers show the library overhead and the syscall savings, not the
+			latency on hardware.
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVSimulatedHIDRaw.h"
+#include "EGAVHIDBatchEngine.h"
+#include "ElgatoUVCDevice.h"
+
+#include <vector>
+
+
+enum class Workload { RegisterRead, HDRPoll };
+
+static const char* GetWorkloadName(Workload inWorkload)
+{
+	return inWorkload == Workload::HDRPoll ? "HDR poll" : "I2C read";
+}
+
+static void PrintResult(const char* inPath, Workload inWorkload, int inDevices, uint64_t inElapsedNs, int inRounds, double inSyscallsPerBatch, int inBad)
+{
+	const double usPerRound = (double)inElapsedNs / 1000.0 / (double)inRounds;
+	char syscalls[32] = "       -";
+	if (inSyscallsPerBatch >= 0)
+		snprintf(syscalls, sizeof(syscalls), "%8.1f", inSyscallsPerBatch);
+	printf("%-8s %-9s %4d devices: %10.1f us/round %8.2f us/transaction %s syscalls/batch  %s\n", inPath, GetWorkloadName(inWorkload),
+		inDevices, usPerRound, usPerRound / inDevices, syscalls, inBad ? "ERRORS" : "");
+}
+
+//! @brief Registers 0x40.. are i ^ device: the register reads check the data of each device
+static bool CheckRegisters(const uint8_t* inData, int inDevice)
+{
+	return inData[0] == (uint8_t)(0x40 ^ inDevice) && inData[1] == (uint8_t)(0x41 ^ inDevice);
+}
+
+
+//==============================================================================
+// # Blocking ElgatoUVCDevice
+//==============================================================================
+
+static bool RunBlocking(Workload inWorkload, int inDevices, int inRounds)
+{
+	std::vector<std::unique_ptr<EGAVSimulatedHIDRawDevice>> simulated;
+	std::vector<std::unique_ptr<ElgatoUVCDevice>> devices;
+	for (int i = 0; i < inDevices; i++)
+	{
+		simulated.push_back(std::make_unique<EGAVSimulatedHIDRawDevice>((uint8_t)i));
+		auto hid = std::make_shared<EGAVSocketPairHID>(simulated.back()->TakeTransport());
+		if (hid->InitHIDInterface(deviceIDHD60X).Failed())
+			return false;
+		devices.push_back(std::make_unique<ElgatoUVCDevice>(hid, deviceIDHD60X));
+	}
+
+	int bad = 0;
+	uint64_t start = 0;
+	for (int round = -1; round < inRounds; round++) // round -1: warm-up
+	{
+		if (round == 0)
+			start = EGAVBenchmark_GetTimeNs();
+		for (int i = 0; i < inDevices; i++)
+		{
+			if (inWorkload == Workload::HDRPoll)
+			{
+				HDMI_GENERIC_INFOFRAME frame{};
+				if (devices[i]->GetHDMIHDRStatusPacket(frame).Failed())
+					bad++;
+			}
+			else
+			{
+				uint8_t data[2] = {};
+				if (devices[i]->ReadI2cBlock((uint8_t)I2CAddress::MCU, 0x40, data, sizeof(data)).Failed() || !CheckRegisters(data, i))
+					bad++;
+			}
+		}
+	}
+	PrintResult("blocking", inWorkload, inDevices, EGAVBenchmark_GetTimeNs() - start, inRounds, -1, bad);
+	return bad == 0;
+}
+
+
+//==============================================================================
+// # EGAVHIDBatchEngine
+//==============================================================================
+
+static bool RunBackend(EGAVHIDBatchBackend inBackend, Workload inWorkload, int inDevices, int inRounds)
+{
+	EGAVHIDBatchEngineConfig config;
+	config.backend = inBackend;
+	EGAVHIDBatchEngine engine(config);
+	if (engine.Init().Failed())
+	{
+		printf("%-8s %-9s %4d devices: not available\n", EGAVHIDBatchEngine::GetBackendName(inBackend), GetWorkloadName(inWorkload), inDevices);
+		return true;
+	}
+
+	std::vector<std::unique_ptr<EGAVSimulatedHIDRawDevice>> devices;
+	std::vector<int> indices;
+	for (int i = 0; i < inDevices; i++)
+	{
+		devices.push_back(std::make_unique<EGAVSimulatedHIDRawDevice>((uint8_t)i));
+		indices.push_back(engine.AddDevice(devices.back()->TakeTransport(), deviceIDHD60X, EGAVFirmwareVersion(), 0));
+		if (indices.back() < 0)
+			return false;
+	}
+
+	std::vector<EGAVHIDBatchTransaction> transactions(inDevices);
+	for (int i = 0; i < inDevices; i++)
+	{
+		transactions[i].device  = i;
+		transactions[i].address = (uint8_t)I2CAddress::MCU;
+		transactions[i].reg     = 0x40;
+		transactions[i].length  = 2;
+	}
+
+	int bad = 0;
+	const auto onHDRStatus = [&](int, EGAVResult inResult, const HDMI_GENERIC_INFOFRAME&) { bad += inResult.Failed() ? 1 : 0; };
+	uint64_t start = 0;
+	for (int round = -1; round < inRounds; round++) // round -1: warm-up
+	{
+		if (round == 0)
+		{
+			engine.ResetStatistics();
+			start = EGAVBenchmark_GetTimeNs();
+		}
+		if (inWorkload == Workload::HDRPoll)
+		{
+			if (engine.PollHDRStatus(indices.data(), indices.size(), onHDRStatus).Failed())
+				bad++;
+			continue;
+		}
+
+		if (engine.Execute(transactions.data(), transactions.size()).Failed())
+			bad++;
+		for (int i = 0; i < inDevices; i++)
+			if (transactions[i].result.Failed() || !CheckRegisters(transactions[i].data.data(), i))
+				bad++;
+	}
+	const uint64_t elapsedNs = EGAVBenchmark_GetTimeNs() - start;
+
+	const EGAVHIDBatchStatistics& statistics = engine.GetStatistics();
+	PrintResult(EGAVHIDBatchEngine::GetBackendName(engine.GetBackend()), inWorkload, inDevices, elapsedNs, inRounds,
+				(double)statistics.syscalls / (double)(statistics.batches ? statistics.batches : 1), bad);
+	return bad == 0;
+}
+
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+	const int rounds = quick ? 20 : 2000;
+	const std::vector<int> deviceCounts = quick ? std::vector<int>{ 4 } : std::vector<int>{ 1, 4, 16, 64 };
+
+	bool ok = true;
+	for (Workload workload : { Workload::RegisterRead, Workload::HDRPoll })
+	{
+		for (int devices : deviceCounts)
+		{
+			ok = RunBlocking(workload, devices, rounds) && ok;
+			ok = RunBackend(EGAVHIDBatchBackend::IoUring, workload, devices, rounds) && ok;
+			ok = RunBackend(EGAVHIDBatchBackend::Sync, workload, devices, rounds) && ok;
+		}
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		BenchI2cBlock.cpp
+
+@brief		ReadI2cBlock() / WriteI2cBlock() throughput against the simulated device
+
+			The simulated device answers instantly, so the numbers are the library
+			overhead per block. On hardware every report is a USB control transfer;
+			the report counts printed here decide the real throughput.
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVSimulatedHID.h"
+#include "ElgatoUVCDevice.h"
+
+
+int main(int argc, char** argv)
+{
+	const uint64_t iterations = EGAVBenchmark_IsQuick(argc, argv) ? 100 : 100000;
+	const uint8_t kAddress = 0x30;
+	const size_t kBlockSize = 256;
+
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+
+	uint8_t block[kBlockSize] = {};
+	bool ok = true;
+
+	struct Case
+	{
+		const char*	name;
+		bool		write;
+		bool		verify;
+	};
+	const Case cases[] =
+	{
+		{ "ReadI2cBlock() 256 bytes",				false,	false },
+		{ "ReadI2cBlock() 256 bytes, verified",		false,	true },
+		{ "WriteI2cBlock() 256 bytes",				true,	false },
+		{ "WriteI2cBlock() 256 bytes, verified",	true,	true },
+	};
+	for (const Case& test : cases)
+	{
+		hid->ResetCounters();
+		const double ns = EGAVBenchmark_Run(test.name, iterations, [&](uint64_t i)
+		{
+			EGAVResult res;
+			if (test.write)
+			{
+				block[0] = (uint8_t)i;
+				res = device.WriteI2cBlock(kAddress, 0, block, kBlockSize, test.verify);
+			}
+			else
+				res = device.ReadI2cBlock(kAddress, 0, block, kBlockSize, test.verify);
+			ok = ok && res.Succeeded();
+		});
+		printf("%-48s %12.1f MB/s, %.1f HID writes + %.1f HID reads per block\n", "", (double)kBlockSize * 1000.0 / ns,
+			(double)hid->GetHIDWriteCount() / (double)iterations, (double)hid->GetHIDReadCount() / (double)iterations);
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		BenchInfoFrameJournal.cpp
+
+@brief		HDMIInfoFrameJournalWriter throughput and HDMIInfoFrameJournalReader
+			queries on a synthetic multi-hour journal
+
+			The journal is a DR packet polled at 60 Hz for 4 hours (1 minute with
+			--quick). MaxFALL changes on every poll, the EOTF toggles every 10
+			minutes: a worst case for the journal size, every poll is a record.
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "HDMIInfoFrameJournal.h"
+#include "ElgatoUVCQuirks.h"
+
+#include <random>
+#include <vector>
+
+
+static HDMI_GENERIC_INFOFRAME MakeDRFrame(uint8_t inEOTF, uint16_t inMaxFALL)
+{
+	std::vector<uint8_t> payload(26, 0);
+	payload[0]  = inEOTF;
+	payload[22] = 0xE8;	// MaxCLL 1000
+	payload[23] = 0x03;
+	payload[24] = (uint8_t)inMaxFALL;
+	payload[25] = (uint8_t)(inMaxFALL >> 8);
+	return EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, payload);
+}
+
+//! @brief Frame of poll inPoll (60 Hz); built up front so the benchmark measures the journal only
+static const HDMI_GENERIC_INFOFRAME& GetPollFrame(uint64_t inPoll)
+{
+	static const std::vector<HDMI_GENERIC_INFOFRAME> frames = []
+	{
+		std::vector<HDMI_GENERIC_INFOFRAME> result;
+		for (uint8_t eotf : { 2, 0 })
+			for (uint16_t i = 0; i < 300; i++)
+				result.push_back(MakeDRFrame(eotf, (uint16_t)(100 + i)));
+		return result;
+	}();
+	const size_t eotfIndex = (inPoll / (60 * 600)) & 1;
+	return frames[eotfIndex * 300 + inPoll % 300];
+}
+
+static const uint64_t kPollIntervalUs = 16667;
+
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+	const uint64_t polls = quick ? 60 * 60 : 4ull * 3600 * 60;
+	const uint64_t start = 1000000;
+
+	const std::string path = EGAVTest_GetTempPath("bench_journal.bin");
+	EGAVTest_GetTempPath("bench_journal.bin.idx");
+
+	// Writer: explicit timestamps (recorded data), every frame changed
+	{
+		HDMIInfoFrameJournalWriter writer;
+		if (writer.Open(path, deviceIDHD60X).Failed())
+			return 1;
+		EGAVBenchmark_Run("Append() changed frame, explicit timestamp", polls, [&](uint64_t i)
+		{
+			writer.Append(GetPollFrame(i), start + i * kPollIntervalUs);
+		});
+		EGAVBenchmark_Run("Append() unchanged frame", quick ? 1000 : 1000000, [&](uint64_t)
+		{
+			writer.Append(GetPollFrame(polls - 1), start + polls * kPollIntervalUs);
+		});
+		writer.Close();
+	}
+	const uintmax_t journalSize = std::filesystem::file_size(path);
+	printf("%-48s %12.1f MB (%.1f bytes/record)\n", "journal size", (double)journalSize / 1e6, (double)journalSize / (double)polls);
+
+	// Writer: current journal time, with clock records
+	{
+		const std::string livePath = EGAVTest_GetTempPath("bench_journal_live.bin");
+		EGAVTest_GetTempPath("bench_journal_live.bin.idx");
+		HDMIInfoFrameJournalWriter writer;
+		if (writer.Open(livePath, deviceIDHD60X).Failed())
+			return 1;
+		EGAVBenchmark_Run("Append() changed frame, journal time", quick ? 1000 : 1000000, [&](uint64_t i)
+		{
+			writer.Append(GetPollFrame(i));
+		});
+	}
+
+	// Reader
+	HDMIInfoFrameJournalReader reader;
+	EGAVBenchmark_Run("Open() reader", quick ? 10 : 1000, [&](uint64_t)
+	{
+		reader.Open(path);
+	});
+	if (reader.GetLastTimestamp() != start + (polls - 1) * kPollIntervalUs)
+		return 1;
+
+	// Random times: binary search in the index, then up to kKeyFrameInterval deltas
+	std::mt19937_64 random(1);
+	std::vector<uint64_t> queries(4096);
+	for (uint64_t& query : queries)
+		query = start + random() % (polls * kPollIntervalUs);
+
+	int bad = 0;
+	EGAVBenchmark_Run("GetFrameAt() random time", quick ? 1000 : 2000000, [&](uint64_t i)
+	{
+		const uint64_t query = queries[i % queries.size()];
+		HDMI_GENERIC_INFOFRAME frame{};
+		uint64_t changedAt = 0;
+		if (reader.GetFrameAt(query, frame, &changedAt).Failed())
+		{
+			bad++;
+			return;
+		}
+		const HDMI_GENERIC_INFOFRAME& expected = GetPollFrame((changedAt - start) / kPollIntervalUs);
+		if (memcmp(&frame, &expected, sizeof(frame)) != 0)
+			bad++;
+	});
+	EGAVBenchmark_Run("GetLastTimestamp()", quick ? 1000 : 1000000, [&](uint64_t)
+	{
+		EGAVBenchmark_DoNotOptimize(reader.GetLastTimestamp());
+	});
+	printf("%-48s %12zu\n", "key frames", reader.GetKeyFrameCount());
+
+	if (bad)
+		printf("ERRORS: %d queries returned a wrong frame\n", bad);
+	return bad == 0 ? 0 : 1;
+}
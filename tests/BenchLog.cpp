@@ -0,0 +1,218 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		BenchLog.cpp
+
+@brief		Cost of a log call on the HID path: EGAVLog::Write() (binary record,
+			formatted later by the consumer thread) compared with snprintf() and a
+			synchronous sink, the way an integrator implements error_printf()
+			without the binary log
+
+			Each iteration reads the HDR status packet from the simulated device
+			and logs one line with integer and string arguments. The loop runs in
+			chunks that fit into the ring; the consumer is flushed between the
+			chunks, outside the measured time, so no record is dropped and the
+			Write() numbers don't include the cheaper drop path. Formatting on the
+			consumer is measured separately.
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVLog.h"
+#include "EGAVSimulatedHID.h"
+#include "ElgatoUVCDevice.h"
+
+#include <algorithm>
+#include <vector>
+
+
+namespace
+{
+
+const int kSlotsPerThread	= 4096;
+const int kChunk			= 2048;		//!< log calls between two flushes (fits into the ring)
+
+const char* const kFormat	= "HDR status packet: type 0x%02x, version %u, length %u, checksum 0x%02x: %s";
+
+uint64_t gSinkBytes = 0;				//!< consumer thread or the logging thread, never both
+
+void CountingSink(const char* inMessage)
+{
+	gSinkBytes += strlen(inMessage);
+}
+
+//! @brief Runs inFunction in chunks of kChunk calls, flushes the log between the chunks (not measured)
+//! @return nanoseconds per iteration
+template <typename Function>
+double RunChunked(const char* inName, uint64_t inIterations, Function&& inFunction)
+{
+	uint64_t elapsed = 0;
+	for (uint64_t done = 0; done < inIterations; )
+	{
+		const uint64_t count = std::min<uint64_t>(kChunk, inIterations - done);
+		const uint64_t start = EGAVBenchmark_GetTimeNs();
+		for (uint64_t i = 0; i < count; i++)
+			inFunction(done + i);
+		elapsed += EGAVBenchmark_GetTimeNs() - start;
+		done += count;
+		EGAVLog::Flush();
+	}
+	const double ns = (double)elapsed / (double)(inIterations ? inIterations : 1);
+	printf("%-48s %12.1f ns/op  (%llu iterations)\n", inName, ns, (unsigned long long)inIterations);
+	return ns;
+}
+
+//! @brief Times every call: the tail matters more than the mean on the HID thread
+template <typename Function>
+void PrintLatency(const char* inName, uint64_t inIterations, Function&& inFunction)
+{
+	std::vector<uint64_t> samples;
+	samples.reserve((size_t)inIterations);
+	for (uint64_t done = 0; done < inIterations; )
+	{
+		const uint64_t count = std::min<uint64_t>(kChunk, inIterations - done);
+		for (uint64_t i = 0; i < count; i++)
+		{
+			const uint64_t start = EGAVBenchmark_GetTimeNs();
+			inFunction(done + i);
+			samples.push_back(EGAVBenchmark_GetTimeNs() - start);
+		}
+		done += count;
+		EGAVLog::Flush();
+	}
+	std::sort(samples.begin(), samples.end());
+	printf("%-48s %12llu ns p50, %llu ns p99, %llu ns max (incl. clock)\n", inName,
+		(unsigned long long)samples[samples.size() / 2], (unsigned long long)samples[samples.size() * 99 / 100],
+		(unsigned long long)samples.back());
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+	const uint64_t iterations = EGAVBenchmark_IsQuick(argc, argv) ? 4096 : 1000000;
+	bool ok = true;
+
+	EGAVLogConfig config;
+	config.slotsPerThread  = kSlotsPerThread;
+	config.flushIntervalMs = 1000;			// the chunks flush explicitly
+	config.sink = [](EGAVLogLevel, uint64_t, int, const char* inMessage) { CountingSink(inMessage); };
+	EGAVLog::Start(config);
+
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	HDMI_GENERIC_INFOFRAME frame{};
+
+	auto readPacket = [&]() -> EGAVResult
+	{
+		const EGAVResult res = device.GetHDMIHDRStatusPacket(frame);
+		ok = ok && res.Succeeded();
+		return res;
+	};
+	auto logSnprintf = [&](const EGAVResult& inResult)
+	{
+		char line[256];
+		snprintf(line, sizeof(line), kFormat, frame.header.bfType, (unsigned)frame.header.bfVersion,
+			(unsigned)frame.header.bPayloadLength, frame.bChecksum, inResult.GetResultCodeString());
+		CountingSink(line);
+	};
+	auto logBinary = [&](const EGAVResult& inResult)
+	{
+		EGAVLog::Write(EGAVLogLevel::Info, kFormat, frame.header.bfType, (unsigned)frame.header.bfVersion,
+			(unsigned)frame.header.bPayloadLength, frame.bChecksum, inResult.GetResultCodeString());
+	};
+
+	//-----------------------------------------------------------------------------
+	// ## HID loop
+	//-----------------------------------------------------------------------------
+
+	const double base = RunChunked("HID loop, no logging", iterations, [&](uint64_t)
+	{
+		readPacket();
+	});
+
+	gSinkBytes = 0;
+	const double withSnprintf = RunChunked("HID loop + snprintf() and sink", iterations, [&](uint64_t)
+	{
+		logSnprintf(readPacket());
+	});
+	const uint64_t snprintfBytes = gSinkBytes;
+	printf("%-48s %12.1f ns per log call\n", "", withSnprintf - base);
+
+	gSinkBytes = 0;
+	const EGAVLogStatistics before = EGAVLog::GetStatistics();
+	const double withBinary = RunChunked("HID loop + EGAVLog::Write()", iterations, [&](uint64_t)
+	{
+		logBinary(readPacket());
+	});
+	const EGAVLogStatistics after = EGAVLog::GetStatistics();
+	printf("%-48s %12.1f ns per log call\n", "", withBinary - base);
+	printf("%-48s %12llu written, %llu dropped, %llu formatted\n", "", (unsigned long long)(after.written - before.written),
+		(unsigned long long)(after.dropped - before.dropped), (unsigned long long)(after.formatted - before.formatted));
+
+	// Same messages, nothing lost
+	ok = ok && after.dropped == before.dropped && after.written - before.written == iterations
+		&& after.formatted - before.formatted == iterations && gSinkBytes == snprintfBytes;
+
+	//-----------------------------------------------------------------------------
+	// ## Log call alone
+	//-----------------------------------------------------------------------------
+
+	const EGAVResult res = readPacket();
+	PrintLatency("snprintf() and sink", iterations, [&](uint64_t) { logSnprintf(res); });
+	PrintLatency("EGAVLog::Write()", iterations, [&](uint64_t) { logBinary(res); });
+
+	// The work moved to the consumer thread
+	EGAVLogRecord record;
+	char line[256];
+	EGAVLog::FillRecord(record, EGAVLogLevel::Info, kFormat, frame.header.bfType, (unsigned)frame.header.bfVersion,
+		(unsigned)frame.header.bPayloadLength, frame.bChecksum, res.GetResultCodeString());
+	EGAVBenchmark_Run("EGAVLog::FormatRecord() (consumer)", iterations, [&](uint64_t)
+	{
+		EGAVLog::FormatRecord(record, line, sizeof(line));
+		EGAVBenchmark_DoNotOptimize(line);
+	});
+
+	//-----------------------------------------------------------------------------
+	// ## Ring full (bounded loss)
+	//-----------------------------------------------------------------------------
+
+	const EGAVLogStatistics burstBefore = EGAVLog::GetStatistics();
+	const uint64_t burst = 2 * kSlotsPerThread;
+	const uint64_t start = EGAVBenchmark_GetTimeNs();
+	for (uint64_t i = 0; i < burst; i++)
+		logBinary(res);
+	const double burstNs = (double)(EGAVBenchmark_GetTimeNs() - start) / (double)burst;
+	EGAVLog::Flush();
+	const EGAVLogStatistics burstAfter = EGAVLog::GetStatistics();
+	printf("%-48s %12.1f ns/op  (%llu calls, %llu dropped)\n", "EGAVLog::Write() burst of twice the ring", burstNs,
+		(unsigned long long)burst, (unsigned long long)(burstAfter.dropped - burstBefore.dropped));
+	ok = ok && burstAfter.dropped > burstBefore.dropped;
+
+	EGAVLog::Stop();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		BenchPixelRepetition.cpp
+
+@brief		HDMI pixel repetition removal per format (NV12, P010, YUY2) with the
+			SSE2 and the scalar kernels: 720(1440)x480 and 720(2880)x480 as sent
+			by SD sources, and a 4K frame for the memory bandwidth. Only factor 2
+			has a SIMD path; factor 4 runs the scalar kernel in both rows.
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "HDMIPixelRepetition.h"
+
+#include <string>
+#include <vector>
+
+
+enum class Format { NV12, P010, YUY2 };
+
+static const char* GetFormatName(Format inFormat)
+{
+	switch (inFormat)
+	{
+		case Format::NV12: return "NV12";
+		case Format::P010: return "P010";
+		case Format::YUY2: return "YUY2";
+	}
+	return "";
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+
+	struct Size
+	{
+		int		width;
+		int		height;
+		int		factor;
+	};
+	const Size sizes[] = { { 1440, 480, 2 }, { 2880, 480, 4 }, { 3840, 2160, 2 } };
+
+	bool ok = true;
+	for (Format format : { Format::NV12, Format::P010, Format::YUY2 })
+	{
+		for (const Size& size : sizes)
+		{
+			// Bytes per row (YUY2: packed) and of the whole input frame
+			const int bytesPerSample = (format == Format::P010) ? 2 : 1;
+			const int inRowBytes  = (format == Format::YUY2) ? size.width * 2 : size.width * bytesPerSample;
+			const int outWidth    = HDMI_GetDecimatedWidth(size.width, size.factor);
+			const int outRowBytes = (format == Format::YUY2) ? outWidth * 2 : outWidth * bytesPerSample;
+			const int inRows      = (format == Format::YUY2) ? size.height : size.height * 3 / 2;
+
+			std::vector<uint8_t> in((size_t)inRowBytes * inRows, 0x40), out((size_t)outRowBytes * inRows);
+			const uint8_t* inUV = in.data() + (size_t)inRowBytes * size.height;
+			uint8_t* outUV = out.data() + (size_t)outRowBytes * size.height;
+
+			const uint64_t iterations = quick ? 2 : (size.height > 1000 ? 200 : 2000);
+			std::vector<uint8_t> reference;
+			for (bool simd : { true, false })
+			{
+				const std::string name = std::string(GetFormatName(format)) + " " + std::to_string(size.width) + "x" + std::to_string(size.height) +
+										 ", factor " + std::to_string(size.factor) + (simd ? ", SIMD" : ", scalar");
+				const double ns = EGAVBenchmark_Run(name.c_str(), iterations, [&](uint64_t)
+				{
+					EGAVResult result;
+					if (format == Format::YUY2)
+						result = HDMI_RemovePixelRepetitionYUY2(in.data(), inRowBytes, out.data(), outRowBytes, size.width, size.height, size.factor, simd);
+					else if (format == Format::NV12)
+						result = HDMI_RemovePixelRepetitionNV12(in.data(), inRowBytes, inUV, inRowBytes, out.data(), outRowBytes, outUV, outRowBytes,
+																size.width, size.height, size.factor, simd);
+					else
+						result = HDMI_RemovePixelRepetitionP010(in.data(), inRowBytes, inUV, inRowBytes, out.data(), outRowBytes, outUV, outRowBytes,
+																size.width, size.height, size.factor, simd);
+					ok = ok && result.Succeeded();
+					EGAVBenchmark_DoNotOptimize(out);
+				});
+				printf("%-48s %12.2f GB/s read\n", "", (double)in.size() / ns);
+
+				if (simd)
+					reference = out;
+				else
+					ok = ok && out == reference;
+			}
+		}
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		BenchResult.cpp
+
+@brief		EGAVResult as a return value: a chain of non-inlined calls that
+			propagate the result (the HID and I2C call pattern), compared with a
+			plain int code and with the former layout carrying a std::string,
+			plus Succeeded() for custom codes and GetResultCodeString()
+
+			16 byte trivially copyable results come back in two registers
+			(System V x64, ARM64); the std::string layout is returned through
+			memory and destroyed at every level.
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVResult.h"
+
+#include <string>
+#include <type_traits>
+
+
+#if defined(_MSC_VER)
+	#define BENCH_NOINLINE __declspec(noinline)
+#else
+	#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+//! @brief EGAVResult before it lost the message string (48 bytes, non-trivial)
+struct LegacyResult
+{
+	EGAVResultCode			mResultCode			= EGAVResult::ErrCustom;
+	EGAVResultCustomType	mCustomResultType	= EGAVResultCustomType::None;
+	int64_t					mCustomResultCode	= 0;
+	std::string				mMessage;
+
+	LegacyResult(EGAVResultCode inResultCode) : mResultCode(inResultCode) {}
+	bool Succeeded() const { return mResultCode > 0; }
+	bool Failed() const { return !Succeeded(); }
+};
+
+
+//==============================================================================
+// # Call chains: transfer -> register access -> device call -> caller
+//==============================================================================
+
+// A timeout every 64 calls, so the failure path is taken but predictable
+template <typename Result>
+BENCH_NOINLINE static Result Transfer(uint64_t inCall)
+{
+	return ((inCall & 63) == 0) ? Result(EGAVResult::ErrTimeOut) : Result(EGAVResult::Ok);
+}
+
+template <typename Result>
+BENCH_NOINLINE static Result ReadRegister(uint64_t inCall)
+{
+	Result res = Transfer<Result>(inCall);
+	if (res.Failed())
+		return res;
+	return Result(EGAVResult::Ok);
+}
+
+template <typename Result>
+BENCH_NOINLINE static Result DeviceCall(uint64_t inCall)
+{
+	Result res = ReadRegister<Result>(inCall);
+	if (res.Failed())
+		return res;
+	return ReadRegister<Result>(inCall + 1);
+}
+
+//! @brief Plain int code through the same chain (lower bound)
+BENCH_NOINLINE static int TransferCode(uint64_t inCall)		{ return ((inCall & 63) == 0) ? EGAVResult::ErrTimeOut : EGAVResult::Ok; }
+BENCH_NOINLINE static int ReadRegisterCode(uint64_t inCall)	{ const int res = TransferCode(inCall); return (res <= 0) ? res : EGAVResult::Ok; }
+BENCH_NOINLINE static int DeviceCallCode(uint64_t inCall)	{ const int res = ReadRegisterCode(inCall); return (res <= 0) ? res : ReadRegisterCode(inCall + 1); }
+
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+	const uint64_t iterations = quick ? 1000 : 50000000;
+
+	printf("%-48s %zu bytes, trivially copyable: %s\n", "sizeof(EGAVResult)", sizeof(EGAVResult),
+		   std::is_trivially_copyable<EGAVResult>::value ? "yes" : "no");
+	printf("%-48s %zu bytes, trivially copyable: %s\n", "sizeof(former EGAVResult with std::string)", sizeof(LegacyResult),
+		   std::is_trivially_copyable<LegacyResult>::value ? "yes" : "no");
+
+	// Each device call is 3 or 5 nested calls (2 register reads), the caller checks the result
+	uint64_t failures[3] = {};
+	EGAVBenchmark_Run("Device call chain, int code", iterations, [&](uint64_t i)
+	{
+		failures[0] += (DeviceCallCode(i) <= 0);
+	});
+	EGAVBenchmark_Run("Device call chain, EGAVResult", iterations, [&](uint64_t i)
+	{
+		failures[1] += DeviceCall<EGAVResult>(i).Failed();
+	});
+	EGAVBenchmark_Run("Device call chain, former EGAVResult", iterations, [&](uint64_t i)
+	{
+		failures[2] += DeviceCall<LegacyResult>(i).Failed();
+	});
+
+	// Custom codes are decided out of line (platform error codes)
+	const EGAVResult custom(EGAVResultCustomType::Device, 0);
+	const EGAVResult plain(EGAVResult::OkNoDataChanged);
+	uint64_t succeeded = 0;
+	EGAVBenchmark_Run("Succeeded(), plain code", iterations, [&](uint64_t i)
+	{
+		EGAVResult res = plain;
+		EGAVBenchmark_DoNotOptimize(res);
+		succeeded += res.Succeeded() + (i & 1);
+	});
+	EGAVBenchmark_Run("Succeeded(), custom code", iterations, [&](uint64_t i)
+	{
+		EGAVResult res = custom;
+		EGAVBenchmark_DoNotOptimize(res);
+		succeeded += res.Succeeded() + (i & 1);
+	});
+	EGAVBenchmark_DoNotOptimize(succeeded);
+
+	// Messages are looked up only when logged
+	const char* text = nullptr;
+	EGAVBenchmark_Run("GetResultCodeString(ErrInvalidOperation), first", quick ? 1000 : 10000000, [&](uint64_t)
+	{
+		EGAVResultCode code = EGAVResult::ErrInvalidOperation;
+		EGAVBenchmark_DoNotOptimize(code);
+		text = EGAVResult::GetResultCodeString(code);
+		EGAVBenchmark_DoNotOptimize(text);
+	});
+	EGAVBenchmark_Run("GetResultCodeString(OkButIncomplete), last", quick ? 1000 : 10000000, [&](uint64_t)
+	{
+		EGAVResultCode code = EGAVResult::OkButIncomplete;
+		EGAVBenchmark_DoNotOptimize(code);
+		text = EGAVResult::GetResultCodeString(code);
+		EGAVBenchmark_DoNotOptimize(text);
+	});
+
+	// All three chains must have taken the failure path equally often
+	return (failures[0] > 0 && failures[0] == failures[1] && failures[1] == failures[2]) ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		BenchStatusReaders.cpp
+
+@brief		EGAVStatusReader::Read() with 1 to 64 reader threads
+
+			One publisher thread publishes a change every 100 us (far above real
+			poll rates, so the seqlock retry path is exercised) while the readers
+			copy snapshots in a loop. Prints the time per read and the aggregate
+			read rate per thread count. Above the number of cores the threads
+			share CPUs, so the per-read time grows with the oversubscription.
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVStatusSegment.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+	const uint64_t durationNs = quick ? 5000000ull : 500000000ull;
+	const std::vector<int> threadCounts = quick ? std::vector<int>{ 1, 4 } : std::vector<int>{ 1, 2, 4, 8, 16, 32, 64 };
+	const std::string name = "/egav-bench-" + std::to_string(getpid());
+
+	EGAVStatusPublisher publisher;
+	EGAVResult res = publisher.Create(name);
+	if (res.Failed())
+	{
+		printf("Can't create %s: %s\n", name.c_str(), res.GetResultCodeString());
+		return 1;
+	}
+
+	EGAVStatusSnapshot snapshot{};
+	snapshot.eotf = HDMI_DR_EOTF_ST2084;
+	publisher.Publish(snapshot, EGAVBenchmark_GetTimeNs() / 1000);
+
+	bool ok = true;
+	printf("%-10s %14s %16s %12s\n", "readers", "ns/read", "reads/s total", "changes");
+	for (int threadCount : threadCounts)
+	{
+		std::atomic<bool> stop{false};
+		std::atomic<int> ready{0};
+		std::atomic<bool> failed{false};
+		std::vector<uint64_t> reads(threadCount, 0);
+		std::vector<std::thread> readers;
+		for (int t = 0; t < threadCount; t++)
+		{
+			readers.emplace_back([&, t]
+			{
+				EGAVStatusReader reader;
+				if (reader.Open(name).Failed())
+					failed = true;
+				ready++;
+				EGAVStatusSnapshot copy{};
+				uint64_t count = 0;
+				while (!stop.load(std::memory_order_relaxed))
+				{
+					if (reader.Read(copy).Failed())
+						failed = true;
+					EGAVBenchmark_DoNotOptimize(copy);
+					count++;
+				}
+				reads[t] = count;
+			});
+		}
+		while (ready.load() < threadCount)
+			std::this_thread::yield();
+
+		// Publisher: one change every 100 us
+		const uint64_t start = EGAVBenchmark_GetTimeNs();
+		uint64_t now = start, changes = 0;
+		while (now - start < durationNs)
+		{
+			snapshot.frameMask = (uint32_t)++changes;
+			publisher.Publish(snapshot, now / 1000);
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			now = EGAVBenchmark_GetTimeNs();
+		}
+		stop = true;
+		for (std::thread& reader : readers)
+			reader.join();
+		const double seconds = (double)(EGAVBenchmark_GetTimeNs() - start) / 1e9;
+
+		uint64_t total = 0;
+		for (uint64_t count : reads)
+			total += count;
+		const double readsPerThread = (double)total / (double)threadCount;
+		printf("%-10d %14.1f %16.0f %12llu\n", threadCount, readsPerThread > 0 ? seconds * 1e9 / readsPerThread : 0.0,
+			(double)total / seconds, (unsigned long long)changes);
+		ok = ok && !failed && total > 0;
+	}
+
+	publisher.Close();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		BenchToneMapLUTCache.cpp
+
+@brief		HDRToneMapLUTCache: LUT build time (curves and 3D LUT), Acquire() on
+			a hit, miss to ready latency through the background thread, and the
+			hit rate of a source that switches between a few DR info frames
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "HDRToneMapLUTCache.h"
+
+#include <cstring>
+#include <string>
+
+
+//! DR payload of a PQ source with the given MaxCLL, as decoded from the info frame
+static HDMI_DR1_PAYLOAD MakePayload(uint16_t inMaxCLL)
+{
+	HDMI_DR1_PAYLOAD payload;
+	memset(&payload, 0, sizeof(payload));
+	payload.bfEOTF					= HDMI_DR_EOTF_ST2084;
+	payload.wMaxDisplayLuminance	= 1000;
+	payload.wMinDisplayLuminance	= 50;
+	payload.wMaxCLL					= inMaxCLL;
+	return payload;
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+	bool ok = true;
+
+	// # Build time
+	HDRToneMapParams params = HDRToneMapParams::FromInfoFrame(MakePayload(1000));
+	EGAVBenchmark_Run("HDRToneMapCurves::Build (1D curves)", quick ? 2 : 200, [&](uint64_t i)
+	{
+		params.sourcePeak = 1000.f + (float)i;
+		auto curves = HDRToneMapCurves::Build(params);
+		EGAVBenchmark_DoNotOptimize(curves);
+	});
+	EGAVBenchmark_Run("HDRToneMapLUTCache::Build (curves + 33^3 LUT)", quick ? 2 : 200, [&](uint64_t i)
+	{
+		params.sourcePeak = 1000.f + (float)i;
+		auto lut = HDRToneMapLUTCache::Build(params);
+		EGAVBenchmark_DoNotOptimize(lut);
+	});
+	EGAVBenchmark_Run("GetKey", quick ? 1000 : 10000000, [&](uint64_t i)
+	{
+		params.sourcePeak = (float)(i & 1023);
+		uint64_t key = HDRToneMapLUTCache::GetKey(params);
+		EGAVBenchmark_DoNotOptimize(key);
+	});
+
+	// # Miss to ready: queued on a miss, built by the background thread
+	{
+		HDRToneMapLUTCache cache;
+		EGAVBenchmark_Run("Acquire miss -> WaitForPendingBuilds -> hit", quick ? 2 : 100, [&](uint64_t i)
+		{
+			const HDMI_DR1_PAYLOAD payload = MakePayload((uint16_t)(2000 + i));
+			ok = ok && !cache.Acquire(payload);
+			cache.WaitForPendingBuilds();
+			ok = ok && cache.Acquire(payload) != nullptr;
+		});
+	}
+
+	// # Hits: the per-frame cost for an unchanged info frame, and with the LRU order changing on each call
+	{
+		const int kSources = 4;
+		HDMI_DR1_PAYLOAD payloads[kSources];
+		std::shared_ptr<const HDRToneMapLUT> built[kSources];
+		HDRToneMapLUTCache cache(kSources);
+		for (int i = 0; i < kSources; i++)
+		{
+			payloads[i] = MakePayload((uint16_t)(400 + 200 * i));
+			cache.Acquire(payloads[i]);
+		}
+		cache.WaitForPendingBuilds();
+		for (int i = 0; i < kSources; i++)
+			built[i] = cache.Acquire(payloads[i]);
+
+		EGAVBenchmark_Run("Acquire hit, same info frame", quick ? 1000 : 10000000, [&](uint64_t)
+		{
+			auto lut = cache.Acquire(payloads[0]);
+			EGAVBenchmark_DoNotOptimize(lut);
+		});
+		EGAVBenchmark_Run("Acquire hit, 4 alternating info frames", quick ? 1000 : 10000000, [&](uint64_t i)
+		{
+			auto lut = cache.Acquire(payloads[i % kSources]);
+			EGAVBenchmark_DoNotOptimize(lut);
+		});
+
+		// The cached LUTs are the ones a synchronous build returns
+		for (int i = 0; i < kSources; i++)
+		{
+			HDRToneMapParams sourceParams = HDRToneMapParams::FromInfoFrame(payloads[i]);
+			auto reference = HDRToneMapLUTCache::Build(sourceParams);
+			ok = ok && built[i] && built[i]->key == reference->key && built[i]->lut3D == reference->lut3D;
+		}
+	}
+
+	// # Hit rate: 60 fps, the source switches between 6 info frames every 2 s (e.g. menus and clips)
+	for (size_t capacity : { 2, 4, 8 })
+	{
+		const int kSources = 6, kFramesPerSwitch = 120;
+		const int frames = quick ? 6 * kFramesPerSwitch : 600 * kFramesPerSwitch;
+		HDRToneMapLUTCache cache(capacity);
+		int withoutLUT = 0;
+		uint32_t state = 1;
+		int source = 0;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			if (frame % kFramesPerSwitch == 0)
+			{
+				state = state * 1664525u + 1013904223u;
+				source = (int)((state >> 16) % kSources);
+			}
+			if (!cache.Acquire(MakePayload((uint16_t)(400 + 200 * source))))
+			{
+				withoutLUT++;
+				cache.WaitForPendingBuilds(); // the build finishes within a frame interval
+			}
+		}
+		const double hitRate = 100.0 * (double)cache.GetHitCount() / (double)(cache.GetHitCount() + cache.GetMissCount());
+		const std::string name = "Hit rate, 6 sources, capacity " + std::to_string(capacity);
+		printf("%-48s %11.3f %%     (%d of %d frames without LUT)\n", name.c_str(), hitRate, withoutLUT, frames);
+		ok = ok && (int)cache.GetMissCount() == withoutLUT;
+	}
+
+	return ok ? 0 : 1;
+}
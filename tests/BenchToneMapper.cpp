@@ -0,0 +1,74 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		BenchToneMapper.cpp
+
+@brief		HDRToneMapper on a 4K P010 PQ frame (EGAVTestFrames.h): frames per
+			second and per core with the AVX2 and the scalar kernel, one thread
+			and one slice per CPU core
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "EGAVTestFrames.h"
+#include "HDRToneMapper.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+
+int main(int argc, char** argv)
+{
+	const bool quick = EGAVBenchmark_IsQuick(argc, argv);
+	const uint64_t frames = quick ? 2 : 60;
+	const int cores = std::max(1, (int)std::thread::hardware_concurrency());
+	const EGAVTestFrame frame = EGAVTest_MakeSceneFrame(EGAVTestTransfer::PQ, 203, true, 3840, 2160);
+
+	std::vector<uint8_t> y((size_t)frame.width * frame.height), uv((size_t)frame.width * (frame.height / 2));
+	std::vector<int> threadCounts = { 1 };
+	if (cores > 1)
+		threadCounts.push_back(cores);
+
+	bool ok = true;
+	for (bool simd : { true, false })
+	{
+		for (int threads : threadCounts)
+		{
+			HDRToneMapper mapper(threads);
+			mapper.SetSIMDEnabled(simd);
+			const std::string name = std::string("4K P010 -> NV12, ") + (simd ? "SIMD, " : "scalar, ") + std::to_string(threads) + " thread(s)";
+			const double ns = EGAVBenchmark_Run(name.c_str(), frames, [&](uint64_t)
+			{
+				ok = ok && mapper.Process(frame.GetY(), frame.GetStride(), frame.GetUV(), frame.GetStride(),
+										  y.data(), frame.width, uv.data(), frame.width, frame.width, frame.height).Succeeded();
+				EGAVBenchmark_DoNotOptimize(y);
+			});
+			printf("%-48s %12.1f frames/s, %.1f frames/s per core\n", "", 1e9 / ns, 1e9 / ns / threads);
+		}
+	}
+	return ok ? 0 : 1;
+}
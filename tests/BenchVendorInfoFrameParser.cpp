@@ -0,0 +1,96 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		BenchVendorInfoFrameParser.cpp
+
+@brief		Throughput of HDMIVendorInfoFrameParser for per-frame HDR10+ metadata
+**/
+//==============================================================================
+
+#include "EGAVBenchmark.h"
+#include "HDMIVendorInfoFrameParser.h"
+
+#include <vector>
+
+
+//! @brief HDR10+ info frame with the given average maxRGB (valid checksum)
+static HDMI_GENERIC_INFOFRAME MakeHDR10PlusFrame(uint8_t inAverageMaxRGB)
+{
+	HDMI_GENERIC_INFOFRAME frame{};
+	frame.header.bfType         = HDMI_INFOFRAME_TYPE_VS;
+	frame.header.bfVersion      = 1;
+	frame.header.bPayloadLength = 27;
+	const uint8_t payload[27] = { 0x8B, 0x84, 0x90, 0x54, inAverageMaxRGB, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0x95, 0x56, 0xAA, 10, 20, 30, 40, 50, 60, 70, 80, 90, 0x40 };
+	memcpy(frame.bPayload, payload, sizeof(payload));
+
+	uint8_t sum = 0;
+	for (size_t i = 0; i < sizeof(HDMI_INFOFRAMEHEADER) + 1 + sizeof(payload); i++)
+		sum = (uint8_t)(sum + ((const uint8_t*)&frame)[i]);
+	frame.bChecksum = (uint8_t)(0x100 - sum);
+	return frame;
+}
+
+int main(int argc, char** argv)
+{
+	const uint64_t iterations = EGAVBenchmark_IsQuick(argc, argv) ? 1000 : 2000000;
+
+	std::vector<HDMI_GENERIC_INFOFRAME> frames;
+	for (int i = 0; i < 256; i++)
+		frames.push_back(MakeHDR10PlusFrame((uint8_t)i));
+
+	const size_t frameSize = sizeof(HDMI_INFOFRAMEHEADER) + 1 + 27;
+	std::vector<uint8_t> stream;
+	for (const HDMI_GENERIC_INFOFRAME& frame : frames)
+		stream.insert(stream.end(), (const uint8_t*)&frame, (const uint8_t*)&frame + frameSize);
+
+	HDMIVendorInfoFrameParser parser;
+	EGAVBenchmark_Run("Parse() unchanged HDR10+ frame", iterations, [&](uint64_t)
+	{
+		EGAVBenchmark_DoNotOptimize(parser.Parse(frames[0]));
+	});
+	EGAVBenchmark_Run("Parse() changed HDR10+ frame", iterations, [&](uint64_t i)
+	{
+		EGAVBenchmark_DoNotOptimize(parser.Parse(frames[i & 0xFF]));
+	});
+	EGAVBenchmark_Run("HDMI_VS_Decode() HDR10+ frame", iterations, [&](uint64_t i)
+	{
+		HDMI_VS_INFO info;
+		EGAVBenchmark_DoNotOptimize(HDMI_VS_Decode(frames[i & 0xFF], info));
+	});
+
+	// Stream of changing frames, fed in 64 byte chunks (HID report size)
+	const uint64_t streamIterations = iterations / frames.size() + 1;
+	const double ns = EGAVBenchmark_Run("Feed() 256 frames in 64 byte chunks", streamIterations, [&](uint64_t)
+	{
+		for (size_t offset = 0; offset < stream.size(); offset += 64)
+			parser.Feed(stream.data() + offset, std::min<size_t>(64, stream.size() - offset));
+	});
+	printf("%-48s %12.1f MB/s\n", "Feed() throughput", (double)stream.size() * 1000.0 / ns);
+
+	const HDMIVendorInfoFrameParser::Statistics& stats = parser.GetStatistics();
+	return (stats.framesInvalid == 0 && stats.bytesSkipped == 0) ? 0 : 1;
+}
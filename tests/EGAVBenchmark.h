@@ -0,0 +1,83 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		EGAVBenchmark.h
+
+@brief		Minimal benchmark helpers (no dependencies)
+
+			Benchmarks are plain executables. ctest runs them with --quick (few
+			iterations) so they keep building and working; run them without
+			arguments for meaningful numbers.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+
+//! @brief true if the benchmark was started with --quick (ctest smoke run)
+inline bool EGAVBenchmark_IsQuick(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+		if (strcmp(argv[i], "--quick") == 0)
+			return true;
+	return false;
+}
+
+inline uint64_t EGAVBenchmark_GetTimeNs()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//! @brief Runs inFunction inIterations times and prints the time per iteration
+//! @return nanoseconds per iteration
+template <typename Function>
+double EGAVBenchmark_Run(const char* inName, uint64_t inIterations, Function&& inFunction)
+{
+	const uint64_t start = EGAVBenchmark_GetTimeNs();
+	for (uint64_t i = 0; i < inIterations; i++)
+		inFunction(i);
+	const double nsPerIteration = (double)(EGAVBenchmark_GetTimeNs() - start) / (double)(inIterations ? inIterations : 1);
+	printf("%-48s %12.1f ns/op  (%llu iterations)\n", inName, nsPerIteration, (unsigned long long)inIterations);
+	return nsPerIteration;
+}
+
+//! @brief Keeps the optimizer from removing a computed value
+template <typename T>
+inline void EGAVBenchmark_DoNotOptimize(const T& inValue)
+{
+#if defined(__GNUC__)
+	asm volatile("" : : "g"(&inValue) : "memory");
+#else
+	static volatile const void* sink;
+	sink = &inValue;
+#endif
+}
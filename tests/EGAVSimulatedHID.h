@@ -0,0 +1,235 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		EGAVSimulatedHID.h
+
+@brief		Simulated capture device behind EGAVHIDInterface (tests)
+
+			Implements the I2C-over-HID reports of both protocols (see
+			ElgatoUVCProtocol.h) on a register file per I2C address, with the
+			report framing of the platform implementations: ReadHID() returns the
+			whole input report, report ID first. Counts the HID transfers and I2C
+			transactions, can fail transfers and call a hook before each read
+			(e.g. to change registers during a block read).
+**/
+//==============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "EGAVHID.h"
+#include "ElgatoUVCProtocol.h"
+#include "HDMIInfoFramesAPI.h"
+
+
+//! @brief Info frame with a valid checksum
+inline HDMI_GENERIC_INFOFRAME EGAVTest_MakeInfoFrame(uint8_t inType, uint8_t inVersion, const std::vector<uint8_t>& inPayload)
+{
+	HDMI_GENERIC_INFOFRAME frame{};
+	frame.header.bfType         = inType;
+	frame.header.bfVersion      = inVersion;
+	frame.header.bPayloadLength = (uint8_t)std::min(inPayload.size(), sizeof(frame.bPayload));
+	memcpy(frame.bPayload, inPayload.data(), frame.header.bPayloadLength);
+
+	uint8_t sum = 0;
+	const uint8_t* bytes = (const uint8_t*)&frame;
+	for (size_t i = 0; i < sizeof(HDMI_INFOFRAMEHEADER) + 1 + frame.header.bPayloadLength; i++)
+		sum += bytes[i];
+	frame.bChecksum = (uint8_t)(0x100 - sum);
+	return frame;
+}
+
+
+class EGAVSimulatedHID : public EGAVHIDInterface
+{
+public:
+	static const size_t kInputReportSize = 64;
+
+	struct Transaction
+	{
+		bool		isRead;
+		uint8_t		address;
+		uint8_t		reg;
+		uint8_t		length;
+	};
+
+	explicit EGAVSimulatedHID(bool inNewProtocol) : mNewProtocol(inNewProtocol) {}
+
+	//-----------------------------------------------------------------------------
+	// ## EGAVHIDInterface implementation
+	//-----------------------------------------------------------------------------
+	EGAVResult InitHIDInterface(const EGAVDeviceID& /*inDeviceID*/) override { return EGAVResult::Ok; }
+	EGAVResult DeinitHIDInterface() override { return EGAVResult::Ok; }
+
+	EGAVResult ReadHID(std::vector<uint8_t>& outMessage, int inReportID, int /*inReadBufferSize = 0*/) override
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mHIDReads++;
+		if (ConsumeFailure())
+			return EGAVResult::ErrInvalidOperation;
+
+		const int responseID = mNewProtocol ? NewProtocol::kReadResponseReportID : LegacyProtocol::kReadResponseReportID;
+		if (inReportID != responseID || !mReadPending)
+			return EGAVResult::ErrInvalidOperation;
+		mReadPending = false;
+
+		if (mOnRead)
+		{
+			// The hook may change registers
+			const auto hook = mOnRead;
+			lock.unlock();
+			hook(mPendingAddress, mPendingRegister, mPendingLength);
+			lock.lock();
+		}
+
+		// Report ID, then the registers (auto-incrementing address), padded to the report size
+		const auto& regs = mRegisters[mPendingAddress];
+		outMessage.assign(kInputReportSize, 0);
+		outMessage[0] = (uint8_t)inReportID;
+		for (size_t i = 0; i < mPendingLength && 1 + i < kInputReportSize; i++)
+			outMessage[1 + i] = regs[(mPendingRegister + i) & 0xFF];
+		return EGAVResult::Ok;
+	}
+
+	EGAVResult WriteHID(const std::vector<uint8_t>& inMessage, int inReportID) override
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mHIDWrites++;
+		if (ConsumeFailure())
+			return EGAVResult::ErrInvalidOperation;
+		return mNewProtocol ? WriteNew(inMessage, inReportID) : WriteLegacy(inMessage, inReportID);
+	}
+
+	//-----------------------------------------------------------------------------
+	// ## Simulation
+	//-----------------------------------------------------------------------------
+	void SetRegisters(uint8_t inAddress, uint8_t inRegister, const void* inData, size_t inLength)
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		for (size_t i = 0; i < inLength; i++)
+			mRegisters[inAddress][(inRegister + i) & 0xFF] = ((const uint8_t*)inData)[i];
+	}
+
+	uint8_t GetRegister(uint8_t inAddress, uint8_t inRegister)
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		return mRegisters[inAddress][inRegister];
+	}
+
+	//! @brief Fails the next inCount HID transfers with ErrInvalidOperation
+	void FailNextTransfers(int inCount) { const std::lock_guard<std::mutex> lock(mMutex); mFailures = inCount; }
+
+	//! @brief Called (without the lock) before a read response is built
+	void SetReadHook(std::function<void(uint8_t inAddress, uint8_t inRegister, uint8_t inLength)> inHook)
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mOnRead = std::move(inHook);
+	}
+
+	//! @brief Completed I2C transactions in order (a read counts when its request was written)
+	std::vector<Transaction> GetTransactions() { const std::lock_guard<std::mutex> lock(mMutex); return mTransactions; }
+	size_t GetHIDWriteCount() { const std::lock_guard<std::mutex> lock(mMutex); return mHIDWrites; }
+	size_t GetHIDReadCount() { const std::lock_guard<std::mutex> lock(mMutex); return mHIDReads; }
+
+	void ResetCounters()
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mTransactions.clear();
+		mHIDWrites = mHIDReads = 0;
+	}
+
+private:
+	bool ConsumeFailure()
+	{
+		if (mFailures <= 0)
+			return false;
+		mFailures--;
+		return true;
+	}
+
+	//! @brief [report length, case, address, write length, register, read length | data...]
+	EGAVResult WriteNew(const std::vector<uint8_t>& inMessage, int inReportID)
+	{
+		if (inReportID != NewProtocol::kWriteReportID || inMessage.size() < 5 || inMessage[3] < 1)
+			return EGAVResult::ErrInvalidParameter;
+		const uint8_t reportCase = inMessage[1], address = inMessage[2], reg = inMessage[4];
+		if (reportCase == (uint8_t)NewProtocol::REPORT_CASE_NEW::REPORT_IIC_READ && inMessage.size() >= 6)
+			return StartRead(address, reg, inMessage[5]);
+		if (reportCase != (uint8_t)NewProtocol::REPORT_CASE_NEW::REPORT_IIC_WRITE || inMessage.size() < 4u + inMessage[3])
+			return EGAVResult::ErrInvalidParameter;
+		return Write(address, reg, inMessage.data() + 5, inMessage[3] - 1);
+	}
+
+	//! @brief Read request [address, register, length], write [address, register, length, data...]
+	EGAVResult WriteLegacy(const std::vector<uint8_t>& inMessage, int inReportID)
+	{
+		if (inMessage.size() < 3)
+			return EGAVResult::ErrInvalidParameter;
+		if (inReportID == LegacyProtocol::kReadRequestReportID)
+			return StartRead(inMessage[0], inMessage[1], inMessage[2]);
+		if (inReportID != LegacyProtocol::kWriteReportID || inMessage.size() < 3u + inMessage[2])
+			return EGAVResult::ErrInvalidParameter;
+		return Write(inMessage[0], inMessage[1], inMessage.data() + 3, inMessage[2]);
+	}
+
+	EGAVResult StartRead(uint8_t inAddress, uint8_t inRegister, uint8_t inLength)
+	{
+		mReadPending     = true;
+		mPendingAddress  = inAddress;
+		mPendingRegister = inRegister;
+		mPendingLength   = inLength;
+		mTransactions.push_back({ true, inAddress, inRegister, inLength });
+		return EGAVResult::Ok;
+	}
+
+	EGAVResult Write(uint8_t inAddress, uint8_t inRegister, const uint8_t* inData, size_t inLength)
+	{
+		for (size_t i = 0; i < inLength; i++)
+			mRegisters[inAddress][(inRegister + i) & 0xFF] = inData[i];
+		mTransactions.push_back({ false, inAddress, inRegister, (uint8_t)inLength });
+		return EGAVResult::Ok;
+	}
+
+	const bool							mNewProtocol;
+	std::mutex							mMutex;
+	std::array<std::array<uint8_t, 256>, 128> mRegisters{};	//!< 7 bit I2C addresses
+	bool								mReadPending		= false;
+	uint8_t								mPendingAddress		= 0;
+	uint8_t								mPendingRegister	= 0;
+	uint8_t								mPendingLength		= 0;
+	int									mFailures			= 0;
+	std::function<void(uint8_t, uint8_t, uint8_t)> mOnRead;
+	std::vector<Transaction>			mTransactions;
+	size_t								mHIDWrites			= 0;
+	size_t								mHIDReads			= 0;
+};
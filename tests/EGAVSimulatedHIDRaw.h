@@ -0,0 +1,231 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		EGAVSimulatedHIDRaw.h
+
+@brief		Simulated hidraw device on a socketpair (Linux benchmarks)
+
+			A device thread answers the NewProtocol output reports on one end of a
+			SOCK_SEQPACKET socketpair; the transport on the other end implements
+			EGAVHIDRawTransport (GET_REPORT reads the answer). The fd can be polled
+			and written like a hidraw node, so EGAVReactor and the io_uring backend
+			run unchanged. EGAVSocketPairHID puts the transport behind
+			EGAVHIDInterface for the blocking ElgatoUVCDevice path.
+
+			The numbers measured with it are library and socket overhead only. On
+			hidraw every output report and GET_REPORT is a USB control transfer
+			(hundreds of microseconds), which dominates and isn't represented here.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "EGAVHID.h"
+#include "EGAVHIDRawDevice.h"
+#include "ElgatoUVCProtocol.h"
+
+
+//! @brief Host end of the socketpair
+class EGAVSocketPairTransport : public EGAVHIDRawTransport
+{
+public:
+	static const size_t kReportSize = 64;
+
+	explicit EGAVSocketPairTransport(int inFD) : mFD(inFD) {}
+	~EGAVSocketPairTransport() { close(mFD); }
+
+	int GetFD() const override { return mFD; }
+	size_t GetOutputReportSize() const override { return kReportSize; }
+	size_t GetInputReportSize(uint8_t /*inReportID*/) const override { return kReportSize; }
+
+	EGAVResult WriteReport(const uint8_t* inReport, size_t inSize) override
+	{
+		// Padded like EGAVHIDRawDevice::WriteReport()
+		uint8_t report[kReportSize] = {};
+		if (inSize < kReportSize)
+		{
+			memcpy(report, inReport, inSize);
+			inReport = report;
+			inSize   = kReportSize;
+		}
+		return write(mFD, inReport, inSize) == (ssize_t)inSize ? EGAVResult::Ok : EGAVResult::ErrUnknown;
+	}
+
+	EGAVResult GetInputReport(uint8_t* ioReport, size_t inBufferSize, size_t& outSize) override
+	{
+		pollfd pfd = { mFD, POLLIN, 0 };
+		if (poll(&pfd, 1, 100) <= 0)
+			return EGAVResult::ErrTimeOut;
+		const ssize_t size = read(mFD, ioReport, inBufferSize);
+		if (size <= 0)
+			return EGAVResult::ErrUnknown;
+		outSize = (size_t)size;
+		return EGAVResult::Ok;
+	}
+
+	size_t DrainInput() override
+	{
+		uint8_t report[kReportSize];
+		size_t count = 0;
+		while (recv(mFD, report, sizeof(report), MSG_DONTWAIT) > 0)
+			count++;
+		return count;
+	}
+
+private:
+	const int mFD;
+};
+
+
+//! @brief EGAVHIDInterface on a transport, same report handling as the Linux EGAVHID (hidraw)
+class EGAVSocketPairHID : public EGAVHIDInterface
+{
+public:
+	explicit EGAVSocketPairHID(std::unique_ptr<EGAVHIDRawTransport> inTransport) : mTransport(std::move(inTransport)) {}
+
+	EGAVResult InitHIDInterface(const EGAVDeviceID& /*inDeviceID*/) override { return mTransport ? EGAVResult::Ok : EGAVResult::ErrNotFound; }
+	EGAVResult DeinitHIDInterface() override { return EGAVResult::Ok; }
+
+	EGAVResult ReadHID(std::vector<uint8_t>& outMessage, int inReportID, int inReadBufferSize = 0) override
+	{
+		const size_t bufferSize = (inReadBufferSize > 0) ? (size_t)inReadBufferSize : mTransport->GetInputReportSize((uint8_t)inReportID);
+		mReport.assign(std::max<size_t>(bufferSize, 2), 0);
+		mReport[0] = (uint8_t)inReportID;
+
+		size_t size = 0;
+		EGAVResult res = mTransport->GetInputReport(mReport.data(), mReport.size(), size);
+		if (res.Succeeded())
+			outMessage.assign(mReport.begin(), mReport.begin() + size);
+		return res;
+	}
+
+	EGAVResult WriteHID(const std::vector<uint8_t>& inMessage, int inReportID) override
+	{
+		mReport.assign(1, (uint8_t)inReportID);
+		mReport.insert(mReport.end(), inMessage.begin(), inMessage.end());
+		return mTransport->WriteReport(mReport.data(), mReport.size());
+	}
+
+private:
+	std::unique_ptr<EGAVHIDRawTransport>	mTransport;
+	std::vector<uint8_t>					mReport;
+};
+
+
+//! @brief Device end: registers of one I2C address, answered by a thread
+class EGAVSimulatedHIDRawDevice
+{
+public:
+	//! @param inSeed register i starts as i ^ inSeed
+	explicit EGAVSimulatedHIDRawDevice(uint8_t inSeed)
+	{
+		for (int i = 0; i < 256; i++)
+			mRegisters[i] = (uint8_t)(i ^ inSeed);
+		if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK, 0, mFDs) == 0)
+			mThread = std::thread(&EGAVSimulatedHIDRawDevice::Run, this);
+	}
+
+	~EGAVSimulatedHIDRawDevice()
+	{
+		mStop = true;
+		if (mThread.joinable())
+			mThread.join();
+		if (mFDs[1] >= 0)
+			close(mFDs[1]);
+		if (mFDs[0] >= 0 && !mTransportTaken)
+			close(mFDs[0]);
+	}
+
+	//! @return the host end (once); nullptr if the socketpair couldn't be created
+	std::unique_ptr<EGAVHIDRawTransport> TakeTransport()
+	{
+		if (mFDs[0] < 0 || mTransportTaken)
+			return nullptr;
+		mTransportTaken = true;
+		return std::make_unique<EGAVSocketPairTransport>(mFDs[0]);
+	}
+
+	//! @brief CPU time of the device thread, so benchmarks can leave it out of the process CPU time
+	uint64_t GetThreadCPUTimeNs()
+	{
+		clockid_t clock;
+		timespec time;
+		if (!mThread.joinable() || pthread_getcpuclockid(mThread.native_handle(), &clock) != 0 || clock_gettime(clock, &time) != 0)
+			return 0;
+		return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+	}
+
+private:
+	//! @brief [report ID, report length, case, address, write length, register, read length | data...]
+	void Run()
+	{
+		while (!mStop)
+		{
+			pollfd pfd = { mFDs[1], POLLIN, 0 };
+			if (poll(&pfd, 1, 20) <= 0)
+				continue;
+			uint8_t report[EGAVSocketPairTransport::kReportSize];
+			const ssize_t size = read(mFDs[1], report, sizeof(report));
+			if (size < 7 || report[0] != NewProtocol::kWriteReportID)
+				continue;
+
+			const uint8_t reg = report[5];
+			if (report[2] == (uint8_t)NewProtocol::REPORT_CASE_NEW::REPORT_IIC_READ)
+			{
+				const uint8_t length = std::min<uint8_t>(report[6], EGAVSocketPairTransport::kReportSize - 1);
+				uint8_t response[EGAVSocketPairTransport::kReportSize] = { (uint8_t)NewProtocol::kReadResponseReportID };
+				for (uint8_t i = 0; i < length; i++)
+					response[1 + i] = mRegisters[(uint8_t)(reg + i)];
+				(void)!write(mFDs[1], response, 1 + length);
+			}
+			else if (report[4] >= 1)
+			{
+				for (size_t i = 0; i + 1 < report[4] && 6 + i < (size_t)size; i++)
+					mRegisters[(uint8_t)(reg + i)] = report[6 + i];
+			}
+		}
+	}
+
+	int					mFDs[2]			= { -1, -1 };
+	bool				mTransportTaken	= false;
+	std::atomic<bool>	mStop{false};
+	std::thread			mThread;
+	uint8_t				mRegisters[256];
+};
@@ -0,0 +1,139 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		EGAVTest.h
+
+@brief		Minimal test harness (no dependencies)
+
+			EGAV_TEST(name) registers a test; the EGAV_CHECK macros count failures
+			and continue. EGAV_TEST_MAIN() runs all tests (or those whose name
+			contains argv[1]) and returns the number of failures, as ctest expects.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+
+//==============================================================================
+// # Class EGAVTestRegistry
+//==============================================================================
+
+class EGAVTestRegistry
+{
+public:
+	typedef void (*TestFunction)();
+
+	static bool Register(const char* inName, TestFunction inFunction)
+	{
+		GetTests().push_back({ inName, inFunction });
+		return true;
+	}
+
+	static void Fail(const char* inFile, int inLine, const std::string& inMessage)
+	{
+		fprintf(stderr, "%s:%d: FAILED: %s\n", inFile, inLine, inMessage.c_str());
+		GetFailures()++;
+	}
+
+	static int RunAll(int argc, char** argv)
+	{
+		const char* filter = (argc > 1) ? argv[1] : nullptr;
+		int failedTests = 0;
+		for (const Test& test : GetTests())
+		{
+			if (filter && !strstr(test.name, filter))
+				continue;
+			const int failuresBefore = GetFailures();
+			const auto start = std::chrono::steady_clock::now();
+			test.function();
+			const long long ms = (long long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+			const bool failed = GetFailures() != failuresBefore;
+			printf("[%s] %s (%lld ms)\n", failed ? "FAILED" : "  OK  ", test.name, ms);
+			if (failed)
+				failedTests++;
+		}
+		return failedTests;
+	}
+
+private:
+	struct Test
+	{
+		const char*		name;
+		TestFunction	function;
+	};
+
+	static std::vector<Test>& GetTests() { static std::vector<Test> tests; return tests; }
+	static int& GetFailures() { static int failures = 0; return failures; }
+};
+
+
+//! @brief Path of a file in the temp directory, removed if it exists
+inline std::string EGAVTest_GetTempPath(const std::string& inName)
+{
+	std::error_code error;
+	const std::filesystem::path path = std::filesystem::temp_directory_path(error) / ("egav_test_" + inName);
+	std::filesystem::remove(path, error);
+	return path.string();
+}
+
+
+//==============================================================================
+// # Macros
+//==============================================================================
+
+#define EGAV_TEST(name) \
+	static void name(); \
+	static const bool name##Registered = EGAVTestRegistry::Register(#name, name); \
+	static void name()
+
+#define EGAV_CHECK(condition) \
+	do { if (!(condition)) EGAVTestRegistry::Fail(__FILE__, __LINE__, #condition); } while (0)
+
+#define EGAV_CHECK_EQUAL(actual, expected) \
+	do { \
+		const auto egavActual = (actual); const auto egavExpected = (expected); \
+		if (!(egavActual == egavExpected)) \
+			EGAVTestRegistry::Fail(__FILE__, __LINE__, std::string(#actual " == " #expected " (") + \
+								   std::to_string((long long)egavActual) + " != " + std::to_string((long long)egavExpected) + ")"); \
+	} while (0)
+
+#define EGAV_CHECK_RESULT(result, code) \
+	do { \
+		const EGAVResult egavResult = (result); \
+		if (egavResult.GetResultCode() != (code)) \
+			EGAVTestRegistry::Fail(__FILE__, __LINE__, std::string(#result ": ") + egavResult.GetResultCodeString()); \
+	} while (0)
+
+#define EGAV_TEST_MAIN() \
+	int main(int argc, char** argv) { return EGAVTestRegistry::RunAll(argc, argv); }
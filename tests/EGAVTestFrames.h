@@ -0,0 +1,161 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		EGAVTestFrames.h
+
+@brief		Synthetic video frames for the frame processing tests and benchmarks
+
+			A scene is a deterministic mix of luminances relative to diffuse white
+			(1.0): shadows and mid tones log-uniform over 2.5 decades, optional
+			specular highlights up to 5x diffuse white, and black bars (top and
+			bottom 1/8 of the rows). It is encoded with SDR gamma (BT.1886 inverse),
+			PQ (ST 2084) or HLG into 10 bit limited range P010. Chroma is random
+			around neutral.
+**/
+//==============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+
+//! @brief Deterministic pseudo random numbers (LCG), identical on all platforms
+class EGAVTestRandom
+{
+public:
+	explicit EGAVTestRandom(uint32_t inSeed) : mState(inSeed * 2654435761u + 1) {}
+
+	uint32_t Next() { mState = mState * 1664525u + 1013904223u; return mState >> 8; }
+	//! @return [0, 1)
+	double NextUnit() { return (double)Next() / (double)(1u << 24); }
+
+private:
+	uint32_t	mState;
+};
+
+
+//------------------------------------------------------------------------------
+// Transfer functions: linear light --> signal 0..1
+//------------------------------------------------------------------------------
+
+//! @param inNits display light in cd/m2
+inline double EGAVTest_PQ(double inNits)
+{
+	const double m1 = 2610.0 / 16384, m2 = 2523.0 / 4096 * 128;
+	const double c1 = 3424.0 / 4096, c2 = 2413.0 / 4096 * 32, c3 = 2392.0 / 4096 * 32;
+	const double y = std::pow(std::max(inNits, 0.0) / 10000.0, m1);
+	return std::pow((c1 + c2 * y) / (1 + c3 * y), m2);
+}
+
+//! @param inRelative display light, 1.0 = SDR peak white
+inline double EGAVTest_SDRGamma(double inRelative)
+{
+	return std::pow(std::min(std::max(inRelative, 0.0), 1.0), 1 / 2.4);
+}
+
+//! @param inScene scene light 0..1 (BT.2100 HLG OETF)
+inline double EGAVTest_HLG(double inScene)
+{
+	const double a = 0.17883277, b = 1 - 4 * a, c = 0.5 - a * std::log(4 * a);
+	const double e = std::min(std::max(inScene, 0.0), 1.0);
+	return (e <= 1.0 / 12) ? std::sqrt(3 * e) : a * std::log(12 * e - b) + c;
+}
+
+//! @return 10 bit limited range code
+inline uint16_t EGAVTest_LimitedCode(double inSignal)
+{
+	return (uint16_t)std::lround(64 + std::min(std::max(inSignal, 0.0), 1.0) * 876);
+}
+
+
+//==============================================================================
+// # Frames
+//==============================================================================
+
+enum class EGAVTestTransfer
+{
+	SDR,	//!< white: exposure (1.0: diffuse white at peak white)
+	PQ,		//!< white: diffuse white in cd/m2
+	HLG,	//!< white: ignored (reference white at 75 % signal)
+};
+
+//! @brief P010 frame: 16 bit samples with the 10 bit code in the upper bits
+struct EGAVTestFrame
+{
+	int						width	= 0;
+	int						height	= 0;
+	std::vector<uint16_t>	y;		//!< width x height
+	std::vector<uint16_t>	uv;		//!< interleaved U V, width x height / 2
+
+	const uint8_t* GetY() const { return (const uint8_t*)y.data(); }
+	const uint8_t* GetUV() const { return (const uint8_t*)uv.data(); }
+	int GetStride() const { return width * 2; }		//!< bytes, both planes
+};
+
+//! @brief Relative scene luminance of one pixel (see file comment); 0 in the black bars
+inline double EGAVTest_SceneLuminance(EGAVTestRandom& ioRandom, bool inHighlights)
+{
+	const double r = ioRandom.NextUnit();
+	if (inHighlights && r < 0.067)
+		return std::pow(10.0, ioRandom.NextUnit() * 0.7);
+	return std::pow(10.0, -2.5 + ioRandom.NextUnit() * 2.5);
+}
+
+inline EGAVTestFrame EGAVTest_MakeSceneFrame(EGAVTestTransfer inTransfer, double inWhite, bool inHighlights, int inWidth, int inHeight, uint32_t inSeed = 1)
+{
+	EGAVTestFrame frame;
+	frame.width  = inWidth;
+	frame.height = inHeight;
+	frame.y.resize((size_t)inWidth * inHeight);
+	frame.uv.resize((size_t)inWidth * (inHeight / 2));
+
+	EGAVTestRandom random(inSeed);
+	const int bar = inHeight / 8;
+	for (int row = 0; row < inHeight; row++)
+	{
+		for (int column = 0; column < inWidth; column++)
+		{
+			double signal = 0;
+			if (row >= bar && row < inHeight - bar)
+			{
+				const double light = EGAVTest_SceneLuminance(random, inHighlights);
+				switch (inTransfer)
+				{
+					case EGAVTestTransfer::SDR:	signal = EGAVTest_SDRGamma(light * inWhite); break;
+					case EGAVTestTransfer::PQ:	signal = EGAVTest_PQ(light * inWhite); break;
+					case EGAVTestTransfer::HLG:	signal = EGAVTest_HLG(light * 0.26); break;
+				}
+			}
+			frame.y[(size_t)row * inWidth + column] = (uint16_t)(EGAVTest_LimitedCode(signal) << 6);
+		}
+	}
+	for (uint16_t& sample : frame.uv)
+		sample = (uint16_t)((412 + random.Next() % 201) << 6);
+	return frame;
+}
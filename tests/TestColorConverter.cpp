@@ -0,0 +1,211 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		TestColorConverter.cpp
+
+@brief		EGAVColorConverter: every AVX2 kernel bit exact against its scalar
+			kernel, reference colors, and kernel selection from the AVI info frame
+
+			The kernels use the same fixed point arithmetic (Q13 coefficients,
+			_mm256_mulhrs_epi16 rounding), so they must match exactly, not within
+			a tolerance.
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "EGAVTestFrames.h"
+#include "EGAVColorConverter.h"
+
+#include <cstdlib>
+
+
+static const EGAVColorMatrix kMatrices[] = { EGAVColorMatrix::BT601, EGAVColorMatrix::BT709, EGAVColorMatrix::BT2020 };
+
+//! @brief 4:2:0 input: luma and chroma rows with the same byte layout (chroma row i belongs to luma rows 2i, 2i + 1)
+struct TestImage
+{
+	int						width	= 0;
+	int						rows	= 0;
+	int						stride	= 0;	//!< bytes, luma and chroma
+	std::vector<uint8_t>	y;
+	std::vector<uint8_t>	uv;
+};
+
+//! @brief NV12 with every (Cb, Cr) pair once (chroma row = Cr, pair = Cb) and luma sweeping all codes
+static TestImage MakeNV12SweepImage()
+{
+	TestImage image;
+	image.width  = 512;
+	image.rows   = 256;
+	image.stride = image.width;
+	image.y.resize((size_t)image.stride * image.rows);
+	image.uv.resize((size_t)image.stride * image.rows);
+	for (int row = 0; row < image.rows; row++)
+	{
+		for (int x = 0; x < image.width; x++)
+			image.y[(size_t)row * image.stride + x] = (uint8_t)(x + 7 * row);
+		for (int pair = 0; pair < image.width / 2; pair++)
+		{
+			image.uv[(size_t)row * image.stride + 2 * pair]     = (uint8_t)pair;
+			image.uv[(size_t)row * image.stride + 2 * pair + 1] = (uint8_t)row;
+		}
+	}
+	return image;
+}
+
+//! @brief P010 with random 16 bit words: valid codes and ones with the low 6 bits set (sloppy sources)
+static TestImage MakeP010RandomImage(int inWidth, int inRows, uint32_t inSeed)
+{
+	TestImage image;
+	image.width  = inWidth;
+	image.rows   = inRows;
+	image.stride = inWidth * 2;
+	image.y.resize((size_t)image.stride * image.rows);
+	image.uv.resize((size_t)image.stride * image.rows);
+	EGAVTestRandom random(inSeed);
+	for (size_t i = 0; i < image.y.size(); i += 2)
+	{
+		const uint16_t y  = (uint16_t)((i & 2) ? random.Next() : (random.Next() % 1024) << 6);
+		const uint16_t uv = (uint16_t)((i & 2) ? random.Next() : (random.Next() % 1024) << 6);
+		memcpy(&image.y[i], &y, 2);
+		memcpy(&image.uv[i], &uv, 2);
+	}
+	return image;
+}
+
+//! @brief Converts all rows with one kernel; inWidth may be less than the image width (SIMD tails)
+static std::vector<uint8_t> ConvertRows(EGAVColorConverter::RowKernel inKernel, const TestImage& inImage, int inWidth)
+{
+	std::vector<uint8_t> bgra((size_t)inWidth * 4 * inImage.rows);
+	for (int row = 0; row < inImage.rows; row++)
+		inKernel(&inImage.y[(size_t)row * inImage.stride], &inImage.uv[(size_t)row * inImage.stride], &bgra[(size_t)row * inWidth * 4], inWidth);
+	return bgra;
+}
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(SIMDKernelsAreBitExact)
+{
+	const TestImage nv12 = MakeNV12SweepImage();
+	const TestImage p010 = MakeP010RandomImage(512, 256, 1);
+
+	for (EGAVColorMatrix matrix : kMatrices)
+	{
+		for (bool fullRange : { false, true })
+		{
+			for (bool isP010 : { false, true })
+			{
+				EGAVColorFormat format;
+				format.matrix    = matrix;
+				format.fullRange = fullRange;
+				const EGAVColorConverter::RowKernel simd   = EGAVColorConverter::GetKernel(format, isP010, true);
+				const EGAVColorConverter::RowKernel scalar = EGAVColorConverter::GetKernel(format, isP010, false);
+
+				// 512: SIMD only, 510 and 498: scalar tails of 14 and 2 pixels, 2: scalar only
+				for (int width : { 512, 510, 498, 2 })
+				{
+					const TestImage& image = isP010 ? p010 : nv12;
+					const bool equal = ConvertRows(simd, image, width) == ConvertRows(scalar, image, width);
+					if (!equal)
+						fprintf(stderr, "matrix %d, %s range, %s, width %d\n", (int)matrix, fullRange ? "full" : "limited", isP010 ? "P010" : "NV12", width);
+					EGAV_CHECK(equal);
+				}
+			}
+		}
+	}
+}
+
+EGAV_TEST(ReferenceColors)
+{
+	// BT.709 limited range: 100 % white and black, 75 % color bars (ITU-R BT.709 codes), BGRA within 2 codes
+	struct Color
+	{
+		uint8_t		y, cb, cr;
+		uint8_t		b, g, r;
+	};
+	const Color colors[] =
+	{
+		{ 235, 128, 128,	255, 255, 255 },
+		{  16, 128, 128,	  0,   0,   0 },
+		{ 180, 128, 128,	191, 191, 191 },
+		{ 168,  44, 136,	  0, 191, 191 },	// yellow
+		{ 145, 147,  44,	191, 191,   0 },	// cyan
+		{ 133,  63,  52,	  0, 191,   0 },	// green
+		{  63, 193, 204,	191,   0, 191 },	// magenta
+		{  51, 109, 212,	  0,   0, 191 },	// red
+		{  28, 212, 120,	191,   0,   0 },	// blue
+	};
+
+	for (bool simd : { true, false })
+	{
+		EGAVColorConverter converter;
+		converter.SetColorFormat(EGAVColorFormat{ EGAVColorMatrix::BT709, false });
+		converter.SetSIMDEnabled(simd);
+		for (const Color& color : colors)
+		{
+			// 32 x 2 pixels of one color: the SIMD kernel processes 16 at a time
+			std::vector<uint8_t> y(32 * 2, color.y), uv(32), bgra(32 * 4 * 2);
+			for (int i = 0; i < 32; i += 2)
+			{
+				uv[i]     = color.cb;
+				uv[i + 1] = color.cr;
+			}
+			EGAV_CHECK_RESULT(converter.ConvertNV12(y.data(), 32, uv.data(), 32, bgra.data(), 32 * 4, 32, 2), EGAVResult::Ok);
+			for (int pixel = 0; pixel < 64; pixel++)
+			{
+				const uint8_t* p = &bgra[(size_t)pixel * 4];
+				EGAV_CHECK(std::abs(p[0] - color.b) <= 2 && std::abs(p[1] - color.g) <= 2 && std::abs(p[2] - color.r) <= 2);
+				EGAV_CHECK_EQUAL(p[3], 0xFF);
+			}
+		}
+	}
+}
+
+EGAV_TEST(InfoFrameSelectsKernels)
+{
+	EGAVColorConverter converter;
+
+	// No info frame: CEA-861 default by height
+	EGAV_CHECK(converter.UpdateInfoFrame(nullptr, 480));
+	EGAV_CHECK(converter.GetColorFormat() == (EGAVColorFormat{ EGAVColorMatrix::BT601, false }));
+	EGAV_CHECK(!converter.UpdateInfoFrame(nullptr, 480));
+	EGAV_CHECK(converter.UpdateInfoFrame(nullptr, 1080));
+	EGAV_CHECK(converter.GetColorFormat() == (EGAVColorFormat{ EGAVColorMatrix::BT709, false }));
+
+	// AVI version 2, byte 2: C = extended, byte 3: EC = BT.2020 YCC, byte 5: YQ = full
+	const HDMI_GENERIC_INFOFRAME bt2020 = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_AVI, 2,
+		{ 0x40, (uint8_t)(HDMI_AVI_C_EXTENDED << 6), (uint8_t)(HDMI_AVI_EC_BT2020 << 4), 97, (uint8_t)(HDMI_AVI_YQ_FULL << 6), 0, 0, 0, 0, 0, 0, 0, 0 });
+	EGAV_CHECK(converter.UpdateInfoFrame(&bt2020, 2160));
+	EGAV_CHECK(converter.GetColorFormat() == (EGAVColorFormat{ EGAVColorMatrix::BT2020, true }));
+	EGAV_CHECK(!converter.UpdateInfoFrame(&bt2020, 2160));
+}
+
+
+EGAV_TEST_MAIN()
@@ -0,0 +1,198 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		TestContentClassifier.cpp
+
+@brief		HDRContentClassifier: SIMD histogram against the scalar kernel, the
+			synthetic corpus (EGAVTestFrames.h) and HDR_CombineDecision()
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "EGAVTestFrames.h"
+#include "HDRContentClassifier.h"
+
+
+//! @brief Classification of a single frame, as the smoothed estimate after some identical frames
+static HDRContentKind ClassifyFrame(const EGAVTestFrame& inFrame, HDRContentEstimate* outSmoothed = nullptr)
+{
+	HDRContentClassifier classifier;
+	HDRLumaHistogram histogram;
+	classifier.ComputeHistogram(inFrame.GetY(), inFrame.GetStride(), inFrame.width, inFrame.height, histogram);
+	if (outSmoothed)
+	{
+		for (int i = 0; i < 60; i++)
+			*outSmoothed = classifier.AddFrame(inFrame.GetY(), inFrame.GetStride(), inFrame.width, inFrame.height);
+	}
+	return HDRContentClassifier::Classify(histogram).kind;
+}
+
+static const HDRContentEstimate kConfidentPQ	= { HDRContentKind::PQ, 0.9f };
+static const HDRContentEstimate kConfidentSDR	= { HDRContentKind::SDR, 0.9f };
+static const HDRContentEstimate kNoEstimate		= { HDRContentKind::Unknown, 0.f };
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(SIMDHistogramMatchesScalar)
+{
+	std::vector<EGAVTestFrame> frames;
+	frames.push_back(EGAVTest_MakeSceneFrame(EGAVTestTransfer::PQ, 203, true, 1920, 1080, 1));
+	frames.push_back(EGAVTest_MakeSceneFrame(EGAVTestTransfer::SDR, 0.35, false, 1000, 300, 2));	// width not a multiple of 16
+
+	// All codes, including the ones above the 10 bit range of a sloppy source (low bits set)
+	EGAVTestFrame noise;
+	noise.width  = 256;
+	noise.height = 64;
+	EGAVTestRandom random(3);
+	for (int i = 0; i < noise.width * noise.height; i++)
+		noise.y.push_back((uint16_t)random.Next());
+	frames.push_back(noise);
+
+	for (const EGAVTestFrame& frame : frames)
+	{
+		for (int step : { 1, 3, 4 })
+		{
+			HDRContentClassifier simd(step, step), scalar(step, step);
+			scalar.SetSIMDEnabled(false);
+			HDRLumaHistogram a, b;
+			simd.ComputeHistogram(frame.GetY(), frame.GetStride(), frame.width, frame.height, a);
+			scalar.ComputeHistogram(frame.GetY(), frame.GetStride(), frame.width, frame.height, b);
+			EGAV_CHECK(0 == memcmp(a.bins, b.bins, sizeof(a.bins)));
+			EGAV_CHECK_EQUAL(a.black, b.black);
+			EGAV_CHECK_EQUAL(a.total, b.total);
+			EGAV_CHECK(a.total > 0);
+		}
+	}
+}
+
+EGAV_TEST(HistogramCountsBlack)
+{
+	// 16 x 2 pixels: codes 64 (black bar), 79 (noise on black), 80, 100, 200, 940
+	EGAVTestFrame frame;
+	frame.width  = 16;
+	frame.height = 2;
+	const uint16_t codes[6] = { 64, 79, 80, 100, 200, 940 };
+	for (int i = 0; i < 32; i++)
+		frame.y.push_back((uint16_t)(codes[i % 6] << 6));
+
+	for (bool simd : { true, false })
+	{
+		HDRContentClassifier classifier(1, 1);
+		classifier.SetSIMDEnabled(simd);
+		HDRLumaHistogram histogram;
+		classifier.ComputeHistogram(frame.GetY(), frame.GetStride(), frame.width, frame.height, histogram);
+		EGAV_CHECK_EQUAL(histogram.total, (uint32_t)32);
+		EGAV_CHECK_EQUAL(histogram.black, (uint32_t)12);		// i % 6 in { 0, 1 }
+		EGAV_CHECK_EQUAL(histogram.bins[1], (uint32_t)22);		// 64..127
+		EGAV_CHECK_EQUAL(histogram.bins[14], (uint32_t)5);		// 896..959
+	}
+}
+
+EGAV_TEST(SyntheticCorpus)
+{
+	const int w = 640, h = 360;
+
+	// SDR with highlights near peak white
+	EGAV_CHECK(ClassifyFrame(EGAVTest_MakeSceneFrame(EGAVTestTransfer::SDR, 1.0, true, w, h)) == HDRContentKind::SDR);
+
+	// Dim SDR without highlights: mid tones where PQ puts diffuse white, nothing near the top. Must not look like PQ.
+	for (double exposure : { 0.6, 0.45, 0.35, 0.25 })
+	{
+		HDRContentEstimate smoothed;
+		EGAV_CHECK(ClassifyFrame(EGAVTest_MakeSceneFrame(EGAVTestTransfer::SDR, exposure, false, w, h), &smoothed) != HDRContentKind::PQ);
+		EGAV_CHECK(smoothed.kind != HDRContentKind::PQ);
+	}
+
+	// Dark SDR: no evidence either way
+	EGAV_CHECK(ClassifyFrame(EGAVTest_MakeSceneFrame(EGAVTestTransfer::SDR, 0.1, false, w, h)) == HDRContentKind::Unknown);
+
+	// PQ graded with diffuse white at 100 .. 300 cd/m2, highlights up to 5x
+	for (double white : { 100.0, 203.0, 300.0 })
+	{
+		HDRContentEstimate smoothed;
+		EGAV_CHECK(ClassifyFrame(EGAVTest_MakeSceneFrame(EGAVTestTransfer::PQ, white, true, w, h), &smoothed) == HDRContentKind::PQ);
+		EGAV_CHECK(smoothed.kind == HDRContentKind::PQ);
+	}
+
+	// HLG is SDR compatible: reference white at 75 %, highlights up to the top. Not PQ.
+	EGAV_CHECK(ClassifyFrame(EGAVTest_MakeSceneFrame(EGAVTestTransfer::HLG, 0, true, w, h)) == HDRContentKind::SDR);
+}
+
+EGAV_TEST(ValidInfoFrameDecides)
+{
+	const HDMI_GENERIC_INFOFRAME sdr = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, { HDMI_DR_EOTF_SDRGAMMA, 0 });
+	const HDMI_GENERIC_INFOFRAME pq  = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, { HDMI_DR_EOTF_ST2084, 0 });
+	const HDMI_GENERIC_INFOFRAME hlg = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, { HDMI_DR_EOTF_HLG, 0 });
+
+	bool isHDR = true;
+	EGAV_CHECK_RESULT(HDR_CombineDecision(EGAVResult::Ok, sdr, kConfidentPQ, isHDR), EGAVResult::Ok);
+	EGAV_CHECK(!isHDR); // a dim SDR scene must not switch a signaled SDR source to HDR
+
+	isHDR = false;
+	EGAV_CHECK_RESULT(HDR_CombineDecision(EGAVResult::Ok, pq, kConfidentSDR, isHDR), EGAVResult::Ok);
+	EGAV_CHECK(isHDR);
+	isHDR = false;
+	EGAV_CHECK_RESULT(HDR_CombineDecision(EGAVResult::Ok, hlg, kNoEstimate, isHDR), EGAVResult::Ok);
+	EGAV_CHECK(isHDR);
+}
+
+EGAV_TEST(ContentDecidesForMissingOrInvalidInfoFrame)
+{
+	const HDMI_GENERIC_INFOFRAME empty{};
+	HDMI_GENERIC_INFOFRAME broken = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, { HDMI_DR_EOTF_SDRGAMMA, 0 });
+	broken.bChecksum ^= 0x55;
+	const HDMI_GENERIC_INFOFRAME otherType = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_AVI, 2, { 0x50, 0x28 });
+
+	// Missing: a confident estimate decides, otherwise SDR
+	bool isHDR = false;
+	EGAV_CHECK_RESULT(HDR_CombineDecision(EGAVResult::Ok, empty, kConfidentPQ, isHDR), EGAVResult::Ok);
+	EGAV_CHECK(isHDR);
+	EGAV_CHECK_RESULT(HDR_CombineDecision(EGAVResult::ErrNoData, empty, kConfidentPQ, isHDR), EGAVResult::Ok);
+	EGAV_CHECK(isHDR);
+	EGAV_CHECK_RESULT(HDR_CombineDecision(EGAVResult::Ok, empty, kNoEstimate, isHDR), EGAVResult::Ok);
+	EGAV_CHECK(!isHDR);
+	isHDR = true;
+	EGAV_CHECK_RESULT(HDR_CombineDecision(EGAVResult::Ok, empty, { HDRContentKind::PQ, 0.3f }, isHDR), EGAVResult::Ok);
+	EGAV_CHECK(!isHDR); // not confident
+
+	// Invalid: a confident estimate decides, otherwise the error is returned
+	isHDR = false;
+	EGAV_CHECK_RESULT(HDR_CombineDecision(EGAVResult::Ok, broken, kConfidentPQ, isHDR), EGAVResult::Ok);
+	EGAV_CHECK(isHDR);
+	EGAV_CHECK_RESULT(HDR_CombineDecision(EGAVResult::Ok, otherType, kConfidentSDR, isHDR), EGAVResult::Ok);
+	EGAV_CHECK(!isHDR);
+	EGAV_CHECK_RESULT(HDR_CombineDecision(EGAVResult::Ok, broken, kNoEstimate, isHDR), EGAVResult::ErrInvalidFormat);
+	EGAV_CHECK_RESULT(HDR_CombineDecision(EGAVResult::ErrTimeOut, empty, kNoEstimate, isHDR), EGAVResult::ErrTimeOut);
+	EGAV_CHECK_RESULT(HDR_CombineDecision(EGAVResult::ErrTimeOut, empty, kConfidentPQ, isHDR), EGAVResult::Ok);
+	EGAV_CHECK(isHDR);
+}
+
+
+EGAV_TEST_MAIN()
@@ -0,0 +1,190 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		TestContentTypeWatcher.cpp
+
+@brief		HDMIContentTypeWatcher: AVI register mapping, initial profile, debouncing
+			and switch latency
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "ElgatoUVCDevice.h"
+#include "HDMIContentTypeWatcher.h"
+
+#include <chrono>
+#include <condition_variable>
+
+
+const uint8_t kAVIRegister = 0x22;
+
+//! @brief AVI info frame with ITC set and the given content type
+static void SetContentType(EGAVSimulatedHID& ioHID, int inContentType)
+{
+	std::vector<uint8_t> payload(13, 0);
+	payload[2] = 0x80;
+	payload[4] = (uint8_t)(inContentType << 4);
+	HDMI_GENERIC_INFOFRAME frame = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_AVI, 2, payload);
+	ioHID.SetRegisters((uint8_t)I2CAddress::MCU, kAVIRegister, &frame, sizeof(frame));
+}
+
+//! @brief Collects the published profiles
+struct ProfileLog
+{
+	std::mutex						mutex;
+	std::condition_variable			condition;
+	std::vector<HDMILatencyProfile>	profiles;
+	std::vector<uint64_t>			latencies;
+
+	HDMIContentTypeWatcher::ProfileCallback Callback()
+	{
+		return [this](const HDMILatencyProfile& inProfile, uint64_t inLatencyUs)
+		{
+			const std::lock_guard<std::mutex> lock(mutex);
+			profiles.push_back(inProfile);
+			latencies.push_back(inLatencyUs);
+			condition.notify_all();
+		};
+	}
+
+	size_t Count()
+	{
+		const std::lock_guard<std::mutex> lock(mutex);
+		return profiles.size();
+	}
+
+	bool WaitForCount(size_t inCount)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return condition.wait_for(lock, std::chrono::seconds(5), [&] { return profiles.size() >= inCount; });
+	}
+};
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(StartWithoutAVIRegisterIsNotSupported)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	ProfileLog log;
+	HDMIContentTypeWatcher watcher(device, log.Callback());
+
+	EGAV_CHECK_RESULT(watcher.Start(), EGAVResult::ErrNotSupported);
+	EGAV_CHECK_EQUAL(log.Count(), (size_t)0);
+}
+
+EGAV_TEST(StartPublishesInitialProfile)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	SetContentType(*hid, HDMI_AVI_CN_GAME);
+
+	ProfileLog log;
+	HDMIContentTypeWatcher watcher(device, log.Callback(), 1000, 3);
+	EGAV_CHECK_RESULT(watcher.Start(kAVIRegister), EGAVResult::Ok);
+
+	// Published synchronously, exactly once, without debouncing
+	EGAV_CHECK_EQUAL(log.Count(), (size_t)1);
+	EGAV_CHECK_EQUAL(log.profiles[0].contentType, HDMI_AVI_CN_GAME);
+	EGAV_CHECK_EQUAL(log.profiles[0].queueDepth, 1);
+	EGAV_CHECK_EQUAL(log.latencies[0], (uint64_t)0);
+	EGAV_CHECK_EQUAL(watcher.GetCurrentProfile().contentType, HDMI_AVI_CN_GAME);
+	watcher.Stop();
+
+	// Still mapped on the device: a plain Start() works now
+	EGAV_CHECK_RESULT(watcher.Start(), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(log.Count(), (size_t)2);
+	watcher.Stop();
+}
+
+EGAV_TEST(StartWithoutSignalPublishesDefaults)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+
+	ProfileLog log;
+	HDMIContentTypeWatcher watcher(device, log.Callback(), 1000, 3);
+	EGAV_CHECK_RESULT(watcher.Start(kAVIRegister), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(log.Count(), (size_t)1);
+	EGAV_CHECK_EQUAL(log.profiles[0].contentType, HDMI_ERROR);
+	watcher.Stop();
+}
+
+EGAV_TEST(DebounceAndSwitchLatency)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	ProfileLog log;
+	HDMIContentTypeWatcher watcher(device, log.Callback(), 100, 3);
+
+	// Nothing published yet: counted from the first poll
+	watcher.ProcessContentType(HDMI_AVI_CN_GAME, 1000);
+	watcher.ProcessContentType(HDMI_AVI_CN_GAME, 1100);
+	EGAV_CHECK_EQUAL(log.Count(), (size_t)0);
+	watcher.ProcessContentType(HDMI_AVI_CN_GAME, 1200);
+	EGAV_CHECK_EQUAL(log.Count(), (size_t)1);
+	EGAV_CHECK_EQUAL(log.latencies[0], (uint64_t)200);
+
+	// A short glitch doesn't switch
+	watcher.ProcessContentType(HDMI_AVI_CN_GAME, 1300);
+	watcher.ProcessContentType(HDMI_AVI_CN_CINEMA, 1400);
+	watcher.ProcessContentType(HDMI_AVI_CN_GAME, 1500);
+	EGAV_CHECK_EQUAL(log.Count(), (size_t)1);
+
+	// The switch latency starts at the last poll that still saw game content, not at the first cinema poll
+	watcher.ProcessContentType(HDMI_AVI_CN_CINEMA, 1600);
+	watcher.ProcessContentType(HDMI_AVI_CN_CINEMA, 1700);
+	watcher.ProcessContentType(HDMI_AVI_CN_CINEMA, 1800);
+	EGAV_CHECK_EQUAL(log.Count(), (size_t)2);
+	EGAV_CHECK_EQUAL(log.profiles[1].contentType, HDMI_AVI_CN_CINEMA);
+	EGAV_CHECK_EQUAL(log.latencies[1], (uint64_t)300);
+}
+
+EGAV_TEST(WorkerThreadFollowsDevice)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	SetContentType(*hid, HDMI_AVI_CN_GAME);
+
+	ProfileLog log;
+	HDMIContentTypeWatcher watcher(device, log.Callback(), 1, 2);
+	EGAV_CHECK_RESULT(watcher.Start(kAVIRegister), EGAVResult::Ok);
+
+	SetContentType(*hid, HDMI_AVI_CN_PHOTO);
+	EGAV_CHECK(log.WaitForCount(2));
+	watcher.Stop();
+
+	const std::lock_guard<std::mutex> lock(log.mutex);
+	EGAV_CHECK_EQUAL(log.profiles[1].contentType, HDMI_AVI_CN_PHOTO);
+	EGAV_CHECK(log.latencies[1] > 0);
+}
+
+EGAV_TEST_MAIN()
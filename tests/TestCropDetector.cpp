@@ -0,0 +1,231 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		TestCropDetector.cpp
+
+@brief		HDMICropDetector: AVI bar data, alignment, the black border scan
+			(NV12 and P010, SIMD blocks and tails) and the detector's precedence
+			and stability rules
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "EGAVTestFrames.h"
+#include "HDMICropDetector.h"
+
+
+//! @brief Luma plane, black (16) outside inContent, random picture (48..235) inside
+struct TestLuma
+{
+	int						width			= 0;
+	int						height			= 0;
+	int						bytesPerSample	= 1;
+	std::vector<uint8_t>	data;
+
+	TestLuma(int inWidth, int inHeight, int inBytesPerSample, const EGAVCropRect& inContent, uint32_t inSeed = 1)
+		: width(inWidth), height(inHeight), bytesPerSample(inBytesPerSample), data((size_t)inWidth * inHeight * inBytesPerSample)
+	{
+		EGAVTestRandom random(inSeed);
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				const bool inside = x >= inContent.left && x < inContent.left + inContent.width && y >= inContent.top && y < inContent.top + inContent.height;
+				Set(x, y, inside ? (uint8_t)(48 + random.Next() % 188) : 16);
+			}
+		}
+	}
+
+	//! @param inValue 8 bit code (P010: the same level in 10 bits, MSB aligned)
+	void Set(int inX, int inY, uint8_t inValue)
+	{
+		uint8_t* p = &data[((size_t)inY * width + inX) * bytesPerSample];
+		if (bytesPerSample == 1)
+			p[0] = inValue;
+		else
+		{
+			const uint16_t sample = (uint16_t)(inValue << 8);
+			memcpy(p, &sample, 2);
+		}
+	}
+
+	int GetStride() const { return width * bytesPerSample; }
+};
+
+static EGAVCropRect MakeRect(int inLeft, int inTop, int inWidth, int inHeight)
+{
+	EGAVCropRect rect;
+	rect.left   = inLeft;
+	rect.top    = inTop;
+	rect.width  = inWidth;
+	rect.height = inHeight;
+	return rect;
+}
+
+//! @brief AVI version 2 with bar data (1-based line / pixel numbers, 0: no bar)
+static HDMI_GENERIC_INFOFRAME MakeAVIWithBars(uint8_t inBars, uint16_t inETB, uint16_t inSBB, uint16_t inELB, uint16_t inSRB)
+{
+	return EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_AVI, 2,
+		{ (uint8_t)(0x40 | (inBars << 2)), 0x28, 0, 16, 0,
+		  (uint8_t)inETB, (uint8_t)(inETB >> 8), (uint8_t)inSBB, (uint8_t)(inSBB >> 8),
+		  (uint8_t)inELB, (uint8_t)(inELB >> 8), (uint8_t)inSRB, (uint8_t)(inSRB >> 8) });
+}
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(BarDataRect)
+{
+	EGAVCropRect rect;
+
+	// 2.39:1 in 1920x1080: top bar lines 1..140, bottom bar from line 941
+	EGAV_CHECK(HDMICrop_GetBarDataRect(MakeAVIWithBars(HDMI_AVI_B_H, 140, 941, 0, 0), 1920, 1080, rect));
+	EGAV_CHECK(rect == MakeRect(0, 140, 1920, 800));
+
+	// 4:3 pillarbox: left bar pixels 1..240, right bar from pixel 1681
+	EGAV_CHECK(HDMICrop_GetBarDataRect(MakeAVIWithBars(HDMI_AVI_B_V, 0, 0, 240, 1681), 1920, 1080, rect));
+	EGAV_CHECK(rect == MakeRect(240, 0, 1440, 1080));
+
+	EGAV_CHECK(HDMICrop_GetBarDataRect(MakeAVIWithBars(HDMI_AVI_B_VH, 140, 941, 240, 1681), 1920, 1080, rect));
+	EGAV_CHECK(rect == MakeRect(240, 140, 1440, 800));
+
+	// No bar data, inconsistent bars, no AVI info frame
+	EGAV_CHECK(!HDMICrop_GetBarDataRect(MakeAVIWithBars(HDMI_AVI_B_NODATA, 140, 941, 0, 0), 1920, 1080, rect));
+	EGAV_CHECK(!HDMICrop_GetBarDataRect(MakeAVIWithBars(HDMI_AVI_B_H, 600, 500, 0, 0), 1920, 1080, rect));
+	EGAV_CHECK(!HDMICrop_GetBarDataRect(EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_SPD, 1, std::vector<uint8_t>(25, 0x41)), 1920, 1080, rect));
+}
+
+EGAV_TEST(AlignGrowsOutward)
+{
+	EGAV_CHECK(HDMICrop_Align(MakeRect(0, 140, 1920, 800), 1920, 1080, 16) == MakeRect(0, 128, 1920, 816));
+	EGAV_CHECK(HDMICrop_Align(MakeRect(0, 140, 1920, 800), 1920, 1080, 64) == MakeRect(0, 128, 1920, 832));
+	EGAV_CHECK(HDMICrop_Align(MakeRect(241, 3, 1437, 1077), 1920, 1080, 16) == MakeRect(240, 0, 1440, 1080));	// clamped to the frame
+	EGAV_CHECK(HDMICrop_Align(MakeRect(5, 5, 9, 9), 1920, 1080, 1) == MakeRect(4, 4, 10, 10));					// at least 2 (4:2:0)
+}
+
+EGAV_TEST(ScanFindsBorders)
+{
+	// 1000 = 62 x 16 + 8: the last 8 samples of each row go through the scalar tail
+	const EGAVCropRect contents[] =
+	{
+		MakeRect(0, 138, 1000, 424),		// letterbox
+		MakeRect(125, 0, 750, 700),			// pillarbox
+		MakeRect(17, 3, 979, 690),			// odd borders, content up to the tail
+		MakeRect(0, 0, 1000, 700),			// no borders
+	};
+	for (int bytesPerSample : { 1, 2 })
+	{
+		for (const EGAVCropRect& content : contents)
+		{
+			const TestLuma luma(1000, 700, bytesPerSample, content);
+			EGAVCropRect rect;
+			EGAV_CHECK(HDMICrop_ScanBlackBorders(luma.data.data(), luma.GetStride(), luma.width, luma.height, bytesPerSample, 32, rect));
+			EGAV_CHECK(rect == content);
+		}
+	}
+}
+
+EGAV_TEST(ScanThresholdAndSinglePixels)
+{
+	for (int bytesPerSample : { 1, 2 })
+	{
+		TestLuma luma(1000, 700, bytesPerSample, MakeRect(0, 100, 1000, 500));
+		EGAVCropRect rect;
+
+		// Noise up to the threshold in the bars is black
+		luma.Set(500, 10, 32);
+		luma.Set(999, 690, 32);
+		EGAV_CHECK(HDMICrop_ScanBlackBorders(luma.data.data(), luma.GetStride(), luma.width, luma.height, bytesPerSample, 32, rect));
+		EGAV_CHECK(rect == MakeRect(0, 100, 1000, 500));
+
+		// One sample above it is picture, in a SIMD block (row 10) and in the scalar tail (row 690)
+		luma.Set(500, 10, 33);
+		EGAV_CHECK(HDMICrop_ScanBlackBorders(luma.data.data(), luma.GetStride(), luma.width, luma.height, bytesPerSample, 32, rect));
+		EGAV_CHECK(rect == MakeRect(0, 10, 1000, 590));
+		luma.Set(999, 690, 33);
+		EGAV_CHECK(HDMICrop_ScanBlackBorders(luma.data.data(), luma.GetStride(), luma.width, luma.height, bytesPerSample, 32, rect));
+		EGAV_CHECK(rect == MakeRect(0, 10, 1000, 681));
+
+		// Black frame
+		const TestLuma black(1000, 700, bytesPerSample, EGAVCropRect());
+		EGAV_CHECK(!HDMICrop_ScanBlackBorders(black.data.data(), black.GetStride(), black.width, black.height, bytesPerSample, 32, rect));
+	}
+	EGAVCropRect rect;
+	EGAV_CHECK(!HDMICrop_ScanBlackBorders(nullptr, 1000, 1000, 700, 1, 32, rect));
+}
+
+EGAV_TEST(DetectorPrefersBarData)
+{
+	HDMICropDetector detector(16, 5);
+	const TestLuma pillarbox(1920, 1080, 1, MakeRect(240, 0, 1440, 1080));
+	const HDMI_GENERIC_INFOFRAME letterbox = MakeAVIWithBars(HDMI_AVI_B_H, 140, 941, 0, 0);
+
+	// Bar data applies at once, even if the picture says otherwise
+	EGAV_CHECK(detector.Update(&letterbox, pillarbox.data.data(), pillarbox.GetStride(), 1920, 1080, 1) == MakeRect(0, 128, 1920, 816));
+
+	// Without bar data the scan takes over: picture outside the crop grows it to the union at once,
+	// the smaller scan result needs 5 stable frames (counting the first one)
+	const HDMI_GENERIC_INFOFRAME noBars = MakeAVIWithBars(HDMI_AVI_B_NODATA, 0, 0, 0, 0);
+	EGAV_CHECK(detector.Update(&noBars, pillarbox.data.data(), pillarbox.GetStride(), 1920, 1080, 1) == MakeRect(0, 0, 1920, 1080));
+	for (int frame = 1; frame < 4; frame++)
+		EGAV_CHECK(detector.Update(&noBars, pillarbox.data.data(), pillarbox.GetStride(), 1920, 1080, 1) == MakeRect(0, 0, 1920, 1080));
+	EGAV_CHECK(detector.Update(nullptr, pillarbox.data.data(), pillarbox.GetStride(), 1920, 1080, 1) == MakeRect(240, 0, 1440, 1080));
+}
+
+EGAV_TEST(DetectorScanStability)
+{
+	HDMICropDetector detector(16, 5);
+	const TestLuma letterbox(1920, 1080, 2, MakeRect(0, 140, 1920, 800), 1);
+	const TestLuma darkScene(1920, 1080, 2, MakeRect(0, 300, 1920, 480), 2);	// looks like wider bars
+	const TestLuma black(1920, 1080, 2, EGAVCropRect());
+	const TestLuma full(1920, 1080, 2, MakeRect(0, 0, 1920, 1080), 3);
+
+	// Full frame until the scan result is stable for 5 frames
+	EGAVCropRect rect;
+	for (int frame = 0; frame < 4; frame++)
+		EGAV_CHECK(detector.Update(nullptr, letterbox.data.data(), letterbox.GetStride(), 1920, 1080, 2) == MakeRect(0, 0, 1920, 1080));
+	EGAV_CHECK(detector.Update(nullptr, letterbox.data.data(), letterbox.GetStride(), 1920, 1080, 2) == MakeRect(0, 128, 1920, 816));
+
+	// A short dark scene and black frames don't shrink the crop
+	for (int frame = 0; frame < 4; frame++)
+		rect = detector.Update(nullptr, darkScene.data.data(), darkScene.GetStride(), 1920, 1080, 2);
+	for (int frame = 0; frame < 10; frame++)
+		rect = detector.Update(nullptr, black.data.data(), black.GetStride(), 1920, 1080, 2);
+	EGAV_CHECK(rect == MakeRect(0, 128, 1920, 816));
+
+	// Picture outside the crop grows it at once
+	EGAV_CHECK(detector.Update(nullptr, full.data.data(), full.GetStride(), 1920, 1080, 2) == MakeRect(0, 0, 1920, 1080));
+
+	// A resolution change starts over with the full frame
+	const TestLuma small(1280, 720, 2, MakeRect(0, 90, 1280, 540));
+	EGAV_CHECK(detector.Update(nullptr, small.data.data(), small.GetStride(), 1280, 720, 2) == MakeRect(0, 0, 1280, 720));
+}
+
+
+EGAV_TEST_MAIN()
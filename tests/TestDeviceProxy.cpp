@@ -0,0 +1,463 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		TestDeviceProxy.cpp
+
+@brief		EGAVDeviceProxy: framing, pipelining, coalescing and the device thread,
+			server and clients in one process against a simulated device
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "EGAVDeviceProxy.h"
+#include "ElgatoUVCDevice.h"
+#include "ElgatoUVCQuirks.h"
+
+#if !_UP_WINDOWS
+
+#include <atomic>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+
+const uint8_t kSPDRegister	= 0x21;
+const uint8_t kAVIRegister	= 0x22;
+
+//! @brief Holds the device thread in a HID read until it is opened again
+class DeviceGate
+{
+public:
+	void Close() { const std::lock_guard<std::mutex> lock(mMutex); mOpen = false; }
+
+	void Open()
+	{
+		{
+			const std::lock_guard<std::mutex> lock(mMutex);
+			mOpen = true;
+		}
+		mCondition.notify_all();
+	}
+
+	//! @brief Read hook of EGAVSimulatedHID
+	void Pass()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mOpen)
+			return;
+		mBlocked = true;
+		mCondition.notify_all();
+		mCondition.wait(lock, [this] { return mOpen; });
+		mBlocked = false;
+	}
+
+	bool WaitUntilBlocked()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		return mCondition.wait_for(lock, std::chrono::seconds(5), [this] { return mBlocked; });
+	}
+
+private:
+	std::mutex				mMutex;
+	std::condition_variable	mCondition;
+	bool					mOpen		= true;
+	bool					mBlocked	= false;
+};
+
+//! @brief Simulated device with a DR packet, SPD and AVI info frames, served on a temp socket
+struct ProxyFixture
+{
+	explicit ProxyFixture(const std::string& inName)
+		: hid(std::make_shared<EGAVSimulatedHID>(true)), device(hid, deviceIDHD60X), server(device), path(EGAVTest_GetTempPath(inName))
+	{
+		const HDMI_GENERIC_INFOFRAME drFrame  = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, { 0x02, 0x00, 0x10, 0x27 });
+		const HDMI_GENERIC_INFOFRAME spdFrame = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_SPD, 1, { 'E', 'l', 'g', 'a', 't', 'o' });
+		const HDMI_GENERIC_INFOFRAME aviFrame = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_AVI, 2, { 0x50, 0x28, 0x00, 0x10 });
+		hid->SetRegisters((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::GET_HDR_PACKET, &drFrame, sizeof(drFrame));
+		hid->SetRegisters((uint8_t)I2CAddress::MCU, kSPDRegister, &spdFrame, sizeof(spdFrame));
+		hid->SetRegisters((uint8_t)I2CAddress::MCU, kAVIRegister, &aviFrame, sizeof(aviFrame));
+		device.SetInfoFrameRegister(HDMI_INFOFRAME_TYPE_SPD, kSPDRegister);
+		device.SetInfoFrameRegister(HDMI_INFOFRAME_TYPE_AVI, kAVIRegister);
+
+		// Expected responses: what the device returns to a direct call (read size and offset depend on the quirks)
+		started = device.GetHDMIHDRStatusPacket(hdr).Succeeded() && hdr.header.bfType == HDMI_INFOFRAME_TYPE_DR &&
+				  device.GetHDMIInfoFrame(HDMI_INFOFRAME_TYPE_SPD, spd).Succeeded() && spd.header.bfType == HDMI_INFOFRAME_TYPE_SPD &&
+				  device.GetHDMIInfoFrame(HDMI_INFOFRAME_TYPE_AVI, avi).Succeeded() && avi.header.bfType == HDMI_INFOFRAME_TYPE_AVI;
+		hid->ResetCounters();
+		hid->SetReadHook([this](uint8_t, uint8_t, uint8_t) { gate.Pass(); });
+		started = started && server.Start(path).Succeeded();
+	}
+
+	~ProxyFixture()
+	{
+		gate.Open();
+		server.Stop();
+	}
+
+	//! @brief Waits until the server thread received inCount requests in total
+	bool WaitForRequests(uint64_t inCount)
+	{
+		for (int i = 0; i < 5000; i++)
+		{
+			if (server.GetStatistics().requests >= inCount)
+				return true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return false;
+	}
+
+	std::shared_ptr<EGAVSimulatedHID>	hid;
+	ElgatoUVCDevice						device;
+	EGAVDeviceProxyServer				server;
+	std::string							path;
+	DeviceGate							gate;
+	HDMI_GENERIC_INFOFRAME				hdr{};
+	HDMI_GENERIC_INFOFRAME				spd{};
+	HDMI_GENERIC_INFOFRAME				avi{};
+	bool								started	= false;
+};
+
+
+//------------------------------------------------------------------------------
+// Raw socket client
+//------------------------------------------------------------------------------
+
+static int RawConnect(const std::string& inPath)
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, inPath.c_str(), sizeof(address.sun_path) - 1);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd >= 0 && connect(fd, (const sockaddr*)&address, sizeof(address)) != 0)
+	{
+		close(fd);
+		fd = -1;
+	}
+	return fd;
+}
+
+static void AppendRequest(std::vector<uint8_t>& ioFrames, EGAVProxyOp inOp, uint32_t inRequestID, const std::vector<uint8_t>& inPayload = {})
+{
+	EGAVProxyRequestHeader header;
+	header.op				= (uint16_t)inOp;
+	header.payloadLength	= (uint16_t)inPayload.size();
+	header.requestID		= inRequestID;
+	ioFrames.insert(ioFrames.end(), (const uint8_t*)&header, (const uint8_t*)&header + sizeof(header));
+	ioFrames.insert(ioFrames.end(), inPayload.begin(), inPayload.end());
+}
+
+//! @return false if the server closed the connection or nothing arrived within 5 s
+static bool ReceiveAll(int inSocket, void* outData, size_t inLength)
+{
+	for (size_t offset = 0; offset < inLength; )
+	{
+		pollfd pfd = { inSocket, POLLIN, 0 };
+		if (poll(&pfd, 1, 5000) <= 0)
+			return false;
+		const ssize_t n = recv(inSocket, (uint8_t*)outData + offset, inLength - offset, 0);
+		if (n <= 0)
+			return false;
+		offset += (size_t)n;
+	}
+	return true;
+}
+
+static bool ReceiveResponse(int inSocket, EGAVProxyResponseHeader& outHeader, std::vector<uint8_t>& outPayload)
+{
+	if (!ReceiveAll(inSocket, &outHeader, sizeof(outHeader)))
+		return false;
+	outPayload.resize(outHeader.payloadLength);
+	return outHeader.payloadLength == 0 || ReceiveAll(inSocket, outPayload.data(), outPayload.size());
+}
+
+static bool SamePayload(const std::vector<uint8_t>& inPayload, const HDMI_GENERIC_INFOFRAME& inFrame)
+{
+	return inPayload.size() == sizeof(inFrame) && 0 == memcmp(inPayload.data(), &inFrame, sizeof(inFrame));
+}
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(FramingSplitRequests)
+{
+	ProxyFixture fixture("proxy_split.sock");
+	EGAV_CHECK(fixture.started);
+	const int fd = RawConnect(fixture.path);
+	EGAV_CHECK(fd >= 0);
+	if (fd < 0)
+		return;
+
+	// Three frames sent one byte at a time: headers and payloads arrive in pieces
+	std::vector<uint8_t> frames;
+	AppendRequest(frames, EGAVProxyOp::Ping, 7);
+	AppendRequest(frames, EGAVProxyOp::GetHDMIInfoFrame, 8, { HDMI_INFOFRAME_TYPE_SPD });
+	AppendRequest(frames, EGAVProxyOp::GetHDMIHDRStatusPacket, 9);
+	for (uint8_t byte : frames)
+	{
+		EGAV_CHECK_EQUAL(send(fd, &byte, 1, MSG_NOSIGNAL), (ssize_t)1);
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	int seen = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		EGAVProxyResponseHeader header;
+		std::vector<uint8_t> payload;
+		EGAV_CHECK(ReceiveResponse(fd, header, payload));
+		EGAV_CHECK_EQUAL(header.result, (int32_t)EGAVResult::Ok);
+		if (header.requestID == 7)
+			EGAV_CHECK(header.op == (uint16_t)EGAVProxyOp::Ping && payload.empty());
+		else if (header.requestID == 8)
+			EGAV_CHECK(header.op == (uint16_t)EGAVProxyOp::GetHDMIInfoFrame && SamePayload(payload, fixture.spd));
+		else if (header.requestID == 9)
+			EGAV_CHECK(header.op == (uint16_t)EGAVProxyOp::GetHDMIHDRStatusPacket && SamePayload(payload, fixture.hdr));
+		seen |= 1 << (header.requestID - 7);
+	}
+	EGAV_CHECK_EQUAL(seen, 7);
+	close(fd);
+}
+
+EGAV_TEST(FramingErrorsCloseOnlyThatClient)
+{
+	ProxyFixture fixture("proxy_errors.sock");
+	EGAV_CHECK(fixture.started);
+	const int fd = RawConnect(fixture.path);
+	EGAV_CHECK(fd >= 0);
+	if (fd < 0)
+		return;
+
+	// A wrong payload length for the operation is an error response, not a protocol error
+	std::vector<uint8_t> frames;
+	AppendRequest(frames, EGAVProxyOp::GetHDMIInfoFrame, 1, { HDMI_INFOFRAME_TYPE_SPD, 0 });
+	AppendRequest(frames, (EGAVProxyOp)999, 2);
+	EGAV_CHECK_EQUAL(send(fd, frames.data(), frames.size(), MSG_NOSIGNAL), (ssize_t)frames.size());
+	for (int i = 0; i < 2; i++)
+	{
+		EGAVProxyResponseHeader header;
+		std::vector<uint8_t> payload;
+		EGAV_CHECK(ReceiveResponse(fd, header, payload));
+		EGAV_CHECK_EQUAL(header.result, (int32_t)(header.requestID == 1 ? EGAVResult::ErrInvalidParameter : EGAVResult::ErrNotSupported));
+	}
+
+	// An oversized payload closes the connection
+	EGAVDeviceProxyClient other;
+	EGAV_CHECK_RESULT(other.Connect(fixture.path), EGAVResult::Ok);
+	EGAVProxyRequestHeader header = { (uint16_t)EGAVProxyOp::Ping, EGAV_PROXY_MAX_PAYLOAD + 1, 3 };
+	EGAV_CHECK_EQUAL(send(fd, &header, sizeof(header), MSG_NOSIGNAL), (ssize_t)sizeof(header));
+	uint8_t byte;
+	pollfd pfd = { fd, POLLIN, 0 };
+	EGAV_CHECK(poll(&pfd, 1, 5000) == 1 && recv(fd, &byte, 1, 0) == 0);
+	close(fd);
+
+	// Other clients keep working
+	EGAV_CHECK_RESULT(other.Ping(), EGAVResult::Ok);
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAV_CHECK_RESULT(other.GetHDMIHDRStatusPacket(frame), EGAVResult::Ok);
+	EGAV_CHECK(0 == memcmp(&frame, &fixture.hdr, sizeof(frame)));
+	EGAV_CHECK_EQUAL(fixture.server.GetStatistics().clients, 1);
+}
+
+EGAV_TEST(PipelinedRequestsGetTheirOwnResponses)
+{
+	ProxyFixture fixture("proxy_pipeline.sock");
+	EGAV_CHECK(fixture.started);
+	EGAVDeviceProxyClient client;
+	EGAV_CHECK_RESULT(client.Connect(fixture.path), EGAVResult::Ok);
+
+	const int kRequests = 300;
+	std::vector<std::future<EGAVProxyResponse>> futures;
+	for (int i = 0; i < kRequests; i++)
+	{
+		const uint8_t type = (i % 3 == 0) ? HDMI_INFOFRAME_TYPE_SPD : HDMI_INFOFRAME_TYPE_AVI;
+		if (i % 3 == 2)
+			futures.push_back(client.SendRequest(EGAVProxyOp::Ping));
+		else
+			futures.push_back(client.SendRequest(EGAVProxyOp::GetHDMIInfoFrame, &type, sizeof(type)));
+	}
+
+	int mismatches = 0;
+	for (int i = 0; i < kRequests; i++)
+	{
+		const EGAVProxyResponse response = futures[i].get();
+		if (response.result.Failed())
+			mismatches++;
+		else if (i % 3 == 2)
+			mismatches += response.payload.empty() ? 0 : 1;
+		else
+			mismatches += SamePayload(response.payload, (i % 3 == 0) ? fixture.spd : fixture.avi) ? 0 : 1;
+	}
+	EGAV_CHECK_EQUAL(mismatches, 0);
+	EGAV_CHECK_EQUAL(fixture.server.GetStatistics().requests, (uint64_t)kRequests);
+}
+
+EGAV_TEST(IdenticalRequestsAreCoalesced)
+{
+	ProxyFixture fixture("proxy_coalesce.sock");
+	EGAV_CHECK(fixture.started);
+
+	// HID reads of one DR packet read
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAV_CHECK_RESULT(fixture.device.GetHDMIHDRStatusPacket(frame), EGAVResult::Ok);
+	const size_t readsPerPacket = fixture.hid->GetHIDReadCount();
+	EGAV_CHECK(readsPerPacket > 0);
+	fixture.hid->ResetCounters();
+
+	// The first request holds the device thread; the others arrive meanwhile and form one batch
+	const int kClients = 8;
+	std::vector<std::unique_ptr<EGAVDeviceProxyClient>> clients;
+	for (int i = 0; i < kClients; i++)
+	{
+		clients.push_back(std::make_unique<EGAVDeviceProxyClient>());
+		EGAV_CHECK_RESULT(clients.back()->Connect(fixture.path), EGAVResult::Ok);
+	}
+	fixture.gate.Close();
+	std::vector<std::future<EGAVProxyResponse>> futures;
+	futures.push_back(clients[0]->SendRequest(EGAVProxyOp::GetHDMIHDRStatusPacket));
+	EGAV_CHECK(fixture.gate.WaitUntilBlocked());
+	for (int i = 0; i < kClients; i++)
+		for (int repeat = 0; repeat < 4; repeat++)
+			futures.push_back(clients[i]->SendRequest(EGAVProxyOp::GetHDMIHDRStatusPacket));
+	EGAV_CHECK(fixture.WaitForRequests(futures.size()));
+	fixture.gate.Open();
+
+	for (auto& future : futures)
+	{
+		const EGAVProxyResponse response = future.get();
+		EGAV_CHECK(response.result.Succeeded() && SamePayload(response.payload, fixture.hdr));
+	}
+	const EGAVDeviceProxyStatistics statistics = fixture.server.GetStatistics();
+	EGAV_CHECK_EQUAL(statistics.batches, (uint64_t)2);
+	EGAV_CHECK_EQUAL(statistics.executed, (uint64_t)2);
+	EGAV_CHECK_EQUAL(statistics.coalesced, (uint64_t)(futures.size() - 2));
+	EGAV_CHECK_EQUAL(fixture.hid->GetHIDReadCount(), 2 * readsPerPacket);
+}
+
+EGAV_TEST(WriteEndsCoalescing)
+{
+	ProxyFixture fixture("proxy_write.sock");
+	EGAV_CHECK(fixture.started);
+	EGAVDeviceProxyClient client;
+	EGAV_CHECK_RESULT(client.Connect(fixture.path), EGAVResult::Ok);
+
+	fixture.gate.Close();
+	auto blocker = client.SendRequest(EGAVProxyOp::GetHDMIInfoFrame, "\x03", 1);
+	EGAV_CHECK(fixture.gate.WaitUntilBlocked());
+	fixture.hid->ResetCounters();
+
+	// One batch: read, write, read. The second read is executed after the write, not answered from the first.
+	const uint8_t enable = 1;
+	auto before = client.SendRequest(EGAVProxyOp::GetHDMIHDRStatusPacket);
+	auto write  = client.SendRequest(EGAVProxyOp::SetHDRTonemappingEnabled, &enable, sizeof(enable));
+	auto after  = client.SendRequest(EGAVProxyOp::GetHDMIHDRStatusPacket);
+	EGAV_CHECK(fixture.WaitForRequests(4));
+	fixture.gate.Open();
+
+	EGAV_CHECK(blocker.get().result.Succeeded());
+	EGAV_CHECK(before.get().result.Succeeded());
+	EGAV_CHECK(write.get().result.Succeeded());
+	EGAV_CHECK(after.get().result.Succeeded());
+	const EGAVDeviceProxyStatistics statistics = fixture.server.GetStatistics();
+	EGAV_CHECK_EQUAL(statistics.executed, (uint64_t)4);
+	EGAV_CHECK_EQUAL(statistics.coalesced, (uint64_t)0);
+
+	// I2C order on the device: DR packet read, tone mapping write, DR packet read
+	std::vector<bool> order;
+	for (const EGAVSimulatedHID::Transaction& transaction : fixture.hid->GetTransactions())
+	{
+		if (transaction.reg == (uint8_t)MCU_I2C_REGISTER::GET_HDR_PACKET || transaction.reg == (uint8_t)MCU_I2C_REGISTER::XET_HDR_TONEMAPPING)
+		{
+			if (order.empty() || order.back() != transaction.isRead)
+				order.push_back(transaction.isRead);
+		}
+	}
+	EGAV_CHECK(order == std::vector<bool>({ true, false, true }));
+}
+
+EGAV_TEST(SlowDeviceDoesNotBlockServerThread)
+{
+	ProxyFixture fixture("proxy_slow.sock");
+	EGAV_CHECK(fixture.started);
+	EGAVDeviceProxyClient busy, other;
+	EGAV_CHECK_RESULT(busy.Connect(fixture.path), EGAVResult::Ok);
+
+	fixture.gate.Close();
+	auto stalled = busy.SendRequest(EGAVProxyOp::GetHDMIHDRStatusPacket);
+	EGAV_CHECK(fixture.gate.WaitUntilBlocked());
+
+	// New connections and Ping are handled while the device thread hangs in a HID read
+	EGAV_CHECK_RESULT(other.Connect(fixture.path), EGAVResult::Ok);
+	auto ping = other.SendRequest(EGAVProxyOp::Ping);
+	EGAV_CHECK(ping.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+	EGAV_CHECK(stalled.wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout);
+
+	fixture.gate.Open();
+	EGAV_CHECK(stalled.get().result.Succeeded());
+	EGAV_CHECK(ping.get().result.Succeeded());
+}
+
+EGAV_TEST(DisconnectDuringConcurrentRequests)
+{
+	ProxyFixture fixture("proxy_disconnect.sock");
+	EGAV_CHECK(fixture.started);
+
+	for (int round = 0; round < 20; round++)
+	{
+		EGAVDeviceProxyClient client;
+		EGAV_CHECK_RESULT(client.Connect(fixture.path), EGAVResult::Ok);
+
+		std::atomic<int> unexpected{0};
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; t++)
+		{
+			threads.emplace_back([&client, &unexpected]
+			{
+				HDMI_GENERIC_INFOFRAME frame{};
+				for (int i = 0; i < 200; i++)
+				{
+					const EGAVResult res = client.GetHDMIHDRStatusPacket(frame);
+					if (res.Failed() && res.GetResultCode() != EGAVResult::ErrResourceNotAvail)
+						unexpected++;
+				}
+			});
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(200 * round));
+		client.Disconnect();
+		for (std::thread& thread : threads)
+			thread.join();
+		EGAV_CHECK_EQUAL(unexpected.load(), 0);
+		EGAV_CHECK(!client.IsConnected());
+	}
+}
+
+#endif
+
+
+EGAV_TEST_MAIN()
@@ -0,0 +1,207 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		TestEDIDCache.cpp
+
+@brief		ElgatoUVCDevice::GetEDID(): caching and invalidation; decoding of malformed EDIDs
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "ElgatoUVCDevice.h"
+#include "HDMIEDID.h"
+
+
+static void SetChecksum(uint8_t* ioBlock)
+{
+	uint8_t sum = 0;
+	for (int i = 0; i < HDMI_EDID_BLOCK_SIZE - 1; i++)
+		sum += ioBlock[i];
+	ioBlock[HDMI_EDID_BLOCK_SIZE - 1] = (uint8_t)(0x100 - sum);
+}
+
+//! @brief Base block (and empty CTA extensions) in the simulated EDID EEPROM
+static void SetEDID(EGAVSimulatedHID& ioHID, uint16_t inProductCode, uint8_t inExtensions = 1)
+{
+	uint8_t data[2 * HDMI_EDID_BLOCK_SIZE] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+	data[8]   = 0x15;	// "EGA"
+	data[9]   = 0xE1;
+	data[10]  = (uint8_t)inProductCode;
+	data[11]  = (uint8_t)(inProductCode >> 8);
+	data[126] = inExtensions;
+	SetChecksum(data);
+
+	data[HDMI_EDID_BLOCK_SIZE]     = 0x02;	// CTA extension, no data blocks
+	data[HDMI_EDID_BLOCK_SIZE + 1] = 0x03;
+	data[HDMI_EDID_BLOCK_SIZE + 2] = 0x04;
+	SetChecksum(data + HDMI_EDID_BLOCK_SIZE);
+
+	ioHID.SetRegisters((uint8_t)I2CAddress::EDID, 0, data, sizeof(data));
+}
+
+static uint16_t GetProductCode(ElgatoUVCDevice& inDevice, EGAVResultCode inExpected = EGAVResult::Ok)
+{
+	std::shared_ptr<const HDMIEDID> edid;
+	EGAV_CHECK_RESULT(inDevice.GetEDID(edid), inExpected);
+	return edid ? edid->GetProductCode() : 0;
+}
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(EDIDIsCached)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	SetEDID(*hid, 0x1234);
+
+	EGAV_CHECK_EQUAL(GetProductCode(device), 0x1234);
+	const size_t reads = hid->GetHIDReadCount();
+	EGAV_CHECK(reads > 0);
+
+	// Changed behind the device's back: still cached
+	SetEDID(*hid, 0x5678);
+	EGAV_CHECK_EQUAL(GetProductCode(device), 0x1234);
+	EGAV_CHECK_EQUAL(hid->GetHIDReadCount(), reads);
+
+	device.InvalidateEDIDCache();
+	EGAV_CHECK_EQUAL(GetProductCode(device), 0x5678);
+
+	std::shared_ptr<const HDMIEDID> edid;
+	EGAV_CHECK_RESULT(device.GetEDID(edid, true), EGAVResult::Ok);
+	EGAV_CHECK(hid->GetHIDReadCount() > reads);
+}
+
+EGAV_TEST(EDIDWriteInvalidatesCache)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	SetEDID(*hid, 0x1234);
+	EGAV_CHECK_EQUAL(GetProductCode(device), 0x1234);
+
+	// Rewrite the EDID EEPROM through the device: product code and checksum
+	std::shared_ptr<const HDMIEDID> edid;
+	EGAV_CHECK_RESULT(device.GetEDID(edid), EGAVResult::Ok);
+	std::vector<uint8_t> base(edid->GetData().begin(), edid->GetData().begin() + HDMI_EDID_BLOCK_SIZE);
+	base[10] = 0x99;
+	SetChecksum(base.data());
+	EGAV_CHECK_RESULT(device.WriteI2cBlock((uint8_t)I2CAddress::EDID, 0, base.data(), base.size()), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(GetProductCode(device), 0x1299);
+
+	// Writes to other addresses keep the cache
+	const size_t reads = hid->GetHIDReadCount();
+	uint8_t value = 1;
+	EGAV_CHECK_RESULT(device.WriteI2cBlock(0x30, 0, &value, 1), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(GetProductCode(device), 0x1299);
+	EGAV_CHECK_EQUAL(hid->GetHIDReadCount(), reads);
+}
+
+EGAV_TEST(ReconnectInvalidatesCache)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	SetEDID(*hid, 0x1234);
+	EGAV_CHECK_EQUAL(GetProductCode(device), 0x1234);
+
+	SetEDID(*hid, 0x2222);
+	EGAV_CHECK_RESULT(device.ReplayShadowRegisters(), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(GetProductCode(device), 0x2222);
+
+	// Reopen: the tonemapping register is written again, the EDID is read again
+	EGAV_CHECK_RESULT(device.SetHDRTonemappingEnabled(true), EGAVResult::Ok);
+	SetEDID(*hid, 0x3333);
+	hid->ResetCounters();
+	EGAV_CHECK_RESULT(device.ReopenHIDInterface(), EGAVResult::Ok);
+	const std::vector<EGAVSimulatedHID::Transaction> transactions = hid->GetTransactions();
+	EGAV_CHECK_EQUAL(transactions.size(), (size_t)1);
+	EGAV_CHECK(!transactions.empty() && !transactions[0].isRead && transactions[0].reg == (uint8_t)MCU_I2C_REGISTER::XET_HDR_TONEMAPPING);
+	EGAV_CHECK_EQUAL(GetProductCode(device), 0x3333);
+}
+
+EGAV_TEST(EDIDWithTwoExtensionsIsIncomplete)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	SetEDID(*hid, 0x1234, 2);
+
+	// Base block and first extension only: decoded as far as read, still a success
+	std::shared_ptr<const HDMIEDID> edid;
+	const EGAVResult res = device.GetEDID(edid);
+	EGAV_CHECK_RESULT(res, EGAVResult::OkButIncomplete);
+	EGAV_CHECK(res.Succeeded());
+	EGAV_CHECK(edid && edid->GetData().size() == 2 * HDMI_EDID_BLOCK_SIZE);
+}
+
+//! @brief Base block and one CTA extension whose last data block starts at byte 120 with length 31,
+//! i.e. runs past the checksum, while the DTD offset claims 255
+static std::vector<uint8_t> MakeOverrunningEDID(uint8_t inLastBlockHeader, const std::vector<uint8_t>& inLastBlockStart)
+{
+	std::vector<uint8_t> data(2 * HDMI_EDID_BLOCK_SIZE, 0); // exactly the size read from the device
+	const uint8_t header[] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+	memcpy(data.data(), header, sizeof(header));
+	data[126] = 1;
+	SetChecksum(data.data());
+
+	uint8_t* ext = data.data() + HDMI_EDID_BLOCK_SIZE;
+	ext[0] = 0x02;
+	ext[1] = 0x03;
+	ext[2] = 0xFF;
+	ext[4] = 0x41;	// video data block: VIC 4 (720p60)
+	ext[5] = 4;
+	const int fillers[] = { 31, 31, 31, 17 }; // reserved tag 6 up to byte 119
+	int pos = 6;
+	for (int length : fillers)
+	{
+		ext[pos] = (uint8_t)(0xC0 | length);
+		pos += 1 + length;
+	}
+	ext[pos] = inLastBlockHeader;
+	memcpy(ext + pos + 1, inLastBlockStart.data(), inLastBlockStart.size());
+	SetChecksum(ext);
+	return data;
+}
+
+EGAV_TEST(MalformedCTADataBlocks)
+{
+	// Video data block: the SVDs inside the block are not decoded either, nothing past it is read
+	std::vector<uint8_t> data = MakeOverrunningEDID(0x5F, std::vector<uint8_t>(6, 16));
+	HDMIEDID edid;
+	EGAV_CHECK_RESULT(edid.Decode(data.data(), data.size()), EGAVResult::Ok);
+	EGAV_CHECK(edid.SupportsVIC(4));
+	EGAV_CHECK(!edid.SupportsVIC(16));
+
+	// YCbCr 4:2:0 capability map (extended tag 15) of 30 bytes
+	data = MakeOverrunningEDID(0xFF, { 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF });
+	EGAV_CHECK_RESULT(edid.Decode(data.data(), data.size()), EGAVResult::Ok);
+	EGAV_CHECK(edid.SupportsVIC(4));
+	EGAV_CHECK(!edid.SupportsYCbCr420(4));
+}
+
+EGAV_TEST_MAIN()
@@ -0,0 +1,228 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		TestHDMIInfoFrames.cpp
+
+@brief		Info frames beyond the DR packet: register mapping, audio (decode --> remap),
+			SPD and AVI decoding against a simulated device
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "ElgatoUVCDevice.h"
+#include "HDMIAudioRemapper.h"
+#include "HDMIInfoFrameJournal.h"
+
+
+// Registers of a hypothetical firmware exposing more info frames
+const uint8_t kAudioRegister	= 0x20;
+const uint8_t kSPDRegister		= 0x21;
+const uint8_t kAVIRegister		= 0x22;
+
+//! @brief 5.1 LPCM, 16 bit, 48 kHz: CA 0x0B = FL FR LFE FC RL RR
+static HDMI_GENERIC_INFOFRAME MakeAudioFrame51()
+{
+	return EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_A, 1, { 0x15, 0x0D, 0x00, 0x0B, 0x00, 0, 0, 0, 0, 0 });
+}
+
+static void SetInfoFrame(EGAVSimulatedHID& ioHID, uint8_t inRegister, const HDMI_GENERIC_INFOFRAME& inFrame)
+{
+	ioHID.SetRegisters((uint8_t)I2CAddress::MCU, inRegister, &inFrame, sizeof(inFrame));
+}
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(InfoFramesWithoutRegisterAreNotSupported)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	SetInfoFrame(*hid, kAudioRegister, MakeAudioFrame51());
+
+	HDMI_AUDIO_INFO audio;
+	HDMI_SPD_INFO spd;
+	int value = 0;
+	EGAV_CHECK_RESULT(device.GetHDMIAudioInfo(audio), EGAVResult::ErrNotSupported);
+	EGAV_CHECK_RESULT(device.GetHDMISourceProductDescription(spd), EGAVResult::ErrNotSupported);
+	EGAV_CHECK_RESULT(device.GetHDMIContentType(value), EGAVResult::ErrNotSupported);
+	EGAV_CHECK_RESULT(device.GetPixelRepetitionFactor(value), EGAVResult::ErrNotSupported);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), (size_t)0);
+}
+
+EGAV_TEST(AudioInfoFrameDecodeAndRemap)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	device.SetInfoFrameRegister(HDMI_INFOFRAME_TYPE_A, kAudioRegister);
+	SetInfoFrame(*hid, kAudioRegister, MakeAudioFrame51());
+
+	HDMI_AUDIO_INFO info;
+	EGAV_CHECK_RESULT(device.GetHDMIAudioInfo(info), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(info.channelCount, 6);
+	EGAV_CHECK_EQUAL(info.sampleSize, 16);
+	EGAV_CHECK_EQUAL(info.sampleRate, 48000);
+	EGAV_CHECK_EQUAL(info.slotCount, 6);
+	EGAV_CHECK_EQUAL(info.slotSpeakers[2], (uint32_t)HDMI_A_SPEAKER_LFE);
+	EGAV_CHECK_EQUAL(info.slotSpeakers[3], (uint32_t)HDMI_A_SPEAKER_FC);
+	EGAV_CHECK_EQUAL(info.speakerMask, (uint32_t)(HDMI_A_SPEAKER_FL | HDMI_A_SPEAKER_FR | HDMI_A_SPEAKER_FC | HDMI_A_SPEAKER_LFE |
+												  HDMI_A_SPEAKER_SL | HDMI_A_SPEAKER_SR));
+
+	// Slot order FL FR LFE FC RL RR --> canonical FL FR FC LFE SL SR, SIMD and scalar path
+	for (bool simd : { true, false })
+	{
+		HDMIAudioRemapper remapper;
+		remapper.SetSIMDEnabled(simd);
+		EGAV_CHECK_RESULT(remapper.Setup(info, 2), EGAVResult::Ok);
+		EGAV_CHECK_EQUAL(remapper.GetInputChannels(), 6);
+		EGAV_CHECK_EQUAL(remapper.GetOutputChannels(), 6);
+
+		const size_t frames = 37;
+		std::vector<int16_t> in(frames * 6), out(frames * 6);
+		for (size_t f = 0; f < frames; f++)
+			for (int slot = 0; slot < 6; slot++)
+				in[f * 6 + slot] = (int16_t)(f * 16 + slot);
+		EGAV_CHECK_RESULT(remapper.Process((const uint8_t*)in.data(), (uint8_t*)out.data(), frames), EGAVResult::Ok);
+
+		static const int kExpectedSlot[6] = { 0, 1, 3, 2, 4, 5 };
+		int mismatches = 0;
+		for (size_t f = 0; f < frames; f++)
+			for (int channel = 0; channel < 6; channel++)
+				if (out[f * 6 + channel] != (int16_t)(f * 16 + kExpectedSlot[channel]))
+					mismatches++;
+		EGAV_CHECK_EQUAL(mismatches, 0);
+	}
+}
+
+EGAV_TEST(AudioInfoFrameErrors)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	device.SetInfoFrameRegister(HDMI_INFOFRAME_TYPE_A, kAudioRegister);
+	HDMI_AUDIO_INFO info;
+
+	// Source doesn't send audio info frames: empty register
+	EGAV_CHECK_RESULT(device.GetHDMIAudioInfo(info), EGAVResult::ErrNoData);
+
+	HDMI_GENERIC_INFOFRAME frame = MakeAudioFrame51();
+	frame.bChecksum ^= 0x55;
+	SetInfoFrame(*hid, kAudioRegister, frame);
+	EGAV_CHECK_RESULT(device.GetHDMIAudioInfo(info), EGAVResult::ErrInvalidFormat);
+
+	hid->FailNextTransfers(1);
+	EGAV_CHECK(device.GetHDMIAudioInfo(info).Failed());
+}
+
+EGAV_TEST(SPDInfoFrame)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	device.SetInfoFrameRegister(HDMI_INFOFRAME_TYPE_SPD, kSPDRegister);
+
+	std::vector<uint8_t> payload(25, 0);
+	memcpy(&payload[0], "SONY    ", 8);
+	memcpy(&payload[8], "PS5", 3);
+	payload[24] = 0x08;
+	SetInfoFrame(*hid, kSPDRegister, EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_SPD, 1, payload));
+
+	HDMI_SPD_INFO info;
+	EGAV_CHECK_RESULT(device.GetHDMISourceProductDescription(info), EGAVResult::Ok);
+	EGAV_CHECK(info.vendorName == "SONY");
+	EGAV_CHECK(info.productDescription == "PS5");
+	EGAV_CHECK_EQUAL(info.bSourceInformation, 0x08);
+}
+
+EGAV_TEST(SPDInfoFrameOversizedLength)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	device.SetInfoFrameRegister(HDMI_INFOFRAME_TYPE_SPD, kSPDRegister);
+
+	// A length beyond the 27 payload bytes must be rejected before the checksum walks past the frame
+	HDMI_GENERIC_INFOFRAME frame = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_SPD, 1, std::vector<uint8_t>(25, 0x20));
+	for (uint8_t length : { (uint8_t)(HDMI_MAX_INFOFRAME_PAYLOAD + 1), (uint8_t)0xFF })
+	{
+		frame.header.bPayloadLength = length;
+		HDMI_SPD_INFO info;
+		EGAV_CHECK(!HDMI_SPD_Decode(frame, info));
+
+		SetInfoFrame(*hid, kSPDRegister, frame);
+		EGAV_CHECK_RESULT(device.GetHDMISourceProductDescription(info), EGAVResult::ErrInvalidFormat);
+	}
+}
+
+EGAV_TEST(AVIInfoFrame)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	device.SetInfoFrameRegister(HDMI_INFOFRAME_TYPE_AVI, kAVIRegister);
+
+	// ITC set, content type 3 (game), pixel repetition 1 (sent twice)
+	std::vector<uint8_t> payload(13, 0);
+	payload[2] = 0x80;
+	payload[4] = 0x31;
+	SetInfoFrame(*hid, kAVIRegister, EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_AVI, 2, payload));
+
+	int contentType = HDMI_ERROR, factor = 0;
+	EGAV_CHECK_RESULT(device.GetHDMIContentType(contentType), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(contentType, 3);
+	EGAV_CHECK_RESULT(device.GetPixelRepetitionFactor(factor), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(factor, 2);
+
+	// The DR packet keeps its built-in register
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAV_CHECK_RESULT(device.GetHDMIInfoFrame(HDMI_INFOFRAME_TYPE_DR, frame), EGAVResult::ErrNoData);
+}
+
+EGAV_TEST(OnlyDRPacketIsJournaled)
+{
+	const std::string path = EGAVTest_GetTempPath("journal_types.bin");
+	EGAVTest_GetTempPath("journal_types.bin.idx");
+
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	device.SetInfoFrameRegister(HDMI_INFOFRAME_TYPE_A, kAudioRegister);
+	SetInfoFrame(*hid, kAudioRegister, MakeAudioFrame51());
+
+	auto journal = std::make_shared<HDMIInfoFrameJournalWriter>();
+	EGAV_CHECK_RESULT(journal->Open(path, deviceIDHD60X), EGAVResult::Ok);
+	device.SetInfoFrameJournal(journal);
+
+	HDMI_AUDIO_INFO info;
+	EGAV_CHECK_RESULT(device.GetHDMIAudioInfo(info), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(journal->Flush(), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL((size_t)std::filesystem::file_size(path), sizeof(HDMI_JOURNAL_FILEHEADER));
+
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAV_CHECK_RESULT(device.GetHDMIHDRStatusPacket(frame), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(journal->Flush(), EGAVResult::Ok);
+	EGAV_CHECK((size_t)std::filesystem::file_size(path) > sizeof(HDMI_JOURNAL_FILEHEADER));
+}
+
+EGAV_TEST_MAIN()
@@ -0,0 +1,293 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		TestHDRMetadataExport.cpp
+
+@brief		HDRMetadataExporter against golden vectors: HEVC SEI, AV1 metadata
+			OBUs and Matroska Colour values of two DR info frames
+
+			The vectors are written out from the specifications, independent of
+			the implementation:
+			- Display P3, 1000 / 0.0001 cd/m2, MaxCLL 1000, MaxFALL 400, PQ, primaries
+			  sent in G, B, R order. This is the mastering display of most HDR10
+			  releases (x265: G(13250,34500)B(7500,3000)R(34000,16000)WP(15635,16450)L(10000000,1)).
+			- BT.2020, 4000 / 0.005 cd/m2, no content light level, HLG, primaries sent
+			  in R, G, B order.
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "HDRMetadataExport.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+//==============================================================================
+// # Golden vectors
+//==============================================================================
+
+//! DR info frame payloads (CTA-861.3 table 5, little endian)
+static const std::vector<uint8_t> kP3Payload =
+{
+	0x02, 0x00,													// ST 2084, static metadata type 1
+	0xC2, 0x33, 0xC4, 0x86,										// G 13250, 34500
+	0x4C, 0x1D, 0xB8, 0x0B,										// B  7500,  3000
+	0xD0, 0x84, 0x80, 0x3E,										// R 34000, 16000
+	0x13, 0x3D, 0x42, 0x40,										// white point 15635, 16450
+	0xE8, 0x03, 0x01, 0x00,										// 1000 cd/m2, 0.0001 cd/m2
+	0xE8, 0x03, 0x90, 0x01,										// MaxCLL 1000, MaxFALL 400
+};
+
+static const std::vector<uint8_t> kBT2020Payload =
+{
+	0x03, 0x00,													// HLG, static metadata type 1
+	0x48, 0x8A, 0x08, 0x39,										// R 35400, 14600
+	0x34, 0x21, 0xAA, 0x9B,										// G  8500, 39850
+	0x96, 0x19, 0xFC, 0x08,										// B  6550,  2300
+	0x13, 0x3D, 0x42, 0x40,										// white point 15635, 16450
+	0xA0, 0x0F, 0x32, 0x00,										// 4000 cd/m2, 0.005 cd/m2
+	0x00, 0x00, 0x00, 0x00,										// no MaxCLL, MaxFALL
+};
+
+//! Prefix SEI NAL units (H.265 7.3.1, D.2.28, D.2.35): G, B, R, big endian, luminance in 0.0001 cd/m2
+static const std::vector<uint8_t> kP3SEINALUnit =
+{
+	0x4E, 0x01,													// nal_unit_type 39, nuh_temporal_id_plus1 1
+	0x89, 0x18,													// mastering_display_colour_volume, 24 bytes
+	0x33, 0xC2, 0x86, 0xC4, 0x1D, 0x4C, 0x0B, 0xB8, 0x84, 0xD0, 0x3E, 0x80,
+	0x3D, 0x13, 0x40, 0x42,
+	0x00, 0x98, 0x96, 0x80,										// 10000000
+	0x00, 0x00, 0x03, 0x00, 0x01,								// 1, emulation prevention byte
+	0x90, 0x04,													// content_light_level_info, 4 bytes
+	0x03, 0xE8, 0x01, 0x90,
+	0x80,														// rbsp_trailing_bits
+};
+
+static const std::vector<uint8_t> kBT2020SEINALUnit =
+{
+	0x4E, 0x01,
+	0x89, 0x18,
+	0x21, 0x34, 0x9B, 0xAA, 0x19, 0x96, 0x08, 0xFC, 0x8A, 0x48, 0x39, 0x08,
+	0x3D, 0x13, 0x40, 0x42,
+	0x02, 0x62, 0x5A, 0x00,										// 40000000
+	0x00, 0x03, 0x00, 0x00, 0x32,								// 50, emulation prevention byte
+	0x90, 0x04,
+	0x00, 0x00, 0x03, 0x00, 0x00,								// 0, 0, emulation prevention byte
+	0x80,
+};
+
+//! AV1 metadata OBUs (AV1 5.8.3, 6.7.4): R, G, B in 0.16, max. luminance 24.8, min. luminance 18.14 fixed point
+static const std::vector<uint8_t> kP3MDCVOBU =
+{
+	0x2A, 0x1A, 0x02,											// OBU_METADATA with size 26, METADATA_TYPE_HDR_MDCV
+	0xAE, 0x14, 0x51, 0xEC,										// R 0.68, 0.32
+	0x43, 0xD7, 0xB0, 0xA4,										// G 0.265, 0.69
+	0x26, 0x66, 0x0F, 0x5C,										// B 0.15, 0.06
+	0x50, 0x0D, 0x54, 0x39,										// white point 0.3127, 0.329
+	0x00, 0x03, 0xE8, 0x00,										// 1000
+	0x00, 0x00, 0x00, 0x02,										// 0.0001 (rounded to 2 / 16384)
+	0x80,														// trailing_bits
+};
+
+static const std::vector<uint8_t> kBT2020MDCVOBU =
+{
+	0x2A, 0x1A, 0x02,
+	0xB5, 0x3F, 0x4A, 0xC1,										// R 0.708, 0.292
+	0x2B, 0x85, 0xCC, 0x08,										// G 0.17, 0.797
+	0x21, 0x89, 0x0B, 0xC7,										// B 0.131, 0.046
+	0x50, 0x0D, 0x54, 0x39,
+	0x00, 0x0F, 0xA0, 0x00,										// 4000
+	0x00, 0x00, 0x00, 0x52,										// 0.005 (82 / 16384)
+	0x80,
+};
+
+static const std::vector<uint8_t> kP3CLLOBU			= { 0x2A, 0x06, 0x01, 0x03, 0xE8, 0x01, 0x90, 0x80 };
+static const std::vector<uint8_t> kBT2020CLLOBU		= { 0x2A, 0x06, 0x01, 0x00, 0x00, 0x00, 0x00, 0x80 };
+
+
+//==============================================================================
+// # Helpers
+//==============================================================================
+
+template <typename Container>
+static bool BytesEqual(const Container& inActual, const std::vector<uint8_t>& inExpected)
+{
+	if (inActual.size() != inExpected.size())
+	{
+		fprintf(stderr, "size %zu, expected %zu\n", inActual.size(), inExpected.size());
+		return false;
+	}
+	for (size_t i = 0; i < inExpected.size(); i++)
+	{
+		if (inActual[i] != inExpected[i])
+		{
+			fprintf(stderr, "byte %zu: 0x%02X, expected 0x%02X\n", i, inActual[i], inExpected[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool Near(float inActual, float inExpected)
+{
+	return std::fabs(inActual - inExpected) <= 1e-6f * std::max(1.f, std::fabs(inExpected));
+}
+
+//! @brief SEI payload of one message: the bytes after payloadType and payloadSize, without emulation prevention
+static std::vector<uint8_t> Unescape(const std::vector<uint8_t>& inNAL, size_t inOffset, size_t inSize)
+{
+	std::vector<uint8_t> payload;
+	int zeros = 0;
+	for (size_t i = inOffset; i < inNAL.size() && payload.size() < inSize; i++)
+	{
+		if (zeros >= 2 && inNAL[i] == 3)
+		{
+			zeros = 0;
+			continue;
+		}
+		payload.push_back(inNAL[i]);
+		zeros = (inNAL[i] == 0) ? zeros + 1 : 0;
+	}
+	return payload;
+}
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(HEVCSEIMatchesGoldenVectors)
+{
+	HDRMetadataExport p3, bt2020;
+	EGAV_CHECK_RESULT(HDRMetadataExporter::Convert(EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, kP3Payload), p3), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(HDRMetadataExporter::Convert(EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, kBT2020Payload), bt2020), EGAVResult::Ok);
+
+	EGAV_CHECK(BytesEqual(p3.hevcSEINALUnit, kP3SEINALUnit));
+	EGAV_CHECK(BytesEqual(bt2020.hevcSEINALUnit, kBT2020SEINALUnit));
+
+	// The separate payloads are the NAL unit contents without emulation prevention
+	EGAV_CHECK(BytesEqual(p3.hevcMasteringDisplayColourVolume, Unescape(kP3SEINALUnit, 4, 24)));
+	EGAV_CHECK(BytesEqual(p3.hevcContentLightLevelInfo, std::vector<uint8_t>{ 0x03, 0xE8, 0x01, 0x90 }));
+	EGAV_CHECK(BytesEqual(bt2020.hevcMasteringDisplayColourVolume, Unescape(kBT2020SEINALUnit, 4, 24)));
+	EGAV_CHECK(BytesEqual(bt2020.hevcContentLightLevelInfo, std::vector<uint8_t>{ 0, 0, 0, 0 }));
+}
+
+EGAV_TEST(AV1OBUsMatchGoldenVectors)
+{
+	HDRMetadataExport p3, bt2020;
+	EGAV_CHECK_RESULT(HDRMetadataExporter::Convert(EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, kP3Payload), p3), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(HDRMetadataExporter::Convert(EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, kBT2020Payload), bt2020), EGAVResult::Ok);
+
+	EGAV_CHECK(BytesEqual(p3.av1MasteringDisplayOBU, kP3MDCVOBU));
+	EGAV_CHECK(BytesEqual(p3.av1ContentLightLevelOBU, kP3CLLOBU));
+	EGAV_CHECK(BytesEqual(bt2020.av1MasteringDisplayOBU, kBT2020MDCVOBU));
+	EGAV_CHECK(BytesEqual(bt2020.av1ContentLightLevelOBU, kBT2020CLLOBU));
+}
+
+EGAV_TEST(MatroskaColourMatchesGoldenVectors)
+{
+	HDRMetadataExport p3, bt2020;
+	EGAV_CHECK_RESULT(HDRMetadataExporter::Convert(EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, kP3Payload), p3), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(HDRMetadataExporter::Convert(EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, kBT2020Payload), bt2020), EGAVResult::Ok);
+
+	// Matroska Colour: R, G, B chromaticities and luminance as plain floats
+	EGAV_CHECK_EQUAL(p3.mkv.matrixCoefficients, 9u);
+	EGAV_CHECK_EQUAL(p3.mkv.primaries, 9u);
+	EGAV_CHECK_EQUAL(p3.mkv.transferCharacteristics, 16u);
+	EGAV_CHECK_EQUAL(p3.mkv.maxCLL, 1000u);
+	EGAV_CHECK_EQUAL(p3.mkv.maxFALL, 400u);
+	EGAV_CHECK(Near(p3.mkv.primaryRChromaticityX, 0.68f));
+	EGAV_CHECK(Near(p3.mkv.primaryRChromaticityY, 0.32f));
+	EGAV_CHECK(Near(p3.mkv.primaryGChromaticityX, 0.265f));
+	EGAV_CHECK(Near(p3.mkv.primaryGChromaticityY, 0.69f));
+	EGAV_CHECK(Near(p3.mkv.primaryBChromaticityX, 0.15f));
+	EGAV_CHECK(Near(p3.mkv.primaryBChromaticityY, 0.06f));
+	EGAV_CHECK(Near(p3.mkv.whitePointChromaticityX, 0.3127f));
+	EGAV_CHECK(Near(p3.mkv.whitePointChromaticityY, 0.329f));
+	EGAV_CHECK(Near(p3.mkv.luminanceMax, 1000.f));
+	EGAV_CHECK(Near(p3.mkv.luminanceMin, 0.0001f));
+
+	EGAV_CHECK_EQUAL(bt2020.mkv.transferCharacteristics, 18u);
+	EGAV_CHECK_EQUAL(bt2020.mkv.maxCLL, 0u);
+	EGAV_CHECK_EQUAL(bt2020.mkv.maxFALL, 0u);
+	EGAV_CHECK(Near(bt2020.mkv.primaryRChromaticityX, 0.708f));
+	EGAV_CHECK(Near(bt2020.mkv.primaryRChromaticityY, 0.292f));
+	EGAV_CHECK(Near(bt2020.mkv.primaryGChromaticityX, 0.17f));
+	EGAV_CHECK(Near(bt2020.mkv.primaryGChromaticityY, 0.797f));
+	EGAV_CHECK(Near(bt2020.mkv.primaryBChromaticityX, 0.131f));
+	EGAV_CHECK(Near(bt2020.mkv.primaryBChromaticityY, 0.046f));
+	EGAV_CHECK(Near(bt2020.mkv.luminanceMax, 4000.f));
+	EGAV_CHECK(Near(bt2020.mkv.luminanceMin, 0.005f));
+
+	// SDR gamma: transfer characteristics unspecified
+	std::vector<uint8_t> sdrPayload = kP3Payload;
+	sdrPayload[0] = HDMI_DR_EOTF_SDRGAMMA;
+	HDRMetadataExport sdr;
+	EGAV_CHECK_RESULT(HDRMetadataExporter::Convert(EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, sdrPayload), sdr), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(sdr.mkv.transferCharacteristics, 2u);
+}
+
+EGAV_TEST(InvalidInfoFramesAreRejected)
+{
+	HDRMetadataExport out;
+
+	HDMI_GENERIC_INFOFRAME badChecksum = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, kP3Payload);
+	badChecksum.bChecksum++;
+	EGAV_CHECK_RESULT(HDRMetadataExporter::Convert(badChecksum, out), EGAVResult::ErrInvalidFormat);
+
+	EGAV_CHECK_RESULT(HDRMetadataExporter::Convert(EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_AVI, 2, kP3Payload), out), EGAVResult::ErrInvalidFormat);
+
+	std::vector<uint8_t> dynamicPayload = kP3Payload;
+	dynamicPayload[1] = 1;	// not static metadata type 1
+	EGAV_CHECK_RESULT(HDRMetadataExporter::Convert(EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, dynamicPayload), out), EGAVResult::ErrInvalidFormat);
+}
+
+EGAV_TEST(UpdateConvertsChangedFramesOnly)
+{
+	HDRMetadataExporter exporter;
+	const HDMI_GENERIC_INFOFRAME p3 = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, kP3Payload);
+	const HDMI_GENERIC_INFOFRAME bt2020 = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, kBT2020Payload);
+
+	auto first = exporter.Update(p3);
+	EGAV_CHECK(first != nullptr);
+	EGAV_CHECK(exporter.Update(p3) == first);
+	EGAV_CHECK(first && BytesEqual(first->hevcSEINALUnit, kP3SEINALUnit));
+
+	auto second = exporter.Update(bt2020);
+	EGAV_CHECK(second != nullptr && second != first);
+	EGAV_CHECK(second && BytesEqual(second->av1MasteringDisplayOBU, kBT2020MDCVOBU));
+	EGAV_CHECK(first && BytesEqual(first->av1MasteringDisplayOBU, kP3MDCVOBU));	// handed out exports don't change
+
+	HDMI_GENERIC_INFOFRAME invalid = p3;
+	invalid.bChecksum++;
+	EGAV_CHECK(exporter.Update(invalid) == nullptr);
+	EGAV_CHECK(exporter.GetCurrent() == nullptr);
+}
+
+
+EGAV_TEST_MAIN()
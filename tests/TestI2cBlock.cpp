@@ -0,0 +1,168 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		TestI2cBlock.cpp
+
+@brief		ReadI2cBlock() / WriteI2cBlock(): chunking, verification and errors
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "ElgatoUVCDevice.h"
+
+
+const uint8_t kAddress = 0x30;
+
+static std::vector<uint8_t> MakePattern(size_t inLength, uint8_t inSeed)
+{
+	std::vector<uint8_t> data(inLength);
+	for (size_t i = 0; i < inLength; i++)
+		data[i] = (uint8_t)(inSeed + i * 7);
+	return data;
+}
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(BlockRoundTrip)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+
+	const std::vector<uint8_t> data = MakePattern(256, 3);
+	EGAV_CHECK_RESULT(device.WriteI2cBlock(kAddress, 0, data.data(), data.size(), true), EGAVResult::Ok);
+	for (size_t i = 0; i < data.size(); i++)
+		EGAV_CHECK_EQUAL(hid->GetRegister(kAddress, (uint8_t)i), data[i]);
+
+	std::vector<uint8_t> readBack(256);
+	EGAV_CHECK_RESULT(device.ReadI2cBlock(kAddress, 0, readBack.data(), readBack.size(), true), EGAVResult::Ok);
+	EGAV_CHECK(readBack == data);
+}
+
+EGAV_TEST(LegacyBlockWrite)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(false);
+	ElgatoUVCDevice device(hid, deviceIDHD60SPlus);
+
+	const std::vector<uint8_t> data = MakePattern(70, 11);
+	EGAV_CHECK_RESULT(device.WriteI2cBlock(kAddress, 0x80, data.data(), data.size()), EGAVResult::Ok);
+	for (size_t i = 0; i < data.size(); i++)
+		EGAV_CHECK_EQUAL(hid->GetRegister(kAddress, (uint8_t)(0x80 + i)), data[i]);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), (size_t)3);
+}
+
+EGAV_TEST(BlockIsSplitIntoReports)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	hid->SetRegisters(kAddress, 0x10, MakePattern(100, 1).data(), 100);
+
+	// 100 bytes from 0x10: 32 + 32 + 32 + 4, auto-incrementing register
+	std::vector<uint8_t> data(100);
+	EGAV_CHECK_RESULT(device.ReadI2cBlock(kAddress, 0x10, data.data(), data.size()), EGAVResult::Ok);
+	EGAV_CHECK(data == MakePattern(100, 1));
+
+	const std::vector<EGAVSimulatedHID::Transaction> transactions = hid->GetTransactions();
+	EGAV_CHECK_EQUAL(transactions.size(), (size_t)4);
+	for (size_t i = 0; i < transactions.size() && i < 4; i++)
+	{
+		EGAV_CHECK(transactions[i].isRead);
+		EGAV_CHECK_EQUAL(transactions[i].reg, 0x10 + 32 * i);
+		EGAV_CHECK_EQUAL(transactions[i].length, (i < 3) ? 32 : 4);
+	}
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), (size_t)4);
+	EGAV_CHECK_EQUAL(hid->GetHIDReadCount(), (size_t)4);
+}
+
+EGAV_TEST(VerifiedReadRetriesOnce)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	hid->SetRegisters(kAddress, 0, MakePattern(64, 0).data(), 64);
+
+	// The registers change once during the first copy: the second and third copy match
+	int reads = 0;
+	hid->SetReadHook([&](uint8_t, uint8_t, uint8_t)
+	{
+		if (++reads == 2)
+			hid->SetRegisters(kAddress, 0, MakePattern(64, 50).data(), 64);
+	});
+
+	std::vector<uint8_t> data(64);
+	EGAV_CHECK_RESULT(device.ReadI2cBlock(kAddress, 0, data.data(), data.size(), true), EGAVResult::Ok);
+	EGAV_CHECK(data == MakePattern(64, 50));
+	EGAV_CHECK_EQUAL(reads, 6);
+}
+
+EGAV_TEST(VerifiedReadOfUnstableDataFails)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+
+	uint8_t counter = 0;
+	hid->SetReadHook([&](uint8_t, uint8_t, uint8_t) { counter++; hid->SetRegisters(kAddress, 0, &counter, 1); });
+
+	std::vector<uint8_t> data(64);
+	EGAV_CHECK_RESULT(device.ReadI2cBlock(kAddress, 0, data.data(), data.size(), true), EGAVResult::ErrInvalidState);
+
+	// Without verification the first copy is returned
+	EGAV_CHECK_RESULT(device.ReadI2cBlock(kAddress, 0, data.data(), data.size()), EGAVResult::Ok);
+}
+
+EGAV_TEST(VerifiedWriteDetectsMismatch)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+
+	// A read-only register: the device keeps its value
+	hid->SetReadHook([&](uint8_t, uint8_t, uint8_t) { const uint8_t value = 0xEE; hid->SetRegisters(kAddress, 5, &value, 1); });
+
+	const std::vector<uint8_t> data = MakePattern(40, 9);
+	EGAV_CHECK_RESULT(device.WriteI2cBlock(kAddress, 0, data.data(), data.size(), true), EGAVResult::ErrInvalidState);
+}
+
+EGAV_TEST(BlockErrors)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+
+	uint8_t data[64] = {};
+	EGAV_CHECK_RESULT(device.ReadI2cBlock(kAddress, 0xF0, data, 32), EGAVResult::ErrOutOfRange);
+	EGAV_CHECK_RESULT(device.WriteI2cBlock(kAddress, 0, data, 0), EGAVResult::ErrOutOfRange);
+	EGAV_CHECK_RESULT(device.ReadI2cBlock(kAddress, 0, nullptr, 32), EGAVResult::ErrNullPointer);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), (size_t)0);
+
+	// A failing transfer aborts the block
+	hid->FailNextTransfers(1);
+	EGAV_CHECK(device.ReadI2cBlock(kAddress, 0, data, sizeof(data)).Failed());
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), (size_t)1);
+}
+
+EGAV_TEST_MAIN()
@@ -0,0 +1,264 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		TestInfoFrameJournal.cpp
+
+@brief		HDMIInfoFrameJournalWriter/Reader: round trip, time ordering, clock records
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "HDMIInfoFrameJournal.h"
+#include "ElgatoUVCDevice.h"
+
+
+static HDMI_GENERIC_INFOFRAME MakeDRFrame(uint8_t inEOTF, uint16_t inMaxCLL = 1000)
+{
+	std::vector<uint8_t> payload(26, 0);
+	payload[0] = inEOTF;
+	payload[22] = (uint8_t)inMaxCLL;
+	payload[23] = (uint8_t)(inMaxCLL >> 8);
+	return EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, payload);
+}
+
+static bool FramesEqual(const HDMI_GENERIC_INFOFRAME& inA, const HDMI_GENERIC_INFOFRAME& inB)
+{
+	return memcmp(&inA, &inB, sizeof(inA)) == 0;
+}
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(JournalRoundTrip)
+{
+	const std::string path = EGAVTest_GetTempPath("journal_roundtrip.bin");
+	EGAVTest_GetTempPath("journal_roundtrip.bin.idx");
+
+	HDMIInfoFrameJournalWriter writer;
+	EGAV_CHECK_RESULT(writer.Open(path, deviceIDHD60X), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(2), 1000), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(2), 1500), EGAVResult::OkNoDataChanged);
+	EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(0), 2000), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(0, 400), 3000), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(writer.Close(), EGAVResult::Ok);
+
+	HDMIInfoFrameJournalReader reader;
+	EGAV_CHECK_RESULT(reader.Open(path), EGAVResult::Ok);
+	EGAV_CHECK(reader.GetDeviceID() == deviceIDHD60X);
+	EGAV_CHECK_EQUAL(reader.GetLastTimestamp(), 3000u);
+
+	HDMI_GENERIC_INFOFRAME frame{};
+	uint64_t changedAt = 0;
+	EGAV_CHECK_RESULT(reader.GetFrameAt(999, frame), EGAVResult::ErrNotFound);
+	EGAV_CHECK_RESULT(reader.GetFrameAt(1700, frame, &changedAt), EGAVResult::Ok);
+	EGAV_CHECK(FramesEqual(frame, MakeDRFrame(2)));
+	EGAV_CHECK_EQUAL(changedAt, 1000u);
+	EGAV_CHECK_RESULT(reader.GetFrameAt(2999, frame, &changedAt), EGAVResult::Ok);
+	EGAV_CHECK(FramesEqual(frame, MakeDRFrame(0)));
+	EGAV_CHECK_EQUAL(changedAt, 2000u);
+	EGAV_CHECK_RESULT(reader.GetFrameAt(100000, frame, &changedAt), EGAVResult::Ok);
+	EGAV_CHECK(FramesEqual(frame, MakeDRFrame(0, 400)));
+}
+
+EGAV_TEST(JournalRejectsTimestampRegression)
+{
+	const std::string path = EGAVTest_GetTempPath("journal_regression.bin");
+	EGAVTest_GetTempPath("journal_regression.bin.idx");
+
+	HDMIInfoFrameJournalWriter writer;
+	EGAV_CHECK_RESULT(writer.Open(path, deviceIDHD60X), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(2), 5000), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(0), 4000), EGAVResult::ErrInvalidParameter);
+
+	// Journal time continues after the last record, even if it is in the future of the wall clock
+	const uint64_t future = HDMIInfoFrameJournalWriter::GetWallClockNow() + 3600ull * 1000000;
+	EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(1), future), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(3)), EGAVResult::Ok);
+	writer.Close();
+
+	HDMIInfoFrameJournalReader reader;
+	EGAV_CHECK_RESULT(reader.Open(path), EGAVResult::Ok);
+	EGAV_CHECK(reader.GetLastTimestamp() >= future);
+}
+
+EGAV_TEST(JournalReopenContinuesTime)
+{
+	const std::string path = EGAVTest_GetTempPath("journal_reopen.bin");
+	EGAVTest_GetTempPath("journal_reopen.bin.idx");
+	const uint64_t future = HDMIInfoFrameJournalWriter::GetWallClockNow() + 3600ull * 1000000;
+	{
+		HDMIInfoFrameJournalWriter writer;
+		EGAV_CHECK_RESULT(writer.Open(path, deviceIDHD60X), EGAVResult::Ok);
+		EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(2), future), EGAVResult::Ok);
+	}
+	{
+		// A stepped back wall clock doesn't move journal time backwards
+		HDMIInfoFrameJournalWriter writer;
+		EGAV_CHECK_RESULT(writer.Open(path, deviceIDHD60X), EGAVResult::Ok);
+		EGAV_CHECK(writer.GetTimestamp() >= future);
+		EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(0)), EGAVResult::Ok);
+	}
+
+	HDMIInfoFrameJournalReader reader;
+	EGAV_CHECK_RESULT(reader.Open(path), EGAVResult::Ok);
+	HDMI_GENERIC_INFOFRAME frame{};
+	uint64_t changedAt = 0;
+	int64_t wallClockOffset = 0;
+	EGAV_CHECK_RESULT(reader.GetFrameAt(reader.GetLastTimestamp(), frame, &changedAt, &wallClockOffset), EGAVResult::Ok);
+	EGAV_CHECK(FramesEqual(frame, MakeDRFrame(0)));
+	EGAV_CHECK(changedAt >= future); // the clock continues at the last timestamp: equal if appended right away
+
+	// Journal time is ahead of the wall clock by about an hour: recorded as negative offset
+	EGAV_CHECK(wallClockOffset < -3500ll * 1000000 && wallClockOffset > -3700ll * 1000000);
+}
+
+EGAV_TEST(JournalRejectsOtherVersions)
+{
+	const std::string path = EGAVTest_GetTempPath("journal_v1.bin");
+	const std::string indexPath = EGAVTest_GetTempPath("journal_v1.bin.idx");
+
+	// A version 1 journal (no clock records) stays readable, but isn't appended to
+	HDMI_JOURNAL_FILEHEADER header{};
+	header.dwMagic           = HDMI_JOURNAL_MAGIC;
+	header.wVersion          = 1;
+	header.wKeyFrameInterval = HDMIInfoFrameJournalWriter::kKeyFrameInterval;
+	FILE* file = fopen(path.c_str(), "wb");
+	EGAV_CHECK(file != nullptr);
+	if (!file)
+		return;
+	fwrite(&header, sizeof(header), 1, file);
+	fclose(file);
+	file = fopen(indexPath.c_str(), "wb"); // empty index
+	if (file)
+		fclose(file);
+
+	HDMIInfoFrameJournalReader reader;
+	EGAV_CHECK_RESULT(reader.Open(path), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(reader.GetVersion(), 1);
+
+	HDMIInfoFrameJournalWriter writer;
+	EGAV_CHECK_RESULT(writer.Open(path, deviceIDHD60X), EGAVResult::ErrInvalidFormat);
+	EGAV_CHECK(writer.Append(MakeDRFrame(2)).Failed());
+	EGAV_CHECK_EQUAL((size_t)std::filesystem::file_size(path), sizeof(header));
+
+	// The failed Open() left nothing open
+	const std::string other = EGAVTest_GetTempPath("journal_v2.bin");
+	EGAVTest_GetTempPath("journal_v2.bin.idx");
+	EGAV_CHECK_RESULT(writer.Open(other, deviceIDHD60X), EGAVResult::Ok);
+}
+
+EGAV_TEST(JournalDropsPartialIndexEntry)
+{
+	const std::string path = EGAVTest_GetTempPath("journal_partial.bin");
+	const std::string indexPath = EGAVTest_GetTempPath("journal_partial.bin.idx");
+	{
+		HDMIInfoFrameJournalWriter writer;
+		EGAV_CHECK_RESULT(writer.Open(path, deviceIDHD60X), EGAVResult::Ok);
+		EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(2), 1000), EGAVResult::Ok);
+	}
+
+	// An index write that failed halfway
+	FILE* index = fopen(indexPath.c_str(), "ab");
+	EGAV_CHECK(index != nullptr);
+	if (!index)
+		return;
+	const uint8_t partial[5] = { 1, 2, 3, 4, 5 };
+	fwrite(partial, sizeof(partial), 1, index);
+	fclose(index);
+
+	{
+		HDMIInfoFrameJournalWriter writer;
+		EGAV_CHECK_RESULT(writer.Open(path, deviceIDHD60X), EGAVResult::Ok);
+		EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(0), 2000), EGAVResult::Ok); // key frame after reopening
+	}
+	EGAV_CHECK_EQUAL((size_t)std::filesystem::file_size(indexPath), 2 * sizeof(HDMI_JOURNAL_INDEXENTRY));
+
+	HDMIInfoFrameJournalReader reader;
+	EGAV_CHECK_RESULT(reader.Open(path), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(reader.GetKeyFrameCount(), (size_t)2);
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAV_CHECK_RESULT(reader.GetFrameAt(1500, frame), EGAVResult::Ok);
+	EGAV_CHECK(FramesEqual(frame, MakeDRFrame(2)));
+	EGAV_CHECK_RESULT(reader.GetFrameAt(2500, frame), EGAVResult::Ok);
+	EGAV_CHECK(FramesEqual(frame, MakeDRFrame(0)));
+}
+
+EGAV_TEST(JournalKeyFrames)
+{
+	const std::string path = EGAVTest_GetTempPath("journal_keyframes.bin");
+	EGAVTest_GetTempPath("journal_keyframes.bin.idx");
+
+	const int count = 5 * HDMIInfoFrameJournalWriter::kKeyFrameInterval;
+	HDMIInfoFrameJournalWriter writer;
+	EGAV_CHECK_RESULT(writer.Open(path, deviceIDHD60X), EGAVResult::Ok);
+	for (int i = 0; i < count; i++)
+		EGAV_CHECK_RESULT(writer.Append(MakeDRFrame(2, (uint16_t)(100 + i)), 1000 + 10 * (uint64_t)i), EGAVResult::Ok);
+	writer.Close();
+
+	HDMIInfoFrameJournalReader reader;
+	EGAV_CHECK_RESULT(reader.Open(path), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(reader.GetKeyFrameCount(), (size_t)5);
+	for (int i = 0; i < count; i += 7)
+	{
+		HDMI_GENERIC_INFOFRAME frame{};
+		EGAV_CHECK_RESULT(reader.GetFrameAt(1000 + 10 * (uint64_t)i + 5, frame), EGAVResult::Ok);
+		EGAV_CHECK(FramesEqual(frame, MakeDRFrame(2, (uint16_t)(100 + i))));
+	}
+}
+
+EGAV_TEST(JournalFromDeviceReads)
+{
+	const std::string path = EGAVTest_GetTempPath("journal_device.bin");
+	EGAVTest_GetTempPath("journal_device.bin.idx");
+
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	auto journal = std::make_shared<HDMIInfoFrameJournalWriter>();
+	EGAV_CHECK_RESULT(journal->Open(path, deviceIDHD60X), EGAVResult::Ok);
+	device.SetInfoFrameJournal(journal);
+
+	const HDMI_GENERIC_INFOFRAME hdr = MakeDRFrame(2);
+	hid->SetRegisters((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::GET_HDR_PACKET, &hdr, sizeof(hdr));
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAV_CHECK_RESULT(device.GetHDMIHDRStatusPacket(frame), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(device.GetHDMIHDRStatusPacket(frame), EGAVResult::Ok);
+
+	// A failing journal doesn't fail the read
+	journal->Close();
+	EGAV_CHECK_RESULT(device.GetHDMIHDRStatusPacket(frame), EGAVResult::Ok);
+	EGAV_CHECK(FramesEqual(frame, hdr));
+
+	HDMIInfoFrameJournalReader reader;
+	EGAV_CHECK_RESULT(reader.Open(path), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(reader.GetFrameAt(reader.GetLastTimestamp(), frame), EGAVResult::Ok);
+	EGAV_CHECK(FramesEqual(frame, hdr));
+}
+
+EGAV_TEST_MAIN()
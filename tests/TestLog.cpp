@@ -0,0 +1,110 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		TestLog.cpp
+
+@brief		EGAVLog record formatting compared with printf
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVLog.h"
+
+#include <cstdio>
+#include <string>
+
+
+template <typename... Args>
+static std::string Format(const char* inFormat, Args... inArgs)
+{
+	EGAVLogRecord record;
+	EGAVLog::FillRecord(record, EGAVLogLevel::Info, inFormat, inArgs...);
+	char buffer[256];
+	EGAVLog::FormatRecord(record, buffer, sizeof(buffer));
+	return buffer;
+}
+
+template <typename... Args>
+static std::string Printf(const char* inFormat, Args... inArgs)
+{
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer), inFormat, inArgs...);
+	return buffer;
+}
+
+#define CHECK_LIKE_PRINTF(format, ...) EGAV_CHECK(Format(format, __VA_ARGS__) == Printf(format, __VA_ARGS__))
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(SignedArgumentsKeepTheirWidth)
+{
+	// Not sign-extended to 64 bits
+	EGAV_CHECK(Format("%x", -1) == "ffffffff");
+	CHECK_LIKE_PRINTF("%x", -1);
+	CHECK_LIKE_PRINTF("%X", (int)-2);
+	CHECK_LIKE_PRINTF("%u", -1);
+	CHECK_LIKE_PRINTF("%o", -8);
+	CHECK_LIKE_PRINTF("%08x", (short)-1);			// promoted to int
+	CHECK_LIKE_PRINTF("%x", (int8_t)-128);
+	CHECK_LIKE_PRINTF("%llx", (long long)-1);
+	CHECK_LIKE_PRINTF("%lld %d", (long long)INT64_MIN, INT32_MIN);
+}
+
+EGAV_TEST(LengthModifiersNarrow)
+{
+	EGAV_CHECK(Format("%hx", -1) == "ffff");
+	CHECK_LIKE_PRINTF("%hx", -1);
+	CHECK_LIKE_PRINTF("%hhx", -1);
+	CHECK_LIKE_PRINTF("%hu", 70000);
+	CHECK_LIKE_PRINTF("%hd", 40000);
+	CHECK_LIKE_PRINTF("%hhd", 200);
+	CHECK_LIKE_PRINTF("%hhu", 0x1FF);
+}
+
+EGAV_TEST(UnsignedArguments)
+{
+	CHECK_LIKE_PRINTF("%u", 4000000000u);
+	CHECK_LIKE_PRINTF("%d", 4000000000u);			// reinterpreted as int, as printf does
+	CHECK_LIKE_PRINTF("%x", (uint8_t)0xAB);
+	CHECK_LIKE_PRINTF("%llu", (unsigned long long)UINT64_MAX);
+	CHECK_LIKE_PRINTF("%zu", sizeof(EGAVLogRecord));
+}
+
+EGAV_TEST(OtherConversions)
+{
+	CHECK_LIKE_PRINTF("%s=%d (%.2f) %c", "value", 42, 3.14159, 'x');
+	CHECK_LIKE_PRINTF("%-6s|%5d|%*d", "ab", -7, 4, 3);
+	CHECK_LIKE_PRINTF("%d%%", 100);
+	CHECK_LIKE_PRINTF("%d", true);
+	EGAV_CHECK(Format("%d %d", 1) == "1 (?)");
+}
+
+
+EGAV_TEST_MAIN()
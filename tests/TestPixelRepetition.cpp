@@ -0,0 +1,178 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		TestPixelRepetition.cpp
+
+@brief		HDMI pixel repetition removal: NV12, P010 and YUY2 with the SSE2 and
+			the scalar kernels against a per-pixel reference, for all repetition
+			factors, row tails and padded strides
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVTestFrames.h"
+#include "HDMIPixelRepetition.h"
+
+
+//! @brief Planar or packed test image with padded rows; the padding is filled with a guard value
+struct TestPlane
+{
+	int						stride	= 0;
+	int						rows	= 0;
+	std::vector<uint8_t>	data;
+
+	TestPlane(int inRowBytes, int inRows, int inPadding) : stride(inRowBytes + inPadding), rows(inRows), data((size_t)stride * inRows, kGuard) {}
+
+	uint8_t* Row(int inRow) { return data.data() + (size_t)inRow * stride; }
+	const uint8_t* Row(int inRow) const { return data.data() + (size_t)inRow * stride; }
+
+	void FillRandom(int inRowBytes, uint32_t inSeed)
+	{
+		EGAVTestRandom random(inSeed);
+		for (int row = 0; row < rows; row++)
+			for (int i = 0; i < inRowBytes; i++)
+				Row(row)[i] = (uint8_t)random.Next();
+	}
+
+	static constexpr uint8_t kGuard = 0xA5;
+};
+
+//! @brief Reference for one plane: element x of the output is element x * factor of the input
+static TestPlane ReferencePlane(const TestPlane& inPlane, int inElementSize, int inOutCount, int inFactor, int inPadding)
+{
+	TestPlane out(inOutCount * inElementSize, inPlane.rows, inPadding);
+	for (int row = 0; row < inPlane.rows; row++)
+		for (int x = 0; x < inOutCount; x++)
+			memcpy(out.Row(row) + x * inElementSize, inPlane.Row(row) + x * inFactor * inElementSize, inElementSize);
+	return out;
+}
+
+//! @brief YUY2 reference: luma of pixel x * factor, chroma of the macropixel that holds pixel 2k * factor
+static TestPlane ReferenceYUY2(const TestPlane& inImage, int inOutWidth, int inFactor, int inPadding)
+{
+	TestPlane out(inOutWidth * 2, inImage.rows, inPadding);
+	for (int row = 0; row < inImage.rows; row++)
+	{
+		const uint8_t* in = inImage.Row(row);
+		for (int x = 0; x < inOutWidth; x++)
+		{
+			out.Row(row)[2 * x] = in[2 * (x * inFactor)];
+			const int sourceMacropixel = (x & ~1) * inFactor / 2;
+			out.Row(row)[2 * x + 1] = in[4 * sourceMacropixel + 1 + 2 * (x & 1)];
+		}
+	}
+	return out;
+}
+
+//! Input widths: SD (1440 = 720 x 2), tails of every length for the SIMD loops, odd remainders
+static const int kWidths[]	= { 1440, 2880, 1442, 1446, 1470, 726, 38, 22, 10 };
+static const int kHeight	= 6;
+static const int kPadding	= 24;
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(NV12AndP010MatchReference)
+{
+	for (int bytesPerSample : { 1, 2 })
+	{
+		for (int width : kWidths)
+		{
+			TestPlane y(width * bytesPerSample, kHeight, kPadding), uv(width * bytesPerSample, kHeight / 2, kPadding);
+			y.FillRandom(width * bytesPerSample, (uint32_t)width);
+			uv.FillRandom(width * bytesPerSample, (uint32_t)width + 1);
+
+			for (int factor = 1; factor <= HDMI_AVI_PR_9 + 1; factor++)
+			{
+				const int outWidth = HDMI_GetDecimatedWidth(width, factor);
+				if (outWidth <= 0)
+					continue;
+				const TestPlane expectedY  = ReferencePlane(y, bytesPerSample, outWidth, factor, kPadding);
+				const TestPlane expectedUV = ReferencePlane(uv, 2 * bytesPerSample, outWidth / 2, factor, kPadding);
+
+				for (bool simd : { true, false })
+				{
+					TestPlane outY(outWidth * bytesPerSample, kHeight, kPadding), outUV(outWidth * bytesPerSample, kHeight / 2, kPadding);
+					auto function = (bytesPerSample == 1) ? HDMI_RemovePixelRepetitionNV12 : HDMI_RemovePixelRepetitionP010;
+					EGAV_CHECK_RESULT(function(y.data.data(), y.stride, uv.data.data(), uv.stride,
+											   outY.data.data(), outY.stride, outUV.data.data(), outUV.stride,
+											   width, kHeight, factor, simd), EGAVResult::Ok);
+					if (outY.data != expectedY.data || outUV.data != expectedUV.data)
+						fprintf(stderr, "%s, width %d, factor %d, %s\n", bytesPerSample == 1 ? "NV12" : "P010", width, factor, simd ? "SIMD" : "scalar");
+					EGAV_CHECK(outY.data == expectedY.data);		// includes the padding: nothing written past the output width
+					EGAV_CHECK(outUV.data == expectedUV.data);
+				}
+			}
+		}
+	}
+}
+
+EGAV_TEST(YUY2MatchesReference)
+{
+	for (int width : kWidths)
+	{
+		TestPlane image(width * 2, kHeight, kPadding);
+		image.FillRandom(width * 2, (uint32_t)width);
+
+		for (int factor = 1; factor <= HDMI_AVI_PR_9 + 1; factor++)
+		{
+			const int outWidth = HDMI_GetDecimatedWidth(width, factor);
+			if (outWidth <= 0)
+				continue;
+			const TestPlane expected = ReferenceYUY2(image, outWidth, factor, kPadding);
+
+			for (bool simd : { true, false })
+			{
+				TestPlane out(outWidth * 2, kHeight, kPadding);
+				EGAV_CHECK_RESULT(HDMI_RemovePixelRepetitionYUY2(image.data.data(), image.stride, out.data.data(), out.stride,
+																 width, kHeight, factor, simd), EGAVResult::Ok);
+				if (out.data != expected.data)
+					fprintf(stderr, "YUY2, width %d, factor %d, %s\n", width, factor, simd ? "SIMD" : "scalar");
+				EGAV_CHECK(out.data == expected.data);
+			}
+		}
+	}
+}
+
+EGAV_TEST(InvalidParametersAreRejected)
+{
+	std::vector<uint8_t> in(64 * 4 * 2), out(64 * 4 * 2);
+	uint8_t* p = in.data();
+	uint8_t* q = out.data();
+
+	EGAV_CHECK_RESULT(HDMI_RemovePixelRepetitionNV12(p, 64, p, 64, q, 64, q, 64, 64, 4, 0, true), EGAVResult::ErrInvalidParameter);
+	EGAV_CHECK_RESULT(HDMI_RemovePixelRepetitionNV12(p, 64, p, 64, q, 64, q, 64, 64, 4, HDMI_AVI_PR_9 + 2, true), EGAVResult::ErrInvalidParameter);
+	EGAV_CHECK_RESULT(HDMI_RemovePixelRepetitionNV12(p, 64, p, 64, q, 64, q, 64, 64, 3, 2, true), EGAVResult::ErrInvalidParameter);		// odd height
+	EGAV_CHECK_RESULT(HDMI_RemovePixelRepetitionP010(p, 128, p, 128, q, 128, q, 128, 3, 4, 2, true), EGAVResult::ErrInvalidParameter);	// no output pixels
+	EGAV_CHECK_RESULT(HDMI_RemovePixelRepetitionP010(p, 128, nullptr, 128, q, 128, q, 128, 64, 4, 2, true), EGAVResult::ErrNullPointer);
+	EGAV_CHECK_RESULT(HDMI_RemovePixelRepetitionYUY2(p, 128, q, 128, 64, 0, 2, true), EGAVResult::ErrInvalidParameter);
+	EGAV_CHECK_RESULT(HDMI_RemovePixelRepetitionYUY2(p, 128, nullptr, 128, 64, 4, 2, true), EGAVResult::ErrNullPointer);
+}
+
+
+EGAV_TEST_MAIN()
@@ -0,0 +1,195 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		TestProcessLock.cpp
+
+@brief		EGAVProcessLock: file handling and mutual exclusion between processes
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVProcessLock.h"
+#include "ElgatoUVCQuirks.h"
+
+#if !_UP_WINDOWS
+
+#include <filesystem>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+//! @brief Empty directory for the lock files of one test
+static std::string MakeLockDirectory(const std::string& inName)
+{
+	const std::string directory = EGAVTest_GetTempPath(inName);
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+	std::filesystem::create_directory(directory, error);
+	return directory;
+}
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(DefaultDirectory)
+{
+	const std::string name = EGAVProcessLock::GetLockName(deviceIDHD60X);
+	EGAV_CHECK(name.rfind(std::string(EGAV_PROCESS_LOCK_DIRECTORY) + "/", 0) == 0);
+	EGAV_CHECK(EGAVProcessLock::GetLockName(deviceIDHD60X, "/var/lock/egav").rfind("/var/lock/egav/egav-", 0) == 0);
+}
+
+EGAV_TEST(CreatesWithoutWorldAccess)
+{
+	const std::string directory = MakeLockDirectory("lock_create");
+	const std::string name = directory + "/device.lock";
+
+	const mode_t previousMask = umask(0);
+	EGAVProcessLock lock;
+	EGAV_CHECK_RESULT(lock.Open(name), EGAVResult::Ok);
+	umask(previousMask);
+
+	struct stat info;
+	EGAV_CHECK(stat(name.c_str(), &info) == 0);
+	EGAV_CHECK_EQUAL(info.st_mode & 0777, 0660);
+
+	// Existing file: opened as is
+	EGAVProcessLock second;
+	EGAV_CHECK_RESULT(second.Open(name), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(second.Lock(), EGAVResult::Ok);
+	second.Unlock();
+}
+
+EGAV_TEST(GroupAccessUnderUmask)
+{
+	const std::string directory = MakeLockDirectory("lock_umask");
+	const std::string name = directory + "/device.lock";
+
+	// The usual umask would leave 0640: other users of the group couldn't share the lock
+	const mode_t previousMask = umask(022);
+	EGAVProcessLock lock;
+	EGAV_CHECK_RESULT(lock.Open(name), EGAVResult::Ok);
+	umask(previousMask);
+
+	struct stat info;
+	EGAV_CHECK(stat(name.c_str(), &info) == 0);
+	EGAV_CHECK_EQUAL(info.st_mode & 0777, 0660);
+
+	// Read access is enough to take the lock
+	EGAV_CHECK(chmod(name.c_str(), 0440) == 0);
+	EGAVProcessLock readOnly;
+	EGAV_CHECK_RESULT(readOnly.Open(name), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(readOnly.Lock(), EGAVResult::Ok);
+	readOnly.Unlock();
+}
+
+EGAV_TEST(RejectsSymlinksAndMissingDirectories)
+{
+	const std::string directory = MakeLockDirectory("lock_symlink");
+	const std::string target = directory + "/target";
+	const std::string link = directory + "/device.lock";
+	EGAV_CHECK(symlink(target.c_str(), link.c_str()) == 0);
+
+	EGAVProcessLock lock;
+	EGAV_CHECK_RESULT(lock.Open(link), EGAVResult::ErrCouldNotOpenFile);
+	EGAV_CHECK(!lock.IsOpen());
+	EGAV_CHECK(access(target.c_str(), F_OK) != 0); // nothing created through the link
+
+	EGAV_CHECK_RESULT(lock.Open(directory), EGAVResult::ErrCouldNotOpenFile);
+	EGAV_CHECK_RESULT(lock.Open(directory + "/missing/device.lock"), EGAVResult::ErrCouldNotOpenFile);
+}
+
+EGAV_TEST(MultiProcessStress)
+{
+	const std::string directory = MakeLockDirectory("lock_stress");
+	const std::string name = directory + "/device.lock";
+	const std::string counterPath = directory + "/counter";
+	const int kProcesses = 8;
+	const int kIterations = 500;
+
+	// A read-modify-write of the counter file with a yield in between loses increments unless the lock works
+	int counterFD = open(counterPath.c_str(), O_RDWR | O_CREAT, 0600);
+	EGAV_CHECK(counterFD >= 0);
+	uint32_t zero = 0;
+	EGAV_CHECK(pwrite(counterFD, &zero, sizeof(zero), 0) == (ssize_t)sizeof(zero));
+	close(counterFD);
+
+	std::vector<pid_t> children;
+	for (int p = 0; p < kProcesses; p++)
+	{
+		const pid_t pid = fork();
+		if (pid == 0)
+		{
+			// All processes race to create the lock file
+			EGAVProcessLock lock;
+			int fd = open(counterPath.c_str(), O_RDWR);
+			if (lock.Open(name).Failed() || fd < 0)
+				_exit(2);
+			for (int i = 0; i < kIterations; i++)
+			{
+				if (lock.Lock().Failed())
+					_exit(3);
+				uint32_t value = 0;
+				if (pread(fd, &value, sizeof(value), 0) != (ssize_t)sizeof(value))
+					_exit(4);
+				sched_yield();
+				value++;
+				if (pwrite(fd, &value, sizeof(value), 0) != (ssize_t)sizeof(value))
+					_exit(4);
+				lock.Unlock();
+			}
+			close(fd);
+			_exit(0);
+		}
+		EGAV_CHECK(pid > 0);
+		if (pid > 0)
+			children.push_back(pid);
+	}
+
+	for (pid_t pid : children)
+	{
+		int status = 0;
+		EGAV_CHECK(waitpid(pid, &status, 0) == pid);
+		EGAV_CHECK(WIFEXITED(status));
+		EGAV_CHECK_EQUAL(WEXITSTATUS(status), 0);
+	}
+
+	uint32_t value = 0;
+	counterFD = open(counterPath.c_str(), O_RDONLY);
+	EGAV_CHECK(pread(counterFD, &value, sizeof(value), 0) == (ssize_t)sizeof(value));
+	close(counterFD);
+	EGAV_CHECK_EQUAL(value, (uint32_t)(kProcesses * kIterations));
+}
+
+#endif
+
+
+EGAV_TEST_MAIN()
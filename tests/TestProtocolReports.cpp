@@ -0,0 +1,187 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		TestProtocolReports.cpp
+
+@brief		Golden bytes of the LegacyProtocol and NewProtocol messages and of
+			their hidraw report framing
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "ElgatoUVCProtocol.h"
+#if defined(__linux__)
+	#include "EGAVHIDRawReports.h"
+#endif
+
+
+template <class Protocol>
+static std::vector<uint8_t> ReadRequest(uint8_t inI2CAddress, uint8_t inRegister, uint8_t inLength)
+{
+	uint8_t message[Protocol::kMaxRequestSize];
+	const size_t size = Protocol::BuildReadRequest(inI2CAddress, inRegister, inLength, message);
+	return std::vector<uint8_t>(message, message + size);
+}
+
+template <class Protocol>
+static std::vector<uint8_t> WriteRequest(uint8_t inI2CAddress, uint8_t inRegister, const std::vector<uint8_t>& inData)
+{
+	uint8_t message[Protocol::kMaxRequestSize];
+	const size_t size = Protocol::BuildWriteRequest(inI2CAddress, inRegister, inData.data(), (uint8_t)inData.size(), message);
+	return std::vector<uint8_t>(message, message + size);
+}
+
+
+//==============================================================================
+// # LegacyProtocol
+//==============================================================================
+
+EGAV_TEST(LegacyReadRequest)
+{
+	EGAV_CHECK(ReadRequest<LegacyProtocol>(0x55, 0x09, 33) == std::vector<uint8_t>({ 0x55, 0x09, 33 }));
+	EGAV_CHECK(ReadRequest<LegacyProtocol>(0xA0, 0x00, 32) == std::vector<uint8_t>({ 0xA0, 0x00, 32 }));
+}
+
+EGAV_TEST(LegacyWriteRequest)
+{
+	EGAV_CHECK(WriteRequest<LegacyProtocol>(0x55, 0x0A, { 1 }) == std::vector<uint8_t>({ 0x55, 0x0A, 1, 1 }));
+	EGAV_CHECK(WriteRequest<LegacyProtocol>(0x50, 0x10, { 7, 8 }) == std::vector<uint8_t>({ 0x50, 0x10, 2, 7, 8 }));
+
+	std::vector<uint8_t> data(MAX_COMM_WRITE_BUFFER_SIZE);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = (uint8_t)(0x80 + i);
+	const std::vector<uint8_t> message = WriteRequest<LegacyProtocol>(0x30, 0xE0, data);
+	EGAV_CHECK_EQUAL(message.size(), LegacyProtocol::kMaxRequestSize);
+	EGAV_CHECK(std::vector<uint8_t>(message.begin(), message.begin() + 3) == std::vector<uint8_t>({ 0x30, 0xE0, 32 }));
+	EGAV_CHECK(std::vector<uint8_t>(message.begin() + 3, message.end()) == data);
+}
+
+EGAV_TEST(LegacyReadResponse)
+{
+	// The data starts at the first byte; short responses leave the rest untouched
+	const uint8_t response[] = { 0x11, 0x22, 0x33, 0x44 };
+	uint8_t data[6] = { 0xEE, 0xEE, 0xEE, 0xEE, 0xEE, 0xEE };
+	LegacyProtocol::ParseReadResponse(response, sizeof(response), data, 3);
+	EGAV_CHECK_EQUAL(data[0], 0x11);
+	EGAV_CHECK_EQUAL(data[2], 0x33);
+	EGAV_CHECK_EQUAL(data[3], 0xEE);
+
+	LegacyProtocol::ParseReadResponse(response, sizeof(response), data, 6);
+	EGAV_CHECK_EQUAL(data[3], 0x44);
+	EGAV_CHECK_EQUAL(data[4], 0xEE);
+}
+
+
+//==============================================================================
+// # NewProtocol
+//==============================================================================
+
+EGAV_TEST(NewReadRequest)
+{
+	EGAV_CHECK(ReadRequest<NewProtocol>(0x55, 0x09, 32) == std::vector<uint8_t>({ 6, 7, 0x55, 1, 0x09, 32 }));
+	EGAV_CHECK(ReadRequest<NewProtocol>(0xA0, 0x80, 16) == std::vector<uint8_t>({ 6, 7, 0xA0, 1, 0x80, 16 }));
+}
+
+EGAV_TEST(NewWriteRequest)
+{
+	EGAV_CHECK(WriteRequest<NewProtocol>(0x55, 0x0A, { 1 }) == std::vector<uint8_t>({ 6, 6, 0x55, 2, 0x0A, 1 }));
+	EGAV_CHECK(WriteRequest<NewProtocol>(0x50, 0x10, { 7, 8 }) == std::vector<uint8_t>({ 7, 6, 0x50, 3, 0x10, 7, 8 }));
+
+	std::vector<uint8_t> data(MAX_COMM_WRITE_BUFFER_SIZE);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = (uint8_t)(0x80 + i);
+	const std::vector<uint8_t> message = WriteRequest<NewProtocol>(0x30, 0xE0, data);
+	EGAV_CHECK_EQUAL(message.size(), NewProtocol::kMaxRequestSize);
+	EGAV_CHECK(std::vector<uint8_t>(message.begin(), message.begin() + 5) == std::vector<uint8_t>({ 4 + 33, 6, 0x30, 33, 0xE0 }));
+	EGAV_CHECK(std::vector<uint8_t>(message.begin() + 5, message.end()) == data);
+}
+
+EGAV_TEST(NewReadResponse)
+{
+	// The data follows the report case byte
+	const uint8_t response[] = { 7, 0x11, 0x22, 0x33 };
+	uint8_t data[4] = { 0xEE, 0xEE, 0xEE, 0xEE };
+	NewProtocol::ParseReadResponse(response, sizeof(response), data, 4);
+	EGAV_CHECK_EQUAL(data[0], 0x11);
+	EGAV_CHECK_EQUAL(data[2], 0x33);
+	EGAV_CHECK_EQUAL(data[3], 0xEE);
+
+	// Nothing but the report case
+	data[0] = 0xEE;
+	NewProtocol::ParseReadResponse(response, 1, data, 4);
+	EGAV_CHECK_EQUAL(data[0], 0xEE);
+}
+
+
+//==============================================================================
+// # hidraw framing
+//==============================================================================
+
+#if defined(__linux__)
+
+EGAV_TEST(HIDRawReports)
+{
+	uint8_t report[kMaxRequestReportSize];
+
+	size_t size = BuildReadReport<LegacyProtocol>(0x55, 0x09, 33, report);
+	EGAV_CHECK(std::vector<uint8_t>(report, report + size) == std::vector<uint8_t>({ 9, 0x55, 0x09, 33 }));
+
+	size = BuildWriteReport<LegacyProtocol>(0x50, 0x10, std::vector<uint8_t>({ 7, 8 }).data(), 2, report);
+	EGAV_CHECK(std::vector<uint8_t>(report, report + size) == std::vector<uint8_t>({ 11, 0x50, 0x10, 2, 7, 8 }));
+
+	size = BuildReadReport<NewProtocol>(0x55, 0x09, 32, report);
+	EGAV_CHECK(std::vector<uint8_t>(report, report + size) == std::vector<uint8_t>({ 6, 6, 7, 0x55, 1, 0x09, 32 }));
+
+	size = BuildWriteReport<NewProtocol>(0x50, 0x10, std::vector<uint8_t>({ 7, 8 }).data(), 2, report);
+	EGAV_CHECK(std::vector<uint8_t>(report, report + size) == std::vector<uint8_t>({ 6, 7, 6, 0x50, 3, 0x10, 7, 8 }));
+}
+
+EGAV_TEST(HIDRawReadResponse)
+{
+	uint8_t data[2] = {};
+
+	// Legacy: the report ID is copied like ReadHID() returns it (offset compensated by the callers)
+	const uint8_t legacy[] = { 10, 0x11, 0x22 };
+	EGAV_CHECK(ParseReadReport<LegacyProtocol>(legacy, sizeof(legacy), data, 2));
+	EGAV_CHECK_EQUAL(data[0], 10);
+	EGAV_CHECK_EQUAL(data[1], 0x11);
+
+	const uint8_t newReport[] = { 5, 0x11, 0x22 };
+	EGAV_CHECK(ParseReadReport<NewProtocol>(newReport, sizeof(newReport), data, 2));
+	EGAV_CHECK_EQUAL(data[0], 0x11);
+	EGAV_CHECK_EQUAL(data[1], 0x22);
+
+	// Other input reports
+	EGAV_CHECK(!ParseReadReport<NewProtocol>(legacy, sizeof(legacy), data, 2));
+	EGAV_CHECK(!ParseReadReport<LegacyProtocol>(newReport, sizeof(newReport), data, 2));
+	EGAV_CHECK(!ParseReadReport<NewProtocol>(newReport, 0, data, 2));
+}
+
+#endif
+
+
+EGAV_TEST_MAIN()
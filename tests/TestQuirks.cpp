@@ -0,0 +1,203 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		TestQuirks.cpp
+
+@brief		Quirk resolution (device and firmware) and each quirk's effect on
+			info frames read from a simulated device
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "ElgatoUVCDevice.h"
+
+
+//! @brief Valid DR info frame: HDR10 (EOTF 2)
+static HDMI_GENERIC_INFOFRAME MakeDRFrame()
+{
+	std::vector<uint8_t> payload(sizeof(HDMI_DR1_PAYLOAD), 0);
+	payload[0] = 2;
+	return EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, payload);
+}
+
+//! @brief EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH: the length is too large, the checksum matches that length
+static HDMI_GENERIC_INFOFRAME BreakPayloadLength(HDMI_GENERIC_INFOFRAME inFrame, uint8_t inLength)
+{
+	inFrame.bChecksum -= (uint8_t)(inLength - inFrame.header.bPayloadLength);
+	inFrame.header.bPayloadLength = inLength;
+	return inFrame;
+}
+
+static bool FramesEqual(const HDMI_GENERIC_INFOFRAME& inA, const HDMI_GENERIC_INFOFRAME& inB)
+{
+	return memcmp(&inA, &inB, HDMI_MAX_INFOFRAME_SIZE) == 0;
+}
+
+
+//==============================================================================
+// # Resolution
+//==============================================================================
+
+EGAV_TEST(ResolveHD60SPlus)
+{
+	const ElgatoUVCQuirks quirks = ResolveElgatoUVCQuirks(deviceIDHD60SPlus, EGAVFirmwareVersion());
+	EGAV_CHECK_EQUAL(quirks.quirks, (uint32_t)(EGAV_QUIRK_INFOFRAME_LEGACY_BUFFER | EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH));
+	EGAV_CHECK_EQUAL(quirks.infoFrameReadSize, 33);
+	EGAV_CHECK_EQUAL(quirks.infoFrameOffset, 1);
+	EGAV_CHECK_EQUAL(quirks.infoFrameFixupCount, 1);
+
+	// No firmware bounds: every version
+	EGAV_CHECK_EQUAL(ResolveElgatoUVCQuirks(deviceIDHD60SPlus, EGAVFirmwareVersion(99, 1, 1)).quirks, quirks.quirks);
+}
+
+EGAV_TEST(ResolveHD60XByFirmware)
+{
+	// Unknown firmware: all firmware specific quirks
+	EGAV_CHECK_EQUAL(ResolveElgatoUVCQuirks(deviceIDHD60X, EGAVFirmwareVersion()).quirks, (uint32_t)EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH);
+	EGAV_CHECK_EQUAL(ResolveElgatoUVCQuirks(deviceIDHD60X, EGAVFirmwareVersion(22, 3, 24)).quirks, (uint32_t)EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH);
+	EGAV_CHECK_EQUAL(ResolveElgatoUVCQuirks(deviceIDHD60X, EGAVFirmwareVersion(21, 12, 1)).quirks, (uint32_t)EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH);
+
+	// Fixed firmware: no quirks, no fixups
+	const ElgatoUVCQuirks fixed = ResolveElgatoUVCQuirks(deviceIDHD60X, EGAVFirmwareVersion(22, 3, 25));
+	EGAV_CHECK_EQUAL(fixed.quirks, (uint32_t)0);
+	EGAV_CHECK_EQUAL(fixed.infoFrameFixupCount, 0);
+	EGAV_CHECK_EQUAL(fixed.infoFrameReadSize, 32);
+	EGAV_CHECK_EQUAL(fixed.infoFrameOffset, 0);
+}
+
+EGAV_TEST(ResolveDevicesWithoutEntryConservatively)
+{
+	// Listed, but no quirk table entry
+	EGAV_CHECK_EQUAL(ResolveElgatoUVCQuirks(deviceIDHD60XRev2, EGAVFirmwareVersion()).quirks, (uint32_t)EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH);
+	EGAV_CHECK_EQUAL(ResolveElgatoUVCQuirks(deviceIDHD60XRev2, EGAVFirmwareVersion(30, 1, 1)).quirks, (uint32_t)EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH);
+
+	// Not listed at all
+	const EGAVDeviceID unknown(EGAVBusType::USB, 0x0FD9, 0x7777);
+	const ElgatoUVCQuirks quirks = ResolveElgatoUVCQuirks(unknown, EGAVFirmwareVersion());
+	EGAV_CHECK_EQUAL(quirks.quirks, (uint32_t)EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH);
+	EGAV_CHECK_EQUAL(quirks.infoFrameFixupCount, 1);
+
+	// The location ID doesn't matter
+	EGAV_CHECK_EQUAL(ResolveElgatoUVCQuirks(EGAVDeviceID(EGAVBusType::USB, 0x0FD9, 0x006A, 0x1234), EGAVFirmwareVersion()).quirks,
+					 (uint32_t)(EGAV_QUIRK_INFOFRAME_LEGACY_BUFFER | EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH));
+}
+
+EGAV_TEST(FirmwareVersion)
+{
+	EGAVFirmwareVersion version;
+	EGAV_CHECK(!version.IsKnown());
+	EGAV_CHECK(EGAVFirmwareVersion::FromString("22.03.24", version));
+	EGAV_CHECK(version == EGAVFirmwareVersion(22, 3, 24));
+	EGAV_CHECK(version.ToString() == "22.03.24");
+	EGAV_CHECK(EGAVFirmwareVersion(22, 3, 24) <= EGAVFirmwareVersion(22, 4, 0));
+	EGAV_CHECK(!(EGAVFirmwareVersion(23, 0, 0) <= EGAVFirmwareVersion(22, 12, 31)));
+	EGAV_CHECK(!EGAVFirmwareVersion::FromString("22.03", version));
+}
+
+
+//==============================================================================
+// # EGAV_QUIRK_INFOFRAME_PAYLOAD_LENGTH
+//==============================================================================
+
+EGAV_TEST(FixPayloadLength)
+{
+	const HDMI_GENERIC_INFOFRAME valid = MakeDRFrame();
+	HDMI_GENERIC_INFOFRAME frame = BreakPayloadLength(valid, 0x3A);
+	EGAV_FixInfoFramePayloadLength(frame);
+	EGAV_CHECK(FramesEqual(frame, valid));
+	EGAV_CHECK(HDMI_IsInfoFrameValid(&frame));
+
+	// SPD
+	const HDMI_GENERIC_INFOFRAME spd = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_SPD, 1, std::vector<uint8_t>(sizeof(HDMI_SPD1_PAYLOAD), 'A'));
+	frame = BreakPayloadLength(spd, 0xF0);
+	EGAV_FixInfoFramePayloadLength(frame);
+	EGAV_CHECK(FramesEqual(frame, spd));
+
+	// Valid frames and other types are left alone
+	frame = valid;
+	EGAV_FixInfoFramePayloadLength(frame);
+	EGAV_CHECK(FramesEqual(frame, valid));
+	const HDMI_GENERIC_INFOFRAME avi = BreakPayloadLength(EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_AVI, 2, std::vector<uint8_t>(13, 0)), 0x40);
+	frame = avi;
+	EGAV_FixInfoFramePayloadLength(frame);
+	EGAV_CHECK(FramesEqual(frame, avi));
+}
+
+EGAV_TEST(PayloadLengthQuirkOnRead)
+{
+	const HDMI_GENERIC_INFOFRAME valid = MakeDRFrame();
+	const HDMI_GENERIC_INFOFRAME broken = BreakPayloadLength(valid, 0x3A);
+
+	for (const EGAVDeviceID& id : { deviceIDHD60X, deviceIDHD60XRev2 })
+	{
+		auto hid = std::make_shared<EGAVSimulatedHID>(true);
+		hid->SetRegisters((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::GET_HDR_PACKET, &broken, HDMI_MAX_INFOFRAME_SIZE);
+
+		ElgatoUVCDevice device(hid, id);
+		HDMI_GENERIC_INFOFRAME frame{};
+		EGAV_CHECK_RESULT(device.GetHDMIHDRStatusPacket(frame), EGAVResult::Ok);
+		EGAV_CHECK(FramesEqual(frame, valid));
+	}
+
+	// Fixed firmware: the frame is delivered as read
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	hid->SetRegisters((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::GET_HDR_PACKET, &broken, HDMI_MAX_INFOFRAME_SIZE);
+	ElgatoUVCDevice device(hid, deviceIDHD60X, EGAVFirmwareVersion(22, 4, 1));
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAV_CHECK_RESULT(device.GetHDMIHDRStatusPacket(frame), EGAVResult::Ok);
+	EGAV_CHECK(FramesEqual(frame, broken));
+}
+
+
+//==============================================================================
+// # EGAV_QUIRK_INFOFRAME_LEGACY_BUFFER
+//==============================================================================
+
+EGAV_TEST(LegacyBufferQuirkOnRead)
+{
+	// The legacy read response carries the report ID in front of the register data: 33 bytes are read
+	// and the frame starts at offset 1
+	auto hid = std::make_shared<EGAVSimulatedHID>(false);
+	const HDMI_GENERIC_INFOFRAME valid = MakeDRFrame();
+	hid->SetRegisters((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::GET_HDR_PACKET, &valid, HDMI_MAX_INFOFRAME_SIZE);
+
+	ElgatoUVCDevice device(hid, deviceIDHD60SPlus);
+	HDMI_GENERIC_INFOFRAME frame{};
+	EGAV_CHECK_RESULT(device.GetHDMIHDRStatusPacket(frame), EGAVResult::Ok);
+	EGAV_CHECK(FramesEqual(frame, valid));
+
+	const std::vector<EGAVSimulatedHID::Transaction> transactions = hid->GetTransactions();
+	EGAV_CHECK_EQUAL(transactions.size(), (size_t)1);
+	EGAV_CHECK(!transactions.empty() && transactions[0].length == 33);
+
+	bool isHDR = false;
+	EGAV_CHECK_RESULT(device.IsVideoHDR(isHDR), EGAVResult::Ok);
+	EGAV_CHECK(isHDR);
+}
+
+EGAV_TEST_MAIN()
@@ -0,0 +1,78 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		TestReactor.cpp
+
+@brief		EGAVReactor: Run() and Stop() from other threads
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVReactor.h"
+
+#include <future>
+#include <thread>
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(StopBeforeRunIsNotLost)
+{
+	EGAVReactor reactor;
+	EGAV_CHECK_RESULT(reactor.Init(), EGAVResult::Ok);
+	reactor.Stop();
+
+	auto run = std::async(std::launch::async, [&reactor] { return reactor.Run(); });
+	EGAV_CHECK(run.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+	if (run.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		reactor.Stop(); // don't hang the test
+		run.wait();
+	}
+	EGAV_CHECK_RESULT(run.get(), EGAVResult::Ok);
+}
+
+EGAV_TEST(StopFromAnotherThread)
+{
+	EGAVReactor reactor;
+	EGAV_CHECK_RESULT(reactor.Init(), EGAVResult::Ok);
+
+	bool posted = false;
+	reactor.Post([&posted] { posted = true; });
+	std::thread stopper([&reactor]
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		reactor.Stop();
+	});
+	EGAV_CHECK_RESULT(reactor.Run(), EGAVResult::Ok);
+	stopper.join();
+	EGAV_CHECK(posted);
+}
+
+
+EGAV_TEST_MAIN()
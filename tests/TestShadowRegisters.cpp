@@ -0,0 +1,258 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		TestShadowRegisters.cpp
+
+@brief		Shadow register cache: redundant writes, verification and replay,
+			counted in I2C transactions of the simulated device
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "ElgatoUVCDevice.h"
+
+
+const uint8_t kAddress = 0x30;
+const uint8_t kOtherAddress = 0x31;
+
+static size_t CountWrites(const std::vector<EGAVSimulatedHID::Transaction>& inTransactions)
+{
+	return (size_t)std::count_if(inTransactions.begin(), inTransactions.end(), [](const EGAVSimulatedHID::Transaction& t) { return !t.isRead; });
+}
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(RedundantWritesAreNotSent)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+
+	EGAV_CHECK_RESULT(device.SetHDRTonemappingEnabled(true), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 1);
+	EGAV_CHECK_EQUAL(hid->GetRegister((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::XET_HDR_TONEMAPPING), 1);
+
+	hid->ResetCounters();
+	EGAV_CHECK_RESULT(device.SetHDRTonemappingEnabled(true), EGAVResult::OkNoDataChanged);
+	EGAV_CHECK_RESULT(device.SetHDRTonemappingEnabled(true), EGAVResult::OkNoDataChanged);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 0);
+	EGAV_CHECK_EQUAL(hid->GetHIDReadCount(), 0);
+
+	EGAV_CHECK_RESULT(device.SetHDRTonemappingEnabled(false), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 1);
+
+	// Same register, different length: sent
+	const uint8_t value[2] = { 0, 0 };
+	hid->ResetCounters();
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::XET_HDR_TONEMAPPING, value, 2), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 1);
+}
+
+EGAV_TEST(FailedWriteIsSentAgain)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	device.SetRegisterWriteVerification(false, 0);
+
+	const uint8_t value = 0x42;
+	hid->FailNextTransfers(1);
+	EGAV_CHECK(device.WriteRegisterShadowed(kAddress, 0x10, &value, 1).Failed());
+	EGAV_CHECK_EQUAL(hid->GetRegister(kAddress, 0x10), 0);
+
+	// Not confirmed: the same value is sent again
+	hid->ResetCounters();
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x10, &value, 1), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 1);
+	EGAV_CHECK_EQUAL(hid->GetRegister(kAddress, 0x10), 0x42);
+
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x10, &value, 1), EGAVResult::OkNoDataChanged);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 1);
+}
+
+EGAV_TEST(WriteRetries)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	device.SetRegisterWriteVerification(false, 2);
+
+	// Two failed attempts, the third succeeds
+	const uint8_t value = 0x42;
+	hid->FailNextTransfers(2);
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x10, &value, 1), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 3);
+	EGAV_CHECK_EQUAL(CountWrites(hid->GetTransactions()), 1);
+
+	// All attempts fail
+	const uint8_t other = 0x43;
+	hid->ResetCounters();
+	hid->FailNextTransfers(3);
+	EGAV_CHECK(device.WriteRegisterShadowed(kAddress, 0x10, &other, 1).Failed());
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 3);
+	EGAV_CHECK_EQUAL(hid->GetRegister(kAddress, 0x10), 0x42);
+}
+
+EGAV_TEST(VerifiedWrite)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	device.SetRegisterWriteVerification(true, 2);
+
+	// One write and one read back
+	const uint8_t value[2] = { 0x42, 0x43 };
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x10, value, 2), EGAVResult::Ok);
+	auto transactions = hid->GetTransactions();
+	EGAV_CHECK_EQUAL(transactions.size(), 2);
+	EGAV_CHECK(!transactions[0].isRead);
+	EGAV_CHECK(transactions[1].isRead && transactions[1].reg == 0x10 && transactions[1].length == 2);
+
+	// The device doesn't take the first write: one retry
+	int overwrites = 1;
+	hid->SetReadHook([&](uint8_t inAddress, uint8_t inRegister, uint8_t)
+	{
+		if (overwrites-- > 0)
+		{
+			const uint8_t stale = 0;
+			hid->SetRegisters(inAddress, inRegister, &stale, 1);
+		}
+	});
+	const uint8_t next[2] = { 0x44, 0x45 };
+	hid->ResetCounters();
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x10, next, 2), EGAVResult::Ok);
+	transactions = hid->GetTransactions();
+	EGAV_CHECK_EQUAL(CountWrites(transactions), 2);
+	EGAV_CHECK_EQUAL(transactions.size(), 4);
+
+	// Never takes it: 1 + 2 retries, then ErrInvalidState and the value stays unconfirmed
+	overwrites = 100;
+	const uint8_t last[2] = { 0x46, 0x47 };
+	hid->ResetCounters();
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x10, last, 2), EGAVResult::ErrInvalidState);
+	EGAV_CHECK_EQUAL(CountWrites(hid->GetTransactions()), 3);
+
+	overwrites = 0;
+	hid->ResetCounters();
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x10, last, 2), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(CountWrites(hid->GetTransactions()), 1);
+}
+
+EGAV_TEST(ReplayBatchesConsecutiveRegisters)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+
+	// 0x10 .. 0x13 in three writes, 0x20 apart, 0x14 of another address
+	const uint8_t a[2] = { 1, 2 }, b = 3, c = 4, d = 5, e = 6;
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x10, a, 2), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x12, &b, 1), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x13, &c, 1), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x20, &d, 1), EGAVResult::Ok);
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kOtherAddress, 0x14, &e, 1), EGAVResult::Ok);
+
+	// Device reset
+	const uint8_t zeros[0x30] = {};
+	hid->SetRegisters(kAddress, 0, zeros, sizeof(zeros));
+	hid->SetRegisters(kOtherAddress, 0, zeros, sizeof(zeros));
+	hid->ResetCounters();
+
+	EGAV_CHECK_RESULT(device.ReplayShadowRegisters(), EGAVResult::Ok);
+	const auto transactions = hid->GetTransactions();
+	EGAV_CHECK_EQUAL(transactions.size(), 3);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 3);
+	if (transactions.size() == 3)
+	{
+		EGAV_CHECK(transactions[0].address == kAddress && transactions[0].reg == 0x10 && transactions[0].length == 4);
+		EGAV_CHECK(transactions[1].address == kAddress && transactions[1].reg == 0x20 && transactions[1].length == 1);
+		EGAV_CHECK(transactions[2].address == kOtherAddress && transactions[2].reg == 0x14 && transactions[2].length == 1);
+	}
+	for (uint8_t i = 0; i < 4; i++)
+		EGAV_CHECK_EQUAL(hid->GetRegister(kAddress, (uint8_t)(0x10 + i)), i + 1);
+	EGAV_CHECK_EQUAL(hid->GetRegister(kAddress, 0x20), 5);
+	EGAV_CHECK_EQUAL(hid->GetRegister(kOtherAddress, 0x14), 6);
+
+	// Replayed values are confirmed
+	hid->ResetCounters();
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x12, &b, 1), EGAVResult::OkNoDataChanged);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 0);
+}
+
+EGAV_TEST(ReplaySplitsLongRuns)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+
+	// 40 consecutive registers: one full write of 32 bytes, then 8
+	for (uint8_t i = 0; i < 40; i++)
+		EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, i, &i, 1), EGAVResult::Ok);
+	hid->ResetCounters();
+
+	EGAV_CHECK_RESULT(device.ReplayShadowRegisters(), EGAVResult::Ok);
+	const auto transactions = hid->GetTransactions();
+	EGAV_CHECK_EQUAL(transactions.size(), 2);
+	if (transactions.size() == 2)
+	{
+		EGAV_CHECK(transactions[0].reg == 0 && transactions[0].length == MAX_COMM_WRITE_BUFFER_SIZE);
+		EGAV_CHECK(transactions[1].reg == MAX_COMM_WRITE_BUFFER_SIZE && transactions[1].length == 8);
+	}
+}
+
+EGAV_TEST(ReplayFailureKeepsRegistersDirty)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+	device.SetRegisterWriteVerification(false, 0);
+
+	const uint8_t value = 0x42;
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x10, &value, 1), EGAVResult::Ok);
+	hid->FailNextTransfers(1);
+	EGAV_CHECK(device.ReplayShadowRegisters().Failed());
+
+	hid->ResetCounters();
+	EGAV_CHECK_RESULT(device.WriteRegisterShadowed(kAddress, 0x10, &value, 1), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 1);
+}
+
+EGAV_TEST(InvalidatedRegistersAreSentAndNotReplayed)
+{
+	auto hid = std::make_shared<EGAVSimulatedHID>(true);
+	ElgatoUVCDevice device(hid, deviceIDHD60X);
+
+	EGAV_CHECK_RESULT(device.SetHDRTonemappingEnabled(true), EGAVResult::Ok);
+	device.InvalidateShadowRegisters();
+	hid->ResetCounters();
+
+	EGAV_CHECK_RESULT(device.ReplayShadowRegisters(), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 0);
+
+	EGAV_CHECK_RESULT(device.SetHDRTonemappingEnabled(true), EGAVResult::Ok);
+	EGAV_CHECK_EQUAL(hid->GetHIDWriteCount(), 1);
+}
+
+
+EGAV_TEST_MAIN()
@@ -0,0 +1,178 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		TestToneMapper.cpp
+
+@brief		HDRToneMapper: AVX2 kernel against the scalar kernel, slicing, and
+			parameter checks
+
+			The kernels aren't bit exact: the AVX2 kernel uses FMA and sums the 2x2
+			chroma block in a different order, so a value close to a rounding
+			boundary (output code or curve index) can end up on the other side.
+			The test bounds both the size and the number of such differences.
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVTestFrames.h"
+#include "HDRToneMapper.h"
+
+#include <cstdlib>
+
+
+//! @brief NV12 output of one frame
+struct ToneMapOutput
+{
+	std::vector<uint8_t>	y;
+	std::vector<uint8_t>	uv;
+};
+
+static ToneMapOutput ToneMap(const EGAVTestFrame& inFrame, const HDRToneMapParams& inParams, bool inSIMD, int inThreadCount = 1)
+{
+	HDRToneMapper mapper(inThreadCount);
+	mapper.SetParams(inParams);
+	mapper.SetSIMDEnabled(inSIMD);
+
+	ToneMapOutput output;
+	output.y.resize((size_t)inFrame.width * inFrame.height);
+	output.uv.resize((size_t)inFrame.width * (inFrame.height / 2));
+	EGAV_CHECK_RESULT(mapper.Process(inFrame.GetY(), inFrame.GetStride(), inFrame.GetUV(), inFrame.GetStride(),
+									 output.y.data(), inFrame.width, output.uv.data(), inFrame.width,
+									 inFrame.width, inFrame.height), EGAVResult::Ok);
+	return output;
+}
+
+//! @brief Checks that at most 1 in 10000 samples differ, by at most inMaxDifference
+static void CheckEquivalent(const std::vector<uint8_t>& inA, const std::vector<uint8_t>& inB, int inMaxDifference)
+{
+	EGAV_CHECK_EQUAL(inA.size(), inB.size());
+	size_t differing = 0;
+	int maxDifference = 0;
+	for (size_t i = 0; i < inA.size() && i < inB.size(); i++)
+	{
+		const int difference = std::abs((int)inA[i] - (int)inB[i]);
+		if (difference > 0)
+			differing++;
+		maxDifference = std::max(maxDifference, difference);
+	}
+	EGAV_CHECK(maxDifference <= inMaxDifference);
+	EGAV_CHECK(differing * 10000 <= inA.size());
+}
+
+//! @brief Every 10 bit luma code (columns) with chroma from neutral to the limits (rows)
+static EGAVTestFrame MakeCodeSweepFrame()
+{
+	EGAVTestFrame frame;
+	frame.width  = 1024;
+	frame.height = 64;
+	frame.y.resize((size_t)frame.width * frame.height);
+	frame.uv.resize((size_t)frame.width * (frame.height / 2));
+	for (int row = 0; row < frame.height; row++)
+		for (int column = 0; column < frame.width; column++)
+			frame.y[(size_t)row * frame.width + column] = (uint16_t)(column << 6);
+
+	EGAVTestRandom random(7);
+	for (int row = 0; row < frame.height / 2; row++)
+	{
+		const int spread = 16 * row;	// 0 (neutral) .. 496
+		for (int column = 0; column < frame.width; column++)
+		{
+			const int code = 512 + (int)(random.Next() % (uint32_t)(2 * spread + 1)) - spread;
+			frame.uv[(size_t)row * frame.width + column] = (uint16_t)(std::min(std::max(code, 0), 1023) << 6);
+		}
+	}
+	return frame;
+}
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(SIMDMatchesScalar)
+{
+	HDRToneMapParams pq203;
+	HDRToneMapParams pq4000;
+	pq4000.sourcePeak  = 4000.f;
+	pq4000.sourceBlack = 0.005f;
+	HDRToneMapParams hlg;
+	hlg.eotf = HDMI_DR_EOTF_HLG;
+
+	struct Case
+	{
+		EGAVTestFrame		frame;
+		HDRToneMapParams	params;
+	};
+	const Case cases[] =
+	{
+		{ EGAVTest_MakeSceneFrame(EGAVTestTransfer::PQ, 203, true, 1926, 1080, 1), pq203 },		// width: 6 pixels for the scalar tail
+		{ EGAVTest_MakeSceneFrame(EGAVTestTransfer::PQ, 1000, true, 1920, 1080, 2), pq4000 },
+		{ EGAVTest_MakeSceneFrame(EGAVTestTransfer::HLG, 0, true, 1920, 1080, 3), hlg },
+		{ MakeCodeSweepFrame(), pq203 },
+		{ MakeCodeSweepFrame(), hlg },
+	};
+	for (const Case& test : cases)
+	{
+		const ToneMapOutput simd   = ToneMap(test.frame, test.params, true);
+		const ToneMapOutput scalar = ToneMap(test.frame, test.params, false);
+		CheckEquivalent(simd.y,  scalar.y,  2);
+		CheckEquivalent(simd.uv, scalar.uv, 1);
+	}
+}
+
+EGAV_TEST(SlicesDontChangeTheOutput)
+{
+	// 1078 rows: 539 row pairs don't divide evenly between the slices
+	const EGAVTestFrame frame = EGAVTest_MakeSceneFrame(EGAVTestTransfer::PQ, 203, true, 1280, 1078, 4);
+	for (bool simd : { true, false })
+	{
+		const ToneMapOutput reference = ToneMap(frame, HDRToneMapParams(), simd, 1);
+		for (int threads : { 2, 3, 8 })
+		{
+			const ToneMapOutput sliced = ToneMap(frame, HDRToneMapParams(), simd, threads);
+			EGAV_CHECK(sliced.y == reference.y);
+			EGAV_CHECK(sliced.uv == reference.uv);
+		}
+	}
+}
+
+EGAV_TEST(ProcessChecksParameters)
+{
+	const EGAVTestFrame frame = EGAVTest_MakeSceneFrame(EGAVTestTransfer::PQ, 203, false, 64, 16);
+	std::vector<uint8_t> y(64 * 16), uv(64 * 8);
+	HDRToneMapper mapper(1);
+	EGAV_CHECK_RESULT(mapper.Process(frame.GetY(), frame.GetStride(), frame.GetUV(), frame.GetStride(), y.data(), 64, uv.data(), 64, 63, 16),
+					  EGAVResult::ErrInvalidParameter);
+	EGAV_CHECK_RESULT(mapper.Process(frame.GetY(), frame.GetStride(), frame.GetUV(), frame.GetStride(), y.data(), 64, uv.data(), 64, 64, 15),
+					  EGAVResult::ErrInvalidParameter);
+	EGAV_CHECK_RESULT(mapper.Process(frame.GetY(), frame.GetStride(), nullptr, frame.GetStride(), y.data(), 64, uv.data(), 64, 64, 16),
+					  EGAVResult::ErrNullPointer);
+	EGAV_CHECK_RESULT(mapper.Process(frame.GetY(), frame.GetStride(), frame.GetUV(), frame.GetStride(), y.data(), 64, uv.data(), 64, 64, 16),
+					  EGAVResult::Ok);
+}
+
+
+EGAV_TEST_MAIN()
@@ -0,0 +1,249 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//==============================================================================
+/**
+@file		TestTonemapPolicy.cpp
+
+@brief		HDRTonemapPolicy: hold and dwell times against scripted signal traces
+			(glitches, flapping, quick changes), counted in register writes of the
+			simulated device
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "EGAVSimulatedHID.h"
+#include "ElgatoUVCDevice.h"
+#include "HDRTonemapPolicy.h"
+
+#include <thread>
+
+
+//! @brief One part of a signal trace: inEOTF (HDMI_DR_EOTF_* or HDMI_ERROR) for inDurationMs
+struct SignalSegment
+{
+	int		eotf;
+	int		durationMs;
+};
+
+//! @brief Feeds the trace to the policy, one sample per 100 ms poll
+//! @return timestamp after the trace
+static uint64_t RunTrace(HDRTonemapPolicy& ioPolicy, const std::vector<SignalSegment>& inTrace, uint64_t inStartUs = 0)
+{
+	const uint64_t kPollUs = 100000;
+	uint64_t now = inStartUs;
+	for (const SignalSegment& segment : inTrace)
+	{
+		for (uint64_t end = now + (uint64_t)segment.durationMs * 1000; now < end; now += kPollUs)
+			ioPolicy.ProcessSignal(segment.eotf, now);
+	}
+	return now;
+}
+
+static size_t CountTonemapWrites(EGAVSimulatedHID& inHID)
+{
+	size_t writes = 0;
+	for (const EGAVSimulatedHID::Transaction& transaction : inHID.GetTransactions())
+		if (!transaction.isRead && transaction.reg == (uint8_t)MCU_I2C_REGISTER::XET_HDR_TONEMAPPING)
+			writes++;
+	return writes;
+}
+
+static uint8_t GetTonemapRegister(EGAVSimulatedHID& inHID)
+{
+	return inHID.GetRegister((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::XET_HDR_TONEMAPPING);
+}
+
+//! @brief Default hold times (enable 300 ms, disable 1500 ms, dwell 2000 ms); records the transitions
+struct PolicyFixture
+{
+	explicit PolicyFixture(const HDRTonemapPolicyConfig& inConfig = HDRTonemapPolicyConfig())
+		: hid(std::make_shared<EGAVSimulatedHID>(true)), device(hid, deviceIDHD60X),
+		  policy(device, inConfig, [this](bool inTonemapping, int) { transitions.push_back(inTonemapping); })
+	{
+	}
+
+	std::shared_ptr<EGAVSimulatedHID>	hid;
+	ElgatoUVCDevice						device;
+	std::vector<bool>					transitions;
+	HDRTonemapPolicy					policy;
+};
+
+
+//==============================================================================
+// # Tests
+//==============================================================================
+
+EGAV_TEST(GlitchesAreSuppressed)
+{
+	PolicyFixture fixture;
+
+	// PQ: the first sample applies the state without hold time. The DR info frame then drops out for 200 ms
+	// (twice, once with an I2C error in between), shorter than the disable hold time.
+	RunTrace(fixture.policy, {
+		{ HDMI_DR_EOTF_ST2084, 3000 },
+		{ HDMI_DR_EOTF_SDRGAMMA, 200 },
+		{ HDMI_DR_EOTF_ST2084, 3000 },
+		{ HDMI_DR_EOTF_SDRGAMMA, 100 }, { HDMI_ERROR, 200 }, { HDMI_DR_EOTF_SDRGAMMA, 1000 },
+		{ HDMI_DR_EOTF_ST2084, 1000 },
+	});
+	EGAV_CHECK(fixture.policy.IsTonemapping());
+	EGAV_CHECK_EQUAL(CountTonemapWrites(*fixture.hid), (size_t)1);
+	EGAV_CHECK_EQUAL(fixture.hid->GetHIDWriteCount(), (size_t)1);
+	EGAV_CHECK_EQUAL(GetTonemapRegister(*fixture.hid), 1);
+
+	const HDRTonemapPolicyStatistics statistics = fixture.policy.GetStatistics();
+	EGAV_CHECK_EQUAL(statistics.transitions, (uint64_t)1);
+	EGAV_CHECK_EQUAL(statistics.registerWrites, (uint64_t)1);
+	EGAV_CHECK_EQUAL(statistics.suppressed, (uint64_t)2);
+	EGAV_CHECK_EQUAL(statistics.samples, (uint64_t)(30 + 2 + 30 + 1 + 10 + 10)); // errors are not samples
+	EGAV_CHECK(fixture.transitions == std::vector<bool>({ true }));
+}
+
+EGAV_TEST(ShortHDRInSDRIsSuppressed)
+{
+	PolicyFixture fixture;
+	RunTrace(fixture.policy, {
+		{ HDMI_DR_EOTF_SDRGAMMA, 3000 },
+		{ HDMI_DR_EOTF_HLG, 200 },			// shorter than the enable hold time
+		{ HDMI_DR_EOTF_SDRGAMMA, 3000 },
+	});
+	EGAV_CHECK(!fixture.policy.IsTonemapping());
+	EGAV_CHECK_EQUAL(CountTonemapWrites(*fixture.hid), (size_t)1); // the initial state
+	EGAV_CHECK_EQUAL(GetTonemapRegister(*fixture.hid), 0);
+	EGAV_CHECK_EQUAL(fixture.policy.GetStatistics().suppressed, (uint64_t)1);
+}
+
+EGAV_TEST(FlappingFasterThanHoldTimeCostsNoWrites)
+{
+	PolicyFixture fixture;
+
+	// The DR info frame flaps every second for 20 s: never gone for the disable hold time (1.5 s)
+	std::vector<SignalSegment> trace;
+	for (int i = 0; i < 10; i++)
+	{
+		trace.push_back({ HDMI_DR_EOTF_ST2084, 1000 });
+		trace.push_back({ HDMI_DR_EOTF_SDRGAMMA, 1000 });
+	}
+	RunTrace(fixture.policy, trace);
+	EGAV_CHECK(fixture.policy.IsTonemapping());
+	EGAV_CHECK_EQUAL(CountTonemapWrites(*fixture.hid), (size_t)1);
+	EGAV_CHECK_EQUAL(fixture.hid->GetHIDWriteCount(), (size_t)1);
+	EGAV_CHECK_EQUAL(fixture.policy.GetStatistics().suppressed, (uint64_t)9); // the last SDR period is still pending
+}
+
+EGAV_TEST(SlowFlappingWritesEachTransitionOnce)
+{
+	PolicyFixture fixture;
+
+	// 3 s periods: on at 0, off at 4.5 s (SDR from 3 s + 1.5 s hold), on at 6.5 s (HDR from 6 s, hold done
+	// at 6.3 s, dwell after the 4.5 s transition ends at 6.5 s), off at 10.5 s
+	RunTrace(fixture.policy, {
+		{ HDMI_DR_EOTF_ST2084, 3000 },
+		{ HDMI_DR_EOTF_SDRGAMMA, 3000 },
+		{ HDMI_DR_EOTF_ST2084, 3000 },
+		{ HDMI_DR_EOTF_SDRGAMMA, 3000 },
+	});
+	EGAV_CHECK(!fixture.policy.IsTonemapping());
+	EGAV_CHECK_EQUAL(CountTonemapWrites(*fixture.hid), (size_t)4);
+	EGAV_CHECK_EQUAL(fixture.hid->GetHIDWriteCount(), (size_t)4);
+	EGAV_CHECK_EQUAL(GetTonemapRegister(*fixture.hid), 0);
+	EGAV_CHECK(fixture.transitions == std::vector<bool>({ true, false, true, false }));
+	EGAV_CHECK_EQUAL(fixture.policy.GetStatistics().registerWrites, (uint64_t)4);
+}
+
+EGAV_TEST(DwellTimeDelaysTransitions)
+{
+	HDRTonemapPolicyConfig config;
+	config.enableHoldMs  = 300;
+	config.disableHoldMs = 300;
+	config.minDwellMs    = 2000;
+	PolicyFixture fixture(config);
+
+	// SDR at 0 (initial write). HDR from 0.5 s: the hold time is over at 0.8 s, the dwell time at 2 s.
+	uint64_t now = RunTrace(fixture.policy, { { HDMI_DR_EOTF_SDRGAMMA, 500 }, { HDMI_DR_EOTF_ST2084, 1400 } });
+	EGAV_CHECK(!fixture.policy.IsTonemapping());
+	EGAV_CHECK_EQUAL(CountTonemapWrites(*fixture.hid), (size_t)1);
+	now = RunTrace(fixture.policy, { { HDMI_DR_EOTF_ST2084, 200 } }, now);
+	EGAV_CHECK(fixture.policy.IsTonemapping());
+	EGAV_CHECK_EQUAL(CountTonemapWrites(*fixture.hid), (size_t)2);
+
+	// SDR from 2.1 s for 0.9 s: longer than the hold time, but the dwell time runs until 4 s. HDR again: no write.
+	RunTrace(fixture.policy, { { HDMI_DR_EOTF_SDRGAMMA, 900 }, { HDMI_DR_EOTF_ST2084, 3000 } }, now);
+	EGAV_CHECK(fixture.policy.IsTonemapping());
+	EGAV_CHECK_EQUAL(CountTonemapWrites(*fixture.hid), (size_t)2);
+	EGAV_CHECK_EQUAL(fixture.hid->GetHIDWriteCount(), (size_t)2);
+	EGAV_CHECK(fixture.transitions == std::vector<bool>({ false, true }));
+}
+
+EGAV_TEST(FailedWriteIsRetried)
+{
+	PolicyFixture fixture;
+	RunTrace(fixture.policy, { { HDMI_DR_EOTF_SDRGAMMA, 3000 } });
+	EGAV_CHECK_EQUAL(CountTonemapWrites(*fixture.hid), (size_t)1);
+
+	// The write of the transition fails (all attempts of the device, see SetRegisterWriteVerification()) at 3.3 s,
+	// when the enable hold time is over; the next sample retries it
+	uint64_t now = RunTrace(fixture.policy, { { HDMI_DR_EOTF_ST2084, 300 } }, 3000000);
+	fixture.hid->FailNextTransfers(3);
+	now = RunTrace(fixture.policy, { { HDMI_DR_EOTF_ST2084, 100 } }, now);
+	EGAV_CHECK(!fixture.policy.IsTonemapping());
+	EGAV_CHECK_EQUAL(GetTonemapRegister(*fixture.hid), 0);
+	RunTrace(fixture.policy, { { HDMI_DR_EOTF_ST2084, 100 } }, now);
+	EGAV_CHECK(fixture.policy.IsTonemapping());
+	EGAV_CHECK_EQUAL(GetTonemapRegister(*fixture.hid), 1);
+
+	const HDRTonemapPolicyStatistics statistics = fixture.policy.GetStatistics();
+	EGAV_CHECK_EQUAL(statistics.writeErrors, (uint64_t)1);
+	EGAV_CHECK_EQUAL(statistics.registerWrites, (uint64_t)2);
+	EGAV_CHECK_EQUAL(fixture.hid->GetHIDWriteCount(), (size_t)5); // initial, 3 failed attempts, retry
+}
+
+EGAV_TEST(PollingThreadFollowsTheDevice)
+{
+	HDRTonemapPolicyConfig config;
+	config.pollIntervalMs = 2;
+	config.enableHoldMs   = 10;
+	config.disableHoldMs  = 10;
+	config.minDwellMs     = 0;
+	PolicyFixture fixture(config);
+
+	// No DR info frame (all zero registers): the initial state is SDR
+	EGAV_CHECK_RESULT(fixture.policy.Start(), EGAVResult::Ok);
+	EGAV_CHECK(!fixture.policy.IsTonemapping());
+	EGAV_CHECK_EQUAL(CountTonemapWrites(*fixture.hid), (size_t)1);
+
+	const HDMI_GENERIC_INFOFRAME pq = EGAVTest_MakeInfoFrame(HDMI_INFOFRAME_TYPE_DR, 1, { HDMI_DR_EOTF_ST2084, 0 });
+	fixture.hid->SetRegisters((uint8_t)I2CAddress::MCU, (uint8_t)MCU_I2C_REGISTER::GET_HDR_PACKET, &pq, sizeof(pq));
+	for (int i = 0; i < 2000 && !fixture.policy.IsTonemapping(); i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	fixture.policy.Stop();
+
+	EGAV_CHECK(fixture.policy.IsTonemapping());
+	EGAV_CHECK_EQUAL(CountTonemapWrites(*fixture.hid), (size_t)2);
+	EGAV_CHECK_EQUAL(GetTonemapRegister(*fixture.hid), 1);
+}
+
+
+EGAV_TEST_MAIN()
@@ -0,0 +1,295 @@
+/*
+MIT License
+
+Copyright (c) 2022-23 Corsair Memory, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+//==============================================================================
+/**
+@file		TestVendorInfoFrames.cpp
+
+@brief		Golden vectors for the vendor specific info frame decoders and the
+			streaming parser
+
+			The vectors are complete info frames as sent on the wire (header,
+			checksum, payload) with precomputed checksums, so a change in the
+			decoders or in HDMI_GENERIC_INFOFRAME shows up here.
+**/
+//==============================================================================
+
+#include "EGAVTest.h"
+#include "HDMIVendorInfoFrameParser.h"
+
+
+//==============================================================================
+// # Golden vectors
+//==============================================================================
+
+//! HDMI 1.4b: extended resolution, HDMI_VIC 1 (4K30)
+static const uint8_t kHDMI14b4K30[] =
+{
+	0x81, 0x01, 0x05, 0x49, 0x03, 0x0C, 0x00, 0x20, 0x01
+};
+
+//! HDMI 1.4b: 3D side-by-side (half), 3D_Ext_Data 1
+static const uint8_t kHDMI14b3DSideBySide[] =
+{
+	0x81, 0x01, 0x06, 0x99, 0x03, 0x0C, 0x00, 0x40, 0x80, 0x10
+};
+
+//! HDMI LLC OUI with a 24 byte payload: Dolby Vision standard (tunneled) mode
+static const uint8_t kDolbyVisionStandard[] =
+{
+	0x81, 0x01, 0x18, 0x57, 0x03, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+//! HDMI Forum: version 1, ALLM
+static const uint8_t kHDMIForumALLM[] =
+{
+	0x81, 0x01, 0x05, 0x7D, 0xD8, 0x5D, 0xC4, 0x01, 0x02
+};
+
+//! HDR10+: version 1, max lum code 10, maxRGB 128, distribution 1..9, 9 anchors,
+//! knee point (341, 682), anchors 10..90, no delay
+static const uint8_t kHDR10Plus[] =
+{
+	0x81, 0x01, 0x1B, 0x2C, 0x8B, 0x84, 0x90, 0x54, 0x80, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x95, 0x56, 0xAA, 0x0A, 0x14, 0x1E, 0x28, 0x32, 0x3C, 0x46, 0x50, 0x5A, 0x40
+};
+
+//! Dolby: Dolby Vision, low latency, backlight metadata with Tmax 0xABC
+static const uint8_t kDolbyLowLatency[] =
+{
+	0x81, 0x01, 0x1B, 0x04, 0x46, 0xD0, 0x00, 0x03, 0x8A, 0xBC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+//! OUI 0x332211: not in the vendor table
+static const uint8_t kUnknownVendor[] =
+{
+	0x81, 0x01, 0x04, 0x14, 0x11, 0x22, 0x33, 0x00
+};
+
+template <size_t N>
+static HDMI_GENERIC_INFOFRAME ToFrame(const uint8_t (&inBytes)[N])
+{
+	static_assert(N >= 4 && N <= HDMI_MAX_INFOFRAME_SIZE, "info frame size");
+	HDMI_GENERIC_INFOFRAME frame{};
+	frame.header.bfType         = inBytes[0] & 0x7F;
+	frame.header.bfPacketType   = inBytes[0] >> 7;
+	frame.header.bfVersion      = inBytes[1] & 0x7F;
+	frame.header.bfChangeBit    = inBytes[1] >> 7;
+	frame.header.bPayloadLength = inBytes[2];
+	frame.bChecksum             = inBytes[3];
+	memcpy(frame.bPayload, inBytes + 4, N - 4);
+	return frame;
+}
+
+template <size_t N>
+static HDMI_VS_INFO Decode(const uint8_t (&inBytes)[N])
+{
+	HDMI_VS_INFO info;
+	EGAV_CHECK(HDMI_VS_Decode(ToFrame(inBytes), info));
+	return info;
+}
+
+
+//==============================================================================
+// # Decoders
+//==============================================================================
+
+EGAV_TEST(DecodeHDMI14b)
+{
+	HDMI_VS_INFO info = Decode(kHDMI14b4K30);
+	EGAV_CHECK_EQUAL(info.dwOUI, (uint32_t)HDMI_VS_OUI_HDMI_LLC);
+	EGAV_CHECK_EQUAL(info.bKind, HDMI_VS_KIND_HDMI14B);
+	EGAV_CHECK_EQUAL(info.hdmi14b.bVideoFormat, HDMI_VS_VF_EXTENDED);
+	EGAV_CHECK_EQUAL(info.hdmi14b.bHDMIVIC, 1);
+	EGAV_CHECK(!info.hdmi14b.bDolbyVision);
+
+	info = Decode(kHDMI14b3DSideBySide);
+	EGAV_CHECK_EQUAL(info.hdmi14b.bVideoFormat, HDMI_VS_VF_3D);
+	EGAV_CHECK_EQUAL(info.hdmi14b.b3DStructure, 8);
+	EGAV_CHECK_EQUAL(info.hdmi14b.b3DExtData, 1);
+
+	info = Decode(kDolbyVisionStandard);
+	EGAV_CHECK_EQUAL(info.bKind, HDMI_VS_KIND_HDMI14B);
+	EGAV_CHECK_EQUAL(info.hdmi14b.bVideoFormat, HDMI_VS_VF_NONE);
+	EGAV_CHECK(info.hdmi14b.bDolbyVision);
+}
+
+EGAV_TEST(DecodeHDMIForum)
+{
+	const HDMI_VS_INFO info = Decode(kHDMIForumALLM);
+	EGAV_CHECK_EQUAL(info.dwOUI, (uint32_t)HDMI_VS_OUI_HDMI_FORUM);
+	EGAV_CHECK_EQUAL(info.bKind, HDMI_VS_KIND_HDMI_FORUM);
+	EGAV_CHECK_EQUAL(info.hdmiForum.bVersion, 1);
+	EGAV_CHECK(info.hdmiForum.bALLM);
+	EGAV_CHECK(!info.hdmiForum.b3DValid);
+}
+
+EGAV_TEST(DecodeHDR10Plus)
+{
+	const HDMI_VS_INFO info = Decode(kHDR10Plus);
+	const HDMI_VS_HDR10PLUS_INFO& md = info.hdr10plus;
+	EGAV_CHECK_EQUAL(info.dwOUI, (uint32_t)HDMI_VS_OUI_HDR10PLUS);
+	EGAV_CHECK_EQUAL(info.bKind, HDMI_VS_KIND_HDR10PLUS);
+	EGAV_CHECK_EQUAL(md.bApplicationVersion, 1);
+	EGAV_CHECK_EQUAL(md.bTargetedSystemDisplayMaxLum, 10);
+	EGAV_CHECK_EQUAL(md.bAverageMaxRGB, 128);
+	for (int i = 0; i < 9; i++)
+	{
+		EGAV_CHECK_EQUAL(md.bDistributionValues[i], i + 1);
+		EGAV_CHECK_EQUAL(md.bBezierCurveAnchors[i], (i + 1) * 10);
+	}
+	EGAV_CHECK_EQUAL(md.bNumBezierCurveAnchors, 9);
+	EGAV_CHECK_EQUAL(md.wKneePointX, 341);
+	EGAV_CHECK_EQUAL(md.wKneePointY, 682);
+	EGAV_CHECK(!md.bGraphicsOverlay);
+	EGAV_CHECK(md.bNoDelay);
+}
+
+EGAV_TEST(DecodeDolby)
+{
+	const HDMI_VS_INFO info = Decode(kDolbyLowLatency);
+	EGAV_CHECK_EQUAL(info.dwOUI, (uint32_t)HDMI_VS_OUI_DOLBY);
+	EGAV_CHECK_EQUAL(info.bKind, HDMI_VS_KIND_DOLBY);
+	EGAV_CHECK(info.dolby.bDolbyVision);
+	EGAV_CHECK(info.dolby.bLowLatency);
+	EGAV_CHECK(info.dolby.bBacklightMetadata);
+	EGAV_CHECK_EQUAL(info.dolby.wEffectiveTmaxPQ, 0xABC);
+}
+
+EGAV_TEST(DecodeUnknownVendor)
+{
+	const HDMI_VS_INFO info = Decode(kUnknownVendor);
+	EGAV_CHECK_EQUAL(info.dwOUI, (uint32_t)0x332211);
+	EGAV_CHECK_EQUAL(info.bKind, HDMI_VS_KIND_UNKNOWN);
+	EGAV_CHECK(strcmp(HDMI_VS_KindToString(info.bKind), "Unknown") == 0);
+	EGAV_CHECK(strcmp(HDMI_VS_KindToString(HDMI_VS_KIND_HDR10PLUS), "HDR10+") == 0);
+}
+
+EGAV_TEST(DecodeRejectsInvalidFrames)
+{
+	HDMI_VS_INFO info;
+
+	HDMI_GENERIC_INFOFRAME frame = ToFrame(kHDR10Plus);
+	frame.bChecksum ^= 0x01;
+	EGAV_CHECK(!HDMI_VS_Decode(frame, info));
+
+	// HDR10+ needs 27 payload bytes (the checksum is fixed up, so only the length is wrong)
+	frame = ToFrame(kHDR10Plus);
+	frame.header.bPayloadLength = 26;
+	frame.bChecksum = (uint8_t)(frame.bChecksum + 1 + kHDR10Plus[30]);
+	EGAV_CHECK(HDMI_IsInfoFrameValid(&frame));
+	EGAV_CHECK(!HDMI_VS_Decode(frame, info));
+
+	// Not a vendor specific info frame
+	frame = ToFrame(kHDMIForumALLM);
+	frame.header.bfType = HDMI_INFOFRAME_TYPE_AVI;
+	EGAV_CHECK(!HDMI_VS_Decode(frame, info));
+	EGAV_CHECK_EQUAL(HDMI_VS_GetOUI(frame), (uint32_t)0);
+}
+
+
+//==============================================================================
+// # Streaming parser
+//==============================================================================
+
+EGAV_TEST(ParserDecodesOnlyChanges)
+{
+	int callbacks = 0;
+	HDMIVendorInfoFrameParser parser([&](const HDMI_VS_INFO&) { callbacks++; });
+
+	bool changed = false;
+	EGAV_CHECK(parser.Parse(ToFrame(kHDR10Plus), &changed));
+	EGAV_CHECK(changed);
+	EGAV_CHECK(parser.Parse(ToFrame(kHDR10Plus), &changed));
+	EGAV_CHECK(!changed);
+
+	// New dynamic metadata
+	HDMI_GENERIC_INFOFRAME frame = ToFrame(kHDR10Plus);
+	frame.bPayload[4]++;
+	frame.bChecksum--;
+	EGAV_CHECK(parser.Parse(frame, &changed));
+	EGAV_CHECK(changed);
+	EGAV_CHECK(parser.GetHDR10PlusMetadata() != nullptr);
+	EGAV_CHECK_EQUAL(parser.GetHDR10PlusMetadata()->bAverageMaxRGB, 129);
+
+	// Other vendors are tracked separately
+	EGAV_CHECK(parser.Parse(ToFrame(kHDMIForumALLM), &changed));
+	EGAV_CHECK(changed);
+	HDMI_VS_INFO info;
+	EGAV_CHECK(parser.GetInfo(HDMI_VS_KIND_HDMI_FORUM, info));
+	EGAV_CHECK(!parser.GetInfo(HDMI_VS_KIND_DOLBY, info));
+
+	EGAV_CHECK_EQUAL(callbacks, 3);
+	EGAV_CHECK_EQUAL(parser.GetStatistics().framesParsed, (uint64_t)4);
+	EGAV_CHECK_EQUAL(parser.GetStatistics().framesDecoded, (uint64_t)3);
+
+	parser.Reset();
+	EGAV_CHECK(parser.GetHDR10PlusMetadata() == nullptr);
+	EGAV_CHECK_EQUAL(parser.GetStatistics().framesParsed, (uint64_t)0);
+}
+
+EGAV_TEST(ParserFeedReassemblesChunks)
+{
+	// Garbage, all golden vectors, a corrupted copy, then a valid frame again
+	std::vector<uint8_t> stream = { 0x00, 0xFF, 0x13 };
+	const std::pair<const uint8_t*, size_t> vectors[] =
+	{
+		{ kHDMI14b4K30, sizeof(kHDMI14b4K30) }, { kHDMIForumALLM, sizeof(kHDMIForumALLM) },
+		{ kHDR10Plus, sizeof(kHDR10Plus) }, { kDolbyLowLatency, sizeof(kDolbyLowLatency) },
+		{ kUnknownVendor, sizeof(kUnknownVendor) },
+	};
+	for (const auto& vector : vectors)
+		stream.insert(stream.end(), vector.first, vector.first + vector.second);
+	const size_t corrupted = stream.size();
+	stream.insert(stream.end(), kDolbyVisionStandard, kDolbyVisionStandard + sizeof(kDolbyVisionStandard));
+	stream[corrupted + 3] ^= 0x55;
+	stream.insert(stream.end(), kHDMI14b3DSideBySide, kHDMI14b3DSideBySide + sizeof(kHDMI14b3DSideBySide));
+
+	for (size_t chunk = 1; chunk <= 64; chunk += 7)
+	{
+		std::vector<HDMI_VS_INFO> changes;
+		HDMIVendorInfoFrameParser parser([&](const HDMI_VS_INFO& inInfo) { changes.push_back(inInfo); });
+
+		size_t frames = 0;
+		for (size_t offset = 0; offset < stream.size(); offset += chunk)
+			frames += parser.Feed(stream.data() + offset, std::min(chunk, stream.size() - offset));
+
+		EGAV_CHECK_EQUAL(frames, (size_t)6);
+		EGAV_CHECK_EQUAL(changes.size(), (size_t)6);
+		EGAV_CHECK_EQUAL(parser.GetStatistics().framesInvalid, (uint64_t)0);
+		EGAV_CHECK(parser.GetStatistics().bytesSkipped >= sizeof(kDolbyVisionStandard));
+
+		HDMI_VS_INFO info;
+		EGAV_CHECK(parser.GetInfo(HDMI_VS_KIND_HDMI14B, info));
+		EGAV_CHECK_EQUAL(info.hdmi14b.b3DStructure, 8);
+		EGAV_CHECK(parser.GetInfo(HDMI_VS_KIND_DOLBY, info));
+		EGAV_CHECK_EQUAL(info.dolby.wEffectiveTmaxPQ, 0xABC);
+		EGAV_CHECK(parser.GetHDR10PlusMetadata() != nullptr);
+	}
+}
+
+EGAV_TEST_MAIN()